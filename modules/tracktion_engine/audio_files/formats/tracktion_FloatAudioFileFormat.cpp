@@ -11,8 +11,257 @@
 namespace tracktion_engine
 {
 
-static int getFloatFileHeaderInt()  { return (int) juce::ByteOrder::littleEndianInt ("TRKF"); }
+static int getFloatFileHeaderInt()      { return (int) juce::ByteOrder::littleEndianInt ("TRKF"); }
+static int getFloatFileV2HeaderInt()    { return (int) juce::ByteOrder::littleEndianInt ("TRK2"); }
 
+//==============================================================================
+/** The min, max and RMS of one channel over a section of a version 2 file. */
+struct FloatFileSummaryEntry
+{
+    float minimum, maximum, rms;
+};
+
+static_assert (sizeof (FloatFileSummaryEntry) == 3 * sizeof (float), "Summary entries must be packed");
+
+/** Describes where everything is in a version 2 file.
+
+    After a 512 byte header, the samples are stored in blocks of blockSize samples per
+    channel, with all of channel 0's samples in the block followed by all of channel 1's
+    etc. The last block is padded with silence. The level summary follows the blocks,
+    starting with an entry for every samplesPerSummaryEntry samples, then each level
+    has an entry for summaryLevelRatio entries of the previous one, down to a single
+    entry for the whole file. Each entry has a FloatFileSummaryEntry for each channel.
+    Everything is little-endian.
+*/
+struct FloatFileV2Layout
+{
+    static constexpr int headerSize = 512;
+    static constexpr int defaultBlockSize = 4096;
+    static constexpr int samplesPerSummaryEntry = 256;
+    static constexpr int summaryLevelRatio = 8;
+
+    double sampleRate = 0.0;
+    juce::int64 lengthInSamples = 0;
+    int numChannels = 0;
+    int blockSize = defaultBlockSize;
+    juce::int64 summaryOffset = 0;
+
+    /** Reads the rest of the header after the magic number. */
+    bool read (juce::InputStream& in)
+    {
+        const int version       = in.readInt();
+        const int storedHeaderSize = in.readInt();
+        blockSize               = in.readInt();
+        sampleRate              = in.readDouble();
+        lengthInSamples         = in.readInt64();
+        numChannels             = in.readInt();
+        summaryOffset           = in.readInt64();
+        const int entrySize     = in.readInt();
+        const int levelRatio    = in.readInt();
+
+        if (entrySize != samplesPerSummaryEntry || levelRatio != summaryLevelRatio)
+            summaryOffset = 0;
+
+        return version == 2 && storedHeaderSize == headerSize
+                && blockSize > 0 && (blockSize * (int) sizeof (float)) % 64 == 0
+                && sampleRate > 0.0 && sampleRate <= 768000.0
+                && numChannels > 0 && numChannels <= 128
+                && lengthInSamples >= 0;
+    }
+
+    void write (juce::OutputStream& out) const
+    {
+        out.writeInt (getFloatFileV2HeaderInt());
+        out.writeInt (2);
+        out.writeInt (headerSize);
+        out.writeInt (blockSize);
+        out.writeDouble (sampleRate);
+        out.writeInt64 (lengthInSamples);
+        out.writeInt (numChannels);
+        out.writeInt64 (summaryOffset);
+        out.writeInt (samplesPerSummaryEntry);
+        out.writeInt (summaryLevelRatio);
+
+        while (out.getPosition() < headerSize)
+            out.writeByte (0);
+    }
+
+    juce::int64 getBlockBytes() const noexcept      { return (juce::int64) blockSize * numChannels * (juce::int64) sizeof (float); }
+    juce::int64 getNumBlocks() const noexcept       { return (lengthInSamples + blockSize - 1) / blockSize; }
+
+    juce::int64 getSampleFilePos (int channel, juce::int64 sample) const noexcept
+    {
+        return headerSize + (sample / blockSize) * getBlockBytes()
+                + ((juce::int64) channel * blockSize + sample % blockSize) * (juce::int64) sizeof (float);
+    }
+
+    //==============================================================================
+    bool hasSummary() const noexcept                { return summaryOffset > 0 && lengthInSamples > 0; }
+
+    juce::int64 getSamplesPerEntry (int level) const noexcept
+    {
+        juce::int64 size = samplesPerSummaryEntry;
+
+        for (int i = 0; i < level; ++i)
+            size *= summaryLevelRatio;
+
+        return size;
+    }
+
+    juce::int64 getNumEntries (int level) const noexcept
+    {
+        const auto size = getSamplesPerEntry (level);
+        return (lengthInSamples + size - 1) / size;
+    }
+
+    int getNumSummaryLevels() const noexcept
+    {
+        if (lengthInSamples <= 0)
+            return 0;
+
+        int numLevels = 1;
+
+        while (getNumEntries (numLevels - 1) > 1)
+            ++numLevels;
+
+        return numLevels;
+    }
+
+    juce::int64 getSummaryEntryFilePos (int level, juce::int64 index) const noexcept
+    {
+        juce::int64 entryIndex = index;
+
+        for (int i = 0; i < level; ++i)
+            entryIndex += getNumEntries (i);
+
+        return summaryOffset + entryIndex * numChannels * (juce::int64) sizeof (FloatFileSummaryEntry);
+    }
+
+    //==============================================================================
+    /** Splits a range in to the largest summary entries that fit in it, and the samples
+        at either end which aren't a whole entry.
+    */
+    template <typename EntryCallback, typename SampleCallback>
+    void visitRange (juce::int64 start, juce::int64 end, EntryCallback&& useEntry, SampleCallback&& useSamples) const
+    {
+        const auto entrySize = (juce::int64) samplesPerSummaryEntry;
+        const auto alignedStart = ((start + entrySize - 1) / entrySize) * entrySize;
+        const auto alignedEnd = end >= lengthInSamples ? lengthInSamples : (end / entrySize) * entrySize;
+
+        if (! hasSummary() || alignedStart >= alignedEnd)
+        {
+            useSamples (start, end);
+            return;
+        }
+
+        if (start < alignedStart)
+            useSamples (start, alignedStart);
+
+        const int numLevels = getNumSummaryLevels();
+
+        for (auto pos = alignedStart; pos < alignedEnd;)
+        {
+            int level = 0;
+
+            while (level + 1 < numLevels)
+            {
+                const auto nextSize = getSamplesPerEntry (level + 1);
+
+                if (pos % nextSize != 0 || juce::jmin (pos + nextSize, lengthInSamples) > alignedEnd)
+                    break;
+
+                ++level;
+            }
+
+            const auto size = getSamplesPerEntry (level);
+            useEntry (level, pos / size, juce::jmin (pos + size, lengthInSamples) - pos);
+            pos += size;
+        }
+
+        if (alignedEnd < end)
+            useSamples (alignedEnd, end);
+    }
+};
+
+/** Collects the levels of each channel from summary entries and samples. */
+struct FloatFileLevels
+{
+    FloatFileLevels (int numChannelsToRead)
+        : minimums ((size_t) numChannelsToRead, std::numeric_limits<float>::max()),
+          maximums ((size_t) numChannelsToRead, std::numeric_limits<float>::lowest()),
+          sumsOfSquares ((size_t) numChannelsToRead)
+    {
+    }
+
+    void addEntries (const FloatFileSummaryEntry* entries, juce::int64 numSamples)
+    {
+        for (size_t i = 0; i < minimums.size(); ++i)
+        {
+            minimums[i] = juce::jmin (minimums[i], entries[i].minimum);
+            maximums[i] = juce::jmax (maximums[i], entries[i].maximum);
+            sumsOfSquares[i] += (double) entries[i].rms * (double) entries[i].rms * (double) numSamples;
+        }
+
+        totalNumSamples += numSamples;
+    }
+
+    void addSamples (const float* const* channels, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        for (size_t i = 0; i < minimums.size(); ++i)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax (channels[i], numSamples);
+            minimums[i] = juce::jmin (minimums[i], range.getStart());
+            maximums[i] = juce::jmax (maximums[i], range.getEnd());
+            sumsOfSquares[i] += BeatDetect::getSumOfSquares (channels[i], numSamples);
+        }
+
+        totalNumSamples += numSamples;
+    }
+
+    void getMaxLevels (juce::Range<float>* results, int numResults) const
+    {
+        for (int i = 0; i < numResults; ++i)
+            results[i] = (totalNumSamples > 0 && i < (int) minimums.size()) ? juce::Range<float> (minimums[(size_t) i], maximums[(size_t) i])
+                                                                          : juce::Range<float>();
+    }
+
+    void getRMSLevels (float* results, int numResults) const
+    {
+        for (int i = 0; i < numResults; ++i)
+            results[i] = (totalNumSamples > 0 && i < (int) sumsOfSquares.size()) ? (float) std::sqrt (sumsOfSquares[(size_t) i] / (double) totalNumSamples)
+                                                                               : 0.0f;
+    }
+
+    std::vector<float> minimums, maximums;
+    std::vector<double> sumsOfSquares;
+    juce::int64 totalNumSamples = 0;
+};
+
+/** Converts floats read from a file to the native byte order, which does nothing on most machines. */
+static void convertFloatsFromFile (float* data, int num) noexcept
+{
+   #if JUCE_LITTLE_ENDIAN
+    juce::ignoreUnused (data, num);
+   #else
+    auto words = reinterpret_cast<juce::uint32*> (data);
+
+    for (int i = 0; i < num; ++i)
+        words[i] = juce::ByteOrder::swap (words[i]);
+   #endif
+}
+
+static void writeFloatsToFile (juce::OutputStream& out, const float* source, int num)
+{
+   #if JUCE_LITTLE_ENDIAN
+    out.write (source, (size_t) num * sizeof (float));
+   #else
+    for (int i = 0; i < num; ++i)
+        out.writeFloat (source[i]);
+   #endif
+}
 
 //==============================================================================
 class FloatAudioFormatReader  : public juce::AudioFormatReader
@@ -22,23 +271,38 @@ public:
         : AudioFormatReader (in, TRANS("Tracktion audio file"))
     {
         usesFloatingPointData = true;
+        bitsPerSample = 32;
+
+        const int magic = in->readInt();
 
-        if (in->readInt() == getFloatFileHeaderInt())
+        if (magic == getFloatFileHeaderInt())
         {
+            version         = 1;
             dataStartOffset = in->readInt();
             sampleRate      = in->readInt();
             lengthInSamples = in->readInt();
             numChannels     = (unsigned int) in->readShort();
             bigEndian       = in->readShort() != 0;
-            bitsPerSample   = 32;
 
             if (sampleRate < 32000 || sampleRate > 192000 || numChannels < 1 || numChannels > 16)
                 sampleRate = 0;
         }
+        else if (magic == getFloatFileV2HeaderInt())
+        {
+            version = 2;
+
+            if (layout.read (*in))
+            {
+                dataStartOffset = FloatFileV2Layout::headerSize;
+                sampleRate      = layout.sampleRate;
+                lengthInSamples = layout.lengthInSamples;
+                numChannels     = (unsigned int) layout.numChannels;
+            }
+        }
     }
 
     bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
-                      juce::int64 startSampleInFile, int numSamples)
+                      juce::int64 startSampleInFile, int numSamples) override
     {
         clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
                                            startSampleInFile, numSamples, lengthInSamples);
@@ -46,6 +310,9 @@ public:
         if (numSamples <= 0)
             return true;
 
+        if (version == 2)
+            return readV2Samples (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+
         input->setPosition (4 * startSampleInFile * numChannels + dataStartOffset);
         const int bytesPerFrame = 4 * (int) numChannels;
 
@@ -77,8 +344,99 @@ public:
         return true;
     }
 
-    int dataStartOffset;
+    using juce::AudioFormatReader::readMaxLevels;
+    void readMaxLevels (juce::int64 startSampleInFile, juce::int64 numSamples, juce::Range<float>* results, int numChannelsToRead) override
+    {
+        if (version != 2)
+        {
+            juce::AudioFormatReader::readMaxLevels (startSampleInFile, numSamples, results, numChannelsToRead);
+            return;
+        }
+
+        readLevels (startSampleInFile, numSamples, numChannelsToRead).getMaxLevels (results, numChannelsToRead);
+    }
+
+    FloatFileLevels readLevels (juce::int64 startSampleInFile, juce::int64 numSamples, int numChannelsToRead)
+    {
+        jassert (version == 2);
+        numChannelsToRead = juce::jmin (numChannelsToRead, (int) numChannels);
+        FloatFileLevels levels (numChannelsToRead);
+
+        startSampleInFile = juce::jmax ((juce::int64) 0, startSampleInFile);
+        numSamples = juce::jmin (numSamples, lengthInSamples - startSampleInFile);
+
+        if (numSamples <= 0)
+            return levels;
+
+        std::vector<FloatFileSummaryEntry> entries ((size_t) layout.numChannels);
+        juce::AudioBuffer<float> buffer;
+
+        layout.visitRange (startSampleInFile, startSampleInFile + numSamples,
+                           [&] (int level, juce::int64 index, juce::int64 numSamplesInEntry)
+                           {
+                               const auto numBytes = (int) (entries.size() * sizeof (FloatFileSummaryEntry));
+                               input->setPosition (layout.getSummaryEntryFilePos (level, index));
+
+                               if (input->read (entries.data(), numBytes) != numBytes)
+                                   std::fill (entries.begin(), entries.end(), FloatFileSummaryEntry());
+
+                               convertFloatsFromFile (&entries[0].minimum, numBytes / (int) sizeof (float));
+                               levels.addEntries (entries.data(), numSamplesInEntry);
+                           },
+                           [&] (juce::int64 start, juce::int64 end)
+                           {
+                               const auto num = (int) (end - start);
+                               buffer.setSize (numChannelsToRead, num, false, false, true);
+                               readV2Samples ((int**) buffer.getArrayOfWritePointers(), numChannelsToRead, 0, start, num);
+                               levels.addSamples (buffer.getArrayOfReadPointers(), num);
+                           });
+
+        return levels;
+    }
+
+    int version = 0;
+    int dataStartOffset = 0;
     bool bigEndian = false;
+    FloatFileV2Layout layout;
+
+private:
+    bool readV2Samples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                        juce::int64 startSampleInFile, int numSamples)
+    {
+        for (int chan = 0; chan < numDestChannels; ++chan)
+        {
+            auto dest = reinterpret_cast<float*> (destSamples[chan]);
+
+            if (dest == nullptr)
+                continue;
+
+            dest += startOffsetInDestBuffer;
+
+            if (chan >= (int) numChannels)
+            {
+                juce::FloatVectorOperations::clear (dest, numSamples);
+                continue;
+            }
+
+            for (int done = 0; done < numSamples;)
+            {
+                const auto sample = startSampleInFile + done;
+                const int numThisTime = juce::jmin (numSamples - done, layout.blockSize - (int) (sample % layout.blockSize));
+                const int numBytes = numThisTime * (int) sizeof (float);
+
+                input->setPosition (layout.getSampleFilePos (chan, sample));
+                const int bytesRead = juce::jmax (0, input->read (dest + done, numBytes));
+
+                if (bytesRead < numBytes)
+                    juce::zeromem (juce::addBytesToPointer (dest + done, bytesRead), (size_t) (numBytes - bytesRead));
+
+                convertFloatsFromFile (dest + done, numThisTime);
+                done += numThisTime;
+            }
+        }
+
+        return true;
+    }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FloatAudioFormatReader)
 };
@@ -150,6 +508,174 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FloatAudioFormatWriter)
 };
 
+//==============================================================================
+class FloatAudioFormatWriterV2  : public juce::AudioFormatWriter
+{
+public:
+    FloatAudioFormatWriterV2 (juce::OutputStream* out, double sampleRate_, unsigned int numChannels_)
+        : AudioFormatWriter (out,
+                             TRANS("Tracktion audio file"),
+                             sampleRate_,
+                             numChannels_,
+                             32),
+          block ((int) numChannels_, FloatFileV2Layout::defaultBlockSize),
+          blockChannels ((size_t) numChannels_),
+          entryLevels ((int) numChannels_)
+    {
+        usesFloatingPointData = true;
+
+        layout.sampleRate = sampleRate_;
+        layout.numChannels = (int) numChannels_;
+
+        layout.write (*output);
+    }
+
+    ~FloatAudioFormatWriterV2() override
+    {
+        if (entryLevels.totalNumSamples > 0)
+            addSummaryEntry();
+
+        if (blockPosition > 0)
+        {
+            block.clear (blockPosition, layout.blockSize - blockPosition);
+            writeBlock();
+        }
+
+        layout.summaryOffset = output->getPosition();
+        writeSummary();
+
+        output->setPosition (0);
+        layout.write (*output);
+    }
+
+    //==============================================================================
+    bool write (const int** data, int numSamps) override
+    {
+        for (int done = 0; done < numSamps;)
+        {
+            // Blocks are a whole number of summary entries, so neither can be crossed here
+            const int numThisTime = juce::jmin (numSamps - done,
+                                                layout.blockSize - blockPosition,
+                                                FloatFileV2Layout::samplesPerSummaryEntry - (int) entryLevels.totalNumSamples);
+
+            for (int chan = 0; chan < layout.numChannels; ++chan)
+            {
+                auto dest = block.getWritePointer (chan, blockPosition);
+
+                if (auto source = reinterpret_cast<const float*> (data[chan]))
+                    copyWithoutDenormals (dest, source + done, numThisTime);
+                else
+                    juce::FloatVectorOperations::clear (dest, numThisTime);
+            }
+
+            for (int chan = 0; chan < layout.numChannels; ++chan)
+                blockChannels[chan] = block.getReadPointer (chan, blockPosition);
+
+            entryLevels.addSamples (blockChannels, numThisTime);
+
+            done += numThisTime;
+            blockPosition += numThisTime;
+            layout.lengthInSamples += numThisTime;
+
+            if (entryLevels.totalNumSamples == FloatFileV2Layout::samplesPerSummaryEntry)
+                addSummaryEntry();
+
+            if (blockPosition == layout.blockSize)
+            {
+                writeBlock();
+                blockPosition = 0;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    //==============================================================================
+    FloatFileV2Layout layout;
+    juce::AudioBuffer<float> block;
+    juce::HeapBlock<const float*> blockChannels;
+    int blockPosition = 0;
+
+    FloatFileLevels entryLevels;
+    std::vector<FloatFileSummaryEntry> summary;
+
+    /** Denormals are stored as zero so they don't slow down anything which reads the file. */
+    static void copyWithoutDenormals (float* dest, const float* source, int num) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+            dest[i] = std::abs (source[i]) < std::numeric_limits<float>::min() ? 0.0f : source[i];
+    }
+
+    void addSummaryEntry()
+    {
+        for (size_t chan = 0; chan < (size_t) layout.numChannels; ++chan)
+        {
+            const auto rms = std::sqrt (entryLevels.sumsOfSquares[chan] / (double) entryLevels.totalNumSamples);
+            summary.push_back ({ entryLevels.minimums[chan], entryLevels.maximums[chan], (float) rms });
+        }
+
+        entryLevels = FloatFileLevels (layout.numChannels);
+    }
+
+    void writeBlock()
+    {
+        for (int chan = 0; chan < layout.numChannels; ++chan)
+            writeFloatsToFile (*output, block.getReadPointer (chan), layout.blockSize);
+    }
+
+    void writeSummary()
+    {
+        const auto numChans = (size_t) layout.numChannels;
+        const int numLevels = layout.getNumSummaryLevels();
+        auto level = summary;
+
+        for (int levelIndex = 0; levelIndex < numLevels; ++levelIndex)
+        {
+            writeFloatsToFile (*output, &level.data()->minimum, (int) (level.size() * 3));
+
+            if (levelIndex == numLevels - 1)
+                break;
+
+            // Each entry of the next level covers summaryLevelRatio of this one's, with the
+            // RMS of each weighted by how many samples it covers as the last may be shorter
+            const auto samplesPerEntry = layout.getSamplesPerEntry (levelIndex);
+            const auto numEntries = level.size() / numChans;
+            std::vector<FloatFileSummaryEntry> nextLevel;
+
+            for (size_t first = 0; first < numEntries; first += FloatFileV2Layout::summaryLevelRatio)
+            {
+                const auto end = std::min (numEntries, first + FloatFileV2Layout::summaryLevelRatio);
+
+                for (size_t chan = 0; chan < numChans; ++chan)
+                {
+                    FloatFileSummaryEntry combined { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0f };
+                    double sumOfSquares = 0.0;
+                    juce::int64 numSamples = 0;
+
+                    for (auto i = first; i < end; ++i)
+                    {
+                        const auto& entry = level[i * numChans + chan];
+                        const auto entrySamples = juce::jmin (samplesPerEntry, layout.lengthInSamples - (juce::int64) i * samplesPerEntry);
+
+                        combined.minimum = juce::jmin (combined.minimum, entry.minimum);
+                        combined.maximum = juce::jmax (combined.maximum, entry.maximum);
+                        sumOfSquares += (double) entry.rms * (double) entry.rms * (double) entrySamples;
+                        numSamples += entrySamples;
+                    }
+
+                    combined.rms = (float) std::sqrt (sumOfSquares / (double) numSamples);
+                    nextLevel.push_back (combined);
+                }
+            }
+
+            level = std::move (nextLevel);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FloatAudioFormatWriterV2)
+};
+
 //==============================================================================
 class MemoryMappedFloatReader   : public juce::MemoryMappedAudioFormatReader
 {
@@ -257,9 +783,282 @@ private:
 };
 
 //==============================================================================
-FloatAudioFormat::FloatAudioFormat()  : AudioFormat ("Tracktion audio file", ".trkaudio") {}
+class MemoryMappedFloatReaderV2   : public juce::MemoryMappedAudioFormatReader
+{
+public:
+    MemoryMappedFloatReaderV2 (const juce::File& f, const FloatAudioFormatReader& reader)
+        : MemoryMappedAudioFormatReader (f, reader,
+                                         FloatFileV2Layout::headerSize,
+                                         reader.layout.getNumBlocks() * reader.layout.getBlockBytes(),
+                                         4 * (int) reader.numChannels),
+          layout (reader.layout)
+    {
+        usesFloatingPointData = true;
+
+        if (layout.hasSummary())
+        {
+            summaryMap = std::make_unique<juce::MemoryMappedFile> (f, juce::Range<juce::int64> (layout.summaryOffset, f.getSize()),
+                                                                   juce::MemoryMappedFile::readOnly);
+
+            if (summaryMap->getData() == nullptr)
+                summaryMap.reset();
+        }
+
+        // Without the summary, the levels are found by reading the samples
+        if (summaryMap == nullptr)
+            layout.summaryOffset = 0;
+    }
+
+    /** The samples are stored in blocks rather than frames, so this maps whole blocks and
+        sets the mapped section to the samples that are in the blocks it gets.
+    */
+    bool mapSectionOfFile (juce::Range<juce::int64> samplesToMap) override
+    {
+        if (map != nullptr && mappedSection.contains (samplesToMap))
+            return true;
+
+        map.reset();
+        mappedSection = {};
+
+        const auto blockSize = (juce::int64) layout.blockSize;
+        const auto blockBytes = layout.getBlockBytes();
+        const auto firstBlock = juce::jmax ((juce::int64) 0, samplesToMap.getStart()) / blockSize;
+        const auto endBlock = juce::jmin (layout.getNumBlocks(), (samplesToMap.getEnd() + blockSize - 1) / blockSize);
+
+        if (endBlock <= firstBlock)
+            return false;
+
+        map = std::make_unique<juce::MemoryMappedFile> (getFile(),
+                                                        juce::Range<juce::int64> (FloatFileV2Layout::headerSize + firstBlock * blockBytes,
+                                                                                  FloatFileV2Layout::headerSize + endBlock * blockBytes),
+                                                        juce::MemoryMappedFile::readOnly);
+
+        if (map->getData() == nullptr)
+        {
+            map.reset();
+            return false;
+        }
+
+        // The mapped range is rounded to whole pages, so only count the blocks it completely covers
+        const auto mapRange = map->getRange();
+        const auto firstMappedBlock = juce::jmax ((juce::int64) 0, mapRange.getStart() - FloatFileV2Layout::headerSize + blockBytes - 1) / blockBytes;
+        const auto endMappedBlock = (mapRange.getEnd() - FloatFileV2Layout::headerSize) / blockBytes;
+
+        mappedSection = { juce::jmin (lengthInSamples, firstMappedBlock * blockSize),
+                          juce::jmin (lengthInSamples, endMappedBlock * blockSize) };
+
+        return true;
+    }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      juce::int64 startSampleInFile, int numSamples) override
+    {
+        clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                           startSampleInFile, numSamples, lengthInSamples);
+
+        if (numSamples <= 0)
+            return true;
+
+        if (map == nullptr || ! mappedSection.contains ({ startSampleInFile, startSampleInFile + numSamples }))
+        {
+            jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
+            return false;
+        }
+
+        for (int chan = 0; chan < numDestChannels; ++chan)
+        {
+            auto dest = reinterpret_cast<float*> (destSamples[chan]);
+
+            if (dest == nullptr)
+                continue;
+
+            dest += startOffsetInDestBuffer;
+
+            if (chan >= (int) numChannels)
+            {
+                juce::FloatVectorOperations::clear (dest, numSamples);
+                continue;
+            }
+
+            for (int done = 0; done < numSamples;)
+            {
+                const auto sample = startSampleInFile + done;
+                const int numThisTime = juce::jmin (numSamples - done, layout.blockSize - (int) (sample % layout.blockSize));
+
+                std::memcpy (dest + done, getChannelPointer (chan, sample), (size_t) numThisTime * sizeof (float));
+                convertFloatsFromFile (dest + done, numThisTime);
+                done += numThisTime;
+            }
+        }
+
+        return true;
+    }
+
+    void getSample (juce::int64 sample, float* result) const noexcept override
+    {
+        if (map == nullptr || ! mappedSection.contains (sample))
+        {
+            jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
+
+            juce::zeromem (result, sizeof (float) * numChannels);
+            return;
+        }
+
+        for (int chan = 0; chan < (int) numChannels; ++chan)
+            std::memcpy (result + chan, getChannelPointer (chan, sample), sizeof (float));
+
+        convertFloatsFromFile (result, (int) numChannels);
+    }
+
+    using juce::MemoryMappedAudioFormatReader::readMaxLevels;
+    void readMaxLevels (juce::int64 startSampleInFile, juce::int64 numSamples, juce::Range<float>* results, int numChannelsToRead) override
+    {
+        readLevels (startSampleInFile, numSamples, numChannelsToRead).getMaxLevels (results, numChannelsToRead);
+    }
+
+    /** Finds the levels from the summary where possible. Any samples that aren't covered
+        by a whole summary entry must be in the mapped section.
+    */
+    FloatFileLevels readLevels (juce::int64 startSampleInFile, juce::int64 numSamples, int numChannelsToRead)
+    {
+        numChannelsToRead = juce::jmin (numChannelsToRead, (int) numChannels);
+        FloatFileLevels levels (numChannelsToRead);
+
+        startSampleInFile = juce::jmax ((juce::int64) 0, startSampleInFile);
+        numSamples = juce::jmin (numSamples, lengthInSamples - startSampleInFile);
+
+        if (numSamples <= 0)
+            return levels;
+
+        std::vector<FloatFileSummaryEntry> entries ((size_t) layout.numChannels);
+        juce::HeapBlock<const float*> channels ((size_t) numChannelsToRead);
+        juce::AudioBuffer<float> buffer;
+
+        layout.visitRange (startSampleInFile, startSampleInFile + numSamples,
+                           [&] (int level, juce::int64 index, juce::int64 numSamplesInEntry)
+                           {
+                               const auto numBytes = entries.size() * sizeof (FloatFileSummaryEntry);
+                               const auto offset = layout.getSummaryEntryFilePos (level, index) - summaryMap->getRange().getStart();
+
+                               if (offset + (juce::int64) numBytes <= (juce::int64) summaryMap->getSize())
+                                   std::memcpy (entries.data(), juce::addBytesToPointer (summaryMap->getData(), offset), numBytes);
+                               else
+                                   std::fill (entries.begin(), entries.end(), FloatFileSummaryEntry());
+
+                               convertFloatsFromFile (&entries[0].minimum, (int) (numBytes / sizeof (float)));
+                               levels.addEntries (entries.data(), numSamplesInEntry);
+                           },
+                           [&] (juce::int64 start, juce::int64 end)
+                           {
+                               if (map == nullptr || ! mappedSection.contains ({ start, end }))
+                               {
+                                   jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
+                                   return;
+                               }
+
+                               for (auto pos = start; pos < end;)
+                               {
+                                   const int numThisTime = (int) juce::jmin (end - pos, (juce::int64) (layout.blockSize - (int) (pos % layout.blockSize)));
+
+                                  #if JUCE_LITTLE_ENDIAN
+                                   for (int chan = 0; chan < numChannelsToRead; ++chan)
+                                       channels[chan] = getChannelPointer (chan, pos);
+
+                                   levels.addSamples (channels, numThisTime);
+                                  #else
+                                   buffer.setSize (numChannelsToRead, numThisTime, false, false, true);
+                                   readSamples ((int**) buffer.getArrayOfWritePointers(), numChannelsToRead, 0, pos, numThisTime);
+                                   levels.addSamples (buffer.getArrayOfReadPointers(), numThisTime);
+                                  #endif
+
+                                   pos += numThisTime;
+                               }
+                           });
+
+        juce::ignoreUnused (channels, buffer);
+        return levels;
+    }
+
+    const float* getChannelPointer (int channel, juce::int64 sample) const noexcept
+    {
+        return static_cast<const float*> (juce::addBytesToPointer (map->getData(), layout.getSampleFilePos (channel, sample) - map->getRange().getStart()));
+    }
+
+    FloatFileV2Layout layout;
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> summaryMap;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedFloatReaderV2)
+};
+
+//==============================================================================
+FloatAudioFormat::FloatAudioFormat (Version v)
+    : AudioFormat ("Tracktion audio file", ".trkaudio"), versionToWrite (v)
+{
+}
+
 FloatAudioFormat::~FloatAudioFormat() {}
 
+int FloatAudioFormat::getFileVersion (const juce::File& file)
+{
+    if (auto in = file.createInputStream())
+    {
+        FloatAudioFormatReader reader (in.release());
+
+        if (reader.sampleRate > 0)
+            return reader.version;
+    }
+
+    return 0;
+}
+
+bool FloatAudioFormat::readRMSLevels (juce::AudioFormatReader& reader, juce::int64 startSample, juce::int64 numSamples,
+                                      float* results, int numChannelsToRead)
+{
+    if (auto mappedReader = dynamic_cast<MemoryMappedFloatReaderV2*> (&reader))
+    {
+        mappedReader->readLevels (startSample, numSamples, numChannelsToRead).getRMSLevels (results, numChannelsToRead);
+        return true;
+    }
+
+    if (auto streamReader = dynamic_cast<FloatAudioFormatReader*> (&reader))
+    {
+        if (streamReader->version == 2)
+        {
+            streamReader->readLevels (startSample, numSamples, numChannelsToRead).getRMSLevels (results, numChannelsToRead);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const float* FloatAudioFormat::getMappedChannelData (juce::MemoryMappedAudioFormatReader& reader, int channel,
+                                                     juce::int64 sample, int& numContiguousSamples)
+{
+    numContiguousSamples = 0;
+
+   #if JUCE_LITTLE_ENDIAN
+    if (auto mappedReader = dynamic_cast<MemoryMappedFloatReaderV2*> (&reader))
+    {
+        const auto section = mappedReader->getMappedSection();
+
+        if (channel < 0 || channel >= (int) mappedReader->numChannels || ! section.contains (sample))
+            return nullptr;
+
+        const auto blockSize = mappedReader->layout.blockSize;
+        numContiguousSamples = (int) juce::jmin ((juce::int64) (blockSize - (int) (sample % blockSize)), section.getEnd() - sample);
+
+        return mappedReader->getChannelPointer (channel, sample);
+    }
+   #else
+    juce::ignoreUnused (reader, channel, sample);
+   #endif
+
+    return nullptr;
+}
+
 juce::Array<int> FloatAudioFormat::getPossibleSampleRates()     { return { 22050, 32000, 44100, 48000, 88200, 96000, 176400, 192000 }; }
 juce::Array<int> FloatAudioFormat::getPossibleBitDepths()       { return { 32 }; }
 
@@ -295,7 +1094,12 @@ juce::MemoryMappedAudioFormatReader* FloatAudioFormat::createMemoryMappedReader
         FloatAudioFormatReader reader (fin.release());
 
         if (reader.lengthInSamples > 0)
+        {
+            if (reader.version == 2)
+                return new MemoryMappedFloatReaderV2 (file, reader);
+
             return new MemoryMappedFloatReader (file, reader);
+        }
     }
 
     return {};
@@ -308,7 +1112,10 @@ juce::AudioFormatWriter* FloatAudioFormat::createWriterFor (juce::OutputStream*
                                                             const juce::StringPairArray& /*metadataValues*/,
                                                             int /*qualityOptionIndex*/)
 {
-    return new FloatAudioFormatWriter (out, sampleRate, numChannels);
+    if (versionToWrite == Version::v1)
+        return new FloatAudioFormatWriter (out, sampleRate, numChannels);
+
+    return new FloatAudioFormatWriterV2 (out, sampleRate, numChannels);
 }
 
 }
@@ -13,13 +13,44 @@ namespace tracktion_engine
 
 /**
     A raw, proprietary, simple floating point format used for freeze files, etc.
+
+    Version 1 files are interleaved. Version 2 files store the channels separately in
+    64-byte aligned blocks so they can be read straight from a memory-mapped file, and
+    have a pyramid of min/max/RMS levels at the end so readMaxLevels() doesn't need to
+    scan the samples. Both versions can be read, and new files are written as the
+    version passed to the constructor.
 */
 class FloatAudioFormat   : public juce::AudioFormat
 {
 public:
-    FloatAudioFormat();
+    enum class Version
+    {
+        v1 = 1,
+        v2 = 2
+    };
+
+    FloatAudioFormat (Version versionToWrite = Version::v2);
     ~FloatAudioFormat() override;
 
+    //==============================================================================
+    /** Returns the version of a file, or 0 if it isn't in this format. */
+    static int getFileVersion (const juce::File&);
+
+    /** Reads the RMS level of each channel over a range of a version 2 file, using the
+        level summary so most of the samples don't need reading.
+        Returns false if the reader isn't one created by this format for a version 2 file.
+    */
+    static bool readRMSLevels (juce::AudioFormatReader&, juce::int64 startSample, juce::int64 numSamples,
+                               float* results, int numChannelsToRead);
+
+    /** Returns a pointer to a channel's samples in a memory-mapped version 2 file.
+        The samples are stored in blocks, so numContiguousSamples is set to the number
+        that can be read from the pointer before the end of the block or mapped section.
+        Returns nullptr if the reader isn't a mapped version 2 reader or the sample isn't mapped.
+    */
+    static const float* getMappedChannelData (juce::MemoryMappedAudioFormatReader&, int channel,
+                                              juce::int64 sample, int& numContiguousSamples);
+
     //==============================================================================
     juce::Array<int> getPossibleSampleRates() override;
     juce::Array<int> getPossibleBitDepths() override;
@@ -39,6 +70,9 @@ public:
                                               unsigned int numChannels, int bitsPerSample,
                                               const juce::StringPairArray& metadataValues,
                                               int qualityOptionIndex) override;
+
+private:
+    const Version versionToWrite;
 };
 
 } // namespace tracktion_engine
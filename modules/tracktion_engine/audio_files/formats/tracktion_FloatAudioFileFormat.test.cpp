@@ -0,0 +1,265 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace float_audio_format_test_utilities
+{
+    static constexpr double sampleRate = 44100.0;
+
+    inline juce::AudioBuffer<float> createNoise (int numChannels, int numSamples)
+    {
+        juce::Random r (1234);
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (chan, i, (r.nextFloat() * 2.0f - 1.0f) * (chan + 1) / (float) numChannels);
+
+        return buffer;
+    }
+
+    inline bool writeFile (FloatAudioFormat& format, const juce::File& file, const juce::AudioBuffer<float>& buffer)
+    {
+        file.deleteFile();
+        auto out = file.createOutputStream();
+
+        if (out == nullptr)
+            return false;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (out.get(), sampleRate, (unsigned int) buffer.getNumChannels(),
+                                                                                 32, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        out.release();
+
+        // Write in odd sized chunks so they don't line up with the blocks
+        for (int start = 0; start < buffer.getNumSamples(); start += 1000)
+            if (! writer->writeFromAudioSampleBuffer (buffer, start, juce::jmin (1000, buffer.getNumSamples() - start)))
+                return false;
+
+        return true;
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class FloatAudioFormatTests  : public juce::UnitTest
+{
+public:
+    FloatAudioFormatTests()
+        : juce::UnitTest ("FloatAudioFormat", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace float_audio_format_test_utilities;
+
+        auto buffer = createNoise (3, 10000);
+        buffer.setSample (0, 10, 1.0e-40f);
+
+        beginTest ("Version 1 round trip");
+        {
+            FloatAudioFormat format (FloatAudioFormat::Version::v1);
+            juce::TemporaryFile tempFile (".freeze");
+            expect (writeFile (format, tempFile.getFile(), buffer));
+            expectEquals (FloatAudioFormat::getFileVersion (tempFile.getFile()), 1);
+
+            auto read = readWholeFile (format, tempFile.getFile());
+            expectEquals (read.getNumChannels(), buffer.getNumChannels());
+            expectEquals (read.getNumSamples(), buffer.getNumSamples());
+            expect (audio_test_utilities::getMaxDifference (read, buffer) < 1.0e-6f);
+        }
+
+        beginTest ("Version 2 round trip");
+        {
+            FloatAudioFormat format;
+            juce::TemporaryFile tempFile (".freeze");
+            expect (writeFile (format, tempFile.getFile(), buffer));
+            expectEquals (FloatAudioFormat::getFileVersion (tempFile.getFile()), 2);
+
+            auto read = readWholeFile (format, tempFile.getFile());
+            expectEquals (read.getNumChannels(), buffer.getNumChannels());
+            expectEquals (read.getNumSamples(), buffer.getNumSamples());
+            expectEquals (read.getSample (0, 10), 0.0f, "Denormals should be flushed to zero");
+
+            read.setSample (0, 10, buffer.getSample (0, 10));
+            expectEquals (audio_test_utilities::getMaxDifference (read, buffer), 0.0f);
+        }
+
+        beginTest ("Version 2 memory mapped reads");
+        {
+            FloatAudioFormat format;
+            juce::TemporaryFile tempFile (".freeze");
+            expect (writeFile (format, tempFile.getFile(), buffer));
+
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader (format.createMemoryMappedReader (tempFile.getFile()));
+            expect (reader != nullptr);
+
+            if (reader != nullptr)
+            {
+                expect (reader->mapSectionOfFile ({ 5000, 9000 }));
+                expect (reader->getMappedSection().contains (juce::Range<juce::int64> (5000, 9000)));
+
+                // Crosses a block boundary
+                juce::AudioBuffer<float> read (3, 4000);
+                expect (reader->read (&read, 0, 4000, 5000, true, true));
+
+                for (int chan = 0; chan < 3; ++chan)
+                    for (int i = 0; i < read.getNumSamples(); ++i)
+                        expectEquals (read.getSample (chan, i), buffer.getSample (chan, 5000 + i));
+
+                int numContiguous = 0;
+                auto data = FloatAudioFormat::getMappedChannelData (*reader, 2, 6000, numContiguous);
+                expect (data != nullptr);
+                expectEquals (numContiguous, 8192 - 6000);
+
+                if (data != nullptr)
+                    expectEquals (data[100], buffer.getSample (2, 6100));
+
+                expect (FloatAudioFormat::getMappedChannelData (*reader, 3, 6000, numContiguous) == nullptr);
+                expect (FloatAudioFormat::getMappedChannelData (*reader, 0, 100, numContiguous) == nullptr);
+            }
+        }
+
+        beginTest ("Version 2 levels");
+        {
+            FloatAudioFormat format;
+            juce::TemporaryFile tempFile (".freeze");
+            auto longBuffer = createNoise (2, 300000);
+            expect (writeFile (format, tempFile.getFile(), longBuffer));
+
+            std::unique_ptr<juce::AudioFormatReader> reader (format.createReaderFor (tempFile.getFile().createInputStream().release(), true));
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader (format.createMemoryMappedReader (tempFile.getFile()));
+            expect (reader != nullptr && mappedReader != nullptr);
+
+            if (reader != nullptr && mappedReader != nullptr)
+            {
+                expect (mappedReader->mapEntireFile());
+
+                for (auto range : { juce::Range<int> (0, 300000), juce::Range<int> (100, 7000), juce::Range<int> (300, 350),
+                                    juce::Range<int> (2048, 264192), juce::Range<int> (299990, 300000) })
+                {
+                    checkLevels (*reader, longBuffer, range);
+                    checkLevels (*mappedReader, longBuffer, range);
+                }
+            }
+        }
+    }
+
+private:
+    static juce::AudioBuffer<float> readWholeFile (FloatAudioFormat& format, const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (format.createReaderFor (file.createInputStream().release(), true));
+
+        if (reader == nullptr)
+            return {};
+
+        juce::AudioBuffer<float> buffer ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+
+        return buffer;
+    }
+
+    void checkLevels (juce::AudioFormatReader& reader, const juce::AudioBuffer<float>& buffer, juce::Range<int> range)
+    {
+        juce::Range<float> levels[2];
+        float rmsLevels[2] = {};
+
+        reader.readMaxLevels (range.getStart(), range.getLength(), levels, 2);
+        expect (FloatAudioFormat::readRMSLevels (reader, range.getStart(), range.getLength(), rmsLevels, 2));
+
+        for (int chan = 0; chan < 2; ++chan)
+        {
+            auto expectedRange = juce::FloatVectorOperations::findMinAndMax (buffer.getReadPointer (chan, range.getStart()), range.getLength());
+            expectEquals (levels[chan].getStart(), expectedRange.getStart());
+            expectEquals (levels[chan].getEnd(), expectedRange.getEnd());
+            expectWithinAbsoluteError (rmsLevels[chan], buffer.getRMSLevel (chan, range.getStart(), range.getLength()), 1.0e-4f);
+        }
+    }
+};
+
+static FloatAudioFormatTests floatAudioFormatTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class FloatAudioFormatBenchmarks  : public juce::UnitTest
+{
+public:
+    FloatAudioFormatBenchmarks()
+        : juce::UnitTest ("FloatAudioFormat Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace float_audio_format_test_utilities;
+
+        beginTest ("Read a five minute stereo file");
+
+        auto buffer = createNoise (2, (int) sampleRate * 300);
+
+        for (auto version : { FloatAudioFormat::Version::v1, FloatAudioFormat::Version::v2 })
+        {
+            FloatAudioFormat format (version);
+            juce::TemporaryFile tempFile (".freeze");
+            expect (writeFile (format, tempFile.getFile(), buffer));
+
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader (format.createMemoryMappedReader (tempFile.getFile()));
+            expect (reader != nullptr && reader->mapEntireFile());
+
+            if (reader == nullptr)
+                continue;
+
+            juce::AudioBuffer<float> block (2, 512);
+            const auto description = "Version " + juce::String ((int) version);
+
+            {
+                const StopwatchTimer timer;
+
+                for (juce::int64 pos = 0; pos < reader->lengthInSamples; pos += block.getNumSamples())
+                    reader->read (&block, 0, block.getNumSamples(), pos, true, true);
+
+                benchmark_utilities::printTime (description + " read", timer);
+            }
+
+            // Like a thumbnail of 1000 pixels
+            juce::Range<float> levels[2];
+            const auto samplesPerPixel = reader->lengthInSamples / 1000;
+
+            {
+                const StopwatchTimer timer;
+
+                for (juce::int64 pos = 0; pos + samplesPerPixel <= reader->lengthInSamples; pos += samplesPerPixel)
+                    reader->readMaxLevels (pos, samplesPerPixel, levels, 2);
+
+                benchmark_utilities::printTime (description + " levels", timer);
+            }
+        }
+    }
+};
+
+static FloatAudioFormatBenchmarks floatAudioFormatBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
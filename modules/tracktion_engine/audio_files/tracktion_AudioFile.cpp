@@ -174,7 +174,7 @@ void AudioFileWriter::closeForWriting()
     audioFileManager.checkFileForChanges (file);
 }
 
-bool AudioFileWriter::appendBuffer (juce::AudioBuffer<float>& buffer, int num)
+bool AudioFileWriter::appendBuffer (const juce::AudioBuffer<float>& buffer, int num)
 {
     num = std::min (num, buffer.getNumSamples());
     const juce::ScopedLock sl (writerLock);
@@ -804,6 +804,11 @@ bool AudioFileCache::Reader::readSamples (int numSamples,
     jassert (numSamples < CachedFile::readAheadSamples); // this method fails unless broken down into chunks smaller than this
     const auto numDestChans = destBuffer.getNumChannels();
 
+    // Discrete source channels select individual channels of a multichannel file so are
+    // mapped to the destination channels in order rather than by their types
+    if (sourceBufferChannels.size() > 0 && sourceBufferChannels.isDiscreteLayout())
+        return readDiscreteChannels (numSamples, destBuffer, startOffsetInDestBuffer, sourceBufferChannels, timeoutMs);
+
     // This may need to deal with the generic surround case if destBuffer number of channels > channelsToUse.size()
     if (cache.engine.getEngineBehaviour().isDescriptionOfWaveDevicesSupported())
     {
@@ -903,6 +908,69 @@ bool AudioFileCache::Reader::readSamples (int numSamples,
     return false;
 }
 
+bool AudioFileCache::Reader::readDiscreteChannels (int numSamples, juce::AudioBuffer<float>& destBuffer,
+                                                   int startOffsetInDestBuffer,
+                                                   const juce::AudioChannelSet& sourceBufferChannels,
+                                                   int timeoutMs)
+{
+    static constexpr int maxNumChannels = 256;
+    float* chans[maxNumChannels] = {};
+    const auto numDestChans = destBuffer.getNumChannels();
+    const auto numSourceChans = sourceBufferChannels.size();
+    int highestUsedSourceChan = -1;
+
+    // A single source channel is duplicated to all the destination channels
+    auto getFileChannel = [&] (int destIndex)
+    {
+        return (int) sourceBufferChannels.getTypeOfChannel (numSourceChans == 1 ? 0 : destIndex)
+                 - (int) juce::AudioChannelSet::discreteChannel0;
+    };
+
+    for (int destIndex = 0; destIndex < numDestChans; ++destIndex)
+    {
+        auto destData = destBuffer.getWritePointer (destIndex, startOffsetInDestBuffer);
+        auto fileChannel = getFileChannel (destIndex);
+
+        if (fileChannel >= 0 && fileChannel < maxNumChannels && fileChannel < getNumChannels())
+        {
+            if (chans[fileChannel] == nullptr)
+            {
+                chans[fileChannel] = destData;
+                highestUsedSourceChan = std::max (highestUsedSourceChan, fileChannel);
+            }
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear (destData, numSamples);
+        }
+    }
+
+    if (highestUsedSourceChan < 0)
+        return true;
+
+    if (! readSamples ((int**) chans, highestUsedSourceChan + 1, 0, numSamples, timeoutMs))
+        return false;
+
+    const bool isFloatingPoint = (file != nullptr) ? static_cast<CachedFile*> (file)->info.isFloatingPoint
+                                                   : fallbackReader->usesFloatingPointData;
+
+    if (! isFloatingPoint)
+        for (int i = 0; i <= highestUsedSourceChan; ++i)
+            if (auto chan = chans[i])
+                juce::FloatVectorOperations::convertFixedToFloat (chan, (const int*) chan, 1.0f / 0x7fffffff, numSamples);
+
+    for (int destIndex = 0; destIndex < numDestChans; ++destIndex)
+    {
+        auto destData = destBuffer.getWritePointer (destIndex, startOffsetInDestBuffer);
+        auto fileChannel = getFileChannel (destIndex);
+
+        if (fileChannel >= 0 && fileChannel < maxNumChannels && chans[fileChannel] != nullptr && chans[fileChannel] != destData)
+            juce::FloatVectorOperations::copy (destData, chans[fileChannel], numSamples);
+    }
+
+    return true;
+}
+
 bool AudioFileCache::Reader::readSamples (int** destSamples, int numDestChannels,
                                           int startOffsetInDestBuffer, int numSamples, int timeoutMs)
 {
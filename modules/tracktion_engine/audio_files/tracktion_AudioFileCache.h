@@ -50,6 +50,7 @@ public:
                        int timeoutMs);
 
         void setLoopRange (juce::Range<juce::int64> newRange);
+        juce::Range<juce::int64> getLoopRange() const noexcept     { auto start = loopStart.load(); return { start, start + loopLength.load() }; }
 
         int getNumChannels() const noexcept;
         double getSampleRate() const noexcept;
@@ -64,6 +65,9 @@ public:
 
         Reader (AudioFileCache&, void*, juce::BufferingAudioReader* fallback);
 
+        bool readDiscreteChannels (int numSamples, juce::AudioBuffer<float>& destBuffer, int startOffsetInDestBuffer,
+                                   const juce::AudioChannelSet& sourceBufferChannels, int timeoutMs);
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reader)
     };
 
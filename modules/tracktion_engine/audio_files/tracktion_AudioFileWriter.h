@@ -44,7 +44,7 @@ public:
 
     //==============================================================================
     /** Appends an AudioBuffer to the file. */
-    bool appendBuffer (juce::AudioBuffer<float>& buffer, int numSamples);
+    bool appendBuffer (const juce::AudioBuffer<float>& buffer, int numSamples);
 
     /** Appends an block of samples to the file. */
     bool appendBuffer (const int** buffer, int numSamples);
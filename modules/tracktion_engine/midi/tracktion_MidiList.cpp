@@ -1093,10 +1093,25 @@ void MidiList::initialise (juce::UndoManager* um)
 
 void MidiList::clear (juce::UndoManager* um)
 {
+    const ScopedBatchUpdate batch (*this);
     state.removeAllChildren (um);
     importedName = {};
 }
 
+MidiList::ScopedBatchUpdate::ScopedBatchUpdate (MidiList& l)  : list (l)
+{
+    list.noteList->beginBatch();
+    list.controllerList->beginBatch();
+    list.sysexList->beginBatch();
+}
+
+MidiList::ScopedBatchUpdate::~ScopedBatchUpdate()
+{
+    list.noteList->endBatch();
+    list.controllerList->endBatch();
+    list.sysexList->endBatch();
+}
+
 void MidiList::copyFrom (const MidiList& other, juce::UndoManager* um)
 {
     if (this != &other)
@@ -1110,8 +1125,12 @@ void MidiList::copyFrom (const MidiList& other, juce::UndoManager* um)
 void MidiList::addFrom (const MidiList& other, juce::UndoManager* um)
 {
     if (this != &other)
+    {
+        const ScopedBatchUpdate batch (*this);
+
         for (int i = 0; i < other.state.getNumChildren(); ++i)
             state.addChild (other.state.getChild (i).createCopy(), -1, um);
+    }
 }
 
 void MidiList::setMidiChannel (MidiChannel newChannel)
@@ -1214,6 +1233,8 @@ void MidiList::trimOutside (double start, double end, juce::UndoManager* um)
         if (s->getBeatPosition() < start || s->getBeatPosition() >= end)
             itemsToRemove.add (s->state);
 
+    const ScopedBatchUpdate batch (*this);
+
     for (auto& v : itemsToRemove)
         state.removeChild (v, um);
 }
@@ -1243,11 +1264,7 @@ double MidiList::getLastBeatNumber() const
 
 MidiNote* MidiList::getNoteFor (const juce::ValueTree& s)
 {
-    for (auto n : getNotes())
-        if (n->state == s)
-            return n;
-
-    return {};
+    return noteList->getEventFor (s);
 }
 
 juce::Range<int> MidiList::getNoteNumberRange() const
@@ -1289,6 +1306,8 @@ void MidiList::removeNote (MidiNote& note, juce::UndoManager* um)
 
 void MidiList::removeAllNotes (juce::UndoManager* um)
 {
+    const ScopedBatchUpdate batch (*this);
+
     for (int i = state.getNumChildren(); --i >= 0;)
         if (state.getChild (i).hasType (IDs::NOTE))
             state.removeChild (i, um);
@@ -1347,6 +1366,8 @@ void MidiList::removeControllerEvent (MidiControllerEvent& e, juce::UndoManager*
 
 void MidiList::removeAllControllers (juce::UndoManager* um)
 {
+    const ScopedBatchUpdate batch (*this);
+
     for (int i = state.getNumChildren(); --i >= 0;)
         if (state.getChild (i).hasType (IDs::CONTROL))
             state.removeChild (i, um);
@@ -1420,6 +1441,8 @@ void MidiList::removeControllersBetween (int controllerType, double beatStart, d
         if (e->getType() == controllerType && e->getBeatPosition() >= beatStart && e->getBeatPosition() < beatEnd)
             itemsToRemove.add (e->state);
 
+    const ScopedBatchUpdate batch (*this);
+
     for (auto& v : itemsToRemove)
         state.removeChild (v, um);
 }
@@ -1427,11 +1450,7 @@ void MidiList::removeControllersBetween (int controllerType, double beatStart, d
 //==============================================================================
 MidiSysexEvent* MidiList::getSysexEventFor (const juce::ValueTree& v) const
 {
-    for (auto n : getSysexEvents())
-        if (n->state == v)
-            return n;
-
-    return {};
+    return sysexList->getEventFor (v);
 }
 
 MidiSysexEvent& MidiList::addSysExEvent (const juce::MidiMessage& message, double beat, juce::UndoManager* um)
@@ -1449,6 +1468,8 @@ void MidiList::removeSysExEvent (const MidiSysexEvent& event, juce::UndoManager*
 
 void MidiList::removeAllSysexes (juce::UndoManager* um)
 {
+    const ScopedBatchUpdate batch (*this);
+
     for (int i = state.getNumChildren(); --i >= 0;)
         if (state.getChild (i).hasType (IDs::SYSEX))
             state.removeChild (i, um);
@@ -1673,6 +1694,7 @@ void MidiList::importMidiSequence (const juce::MidiMessageSequence& sequence, Ed
     auto ts = edit != nullptr ? &edit->tempoSequence : nullptr;
     auto firstBeatNum = ts != nullptr ? ts->timeToBeats (editTimeOfListTimeZero) : 0.0;
     const int channelNumber = getMidiChannel().getChannelNumber();
+    const ScopedBatchUpdate batch (*this);
 
     for (int i = 0; i < sequence.getNumEvents(); ++i)
     {
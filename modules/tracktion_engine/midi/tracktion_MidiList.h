@@ -60,6 +60,23 @@ public:
     bool isEmpty() const noexcept                                   { return state.getNumChildren() == 0; }
 
     void clear (juce::UndoManager*);
+
+    /** Batches the changes made to the list while it exists.
+        Adding or removing lots of events inside one of these updates the lists of
+        events in one go at the end rather than once for each event. Until it's deleted,
+        getNotes() etc. won't include events that have been added and will still include
+        ones that have been removed, but getNoteFor() etc. are kept up to date.
+    */
+    struct ScopedBatchUpdate
+    {
+        ScopedBatchUpdate (MidiList&);
+        ~ScopedBatchUpdate();
+
+        MidiList& list;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatchUpdate)
+    };
+
     void trimOutside (double firstBeat, double lastBeat, juce::UndoManager*);
     void moveAllBeatPositions (double deltaBeats, juce::UndoManager*);
     void rescale (double factor, juce::UndoManager*);
@@ -189,26 +206,22 @@ private:
     };
 
     template<typename EventType>
-    struct EventList : public ValueTreeObjectList<EventType>
+    struct EventList : public IndexedValueTreeObjectList<EventType>
     {
         EventList (const juce::ValueTree& v)
-            : ValueTreeObjectList<EventType> (v)
+            : IndexedValueTreeObjectList<EventType> (v)
         {
-            ValueTreeObjectList<EventType>::rebuildObjects();
+            IndexedValueTreeObjectList<EventType>::rebuildObjects();
         }
 
         ~EventList() override
         {
-            ValueTreeObjectList<EventType>::freeObjects();
+            IndexedValueTreeObjectList<EventType>::freeObjects();
         }
 
-        EventType* getEventFor (const juce::ValueTree& v)
+        EventType* getEventFor (const juce::ValueTree& v) const
         {
-            for (auto m : ValueTreeObjectList<EventType>::objects)
-                if (m->state == v)
-                    return m;
-
-            return {};
+            return IndexedValueTreeObjectList<EventType>::getObjectFor (v);
         }
 
         bool isSuitableType (const juce::ValueTree& v) const override   { return EventDelegate<EventType>::isSuitableType (v); }
@@ -0,0 +1,217 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class MidiListTests : public juce::UnitTest
+{
+public:
+    MidiListTests()
+        : juce::UnitTest ("MidiList", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        beginTest ("Notes can be found from their state");
+        {
+            MidiList list;
+
+            for (int i = 0; i < 100; ++i)
+                expect (list.addNote (60, i, 0.5, 100, 0, nullptr) != nullptr);
+
+            expectEquals (list.getNumNotes(), 100);
+
+            for (auto n : list.getNotes())
+                expect (list.getNoteFor (n->state) == n);
+
+            // Remove every other note, then insert some in the middle of the tree
+            auto notes = list.getNotes();
+            auto firstNoteState = notes.getFirst()->state;
+
+            for (int i = 0; i < notes.size(); i += 2)
+                list.removeNote (*notes.getUnchecked (i), nullptr);
+
+            expectEquals (list.getNumNotes(), 50);
+            expect (list.getNoteFor (firstNoteState) == nullptr);
+
+            for (int i = 0; i < 10; ++i)
+                list.state.addChild (createNoteValueTree (72, i + 0.25, 0.5, 100, 0), i * 3, nullptr);
+
+            expectEquals (list.getNumNotes(), 60);
+            expectNotesMatchState (list);
+        }
+
+        beginTest ("Batched changes are applied at the end of the batch");
+        {
+            MidiList list;
+            list.addControllerEvent (0.0, 1, 0, nullptr);
+
+            {
+                const MidiList::ScopedBatchUpdate batch (list);
+
+                for (int i = 0; i < 50; ++i)
+                {
+                    auto n = list.addNote (60, i, 0.5, 100, 0, nullptr);
+                    expect (n != nullptr);
+                    expect (list.getNoteFor (n->state) == n);
+                }
+
+                list.removeAllControllers (nullptr);
+                expectEquals (list.getNumNotes(), 0);
+                expectEquals (list.getControllerEvents().size(), 1);
+            }
+
+            expectEquals (list.getNumNotes(), 50);
+            expectEquals (list.getControllerEvents().size(), 0);
+            expectNotesMatchState (list);
+
+            {
+                const MidiList::ScopedBatchUpdate batch (list);
+                auto notes = list.getNotes();
+
+                // Add and remove the same note inside the batch
+                auto n = list.addNote (64, 100.0, 1.0, 100, 0, nullptr);
+                list.removeNote (*n, nullptr);
+
+                for (int i = 0; i < 10; ++i)
+                    list.removeNote (*notes.getUnchecked (i), nullptr);
+            }
+
+            expectEquals (list.getNumNotes(), 40);
+            expectNotesMatchState (list);
+        }
+
+        beginTest ("Undoing a bulk delete restores the notes");
+        {
+            juce::UndoManager um;
+            MidiList list;
+
+            for (int i = 0; i < 100; ++i)
+                list.addNote (60 + (i % 12), i * 0.5, 0.5, 100, 0, nullptr);
+
+            um.beginNewTransaction();
+            list.removeAllNotes (&um);
+            expectEquals (list.getNumNotes(), 0);
+
+            um.undo();
+            expectEquals (list.getNumNotes(), 100);
+            expectNotesMatchState (list);
+
+            um.redo();
+            expectEquals (list.getNumNotes(), 0);
+        }
+    }
+
+private:
+    void expectNotesMatchState (MidiList& list)
+    {
+        int numNoteStates = 0;
+
+        for (auto v : list.state)
+        {
+            if (! v.hasType (IDs::NOTE))
+                continue;
+
+            ++numNoteStates;
+            auto n = list.getNoteFor (v);
+            expect (n != nullptr && n->state == v);
+        }
+
+        expectEquals (list.getNumNotes(), numNoteStates);
+    }
+};
+
+static MidiListTests midiListTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class MidiListBenchmarks : public juce::UnitTest
+{
+public:
+    MidiListBenchmarks()
+        : juce::UnitTest ("MidiList Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        for (int numNotes : { 10000, 100000 })
+        {
+            runBulkEdits (numNotes, false);
+            runBulkEdits (numNotes, true);
+        }
+    }
+
+private:
+    void runBulkEdits (int numNotes, bool batched)
+    {
+        beginTest (juce::String (numNotes) + " notes" + (batched ? " (batched)" : ""));
+
+        MidiList list;
+        std::unique_ptr<MidiList::ScopedBatchUpdate> batch;
+
+        {
+            StopwatchTimer timer;
+
+            if (batched)
+                batch = std::make_unique<MidiList::ScopedBatchUpdate> (list);
+
+            for (int i = 0; i < numNotes; ++i)
+                list.addNote (36 + (i % 48), i * 0.25 + 0.01, 0.2, 100, 0, nullptr);
+
+            batch.reset();
+            benchmark_utilities::printTime ("Insert", timer);
+        }
+
+        expectEquals (list.getNumNotes(), numNotes);
+
+        {
+            // Quantising changes the properties of every note, which looks up each one
+            StopwatchTimer timer;
+
+            for (auto n : list.getNotes())
+                n->setStartAndLength (std::round (n->getStartBeat() * 4.0) / 4.0, 0.25, nullptr);
+
+            benchmark_utilities::printTime ("Quantise", timer);
+        }
+
+        {
+            // Delete from the end of the tree so this measures the list rather than juce::ValueTree::indexOf
+            StopwatchTimer timer;
+
+            if (batched)
+                batch = std::make_unique<MidiList::ScopedBatchUpdate> (list);
+
+            auto notes = list.getNotes();
+
+            for (int i = notes.size(); --i >= 0;)
+                list.removeNote (*notes.getUnchecked (i), nullptr);
+
+            batch.reset();
+            benchmark_utilities::printTime ("Delete", timer);
+        }
+
+        expectEquals (list.getNumNotes(), 0);
+    }
+};
+
+static MidiListBenchmarks midiListBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
@@ -502,6 +502,16 @@ struct AutomatableParameter::AttachedValue  : public juce::AsyncUpdater
 
     virtual ~AttachedValue() { cancelPendingUpdate(); }
 
+    /** Writes the value automation has set back to the state. The curve sets the value
+        when rendering anyway, so this isn't a change that needs anything re-rendering.
+    */
+    void handleAsyncUpdate() override
+    {
+        const EditChangeTracker::ScopedIgnore sci (parameter.getEdit());
+        updateValueFromParameter();
+    }
+
+    virtual void updateValueFromParameter() = 0;
     virtual void setValue (float v) = 0;
     virtual float getValue() = 0;
     virtual float getDefault() = 0;
@@ -520,7 +530,7 @@ struct AutomatableParameter::AttachedFloatValue : public AutomatableParameter::A
         parameter.setParameter (value, juce::dontSendNotification);
     }
 
-    void handleAsyncUpdate() override               { value.setValue (parameter.currentValue, nullptr); }
+    void updateValueFromParameter() override        { value.setValue (parameter.currentValue, nullptr); }
     float getValue() override                       { return value; }
     void setValue (float v) override                { value = v; }
     float getDefault() override                     { return value.getDefault(); }
@@ -552,7 +562,7 @@ struct AutomatableParameter::AttachedIntValue : public AutomatableParameter::Att
         parameter.setParameter ((float) value.get(), juce::dontSendNotification);
     }
 
-    void handleAsyncUpdate() override               { value.setValue (roundToInt (parameter.getCurrentValue()), nullptr); }
+    void updateValueFromParameter() override        { value.setValue (roundToInt (parameter.getCurrentValue()), nullptr); }
     float getValue() override                       { return (float) value.get(); }
     void setValue (float v) override                { value = roundToInt (v); }
     float getDefault() override                     { return (float) value.getDefault(); }
@@ -584,7 +594,7 @@ struct AutomatableParameter::AttachedBoolValue : public AutomatableParameter::At
         parameter.setParameter (value.get() ? 1.0f : 0.0f, juce::dontSendNotification);
     }
 
-    void handleAsyncUpdate() override               { value.setValue (parameter.currentValue != 0.0f, nullptr); }
+    void updateValueFromParameter() override        { value.setValue (parameter.currentValue != 0.0f, nullptr); }
     float getValue() override                       { return value; }
     void setValue (float v) override                { value = v != 0 ? true : false; }
     float getDefault() override                     { return value.getDefault() ? 1.0f : 0.0f; }
@@ -1066,7 +1076,7 @@ void AutomatableParameter::setParameter (float value, juce::NotificationType nt)
         if (attachedValue != nullptr)
         {
             // Updates the ValueTree via the CachedValue to the current parameter value synchronously
-            attachedValue->handleAsyncUpdate();
+            attachedValue->updateValueFromParameter();
         }
     }
 }
@@ -1165,6 +1175,28 @@ void AutomatableParameter::midiControllerPressed()
 void AutomatableParameter::curveHasChanged()
 {
     CRASH_TRACER
+    auto& ed = getEdit();
+
+    // Editing lots of points in a transaction only needs the listeners calling once
+    if (ed.isInTransaction())
+    {
+        if (! curveChangePending)
+        {
+            curveChangePending = true;
+
+            ed.callWhenTransactionEnds ([ref = getWeakRef()]
+            {
+                if (auto param = dynamic_cast<AutomatableParameter*> (ref.get()))
+                {
+                    param->curveChangePending = false;
+                    param->curveHasChanged();
+                }
+            });
+        }
+
+        return;
+    }
+
     curveSource->triggerAsyncCurveUpdate();
     getEdit().getParameterChangeHandler().parameterChanged (*this, false);
     listeners.call (&Listener::curveHasChanged, *this);
@@ -238,6 +238,7 @@ protected:
     std::atomic<float> currentValue { 0.0f }, currentParameterValue { 0.0f },  currentBaseValue { 0.0f }, currentModifierValue { 0.0f };
     std::atomic<bool> isRecording { false };
     bool updateParametersRecursionCheck = false;
+    bool curveChangePending = false;
 
     juce::ValueTree modifiersState;
     struct AutomationSourceList;
@@ -35,6 +35,16 @@ public:
     /** Performs the actual detection. */
     JobStatus runJob() override
     {
+        // Use the tempo from a batch analysis if the file's already been through one
+        auto cached = AudioFileAnalyser (engine).getCachedAnalysis (AudioFile (engine, sourceFile));
+
+        if (cached.isValid())
+        {
+            bpm = cached.bpm;
+            isSensible = bpm > 0;
+            return jobHasFinished;
+        }
+
         std::unique_ptr<AudioFormatReader> reader (AudioFileUtils::createReaderFor (engine, sourceFile));
 
         if (reader == nullptr)
@@ -481,6 +491,12 @@ bool AudioClipBase::isRightChannelActive() const
     return activeChannels.size() == 0 || activeChannels.getChannelIndexForType (juce::AudioChannelSet::right) != -1;
 }
 
+void AudioClipBase::setActiveChannels (const juce::AudioChannelSet& set)
+{
+    if (set.size() > 0)
+        channels = set.getSpeakerArrangementAsString();
+}
+
 //==============================================================================
 bool AudioClipBase::setFadeIn (double in)
 {
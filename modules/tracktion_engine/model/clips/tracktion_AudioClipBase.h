@@ -152,6 +152,10 @@ public:
     /** Returns whether the right channel of the clip is enabled. */
     bool isRightChannelActive() const;
 
+    /** Sets the channels of the source file to play.
+        This can be a set of discrete channels to play individual channels of a multichannel file.
+    */
+    void setActiveChannels (const juce::AudioChannelSet&);
     /** Returns the layout of the active channels. */
     juce::AudioChannelSet getActiveChannels() const     { return activeChannels; }
 
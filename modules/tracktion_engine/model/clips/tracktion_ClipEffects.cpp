@@ -78,6 +78,7 @@ private:
     {
         clipEffects.cachedClipProperties = nullptr;
         clipEffects.cachedHash = ClipEffects::hashNeedsRecaching;
+        clipEffects.cachedRenderedHash = ClipEffects::hashNeedsRecaching;
     }
 
     void valueTreePropertyChanged (ValueTree& v, const juce::Identifier& i) override
@@ -90,7 +91,8 @@ private:
             {
                 invalidateCache();
             }
-            else if (matchesAnyOf (i, { speed, loopStart, loopLength, loopStartBeats, loopLengthBeats, autoTempo }))
+            else if (matchesAnyOf (i, { speed, loopStart, loopLength, loopStartBeats, loopLengthBeats, autoTempo,
+                                        autoPitch, pitchChange, elastiqueMode }))
             {
                 invalidateCache();
                 triggerAsyncUpdate();
@@ -205,6 +207,11 @@ struct ClipEffect::ClipEffectRenderJob  : public ReferenceCountedObject
     */
     virtual bool completeRender() = 0;
 
+    /** Should return any files other than the destination that the render writes.
+        These are validated along with the destination once the job completes.
+    */
+    virtual juce::Array<AudioFile> getIntermediateFiles() const     { return {}; }
+
     Engine& engine;
     const AudioFile destination, source;
     std::atomic<float> progress { 0.0f };
@@ -569,37 +576,104 @@ struct BlockBasedRenderJob : public ClipEffect::ClipEffectRenderJob
     bool setUpRender() override
     {
         CRASH_TRACER
-        auto sourceInfo = source.getInfo();
-        jassert (sourceInfo.numChannels > 0 && sourceInfo.sampleRate > 0.0 && sourceInfo.bitsPerSample > 0);
+        if (! openReader())
+            return false;
 
-        // need to strip AIFF metadata to write to wav files
-        if (sourceInfo.metadata.getValue ("MetaDataSource", "None") == "AIFF")
-            sourceInfo.metadata.clear();
+        writer = createWriterFor (destination, getNumOutputChannels ((int) reader->numChannels));
+        return writer->isOpen();
+    }
+
+    /** Renders the next block using readNextBlock.
+        Subclasses that can't produce their output a block at a time should override this instead.
+    */
+    bool renderNextBlock() override
+    {
+        CRASH_TRACER
+        // Some effects output more channels than they read, e.g. panning a mono source
+        AudioScratchBuffer scratch (jmax ((int) reader->numChannels, getNumOutputChannels ((int) reader->numChannels)), blockSize);
+        auto numDone = readNextBlock (scratch.buffer);
+
+        juce::AudioBuffer<float> output (scratch.buffer.getArrayOfWritePointers(),
+                                         getNumOutputChannels ((int) reader->numChannels), numDone);
+        writer->appendBuffer (output, numDone);
+
+        return position >= sourceLengthSamples;
+    }
+
+    bool completeRender() override
+    {
+        CRASH_TRACER
+        reader = nullptr;
+        writer = nullptr;
+
+        return true;
+    }
 
+    //==============================================================================
+    /** Opens the source file and works out how many samples need rendering. */
+    bool openReader()
+    {
         reader.reset (AudioFileUtils::createReaderFor (engine, source.getFile()));
 
         if (reader == nullptr || reader->lengthInSamples == 0)
             return false;
 
         sourceLengthSamples = (juce::int64) (sourceLengthSeconds * reader->sampleRate);
+        return true;
+    }
 
-        writer.reset (new AudioFileWriter (destination, engine.getAudioFileFormatManager().getWavFormat(),
-                                           sourceInfo.numChannels, sourceInfo.sampleRate,
-                                           jmax (16, sourceInfo.bitsPerSample),
-                                           sourceInfo.metadata, 0));
+    /** Creates a wav writer with the same format as the source file. */
+    std::unique_ptr<AudioFileWriter> createWriterFor (const AudioFile& file, int numChannels) const
+    {
+        auto sourceInfo = source.getInfo();
+        jassert (sourceInfo.numChannels > 0 && sourceInfo.sampleRate > 0.0 && sourceInfo.bitsPerSample > 0);
 
-        return writer->isOpen();
+        // need to strip AIFF metadata to write to wav files
+        if (sourceInfo.metadata.getValue ("MetaDataSource", "None") == "AIFF")
+            sourceInfo.metadata.clear();
+
+        return std::make_unique<AudioFileWriter> (file, engine.getAudioFileFormatManager().getWavFormat(),
+                                                  numChannels, sourceInfo.sampleRate,
+                                                  jmax (16, sourceInfo.bitsPerSample),
+                                                  sourceInfo.metadata, 0);
     }
 
-    bool completeRender() override
+    /** Should return true if readNextBlock is implemented, which lets this job read the
+        source at the start of a FusedRenderJob.
+    */
+    virtual bool canReadBlocks() const                              { return true; }
+
+    /** Should return true if the output of processBlock only depends on the samples it's
+        given. This lets the job be fused with the previous one rather than read its file.
+    */
+    virtual bool canProcessBlocksInPlace() const                    { return false; }
+
+    /** Returns the number of channels the output will have for a number of input channels. */
+    virtual int getNumOutputChannels (int numInputChannels) const   { return numInputChannels; }
+
+    /** Reads the next block of the source into the buffer and processes it, returning
+        the number of samples read. The buffer must have as many channels as the source.
+    */
+    virtual int readNextBlock (juce::AudioBuffer<float>& buffer)
     {
-        CRASH_TRACER
-        reader = nullptr;
-        writer = nullptr;
+        auto todo = (int) jmin ((juce::int64) jmin (blockSize, buffer.getNumSamples()), sourceLengthSamples - position);
+        reader->read (&buffer, 0, todo, position, true, true);
+        processBlock (buffer, (int) reader->numChannels, todo, position, reader->sampleRate);
 
-        return true;
+        position += todo;
+        progress = float (position) / float (sourceLengthSamples);
+
+        return todo;
     }
 
+    /** Applies the effect to the first numChannels of a buffer in-place.
+        startSample is the position in the source file of the start of the buffer.
+    */
+    virtual void processBlock (juce::AudioBuffer<float>&, int /*numChannels*/, int /*numSamples*/,
+                               juce::int64 /*startSample*/, double /*sampleRate*/) {}
+
+    static constexpr int blockSize = 32768;
+
 protected:
     std::unique_ptr<AudioFormatReader> reader;
     std::unique_ptr<AudioFileWriter> writer;
@@ -608,9 +682,158 @@ protected:
     juce::int64 position = 0;
     juce::int64 sourceLengthSamples = 0;
 
+    friend struct FusedRenderJob;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockBasedRenderJob)
 };
 
+//==============================================================================
+/**
+    Runs a BlockBasedRenderJob followed by any number of jobs that can process their
+    blocks in-place, streaming each block through all of them in memory.
+    Only the last job's destination file is written, along with the output of the
+    job before it so editing the last effect in a chain won't re-render the rest.
+*/
+struct FusedRenderJob  : public ClipEffect::ClipEffectRenderJob
+{
+    FusedRenderJob (Engine& e, ReferenceCountedArray<BlockBasedRenderJob> jobsToFuse)
+        : ClipEffect::ClipEffectRenderJob (e, jobsToFuse.getLast()->destination, jobsToFuse.getFirst()->source),
+          jobs (std::move (jobsToFuse))
+    {
+        jassert (jobs.size() > 1);
+        jassert (jobs.getFirst()->canReadBlocks());
+
+        for (int i = 1; i < jobs.size(); ++i)
+            jassert (jobs.getUnchecked (i)->canProcessBlocksInPlace());
+    }
+
+    bool setUpRender() override
+    {
+        CRASH_TRACER
+        auto& head = *jobs.getFirst();
+
+        if (! head.openReader())
+            return false;
+
+        int numChannels = (int) head.reader->numChannels;
+        maxNumChannels = numChannels;
+
+        for (int i = 0; i < jobs.size(); ++i)
+        {
+            numChannels = jobs.getUnchecked (i)->getNumOutputChannels (numChannels);
+            maxNumChannels = jmax (maxNumChannels, numChannels);
+
+            if (i == jobs.size() - 2)
+                checkpointWriter = head.createWriterFor (jobs.getUnchecked (i)->destination, numChannels);
+        }
+
+        writer = head.createWriterFor (destination, numChannels);
+
+        return writer->isOpen() && checkpointWriter->isOpen();
+    }
+
+    bool renderNextBlock() override
+    {
+        CRASH_TRACER
+        auto& head = *jobs.getFirst();
+
+        AudioScratchBuffer scratch (maxNumChannels, BlockBasedRenderJob::blockSize);
+        const auto startSample = head.position;
+        auto numDone = head.readNextBlock (scratch.buffer);
+        int numChannels = head.getNumOutputChannels ((int) head.reader->numChannels);
+
+        for (int i = 1; i < jobs.size(); ++i)
+        {
+            if (i == jobs.size() - 1)
+                write (*checkpointWriter, scratch.buffer, numChannels, numDone);
+
+            auto& job = *jobs.getUnchecked (i);
+            job.processBlock (scratch.buffer, numChannels, numDone, startSample, head.reader->sampleRate);
+            numChannels = job.getNumOutputChannels (numChannels);
+        }
+
+        write (*writer, scratch.buffer, numChannels, numDone);
+        progress = head.progress.load();
+
+        return head.position >= head.sourceLengthSamples;
+    }
+
+    bool completeRender() override
+    {
+        CRASH_TRACER
+        writer = nullptr;
+        checkpointWriter = nullptr;
+
+        return jobs.getFirst()->completeRender();
+    }
+
+    juce::Array<AudioFile> getIntermediateFiles() const override
+    {
+        return { jobs[jobs.size() - 2]->destination };
+    }
+
+private:
+    ReferenceCountedArray<BlockBasedRenderJob> jobs;
+    std::unique_ptr<AudioFileWriter> writer, checkpointWriter;
+    int maxNumChannels = 0;
+
+    static void write (AudioFileWriter& w, juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> output (buffer.getArrayOfWritePointers(), numChannels, numSamples);
+        w.appendBuffer (output, numSamples);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FusedRenderJob)
+};
+
+//==============================================================================
+/** Renders an effect with its RealTimeProcessor so the file matches real-time playback exactly. */
+struct RealTimeProcessorRenderJob  : public BlockBasedRenderJob
+{
+    RealTimeProcessorRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength,
+                                std::unique_ptr<ClipEffect::RealTimeProcessor> p)
+        : BlockBasedRenderJob (e, dest, src, sourceLength), processor (std::move (p))
+    {
+        jassert (processor != nullptr);
+    }
+
+    bool canProcessBlocksInPlace() const override                   { return true; }
+    int getNumOutputChannels (int numInputChannels) const override  { return processor->getNumOutputChannels (numInputChannels); }
+
+    void processBlock (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples,
+                       juce::int64 startSample, double sampleRate) override
+    {
+        processor->process (buffer, numChannels, 0, numSamples, startSample, sampleRate);
+    }
+
+    const std::unique_ptr<ClipEffect::RealTimeProcessor> processor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealTimeProcessorRenderJob)
+};
+
+/** Multiplies some channels of a buffer by a gain that depends on the time in the source file. */
+template<typename GainFunction>
+static void applyGainAtSourceTimes (juce::AudioBuffer<float>& buffer, int firstChannel, int numChannels,
+                                    int startSample, int numSamples, juce::int64 sourceStartSample,
+                                    double sampleRate, GainFunction&& getGainAt)
+{
+    constexpr int chunkSize = 256;
+    float gains[chunkSize];
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int num = jmin (chunkSize, numSamples - done);
+
+        for (int i = 0; i < num; ++i)
+            gains[i] = getGainAt ((sourceStartSample + done + i) / sampleRate);
+
+        for (int c = firstChannel; c < firstChannel + numChannels; ++c)
+            FloatVectorOperations::multiply (buffer.getWritePointer (c, startSample + done), gains, num);
+
+        done += num;
+    }
+}
+
 //==============================================================================
 class WarpTimeEffectRenderJob :   public BlockBasedRenderJob
 {
@@ -630,6 +853,8 @@ public:
                                         ? tm : TimeStretcher::defaultMode;
     }
 
+    bool canReadBlocks() const override     { return false; }
+
     bool renderNextBlock() override
     {
         CRASH_TRACER
@@ -673,16 +898,110 @@ VolumeEffect::VolumeEffect (const ValueTree& v, ClipEffects& o)
     plugin = new VolumeAndPanPlugin (edit, volState, false);
 }
 
+/** Applies a snapshot of the volume and pan automation, interpolated between points at regular intervals. */
+struct VolumePanProcessor  : public ClipEffect::RealTimeProcessor
+{
+    /** Mono sources are panned so become stereo, in the same way as the VolumeAndPanPlugin. */
+    int getNumOutputChannels (int numInputChannels) const override  { return jmax (2, numInputChannels); }
+
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples,
+                  juce::int64 sourceStartSample, double sampleRate) const override
+    {
+        if (numChannels == 1 && buffer.getNumChannels() > 1)
+        {
+            buffer.copyFrom (1, startSample, buffer, 0, startSample, numSamples);
+            numChannels = 2;
+        }
+
+        // The left and right channels use the pan, any others just the volume
+        for (int c = 0; c < jmin (numChannels, 3); ++c)
+        {
+            const auto type = (size_t) c;
+            const int numChannelsToApplyTo = c < 2 ? 1 : numChannels - 2;
+
+            if (gains.size() == 1)
+            {
+                for (int i = c; i < c + numChannelsToApplyTo; ++i)
+                    buffer.applyGain (i, startSample, numSamples, gains.front()[type]);
+
+                continue;
+            }
+
+            applyGainAtSourceTimes (buffer, c, numChannelsToApplyTo, startSample, numSamples, sourceStartSample, sampleRate,
+                                    [this, type] (double t) { return getGainAt (type, t); });
+        }
+    }
+
+    float getGainAt (size_t type, double time) const noexcept
+    {
+        const auto pos = jlimit (0.0, (double) (gains.size() - 1), time / interval);
+        const auto index = (size_t) pos;
+
+        if (index + 1 >= gains.size())
+            return gains.back()[type];
+
+        const auto start = gains[index][type];
+        return start + (float) (pos - (double) index) * (gains[index + 1][type] - start);
+    }
+
+    static constexpr double interval = 0.01;
+
+    // The left, right and other channel gains at each interval of the source
+    std::vector<std::array<float, 3>> gains;
+};
+
 ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> VolumeEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
 {
     CRASH_TRACER
-    EditTimeRange timeRange (0.0, sourceLength);
-    jassert (! timeRange.isEmpty());
+    jassert (sourceLength > 0);
 
-    auto n = new WaveAudioNode (sourceFile, timeRange, 0.0, {}, {}, 1.0, AudioChannelSet::stereo());
+    return new RealTimeProcessorRenderJob (edit.engine, getDestinationFile(), sourceFile,
+                                           sourceLength, createRealTimeProcessor());
+}
 
-    return new AudioNodeRenderJob (edit.engine, new PluginAudioNode (plugin, n, false),
-                                   getDestinationFile(), sourceFile, 128);
+std::unique_ptr<ClipEffect::RealTimeProcessor> VolumeEffect::createRealTimeProcessor()
+{
+    CRASH_TRACER
+    auto processor = std::make_unique<VolumePanProcessor>();
+
+    if (plugin == nullptr || ! plugin->isEnabled())
+    {
+        processor->gains.push_back ({ 1.0f, 1.0f, 1.0f });
+        return processor;
+    }
+
+    // The automation is in source time as the effect is applied to the source file
+    auto getGainsAt = [this] (double time) -> std::array<float, 3>
+    {
+        auto getValueAt = [time] (AutomatableParameter& ap)
+        {
+            return ap.hasAutomationPoints() ? ap.getCurve().getValueAt (time)
+                                            : ap.getCurrentValue();
+        };
+
+        const auto volume = getValueAt (*plugin->volParam);
+        const auto polarity = plugin->polarity ? -1.0f : 1.0f;
+
+        float left, right;
+        getGainsFromVolumeFaderPositionAndPan (volume, getValueAt (*plugin->panParam), plugin->getPanLaw(), left, right);
+
+        return {{ left * polarity, right * polarity, volumeFaderPositionToGain (volume) * polarity }};
+    };
+
+    if (plugin->volParam->hasAutomationPoints() || plugin->panParam->hasAutomationPoints())
+    {
+        const auto numPoints = (size_t) std::ceil (getClip().getSourceLength() / VolumePanProcessor::interval) + 1;
+        processor->gains.reserve (numPoints);
+
+        for (size_t i = 0; i < numPoints; ++i)
+            processor->gains.push_back (getGainsAt ((double) i * VolumePanProcessor::interval));
+    }
+    else
+    {
+        processor->gains.push_back (getGainsAt (0.0));
+    }
+
+    return processor;
 }
 
 bool VolumeEffect::hasProperties()
@@ -775,9 +1094,81 @@ void FadeInOutEffect::setFadeOut (double out)
     }
 }
 
+/** Mutes the source outside the effect range and applies the fade curves at either end. */
+struct FadeInOutProcessor  : public ClipEffect::RealTimeProcessor
+{
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples,
+                  juce::int64 sourceStartSample, double sampleRate) const override
+    {
+        const EditTimeRange blockTime (sourceStartSample / sampleRate, (sourceStartSample + numSamples) / sampleRate);
+
+        if (blockTime.getEnd() <= effectRange.getStart() || blockTime.getStart() >= effectRange.getEnd())
+        {
+            for (int c = 0; c < numChannels; ++c)
+                buffer.clear (c, startSample, numSamples);
+
+            return;
+        }
+
+        if (blockTime.getStart() >= fadeInRange.getEnd() && blockTime.getEnd() <= fadeOutRange.getStart())
+            return;
+
+        applyGainAtSourceTimes (buffer, 0, numChannels, startSample, numSamples, sourceStartSample, sampleRate,
+                                [this] (double t) { return getGainAt (t); });
+    }
+
+    float getGainAt (double time) const noexcept
+    {
+        if (! effectRange.contains (time))
+            return 0.0f;
+
+        float gain = 1.0f;
+
+        if (time < fadeInRange.getEnd())
+            gain = AudioFadeCurve::alphaToGainForType (fadeInType, (float) ((time - fadeInRange.getStart()) / fadeInRange.getLength()));
+
+        if (time > fadeOutRange.getStart())
+            gain *= AudioFadeCurve::alphaToGainForType (fadeOutType, (float) ((fadeOutRange.getEnd() - time) / fadeOutRange.getLength()));
+
+        return gain;
+    }
+
+    EditTimeRange effectRange, fadeInRange, fadeOutRange;
+    AudioFadeCurve::Type fadeInType = AudioFadeCurve::linear, fadeOutType = AudioFadeCurve::linear;
+};
+
+bool FadeInOutEffect::canBeAppliedInRealTime() const
+{
+    return getType() == EffectType::fadeInOut;
+}
+
+std::unique_ptr<ClipEffect::RealTimeProcessor> FadeInOutEffect::createRealTimeProcessor()
+{
+    if (! canBeAppliedInRealTime())
+        return {};
+
+    auto speedRatio = clipEffects.getSpeedRatioEstimate();
+    auto effectRange = clipEffects.getEffectsRange();
+
+    auto processor = std::make_unique<FadeInOutProcessor>();
+    processor->effectRange = { effectRange.getStart() * speedRatio,
+                               effectRange.getEnd() * speedRatio };
+    processor->fadeInRange = { processor->effectRange.getStart(), processor->effectRange.getStart() + fadeIn };
+    processor->fadeOutRange = { processor->effectRange.getEnd() - fadeOut, processor->effectRange.getEnd() };
+    processor->fadeInType = fadeInType;
+    processor->fadeOutType = fadeOutType;
+
+    return processor;
+}
+
 ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> FadeInOutEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
 {
     CRASH_TRACER
+
+    if (canBeAppliedInRealTime())
+        return new RealTimeProcessorRenderJob (edit.engine, getDestinationFile(), sourceFile,
+                                               sourceLength, createRealTimeProcessor());
+
     AudioFile destFile (getDestinationFile());
     EditTimeRange timeRange (0.0, sourceLength);
     jassert (! timeRange.isEmpty());
@@ -795,12 +1186,6 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> FadeInOutEffect::crea
 
     switch (getType())
     {
-        case EffectType::fadeInOut:
-            if (fadeIn > 0.0 || fadeOut > 0.0)
-                n = new FadeInOutAudioNode (n, fadeInRange, fadeOutRange, fadeInType, fadeOutType);
-            
-            break;
-            
         case EffectType::tapeStartStop:
             if (fadeIn > 0.0 || fadeOut > 0.0)
             {
@@ -812,6 +1197,7 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> FadeInOutEffect::crea
             
         case EffectType::none:
         case EffectType::volume:
+        case EffectType::fadeInOut:
         case EffectType::stepVolume:
         case EffectType::pitchShift:
         case EffectType::warpTime:
@@ -880,79 +1266,128 @@ int StepVolumeEffect::getMaxNumNotes()
     return (int) std::ceil ((endBeat - startBeat) / noteLength);
 }
 
-ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> StepVolumeEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
+Array<EditTimeRange> StepVolumeEffect::getNonMuteTimes()
 {
     CRASH_TRACER
-    jassert (sourceLength > 0);
-
-    auto destFile = getDestinationFile();
-    EditTimeRange timeRange (0.0, sourceLength);
-
     auto speedRatio = clipEffects.getSpeedRatioEstimate();
     auto effectRange = clipEffects.getEffectsRange();
 
-    auto fade = crossfade.get();
-    auto halfCrossfade = fade / 2.0;
+    auto halfCrossfade = crossfade.get() / 2.0;
     Array<EditTimeRange> nonMuteTimes;
 
-    // Calculate non-mute times
-    {
-        const StepVolumeEffect::Pattern p (*this);
-        auto cache = p.getPattern();
-        auto& ts = edit.tempoSequence;
-        auto& c = getClip();
-        auto pos = c.getPosition();
+    const StepVolumeEffect::Pattern p (*this);
+    auto cache = p.getPattern();
+    auto& ts = edit.tempoSequence;
+    auto& c = getClip();
+    auto pos = c.getPosition();
 
-        auto length = noteLength.get();
-        auto startTime = pos.getStart();
+    auto length = noteLength.get();
+    auto startTime = pos.getStart();
 
-        auto startBeat = ts.timeToBeats (pos.getStart() + effectRange.getStart());
-        auto endBeat = ts.timeToBeats (pos.getEnd());
-        auto numNotes = jmin (p.getNumNotes(), (int) std::ceil ((endBeat - startBeat) / length));
+    auto startBeat = ts.timeToBeats (pos.getStart() + effectRange.getStart());
+    auto endBeat = ts.timeToBeats (pos.getEnd());
+    auto numNotes = jmin (p.getNumNotes(), (int) std::ceil ((endBeat - startBeat) / length));
 
-        auto beat = startBeat;
+    auto beat = startBeat;
 
-        for (int i = 0; i <= numNotes; ++i)
+    for (int i = 0; i <= numNotes; ++i)
+    {
+        if (! cache[i])
         {
-            if (! cache[i])
-            {
-                beat += length;
-                continue;
-            }
-
-            auto s = ts.beatsToTime (beat) - startTime;
             beat += length;
-            auto e = ts.beatsToTime (beat) - startTime;
-
-            nonMuteTimes.add ({ s - halfCrossfade,
-                                e + halfCrossfade });
+            continue;
         }
 
-        // Strip adjacent times
-        auto lastTime = nonMuteTimes.getLast();
+        auto s = ts.beatsToTime (beat) - startTime;
+        beat += length;
+        auto e = ts.beatsToTime (beat) - startTime;
 
-        for (int i = nonMuteTimes.size() - 1; --i >= 0;)
-        {
-            auto& thisTime = nonMuteTimes.getReference (i);
+        nonMuteTimes.add ({ s - halfCrossfade,
+                            e + halfCrossfade });
+    }
 
-            if (thisTime.getEnd() >= lastTime.getStart())
-            {
-                thisTime.end = lastTime.getEnd();
-                nonMuteTimes.remove (i + 1);
-            }
+    // Strip adjacent times
+    auto lastTime = nonMuteTimes.getLast();
 
-            lastTime = thisTime;
+    for (int i = nonMuteTimes.size() - 1; --i >= 0;)
+    {
+        auto& thisTime = nonMuteTimes.getReference (i);
+
+        if (thisTime.getEnd() >= lastTime.getStart())
+        {
+            thisTime.end = lastTime.getEnd();
+            nonMuteTimes.remove (i + 1);
         }
 
-        // Scale everything by the speed ratio
-        for (auto& t : nonMuteTimes)
-            t = t.rescaled (0.0, speedRatio);
+        lastTime = thisTime;
+    }
+
+    // Scale everything by the speed ratio
+    for (auto& t : nonMuteTimes)
+        t = t.rescaled (0.0, speedRatio);
+
+    return nonMuteTimes;
+}
+
+/** Mutes the source outside a set of sorted time ranges, with a crossfade at each end of them. */
+struct StepVolumeProcessor  : public ClipEffect::RealTimeProcessor
+{
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples,
+                  juce::int64 sourceStartSample, double sampleRate) const override
+    {
+        // Find the first range that might contain the block then walk forwards from there
+        auto range = std::lower_bound (nonMuteTimes.begin(), nonMuteTimes.end(), sourceStartSample / sampleRate,
+                                       [] (const EditTimeRange& r, double t) { return r.getEnd() <= t; });
+
+        applyGainAtSourceTimes (buffer, 0, numChannels, startSample, numSamples, sourceStartSample, sampleRate,
+                                [this, &range] (double t)
+                                {
+                                    while (range != nonMuteTimes.end() && t >= range->getEnd())
+                                        ++range;
+
+                                    if (range == nonMuteTimes.end() || t < range->getStart())
+                                        return 0.0f;
+
+                                    return getGainAt (*range, t);
+                                });
     }
 
-    auto waveNode = new WaveAudioNode (sourceFile, timeRange, 0.0, {}, {}, 1.0, AudioChannelSet::stereo());
-    auto compNode = createTrackCompAudioNode (waveNode, TrackCompManager::TrackComp::getMuteTimes (nonMuteTimes), nonMuteTimes, fade);
+    float getGainAt (EditTimeRange range, double time) const noexcept
+    {
+        float gain = 1.0f;
+
+        if (time < range.getStart() + fadeLength)
+            gain = AudioFadeCurve::alphaToGain<AudioFadeCurve::Convex> ((float) ((time - range.getStart()) / fadeLength));
+
+        if (time > range.getEnd() - fadeLength)
+            gain *= AudioFadeCurve::alphaToGain<AudioFadeCurve::Convex> ((float) ((range.getEnd() - time) / fadeLength));
+
+        return gain;
+    }
+
+    std::vector<EditTimeRange> nonMuteTimes;
+    double fadeLength = 0;
+};
 
-    return new AudioNodeRenderJob (edit.engine, compNode, destFile, sourceFile);
+ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> StepVolumeEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
+{
+    CRASH_TRACER
+    jassert (sourceLength > 0);
+
+    return new RealTimeProcessorRenderJob (edit.engine, getDestinationFile(), sourceFile,
+                                           sourceLength, createRealTimeProcessor());
+}
+
+std::unique_ptr<ClipEffect::RealTimeProcessor> StepVolumeEffect::createRealTimeProcessor()
+{
+    auto processor = std::make_unique<StepVolumeProcessor>();
+
+    for (auto& t : getNonMuteTimes())
+        processor->nonMuteTimes.push_back (t);
+
+    processor->fadeLength = crossfade.get();
+
+    return processor;
 }
 
 bool StepVolumeEffect::hasProperties()
@@ -1397,7 +1832,7 @@ struct NormaliseEffect::NormaliseRenderJob : public BlockBasedRenderJob
     NormaliseRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength, double gain)
         : BlockBasedRenderJob (e, dest, src, sourceLength), maxGain (gain) {}
 
-    bool renderNextBlock() override
+    int readNextBlock (juce::AudioBuffer<float>& buffer) override
     {
         CRASH_TRACER
 
@@ -1412,20 +1847,14 @@ struct NormaliseEffect::NormaliseRenderJob : public BlockBasedRenderJob
             gainFactor = dbToGain (float (maxGain)) / maxLevel;
         }
 
-        auto todo = (int) jmin (32768ll, sourceLengthSamples - position);
-
-        AudioScratchBuffer scratch ((int) reader->numChannels, todo);
-
-        reader->read (&scratch.buffer, 0, todo, position, true, true);
-
-        scratch.buffer.applyGain (0, todo, gainFactor);
-
-        writer->appendBuffer (scratch.buffer, todo);
-
-        position += todo;
-        progress = float (position) / float (sourceLengthSamples);
+        return BlockBasedRenderJob::readNextBlock (buffer);
+    }
 
-        return position >= sourceLengthSamples;
+    void processBlock (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples,
+                       juce::int64, double) override
+    {
+        for (int i = 0; i < numChannels; ++i)
+            buffer.applyGain (i, 0, numSamples, gainFactor);
     }
 
     const double maxGain = 1.0;
@@ -1470,77 +1899,31 @@ String NormaliseEffect::getSelectableDescription()
 }
 
 //==============================================================================
-struct MakeMonoEffect::MakeMonoRenderJob : public BlockBasedRenderJob
+struct MakeMonoEffect::MakeMonoProcessor  : public ClipEffect::RealTimeProcessor
 {
-    MakeMonoRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength, SrcChannels srcCh)
-        : BlockBasedRenderJob (e, dest, src, sourceLength), srcChannels (srcCh) {}
-
-    bool setUpRender() override
-    {
-        CRASH_TRACER
-        auto sourceInfo = source.getInfo();
-        jassert (sourceInfo.numChannels > 0 && sourceInfo.sampleRate > 0.0 && sourceInfo.bitsPerSample > 0);
-
-        // need to strip AIFF metadata to write to wav files
-        if (sourceInfo.metadata.getValue ("MetaDataSource", "None") == "AIFF")
-            sourceInfo.metadata.clear();
-
-        reader.reset (AudioFileUtils::createReaderFor (engine, source.getFile()));
-
-        if (reader == nullptr || reader->lengthInSamples == 0)
-            return false;
-
-        sourceLengthSamples = (juce::int64) (sourceLengthSeconds * reader->sampleRate);
-
-        writer.reset (new AudioFileWriter (destination, engine.getAudioFileFormatManager().getWavFormat(),
-                                           1, sourceInfo.sampleRate,
-                                           jmax (16, sourceInfo.bitsPerSample),
-                                           sourceInfo.metadata, 0));
+    MakeMonoProcessor (SrcChannels srcCh) : srcChannels (srcCh) {}
 
-        return writer->isOpen();
-    }
+    int getNumOutputChannels (int) const override           { return 1; }
 
-    bool renderNextBlock() override
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples,
+                  juce::int64, double) const override
     {
-        CRASH_TRACER
-        auto todo = (int) jmin (32768ll, sourceLengthSamples - position);
+        if (numChannels == 1)
+            return;
 
-        AudioScratchBuffer input ((int) reader->numChannels, todo);
-        reader->read (&input.buffer, 0, todo, position, true, true);
-
-        if (reader->numChannels == 1)
+        if (srcChannels == chLR)
+        {
+            buffer.applyGain (0, startSample, numSamples, 0.5f);
+            buffer.addFrom (0, startSample, buffer.getReadPointer (1, startSample), numSamples, 0.5f);
+        }
+        else if (srcChannels == chR)
         {
-            writer->appendBuffer (input.buffer, todo);
+            buffer.copyFrom (0, startSample, buffer.getReadPointer (1, startSample), numSamples);
         }
         else
         {
-            AudioScratchBuffer output (1, todo);
-
-            if (srcChannels == chLR)
-            {
-                output.buffer.copyFrom (0, 0, input.buffer.getReadPointer (0), todo, 0.5f);
-                output.buffer.addFrom (0, 0, input.buffer.getReadPointer (1), todo, 0.5f);
-            }
-            else if (srcChannels == chL)
-            {
-                output.buffer.copyFrom (0, 0, input.buffer.getReadPointer (0), todo);
-            }
-            else if (srcChannels == chR)
-            {
-                output.buffer.copyFrom (0, 0, input.buffer.getReadPointer (1), todo);
-            }
-            else
-            {
-                jassertfalse;
-            }
-
-            writer->appendBuffer (output.buffer, todo);
+            jassert (srcChannels == chL);
         }
-
-        position += todo;
-        progress = float(position) / float(sourceLengthSamples);
-
-        return position >= sourceLengthSamples;
     }
 
     const SrcChannels srcChannels;
@@ -1561,8 +1944,13 @@ MakeMonoEffect::~MakeMonoEffect()
 ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> MakeMonoEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
 {
     CRASH_TRACER
-    return new MakeMonoRenderJob (edit.engine, getDestinationFile(), sourceFile,
-                                  sourceLength, (SrcChannels) channels.get());
+    return new RealTimeProcessorRenderJob (edit.engine, getDestinationFile(), sourceFile,
+                                           sourceLength, createRealTimeProcessor());
+}
+
+std::unique_ptr<ClipEffect::RealTimeProcessor> MakeMonoEffect::createRealTimeProcessor()
+{
+    return std::make_unique<MakeMonoProcessor> ((SrcChannels) channels.get());
 }
 
 bool MakeMonoEffect::hasProperties()
@@ -1586,23 +1974,20 @@ struct ReverseEffect::ReverseRenderJob  : public BlockBasedRenderJob
     ReverseRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength)
         : BlockBasedRenderJob (e, dest, src, sourceLength) {}
 
-    bool renderNextBlock() override
+    int readNextBlock (juce::AudioBuffer<float>& buffer) override
     {
         CRASH_TRACER
-        auto todo = (int) jmin (32768ll, sourceLengthSamples - position);
-
-        AudioScratchBuffer scratch ((int) reader->numChannels, todo);
+        auto todo = (int) jmin ((juce::int64) jmin (blockSize, buffer.getNumSamples()), sourceLengthSamples - position);
 
-        reader->read (&scratch.buffer, 0, todo, sourceLengthSamples - position - todo, true, true);
+        reader->read (&buffer, 0, todo, sourceLengthSamples - position - todo, true, true);
 
-        scratch.buffer.reverse (0, todo);
-
-        writer->appendBuffer (scratch.buffer, todo);
+        for (int i = 0; i < (int) reader->numChannels; ++i)
+            buffer.reverse (i, 0, todo);
 
         position += todo;
-        progress = float(position) / float(sourceLengthSamples);
+        progress = float (position) / float (sourceLengthSamples);
 
-        return position >= sourceLengthSamples;
+        return todo;
     }
 };
 
@@ -1619,28 +2004,13 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> ReverseEffect::create
 }
 
 //==============================================================================
-struct InvertEffect::InvertRenderJob : public BlockBasedRenderJob
+struct InvertEffect::InvertProcessor  : public ClipEffect::RealTimeProcessor
 {
-    InvertRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength)
-        : BlockBasedRenderJob (e, dest, src, sourceLength) {}
-
-    bool renderNextBlock() override
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples,
+                  juce::int64, double) const override
     {
-        CRASH_TRACER
-        auto todo = (int) jmin (32768ll, sourceLengthSamples - position);
-
-        AudioScratchBuffer scratch ((int) reader->numChannels, todo);
-
-        reader->read (&scratch.buffer, 0, todo, position, true, true);
-
-        scratch.buffer.applyGain (0, todo, -1.0f);
-
-        writer->appendBuffer (scratch.buffer, todo);
-
-        position += todo;
-        progress = float (position) / float (sourceLengthSamples);
-
-        return position >= sourceLengthSamples;
+        for (int i = 0; i < numChannels; ++i)
+            buffer.applyGain (i, startSample, numSamples, -1.0f);
     }
 };
 
@@ -1652,7 +2022,13 @@ InvertEffect::InvertEffect (const ValueTree& v, ClipEffects& o)
 ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> InvertEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
 {
     CRASH_TRACER
-    return new InvertRenderJob (edit.engine, getDestinationFile(), sourceFile, sourceLength);
+    return new RealTimeProcessorRenderJob (edit.engine, getDestinationFile(), sourceFile,
+                                           sourceLength, createRealTimeProcessor());
+}
+
+std::unique_ptr<ClipEffect::RealTimeProcessor> InvertEffect::createRealTimeProcessor()
+{
+    return std::make_unique<InvertProcessor>();
 }
 
 //==============================================================================
@@ -1717,14 +2093,20 @@ struct AggregateJob  : public RenderManager::Job
                     return true;
 
                 auto& afm = engine.getAudioFileManager();
-                afm.releaseFile (currentJob->destination);
-               
-                if (! currentJob->destination.isNull())
-                    callBlocking ([&afm, fileToValidate = currentJob->destination]
-                                  {
-                                      afm.validateFile (fileToValidate, true);
-                                      jassert (fileToValidate.isValid());
-                                  });
+                auto filesWritten = currentJob->getIntermediateFiles();
+                filesWritten.add (currentJob->destination);
+
+                for (auto& f : filesWritten)
+                {
+                    afm.releaseFile (f);
+
+                    if (! f.isNull())
+                        callBlocking ([&afm, fileToValidate = f]
+                                      {
+                                          afm.validateFile (fileToValidate, true);
+                                          jassert (fileToValidate.isValid());
+                                      });
+                }
 
                 lastFile = currentJob->destination.getFile();
                 currentJob = nullptr;
@@ -1754,7 +2136,172 @@ struct AggregateJob  : public RenderManager::Job
 };
 
 //==============================================================================
-RenderManager::Job::Ptr ClipEffects::createRenderJob (const AudioFile& destFile, const AudioFile& sourceFile) const
+/** Replaces runs of block-based jobs with FusedRenderJobs. */
+static ReferenceCountedArray<ClipEffect::ClipEffectRenderJob> fuseBlockBasedJobs (const ReferenceCountedArray<ClipEffect::ClipEffectRenderJob>& jobs,
+                                                                                  Engine& engine)
+{
+    ReferenceCountedArray<ClipEffect::ClipEffectRenderJob> fusedJobs;
+
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        auto head = dynamic_cast<BlockBasedRenderJob*> (jobs.getUnchecked (i));
+
+        if (head != nullptr && head->canReadBlocks())
+        {
+            ReferenceCountedArray<BlockBasedRenderJob> jobsToFuse;
+            jobsToFuse.add (head);
+
+            while (auto next = dynamic_cast<BlockBasedRenderJob*> (jobs[i + 1].get()))
+            {
+                if (! next->canProcessBlocksInPlace())
+                    break;
+
+                jobsToFuse.add (next);
+                ++i;
+            }
+
+            if (jobsToFuse.size() > 1)
+            {
+                fusedJobs.add (new FusedRenderJob (engine, std::move (jobsToFuse)));
+                continue;
+            }
+        }
+
+        fusedJobs.add (jobs.getUnchecked (i));
+    }
+
+    return fusedJobs;
+}
+
+int ClipEffects::getNumEffectsToRender() const
+{
+    // Time-stretched proxies are rendered from the effects' output so need all of them
+    if (! realTimeEffectsEnabled || clip.usesTimeStretchedProxy())
+        return objects.size();
+
+    int numToRender = objects.size();
+
+    while (numToRender > 0 && objects.getUnchecked (numToRender - 1)->canBeAppliedInRealTime())
+        --numToRender;
+
+    return numToRender;
+}
+
+std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> ClipEffects::createRealTimeProcessorList()
+{
+    std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> processors;
+
+    for (int i = getNumEffectsToRender(); i < objects.size(); ++i)
+        if (auto processor = objects.getUnchecked (i)->createRealTimeProcessor())
+            processors.push_back (std::move (processor));
+
+    return processors;
+}
+
+std::shared_ptr<ClipEffects::RealTimeProcessors> ClipEffects::createRealTimeProcessors (bool updateWhenEffectsChange)
+{
+    CRASH_TRACER
+
+    if (getNumEffectsToRender() == objects.size())
+        return {};
+
+    auto realTimeProcessors = std::make_shared<RealTimeProcessors>();
+    realTimeProcessors->processors = createRealTimeProcessorList();
+
+    if (updateWhenEffectsChange)
+    {
+        liveRealTimeProcessors.erase (std::remove_if (liveRealTimeProcessors.begin(), liveRealTimeProcessors.end(),
+                                                      [] (auto& p) { return p.expired(); }),
+                                      liveRealTimeProcessors.end());
+        liveRealTimeProcessors.push_back (realTimeProcessors);
+    }
+
+    return realTimeProcessors;
+}
+
+void ClipEffects::updateLiveRealTimeProcessors()
+{
+    CRASH_TRACER
+
+    for (auto& p : liveRealTimeProcessors)
+        if (auto realTimeProcessors = p.lock())
+            realTimeProcessors->setProcessors (createRealTimeProcessorList());
+}
+
+void ClipEffects::setRealTimeEffectsEnabled (bool shouldBeEnabled)
+{
+    if (realTimeEffectsEnabled != shouldBeEnabled)
+    {
+        realTimeEffectsEnabled = shouldBeEnabled;
+        invalidateAllEffects();
+    }
+}
+
+void ClipEffects::RealTimeProcessors::process (juce::AudioBuffer<float>& buffer, int numSourceChannels, int numSamples,
+                                               juce::int64 sourceStartSample, juce::Range<juce::int64> loopRange,
+                                               double sampleRate)
+{
+    jassert (numSourceChannels > 0 && numSourceChannels <= buffer.getNumChannels());
+
+    // If the message thread is replacing the processors, pick them up next block
+    if (pendingLock.try_lock())
+    {
+        if (hasPendingProcessors)
+        {
+            std::swap (processors, pendingProcessors);
+            hasPendingProcessors = false;
+        }
+
+        pendingLock.unlock();
+    }
+
+    int numOutputChannels = numSourceChannels;
+
+    for (int start = 0; start < numSamples;)
+    {
+        auto num = numSamples - start;
+
+        if (! loopRange.isEmpty())
+        {
+            // The start can be several loop lengths past the end, e.g. after a seek
+            if (sourceStartSample >= loopRange.getEnd())
+                sourceStartSample = loopRange.getStart()
+                                      + (sourceStartSample - loopRange.getStart()) % loopRange.getLength();
+
+            num = (int) jmin ((juce::int64) num, loopRange.getEnd() - sourceStartSample);
+        }
+
+        numOutputChannels = numSourceChannels;
+
+        for (auto& p : processors)
+        {
+            p->process (buffer, numOutputChannels, start, num, sourceStartSample, sampleRate);
+            numOutputChannels = jmin (buffer.getNumChannels(), p->getNumOutputChannels (numOutputChannels));
+        }
+
+        start += num;
+        sourceStartSample += num;
+    }
+
+    for (int c = numOutputChannels; c < buffer.getNumChannels(); ++c)
+        buffer.copyFrom (c, 0, buffer, numOutputChannels - 1, 0, numSamples);
+}
+
+void ClipEffects::RealTimeProcessors::setProcessors (std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> newProcessors)
+{
+    // These are either ones the audio thread has swapped out or never used, so can be deleted here
+    std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> oldProcessors;
+
+    {
+        const std::lock_guard<tracktion_graph::RealTimeSpinLock> sl (pendingLock);
+        oldProcessors = std::move (pendingProcessors);
+        pendingProcessors = std::move (newProcessors);
+        hasPendingProcessors = true;
+    }
+}
+
+RenderManager::Job::Ptr ClipEffects::createRenderJob (const AudioFile& destFile, const AudioFile& sourceFile,
+                                                      bool fuseBlockBasedEffects) const
 {
     CRASH_TRACER
     clip.edit.getTransport().forceOrphanFreezeAndProxyFilesPurge();
@@ -1763,21 +2310,35 @@ RenderManager::Job::Ptr ClipEffects::createRenderJob (const AudioFile& destFile,
     AudioFile inputFile (sourceFile);
     ReferenceCountedArray<ClipEffect::ClipEffectRenderJob> jobs;
 
-    for (auto ce : objects)
+    // As each effect's file is named by the hash of all the effects up to it, start
+    // from the longest prefix of the chain that has already been rendered
+    const int numEffectsToRender = getNumEffectsToRender();
+    int firstEffectToRender = 0;
+
+    for (int i = numEffectsToRender; --i >= 0;)
     {
-        const AudioFile af (ce->getDestinationFile());
+        const AudioFile af (objects.getUnchecked (i)->getDestinationFile());
 
         if (af.getFile().existsAsFile() && af.isValid())
         {
             inputFile = af;
+            firstEffectToRender = i + 1;
+            break;
         }
-        else if (ClipEffect::ClipEffectRenderJob::Ptr j = ce->createRenderJob (inputFile, length))
+    }
+
+    for (int i = firstEffectToRender; i < numEffectsToRender; ++i)
+    {
+        if (ClipEffect::ClipEffectRenderJob::Ptr j = objects.getUnchecked (i)->createRenderJob (inputFile, length))
         {
             inputFile = j->destination;
             jobs.add (j);
         }
     }
 
+    if (fuseBlockBasedEffects)
+        jobs = fuseBlockBasedJobs (jobs, clip.edit.engine);
+
     AudioFile firstFile (jobs.isEmpty() ? inputFile : jobs.getFirst()->source);
 
     return new AggregateJob (clip.edit.engine, destFile, firstFile, std::move (jobs));
@@ -58,6 +58,36 @@ public:
     */
     virtual juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) = 0;
 
+    //==============================================================================
+    /** Applies an effect to blocks of its source file during playback. */
+    struct RealTimeProcessor
+    {
+        virtual ~RealTimeProcessor() = default;
+
+        /** Returns the number of channels the output will have for a number of input channels. */
+        virtual int getNumOutputChannels (int numInputChannels) const   { return numInputChannels; }
+
+        /** Applies the effect in-place to the first numChannels of a buffer.
+            sourceStartSample is the position in the source file of startSample. The output must
+            only depend on this position so that it's the same however the file is split into blocks.
+            This is called on the audio thread so mustn't allocate or take any locks.
+        */
+        virtual void process (juce::AudioBuffer<float>&, int numChannels, int startSample, int numSamples,
+                              juce::int64 sourceStartSample, double sampleRate) const = 0;
+    };
+
+    /** Should return true if this effect is cheap enough to be applied during playback
+        rather than being rendered to a file.
+        @see createRealTimeProcessor
+    */
+    virtual bool canBeAppliedInRealTime() const                         { return false; }
+
+    /** Creates a processor that applies the effect with its current settings.
+        This is called on the message thread and the processor is then used on the audio
+        thread, or by the render job so rendered and real-time effects sound the same.
+    */
+    virtual std::unique_ptr<RealTimeProcessor> createRealTimeProcessor()   { return {}; }
+
     /** Return true here to show a properties button in the editor and enable the propertiesButtonPressed callback. */
     virtual bool hasProperties()                                { return false; }
     virtual void propertiesButtonPressed (SelectionManager&)    {}
@@ -139,6 +169,65 @@ public:
         return cachedHash;
     }
 
+    //==============================================================================
+    /** Returns the number of effects at the start of the chain that need rendering to a file.
+        The effects after these are applied by the clip's playback node in real-time.
+        If the clip plays back a time-stretched proxy all the effects need rendering.
+    */
+    int getNumEffectsToRender() const;
+
+    /** Returns the hash of the effects that need rendering, or 0 if there aren't any. */
+    juce::int64 getRenderedEffectsHash() const
+    {
+        if (cachedRenderedHash == hashNeedsRecaching)
+        {
+            auto numToRender = getNumEffectsToRender();
+            cachedRenderedHash = numToRender > 0 ? objects.getUnchecked (numToRender - 1)->getHash() : 0;
+        }
+
+        return cachedRenderedHash;
+    }
+
+    /** The processors for the effects at the end of the chain that are applied in real-time. */
+    struct RealTimeProcessors
+    {
+        /** Applies the processors to a block read from the source file, starting at sourceStartSample.
+            If the loop range isn't empty, the source positions wrap around it in the same way as an
+            AudioFileCache::Reader. Any channels after the first numSourceChannels are assumed to be
+            copies of the source channels so are refilled with the last channel of the output.
+        */
+        void process (juce::AudioBuffer<float>&, int numSourceChannels, int numSamples,
+                      juce::int64 sourceStartSample, juce::Range<juce::int64> loopRange,
+                      double sampleRate);
+
+        /** Replaces the processors from the message thread.
+            The audio thread swaps them in at the start of the next block it processes.
+        */
+        void setProcessors (std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>>);
+
+        std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> processors;
+
+    private:
+        tracktion_graph::RealTimeSpinLock pendingLock;
+        std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> pendingProcessors;
+        bool hasPendingProcessors = false;
+    };
+
+    /** Creates the processors for the effects that aren't rendered, or nullptr if there aren't any.
+        If updateWhenEffectsChange is true, the processors will be replaced when the settings of
+        the real-time effects change so a playback node doesn't need rebuilding. Each node should
+        have its own set of processors as they're updated on the thread that uses them.
+        @see getNumEffectsToRender
+    */
+    std::shared_ptr<RealTimeProcessors> createRealTimeProcessors (bool updateWhenEffectsChange = false);
+
+    /** Enables or disables applying the cheap effects at the end of the chain during playback.
+        If this is disabled, all the effects will be rendered to a file.
+    */
+    void setRealTimeEffectsEnabled (bool);
+    bool areRealTimeEffectsEnabled() const                  { return realTimeEffectsEnabled; }
+
+    //==============================================================================
     /** Returns the start position in the file that the effect should apply to.
         In practice this is the loop start point.
     */
@@ -186,7 +275,14 @@ public:
         listeners.call (&Listener::renderComplete);
     }
 
-    RenderManager::Job::Ptr createRenderJob (const AudioFile& destFile, const AudioFile& sourceFile) const;
+    /** Creates a job to render the effects that can't be applied in real-time, starting from
+        the last effect whose output has already been rendered.
+        If fuseBlockBasedEffects is true, consecutive block-based effects such as invert and
+        make-mono stream their blocks through each other in memory rather than each
+        rendering an intermediate file.
+    */
+    RenderManager::Job::Ptr createRenderJob (const AudioFile& destFile, const AudioFile& sourceFile,
+                                             bool fuseBlockBasedEffects = true) const;
 
     bool isSuitableType (const juce::ValueTree& v) const override
     {
@@ -285,9 +381,17 @@ private:
     juce::ListenerList<Listener> listeners;
     std::unique_ptr<ClipPropertyWatcher> clipPropertyWatcher;
     mutable std::unique_ptr<CachedClipProperties> cachedClipProperties;
-    mutable juce::int64 cachedHash = hashNeedsRecaching;
+    mutable juce::int64 cachedHash = hashNeedsRecaching, cachedRenderedHash = hashNeedsRecaching;
 
     int renderInhibitors = 0;
+    bool realTimeEffectsEnabled = true;
+    int lastNumEffectsToRender = -1;
+    juce::int64 lastRenderedHash = hashNeedsRecaching;
+    std::vector<std::weak_ptr<RealTimeProcessors>> liveRealTimeProcessors;
+
+    std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> createRealTimeProcessorList();
+    void updateLiveRealTimeProcessors();
+    bool effectChangePending = false;
 
     const CachedClipProperties& getCachedClipProperties() const
     {
@@ -300,13 +404,52 @@ private:
     void invalidateAllEffects()
     {
         cachedHash = hashNeedsRecaching;
+        cachedRenderedHash = hashNeedsRecaching;
 
         for (auto ce : objects)
             ce->invalidateDestination();
+
+        const auto numEffectsToRender = getNumEffectsToRender();
+        const auto renderedHash = getRenderedEffectsHash();
+
+        // The clip only needs a new source file if the effects that get rendered have
+        // changed, otherwise the playback nodes just need the new real-time settings
+        if (numEffectsToRender != lastNumEffectsToRender || renderedHash != lastRenderedHash)
+        {
+            lastNumEffectsToRender = numEffectsToRender;
+            lastRenderedHash = renderedHash;
+
+            clip.sourceMediaChanged();
+            clip.edit.restartPlayback();
+        }
+        else
+        {
+            updateLiveRealTimeProcessors();
+        }
     }
 
     void effectChanged()
     {
+        // Changing lots of effect properties in a transaction only needs to do this once
+        if (clip.edit.isInTransaction())
+        {
+            if (! effectChangePending)
+            {
+                effectChangePending = true;
+
+                clip.edit.callWhenTransactionEnds ([ref = juce::WeakReference<ClipEffects> (this)]
+                {
+                    if (auto ce = ref.get())
+                    {
+                        ce->effectChangePending = false;
+                        ce->effectChanged();
+                    }
+                });
+            }
+
+            return;
+        }
+
         clip.cancelCurrentRender();
         startTimer (500);
     }
@@ -346,6 +489,9 @@ struct VolumeEffect : public ClipEffect,
     VolumeEffect (const juce::ValueTree&, ClipEffects&);
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
 
+    bool canBeAppliedInRealTime() const override                        { return true; }
+    std::unique_ptr<RealTimeProcessor> createRealTimeProcessor() override;
+
     void initialise() override 
     {
         if (plugin != nullptr)
@@ -379,6 +525,10 @@ struct FadeInOutEffect  : public ClipEffect
 
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
 
+    /** Fades can be applied in real-time but tape start/stops need rendering. */
+    bool canBeAppliedInRealTime() const override;
+    std::unique_ptr<RealTimeProcessor> createRealTimeProcessor() override;
+
     juce::CachedValue<double> fadeIn, fadeOut;
     juce::CachedValue<AudioFadeCurve::Type> fadeInType, fadeOutType;
 
@@ -401,6 +551,9 @@ struct StepVolumeEffect  : public ClipEffect,
 
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
 
+    bool canBeAppliedInRealTime() const override                        { return true; }
+    std::unique_ptr<RealTimeProcessor> createRealTimeProcessor() override;
+
     bool hasProperties() override;
     void propertiesButtonPressed (SelectionManager&) override;
 
@@ -439,6 +592,10 @@ struct StepVolumeEffect  : public ClipEffect,
 protected:
     juce::int64 getIndividualHash() const override;
 
+private:
+    /** Returns the times in the source file that aren't muted, including the crossfades. */
+    juce::Array<EditTimeRange> getNonMuteTimes();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StepVolumeEffect)
 };
 
@@ -567,6 +724,9 @@ struct MakeMonoEffect : public ClipEffect,
 
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile&, double sourceLength) override;
 
+    bool canBeAppliedInRealTime() const override                        { return true; }
+    std::unique_ptr<RealTimeProcessor> createRealTimeProcessor() override;
+
     bool hasProperties() override;
     void propertiesButtonPressed (SelectionManager&) override;
     juce::String getSelectableDescription() override;
@@ -574,7 +734,7 @@ struct MakeMonoEffect : public ClipEffect,
     juce::CachedValue<int> channels;
 
 private:
-    struct MakeMonoRenderJob;
+    struct MakeMonoProcessor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MakeMonoEffect)
 };
@@ -602,7 +762,10 @@ struct InvertEffect  : public ClipEffect
 
     juce::ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> createRenderJob (const AudioFile&, double sourceLength) override;
 
-    struct InvertRenderJob;
+    bool canBeAppliedInRealTime() const override                        { return true; }
+    std::unique_ptr<RealTimeProcessor> createRealTimeProcessor() override;
+
+    struct InvertProcessor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InvertEffect)
 };
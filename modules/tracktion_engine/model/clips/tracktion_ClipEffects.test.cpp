@@ -0,0 +1,209 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class ClipEffectsTests  : public juce::UnitTest
+{
+public:
+    ClipEffectsTests()
+        : juce::UnitTest ("ClipEffects", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+
+        // Floating point files mean intermediate files don't lose any precision
+        juce::TemporaryFile sourceFile (".wav");
+        writeNoiseFile (sourceFile.getFile(), 44100.0, 2, 3.0);
+
+        beginTest ("Fused block-based effects");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, sourceFile.getFile(),
+                                               { ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::makeMono,
+                                                 ClipEffect::EffectType::invert });
+            auto& effects = *clip->getClipEffects();
+            expectRendersMatch (engine, effects, sourceFile.getFile(), 1);
+
+            // Only the last file and the one before it should have been written
+            expect (! effects[0]->getDestinationFile().getFile().existsAsFile());
+            expect (effects[1]->getDestinationFile().getFile().existsAsFile());
+            expect (effects[2]->getDestinationFile().getFile().existsAsFile());
+
+            cleanUp (engine, *edit);
+        }
+
+        beginTest ("Fusing around non-streamable effects");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, sourceFile.getFile(),
+                                               { ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::normalise,
+                                                 ClipEffect::EffectType::reverse,
+                                                 ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::makeMono });
+            expectRendersMatch (engine, *clip->getClipEffects(), sourceFile.getFile(), 3);
+            cleanUp (engine, *edit);
+        }
+
+        beginTest ("Editing the last effect only renders that effect");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, sourceFile.getFile(),
+                                               { ClipEffect::EffectType::normalise,
+                                                 ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::invert });
+            auto& effects = *clip->getClipEffects();
+            juce::TemporaryFile destFile (".wav");
+            expect (render (*effects.createRenderJob (AudioFile (engine, destFile.getFile()),
+                                                      AudioFile (engine, sourceFile.getFile()))));
+
+            auto lastEffect = effects[2]->state;
+            lastEffect.getParent().removeChild (lastEffect, nullptr);
+            clip->addEffect (ClipEffect::create (ClipEffect::EffectType::makeMono));
+
+            auto job = effects.createRenderJob (AudioFile (engine, destFile.getFile()), AudioFile (engine, sourceFile.getFile()));
+            auto aggregateJob = dynamic_cast<AggregateJob*> (job.get());
+            expect (aggregateJob != nullptr);
+
+            if (aggregateJob != nullptr)
+            {
+                expectEquals (aggregateJob->originalNumTasks, 1);
+                expect (aggregateJob->sourceFile.getFile() == effects[1]->getDestinationFile().getFile());
+                expect (render (*job));
+            }
+
+            cleanUp (engine, *edit);
+        }
+    }
+
+private:
+    static void writeNoiseFile (const juce::File& f, double sampleRate, int numChannels, double durationSeconds)
+    {
+        juce::Random r (1);
+        juce::AudioBuffer<float> buffer (numChannels, (int) (sampleRate * durationSeconds));
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (c, i, r.nextFloat() * 0.5f - 0.25f);
+
+        juce::WavAudioFormat format;
+
+        if (auto out = std::unique_ptr<juce::FileOutputStream> (f.createOutputStream()))
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (format.createWriterFor (out.get(), sampleRate,
+                                                                                                 (unsigned int) numChannels,
+                                                                                                 32, {}, 0)))
+            {
+                out.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+    }
+
+    static juce::ReferenceCountedObjectPtr<WaveAudioClip> createClipWithEffects (Edit& edit, const juce::File& file,
+                                                                                 std::vector<ClipEffect::EffectType> types)
+    {
+        auto track = getAudioTracks (edit)[0];
+        auto clip = track->insertWaveClip ({}, file, ClipPosition { { 0.0, AudioFile (edit.engine, file).getLength() } }, false);
+        clip->enableEffects (true, false);
+
+        // These tests check the rendering so make sure no effects are left to be applied in real-time
+        clip->getClipEffects()->setRealTimeEffectsEnabled (false);
+
+        for (auto type : types)
+            clip->addEffect (ClipEffect::create (type));
+
+        return clip;
+    }
+
+    static bool render (RenderManager::Job& job)
+    {
+        if (! job.setUpRender())
+            return false;
+
+        while (! job.renderNextBlock())
+        {}
+
+        return job.completeRender();
+    }
+
+    static void deleteRenderedFiles (Engine& engine, ClipEffects& effects)
+    {
+        for (auto ce : effects)
+        {
+            engine.getAudioFileManager().releaseFile (ce->getDestinationFile());
+            ce->getDestinationFile().getFile().deleteFile();
+        }
+    }
+
+    static juce::AudioBuffer<float> readFile (const juce::File& f)
+    {
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader (format.createReaderFor (f.createInputStream().release(), true));
+
+        if (reader == nullptr)
+            return {};
+
+        juce::AudioBuffer<float> buffer ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+        return buffer;
+    }
+
+    /** Renders the effects with and without fusing and checks the results are the same. */
+    void expectRendersMatch (Engine& engine, ClipEffects& effects, const juce::File& source, int expectedNumFusedJobs)
+    {
+        juce::TemporaryFile serialFile (".wav"), fusedFile (".wav");
+
+        auto serialJob = effects.createRenderJob (AudioFile (engine, serialFile.getFile()), AudioFile (engine, source), false);
+        expect (render (*serialJob));
+        deleteRenderedFiles (engine, effects);
+
+        auto fusedJob = effects.createRenderJob (AudioFile (engine, fusedFile.getFile()), AudioFile (engine, source), true);
+
+        if (auto aggregateJob = dynamic_cast<AggregateJob*> (fusedJob.get()))
+            expectEquals (aggregateJob->originalNumTasks, expectedNumFusedJobs);
+
+        expect (render (*fusedJob));
+
+        auto serial = readFile (serialFile.getFile());
+        auto fused = readFile (fusedFile.getFile());
+        expectEquals (fused.getNumChannels(), serial.getNumChannels());
+        expectEquals (fused.getNumSamples(), serial.getNumSamples());
+        expect (serial.getNumSamples() > 0);
+
+        for (int c = 0; c < juce::jmin (serial.getNumChannels(), fused.getNumChannels()); ++c)
+        {
+            fused.addFrom (c, 0, serial, c, 0, juce::jmin (serial.getNumSamples(), fused.getNumSamples()), -1.0f);
+            expectEquals (fused.getMagnitude (c, 0, fused.getNumSamples()), 0.0f);
+        }
+    }
+
+    static void cleanUp (Engine& engine, Edit& edit)
+    {
+        engine.getAudioFileManager().releaseAllFiles();
+        edit.getTempDirectory (false).deleteRecursively();
+    }
+};
+
+static ClipEffectsTests clipEffectsTests;
+
+#endif
+
+} // namespace tracktion_engine
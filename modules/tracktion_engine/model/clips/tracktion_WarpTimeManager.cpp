@@ -22,22 +22,6 @@ inline int64 hashDouble (double d) noexcept
 
 int64 WarpMarker::getHash() const noexcept    { return hashDouble (sourceTime) ^ hashDouble (warpTime); }
 
-template <typename FloatingPointType>
-struct Differentiator
-{
-    void process (const FloatingPointType* inputSamples, int numSamples, FloatingPointType* outputSamples)
-    {
-        for (int i = 0; i < numSamples; ++i)
-        {
-            FloatingPointType currentSample = inputSamples[i];
-            outputSamples[i] = currentSample - lastSample;
-            lastSample = currentSample;
-        }
-    }
-
-    FloatingPointType lastSample { (FloatingPointType) 0.0 };
-};
-
 //==============================================================================
 struct TransientDetectionJob  : public RenderManager::Job
 {
@@ -66,158 +50,74 @@ struct TransientDetectionJob  : public RenderManager::Job
     Array<double> getTimes() const                  { return transientTimes; }
 
 protected:
-    bool setUpRender() override                     { return reader != nullptr && totalNumSamples > 0; }
-
-    bool completeRender() override
+    bool setUpRender() override
     {
-        if (transientTimes.size() > 1)
+        auto cached = AudioFileAnalyser (engine).getCachedTransients (file, config.sensitivity);
+
+        if (cached.first)
         {
-            auto trimTransients = [this]() -> bool
-            {
-                const double minTime = 0.1;
-                double lastTime = transientTimes.getLast();
-                const int initialSize = transientTimes.size();
-
-                for (int i = transientTimes.size() - 1; --i >= 0;)
-                {
-                    const double t = transientTimes.getUnchecked (i);
-
-                    if ((lastTime - t) < minTime)
-                        transientTimes.remove (i);
-                    else
-                        lastTime = t;
-                }
-
-                return initialSize != transientTimes.size();
-            };
-
-            for (int i = 10; --i >= 0;)
-                if (! trimTransients())
-                    break;
+            transientTimes = cached.second;
+            return true;
         }
 
-        return true;
+        fileModificationTime = file.getFile().getLastModificationTime();
+        detector = std::make_unique<TransientDetect> (engine, file, config.sensitivity);
+
+        if (detector->start())
+            return true;
+
+        detector = nullptr;
+        return false;
     }
 
     bool renderNextBlock() override
     {
-        CRASH_TRACER
-        const int64 numLeft = totalNumSamples - numSamplesRead;
-        const int numToDo = (int) jmin ((int64) 32768, numLeft);
+        if (detector == nullptr)
+            return true;
 
-        AudioScratchBuffer scratch (numChannels, numToDo);
-        AudioChannelSet schannels = AudioChannelSet::canonicalChannelSet(numChannels);
-        reader->readSamples (numToDo, scratch.buffer, schannels, 0, AudioChannelSet::stereo(), 5000);
+        const bool finished = detector->waitForFinish (50);
+        progress = detector->getProgress();
 
-        if (findingNormaliseLevel)
-            processNextNormaliseBuffer (scratch.buffer);
-        else
-            processNextBuffer (scratch.buffer);
+        return finished;
+    }
 
-        numSamplesRead += numToDo;
-        progress = (numSamplesRead / (float) totalNumSamples)
-            * (findingNormaliseLevel ? 0.5f : 1.0f);
+    bool completeRender() override
+    {
+        if (detector == nullptr)
+            return true;
 
-        if (findingNormaliseLevel && numSamplesRead >= totalNumSamples)
+        // If the job was stopped the detector won't have finished
+        if (! detector->waitForFinish (0))
         {
-            const float peak = jmax (std::abs (fileMinMax.getStart()), std::abs (fileMinMax.getEnd()));
-            normaliseScale = peak > 0.0f ? 1.0f / peak : 1.0f;
-            reader->setReadPosition (0);
-            numSamplesRead = 0;
-            findingNormaliseLevel = false;
+            detector->cancel();
+            return false;
         }
 
-        return ! findingNormaliseLevel && numSamplesRead >= totalNumSamples;
+        // An empty result from a file that couldn't be read would stop it being detected again
+        if (detector->hasFailed())
+            return false;
+
+        transientTimes = detector->getTransientTimes();
+        AudioFileAnalyser (engine).saveTransients (file, config.sensitivity, transientTimes, fileModificationTime);
+
+        return true;
     }
 
 private:
     AudioFile file;
     Config config;
 
-    int64 numSamplesRead = 0, totalNumSamples;
-    int numChannels;
-    double sampleRate = 0;
-    AudioFileCache::Reader::Ptr reader;
-
-    AudioFileUtils::EnvelopeFollower envelopeFollower[3];
-    Differentiator<float> differentiator;
+    std::unique_ptr<TransientDetect> detector;
+    Time fileModificationTime;
     Array<double> transientTimes;
 
-    Range<float> fileMinMax;
-    float normaliseScale = -1.0f;
-    const float thresh = Decibels::decibelsToGain (-25.0f);
-    int triggerTimer = 0;
-    int countDownTimer = 0;
-    bool findingNormaliseLevel = true;
-
     TransientDetectionJob (Engine& e, const AudioFile& af, Config c)
-        : Job (e, AudioFile (e)), file (af), config (c),
-          totalNumSamples (af.getLengthInSamples()),
-          numChannels (af.getNumChannels()),
-          reader (e.getAudioFileManager().cache.createReader (af))
+        : Job (e, AudioFile (e)), file (af), config (c)
     {
         TRACKTION_ASSERT_MESSAGE_THREAD
         // N.B. The argumnet to the Job constructor is the proxy file to use
         // Don't send the audio file here or it will get deleted!
         jassert (proxy.isNull());
-
-        if (reader != nullptr)
-            sampleRate = reader->getSampleRate();
-
-        triggerTimer = int (sampleRate * 50 * 0.001); // 50ms - should be linked to BPM
-        envelopeFollower[0].setCoefficients (1.0, 0.002f);
-        envelopeFollower[1].setCoefficients (1.0, 0.002f);
-        envelopeFollower[2].setCoefficients (1.0, 0.002f);
-    }
-
-    void processNextNormaliseBuffer (const juce::AudioBuffer<float>& buffer)
-    {
-        fileMinMax = fileMinMax.getUnionWith (FloatVectorOperations::findMinAndMax (buffer.getReadPointer (0), buffer.getNumSamples()));
-    }
-
-    void processNextBuffer (const juce::AudioBuffer<float>& buffer)
-    {
-        const int numSamples = buffer.getNumSamples();
-        AudioScratchBuffer scratch (1, numSamples);
-        auto& detectionBuffer = scratch.buffer;
-
-        detectionBuffer.copyFrom (0, 0, buffer, 0, 0, numSamples);
-        detectionBuffer.applyGain (0, 0, numSamples, normaliseScale);
-        float* data = detectionBuffer.getWritePointer (0);
-
-        envelopeFollower[0].processEnvelope (data, data, numSamples);
-        envelopeFollower[1].processEnvelope (data, data, numSamples);
-
-        differentiator.process (data, numSamples, data);
-        envelopeFollower[2].processEnvelope (data, data, numSamples);
-
-        for (int i = 0; i < numSamples; i++)
-        {
-            const float sample = *data++;
-
-            if (countDownTimer)
-                countDownTimer--;
-
-            if (sample > thresh)
-            {
-                if (countDownTimer == 0)
-                {
-                    int rewindIndex = int (i - sampleRate * 0.0005); //rewind by 0.05ms
-
-                    if (rewindIndex < 0)
-                        rewindIndex = 0;
-
-                    transientTimes.add (sampleToSeconds (numSamplesRead + rewindIndex));
-                }
-
-                countDownTimer = triggerTimer;
-            }
-        }
-    }
-
-    double sampleToSeconds (int64 sample) const
-    {
-        return sampleRate > 0.0 ? sample / sampleRate : 0.0;
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransientDetectionJob)
@@ -312,6 +212,45 @@ int WarpTimeManager::insertMarker (WarpMarker marker)
     return index;
 }
 
+bool WarpTimeManager::insertMarkersAtTransients()
+{
+    CRASH_TRACER
+
+    if (! transientTimes.first)
+        return false;
+
+    auto& markersArray = markers->objects;
+
+    if (markersArray.size() < 2)
+        return true;
+
+    const double minDistance = 0.001;
+    const auto sourceStart = markersArray.getFirst()->sourceTime;
+    const auto sourceEnd = markersArray.getLast()->sourceTime;
+
+    // Find all the warp times first so the new markers don't change them
+    Array<WarpMarker> newMarkers;
+
+    for (auto t : transientTimes.second)
+    {
+        if (t <= sourceStart + minDistance || t >= sourceEnd - minDistance)
+            continue;
+
+        auto hasMarkerNearby = std::any_of (markersArray.begin(), markersArray.end(),
+                                            [&] (WarpMarker* m) { return std::abs (m->sourceTime - t) < minDistance; });
+
+        if (! hasMarkerNearby)
+            newMarkers.add (WarpMarker (t, sourceTimeToWarpTime (t)));
+    }
+
+    const Edit::ScopedTransaction transaction (edit);
+
+    for (auto& m : newMarkers)
+        insertMarker (m);
+
+    return true;
+}
+
 void WarpTimeManager::removeMarker (int index)
 {
     if (index == 0 || index == markers->size() - 1)
@@ -564,12 +503,12 @@ UndoManager* WarpTimeManager::getUndoManager() const
     return &edit.getUndoManager();
 }
 
-void WarpTimeManager::jobFinished (RenderManager::Job& job, bool /*completedOk*/)
+void WarpTimeManager::jobFinished (RenderManager::Job& job, bool completedOk)
 {
     if (auto tdj = dynamic_cast<TransientDetectionJob*> (&job))
     {
         transientTimes.second = tdj->getTimes();
-        transientTimes.first = true;
+        transientTimes.first = completedOk;
     }
 
     job.removeListener (this);
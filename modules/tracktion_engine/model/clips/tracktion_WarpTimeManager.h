@@ -129,6 +129,13 @@ public:
     */
     std::pair<bool, juce::Array<double>> getTransientTimes() const    { return transientTimes; }
 
+    /** Adds a WarpMarker at each detected transient between the first and last markers,
+        where there isn't one already, without changing the current warping.
+        Returns false if the transients haven't been detected yet.
+        @see getTransientTimes
+    */
+    bool insertMarkersAtTransients();
+
     /** Converts a warp time (i.e. a linear time) to the time in the source file after warping has been applied. */
     double warpTimeToSourceTime (double warpTime) const;
 
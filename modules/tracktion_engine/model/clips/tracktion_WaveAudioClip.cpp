@@ -93,7 +93,7 @@ File WaveAudioClip::getOriginalFile() const
 bool WaveAudioClip::needsRender() const
 {
     return ! isUsingMelodyne()
-        && (isReversed || warpTime || (clipEffects != nullptr && canHaveEffects()))
+        && (isReversed || warpTime || (clipEffects != nullptr && canHaveEffects() && clipEffects->getNumEffectsToRender() > 0))
         && AudioFile (edit.engine, getOriginalFile()).isValid();
 }
 
@@ -102,7 +102,7 @@ int64 WaveAudioClip::getHash() const
     return AudioFile (edit.engine, getOriginalFile()).getHash()
          ^ (int64) (getWarpTime() ? getWarpTimeManager().getHash() : 0)
          ^ (int64) (getIsReversed() * 768)
-         ^ (int64) ((clipEffects == nullptr || ! canHaveEffects())  ? 0 : clipEffects->getHash());
+         ^ (int64) ((clipEffects == nullptr || ! canHaveEffects())  ? 0 : clipEffects->getRenderedEffectsHash());
 }
 
 void WaveAudioClip::renderComplete()
@@ -77,6 +77,41 @@ struct Edit::EditChangeResetterTimer  : private Timer
     Edit& edit;
 };
 
+//==============================================================================
+struct Edit::PendingTransaction
+{
+    void propertyChanged (const juce::ValueTree& v, const juce::Identifier& i)
+    {
+        // Changes to a tree tend to come together so only the trailing run of changes
+        // to the same tree is checked. This keeps each change constant time.
+        for (auto c = changes.changedProperties.rbegin(); c != changes.changedProperties.rend() && c->first == v; ++c)
+            if (c->second == i)
+                return;
+
+        changes.changedProperties.emplace_back (v, i);
+    }
+
+    void childAdded (const juce::ValueTree& parent, const juce::ValueTree& child)
+    {
+        changes.addedChildren.emplace_back (parent, child);
+    }
+
+    void childRemoved (const juce::ValueTree& parent, const juce::ValueTree& child)
+    {
+        changes.removedChildren.emplace_back (parent, child);
+    }
+
+    void childOrderChanged (const juce::ValueTree& parent)
+    {
+        if (std::find (changes.reorderedParents.begin(), changes.reorderedParents.end(), parent)
+              == changes.reorderedParents.end())
+            changes.reorderedParents.push_back (parent);
+    }
+
+    TransactionChanges changes;
+    std::vector<std::function<void()>> callbacks;
+};
+
 //==============================================================================
 struct Edit::TreeWatcher   : public juce::ValueTree::Listener
 {
@@ -90,6 +125,9 @@ struct Edit::TreeWatcher   : public juce::ValueTree::Listener
 
     void valueTreePropertyChanged (juce::ValueTree& v, const juce::Identifier& i) override
     {
+        if (edit.pendingTransaction != nullptr)
+            edit.pendingTransaction->propertyChanged (v, i);
+
         if (v.hasType (IDs::TRANSPORT))
         {
             if (i == IDs::recordPunchInOut)
@@ -133,7 +171,7 @@ struct Edit::TreeWatcher   : public juce::ValueTree::Listener
                 }
                 else if (i == IDs::mute || i == IDs::solo || i == IDs::soloIsolate)
                 {
-                    edit.updateMuteSoloStatuses();
+                    updateMuteSoloStatuses();
                     edit.markAsChanged();
                 }
             }
@@ -270,11 +308,17 @@ struct Edit::TreeWatcher   : public juce::ValueTree::Listener
 
     void valueTreeChildAdded (juce::ValueTree& p, juce::ValueTree& c) override
     {
+        if (edit.pendingTransaction != nullptr)
+            edit.pendingTransaction->childAdded (p, c);
+
         childAddedOrRemoved (p, c);
     }
 
     void valueTreeChildRemoved (juce::ValueTree& p, juce::ValueTree& c, int) override
     {
+        if (edit.pendingTransaction != nullptr)
+            edit.pendingTransaction->childRemoved (p, c);
+
         childAddedOrRemoved (p, c);
     }
 
@@ -333,7 +377,12 @@ struct Edit::TreeWatcher   : public juce::ValueTree::Listener
         }
     }
 
-    void valueTreeChildOrderChanged (juce::ValueTree&, int, int) override {}
+    void valueTreeChildOrderChanged (juce::ValueTree& p, int, int) override
+    {
+        if (edit.pendingTransaction != nullptr)
+            edit.pendingTransaction->childOrderChanged (p);
+    }
+
     void valueTreeParentChanged (juce::ValueTree&) override {}
 
     void clipMovedOrAdded (const juce::ValueTree& v)
@@ -353,6 +402,23 @@ struct Edit::TreeWatcher   : public juce::ValueTree::Listener
         edit.restartPlayback();
     }
 
+    void updateMuteSoloStatuses()
+    {
+        // Soloing lots of tracks in one go would otherwise update every track for each one
+        if (muteSoloUpdatePending)
+            return;
+
+        muteSoloUpdatePending = true;
+
+        edit.callWhenTransactionEnds ([this]
+        {
+            muteSoloUpdatePending = false;
+            edit.updateMuteSoloStatuses();
+        });
+    }
+
+    bool muteSoloUpdatePending = false;
+
     void updateTrackStatusesAsync()
     {
         if (trackStatusUpdater == nullptr)
@@ -561,6 +627,12 @@ Edit::Edit (Options options)
 
     undoTransactionTimer = std::make_unique<UndoTransactionTimer> (*this);
 
+    if (shouldPlay())
+        changeTracker = std::make_unique<EditChangeTracker> (*this);
+
+    if (shouldPlay() && engine.getEngineBehaviour().getAutoFreezeDelaySeconds() > 0.0)
+        autoFreezer = std::make_unique<AutoFreezer> (*this);
+
     if (loadContext != nullptr && ! loadContext->shouldExit)
     {
         loadContext->completed = true;
@@ -599,6 +671,8 @@ Edit::~Edit()
     engine.getActiveEdits().edits.removeFirstMatchingValue (this);
     masterReference.clear();
     changeResetterTimer.reset();
+    autoFreezer.reset();
+    changeTracker.reset();
 
     if (transportControl != nullptr)
         transportControl->freePlaybackContext();
@@ -608,6 +682,7 @@ Edit::~Edit()
     jassert (juce::MessageManager::getInstance()->currentThreadHasLockedMessageManager());
     jassert (! getTransport().isPlayContextActive());
     jassert (numUndoTransactionInhibitors == 0);
+    jassert (transactionDepth == 0);
 
     cancelAllProxyGeneratorJobs();
     changedPluginsList.reset();
@@ -706,11 +781,13 @@ void Edit::initialise()
     initialiseClickTrack();
     initialiseMetadata();
     initialiseMasterVolume();
+    preloadExternalPlugins();
     initialiseRacks();
     initialiseMasterPlugins();
     initialiseAuxBusses();
     initialiseAudioDevices();
     loadTracks();
+    pluginPreloader.reset();
 
     if (loadContext != nullptr)
         loadContext->progress = 1.0f;
@@ -726,7 +803,10 @@ void Edit::initialise()
         t->cancelAnyPendingUpdates();
 
     initialiseControllerMappings();
-    TemporaryFileManager::purgeOrphanFreezeAndProxyFiles (*this);
+
+    // Edits used for rendering can be partial copies of an Edit that's open so mustn't delete its files
+    if (shouldPlay())
+        TemporaryFileManager::purgeOrphanFreezeAndProxyFiles (*this);
 
     callBlocking ([this]
                   {
@@ -931,6 +1011,15 @@ void Edit::initialiseAudioDevices()
     editInputDevices.reset (new EditInputDevices (*this, inputDeviceState));
 }
 
+void Edit::preloadExternalPlugins()
+{
+    if (! shouldLoadPlugins())
+        return;
+
+    pluginPreloader = std::make_unique<ExternalPluginPreloader> (*this);
+    pluginPreloader->preloadPlugins (state, loadContext);
+}
+
 void Edit::initialiseRacks()
 {
     rackTypes->initialise (state.getOrCreateChildWithName (IDs::RACKS, nullptr));
@@ -1053,10 +1142,80 @@ void Edit::restartPlayback()
 {
     shouldRestartPlayback = true;
 
+    // The graph is rebuilt once when the transaction ends
+    if (isInTransaction())
+        return;
+
     if (! isTimerRunning())
         startTimer (1);
 }
 
+//==============================================================================
+bool Edit::TransactionChanges::isEmpty() const noexcept
+{
+    return changedProperties.empty() && addedChildren.empty()
+            && removedChildren.empty() && reorderedParents.empty();
+}
+
+Edit::ScopedTransaction::ScopedTransaction (Edit& e, const juce::String& undoTransactionName)
+    : edit (e)
+{
+    TRACKTION_ASSERT_MESSAGE_THREAD
+
+    if (edit.transactionDepth++ > 0)
+        return;
+
+    if (undoTransactionName.isNotEmpty())
+        edit.getUndoManager().beginNewTransaction (undoTransactionName);
+
+    ++edit.numUndoTransactionInhibitors;
+    edit.pendingTransaction = std::make_unique<PendingTransaction>();
+}
+
+Edit::ScopedTransaction::~ScopedTransaction()
+{
+    TRACKTION_ASSERT_MESSAGE_THREAD
+    jassert (edit.transactionDepth > 0);
+
+    if (--edit.transactionDepth == 0)
+        edit.endTransaction();
+}
+
+void Edit::endTransaction()
+{
+    --numUndoTransactionInhibitors;
+    auto transaction = std::move (pendingTransaction);
+    jassert (transaction != nullptr);
+
+    // Callbacks can make more changes, which are applied immediately now
+    for (auto& callback : transaction->callbacks)
+        callback();
+
+    if (shouldRestartPlayback)
+        restartPlayback();
+
+    if (! transaction->changes.isEmpty())
+        transactionListeners.call ([&] (TransactionListener& l) { l.transactionEnded (transaction->changes); });
+}
+
+void Edit::callWhenTransactionEnds (std::function<void()> callback)
+{
+    if (pendingTransaction != nullptr)
+        pendingTransaction->callbacks.push_back (std::move (callback));
+    else
+        callback();
+}
+
+void Edit::addTransactionListener (TransactionListener* l)
+{
+    transactionListeners.add (l);
+}
+
+void Edit::removeTransactionListener (TransactionListener* l)
+{
+    transactionListeners.remove (l);
+}
+
 EditPlaybackContext* Edit::getCurrentPlaybackContext() const
 {
     return transportControl->getCurrentPlaybackContext();
@@ -1586,7 +1745,7 @@ void Edit::timerCallback()
     if (! isFullyConstructed.load (std::memory_order_relaxed))
         return;
 
-    if (shouldRestartPlayback && shouldPlay())
+    if (shouldRestartPlayback && shouldPlay() && ! isInTransaction())
     {
         shouldRestartPlayback = false;
         parameterControlMappings->checkForDeletedParams();
@@ -2117,6 +2276,12 @@ void Edit::pluginChanged (Plugin& p) noexcept
 
     changedPluginsList->pluginChanged (p);
     pluginChangeTimer->pluginChanged();
+
+    if (autoFreezer != nullptr)
+        autoFreezer->pluginChanged (p);
+
+    if (changeTracker != nullptr)
+        changeTracker->pluginChanged (p);
 }
 
 //==============================================================================
@@ -83,6 +83,33 @@ public:
         std::atomic<float> progress  { 0.0f };  /**< Progress will be updated as the Edit loads. */
         std::atomic<bool> completed  { false }; /**< Set to true once the Edit has loaded. */
         std::atomic<bool> shouldExit { false }; /**< Can be set to true to cancel loading the Edit. */
+
+        /** Describes how long an external plugin took to load. */
+        struct PluginLoadTime
+        {
+            EditItemID pluginID;                /**< The ID of the plugin's state. */
+            juce::String name;                  /**< The name of the plugin. */
+            double seconds = 0.0;               /**< The time taken to create the instance and restore its state. */
+            bool createdOnMessageThread = true; /**< Whether the plugin had to be created on the message thread. */
+        };
+
+        /** Returns the load times of the plugins that have been created so far. */
+        std::vector<PluginLoadTime> getPluginLoadTimes() const
+        {
+            const juce::ScopedLock sl (pluginLoadTimesLock);
+            return pluginLoadTimes;
+        }
+
+        /** Adds a plugin load time. This can be called from any thread. */
+        void addPluginLoadTime (PluginLoadTime loadTime)
+        {
+            const juce::ScopedLock sl (pluginLoadTimesLock);
+            pluginLoadTimes.push_back (std::move (loadTime));
+        }
+
+    private:
+        juce::CriticalSection pluginLoadTimesLock;
+        std::vector<PluginLoadTime> pluginLoadTimes;
     };
 
     //==============================================================================
@@ -327,6 +354,85 @@ public:
     */
     void restartPlayback();
 
+    //==============================================================================
+    /** The changes made to an Edit's state during a ScopedTransaction. */
+    struct TransactionChanges
+    {
+        /** Returns true if nothing was changed. */
+        bool isEmpty() const noexcept;
+
+        /** The trees which had a property changed and the property, in the order they first changed.
+            Repeated changes to the same property are listed once if no other tree was changed
+            in between, so listeners should be able to cope with the same pair being listed twice.
+        */
+        std::vector<std::pair<juce::ValueTree, juce::Identifier>> changedProperties;
+
+        /** The parents and the children added to or removed from them, in the order they happened.
+            A tree which was added and then removed will be in both lists.
+        */
+        std::vector<std::pair<juce::ValueTree, juce::ValueTree>> addedChildren, removedChildren;
+
+        /** The trees which had their children re-ordered, each listed once. */
+        std::vector<juce::ValueTree> reorderedParents;
+    };
+
+    /**
+        Groups a set of changes to the Edit so the work they trigger is done once when the
+        outermost ScopedTransaction is deleted rather than after every change.
+
+        While one exists:
+        - the audio graph isn't rebuilt; if any change needed it, it's rebuilt once at the end
+        - automation curve change callbacks, clip effect invalidation and track mute/solo
+          updates are made once for each object at the end
+        - the undo manager won't start a new transaction, so all the changes can be undone
+          in one go
+        - the changes are collected and passed to any TransactionListener[s] at the end
+
+        ValueTree listeners are still called synchronously, so code which depends on a
+        model object being updated (e.g. a Clip's position) will see it change as normal.
+        Transactions can be nested, only the outermost one has any effect.
+    */
+    struct ScopedTransaction
+    {
+        /** Starts a transaction.
+            If a name is given, this also starts a new undo transaction with that name,
+            otherwise the changes are added to the current undo transaction.
+        */
+        ScopedTransaction (Edit&, const juce::String& undoTransactionName = {});
+
+        /** Destructor. If this is the outermost transaction, this applies the deferred changes. */
+        ~ScopedTransaction();
+
+    private:
+        Edit& edit;
+        JUCE_DECLARE_NON_COPYABLE (ScopedTransaction)
+    };
+
+    /** Returns true if a ScopedTransaction is active. */
+    bool isInTransaction() const noexcept                       { return transactionDepth > 0; }
+
+    /** Calls a function when the current ScopedTransaction ends, or immediately if there isn't one.
+        Use this to defer expensive updates; the function should check any objects it
+        uses are still alive as they may have been deleted during the transaction.
+    */
+    void callWhenTransactionEnds (std::function<void()>);
+
+    /** Interface for classes that want to be told about the changes made in a ScopedTransaction. */
+    struct TransactionListener
+    {
+        /** Destructor. */
+        virtual ~TransactionListener() = default;
+
+        /** Called once the outermost ScopedTransaction ends, if anything was changed. */
+        virtual void transactionEnded (const TransactionChanges&) = 0;
+    };
+
+    /** Adds a TransactionListener. */
+    void addTransactionListener (TransactionListener*);
+
+    /** Removes a previously added TransactionListener. */
+    void removeTransactionListener (TransactionListener*);
+
     //==============================================================================
     /** Returns the TrackList for the Edit which contains all the top level tracks. */
     TrackList& getTrackList()                                   { return *trackList; }
@@ -492,6 +598,17 @@ public:
     /** Returns the TrackCompManager for the Edit. */
     TrackCompManager& getTrackCompManager() const noexcept      { jassert (trackCompManager != nullptr); return *trackCompManager; }
 
+    /** Returns the AutoFreezer for the Edit.
+        This will be nullptr if EngineBehaviour::getAutoFreezeDelaySeconds() returns 0 or the
+        Edit isn't used for playback.
+    */
+    AutoFreezer* getAutoFreezer() const noexcept                { return autoFreezer.get(); }
+
+    /** Returns the EditChangeTracker for the Edit.
+        This will be nullptr if the Edit isn't used for playback.
+    */
+    EditChangeTracker* getChangeTracker() const noexcept        { return changeTracker.get(); }
+
     //==============================================================================
     /** Returns the name of an aux bus. */
     juce::String getAuxBusName (int bus) const;
@@ -523,6 +640,11 @@ public:
     /** Returns the PluginCache which manages all active Plugin[s] for this Edit. */
     PluginCache& getPluginCache() noexcept;
 
+    /** Returns the ExternalPluginPreloader used whilst the Edit is loading.
+        This will be nullptr once the Edit has finished loading.
+    */
+    ExternalPluginPreloader* getExternalPluginPreloader() const noexcept    { return pluginPreloader.get(); }
+
     /** Returns the time of first clip. */
     double getFirstClipTime() const;
 
@@ -829,7 +951,10 @@ private:
     std::unique_ptr<FrozenTrackCallback> frozenTrackCallback;
     std::unique_ptr<ParameterChangeHandler> parameterChangeHandler;
     std::unique_ptr<PluginCache> pluginCache;
+    std::unique_ptr<ExternalPluginPreloader> pluginPreloader;
     std::unique_ptr<TrackCompManager> trackCompManager;
+    std::unique_ptr<AutoFreezer> autoFreezer;
+    std::unique_ptr<EditChangeTracker> changeTracker;
     juce::Array<ModifierTimer*, juce::CriticalSection> modifierTimers;
     std::unique_ptr<GlobalMacros> globalMacros;
 
@@ -844,6 +969,7 @@ private:
     LoadContext* loadContext = nullptr;
     juce::UndoManager undoManager;
     int numUndoTransactionInhibitors = 0;
+    int transactionDepth = 0;
     mutable juce::File tempDirectory;
     juce::Array<EditItemID> lowLatencyDisabledPlugins;
     double normalLatencyBufferSizeSeconds = 0.0;
@@ -857,6 +983,10 @@ private:
     struct TreeWatcher;
     std::unique_ptr<TreeWatcher> treeWatcher;
 
+    struct PendingTransaction;
+    std::unique_ptr<PendingTransaction> pendingTransaction;
+    juce::ListenerList<TransactionListener> transactionListeners;
+
     std::unique_ptr<TrackList> trackList;
     std::unique_ptr<EditInputDevices> editInputDevices;
 
@@ -881,12 +1011,14 @@ private:
     //==============================================================================
     void initialise();
     void undoOrRedo (bool isUndo);
+    void endTransaction();
 
     //==============================================================================
     void initialiseTempoAndPitch();
     void initialiseTimecode (juce::ValueTree&);
     void initialiseTransport();
     void initialiseMasterVolume();
+    void preloadExternalPlugins();
     void initialiseVideo();
     void initialiseClickTrack();
     void initialiseTracks();
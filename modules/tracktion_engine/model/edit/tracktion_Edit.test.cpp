@@ -0,0 +1,156 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class EditTransactionTests  : public juce::UnitTest
+{
+public:
+    EditTransactionTests()
+        : juce::UnitTest ("Edit Transactions", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+
+        beginTest ("Listeners get one set of changes");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto track = getAudioTracks (*edit)[0];
+            auto clip = track->insertMIDIClip ({ 0.0, 4.0 }, nullptr);
+
+            TransactionRecorder recorder (*edit);
+
+            {
+                const Edit::ScopedTransaction transaction (*edit);
+
+                {
+                    const Edit::ScopedTransaction nestedTransaction (*edit);
+                    expect (edit->isInTransaction());
+                }
+
+                expect (edit->isInTransaction());
+                expect (recorder.changes.empty());
+
+                for (int i = 0; i < 100; ++i)
+                    clip->getSequence().addNote (60, i * 0.25, 0.25, 100, 0, nullptr);
+
+                // The same property set twice is only listed once
+                clip->state.setProperty (IDs::colour, "ff00ff00", nullptr);
+                clip->state.setProperty (IDs::colour, "ff0000ff", nullptr);
+            }
+
+            expect (! edit->isInTransaction());
+            expectEquals ((int) recorder.changes.size(), 1);
+
+            auto& changes = recorder.changes.front();
+            expectEquals ((int) changes.addedChildren.size(), 100);
+            expectEquals ((int) std::count_if (changes.changedProperties.begin(), changes.changedProperties.end(),
+                                               [&] (auto& c) { return c.first == clip->state && c.second == IDs::colour; }), 1);
+
+            {
+                // Nothing is sent if nothing changed
+                const Edit::ScopedTransaction transaction (*edit);
+            }
+
+            expectEquals ((int) recorder.changes.size(), 1);
+        }
+
+        beginTest ("Deferred callbacks are called once at the end");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto track = getAudioTracks (*edit)[0];
+            auto& volParam = *track->getVolumePlugin()->volParam;
+
+            CurveChangeCounter counter (volParam);
+            int numCallbacks = 0;
+
+            edit->callWhenTransactionEnds ([&] { ++numCallbacks; });
+            expectEquals (numCallbacks, 1);
+
+            {
+                const Edit::ScopedTransaction transaction (*edit);
+                edit->callWhenTransactionEnds ([&] { ++numCallbacks; });
+
+                for (int i = 0; i < 50; ++i)
+                    volParam.getCurve().addPoint (i * 0.1, 0.5f, 0.0f);
+
+                expectEquals (numCallbacks, 1);
+                expectEquals (counter.numCurveChanges, 0);
+            }
+
+            expectEquals (numCallbacks, 2);
+            expectEquals (counter.numCurveChanges, 1);
+            expectEquals (volParam.getCurve().getNumPoints(), 50);
+
+            volParam.getCurve().addPoint (10.0, 0.5f, 0.0f);
+            expectEquals (counter.numCurveChanges, 2);
+        }
+
+        beginTest ("Changes in a named transaction are undone together");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto track = getAudioTracks (*edit)[0];
+            auto clip = track->insertMIDIClip ({ 0.0, 4.0 }, nullptr);
+            edit->getUndoManager().clearUndoHistory();
+
+            {
+                const Edit::ScopedTransaction transaction (*edit, "Add notes");
+
+                for (int i = 0; i < 16; ++i)
+                    clip->getSequence().addNote (60 + i, i * 0.25, 0.25, 100, 0, &edit->getUndoManager());
+            }
+
+            expectEquals (clip->getSequence().getNumNotes(), 16);
+            expectEquals (edit->getUndoManager().getUndoDescription(), juce::String ("Add notes"));
+
+            edit->undo();
+            expectEquals (clip->getSequence().getNumNotes(), 0);
+        }
+    }
+
+private:
+    struct TransactionRecorder  : public Edit::TransactionListener
+    {
+        TransactionRecorder (Edit& e) : edit (e)    { edit.addTransactionListener (this); }
+        ~TransactionRecorder() override             { edit.removeTransactionListener (this); }
+
+        void transactionEnded (const Edit::TransactionChanges& c) override
+        {
+            changes.push_back (c);
+        }
+
+        Edit& edit;
+        std::vector<Edit::TransactionChanges> changes;
+    };
+
+    struct CurveChangeCounter  : public AutomatableParameter::Listener
+    {
+        CurveChangeCounter (AutomatableParameter& p) : param (p)    { param.addListener (this); }
+        ~CurveChangeCounter() override                              { param.removeListener (this); }
+
+        void curveHasChanged (AutomatableParameter&) override       { ++numCurveChanges; }
+
+        AutomatableParameter& param;
+        int numCurveChanges = 0;
+    };
+};
+
+static EditTransactionTests editTransactionTests;
+
+#endif
+
+} // namespace tracktion_engine
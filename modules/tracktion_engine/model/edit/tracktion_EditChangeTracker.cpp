@@ -0,0 +1,404 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace
+{
+    // Plenty for an editing session as consecutive changes to the same area are merged
+    constexpr size_t maxNumChanges = 8192;
+}
+
+//==============================================================================
+EditChangeTracker::ScopedIgnore::ScopedIgnore (Edit& e)  : tracker (e.getChangeTracker())
+{
+    if (tracker != nullptr)
+        ++tracker->ignoreCount;
+}
+
+EditChangeTracker::ScopedIgnore::~ScopedIgnore()
+{
+    if (tracker != nullptr)
+        --tracker->ignoreCount;
+}
+
+//==============================================================================
+EditChangeTracker::EditChangeTracker (Edit& e)
+    : edit (e)
+{
+    addClipTimes (edit.state);
+    edit.state.addListener (this);
+}
+
+EditChangeTracker::~EditChangeTracker()
+{
+    edit.state.removeListener (this);
+}
+
+//==============================================================================
+juce::Array<EditTimeRange> EditChangeTracker::getChangesSince (Generation since, const juce::Array<EditItemID>& tracks) const
+{
+    if (since < oldestGeneration)
+        return { Edit::getMaximumEditTimeRange() };
+
+    // Changes to a folder affect all the tracks in it
+    auto trackIDs = tracks;
+
+    for (auto id : tracks)
+        if (auto t = findTrackForID (edit, id))
+            for (auto parent = t->getParentTrack(); parent != nullptr; parent = parent->getParentTrack())
+                trackIDs.addIfNotAlreadyThere (parent->itemID);
+
+    auto firstChange = std::upper_bound (changes.begin(), changes.end(), since,
+                                         [] (Generation g, const Change& c) { return g < c.generation; });
+
+    juce::Array<EditTimeRange> times;
+
+    for (auto c = firstChange; c != changes.end(); ++c)
+        if (tracks.isEmpty() || ! c->trackID.isValid() || trackIDs.contains (c->trackID))
+            times.add (c->time);
+
+    std::sort (times.begin(), times.end(),
+               [] (const EditTimeRange& a, const EditTimeRange& b) { return a.getStart() < b.getStart(); });
+
+    juce::Array<EditTimeRange> merged;
+
+    for (auto& t : times)
+    {
+        if (! merged.isEmpty() && t.getStart() <= merged.getReference (merged.size() - 1).getEnd())
+            merged.getReference (merged.size() - 1) = merged.getLast().getUnionWith (t);
+        else
+            merged.add (t);
+    }
+
+    return merged;
+}
+
+void EditChangeTracker::pluginChanged (Plugin& p)
+{
+    if (dynamic_cast<FreezePointPlugin*> (&p) == nullptr)
+        treeChanged (p.state);
+}
+
+//==============================================================================
+void EditChangeTracker::setRenderedFileGeneration (const juce::File& file, juce::int64 settingsHash, Generation generation)
+{
+    for (auto& r : renderedFiles)
+    {
+        if (r.file == file)
+        {
+            r.settingsHash = settingsHash;
+            r.generation = generation;
+            return;
+        }
+    }
+
+    renderedFiles.push_back ({ file, settingsHash, generation });
+}
+
+bool EditChangeTracker::getRenderedFileGeneration (const juce::File& file, juce::int64 settingsHash, Generation& result) const
+{
+    for (auto& r : renderedFiles)
+    {
+        if (r.file == file)
+        {
+            if (r.settingsHash != settingsHash)
+                return false;
+
+            result = r.generation;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//==============================================================================
+void EditChangeTracker::addChange (EditItemID trackID, EditTimeRange time)
+{
+    if (ignoreCount > 0 || time.isEmpty())
+        return;
+
+    ++currentGeneration;
+
+    // Dragging something around makes lots of small changes so merge these with the last one.
+    // Moving it to the new generation means it's still included in anything that included it before.
+    if (! changes.empty())
+    {
+        auto& last = changes.back();
+
+        if (last.trackID == trackID
+             && time.getStart() <= last.time.getEnd()
+             && last.time.getStart() <= time.getEnd())
+        {
+            last.time = last.time.getUnionWith (time);
+            last.generation = currentGeneration;
+            return;
+        }
+    }
+
+    changes.push_back ({ currentGeneration, trackID, time });
+
+    if (changes.size() > maxNumChanges)
+    {
+        const auto numToRemove = changes.size() / 2;
+        oldestGeneration = changes[numToRemove - 1].generation;
+        changes.erase (changes.begin(), changes.begin() + (std::ptrdiff_t) numToRemove);
+    }
+}
+
+void EditChangeTracker::addAllChanged (EditItemID trackID)
+{
+    addChange (trackID, Edit::getMaximumEditTimeRange());
+}
+
+//==============================================================================
+bool EditChangeTracker::findOwner (const juce::ValueTree& v, EditItemID& trackID, juce::ValueTree& clip) const
+{
+    for (auto t = v; t.isValid(); t = t.getParent())
+    {
+        if (Clip::isClipState (t))
+        {
+            // Keep going so this ends up as the outermost clip, which is the one positioned in the Edit
+            clip = t;
+        }
+        else if (TrackList::isTrack (t))
+        {
+            trackID = EditItemID::fromID (t);
+            return true;
+        }
+        else if (t.hasType (IDs::TEMPOSEQUENCE) || t.hasType (IDs::PITCHSEQUENCE)
+                  || t.hasType (IDs::MASTERPLUGINS) || t.hasType (IDs::MASTERVOLUME)
+                  || t.hasType (IDs::RACKS) || t.hasType (IDs::TRACKCOMPS))
+        {
+            trackID = {};
+            clip = {};
+            return true;
+        }
+    }
+
+    // Anything else, e.g. the transport or view state, doesn't affect the audio
+    return false;
+}
+
+void EditChangeTracker::treeChanged (const juce::ValueTree& v)
+{
+    EditItemID trackID;
+    juce::ValueTree clip;
+
+    if (! findOwner (v, trackID, clip))
+        return;
+
+    if (clip.isValid())
+        addChange (trackID, getClipTime (clip));
+    else
+        addAllChanged (trackID);
+}
+
+void EditChangeTracker::clipMoved (EditItemID trackID, const juce::ValueTree& clip)
+{
+    auto& time = clipTimes[EditItemID::fromID (clip)];
+    addChange (trackID, time);
+
+    time = getClipTime (clip);
+    addChange (trackID, time);
+}
+
+void EditChangeTracker::clipAdded (EditItemID trackID, const juce::ValueTree& clip)
+{
+    addClipTimes (clip);
+    addChange (trackID, getClipTime (clip));
+}
+
+void EditChangeTracker::clipRemoved (EditItemID trackID, const juce::ValueTree& clip)
+{
+    auto found = clipTimes.find (EditItemID::fromID (clip));
+    addChange (trackID, found != clipTimes.end() ? found->second : getClipTime (clip));
+    removeClipTimes (clip);
+}
+
+void EditChangeTracker::addClipTimes (const juce::ValueTree& v)
+{
+    if (Clip::isClipState (v))
+    {
+        // Only the outermost clips are positioned in the Edit
+        clipTimes[EditItemID::fromID (v)] = getClipTime (v);
+        return;
+    }
+
+    for (auto child : v)
+        addClipTimes (child);
+}
+
+void EditChangeTracker::removeClipTimes (const juce::ValueTree& v)
+{
+    if (Clip::isClipState (v))
+    {
+        clipTimes.erase (EditItemID::fromID (v));
+        return;
+    }
+
+    for (auto child : v)
+        removeClipTimes (child);
+}
+
+//==============================================================================
+bool EditChangeTracker::isIgnoredProperty (const juce::Identifier& id)
+{
+    // These only affect the UI or are changed when freezing, which doesn't change the track's audio
+    for (auto& ignored : { IDs::name, IDs::colour, IDs::height, IDs::expanded,
+                           IDs::windowX, IDs::windowY, IDs::windowLocked,
+                           IDs::frozen, IDs::frozenIndividually })
+        if (id == ignored)
+            return true;
+
+    return false;
+}
+
+bool EditChangeTracker::isFreezePoint (const juce::ValueTree& v)
+{
+    return v.hasType (IDs::PLUGIN) && v[IDs::type].toString() == FreezePointPlugin::xmlTypeName;
+}
+
+bool EditChangeTracker::isAutomationPoint (const juce::ValueTree& parent, const juce::ValueTree& child)
+{
+    return parent.hasType (IDs::AUTOMATIONCURVE) && child.hasType (IDs::POINT);
+}
+
+EditTimeRange EditChangeTracker::getClipTime (const juce::ValueTree& clip)
+{
+    const double start = clip[IDs::start];
+    return { start, start + (double) clip[IDs::length] };
+}
+
+EditTimeRange EditChangeTracker::getAutomationTime (const juce::ValueTree& curve, int previousIndex, int nextIndex)
+{
+    // The curve's interpolated between the points either side so that's all that can change
+    const double start = previousIndex >= 0 ? (double) curve.getChild (previousIndex)[IDs::t] : 0.0;
+    const double end = nextIndex < curve.getNumChildren() ? (double) curve.getChild (nextIndex)[IDs::t] : Edit::maximumLength;
+
+    return EditTimeRange::between (start, end);
+}
+
+//==============================================================================
+void EditChangeTracker::valueTreePropertyChanged (juce::ValueTree& v, const juce::Identifier& id)
+{
+    if (isIgnoredProperty (id))
+        return;
+
+    EditItemID trackID;
+    juce::ValueTree clip;
+
+    if (! findOwner (v, trackID, clip))
+        return;
+
+    auto parent = v.getParent();
+
+    if (clip.isValid())
+    {
+        if (clip == v)
+            clipMoved (trackID, clip);
+        else
+            addChange (trackID, getClipTime (clip));
+    }
+    else if (isAutomationPoint (parent, v))
+    {
+        const int index = parent.indexOf (v);
+        addChange (trackID, getAutomationTime (parent, index - 1, index + 1));
+    }
+    else
+    {
+        addAllChanged (trackID);
+    }
+}
+
+void EditChangeTracker::valueTreeChildAdded (juce::ValueTree& parent, juce::ValueTree& child)
+{
+    if (isFreezePoint (child))
+        return;
+
+    EditItemID trackID;
+    juce::ValueTree clip;
+
+    if (! findOwner (child, trackID, clip))
+        return;
+
+    if (TrackList::isTrack (child))
+    {
+        addClipTimes (child);
+        addAllChanged (trackID);
+    }
+    else if (clip == child)
+    {
+        clipAdded (trackID, clip);
+    }
+    else if (clip.isValid())
+    {
+        addChange (trackID, getClipTime (clip));
+    }
+    else if (isAutomationPoint (parent, child))
+    {
+        const int index = parent.indexOf (child);
+        addChange (trackID, getAutomationTime (parent, index - 1, index + 1));
+    }
+    else
+    {
+        addAllChanged (trackID);
+    }
+}
+
+void EditChangeTracker::valueTreeChildRemoved (juce::ValueTree& parent, juce::ValueTree& child, int index)
+{
+    if (TrackList::isTrack (child))
+    {
+        removeClipTimes (child);
+        addAllChanged (EditItemID::fromID (child));
+        return;
+    }
+
+    EditItemID trackID;
+    juce::ValueTree clip;
+
+    // The child's already been removed so this has to start from the parent
+    if (! findOwner (parent, trackID, clip))
+    {
+        removeClipTimes (child);
+        return;
+    }
+
+    if (! clip.isValid() && Clip::isClipState (child))
+    {
+        clipRemoved (trackID, child);
+    }
+    else if (isFreezePoint (child))
+    {
+        return;
+    }
+    else if (clip.isValid())
+    {
+        addChange (trackID, getClipTime (clip));
+    }
+    else if (isAutomationPoint (parent, child))
+    {
+        addChange (trackID, getAutomationTime (parent, index - 1, index));
+    }
+    else
+    {
+        addAllChanged (trackID);
+    }
+}
+
+void EditChangeTracker::valueTreeChildOrderChanged (juce::ValueTree& parent, int, int)
+{
+    treeChanged (parent);
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,140 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Keeps a history of which parts of an Edit have changed, so that a previous render
+    only needs the changed sections rendering again.
+
+    Each change to the Edit's state is recorded as a time range on a track:
+    - Moving, resizing or editing a clip covers the clip's old and new positions.
+    - Adding, removing or moving an automation point covers the span between the
+      points either side of it.
+    - Any other change to a plugin or track covers the whole track, or just the clip
+      if the plugin's on a clip.
+    - Changes to the tempo or pitch sequences, master plugins, racks or comps cover
+      the whole Edit on every track.
+
+    Changes that only affect the UI or the freeze state are ignored. Anything not made
+    to the Edit, e.g. a source file being replaced on disk, isn't tracked.
+
+    This should only be used from the message thread.
+    The Edit creates one of these if it's used for playback.
+    @see Edit::getChangeTracker, IncrementalRenderer
+*/
+class EditChangeTracker   : private juce::ValueTree::Listener
+{
+public:
+    /** Creates a tracker for an Edit. */
+    EditChangeTracker (Edit&);
+
+    /** Destructor. */
+    ~EditChangeTracker() override;
+
+    //==============================================================================
+    /** A position in the history of changes. This goes up with each change. */
+    using Generation = juce::uint64;
+
+    /** Returns the Generation of the most recent change. */
+    Generation getCurrentGeneration() const noexcept        { return currentGeneration; }
+
+    /** Returns the time ranges changed since a Generation that affect any of the given
+        tracks, including changes to the folders they're in. Pass an empty array to include
+        changes to every track.
+        The ranges are sorted and merged. If the history doesn't go back that far, this
+        returns the whole Edit.
+    */
+    juce::Array<EditTimeRange> getChangesSince (Generation, const juce::Array<EditItemID>& tracks) const;
+
+    /** Called by the Edit when a plugin's state has changed. */
+    void pluginChanged (Plugin&);
+
+    //==============================================================================
+    /** Records the Generation a file was rendered from and a hash of the settings it was
+        rendered with. @see IncrementalRenderer
+    */
+    void setRenderedFileGeneration (const juce::File&, juce::int64 settingsHash, Generation);
+
+    /** Looks up the Generation a file was last rendered from, returning false if it hasn't
+        been rendered or was rendered with different settings.
+    */
+    bool getRenderedFileGeneration (const juce::File&, juce::int64 settingsHash, Generation& result) const;
+
+    //==============================================================================
+    /** Stops changes being recorded while in scope.
+        Use this for temporary changes that are reverted before anything else happens,
+        e.g. un-soloing tracks while freezing, or ones that don't change what's rendered,
+        e.g. parameters storing the values their automation has set.
+    */
+    struct ScopedIgnore
+    {
+        ScopedIgnore (Edit&);
+        ~ScopedIgnore();
+
+        EditChangeTracker* tracker;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedIgnore)
+    };
+
+private:
+    //==============================================================================
+    struct Change
+    {
+        Generation generation;
+        EditItemID trackID;     // Invalid for changes to every track
+        EditTimeRange time;
+    };
+
+    struct RenderedFile
+    {
+        juce::File file;
+        juce::int64 settingsHash;
+        Generation generation;
+    };
+
+    Edit& edit;
+    std::vector<Change> changes;
+    Generation currentGeneration = 0, oldestGeneration = 0;
+    std::map<EditItemID, EditTimeRange> clipTimes;
+    std::vector<RenderedFile> renderedFiles;
+    int ignoreCount = 0;
+
+    //==============================================================================
+    void addChange (EditItemID trackID, EditTimeRange);
+    void addAllChanged (EditItemID trackID);
+
+    bool findOwner (const juce::ValueTree&, EditItemID& trackID, juce::ValueTree& clip) const;
+    void treeChanged (const juce::ValueTree&);
+    void clipMoved (EditItemID trackID, const juce::ValueTree& clip);
+    void clipAdded (EditItemID trackID, const juce::ValueTree& clip);
+    void clipRemoved (EditItemID trackID, const juce::ValueTree& clip);
+    void addClipTimes (const juce::ValueTree&);
+    void removeClipTimes (const juce::ValueTree&);
+
+    static bool isIgnoredProperty (const juce::Identifier&);
+    static bool isFreezePoint (const juce::ValueTree&);
+    static bool isAutomationPoint (const juce::ValueTree& parent, const juce::ValueTree& child);
+    static EditTimeRange getClipTime (const juce::ValueTree&);
+    static EditTimeRange getAutomationTime (const juce::ValueTree& curve, int previousIndex, int nextIndex);
+
+    //==============================================================================
+    void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
+    void valueTreeChildAdded (juce::ValueTree&, juce::ValueTree&) override;
+    void valueTreeChildRemoved (juce::ValueTree&, juce::ValueTree&, int) override;
+    void valueTreeChildOrderChanged (juce::ValueTree&, int, int) override;
+    void valueTreeParentChanged (juce::ValueTree&) override {}
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EditChangeTracker)
+};
+
+} // namespace tracktion_engine
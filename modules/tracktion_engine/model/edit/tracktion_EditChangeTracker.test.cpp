@@ -0,0 +1,177 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class EditChangeTrackerTests  : public juce::UnitTest
+{
+public:
+    EditChangeTrackerTests()
+        : juce::UnitTest ("EditChangeTracker", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->ensureNumberOfAudioTracks (2);
+
+        auto tracker = edit->getChangeTracker();
+        expect (tracker != nullptr);
+
+        if (tracker == nullptr)
+            return;
+
+        auto track = getAudioTracks (*edit)[0];
+        auto otherTrack = getAudioTracks (*edit)[1];
+        auto clip = track->insertMIDIClip ({ 80.0, 84.0 }, nullptr);
+
+        beginTest ("Moving a clip");
+        {
+            const auto generation = tracker->getCurrentGeneration();
+            clip->setStart (90.0, false, true);
+
+            expectRanges (tracker->getChangesSince (generation, { track->itemID }), { { 80.0, 84.0 }, { 90.0, 94.0 } });
+        }
+
+        beginTest ("Editing a clip");
+        {
+            const auto generation = tracker->getCurrentGeneration();
+
+            for (int i = 0; i < 10; ++i)
+                clip->getSequence().addNote (60, i * 0.25, 0.25, 100, 0, nullptr);
+
+            expectRanges (tracker->getChangesSince (generation, { track->itemID }), { { 90.0, 94.0 } });
+        }
+
+        beginTest ("Automation");
+        {
+            auto& curve = track->getVolumePlugin()->volParam->getCurve();
+
+            for (auto time : { 0.0, 10.0, 20.0, 30.0 })
+                curve.addPoint (time, 0.5f, 0.0f);
+
+            const auto generation = tracker->getCurrentGeneration();
+            curve.setPointValue (1, 0.25f);
+            expectRanges (tracker->getChangesSince (generation, { track->itemID }), { { 0.0, 20.0 } });
+
+            const auto removeGeneration = tracker->getCurrentGeneration();
+            curve.removePoint (2);
+            expectRanges (tracker->getChangesSince (removeGeneration, { track->itemID }), { { 10.0, 30.0 } });
+        }
+
+       #if JUCE_MODAL_LOOPS_PERMITTED
+        beginTest ("Automation playback isn't a change");
+        {
+            auto volumePlugin = track->getVolumePlugin();
+            auto& param = *volumePlugin->volParam;
+            const auto generation = tracker->getCurrentGeneration();
+
+            for (auto time : { 0.0, 5.0, 10.0, 20.0 })
+            {
+                param.updateToFollowCurve (time);
+
+                // Let the parameter write the value back to the state
+                juce::MessageManager::getInstance()->runDispatchLoopUntil (20);
+            }
+
+            expectWithinAbsoluteError ((float) volumePlugin->state[IDs::volume], param.getCurve().getValueAt (20.0), 0.001f);
+            expectEquals ((juce::int64) tracker->getCurrentGeneration(), (juce::int64) generation);
+        }
+       #endif
+
+        beginTest ("Changes are kept per track");
+        {
+            const auto generation = tracker->getCurrentGeneration();
+            auto otherClip = otherTrack->insertMIDIClip ({ 4.0, 8.0 }, nullptr);
+
+            expect (tracker->getChangesSince (generation, { track->itemID }).isEmpty());
+            expectRanges (tracker->getChangesSince (generation, { otherTrack->itemID }), { { 4.0, 8.0 } });
+
+            otherClip->removeFromParentTrack();
+            expectRanges (tracker->getChangesSince (generation, {}), { { 4.0, 8.0 } });
+
+            // Track plugins affect the whole track
+            const auto pluginGeneration = tracker->getCurrentGeneration();
+            otherTrack->getVolumePlugin()->setVolumeDb (-6.0f);
+            expectRanges (tracker->getChangesSince (pluginGeneration, { otherTrack->itemID }), { Edit::getMaximumEditTimeRange() });
+            expect (tracker->getChangesSince (pluginGeneration, { track->itemID }).isEmpty());
+        }
+
+        beginTest ("Tempo changes affect everything");
+        {
+            const auto generation = tracker->getCurrentGeneration();
+            edit->tempoSequence.getTempo (0)->setBpm (130.0);
+
+            expectRanges (tracker->getChangesSince (generation, { track->itemID }), { Edit::getMaximumEditTimeRange() });
+            expectRanges (tracker->getChangesSince (generation, { otherTrack->itemID }), { Edit::getMaximumEditTimeRange() });
+        }
+
+        beginTest ("Ignored changes");
+        {
+            const auto generation = tracker->getCurrentGeneration();
+            track->setName ("Renamed");
+            clip->state.setProperty (IDs::colour, "ff00ff00", nullptr);
+
+            {
+                const EditChangeTracker::ScopedIgnore ignore (*edit);
+                clip->setStart (100.0, false, true);
+            }
+
+            expectEquals ((juce::int64) tracker->getCurrentGeneration(), (juce::int64) generation);
+
+            // The ignored move is still known about so moving it again covers the right place
+            clip->setStart (110.0, false, true);
+            expectRanges (tracker->getChangesSince (generation, { track->itemID }), { { 100.0, 104.0 }, { 110.0, 114.0 } });
+        }
+
+        beginTest ("Rendered files");
+        {
+            const juce::File file ("/render.wav");
+            EditChangeTracker::Generation generation = 0;
+            expect (! tracker->getRenderedFileGeneration (file, 123, generation));
+
+            tracker->setRenderedFileGeneration (file, 123, 42);
+            expect (tracker->getRenderedFileGeneration (file, 123, generation));
+            expectEquals ((juce::int64) generation, (juce::int64) 42);
+            expect (! tracker->getRenderedFileGeneration (file, 456, generation));
+        }
+    }
+
+private:
+    void expectRanges (const juce::Array<EditTimeRange>& actual, std::initializer_list<EditTimeRange> expected)
+    {
+        expectEquals (actual.size(), (int) expected.size());
+
+        int i = 0;
+
+        for (auto& e : expected)
+        {
+            if (i < actual.size())
+            {
+                expectWithinAbsoluteError (actual[i].getStart(), e.getStart(), 1.0e-9);
+                expectWithinAbsoluteError (actual[i].getEnd(), e.getEnd(), 1.0e-9);
+            }
+
+            ++i;
+        }
+    }
+};
+
+static EditChangeTrackerTests editChangeTrackerTests;
+
+#endif
+
+} // namespace tracktion_engine
@@ -1178,6 +1178,8 @@ void EditTimecodeRemapperSnapshot::savePreChangeState (Edit& ed)
 
 void EditTimecodeRemapperSnapshot::remapEdit (Edit& ed)
 {
+    const Edit::ScopedTransaction transaction (ed);
+
     auto& transport = ed.getTransport();
     auto& tempoSequence = ed.tempoSequence;
     tempoSequence.updateTempoData();
@@ -24,6 +24,16 @@ static bool isWorthConvertingToOgg (AudioFile& source, int quality)
     return true;
 }
 
+static int askWhetherToOverwrite (Engine& engine, const File& destFile)
+{
+    return engine.getUIBehaviour()
+             .showYesNoCancelAlertBox (TRANS("Unpacking archive"),
+                                       TRANS("The file XZZX already exists - do you want to overwrite it?")
+                                         .replace ("XZZX", destFile.getFullPathName()),
+                                       TRANS("Overwrite"),
+                                       TRANS("Leave existing"));
+}
+
 //==============================================================================
 TracktionArchiveFile::IndexEntry::IndexEntry (InputStream& in)
 {
@@ -186,12 +196,7 @@ bool TracktionArchiveFile::extractFile (int index, const File& destDirectory, Fi
 
     if (askBeforeOverwriting && destFile.existsAsFile())
     {
-        auto r = engine.getUIBehaviour()
-                    .showYesNoCancelAlertBox (TRANS("Unpacking archive"),
-                                              TRANS("The file XZZX already exists - do you want to overwrite it?")
-                                                .replace ("XZZX", destFile.getFullPathName()),
-                                              TRANS("Overwrite"),
-                                              TRANS("Leave existing"));
+        auto r = askWhetherToOverwrite (engine, destFile);
 
         if (r == 1)  return true;
         if (r == 0)  return false;
@@ -238,20 +243,98 @@ bool TracktionArchiveFile::extractFile (int index, const File& destDirectory, Fi
 
 bool TracktionArchiveFile::extractAll (const File& destDirectory, Array<File>& filesCreated)
 {
+    return extractAll (destDirectory, filesCreated, false, {});
+}
+
+bool TracktionArchiveFile::extractAll (const File& destDirectory, Array<File>& filesCreated,
+                                       bool askBeforeOverwriting, std::function<bool (float)> progressCallback,
+                                       int numThreads)
+{
+    CRASH_TRACER
+
     if (! destDirectory.createDirectory())
         return false;
 
-    for (int i = 0; i < entries.size(); ++i)
+    enum class Status { pending, skipped, extracted, failed };
+
+    const int numFiles = entries.size();
+    std::vector<Status> status ((size_t) numFiles, Status::pending);
+    std::map<String, int> lastIndexForName;
+    Array<File> destFiles;
+
+    for (int i = 0; i < numFiles; ++i)
     {
-        File fileCreated;
+        auto destFile = destDirectory.getChildFile (getOriginalFileName (i));
+        destFiles.add (destFile);
 
-        if (! extractFile (i, destDirectory, fileCreated, false))
-            return false;
+        // Only the last of any entries with the same name needs extracting as it would overwrite the others
+        auto existing = lastIndexForName.find (destFile.getFullPathName());
+
+        if (existing != lastIndexForName.end())
+        {
+            status[(size_t) existing->second] = Status::skipped;
+            existing->second = i;
+            continue;
+        }
+
+        lastIndexForName[destFile.getFullPathName()] = i;
 
-        filesCreated.add (fileCreated);
+        // The questions have to be asked up-front as the files are extracted concurrently
+        if (askBeforeOverwriting && destFile.existsAsFile())
+        {
+            auto r = askWhetherToOverwrite (engine, destFile);
+
+            if (r == 1)  status[(size_t) i] = Status::skipped;
+            if (r == 0)  return false;
+        }
     }
 
-    return true;
+    std::atomic<int> numFinished { 0 };
+    WaitableEvent jobFinished;
+    int numJobs = 0;
+
+    {
+        ThreadPool pool (getNumThreadsToUse (numThreads));
+
+        for (int i = 0; i < numFiles; ++i)
+        {
+            if (status[(size_t) i] != Status::pending)
+                continue;
+
+            ++numJobs;
+            pool.addJob ([this, i, &destDirectory, &status, &numFinished, &jobFinished]
+                         {
+                             File fileCreated;
+                             status[(size_t) i] = extractFile (i, destDirectory, fileCreated, false) ? Status::extracted
+                                                                                                      : Status::failed;
+                             ++numFinished;
+                             jobFinished.signal();
+                         });
+        }
+
+        while (numFinished < numJobs)
+        {
+            if (progressCallback != nullptr && ! progressCallback (numFinished / (float) numJobs))
+            {
+                pool.removeAllJobs (true, -1);
+                break;
+            }
+
+            jobFinished.wait (50);
+        }
+    }
+
+    bool ok = numFinished == numJobs;
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        if (status[(size_t) i] == Status::pending || status[(size_t) i] == Status::failed)
+            ok = false;
+        else
+            filesCreated.add (destFiles[i]);
+    }
+
+    return ok;
 }
 
 //==============================================================================
@@ -276,30 +359,16 @@ public:
         CRASH_TRACER
         FloatVectorOperations::disableDenormalisedNumberSupport();
 
-        if (! destDir.createDirectory())
-            return jobHasFinished;
-
-        for (int i = 0; i < archive.getNumFiles(); ++i)
+        if (! archive.extractAll (destDir, filesCreated, warnAboutOverwrite,
+                                  [this] (float p) { progress = p; return ! shouldExit(); }))
         {
-            if (shouldExit())
-            {
-                wasAborted = true;
-
-                for (auto& f : filesCreated)
-                    f.deleteFile();
-
-                break;
-            }
-
-            progress = i / (float) archive.getNumFiles();
-
-            File fileCreated;
-
-            if (! archive.extractFile (i, destDir, fileCreated, warnAboutOverwrite))
+            if (! shouldExit())
                 return jobHasFinished;
 
-            if (fileCreated.exists())
-                filesCreated.add (fileCreated);
+            wasAborted = true;
+
+            for (auto& f : filesCreated)
+                f.deleteFile();
         }
 
         ok = true;
@@ -331,178 +400,294 @@ bool TracktionArchiveFile::extractAllAsTask (const File& destDirectory, bool war
     return task.ok;
 }
 
-bool TracktionArchiveFile::addFile (const File& f, const File& rootDirectory, CompressionType compression)
+String TracktionArchiveFile::getArchivedFileName (const File& f, const File& rootDirectory)
 {
-    String name;
-
     if (f.isAChildOf (rootDirectory))
-        name = f.getRelativePathFrom (rootDirectory)
+        return f.getRelativePathFrom (rootDirectory)
                 .replaceCharacter ('\\', '/');
-    else
-        name = f.getFileName();
 
-    return addFile (f, name, compression);
+    return f.getFileName();
 }
 
-bool TracktionArchiveFile::addFile (const File& f, const String& filenameToUse, CompressionType compression)
+bool TracktionArchiveFile::addFile (const File& f, const File& rootDirectory, CompressionType compression)
 {
-    // don't risk using ogg or flac on small audio files
-    if (compression != CompressionType::none && f.getSize() <= 16 * 1024)
-        compression = CompressionType::zip;
+    return addFile (f, getArchivedFileName (f, rootDirectory), compression);
+}
 
+bool TracktionArchiveFile::addFile (const File& f, const String& filenameToUse, CompressionType compression)
+{
     FileInputStream in (f);
-    bool ok = false;
 
-    if (in.openedOk())
+    if (! in.openedOk())
+        return false;
+
+    std::unique_ptr<IndexEntry> entry (new IndexEntry());
+    entry->originalName = filenameToUse;
+    entry->storedName = filenameToUse;
+
+    return appendEntry (std::move (entry), f.getFileName(),
+                        [&] (OutputStream& out, IndexEntry& e)
+                        {
+                            return writeCompressedFile (engine, f, in, compression, out, e);
+                        });
+}
+
+bool TracktionArchiveFile::addFiles (const Array<FileToAdd>& files, StringArray& failedFiles,
+                                     std::function<bool (float)> progressCallback, int numThreads)
+{
+    CRASH_TRACER
+
+    struct EncodedFile
     {
-        FileOutputStream out (file);
+        EncodedFile (const File& archiveFile)  : tempFile (archiveFile) {}
+
+        TemporaryFile tempFile;
+        std::unique_ptr<IndexEntry> entry { new IndexEntry() };
+        std::atomic<bool> finished { false };
+        bool ok = false;
+    };
+
+    const int numFiles = files.size();
+    const int numThreadsToUse = getNumThreadsToUse (numThreads);
+    const int maxNumInFlight = numThreadsToUse * 2; // Limits the amount of temporary disk space used
+    OwnedArray<EncodedFile> encodedFiles;
+    WaitableEvent jobFinished;
+    ThreadPool pool (numThreadsToUse);
+    bool ok = true;
+
+    auto startJob = [&] (int index)
+    {
+        auto& fileToAdd = files.getReference (index);
+        auto encoded = encodedFiles.add (new EncodedFile (file));
+        encoded->entry->originalName = fileToAdd.filenameToUse;
+        encoded->entry->storedName = fileToAdd.filenameToUse;
+
+        pool.addJob ([this, &fileToAdd, encoded, &jobFinished]
+                     {
+                         FileInputStream in (fileToAdd.file);
+
+                         if (in.openedOk())
+                         {
+                             FileOutputStream out (encoded->tempFile.getFile());
+
+                             if (out.openedOk())
+                             {
+                                 encoded->ok = writeCompressedFile (engine, fileToAdd.file, in, fileToAdd.compression, out, *encoded->entry);
+                                 out.flush();
+                                 encoded->ok = encoded->ok && out.getStatus().wasOk();
+                             }
+                         }
+
+                         encoded->finished = true;
+                         jobFinished.signal();
+                     });
+    };
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        while (encodedFiles.size() < numFiles && encodedFiles.size() < i + maxNumInFlight)
+            startJob (encodedFiles.size());
 
-        if (out.openedOk())
+        // Entries are appended in order whilst the following ones are still being encoded
+        auto& encoded = *encodedFiles.getUnchecked (i);
+        const auto& fileToAdd = files.getReference (i);
+
+        while (! encoded.finished)
         {
-            if (! valid)
+            if (progressCallback != nullptr && ! progressCallback (i / (float) numFiles))
             {
-                out.setPosition (0);
-                out.writeInt (getMagicNumber());
-                out.writeInt (int (indexOffset));
-                valid = true;
+                pool.removeAllJobs (true, -1);
+                return false;
             }
 
-            auto initialPosition = out.getPosition();
+            jobFinished.wait (50);
+        }
 
-            out.setPosition (indexOffset);
-            jassert (indexOffset < 2147483648);
+        bool added = false;
 
-            if (indexOffset >= 2147483648)
-            {
-                TRACKTION_LOG_ERROR ("Archive too large when archiving file: " + f.getFileName());
-                return false;
-            }
+        if (encoded.ok)
+        {
+            FileInputStream in (encoded.tempFile.getFile());
+
+            if (in.openedOk())
+                added = appendEntry (std::move (encoded.entry), fileToAdd.file.getFileName(),
+                                     [&in] (OutputStream& out, IndexEntry&)
+                                     {
+                                         return out.writeFromInputStream (in, -1) == in.getTotalLength();
+                                     });
+        }
 
-            auto filenameRoot = filenameToUse.substring (0, filenameToUse.lastIndexOfChar ('.'));
+        if (! added)
+        {
+            failedFiles.add (fileToAdd.file.getFileName());
+            ok = false;
+        }
 
-            std::unique_ptr<IndexEntry> entry (new IndexEntry());
-            entry->offset = indexOffset;
-            entry->length = 0;
-            entry->originalName = filenameToUse;
-            entry->storedName = filenameToUse;
+        // Deletes the temporary file
+        encodedFiles.set (i, nullptr);
+    }
 
-            switch (compression)
-            {
-                case CompressionType::none:
-                {
-                    out.writeFromInputStream (in, -1);
-                    break;
-                }
+    return ok;
+}
 
-                case CompressionType::zip:
-                {
-                    entry->storedName = filenameRoot + ".gz";
+bool TracktionArchiveFile::appendEntry (std::unique_ptr<IndexEntry> entry, const String& filenameForErrors,
+                                        const std::function<bool (OutputStream&, IndexEntry&)>& writeData)
+{
+    FileOutputStream out (file);
 
-                    GZIPCompressorOutputStream deflater (&out, 9, false);
-                    deflater.writeFromInputStream (in, -1);
-                    break;
-                }
+    if (! out.openedOk())
+        return false;
 
-                case CompressionType::lossless:
-                {
-                    AudioFile af (engine, f);
+    if (! valid)
+    {
+        out.setPosition (0);
+        out.writeInt (getMagicNumber());
+        out.writeInt (int (indexOffset));
+        valid = true;
+    }
 
-                    if (af.isOggFile() || af.isMp3File() || af.isFlacFile())
-                    {
-                        out.writeFromInputStream (in, -1); // no point re-compressing these
-                    }
-                    else
-                    {
-                        if (af.getBitsPerSample() > 24)
-                        {
-                            // FLAC can't do higher than 24 bits so just have to zip it instead..
-                            entry->storedName = filenameRoot + ".gz";
+    auto initialPosition = out.getPosition();
 
-                            GZIPCompressorOutputStream deflater (&out, 9, false);
-                            deflater.writeFromInputStream (in, -1);
-                        }
-                        else
-                        {
-                            entry->storedName = filenameRoot + ".flac";
-
-                            if (! AudioFileUtils::convertToFormat<FlacAudioFormat> (engine, f, out, 0, StringPairArray()))
-                            {
-                                needToWriteIndex = true;
-                                TRACKTION_LOG_ERROR ("Failed to add file to archive flac: " + f.getFileName());
-                                return false;
-                            }
-                        }
-                    }
+    out.setPosition (indexOffset);
+    jassert (indexOffset < 2147483648);
 
-                    break;
-                }
+    if (indexOffset >= 2147483648)
+    {
+        TRACKTION_LOG_ERROR ("Archive too large when archiving file: " + filenameForErrors);
+        return false;
+    }
 
-                case CompressionType::lossyGoodQuality:
-                case CompressionType::lossyMediumQuality:
-                case CompressionType::lossyLowQuality:
-                {
-                    entry->storedName = filenameRoot + ".ogg";
-                    entry->originalName = entry->storedName;  // oggs get extracted as oggs, not named back to how they were
+    entry->offset = indexOffset;
+    entry->length = 0;
 
-                    auto quality = getOggQuality (compression);
-                    AudioFile af (engine, f);
+    if (! writeData (out, *entry))
+    {
+        needToWriteIndex = true;
+        return false;
+    }
 
-                    if (! isWorthConvertingToOgg (af, quality))
-                    {
-                        FileInputStream fin (af.getFile());
+    out.flush();
 
-                        if (! fin.openedOk())
-                        {
-                            needToWriteIndex = true;
-                            TRACKTION_LOG_ERROR ("Failed to add file to archive: " + f.getFileName());
-                            return false;
-                        }
+    jassert (out.getPosition() > indexOffset);
 
-                        out.writeFromInputStream (fin, -1);
-                    }
-                    else if (! AudioFileUtils::convertToFormat<OggVorbisAudioFormat> (engine, f, out, quality, StringPairArray()))
-                    {
-                        needToWriteIndex = true;
-                        TRACKTION_LOG_ERROR ("Failed to add file to archive ogg: " + f.getFileName());
-                        return false;
-                    }
+    entry->length = jmax (int64 (0), out.getPosition() - indexOffset);
 
-                    break;
-                }
+    jassert (indexOffset + entry->length < 2147483648);
+
+    if (indexOffset + entry->length >= 2147483648)
+    {
+        out.setPosition (initialPosition);
+        out.truncate();
+        TRACKTION_LOG_ERROR ("Archive too large when archiving file: " + filenameForErrors);
+        return false;
+    }
+
+    indexOffset += entry->length;
+    needToWriteIndex = true;
+
+    entries.add (entry.release());
+    return true;
+}
 
-                default:
+bool TracktionArchiveFile::writeCompressedFile (Engine& engine, const File& f, InputStream& in, CompressionType compression,
+                                                OutputStream& out, IndexEntry& entry)
+{
+    // don't risk using ogg or flac on small audio files
+    if (compression != CompressionType::none && f.getSize() <= 16 * 1024)
+        compression = CompressionType::zip;
+
+    auto filenameRoot = entry.originalName.substring (0, entry.originalName.lastIndexOfChar ('.'));
+
+    switch (compression)
+    {
+        case CompressionType::none:
+        {
+            out.writeFromInputStream (in, -1);
+            break;
+        }
+
+        case CompressionType::zip:
+        {
+            entry.storedName = filenameRoot + ".gz";
+
+            GZIPCompressorOutputStream deflater (&out, 9, false);
+            deflater.writeFromInputStream (in, -1);
+            break;
+        }
+
+        case CompressionType::lossless:
+        {
+            AudioFile af (engine, f);
+
+            if (af.isOggFile() || af.isMp3File() || af.isFlacFile())
+            {
+                out.writeFromInputStream (in, -1); // no point re-compressing these
+            }
+            else
+            {
+                if (af.getBitsPerSample() > 24)
                 {
-                    TRACKTION_LOG_ERROR ("Unknown compression type when archiving file: " + f.getFileName());
-                    jassertfalse;
-                    break;
+                    // FLAC can't do higher than 24 bits so just have to zip it instead..
+                    entry.storedName = filenameRoot + ".gz";
+
+                    GZIPCompressorOutputStream deflater (&out, 9, false);
+                    deflater.writeFromInputStream (in, -1);
+                }
+                else
+                {
+                    entry.storedName = filenameRoot + ".flac";
+
+                    if (! AudioFileUtils::convertToFormat<FlacAudioFormat> (engine, f, out, 0, StringPairArray()))
+                    {
+                        TRACKTION_LOG_ERROR ("Failed to add file to archive flac: " + f.getFileName());
+                        return false;
+                    }
                 }
             }
 
-            out.flush();
+            break;
+        }
 
-            jassert (out.getPosition() > indexOffset);
+        case CompressionType::lossyGoodQuality:
+        case CompressionType::lossyMediumQuality:
+        case CompressionType::lossyLowQuality:
+        {
+            entry.storedName = filenameRoot + ".ogg";
+            entry.originalName = entry.storedName;  // oggs get extracted as oggs, not named back to how they were
 
-            entry->length = jmax (int64 (0), out.getPosition() - indexOffset);
+            auto quality = getOggQuality (compression);
+            AudioFile af (engine, f);
 
-            jassert (indexOffset + entry->length < 2147483648);
+            if (! isWorthConvertingToOgg (af, quality))
+            {
+                FileInputStream fin (af.getFile());
 
-            if (indexOffset + entry->length >= 2147483648)
+                if (! fin.openedOk())
+                {
+                    TRACKTION_LOG_ERROR ("Failed to add file to archive: " + f.getFileName());
+                    return false;
+                }
+
+                out.writeFromInputStream (fin, -1);
+            }
+            else if (! AudioFileUtils::convertToFormat<OggVorbisAudioFormat> (engine, f, out, quality, StringPairArray()))
             {
-                out.setPosition (initialPosition);
-                out.truncate();
-                TRACKTION_LOG_ERROR ("Archive too large when archiving file: " + f.getFileName());
+                TRACKTION_LOG_ERROR ("Failed to add file to archive ogg: " + f.getFileName());
                 return false;
             }
 
-            indexOffset += entry->length;
-            needToWriteIndex = true;
-            ok = true;
+            break;
+        }
 
-            entries.add (entry.release());
+        default:
+        {
+            TRACKTION_LOG_ERROR ("Unknown compression type when archiving file: " + f.getFileName());
+            jassertfalse;
+            break;
         }
     }
 
-    return ok;
+    return true;
 }
 
 void TracktionArchiveFile::addFileInfo (const String& filename, const String& itemName, const String& itemValue)
@@ -517,6 +702,11 @@ void TracktionArchiveFile::addFileInfo (const String& filename, const String& it
     }
 }
 
+int TracktionArchiveFile::getNumThreadsToUse (int numThreads)
+{
+    return numThreads > 0 ? numThreads : jmax (1, SystemStats::getNumCpus());
+}
+
 int TracktionArchiveFile::getOggQuality (CompressionType c)
 {
     auto numOptions = OggVorbisAudioFormat().getQualityOptions().size();
@@ -50,9 +50,46 @@ public:
                            juce::Array<juce::File>& filesCreated,
                            bool& wasAborted);
 
+    /** Extracts all the files, decoding them concurrently on a pool of worker threads.
+        Each entry is read through its own stream starting at its offset in the archive.
+        If askBeforeOverwriting is true, the user is asked about any existing files before
+        the extraction starts. The progress callback is called on this thread and should
+        return false to abort the extraction.
+        If numThreads is 0, one thread per CPU will be used.
+    */
+    bool extractAll (const juce::File& destDirectory,
+                     juce::Array<juce::File>& filesCreated,
+                     bool askBeforeOverwriting,
+                     std::function<bool (float progress)> progressCallback,
+                     int numThreads = 0);
+
     bool addFile (const juce::File&, const juce::File& rootDirectory, CompressionType);
     bool addFile (const juce::File&, const juce::String& filenameToUse, CompressionType);
 
+    /** Describes a file to be added with addFiles(). */
+    struct FileToAdd
+    {
+        juce::File file;
+        juce::String filenameToUse;
+        CompressionType compression = CompressionType::none;
+    };
+
+    /** Adds a set of files, compressing them concurrently on a pool of worker threads.
+        Each file is encoded to a temporary file next to the archive and these are
+        appended in the order given as soon as they're ready, so the entries end up
+        the same as if addFile() had been called for each one in turn.
+        The names of any files that couldn't be added are added to failedFiles.
+        The progress callback is called on this thread and should return false to abort.
+        If numThreads is 0, one thread per CPU will be used.
+    */
+    bool addFiles (const juce::Array<FileToAdd>&,
+                   juce::StringArray& failedFiles,
+                   std::function<bool (float progress)> progressCallback = {},
+                   int numThreads = 0);
+
+    /** Returns the name that addFile() will use for a file relative to a root directory. */
+    static juce::String getArchivedFileName (const juce::File&, const juce::File& rootDirectory);
+
     void addFileInfo (const juce::String& filename,
                       const juce::String& itemName,
                       const juce::String& itemValue);
@@ -90,6 +127,12 @@ private:
     juce::OwnedArray<IndexEntry> entries;
     void readIndex();
 
+    bool appendEntry (std::unique_ptr<IndexEntry>, const juce::String& filenameForErrors,
+                      const std::function<bool (juce::OutputStream&, IndexEntry&)>& writeData);
+    static bool writeCompressedFile (Engine&, const juce::File&, juce::InputStream&, CompressionType,
+                                     juce::OutputStream&, IndexEntry&);
+
+    static int getNumThreadsToUse (int numThreads);
     static int getOggQuality (CompressionType);
     static int getMagicNumber();
 
@@ -0,0 +1,286 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace archive_test_utilities
+{
+    /** Writes a wav file of noise. */
+    inline juce::File createNoiseFile (const juce::File& destDir, const juce::String& name,
+                                       double sampleRate, int numChannels, double durationSeconds)
+    {
+        auto f = destDir.getChildFile (name + ".wav");
+        juce::Random r (name.hashCode());
+        auto buffer = audio_test_utilities::createNoise (numChannels, (int) (sampleRate * durationSeconds), r, 0.25f);
+
+        juce::WavAudioFormat format;
+
+        if (auto out = std::unique_ptr<juce::FileOutputStream> (f.createOutputStream()))
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (format.createWriterFor (out.get(), sampleRate,
+                                                                                                 (unsigned int) numChannels,
+                                                                                                 16, {}, 0)))
+            {
+                out.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+
+        return f;
+    }
+
+    /** Writes a text file with some compressible content. */
+    inline juce::File createTextFile (const juce::File& destDir, const juce::String& name, int numLines)
+    {
+        auto f = destDir.getChildFile (name + ".txt");
+        juce::String text;
+
+        for (int i = 0; i < numLines; ++i)
+            text << name << " line " << i << juce::newLine;
+
+        f.replaceWithText (text);
+        return f;
+    }
+
+    inline juce::int64 getTotalSize (const juce::Array<juce::File>& files)
+    {
+        juce::int64 total = 0;
+
+        for (auto& f : files)
+            total += f.getSize();
+
+        return total;
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class ArchiveFileTests  : public juce::UnitTest
+{
+public:
+    ArchiveFileTests()
+        : juce::UnitTest ("TracktionArchiveFile", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace archive_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+
+        juce::TemporaryFile sourceDir, serialArchiveFile, parallelArchiveFile, serialDestDir, parallelDestDir;
+        sourceDir.getFile().createDirectory();
+
+        juce::Array<juce::File> sourceFiles;
+        sourceFiles.add (createTextFile (sourceDir.getFile(), "small", 10));
+        sourceFiles.add (createTextFile (sourceDir.getFile(), "large", 10000));
+        sourceFiles.add (createNoiseFile (sourceDir.getFile(), "noise1", 44100.0, 2, 1.0));
+        sourceFiles.add (createNoiseFile (sourceDir.getFile(), "noise2", 48000.0, 1, 2.0));
+        sourceFiles.add (createTextFile (sourceDir.getFile(), "last", 100));
+
+        auto getCompression = [&] (const juce::File& f)
+        {
+            return AudioFile (engine, f).isValid() ? TracktionArchiveFile::CompressionType::lossless
+                                                   : TracktionArchiveFile::CompressionType::zip;
+        };
+
+        beginTest ("Parallel writing");
+        {
+            {
+                TracktionArchiveFile archive (engine, serialArchiveFile.getFile());
+
+                for (auto& f : sourceFiles)
+                    expect (archive.addFile (f, sourceDir.getFile(), getCompression (f)));
+            }
+
+            {
+                TracktionArchiveFile archive (engine, parallelArchiveFile.getFile());
+                juce::Array<TracktionArchiveFile::FileToAdd> filesToAdd;
+
+                for (auto& f : sourceFiles)
+                    filesToAdd.add ({ f, TracktionArchiveFile::getArchivedFileName (f, sourceDir.getFile()), getCompression (f) });
+
+                juce::StringArray failedFiles;
+                expect (archive.addFiles (filesToAdd, failedFiles, {}, 3));
+                expect (failedFiles.isEmpty());
+            }
+
+            TracktionArchiveFile serialArchive (engine, serialArchiveFile.getFile());
+            TracktionArchiveFile parallelArchive (engine, parallelArchiveFile.getFile());
+            expect (serialArchive.isValidArchive());
+            expect (parallelArchive.isValidArchive());
+            expectEquals (parallelArchive.getNumFiles(), sourceFiles.size());
+            expectEquals (parallelArchive.getNumFiles(), serialArchive.getNumFiles());
+
+            for (int i = 0; i < serialArchive.getNumFiles(); ++i)
+                expectEquals (parallelArchive.getOriginalFileName (i), serialArchive.getOriginalFileName (i));
+
+            expect (serialArchiveFile.getFile().hasIdenticalContentTo (parallelArchiveFile.getFile()),
+                    "Archives written concurrently should be the same as those written serially");
+        }
+
+        beginTest ("Parallel extraction");
+        {
+            juce::Array<juce::File> serialFiles, parallelFiles;
+
+            {
+                TracktionArchiveFile archive (engine, serialArchiveFile.getFile());
+                serialDestDir.getFile().createDirectory();
+
+                for (int i = 0; i < archive.getNumFiles(); ++i)
+                {
+                    juce::File fileCreated;
+                    expect (archive.extractFile (i, serialDestDir.getFile(), fileCreated, false));
+                    serialFiles.add (fileCreated);
+                }
+            }
+
+            {
+                TracktionArchiveFile archive (engine, parallelArchiveFile.getFile());
+                expect (archive.extractAll (parallelDestDir.getFile(), parallelFiles, false, {}, 3));
+            }
+
+            expectEquals (parallelFiles.size(), serialFiles.size());
+
+            for (int i = 0; i < juce::jmin (serialFiles.size(), parallelFiles.size()); ++i)
+            {
+                expectEquals (parallelFiles[i].getFileName(), serialFiles[i].getFileName());
+                expect (parallelFiles[i].hasIdenticalContentTo (serialFiles[i]));
+            }
+
+            // Files stored without lossy compression should be restored exactly
+            for (auto& f : sourceFiles)
+                if (! AudioFile (engine, f).isValid())
+                    expect (f.hasIdenticalContentTo (parallelDestDir.getFile().getChildFile (f.getFileName())));
+        }
+
+        beginTest ("Aborting extraction");
+        {
+            juce::TemporaryFile abortDestDir;
+            juce::Array<juce::File> filesCreated;
+            TracktionArchiveFile archive (engine, parallelArchiveFile.getFile());
+            expect (! archive.extractAll (abortDestDir.getFile(), filesCreated, false, [] (float) { return false; }, 1));
+            expect (filesCreated.size() < archive.getNumFiles());
+            abortDestDir.getFile().deleteRecursively();
+        }
+
+        sourceDir.getFile().deleteRecursively();
+        serialDestDir.getFile().deleteRecursively();
+        parallelDestDir.getFile().deleteRecursively();
+    }
+};
+
+static ArchiveFileTests archiveFileTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+//==============================================================================
+class ArchiveFileBenchmarks : public juce::UnitTest
+{
+public:
+    ArchiveFileBenchmarks()
+        : juce::UnitTest ("TracktionArchiveFile Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace archive_test_utilities;
+        auto& engine = *Engine::getEngines()[0];
+
+        juce::TemporaryFile sourceDir;
+        sourceDir.getFile().createDirectory();
+
+        juce::Array<juce::File> sourceFiles;
+
+        for (int i = 0; i < 16; ++i)
+            sourceFiles.add (createNoiseFile (sourceDir.getFile(), "noise" + juce::String (i), 44100.0, 2, 30.0));
+
+        for (auto compression : { TracktionArchiveFile::CompressionType::zip,
+                                  TracktionArchiveFile::CompressionType::lossless,
+                                  TracktionArchiveFile::CompressionType::lossyMediumQuality })
+        {
+            for (int numThreads : { 1, juce::SystemStats::getNumCpus() })
+                runArchiveBenchmark (engine, sourceDir.getFile(), sourceFiles, compression, numThreads);
+        }
+
+        sourceDir.getFile().deleteRecursively();
+    }
+
+private:
+    static juce::String getDescription (TracktionArchiveFile::CompressionType compression, int numThreads)
+    {
+        juce::String s;
+
+        switch (compression)
+        {
+            case TracktionArchiveFile::CompressionType::zip:                 s << "zip";     break;
+            case TracktionArchiveFile::CompressionType::lossless:            s << "FLAC";    break;
+            case TracktionArchiveFile::CompressionType::lossyMediumQuality:  s << "ogg";     break;
+            case TracktionArchiveFile::CompressionType::none:
+            case TracktionArchiveFile::CompressionType::lossyGoodQuality:
+            case TracktionArchiveFile::CompressionType::lossyLowQuality:
+            default:                                                         s << "other";   break;
+        }
+
+        return s << ", " << numThreads << " threads";
+    }
+
+    void runArchiveBenchmark (Engine& engine, const juce::File& sourceDir, const juce::Array<juce::File>& sourceFiles,
+                              TracktionArchiveFile::CompressionType compression, int numThreads)
+    {
+        using namespace archive_test_utilities;
+        const auto description = getDescription (compression, numThreads);
+        const auto totalSize = getTotalSize (sourceFiles);
+        juce::TemporaryFile archiveFile, destDir;
+
+        beginTest ("Archiving: " + description);
+        {
+            juce::Array<TracktionArchiveFile::FileToAdd> filesToAdd;
+
+            for (auto& f : sourceFiles)
+                filesToAdd.add ({ f, TracktionArchiveFile::getArchivedFileName (f, sourceDir), compression });
+
+            const StopwatchTimer timer;
+            TracktionArchiveFile archive (engine, archiveFile.getFile());
+            juce::StringArray failedFiles;
+            expect (archive.addFiles (filesToAdd, failedFiles, {}, numThreads));
+            archive.flush();
+            benchmark_utilities::printThroughput (timer, totalSize);
+        }
+
+        beginTest ("Extracting: " + description);
+        {
+            const StopwatchTimer timer;
+            TracktionArchiveFile archive (engine, archiveFile.getFile());
+            juce::Array<juce::File> filesCreated;
+            expect (archive.extractAll (destDir.getFile(), filesCreated, false, {}, numThreads));
+            benchmark_utilities::printThroughput (timer, getTotalSize (filesCreated));
+        }
+
+        destDir.getFile().deleteRecursively();
+    }
+};
+
+static ArchiveFileBenchmarks archiveFileBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
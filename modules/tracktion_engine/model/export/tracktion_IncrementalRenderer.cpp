@@ -0,0 +1,343 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace
+{
+    // Instruments often report no tail even though their notes have a release
+    constexpr double minimumTailLength = 1.0;
+    constexpr double crossfadeLength = 0.01;
+
+    /** Returns the tracks whose changes affect a render, or an empty array for all of them. */
+    juce::Array<EditItemID> getTracksAffectingRender (const Renderer::Parameters& r)
+    {
+        juce::Array<EditItemID> trackIDs;
+        auto tracks = getAllTracks (*r.edit);
+
+        for (auto bit = r.tracksToDo.findNextSetBit (0); bit != -1; bit = r.tracksToDo.findNextSetBit (bit + 1))
+        {
+            if (auto t = tracks[bit])
+            {
+                // This could be affected by changes to any of the tracks it's connected to
+                if (auto at = dynamic_cast<AudioTrack*> (t))
+                    if (! canTrackBeProcessedIndependently (*at))
+                        return {};
+
+                trackIDs.add (t->itemID);
+            }
+        }
+
+        return trackIDs;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> createReader (juce::AudioFormat& format, const juce::File& file)
+    {
+        return std::unique_ptr<juce::AudioFormatReader> (format.createReaderFor (file.createInputStream().release(), true));
+    }
+}
+
+//==============================================================================
+bool IncrementalRenderer::renderChanges (const juce::String& taskDescription, const Renderer::Parameters& r)
+{
+    CRASH_TRACER
+    auto tracker = r.edit->getChangeTracker();
+
+    if (tracker == nullptr || ! canRenderIncrementally (r) || ! r.destFile.existsAsFile())
+        return false;
+
+    const auto settingsHash = getSettingsHash (r);
+    EditChangeTracker::Generation renderedGeneration = 0;
+
+    if (! tracker->getRenderedFileGeneration (r.destFile, settingsHash, renderedGeneration))
+        return false;
+
+    // Take this now so anything changed while rendering is picked up next time
+    const auto generation = tracker->getCurrentGeneration();
+    const auto sampleRate = r.sampleRateForAudio;
+    auto previous = createReader (*r.audioFormat, r.destFile);
+
+    if (previous == nullptr || previous->sampleRate != sampleRate)
+        return false;
+
+    // The render can be a few samples out depending on how the blocks and latency line up
+    const auto numSamples = previous->lengthInSamples;
+
+    if (std::abs (numSamples - (juce::int64) juce::roundToInt (r.time.getLength() * sampleRate)) > r.blockSizeForAudio)
+        return false;
+
+    const auto tailLength = juce::jmin (getTailLength (*r.edit), r.time.getLength());
+    const auto times = getRangesToRender (tracker->getChangesSince (renderedGeneration, getTracksAffectingRender (r)),
+                                          { r.time.getStart(), r.time.getStart() + numSamples / sampleRate },
+                                          tailLength, crossfadeLength);
+
+    if (times.isEmpty())
+    {
+        tracker->setRenderedFileGeneration (r.destFile, settingsHash, generation);
+        return true;
+    }
+
+    double lengthToRender = 0.0;
+
+    for (auto& t : times)
+        lengthToRender += t.getLength() + tailLength;
+
+    if (lengthToRender > r.time.getLength() / 2.0)
+        return false;
+
+    //==============================================================================
+    auto toSample = [&] (double time)
+    {
+        return juce::jlimit ((juce::int64) 0, numSamples, (juce::int64) std::llround ((time - r.time.getStart()) * sampleRate));
+    };
+
+    const auto preRollSamples = (juce::int64) std::llround (tailLength * sampleRate);
+    auto& sectionFormat = *r.engine->getAudioFileFormatManager().getFrozenFileFormat();
+
+    std::vector<std::unique_ptr<juce::TemporaryFile>> sectionFiles;
+    std::vector<std::unique_ptr<juce::AudioFormatReader>> sectionReaders;
+    std::vector<Section> sections;
+
+    for (auto& t : times)
+    {
+        const juce::Range<juce::int64> destRange (toSample (t.getStart()), toSample (t.getEnd()));
+        const auto renderStart = juce::jmax ((juce::int64) 0, destRange.getStart() - preRollSamples);
+
+        sectionFiles.push_back (std::make_unique<juce::TemporaryFile> (r.destFile, juce::TemporaryFile::useHiddenFile));
+        auto sectionFile = sectionFiles.back()->getFile();
+
+        // Start and end on the previous render's samples so the sections line up with it
+        auto p = r;
+        p.destFile = sectionFile;
+        p.audioFormat = &sectionFormat;
+        p.bitDepth = 32;
+        p.time = { r.time.getStart() + renderStart / sampleRate, r.time.getStart() + destRange.getEnd() / sampleRate };
+        p.trimSilenceAtEnds = false;
+        p.shouldNormalise = false;
+        p.shouldNormaliseByRMS = false;
+        p.ditheringEnabled = false; // The section is dithered when it's spliced in
+        p.metadata = {};
+        p.category = ProjectItem::Category::none;
+        p.allowIncrementalRender = false;
+
+        if (Renderer::renderToFile (taskDescription, p) != sectionFile)
+            return false;
+
+        auto reader = createReader (sectionFormat, sectionFile);
+
+        if (reader == nullptr
+             || reader->numChannels != previous->numChannels
+             || reader->lengthInSamples < destRange.getEnd() - renderStart)
+            return false;
+
+        sections.push_back ({ reader.get(), destRange.getStart() - renderStart, destRange });
+        sectionReaders.push_back (std::move (reader));
+    }
+
+    //==============================================================================
+    juce::TemporaryFile output (r.destFile);
+
+    {
+        AudioFileWriter writer (AudioFile (*r.engine, output.getFile()), r.audioFormat,
+                                (int) previous->numChannels, sampleRate, r.bitDepth,
+                                previous->metadataValues, r.quality);
+
+        const int ditherBitDepth = r.ditheringEnabled && r.bitDepth < 32 ? r.bitDepth : 0;
+
+        if (! writer.isOpen() || ! splice (writer, *previous, sections, juce::roundToInt (crossfadeLength * sampleRate), ditherBitDepth))
+            return false;
+    }
+
+    previous.reset();
+    sectionReaders.clear();
+
+    AudioFile destFile (*r.engine, r.destFile);
+    r.engine->getAudioFileManager().releaseFile (destFile);
+
+    if (! output.overwriteTargetFileWithTemporary())
+        return false;
+
+    r.engine->getAudioFileManager().checkFileForChanges (destFile);
+    tracker->setRenderedFileGeneration (r.destFile, settingsHash, generation);
+
+    return true;
+}
+
+void IncrementalRenderer::renderFinished (const Renderer::Parameters& r, EditChangeTracker::Generation generation)
+{
+    if (auto tracker = r.edit->getChangeTracker())
+        if (canRenderIncrementally (r) && r.destFile.existsAsFile())
+            tracker->setRenderedFileGeneration (r.destFile, getSettingsHash (r), generation);
+}
+
+bool IncrementalRenderer::canRenderIncrementally (const Renderer::Parameters& r)
+{
+    // Normalising, trimming and the end allowance depend on the whole render and a lossy
+    // format would lose quality each time it was updated
+    return r.edit != nullptr
+        && r.audioFormat != nullptr
+        && ! r.audioFormat->isCompressed()
+        && ! r.createMidiFile
+        && ! r.trimSilenceAtEnds
+        && r.endAllowance == 0.0
+        && ! r.shouldNormalise
+        && ! r.shouldNormaliseByRMS
+        && ! r.separateTracks
+        && r.additionalOutputs.empty();
+}
+
+//==============================================================================
+juce::Array<EditTimeRange> IncrementalRenderer::getRangesToRender (const juce::Array<EditTimeRange>& changes,
+                                                                   EditTimeRange renderRange,
+                                                                   double tailLength, double crossfade)
+{
+    juce::Array<EditTimeRange> ranges;
+
+    for (auto& c : changes)
+    {
+        auto range = EditTimeRange (c.getStart() - crossfade, c.getEnd() + tailLength + crossfade)
+                        .getIntersectionWith (renderRange);
+
+        if (range.isEmpty())
+            continue;
+
+        if (! ranges.isEmpty() && range.getStart() <= ranges.getLast().getEnd() + tailLength)
+            ranges.getReference (ranges.size() - 1) = ranges.getLast().getUnionWith (range);
+        else
+            ranges.add (range);
+    }
+
+    return ranges;
+}
+
+double IncrementalRenderer::getTailLength (const Edit& edit)
+{
+    // The latency's included so the delay compensation has filled up by the start of a section
+    double tail = minimumTailLength, latency = 0.0;
+
+    for (auto p : getAllPlugins (edit, true))
+    {
+        tail = juce::jmax (tail, p->getTailLength());
+        latency = juce::jmax (latency, p->getLatencySeconds());
+    }
+
+    return tail + latency;
+}
+
+juce::int64 IncrementalRenderer::getSettingsHash (const Renderer::Parameters& r)
+{
+    juce::String settings;
+    settings << r.tracksToDo.toString (16) << ";"
+             << (r.audioFormat != nullptr ? r.audioFormat->getFormatName() : juce::String()) << ";"
+             << r.bitDepth << ";" << r.blockSizeForAudio << ";" << r.sampleRateForAudio << ";"
+             << r.time.getStart() << ";" << r.time.getEnd() << ";" << r.endAllowance << ";"
+             << (int) r.canRenderInMono << (int) r.mustRenderInMono << (int) r.usePlugins
+             << (int) r.useMasterPlugins << (int) r.ditheringEnabled << (int) r.addAntiDenormalisationNoise << ";"
+             << r.quality << ";" << r.metadata.getDescription();
+
+    for (auto c : r.allowedClips)
+        settings << ";" << c->itemID.toString();
+
+    auto hash = settings.hashCode64();
+
+    // The source files could be changed without changing the Edit
+    if (r.edit != nullptr)
+    {
+        for (auto at : getAudioTracks (*r.edit))
+        {
+            for (auto c : at->getClips())
+            {
+                if (auto acb = dynamic_cast<AudioClipBase*> (c))
+                {
+                    auto file = acb->getPlaybackFile().getFile();
+                    hash ^= (file.getFullPathName() + juce::String (file.getLastModificationTime().toMilliseconds())).hashCode64();
+                }
+            }
+        }
+    }
+
+    return hash;
+}
+
+//==============================================================================
+bool IncrementalRenderer::splice (AudioFileWriter& writer, juce::AudioFormatReader& previous,
+                                  const std::vector<Section>& sections, int crossfadeSamples, int ditherBitDepth)
+{
+    CRASH_TRACER
+    const int numChannels = (int) previous.numChannels;
+    const int blockSize = 8192;
+
+    juce::AudioBuffer<float> oldAudio (numChannels, blockSize), newAudio (numChannels, blockSize);
+    juce::HeapBlock<float> gains ((size_t) blockSize);
+    juce::int64 position = 0;
+
+    const bool shouldDither = ditherBitDepth > 0 && ditherBitDepth < 32;
+    std::vector<Ditherer> ditherers ((size_t) numChannels);
+
+    for (auto& d : ditherers)
+        d.reset (ditherBitDepth);
+
+    for (auto& s : sections)
+    {
+        jassert (s.reader != nullptr && s.destRange.getStart() >= position);
+
+        if (! writer.writeFromAudioReader (previous, position, s.destRange.getStart() - position))
+            return false;
+
+        const auto sectionLength = s.destRange.getLength();
+        const auto fadeLength = juce::jmin ((juce::int64) crossfadeSamples, sectionLength / 2);
+
+        for (auto start = s.destRange.getStart(); start < s.destRange.getEnd(); start += blockSize)
+        {
+            const int numThisTime = (int) juce::jmin ((juce::int64) blockSize, s.destRange.getEnd() - start);
+            const auto startInSection = start - s.destRange.getStart();
+
+            if (! s.reader->read (&newAudio, 0, numThisTime, s.readerStart + startInSection, true, true))
+                return false;
+
+            if (startInSection < fadeLength || startInSection + numThisTime > sectionLength - fadeLength)
+            {
+                if (! previous.read (&oldAudio, 0, numThisTime, start, true, true))
+                    return false;
+
+                // Fade from the previous render in to the new one and back again
+                for (int i = 0; i < numThisTime; ++i)
+                {
+                    const auto distanceFromEnd = juce::jmin (startInSection + i + 1, sectionLength - (startInSection + i));
+                    gains[i] = (float) juce::jmin (1.0, distanceFromEnd / (double) (fadeLength + 1));
+                }
+
+                for (int chan = 0; chan < numChannels; ++chan)
+                {
+                    auto dest = newAudio.getWritePointer (chan);
+                    auto old = oldAudio.getReadPointer (chan);
+
+                    juce::FloatVectorOperations::subtract (dest, old, numThisTime);
+                    juce::FloatVectorOperations::multiply (dest, gains, numThisTime);
+                    juce::FloatVectorOperations::add (dest, old, numThisTime);
+                }
+            }
+
+            if (shouldDither)
+                for (int chan = 0; chan < numChannels; ++chan)
+                    ditherers[(size_t) chan].process (newAudio.getWritePointer (chan), numThisTime);
+
+            if (! writer.appendBuffer (newAudio, numThisTime))
+                return false;
+        }
+
+        position = s.destRange.getEnd();
+    }
+
+    return writer.writeFromAudioReader (previous, position, previous.lengthInSamples - position);
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,84 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Updates a previous render by only rendering the sections that have changed.
+
+    The Edit's EditChangeTracker gives the time ranges changed since the file was
+    rendered. Each one is extended by the longest plugin tail so anything ringing on
+    from it is included, then rendered on its own, starting a tail's length early so
+    the plugins are in the same state they'd be in a full render. The new sections
+    are crossfaded in to a copy of the previous render, which then replaces it.
+
+    Renderer::renderToFile() uses this when Parameters::allowIncrementalRender is set.
+*/
+struct IncrementalRenderer
+{
+    /** Tries to update a previous render of params.destFile.
+        Returns false if it couldn't, in which case the file's left unchanged and should
+        be rendered in full. This happens if the file hasn't been rendered with the same
+        settings before, the settings can't be used incrementally (e.g. normalising) or
+        so much has changed that a full render would be quicker.
+    */
+    static bool renderChanges (const juce::String& taskDescription, const Renderer::Parameters&);
+
+    /** Records that params.destFile has been fully rendered so it can be updated by
+        renderChanges() later. The Generation should be taken before the render started.
+    */
+    static void renderFinished (const Renderer::Parameters&, EditChangeTracker::Generation);
+
+    /** Returns true if a render with these settings could be updated incrementally. */
+    static bool canRenderIncrementally (const Renderer::Parameters&);
+
+    //==============================================================================
+    /** Returns the sections of a render that need re-rendering for some changes.
+        Each change is extended by the tail length and a crossfade either side, then
+        they're limited to the render range. Any closer together than the tail length
+        are merged as the gap would have to be rendered as pre-roll anyway.
+        The changes must be sorted.
+    */
+    static juce::Array<EditTimeRange> getRangesToRender (const juce::Array<EditTimeRange>& changes,
+                                                         EditTimeRange renderRange,
+                                                         double tailLength, double crossfadeLength);
+
+    /** Returns the length of pre-roll needed before a section and the amount it can
+        affect after it, i.e. the longest plugin tail plus the longest latency.
+    */
+    static double getTailLength (const Edit&);
+
+    /** Returns a hash of the settings that would change the whole of a render, including
+        the modification times of the source files.
+    */
+    static juce::int64 getSettingsHash (const Renderer::Parameters&);
+
+    //==============================================================================
+    /** A newly rendered section to splice in to a previous render. */
+    struct Section
+    {
+        juce::AudioFormatReader* reader = nullptr;
+        juce::int64 readerStart = 0;            /**< The reader's sample that goes at destRange.getStart(). */
+        juce::Range<juce::int64> destRange;     /**< The samples of the previous render to replace. */
+    };
+
+    /** Writes the previous render to a writer with the sections replaced.
+        The sections must be in order and not overlap. Each one is crossfaded from and back
+        to the previous render over crossfadeSamples at its ends.
+        The sections are dithered to ditherBitDepth like the rest of the previous render
+        would have been. Pass 0 to not dither them.
+    */
+    static bool splice (AudioFileWriter&, juce::AudioFormatReader& previous,
+                        const std::vector<Section>&, int crossfadeSamples, int ditherBitDepth);
+};
+
+} // namespace tracktion_engine
@@ -0,0 +1,214 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class IncrementalRendererTests  : public juce::UnitTest
+{
+public:
+    IncrementalRendererTests()
+        : juce::UnitTest ("IncrementalRenderer", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+
+        beginTest ("Ranges to render");
+        {
+            juce::Array<EditTimeRange> changes;
+
+            for (auto c : { EditTimeRange (10.0, 11.0), EditTimeRange (11.5, 12.0), EditTimeRange (30.0, 31.0),
+                            EditTimeRange (39.5, 45.0), EditTimeRange (50.0, 51.0) })
+                changes.add (c);
+
+            auto ranges = IncrementalRenderer::getRangesToRender (changes, { 0.0, 40.0 }, 1.0, 0.01);
+            expectEquals (ranges.size(), 3);
+
+            // The first two are closer than the tail so are merged
+            expectRange (ranges[0], { 9.99, 13.01 });
+            expectRange (ranges[1], { 29.99, 32.01 });
+            expectRange (ranges[2], { 39.49, 40.0 });
+
+            expect (IncrementalRenderer::getRangesToRender ({}, { 0.0, 40.0 }, 1.0, 0.01).isEmpty());
+        }
+
+        beginTest ("Splicing");
+        {
+            juce::WavAudioFormat format;
+            juce::TemporaryFile previousFile (".wav"), sectionFile (".wav"), outputFile (".wav");
+
+            juce::AudioBuffer<float> previousAudio (2, 10000), sectionAudio (2, 3000);
+            previousAudio.clear();
+            sectionAudio.clear();
+
+            for (int chan = 0; chan < 2; ++chan)
+            {
+                juce::FloatVectorOperations::fill (previousAudio.getWritePointer (chan), 0.25f, previousAudio.getNumSamples());
+                juce::FloatVectorOperations::fill (sectionAudio.getWritePointer (chan), 0.75f, sectionAudio.getNumSamples());
+            }
+
+            expect (writeFile (engine, format, previousFile.getFile(), previousAudio));
+            expect (writeFile (engine, format, sectionFile.getFile(), sectionAudio));
+
+            auto previous = createReader (format, previousFile.getFile());
+            auto section = createReader (format, sectionFile.getFile());
+            expect (previous != nullptr && section != nullptr);
+
+            if (previous != nullptr && section != nullptr)
+            {
+                {
+                    AudioFileWriter writer (AudioFile (engine, outputFile.getFile()), &format, 2, 44100.0, 32, {}, 0);
+                    expect (IncrementalRenderer::splice (writer, *previous, { { section.get(), 500, { 4000, 6000 } } }, 100, 0));
+                }
+
+                auto result = readFile (format, outputFile.getFile());
+                expectEquals (result.getNumSamples(), previousAudio.getNumSamples());
+
+                for (int chan = 0; chan < 2; ++chan)
+                {
+                    expectEquals (result.getSample (chan, 3999), 0.25f);
+                    expectEquals (result.getSample (chan, 5000), 0.75f);
+                    expectEquals (result.getSample (chan, 6000), 0.25f);
+
+                    // Crossfaded in and out again
+                    expect (result.getSample (chan, 4000) > 0.25f && result.getSample (chan, 4000) < 0.26f);
+                    expectWithinAbsoluteError (result.getSample (chan, 4050), 0.5f, 0.01f);
+                    expectEquals (result.getSample (chan, 4100), 0.75f);
+                    expectWithinAbsoluteError (result.getSample (chan, 5950), 0.5f, 0.01f);
+                    expect (result.getSample (chan, 5999) > 0.25f && result.getSample (chan, 5999) < 0.26f);
+                }
+
+                // Dithered, only the new section has noise added
+                {
+                    outputFile.getFile().deleteFile();
+                    AudioFileWriter writer (AudioFile (engine, outputFile.getFile()), &format, 2, 44100.0, 16, {}, 0);
+                    expect (IncrementalRenderer::splice (writer, *previous, { { section.get(), 500, { 4000, 6000 } } }, 100, 16));
+                }
+
+                auto dithered = readFile (format, outputFile.getFile());
+                expectEquals (dithered.getNumSamples(), previousAudio.getNumSamples());
+
+                for (int chan = 0; chan < 2; ++chan)
+                {
+                    auto range = dithered.findMinMax (chan, 4100, 1800);
+                    expect (range.getLength() > 0.0f);
+                    expectWithinAbsoluteError (range.getStart(), 0.75f, 0.001f);
+                    expectWithinAbsoluteError (range.getEnd(), 0.75f, 0.001f);
+
+                    expectEquals (dithered.findMinMax (chan, 0, 4000), juce::Range<float> (0.25f, 0.25f));
+                }
+            }
+        }
+
+        beginTest ("Only the changed sections are rendered");
+        {
+            auto& dm = engine.getDeviceManager();
+            const double sampleRate = dm.getSampleRate();
+            auto sinFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (sampleRate, 1.0);
+
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto track = getAudioTracks (*edit)[0];
+            track->insertWaveClip ("first", sinFile->getFile(), { { 5.0, 6.0 } }, false);
+            auto movedClip = track->insertWaveClip ("second", sinFile->getFile(), { { 20.0, 21.0 } }, false);
+
+            juce::TemporaryFile incrementalFile (".wav"), fullFile (".wav");
+
+            Renderer::Parameters r (*edit);
+            r.tracksToDo.setBit (track->getIndexInEditTrackList());
+            r.destFile = incrementalFile.getFile();
+            r.audioFormat = engine.getAudioFileFormatManager().getDefaultFormat();
+            r.bitDepth = 32;
+            r.blockSizeForAudio = dm.getBlockSize();
+            r.sampleRateForAudio = sampleRate;
+            r.time = { 0.0, 30.0 };
+            r.canRenderInMono = false;
+            r.allowIncrementalRender = true;
+
+            expect (Renderer::renderToFile ({}, r) == r.destFile);
+
+            // Replace the render with silence so any section that gets rendered again shows up
+            auto previous = readFile (*r.audioFormat, r.destFile);
+            expect (previous.getNumSamples() > 0);
+            previous.clear();
+            expect (writeFile (engine, *r.audioFormat, r.destFile, previous, sampleRate));
+
+            movedClip->setStart (22.0, false, true);
+            expect (Renderer::renderToFile ({}, r) == r.destFile);
+
+            auto full = r;
+            full.destFile = fullFile.getFile();
+            full.allowIncrementalRender = false;
+            expect (Renderer::renderToFile ({}, full) == full.destFile);
+
+            auto incremental = readFile (*r.audioFormat, r.destFile);
+            auto expected = readFile (*r.audioFormat, full.destFile);
+            expectEquals (incremental.getNumSamples(), expected.getNumSamples());
+
+            auto toSample = [sampleRate] (double time) { return juce::roundToInt (time * sampleRate); };
+
+            // The unchanged clip wasn't rendered again
+            expectEquals (incremental.getMagnitude (toSample (5.0), toSample (1.0)), 0.0f);
+            expect (expected.getMagnitude (toSample (5.0), toSample (1.0)) > 0.5f);
+
+            // Both the clip's old and new positions were
+            expect (expected.getMagnitude (toSample (22.0), toSample (1.0)) > 0.5f);
+            expectLessThan (audio_test_utilities::getMaxDifference (incremental, expected, { toSample (19.0), toSample (25.0) }), 1.0e-4f);
+
+            engine.getAudioFileManager().releaseAllFiles();
+            edit->getTempDirectory (false).deleteRecursively();
+        }
+    }
+
+private:
+    void expectRange (EditTimeRange actual, EditTimeRange expected)
+    {
+        expectWithinAbsoluteError (actual.getStart(), expected.getStart(), 1.0e-9);
+        expectWithinAbsoluteError (actual.getEnd(), expected.getEnd(), 1.0e-9);
+    }
+
+    static std::unique_ptr<juce::AudioFormatReader> createReader (juce::AudioFormat& format, const juce::File& file)
+    {
+        return std::unique_ptr<juce::AudioFormatReader> (format.createReaderFor (file.createInputStream().release(), true));
+    }
+
+    static juce::AudioBuffer<float> readFile (juce::AudioFormat& format, const juce::File& file)
+    {
+        auto reader = createReader (format, file);
+
+        if (reader == nullptr)
+            return {};
+
+        juce::AudioBuffer<float> buffer ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+
+        return buffer;
+    }
+
+    static bool writeFile (Engine& engine, juce::AudioFormat& format, const juce::File& file,
+                           const juce::AudioBuffer<float>& buffer, double sampleRate = 44100.0)
+    {
+        file.deleteFile();
+
+        AudioFileWriter writer (AudioFile (engine, file), &format, buffer.getNumChannels(), sampleRate, 32, {}, 0);
+        return writer.isOpen() && writer.appendBuffer (buffer, buffer.getNumSamples());
+    }
+};
+
+static IncrementalRendererTests incrementalRendererTests;
+
+#endif
+
+} // namespace tracktion_engine
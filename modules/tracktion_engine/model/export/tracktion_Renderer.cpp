@@ -178,6 +178,8 @@ bool Renderer::RenderTask::performNormalisingAndTrimming (const Renderer::Parame
 {
     CRASH_TRACER
 
+    auto startTime = intermediate.time.getStart();
+
     if (target.trimSilenceAtEnds)
     {
         setJobName (TRANS("Trimming silence") + "...");
@@ -194,6 +196,8 @@ bool Renderer::RenderTask::performNormalisingAndTrimming (const Renderer::Parame
         AudioFileUtils::applyBWAVStartTime (intermediate.destFile,
                                             (int64) (intermediate.time.getStart() * intermediate.sampleRateForAudio)
                                                + doneRange.getStart());
+
+        startTime += doneRange.getStart() / intermediate.sampleRateForAudio;
     }
 
     if (target.shouldNormalise || target.shouldNormaliseByRMS)
@@ -230,6 +234,23 @@ bool Renderer::RenderTask::performNormalisingAndTrimming (const Renderer::Parame
     const int blockSize = 16384;
     juce::AudioBuffer<float> tempBuffer ((int) reader->numChannels, blockSize + 256);
 
+    // The additional outputs get the same trimmed and normalised audio as the main file
+    std::vector<std::unique_ptr<StreamingEncoder>> additionalEncoders;
+
+    for (auto& output : target.additionalOutputs)
+    {
+        auto encoder = StreamingEncoder::createForOutput (params.edit->engine, output, (int) reader->numChannels,
+                                                          reader->sampleRate, startTime, blockSize * 4);
+
+        if (encoder == nullptr)
+        {
+            errorMessage = TRANS("Couldn't write to target file") + ": " + output.destFile.getFileName();
+            return false;
+        }
+
+        additionalEncoders.push_back (std::move (encoder));
+    }
+
     for (int64 pos = 0; pos < reader->lengthInSamples;)
     {
         auto numLeft = static_cast<int> (reader->lengthInSamples - pos);
@@ -239,6 +260,16 @@ bool Renderer::RenderTask::performNormalisingAndTrimming (const Renderer::Parame
 
         tempBuffer.applyGain (0, samps, gain);
 
+        // These do their own dithering, so get the audio before it's dithered here
+        for (auto& encoder : additionalEncoders)
+        {
+            if (! encoder->write (tempBuffer, 0, samps))
+            {
+                errorMessage = TRANS("Couldn't write to target file");
+                return false;
+            }
+        }
+
         if (target.ditheringEnabled && target.bitDepth < 32)
             ditherers.apply (tempBuffer, samps);
 
@@ -246,6 +277,15 @@ bool Renderer::RenderTask::performNormalisingAndTrimming (const Renderer::Parame
         pos += samps;
     }
 
+    for (size_t i = 0; i < additionalEncoders.size(); ++i)
+    {
+        if (! additionalEncoders[i]->finish())
+        {
+            errorMessage = TRANS("Couldn't write to target file") + ": " + target.additionalOutputs[i].destFile.getFileName();
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -465,7 +505,25 @@ juce::File Renderer::renderToFile (const String& taskDescription, const Paramete
          && ! r.destFile.isDirectory())
     {
         auto& ui = r.edit->engine.getUIBehaviour();
-        
+
+        // Taken before rendering so anything changed during the render is picked up next time
+        EditChangeTracker::Generation generation = 0;
+
+        if (r.allowIncrementalRender)
+        {
+            if (auto tracker = r.edit->getChangeTracker())
+                generation = tracker->getCurrentGeneration();
+
+            if (IncrementalRenderer::renderChanges (taskDescription, r))
+            {
+                turnOffAllPlugins (*r.edit);
+                return r.destFile;
+            }
+
+            // The writer would append to the previous render
+            r.destFile.deleteFile();
+        }
+
         if (auto task = render_utils::createRenderTask (r, taskDescription, nullptr, nullptr))
         {
             ui.runTaskWithProgressBar (*task);
@@ -480,6 +538,9 @@ juce::File Renderer::renderToFile (const String& taskDescription, const Paramete
                     return {};
                 }
 
+                if (r.allowIncrementalRender)
+                    IncrementalRenderer::renderFinished (r, generation);
+
                 return r.destFile;
             }
 
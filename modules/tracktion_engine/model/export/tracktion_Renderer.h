@@ -72,6 +72,33 @@ public:
         juce::StringPairArray metadata;
         ProjectItem::Category category = ProjectItem::Category::none;
 
+        /** Another file to write from the same render, e.g. for a different delivery format.
+            Each one is resampled, dithered and encoded on its own thread from the audio before
+            the main file's dithering, so the Edit only needs to be rendered once.
+        */
+        struct AdditionalOutput
+        {
+            juce::File destFile;
+            juce::AudioFormat* audioFormat = nullptr;
+            int bitDepth = 16;
+            double sampleRate = 0.0;        /**< 0 to use sampleRateForAudio. */
+            bool ditheringEnabled = false;
+            int quality = 0;
+            juce::StringPairArray metadata;
+        };
+
+        /** When normalising or trimming silence, these are written from the trimmed and
+            normalised audio after the render, so they match the main file.
+        */
+        std::vector<AdditionalOutput> additionalOutputs;
+
+        /** If the destination file was rendered before with the same settings, renderToFile()
+            only re-renders the parts of it the Edit's changed since then.
+            The result values below aren't set by an incremental render.
+            @see IncrementalRenderer
+        */
+        bool allowIncrementalRender = false;
+
         float resultMagnitude = 0;
         float resultRMS = 0;
         float resultAudioDuration = 0;
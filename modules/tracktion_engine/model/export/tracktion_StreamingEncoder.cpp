@@ -0,0 +1,343 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace
+{
+    struct WriterCodec  : public StreamingEncoder::Codec
+    {
+        WriterCodec (std::unique_ptr<AudioFileWriter> w)  : writer (std::move (w)) {}
+
+        bool encode (const juce::AudioBuffer<float>& buffer, int numSamples) override
+        {
+            return writer->appendBuffer (buffer, numSamples);
+        }
+
+        bool finish() override
+        {
+            writer->closeForWriting();
+            return true;
+        }
+
+        std::unique_ptr<AudioFileWriter> writer;
+    };
+
+    struct ConvertingCodec  : public StreamingEncoder::Codec
+    {
+        ConvertingCodec (std::unique_ptr<StreamingEncoder::Codec> d, int numChannels,
+                         double sourceSampleRate, double destSampleRate, int ditherBitDepth)
+            : dest (std::move (d)),
+              ratio (sourceSampleRate / destSampleRate),
+              needsResampling (sourceSampleRate != destSampleRate),
+              shouldDither (ditherBitDepth > 0 && ditherBitDepth < 32),
+              input (numChannels, 0), output (numChannels, 0),
+              interpolators ((size_t) numChannels), antiAliasingFilters ((size_t) numChannels),
+              ditherers ((size_t) numChannels)
+        {
+            for (auto& d : ditherers)
+                d.reset (ditherBitDepth);
+
+            if (sourceSampleRate > destSampleRate)
+                createAntiAliasingFilters (sourceSampleRate, destSampleRate);
+        }
+
+        bool encode (const juce::AudioBuffer<float>& buffer, int numSamples) override
+        {
+            if (! needsResampling)
+            {
+                if (! shouldDither)
+                    return dest->encode (buffer, numSamples);
+
+                output.setSize (output.getNumChannels(), numSamples, false, false, true);
+
+                for (int chan = output.getNumChannels(); --chan >= 0;)
+                    output.copyFrom (chan, 0, buffer, chan, 0, numSamples);
+
+                return ditherAndEncode (numSamples);
+            }
+
+            addInput (&buffer, numSamples);
+            totalNumInput += numSamples;
+
+            // Only produce as much output as can be interpolated from the input so far
+            return resampleAndEncode ((int) ((numInputSamples - 1) / ratio));
+        }
+
+        bool finish() override
+        {
+            if (needsResampling)
+            {
+                const auto numOutputLeft = (int) (std::llround (totalNumInput / ratio) - totalNumOutput);
+
+                if (numOutputLeft > 0)
+                {
+                    // Push the last of the input through the interpolators with some silence
+                    addInput (nullptr, (int) std::ceil (numOutputLeft * ratio) + 8);
+
+                    if (! resampleAndEncode (numOutputLeft))
+                        return false;
+                }
+            }
+
+            return dest->finish();
+        }
+
+        void createAntiAliasingFilters (double sourceSampleRate, double destSampleRate)
+        {
+            // The interpolator isn't band-limited, so when downsampling anything above the new
+            // Nyquist frequency has to be removed first or it'll be aliased. This passes up to
+            // 90% of it and is 90dB down by the time it's reached.
+            const auto stopBand = destSampleRate / 2.0 / sourceSampleRate;
+            const auto passBand = stopBand * 0.9;
+
+            auto coefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderEllipticMethod ((float) ((passBand + stopBand) / 2.0 * sourceSampleRate),
+                                                                                                         sourceSampleRate, (float) (stopBand - passBand),
+                                                                                                         -0.1f, -90.0f);
+
+            for (auto& filters : antiAliasingFilters)
+                for (auto c : coefficients)
+                    filters.emplace_back (c);
+        }
+
+        void addInput (const juce::AudioBuffer<float>* source, int numSamples)
+        {
+            input.setSize (input.getNumChannels(), numInputSamples + numSamples, true, false, true);
+
+            for (int chan = input.getNumChannels(); --chan >= 0;)
+            {
+                if (source != nullptr)
+                    input.copyFrom (chan, numInputSamples, *source, chan, 0, numSamples);
+                else
+                    input.clear (chan, numInputSamples, numSamples);
+
+                // Silence is filtered too so that the filters' tails are flushed out at the end
+                juce::dsp::AudioBlock<float> block (input.getArrayOfWritePointers() + chan, 1,
+                                                    (size_t) numInputSamples, (size_t) numSamples);
+
+                for (auto& filter : antiAliasingFilters[(size_t) chan])
+                    filter.process (juce::dsp::ProcessContextReplacing<float> (block));
+            }
+
+            numInputSamples += numSamples;
+        }
+
+        bool resampleAndEncode (int numOutputSamples)
+        {
+            if (numOutputSamples <= 0)
+                return true;
+
+            output.setSize (output.getNumChannels(), numOutputSamples, false, false, true);
+            int numUsed = 0;
+
+            for (int chan = 0; chan < output.getNumChannels(); ++chan)
+                numUsed = interpolators[(size_t) chan].process (ratio, input.getReadPointer (chan),
+                                                                output.getWritePointer (chan), numOutputSamples);
+
+            // Move anything that hasn't been used yet to the start for the next block
+            jassert (numUsed <= numInputSamples);
+            numInputSamples -= numUsed;
+
+            for (int chan = input.getNumChannels(); --chan >= 0;)
+                std::memmove (input.getWritePointer (chan), input.getReadPointer (chan, numUsed),
+                              (size_t) numInputSamples * sizeof (float));
+
+            totalNumOutput += numOutputSamples;
+
+            return ditherAndEncode (numOutputSamples);
+        }
+
+        bool ditherAndEncode (int numSamples)
+        {
+            if (shouldDither)
+                for (int chan = output.getNumChannels(); --chan >= 0;)
+                    ditherers[(size_t) chan].process (output.getWritePointer (chan), numSamples);
+
+            return dest->encode (output, numSamples);
+        }
+
+        std::unique_ptr<StreamingEncoder::Codec> dest;
+        const double ratio;
+        const bool needsResampling, shouldDither;
+
+        juce::AudioBuffer<float> input, output;
+        int numInputSamples = 0;
+        juce::int64 totalNumInput = 0, totalNumOutput = 0;
+
+        std::vector<juce::LagrangeInterpolator> interpolators;
+        std::vector<std::vector<juce::dsp::IIR::Filter<float>>> antiAliasingFilters;
+        std::vector<Ditherer> ditherers;
+    };
+}
+
+std::unique_ptr<StreamingEncoder::Codec> StreamingEncoder::createWriterCodec (std::unique_ptr<AudioFileWriter> writer)
+{
+    if (writer == nullptr || ! writer->isOpen())
+        return {};
+
+    return std::make_unique<WriterCodec> (std::move (writer));
+}
+
+std::unique_ptr<StreamingEncoder::Codec> StreamingEncoder::createConvertingCodec (std::unique_ptr<Codec> destCodec, int numChannels,
+                                                                                  double sourceSampleRate, double destSampleRate,
+                                                                                  int ditherBitDepth)
+{
+    if (destCodec == nullptr)
+        return {};
+
+    jassert (sourceSampleRate > 0.0 && destSampleRate > 0.0);
+    return std::make_unique<ConvertingCodec> (std::move (destCodec), numChannels, sourceSampleRate, destSampleRate, ditherBitDepth);
+}
+
+std::unique_ptr<StreamingEncoder> StreamingEncoder::createForOutput (Engine& engine, const Renderer::Parameters::AdditionalOutput& output,
+                                                                     int numChannels, double sourceSampleRate,
+                                                                     double startTime, int queueSizeSamples)
+{
+    const auto destSampleRate = output.sampleRate > 0.0 ? output.sampleRate : sourceSampleRate;
+
+    auto metadata = output.metadata;
+    AudioFileUtils::addBWAVStartToMetadata (metadata, (int64_t) (startTime * destSampleRate));
+
+    auto codec = createWriterCodec (std::make_unique<AudioFileWriter> (AudioFile (engine, output.destFile),
+                                                                       output.audioFormat, numChannels, destSampleRate,
+                                                                       output.bitDepth, metadata, output.quality));
+
+    if (codec == nullptr)
+        return {};
+
+    std::vector<std::unique_ptr<Codec>> codecs;
+    codecs.push_back (createConvertingCodec (std::move (codec), numChannels, sourceSampleRate, destSampleRate,
+                                             output.ditheringEnabled ? output.bitDepth : 0));
+
+    return std::make_unique<StreamingEncoder> (std::move (codecs), numChannels, queueSizeSamples);
+}
+
+//==============================================================================
+StreamingEncoder::StreamingEncoder (std::vector<std::unique_ptr<Codec>> codecsToUse, int numChannels, int queueSizeSamples)
+    : juce::Thread ("Streaming Encoder"),
+      codecs (std::move (codecsToUse)),
+      fifo (numChannels, queueSizeSamples)
+{
+    jassert (! codecs.empty());
+    startThread();
+}
+
+StreamingEncoder::~StreamingEncoder()
+{
+    cancel();
+}
+
+bool StreamingEncoder::write (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    jassert (! inputFinished);
+
+    while (numSamples > 0)
+    {
+        if (failed || hasStopped)
+            return false;
+
+        const int numThisTime = juce::jmin (numSamples, fifo.getFreeSpace());
+
+        if (numThisTime == 0)
+        {
+            spaceAvailable.wait (10);
+            continue;
+        }
+
+        fifo.write (buffer, startSample, numThisTime);
+        dataAvailable.signal();
+
+        startSample += numThisTime;
+        numSamples -= numThisTime;
+    }
+
+    return ! failed;
+}
+
+bool StreamingEncoder::finish()
+{
+    if (! hasStopped)
+    {
+        inputFinished = true;
+        dataAvailable.signal();
+        stop();
+    }
+
+    return ! failed;
+}
+
+void StreamingEncoder::cancel()
+{
+    if (! hasStopped)
+    {
+        signalThreadShouldExit();
+        dataAvailable.signal();
+        stop();
+    }
+}
+
+void StreamingEncoder::stop()
+{
+    waitForThreadToExit (-1);
+    codecs.clear();
+    hasStopped = true;
+}
+
+//==============================================================================
+void StreamingEncoder::run()
+{
+    CRASH_TRACER
+    juce::AudioBuffer<float> buffer (fifo.getNumChannels(), 4096);
+
+    for (;;)
+    {
+        if (threadShouldExit())
+            return;
+
+        // Check the flag before the queue so nothing written before it was set gets missed
+        const bool isLastBlock = inputFinished;
+
+        if (fifo.getNumReady() == 0)
+        {
+            if (isLastBlock)
+                break;
+
+            dataAvailable.wait (50);
+            continue;
+        }
+
+        if (! encodeQueuedAudio (buffer))
+        {
+            failed = true;
+            spaceAvailable.signal();
+            return;
+        }
+    }
+
+    for (auto& codec : codecs)
+        if (! codec->finish())
+            failed = true;
+}
+
+bool StreamingEncoder::encodeQueuedAudio (juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = juce::jmin (fifo.getNumReady(), buffer.getNumSamples());
+    fifo.read (buffer, 0, numSamples);
+    spaceAvailable.signal();
+
+    for (auto& codec : codecs)
+        if (! codec->encode (buffer, numSamples))
+            return false;
+
+    return true;
+}
+
+} // namespace tracktion_engine
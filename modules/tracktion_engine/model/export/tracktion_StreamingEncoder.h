@@ -0,0 +1,108 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Encodes rendered audio on its own thread so the encoding overlaps the rendering.
+
+    The Renderer pushes each block in to a bounded AudioFifo, blocking only if the
+    encoder has fallen a whole queue behind, and the thread passes the audio on to
+    one or more Codecs. Each Codec gets exactly the same audio, so several formats
+    can be produced from a single render.
+*/
+class StreamingEncoder  : private juce::Thread
+{
+public:
+    /** Something that encodes the audio, e.g. an AudioFormatWriter for a file. */
+    struct Codec
+    {
+        virtual ~Codec() = default;
+
+        /** Called on the encoder thread with the next block of audio.
+            Return false if it couldn't be encoded, which stops the encoding.
+        */
+        virtual bool encode (const juce::AudioBuffer<float>&, int numSamples) = 0;
+
+        /** Called on the encoder thread once all the audio has been encoded.
+            Return false if the output couldn't be finished.
+        */
+        virtual bool finish() = 0;
+    };
+
+    /** Creates a Codec which writes to an AudioFileWriter.
+        This works with any of the juce::AudioFormats, so FLAC and Ogg-Vorbis are encoded
+        as the audio arrives. Returns nullptr if the writer isn't open.
+    */
+    static std::unique_ptr<Codec> createWriterCodec (std::unique_ptr<AudioFileWriter>);
+
+    /** Creates a Codec which resamples the audio and optionally dithers it before passing
+        it on to another Codec. Pass 0 for ditherBitDepth to not dither.
+        When downsampling, the audio is low-pass filtered first so it doesn't alias.
+        The destination gets the number of samples the source would have at its sample rate.
+    */
+    static std::unique_ptr<Codec> createConvertingCodec (std::unique_ptr<Codec> destCodec, int numChannels,
+                                                         double sourceSampleRate, double destSampleRate,
+                                                         int ditherBitDepth);
+
+    /** Creates an encoder which resamples, dithers and writes audio at sourceSampleRate
+        to one of a render's additional outputs. The file's BWAV start is set to startTime.
+        Returns nullptr if the file couldn't be opened.
+    */
+    static std::unique_ptr<StreamingEncoder> createForOutput (Engine&, const Renderer::Parameters::AdditionalOutput&,
+                                                              int numChannels, double sourceSampleRate,
+                                                              double startTime, int queueSizeSamples);
+
+    //==============================================================================
+    /** Creates an encoder and starts its thread.
+        The queue holds queueSizeSamples of audio before write() has to wait.
+    */
+    StreamingEncoder (std::vector<std::unique_ptr<Codec>>, int numChannels, int queueSizeSamples);
+
+    /** Destructor. If finish() hasn't been called, this cancels the encoding. */
+    ~StreamingEncoder() override;
+
+    /** Adds some audio to the queue, waiting for space if it's full.
+        Only one thread should call this.
+        Returns false if one of the codecs has failed.
+    */
+    bool write (const juce::AudioBuffer<float>&, int startSample, int numSamples);
+
+    /** Waits for all the queued audio to be encoded, then finishes the codecs and
+        deletes them. Returns false if any of them failed.
+    */
+    bool finish();
+
+    /** Stops encoding and deletes the codecs without finishing them, dropping anything
+        left in the queue.
+    */
+    void cancel();
+
+    /** Returns true if one of the codecs has failed. */
+    bool hasFailed() const noexcept             { return failed; }
+
+private:
+    //==============================================================================
+    std::vector<std::unique_ptr<Codec>> codecs;
+    AudioFifo fifo;
+    juce::WaitableEvent dataAvailable, spaceAvailable;
+    std::atomic<bool> inputFinished { false }, failed { false };
+    bool hasStopped = false;
+
+    void run() override;
+    bool encodeQueuedAudio (juce::AudioBuffer<float>&);
+    void stop();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingEncoder)
+};
+
+} // namespace tracktion_engine
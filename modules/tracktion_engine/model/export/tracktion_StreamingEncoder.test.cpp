@@ -0,0 +1,367 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class StreamingEncoderTests  : public juce::UnitTest
+{
+public:
+    StreamingEncoderTests()
+        : juce::UnitTest ("StreamingEncoder", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        beginTest ("All audio reaches every codec in order");
+        {
+            auto source = createRamp (2, 100000);
+            auto first = std::make_unique<RecordingCodec> (2);
+            auto second = std::make_unique<RecordingCodec> (2);
+            second->sleepMsPerBlock = 1; // Slower than the writes so the queue fills up
+            auto firstResult = first->result, secondResult = second->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (std::move (first));
+            codecs.push_back (std::move (second));
+            StreamingEncoder encoder (std::move (codecs), 2, 8192);
+
+            for (int start = 0; start < source.getNumSamples(); start += 1000)
+                expect (encoder.write (source, start, juce::jmin (1000, source.getNumSamples() - start)));
+
+            expect (encoder.finish());
+            expect (! encoder.hasFailed());
+
+            for (auto result : { firstResult, secondResult })
+            {
+                expect (result->finished);
+                expect (isSameAudio (result->received, source));
+            }
+        }
+
+        beginTest ("A failing codec stops the writes");
+        {
+            auto source = createRamp (1, 50000);
+            auto codec = std::make_unique<RecordingCodec> (1);
+            codec->failAfterNumSamples = 10000;
+            auto result = codec->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (std::move (codec));
+            StreamingEncoder encoder (std::move (codecs), 1, 4096);
+
+            bool writeFailed = false;
+
+            for (int start = 0; start < source.getNumSamples() && ! writeFailed; start += 1000)
+                writeFailed = ! encoder.write (source, start, 1000);
+
+            expect (! encoder.finish());
+            expect (encoder.hasFailed());
+            expect (! result->finished);
+        }
+
+        beginTest ("Cancelling doesn't finish the codecs");
+        {
+            auto source = createRamp (1, 10000);
+            auto codec = std::make_unique<RecordingCodec> (1);
+            auto result = codec->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (std::move (codec));
+
+            {
+                StreamingEncoder encoder (std::move (codecs), 1, 4096);
+                encoder.write (source, 0, 2000);
+                encoder.cancel();
+                expect (! encoder.write (source, 2000, 1000));
+            }
+
+            expect (! result->finished);
+        }
+
+        beginTest ("Resampling");
+        {
+            const double sourceRate = 48000.0, destRate = 44100.0, frequency = 1000.0;
+            juce::AudioBuffer<float> source (1, 48000);
+
+            for (int i = 0; i < source.getNumSamples(); ++i)
+                source.setSample (0, i, 0.5f * (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i / sourceRate));
+
+            auto codec = std::make_unique<RecordingCodec> (1);
+            auto result = codec->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (StreamingEncoder::createConvertingCodec (std::move (codec), 1, sourceRate, destRate, 0));
+
+            {
+                StreamingEncoder encoder (std::move (codecs), 1, 4096);
+
+                // Uneven blocks so the resampler has input left over between them
+                for (int start = 0; start < source.getNumSamples(); start += 777)
+                    expect (encoder.write (source, start, juce::jmin (777, source.getNumSamples() - start)));
+
+                expect (encoder.finish());
+            }
+
+            auto& received = result->received;
+            expect (result->finished);
+            expectEquals (received.getNumSamples(), 44100);
+
+            // Still a 1kHz sine at the same level, away from the edges
+            expectWithinAbsoluteError (received.getRMSLevel (0, 1000, 40000), 0.5f / std::sqrt (2.0f), 0.01f);
+
+            int numCrossings = 0;
+
+            for (int i = 1001; i < 41000; ++i)
+                if ((received.getSample (0, i - 1) < 0.0f) != (received.getSample (0, i) < 0.0f))
+                    ++numCrossings;
+
+            expectWithinAbsoluteError (numCrossings, juce::roundToInt (2.0 * frequency * 40000 / destRate), 2);
+        }
+
+        beginTest ("Downsampling doesn't alias");
+        {
+            // Above the new Nyquist frequency, so this would alias to 21.1kHz without filtering
+            const double sourceRate = 48000.0, destRate = 44100.0, frequency = 23000.0;
+            juce::AudioBuffer<float> source (1, 48000);
+
+            for (int i = 0; i < source.getNumSamples(); ++i)
+                source.setSample (0, i, 0.5f * (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i / sourceRate));
+
+            auto codec = std::make_unique<RecordingCodec> (1);
+            auto result = codec->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (StreamingEncoder::createConvertingCodec (std::move (codec), 1, sourceRate, destRate, 0));
+
+            {
+                StreamingEncoder encoder (std::move (codecs), 1, 4096);
+                expect (encoder.write (source, 0, source.getNumSamples()));
+                expect (encoder.finish());
+            }
+
+            auto& received = result->received;
+            expectEquals (received.getNumSamples(), 44100);
+
+            // Skip the filter settling at the start
+            expectLessThan (received.getRMSLevel (0, 1000, 40000), 0.5f * juce::Decibels::decibelsToGain (-60.0f));
+        }
+
+        beginTest ("Dithering without resampling");
+        {
+            auto source = createRamp (2, 10000);
+            auto codec = std::make_unique<RecordingCodec> (2);
+            auto result = codec->result;
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (StreamingEncoder::createConvertingCodec (std::move (codec), 2, 44100.0, 44100.0, 16));
+
+            {
+                StreamingEncoder encoder (std::move (codecs), 2, 4096);
+                expect (encoder.write (source, 0, source.getNumSamples()));
+                expect (encoder.finish());
+            }
+
+            auto& received = result->received;
+            expectEquals (received.getNumSamples(), source.getNumSamples());
+            expect (! isSameAudio (received, source));
+
+            expectLessThan (audio_test_utilities::getMaxDifference (received, source), 8.0f / 32768.0f);
+        }
+
+        beginTest ("Writing a file");
+        {
+            auto& engine = *Engine::getEngines().getFirst();
+            auto source = createRamp (2, 44100);
+            juce::WavAudioFormat format;
+            juce::TemporaryFile tempFile (".wav");
+
+            auto writer = std::make_unique<AudioFileWriter> (AudioFile (engine, tempFile.getFile()), &format,
+                                                             2, 44100.0, 32, juce::StringPairArray(), 0);
+            auto codec = StreamingEncoder::createWriterCodec (std::move (writer));
+            expect (codec != nullptr);
+
+            std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+            codecs.push_back (std::move (codec));
+
+            {
+                StreamingEncoder encoder (std::move (codecs), 2, 8192);
+                expect (encoder.write (source, 0, source.getNumSamples()));
+                expect (encoder.finish());
+            }
+
+            std::unique_ptr<juce::AudioFormatReader> reader (format.createReaderFor (tempFile.getFile().createInputStream().release(), true));
+            expect (reader != nullptr);
+
+            if (reader != nullptr)
+            {
+                expectEquals (reader->lengthInSamples, (juce::int64) source.getNumSamples());
+
+                juce::AudioBuffer<float> read (2, source.getNumSamples());
+                reader->read (&read, 0, read.getNumSamples(), 0, true, true);
+                expectWithinAbsoluteError (read.getSample (1, 30000), source.getSample (1, 30000), 1.0e-6f);
+            }
+        }
+
+        beginTest ("Additional outputs are trimmed and normalised with the main file");
+        {
+            auto& engine = *Engine::getEngines().getFirst();
+            auto& dm = engine.getDeviceManager();
+            const double sampleRate = dm.getSampleRate();
+            auto sinFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (sampleRate, 1.0);
+
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto track = getAudioTracks (*edit)[0];
+            auto clip = track->insertWaveClip ("sin", sinFile->getFile(), { { 1.0, 2.0 } }, false);
+            clip->setGainDB (-12.0f);
+
+            juce::WavAudioFormat format;
+            juce::TemporaryFile mainFile (".wav"), sameRateFile (".wav"), halfRateFile (".wav");
+
+            Renderer::Parameters r (*edit);
+            r.tracksToDo.setBit (track->getIndexInEditTrackList());
+            r.destFile = mainFile.getFile();
+            r.audioFormat = &format;
+            r.bitDepth = 32;
+            r.blockSizeForAudio = dm.getBlockSize();
+            r.sampleRateForAudio = sampleRate;
+            r.time = { 0.0, 3.0 };
+            r.canRenderInMono = false;
+            r.trimSilenceAtEnds = true;
+            r.shouldNormalise = true;
+
+            Renderer::Parameters::AdditionalOutput sameRate;
+            sameRate.destFile = sameRateFile.getFile();
+            sameRate.audioFormat = &format;
+            sameRate.bitDepth = 24;
+            sameRate.ditheringEnabled = true;
+            r.additionalOutputs.push_back (sameRate);
+
+            auto halfRate = sameRate;
+            halfRate.destFile = halfRateFile.getFile();
+            halfRate.bitDepth = 32;
+            halfRate.ditheringEnabled = false;
+            halfRate.sampleRate = sampleRate / 2.0;
+            r.additionalOutputs.push_back (halfRate);
+
+            expect (Renderer::renderToFile ({}, r) == r.destFile);
+
+            auto main = readFile (format, mainFile.getFile());
+            auto same = readFile (format, sameRateFile.getFile());
+            auto half = readFile (format, halfRateFile.getFile());
+
+            // The silence either side of the clip has been trimmed from all of them
+            expect (main.getNumSamples() > 0);
+            expectLessThan (main.getNumSamples(), juce::roundToInt (1.5 * sampleRate));
+            expectEquals (same.getNumSamples(), main.getNumSamples());
+            expectWithinAbsoluteError (half.getNumSamples(), juce::roundToInt (main.getNumSamples() / 2.0), 1);
+
+            // And they've all been normalised
+            expectWithinAbsoluteError (main.getMagnitude (0, main.getNumSamples()), 1.0f, 0.01f);
+            expectWithinAbsoluteError (same.getMagnitude (0, same.getNumSamples()), 1.0f, 0.01f);
+            expectWithinAbsoluteError (half.getMagnitude (0, half.getNumSamples()), 1.0f, 0.05f);
+
+            engine.getAudioFileManager().releaseAllFiles();
+            edit->getTempDirectory (false).deleteRecursively();
+        }
+    }
+
+private:
+    //==============================================================================
+    /** Keeps everything it's given. The result outlives the codec, which the encoder deletes. */
+    struct RecordingCodec  : public StreamingEncoder::Codec
+    {
+        struct Result
+        {
+            juce::AudioBuffer<float> received;
+            bool finished = false;
+        };
+
+        RecordingCodec (int numChannels)
+        {
+            result->received.setSize (numChannels, 0);
+        }
+
+        bool encode (const juce::AudioBuffer<float>& buffer, int numSamples) override
+        {
+            auto& received = result->received;
+            const int numReceived = received.getNumSamples();
+
+            if (failAfterNumSamples >= 0 && numReceived + numSamples > failAfterNumSamples)
+                return false;
+
+            received.setSize (received.getNumChannels(), numReceived + numSamples, true);
+
+            for (int chan = 0; chan < received.getNumChannels(); ++chan)
+                received.copyFrom (chan, numReceived, buffer, chan, 0, numSamples);
+
+            if (sleepMsPerBlock > 0)
+                juce::Thread::sleep (sleepMsPerBlock);
+
+            return true;
+        }
+
+        bool finish() override
+        {
+            result->finished = true;
+            return true;
+        }
+
+        std::shared_ptr<Result> result { std::make_shared<Result>() };
+        int failAfterNumSamples = -1, sleepMsPerBlock = 0;
+    };
+
+    static juce::AudioBuffer<float> readFile (juce::AudioFormat& format, const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (format.createReaderFor (file.createInputStream().release(), true));
+
+        if (reader == nullptr)
+            return {};
+
+        juce::AudioBuffer<float> buffer ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+
+        return buffer;
+    }
+
+    static bool isSameAudio (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return false;
+
+        for (int chan = 0; chan < a.getNumChannels(); ++chan)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                if (a.getSample (chan, i) != b.getSample (chan, i))
+                    return false;
+
+        return true;
+    }
+
+    static juce::AudioBuffer<float> createRamp (int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (chan, i, (i % 1000) / 1000.0f - (float) chan * 0.25f);
+
+        return buffer;
+    }
+};
+
+static StreamingEncoderTests streamingEncoderTests;
+
+#endif
+
+} // namespace tracktion_engine
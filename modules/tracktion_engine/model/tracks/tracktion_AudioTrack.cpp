@@ -862,6 +862,9 @@ AudioTrack::FreezePointRemovalInhibitor::~FreezePointRemovalInhibitor()
 
 void AudioTrack::freezeTrack()
 {
+    // The muting and soloing changed here don't affect the freeze file
+    const EditChangeTracker::ScopedIgnore sci (edit);
+
     insertFreezePointIfRequired();
     const FreezePointPlugin::ScopedPluginDisabler spd (*this, Range<int> (getIndexOfFreezePoint(),
                                                                           pluginList.size()));
@@ -874,12 +877,9 @@ void AudioTrack::freezeTrack()
 
     BigInteger trackNum;
     trackNum.setBit (getIndexInEditTrackList());
-    auto freezeFile = getFreezeFile();
-    freezeFile.deleteFile();
-
     Renderer::Parameters r (edit);
     r.tracksToDo = trackNum;
-    r.destFile = freezeFile;
+    r.destFile = getFreezeFile();
     r.audioFormat = edit.engine.getAudioFileFormatManager().getFrozenFileFormat();
     r.blockSizeForAudio = dm.getBlockSize();
     r.sampleRateForAudio = dm.getSampleRate();
@@ -890,6 +890,7 @@ void AudioTrack::freezeTrack()
     r.useMasterPlugins = false;
     r.addAntiDenormalisationNoise = EditPlaybackContext::shouldAddAntiDenormalisationNoise (edit.engine);
     r.category = ProjectItem::Category::frozen;
+    r.allowIncrementalRender = true;
 
     const Edit::ScopedRenderStatus srs (edit, true);
     const auto desc = TRANS("Creating track freeze for \"XDVX\"")
@@ -0,0 +1,681 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace
+{
+    template<typename Fn>
+    void forEachPluginOnTrack (AudioTrack& at, Fn&& fn)
+    {
+        for (auto p : at.pluginList)
+            fn (*p);
+
+        for (auto c : at.getClips())
+            if (auto pluginList = c->getPluginList())
+                for (auto p : *pluginList)
+                    fn (*p);
+    }
+
+    bool isTrackOrFolder (const juce::ValueTree& v)
+    {
+        return v.hasType (IDs::TRACK) || v.hasType (IDs::FOLDERTRACK);
+    }
+
+    /** Removes all the tracks apart from the given one and the folders it's in. */
+    bool removeOtherTracks (juce::ValueTree& v, EditItemID trackID)
+    {
+        bool containsTrack = false;
+
+        for (int i = v.getNumChildren(); --i >= 0;)
+        {
+            auto child = v.getChild (i);
+
+            if (! isTrackOrFolder (child))
+                continue;
+
+            if (EditItemID::fromID (child) == trackID || removeOtherTracks (child, trackID))
+            {
+                // The muting is applied live so the render needs to be audible
+                child.removeProperty (IDs::mute, nullptr);
+                child.removeProperty (IDs::solo, nullptr);
+                child.removeProperty (IDs::soloIsolate, nullptr);
+                containsTrack = true;
+            }
+            else
+            {
+                v.removeChild (i, nullptr);
+            }
+        }
+
+        return containsTrack;
+    }
+
+    /** Removes the tracks and folders from the top level of an Edit's state and returns them. */
+    juce::Array<juce::ValueTree> removeTracks (juce::ValueTree& editState)
+    {
+        juce::Array<juce::ValueTree> tracks;
+
+        for (int i = editState.getNumChildren(); --i >= 0;)
+        {
+            auto child = editState.getChild (i);
+
+            if (isTrackOrFolder (child))
+            {
+                tracks.insert (0, child);
+                editState.removeChild (i, nullptr);
+            }
+        }
+
+        return tracks;
+    }
+
+    bool isSameExternalPlugin (const juce::ValueTree& a, const juce::ValueTree& b)
+    {
+        for (auto& id : { IDs::type, IDs::uniqueId, IDs::uid, IDs::filename, IDs::separateProcess })
+            if (a[id] != b[id])
+                return false;
+
+        return true;
+    }
+
+    /** Swaps the states of any external plugins in the tracks for the ones already loaded in
+        the Edit so the Edit reuses them when the tracks are added to it.
+        Returns the plugins whose state needs restoring.
+    */
+    Plugin::Array reuseExternalPlugins (Edit& ed, const juce::Array<juce::ValueTree>& tracks)
+    {
+        Plugin::Array pluginsToRestore;
+
+        for (auto& track : tracks)
+        {
+            juce::Array<juce::ValueTree> children;
+            getChildTreesRecursive (children, track);
+
+            for (auto v : getTreesOfType (children, IDs::PLUGIN))
+            {
+                if (v[IDs::type].toString() != ExternalPlugin::xmlTypeName)
+                    continue;
+
+                auto existing = ed.getPluginCache().getPluginFor (EditItemID::fromID (v));
+
+                if (dynamic_cast<ExternalPlugin*> (existing.get()) == nullptr
+                     || ! isSameExternalPlugin (existing->state, v))
+                    continue;
+
+                const bool stateChanged = existing->state[IDs::state] != v[IDs::state]
+                                            || existing->state[IDs::programNum] != v[IDs::programNum];
+
+                auto existingState = existing->state;
+                existingState.getParent().removeChild (existingState, nullptr);
+
+                auto parent = v.getParent();
+                const int index = parent.indexOf (v);
+                parent.removeChild (index, nullptr);
+                parent.addChild (existingState, index, nullptr);
+                copyValueTree (existingState, v, nullptr);
+
+                if (stateChanged)
+                    pluginsToRestore.add (existing);
+            }
+        }
+
+        return pluginsToRestore;
+    }
+}
+
+//==============================================================================
+AutoFreezer::AutoFreezer (Edit& e)
+    : AutoFreezer (e, e.engine.getEngineBehaviour().getAutoFreezeDelaySeconds())
+{
+}
+
+AutoFreezer::AutoFreezer (Edit& e, double delaySeconds)
+    : edit (e),
+      delayMs ((juce::uint32) juce::roundToInt (1000.0 * delaySeconds))
+{
+    edit.state.addListener (this);
+    markAllChanged();
+
+    // Check a few times per delay so short delays aren't overshot by much
+    startTimer (juce::jlimit (50, 1000, (int) delayMs / 4));
+}
+
+AutoFreezer::~AutoFreezer()
+{
+    stopTimer();
+    cancelPendingUpdate();
+    edit.state.removeListener (this);
+    cancelRender();
+    releaseRenderEdit();
+}
+
+//==============================================================================
+juce::File AutoFreezer::getFrozenFile (AudioTrack& at)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        auto s = getTrackState (at.itemID);
+
+        if (s == nullptr || ! s->isFrozen)
+            return {};
+    }
+
+    // Routing changes rebuild the graph straight away so check this here rather than waiting for the timer
+    if (! canTrackBeFrozen (at))
+        return {};
+
+    const juce::ScopedLock sl (lock);
+
+    if (auto s = getTrackState (at.itemID))
+        return s->isFrozen ? s->renderedFile : juce::File();
+
+    return {};
+}
+
+int AutoFreezer::getNumFrozenTracks() const
+{
+    const juce::ScopedLock sl (lock);
+    int num = 0;
+
+    for (auto& s : trackStates)
+        if (s.isFrozen)
+            ++num;
+
+    return num;
+}
+
+double AutoFreezer::getEstimatedCpuSaving() const
+{
+    const juce::ScopedLock sl (lock);
+    double total = 0.0;
+
+    for (auto& s : trackStates)
+        if (s.isFrozen)
+            total += s.renderCpuProportion;
+
+    return total;
+}
+
+bool AutoFreezer::isUsingFile (const juce::File& f) const
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto& s : trackStates)
+        if (s.renderedFile == f)
+            return true;
+
+    return false;
+}
+
+//==============================================================================
+bool AutoFreezer::canTrackBeFrozen (AudioTrack& at)
+{
+    if (! at.isProcessing (true) || at.isFrozen (Track::anyFreeze) || at.getClips().isEmpty())
+        return false;
+
+    for (auto c : at.getClips())
+    {
+        if (auto acb = dynamic_cast<AudioClipBase*> (c))
+        {
+            // A proxy that hasn't finished rendering would be rendered as silence
+            if (acb->isUsingMelodyne() || ! acb->getPlaybackFile().isValid())
+                return false;
+        }
+    }
+
+    return canTrackBeProcessedIndependently (at);
+}
+
+void AutoFreezer::pluginChanged (Plugin& p)
+{
+    auto track = p.getOwnerTrack();
+
+    if (track == nullptr)
+        if (auto clip = p.getOwnerClip())
+            track = clip->getTrack();
+
+    if (track == nullptr)
+        return;
+
+    // Some plugin state isn't in the Edit until it's flushed so this can't be hashed.
+    // Treat it as a change that also invalidates the previous render.
+    bool wasFrozen = false;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (auto s = getTrackState (track->itemID))
+        {
+            wasFrozen = s->isFrozen;
+            invalidate (*s);
+        }
+    }
+
+    if (renderingTrackID == track->itemID)
+        cancelRender();
+
+    if (wasFrozen)
+        edit.restartPlayback();
+}
+
+//==============================================================================
+AutoFreezer::TrackState* AutoFreezer::getTrackState (EditItemID trackID)
+{
+    for (auto& s : trackStates)
+        if (s.trackID == trackID)
+            return &s;
+
+    return nullptr;
+}
+
+AutoFreezer::TrackState& AutoFreezer::getOrCreateTrackState (EditItemID trackID)
+{
+    if (auto s = getTrackState (trackID))
+        return *s;
+
+    trackStates.push_back ({});
+    trackStates.back().trackID = trackID;
+
+    return trackStates.back();
+}
+
+void AutoFreezer::trackChanged (const juce::ValueTree& v)
+{
+    for (auto t = v; t.isValid(); t = t.getParent())
+    {
+        if (TrackList::isTrack (t))
+        {
+            markChanged (EditItemID::fromID (t));
+            return;
+        }
+
+        if (t.hasType (IDs::TEMPOSEQUENCE) || t.hasType (IDs::PITCHSEQUENCE))
+        {
+            markAllChanged();
+            return;
+        }
+    }
+}
+
+void AutoFreezer::markChanged (EditItemID trackID)
+{
+    changedTracks.addIfNotAlreadyThere (trackID);
+    triggerAsyncUpdate();
+}
+
+void AutoFreezer::markAllChanged()
+{
+    for (auto at : getAudioTracks (edit))
+        markChanged (at->itemID);
+}
+
+void AutoFreezer::invalidate (TrackState& s)
+{
+    s.lastChangeTime = juce::Time::getMillisecondCounter();
+    s.renderedHash = 0;
+    s.isFrozen = false;
+}
+
+//==============================================================================
+juce::int64 AutoFreezer::calculateEditHash() const
+{
+    return edit.tempoSequence.getState().toXmlString().hashCode64() * 3
+            ^ edit.pitchSequence.state.toXmlString().hashCode64() * 5;
+}
+
+juce::int64 AutoFreezer::calculateHash (AudioTrack& at) const
+{
+    auto trackState = at.state.createCopy();
+
+    // These are applied live or only affect the UI so shouldn't need a new render
+    for (auto& id : { IDs::mute, IDs::solo, IDs::soloIsolate, IDs::name, IDs::colour, IDs::height, IDs::expanded })
+        trackState.removeProperty (id, nullptr);
+
+    juce::int64 h = trackState.toXmlString().hashCode64();
+    h ^= calculateEditHash();
+    h ^= juce::String (edit.engine.getDeviceManager().getSampleRate()).hashCode64() * 7;
+
+    // The source files could be changed without changing the Edit
+    for (auto c : at.getClips())
+    {
+        if (auto acb = dynamic_cast<AudioClipBase*> (c))
+        {
+            auto file = acb->getPlaybackFile().getFile();
+            h ^= (file.getFullPathName() + juce::String (file.getLastModificationTime().toMilliseconds())).hashCode64();
+        }
+    }
+
+    return h;
+}
+
+bool AutoFreezer::updateHash (AudioTrack& at)
+{
+    const auto newHash = calculateHash (at);
+    bool frozenStateChanged = false;
+
+    {
+        const juce::ScopedLock sl (lock);
+        auto& s = getOrCreateTrackState (at.itemID);
+
+        if (newHash == s.hash)
+            return false;
+
+        s.hash = newHash;
+        s.lastChangeTime = juce::Time::getMillisecondCounter();
+
+        // If this has been changed back to a state that's already been rendered, e.g. by an undo, reuse the render
+        const bool wasFrozen = s.isFrozen;
+        s.isFrozen = s.renderedHash == newHash && s.renderedFile.existsAsFile();
+        frozenStateChanged = wasFrozen != s.isFrozen;
+    }
+
+    if (renderingTrackID == at.itemID)
+        cancelRender();
+
+    return frozenStateChanged;
+}
+
+//==============================================================================
+bool AutoFreezer::isRenderEditInUse()
+{
+    // Until it's stopped running, the job also holds a reference to itself
+    if (finishingJob != nullptr && finishingJob->getReferenceCount() > 1)
+        return true;
+
+    finishingJob = nullptr;
+    return false;
+}
+
+Edit* AutoFreezer::getRenderEditFor (AudioTrack& at)
+{
+    auto state = edit.state.createCopy();
+    removeOtherTracks (state, at.itemID);
+
+    // Nothing else uses these so don't load the plugins
+    state.getOrCreateChildWithName (IDs::MASTERPLUGINS, nullptr).removeAllChildren (nullptr);
+    state.getOrCreateChildWithName (IDs::RACKS, nullptr).removeAllChildren (nullptr);
+
+    const auto editHash = calculateEditHash();
+
+    if (renderEdit != nullptr && renderEditHash == editHash)
+    {
+        auto tracks = removeTracks (state);
+        auto pluginsToRestore = reuseExternalPlugins (*renderEdit, tracks);
+        removeTracks (renderEdit->state);
+
+        for (auto& t : tracks)
+            renderEdit->state.addChild (t, -1, nullptr);
+
+        for (auto p : pluginsToRestore)
+            p->restorePluginStateFromValueTree (p->state);
+
+        return renderEdit.get();
+    }
+
+    releaseRenderEdit();
+
+    Edit::Options options { edit.engine, state, edit.getProjectItemID() };
+    options.role = Edit::forRendering;
+    options.numUndoLevelsToStore = 0;
+    options.editFileRetriever = edit.editFileRetriever;
+    options.filePathResolver = edit.filePathResolver;
+
+    renderEdit = std::make_unique<Edit> (options);
+    renderEditHash = editHash;
+
+    return renderEdit.get();
+}
+
+bool AutoFreezer::startRender (AudioTrack& at, TrackState& s)
+{
+    CRASH_TRACER
+    jassert (renderJob == nullptr);
+
+    if (isRenderEditInUse())
+        return false;
+
+    // Make sure the copy has the latest state of any plugins that have changed
+    forEachPluginOnTrack (at, [this] (Plugin& p) { edit.flushPluginStateIfNeeded (p); });
+
+    {
+        const juce::ScopedLock sl (lock);
+        s.hash = calculateHash (at);
+    }
+
+    const auto destFile = TemporaryFileManager::getAutoFreezeFileForTrack (at, s.hash);
+
+    // A cancelled job for the same file may still be finishing
+    if (edit.engine.getRenderManager().getRenderJobWithoutCreating (AudioFile (edit.engine, destFile)) != nullptr)
+        return false;
+
+    auto renderTrack = findTrackForID (*getRenderEditFor (at), at.itemID);
+
+    if (renderTrack == nullptr)
+    {
+        jassertfalse;
+        return false;
+    }
+
+    juce::BigInteger tracksToDo;
+    tracksToDo.setBit (renderTrack->getIndexInEditTrackList());
+
+    auto& dm = edit.engine.getDeviceManager();
+
+    Renderer::Parameters r (*renderEdit);
+    r.tracksToDo = tracksToDo;
+    r.destFile = destFile;
+    r.audioFormat = edit.engine.getAudioFileFormatManager().getFrozenFileFormat();
+    r.blockSizeForAudio = dm.getBlockSize();
+    r.sampleRateForAudio = dm.getSampleRate();
+    r.time = { 0.0, at.getLengthIncludingInputTracks() };
+    r.canRenderInMono = false;
+    r.mustRenderInMono = false;
+    r.usePlugins = true;
+    r.useMasterPlugins = false;
+    r.addAntiDenormalisationNoise = EditPlaybackContext::shouldAddAntiDenormalisationNoise (edit.engine);
+    r.category = ProjectItem::Category::none;
+    r.edit = renderEdit.get();
+
+    renderJob = EditRenderJob::getOrCreateRenderJob (edit.engine, r, false, false, false);
+
+    if (renderJob == nullptr)
+        return false;
+
+    renderJob->setName (TRANS("Freezing") + ": " + at.getName());
+    renderJob->addListener (this);
+    renderingTrackID = at.itemID;
+    renderingHash = s.hash;
+    renderStartTime = juce::Time::getMillisecondCounterHiRes();
+
+    return true;
+}
+
+void AutoFreezer::cancelRender()
+{
+    if (renderJob == nullptr)
+        return;
+
+    // Keep hold of the job so the render Edit isn't changed until it's finished with it
+    renderJob->removeListener (this);
+    renderJob->cancelJob();
+    finishingJob = renderJob;
+    renderJob = nullptr;
+    renderingTrackID = {};
+}
+
+void AutoFreezer::releaseRenderEdit()
+{
+    if (finishingJob != nullptr)
+    {
+        // The job's deleted on the message thread so make sure it's stopped and let go of
+        // it before the Edit it's using is deleted
+        edit.engine.getBackgroundJobs().removeJob (finishingJob.get(), true, 10000);
+        finishingJob->cleanUpDanglingJob();
+        finishingJob = nullptr;
+    }
+
+    renderEdit.reset();
+}
+
+//==============================================================================
+void AutoFreezer::valueTreePropertyChanged (juce::ValueTree& v, const juce::Identifier&)
+{
+    trackChanged (v);
+}
+
+void AutoFreezer::valueTreeChildAdded (juce::ValueTree& p, juce::ValueTree& c)
+{
+    if (TrackList::isTrack (c))
+        markChanged (EditItemID::fromID (c));
+    else
+        trackChanged (p);
+}
+
+void AutoFreezer::valueTreeChildRemoved (juce::ValueTree& p, juce::ValueTree& c, int)
+{
+    if (TrackList::isTrack (c))
+        markChanged (EditItemID::fromID (c));
+    else
+        trackChanged (p);
+}
+
+void AutoFreezer::valueTreeChildOrderChanged (juce::ValueTree& p, int, int)
+{
+    trackChanged (p);
+}
+
+void AutoFreezer::handleAsyncUpdate()
+{
+    CRASH_TRACER
+    auto tracksToUpdate = std::move (changedTracks);
+    changedTracks.clear();
+    bool needsRestart = false;
+
+    for (auto trackID : tracksToUpdate)
+    {
+        if (auto at = dynamic_cast<AudioTrack*> (findTrackForID (edit, trackID)))
+        {
+            needsRestart = updateHash (*at) || needsRestart;
+        }
+        else
+        {
+            if (renderingTrackID == trackID)
+                cancelRender();
+
+            // The file will be removed by TemporaryFileManager::purgeOrphanFreezeAndProxyFiles
+            const juce::ScopedLock sl (lock);
+            trackStates.erase (std::remove_if (trackStates.begin(), trackStates.end(),
+                                               [trackID] (const TrackState& s) { return s.trackID == trackID; }),
+                               trackStates.end());
+        }
+    }
+
+    if (needsRestart)
+        edit.restartPlayback();
+}
+
+void AutoFreezer::timerCallback()
+{
+    if (isUpdatePending() || edit.getIsPreviewEdit())
+        return;
+
+    const auto now = juce::Time::getMillisecondCounter();
+    bool needsRestart = false;
+
+    for (auto at : getAudioTracks (edit))
+    {
+        auto s = getTrackState (at->itemID);
+
+        if (s == nullptr)
+            continue;
+
+        if (s->isFrozen)
+        {
+            if (! canTrackBeFrozen (*at))
+            {
+                const juce::ScopedLock sl (lock);
+                s->isFrozen = false;
+                needsRestart = true;
+            }
+
+            continue;
+        }
+
+        if (now - s->lastChangeTime < delayMs || ! canTrackBeFrozen (*at))
+            continue;
+
+        if (s->renderedHash == s->hash && s->renderedFile.existsAsFile())
+        {
+            // The track's become eligible again
+            const juce::ScopedLock sl (lock);
+            s->isFrozen = true;
+            needsRestart = true;
+        }
+        else if (renderJob == nullptr && ! edit.getTransport().isRecording())
+        {
+            // Only render one track at a time to leave the other cores free
+            startRender (*at, *s);
+        }
+    }
+
+    if (needsRestart)
+        edit.restartPlayback();
+}
+
+void AutoFreezer::jobStarted (RenderManager::Job& job)
+{
+    if (&job == renderJob.get())
+        renderStartTime = juce::Time::getMillisecondCounterHiRes();
+}
+
+void AutoFreezer::jobFinished (RenderManager::Job& job, bool completedOk)
+{
+    CRASH_TRACER
+
+    if (&job != renderJob.get())
+        return;
+
+    const auto renderSeconds = (juce::Time::getMillisecondCounterHiRes() - renderStartTime) / 1000.0;
+    const auto trackID = renderingTrackID;
+    const auto hash = renderingHash;
+    cancelRender();
+
+    auto at = dynamic_cast<AudioTrack*> (findTrackForID (edit, trackID));
+    auto s = getTrackState (trackID);
+
+    if (! completedOk || at == nullptr || s == nullptr || s->hash != hash)
+        return;
+
+    const auto file = TemporaryFileManager::getAutoFreezeFileForTrack (*at, hash);
+
+    if (! file.existsAsFile())
+        return;
+
+    const auto length = at->getLengthIncludingInputTracks();
+    const auto previousFile = s->renderedFile;
+
+    {
+        const juce::ScopedLock sl (lock);
+        s->renderedFile = file;
+        s->renderedHash = hash;
+        s->renderCpuProportion = length > 0.0 ? renderSeconds / length : 0.0;
+        s->isFrozen = canTrackBeFrozen (*at);
+    }
+
+    if (previousFile != juce::File() && previousFile != file)
+        AudioFile (edit.engine, previousFile).deleteFile();
+
+    if (s->isFrozen)
+        edit.restartPlayback();
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,145 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Freezes tracks in the background once they've stopped changing.
+
+    Each AudioTrack's state (clips, plugins, automation and the tempo and pitch
+    sequences it plays against) is hashed whenever it changes. Once a track's hash has
+    stayed the same for EngineBehaviour::getAutoFreezeDelaySeconds(), a copy of it is
+    rendered by the RenderManager's threads and playback switches to the rendered file.
+    Any change to the track switches it straight back to live playback and a new render
+    starts once it's settled again. If the track is changed back, e.g. by an undo, the
+    previous render is reused.
+
+    This is separate from the user-facing individual freeze and doesn't change any of
+    the Edit's state. Only tracks that can be processed independently of the rest of
+    the Edit are frozen, i.e. without live inputs, sends, racks or tracks feeding them.
+
+    The copy of the track is rendered in a separate Edit which is kept between renders.
+    If the tempo and pitch sequences haven't changed, the next track is swapped into it
+    and any external plugins it's already loaded are reused rather than instantiated again.
+
+    The Edit creates one of these if auto-freezing is enabled.
+    @see Edit::getAutoFreezer
+*/
+class AutoFreezer   : private juce::ValueTree::Listener,
+                      private juce::AsyncUpdater,
+                      private juce::Timer,
+                      private RenderManager::Job::Listener
+{
+public:
+    /** Creates an AutoFreezer for an Edit using EngineBehaviour::getAutoFreezeDelaySeconds(). */
+    AutoFreezer (Edit&);
+
+    /** Creates an AutoFreezer for an Edit that freezes tracks once they haven't changed
+        for the given number of seconds.
+    */
+    AutoFreezer (Edit&, double delaySeconds);
+
+    /** Destructor. */
+    ~AutoFreezer() override;
+
+    //==============================================================================
+    /** Returns the file the track should be played back from, or a null file if it
+        should be played live.
+        This can be called from any thread.
+    */
+    juce::File getFrozenFile (AudioTrack&);
+
+    /** Returns the number of tracks currently being played back from a render. */
+    int getNumFrozenTracks() const;
+
+    /** Returns an estimate of the CPU being saved, as a proportion of a single core.
+        This is the sum of the time each frozen track took to render divided by its length,
+        which is roughly the load the track would have added to the audio callback.
+    */
+    double getEstimatedCpuSaving() const;
+
+    /** Returns true if a render is currently in progress. */
+    bool isRendering() const noexcept               { return renderJob != nullptr; }
+
+    //==============================================================================
+    /** Returns true if the track could be automatically frozen. */
+    static bool canTrackBeFrozen (AudioTrack&);
+
+    /** Called by the Edit when a plugin's state has changed. */
+    void pluginChanged (Plugin&);
+
+    /** Returns true if the file is a current render for one of the tracks. */
+    bool isUsingFile (const juce::File&) const;
+
+private:
+    //==============================================================================
+    struct TrackState
+    {
+        EditItemID trackID;
+        juce::int64 hash = 0;
+        juce::uint32 lastChangeTime = 0;
+
+        juce::File renderedFile;
+        juce::int64 renderedHash = 0;
+        double renderCpuProportion = 0.0;
+        bool isFrozen = false;
+    };
+
+    Edit& edit;
+    const juce::uint32 delayMs;
+    mutable juce::CriticalSection lock;
+    std::vector<TrackState> trackStates;
+    juce::Array<EditItemID> changedTracks;
+
+    std::unique_ptr<Edit> renderEdit;
+    juce::int64 renderEditHash = 0;
+    RenderManager::Job::Ptr renderJob, finishingJob;
+    EditItemID renderingTrackID;
+    juce::int64 renderingHash = 0;
+    double renderStartTime = 0.0;
+
+    //==============================================================================
+    TrackState* getTrackState (EditItemID);
+    TrackState& getOrCreateTrackState (EditItemID);
+
+    void trackChanged (const juce::ValueTree&);
+    void markChanged (EditItemID);
+    void markAllChanged();
+    void invalidate (TrackState&);
+
+    juce::int64 calculateEditHash() const;
+    juce::int64 calculateHash (AudioTrack&) const;
+    bool updateHash (AudioTrack&);
+
+    bool isRenderEditInUse();
+    Edit* getRenderEditFor (AudioTrack&);
+    bool startRender (AudioTrack&, TrackState&);
+    void cancelRender();
+    void releaseRenderEdit();
+
+    //==============================================================================
+    void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
+    void valueTreeChildAdded (juce::ValueTree&, juce::ValueTree&) override;
+    void valueTreeChildRemoved (juce::ValueTree&, juce::ValueTree&, int) override;
+    void valueTreeChildOrderChanged (juce::ValueTree&, int, int) override;
+    void valueTreeParentChanged (juce::ValueTree&) override {}
+
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+
+    void jobStarted (RenderManager::Job&) override;
+    void jobFinished (RenderManager::Job&, bool completedOk) override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoFreezer)
+};
+
+} // namespace tracktion_engine
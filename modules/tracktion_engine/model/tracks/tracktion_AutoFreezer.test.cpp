@@ -0,0 +1,117 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS && JUCE_MODAL_LOOPS_PERMITTED
+
+//==============================================================================
+class AutoFreezerTests  : public juce::UnitTest
+{
+public:
+    AutoFreezerTests()
+        : juce::UnitTest ("AutoFreezer", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+        auto sinFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (engine.getDeviceManager().getSampleRate(), 1.0);
+
+        auto edit = Edit::createSingleTrackEdit (engine);
+        auto track = getAudioTracks (*edit)[0];
+        auto clip = track->insertWaveClip ("sin", sinFile->getFile(), { { 0.0, 1.0 } }, false);
+        expect (AutoFreezer::canTrackBeFrozen (*track));
+
+        const double delaySeconds = 0.5;
+        AutoFreezer freezer (*edit, delaySeconds);
+        juce::File firstRender;
+
+        beginTest ("Freezes after the idle delay");
+        {
+            const auto startTime = juce::Time::getMillisecondCounterHiRes();
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 1; }));
+
+            expectGreaterOrEqual ((juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0, delaySeconds);
+            expect (! freezer.isRendering());
+
+            firstRender = freezer.getFrozenFile (*track);
+            expect (firstRender.existsAsFile());
+            expect (freezer.isUsingFile (firstRender));
+            expectWithinAbsoluteError (AudioFile (engine, firstRender).getLength(), 1.0, 0.01);
+        }
+
+        beginTest ("Undo reuses the previous render");
+        {
+            edit->getUndoManager().beginNewTransaction();
+            clip->setGainDB (-6.0f);
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 0; }));
+            expect (freezer.getFrozenFile (*track) == juce::File());
+
+            // This is frozen again straight away rather than after the delay
+            edit->getUndoManager().undo();
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 1; }, juce::roundToInt (delaySeconds * 500.0)));
+            expect (freezer.getFrozenFile (*track) == firstRender);
+        }
+
+        beginTest ("Changes invalidate the render");
+        {
+            clip->setGainDB (-6.0f);
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 0; }));
+            expect (freezer.getFrozenFile (*track) == juce::File());
+
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 1; }));
+            auto secondRender = freezer.getFrozenFile (*track);
+            expect (secondRender.existsAsFile());
+            expect (secondRender != firstRender);
+            expect (! firstRender.existsAsFile());
+            expect (! freezer.isUsingFile (firstRender));
+        }
+
+        beginTest ("Plugin changes invalidate the render");
+        {
+            auto plugin = track->pluginList.insertPlugin (VolumeAndPanPlugin::create(), 0);
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 0; }));
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 1; }));
+
+            freezer.pluginChanged (*plugin);
+            expectEquals (freezer.getNumFrozenTracks(), 0);
+            expect (waitFor ([&] { return freezer.getNumFrozenTracks() == 1; }));
+        }
+    }
+
+private:
+    /** Runs the message loop until the condition's met, which will be when the render's
+        completion messages have been delivered.
+    */
+    template<typename Condition>
+    static bool waitFor (Condition&& condition, int timeoutMs = 10000)
+    {
+        const auto endTime = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+        while (! condition())
+        {
+            if (juce::Time::getMillisecondCounter() > endTime)
+                return false;
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+        }
+
+        return true;
+    }
+};
+
+static AutoFreezerTests autoFreezerTests;
+
+#endif
+
+} // namespace tracktion_engine
@@ -11,11 +11,11 @@
 namespace tracktion_engine
 {
 
-struct ClipTrack::ClipList  : public ValueTreeObjectList<Clip>,
+struct ClipTrack::ClipList  : public IndexedValueTreeObjectList<Clip>,
                               private AsyncUpdater
 {
     ClipList (ClipTrack& ct, const ValueTree& parentTree)
-        : ValueTreeObjectList<Clip> (parentTree),
+        : IndexedValueTreeObjectList<Clip> (parentTree),
           clipTrack (ct)
     {
         rebuildObjects();
@@ -34,11 +34,7 @@ struct ClipTrack::ClipList  : public ValueTreeObjectList<Clip>,
 
     Clip::Ptr getClipForTree (const ValueTree& v) const
     {
-        for (auto c : objects)
-            if (c->state == v)
-                return c;
-
-        return {};
+        return getObjectFor (v);
     }
 
     bool isSuitableType (const ValueTree& v) const override
@@ -75,6 +75,15 @@ juce::AudioChannelSet::ChannelType channelTypeFromAbbreviatedName (const juce::S
     if (result != cache.map.end())
         return result->second;
 
+    // Discrete channels are named "#1", "#2" etc.
+    if (abbreviatedName.startsWithChar ('#'))
+    {
+        const int discreteIndex = abbreviatedName.substring (1).getIntValue() - 1;
+
+        if (discreteIndex >= 0 && abbreviatedName.substring (1).containsOnly ("0123456789"))
+            return static_cast<AudioChannelSet::ChannelType> (AudioChannelSet::discreteChannel0 + discreteIndex);
+    }
+
     return juce::AudioChannelSet::unknown;
 }
 
@@ -114,6 +114,43 @@ static String expandPatterns (Edit& ed, const String& s, Track* track, int take)
 }
 
 
+static Result getNewRecordingFile (Edit& edit, const String& filenameMask, Track* track,
+                                   const AudioFormat& format, File& recordedFile)
+{
+    int take = 1;
+
+    do
+    {
+        recordedFile = File (expandPatterns (edit, filenameMask, track, take++)
+                                + format.getFileExtensions()[0]);
+    } while (recordedFile.exists());
+
+    if (! recordedFile.getParentDirectory().createDirectory())
+    {
+        TRACKTION_LOG_ERROR ("Record fail: can't create parent directory: " + recordedFile.getFullPathName());
+
+        return Result::fail (TRANS("The directory\nXZZX\ndoesn't exist")
+                             .replace ("XZZX", recordedFile.getParentDirectory().getFullPathName()));
+    }
+
+    if (! recordedFile.getParentDirectory().hasWriteAccess())
+    {
+        TRACKTION_LOG_ERROR ("Record fail: directory is read-only: " + recordedFile.getFullPathName());
+
+        return Result::fail (TRANS("The directory\nXZZX\n doesn't have write-access")
+                             .replace ("XZZX", recordedFile.getParentDirectory().getFullPathName()));
+    }
+
+    if (! recordedFile.deleteFile())
+    {
+        TRACKTION_LOG_ERROR ("Record fail: can't overwrite file: " + recordedFile.getFullPathName());
+
+        return Result::fail (TRANS("Can't overwrite the existing file:") + "\n" + recordedFile.getFullPathName());
+    }
+
+    return Result::ok();
+}
+
 //==============================================================================
 struct RetrospectiveRecordBuffer
 {
@@ -202,6 +239,96 @@ struct RetrospectiveRecordBuffer
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RetrospectiveRecordBuffer)
 };
 
+//==============================================================================
+class WaveInputDeviceInstance;
+
+/** A single interleaved file that all the armed inputs of the audio device record into
+    when EngineBehaviour::shouldRecordInputsToMultiChannelFile() is enabled.
+    Each input's WaveInputDeviceInstance writes to its own range of the file's channels
+    and the clips created reference those channels as discrete channel types.
+*/
+struct MultiChannelRecordingFile
+{
+    /** Releases the file when the last input using it has finished with it. */
+    struct Releaser
+    {
+        void operator() (MultiChannelRecordingFile*) const;
+    };
+
+    using Ptr = std::unique_ptr<MultiChannelRecordingFile, Releaser>;
+
+    MultiChannelRecordingFile (EditPlaybackContext& c, double start, double punch)
+        : context (c), playStart (start), punchIn (punch)
+    {
+    }
+
+    ~MultiChannelRecordingFile()
+    {
+        closeFileWriter();
+
+        // The file is only kept if one of the inputs has made a clip from it
+        if (! keepFile && file.existsAsFile())
+            file.deleteFile();
+    }
+
+    /** Returns the file being recorded by all the armed inputs in the context, creating
+        it when the first of them is prepared. This will return nullptr if the input isn't
+        part of the file, in which case it should record to its own file.
+        The file is deleted when the last of the inputs' Ptrs is released.
+    */
+    static Ptr getOrCreate (WaveInputDeviceInstance&, double playStart, double punchIn, double sampleRate, String& error);
+
+    /** Stops all the inputs recording and closes the file. */
+    void closeFileWriter();
+
+    /** Returns the range of the file's channels that an input is recorded to. */
+    juce::Range<int> getChannelsInFile (const WaveInputDeviceInstance& input) const
+    {
+        for (auto& i : inputs)
+            if (i.instance == &input)
+                return { i.firstChannel, i.firstChannel + i.numChannels };
+
+        return {};
+    }
+
+    /** Returns the channels of the file that an input's clips should use. */
+    juce::AudioChannelSet getChannelSetFor (const WaveInputDeviceInstance& input) const
+    {
+        juce::AudioChannelSet set;
+        const auto channels = getChannelsInFile (input);
+
+        for (int i = channels.getStart(); i < channels.getEnd(); ++i)
+            set.addChannel (static_cast<juce::AudioChannelSet::ChannelType> (juce::AudioChannelSet::discreteChannel0 + i));
+
+        return set;
+    }
+
+    struct Input
+    {
+        WaveInputDeviceInstance* instance = nullptr;
+        int firstChannel = 0, numChannels = 0;
+    };
+
+    EditPlaybackContext& context;
+    const double playStart, punchIn;
+    File file;
+    std::vector<Input> inputs;
+    std::unique_ptr<AudioFileWriter> fileWriter;
+    RecordingThumbnailManager::Thumbnail::Ptr thumbnail;
+    bool keepFile = false;
+
+    // If loop recording splits the file into takes, this is done once for all the inputs
+    bool hasSplitIntoTakes = false;
+    ReferenceCountedArray<ProjectItem> extraTakes;
+    Array<File> takeFiles;
+
+private:
+    // Guarded by the context's MultiChannelRecordingFiles lock
+    int numUsers = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiChannelRecordingFile)
+};
+
 //==============================================================================
 class WaveInputDeviceInstance  : public InputDeviceInstance
 {
@@ -260,48 +387,18 @@ public:
 
     Result getRecordingFile (File& recordedFile, const AudioFormat& format) const
     {
-        int take = 1;
+        auto firstActiveTarget = getTargetTracks().getFirst();
 
-        do
+        for (auto t : getTargetTracks())
         {
-            auto firstActiveTarget = getTargetTracks().getFirst();
-            for (auto t : getTargetTracks())
+            if (activeTracks.contains (t))
             {
-                if (activeTracks.contains (t))
-                {
-                    firstActiveTarget = t;
-                    break;
-                }
+                firstActiveTarget = t;
+                break;
             }
-
-            recordedFile = File (expandPatterns (edit, getWaveInput().filenameMask, firstActiveTarget, take++)
-                                    + format.getFileExtensions()[0]);
-        } while (recordedFile.exists());
-
-        if (! recordedFile.getParentDirectory().createDirectory())
-        {
-            TRACKTION_LOG_ERROR ("Record fail: can't create parent directory: " + recordedFile.getFullPathName());
-
-            return Result::fail (TRANS("The directory\nXZZX\ndoesn't exist")
-                                 .replace ("XZZX", recordedFile.getParentDirectory().getFullPathName()));
-        }
-
-        if (! recordedFile.getParentDirectory().hasWriteAccess())
-        {
-            TRACKTION_LOG_ERROR ("Record fail: directory is read-only: " + recordedFile.getFullPathName());
-
-            return Result::fail (TRANS("The directory\nXZZX\n doesn't have write-access")
-                                 .replace ("XZZX", recordedFile.getParentDirectory().getFullPathName()));
         }
 
-        if (! recordedFile.deleteFile())
-        {
-            TRACKTION_LOG_ERROR ("Record fail: can't overwrite file: " + recordedFile.getFullPathName());
-
-            return Result::fail (TRANS("Can't overwrite the existing file:") + "\n" + recordedFile.getFullPathName());
-        }
-
-        return Result::ok();
+        return getNewRecordingFile (edit, getWaveInput().filenameMask, firstActiveTarget, format, recordedFile);
     }
 
     String prepareToRecord (double playStart, double punchIn, double sr, int /*blockSizeSamples*/, bool isLivePunch) override
@@ -318,26 +415,48 @@ public:
                 if (proj->isReadOnly())
                     return TRANS("The current project is read-only, so new clips can't be recorded into it!");
 
-            auto format = getFormatToUse();
-            File recordedFile;
+            auto& wi = getWaveInput();
+            std::unique_ptr<RecordingContext> rc;
+            AudioFileWriter* writer = nullptr;
 
-            auto res = getRecordingFile (recordedFile, *format);
+            if (! isLivePunch && edit.engine.getEngineBehaviour().shouldRecordInputsToMultiChannelFile())
+            {
+                if (auto sharedFile = MultiChannelRecordingFile::getOrCreate (*this, playStart, punchIn, sr, error))
+                {
+                    rc = std::make_unique<RecordingContext> (edit.engine, sharedFile->file);
+                    writer = sharedFile->fileWriter.get();
+                    rc->sharedFile = std::move (sharedFile);
+                }
+                else if (error.isNotEmpty())
+                {
+                    return error;
+                }
+            }
 
-            if (! res.wasOk())
-                return res.getErrorMessage();
+            if (rc == nullptr)
+            {
+                auto format = getFormatToUse();
+                File recordedFile;
 
-            auto rc = std::make_unique<RecordingContext> (edit.engine, recordedFile);
-            rc->sampleRate = sr;
+                auto res = getRecordingFile (recordedFile, *format);
 
-            StringPairArray metadata;
-            AudioFileUtils::addBWAVStartToMetadata (metadata, (int64) (playStart * sr));
-            auto& wi = getWaveInput();
+                if (! res.wasOk())
+                    return res.getErrorMessage();
 
-            rc->fileWriter.reset (new AudioFileWriter (AudioFile (edit.engine, recordedFile), format,
-                                                       wi.isStereoPair() ? 2 : 1,
-                                                       sr, wi.bitDepth, metadata, 0));
+                rc = std::make_unique<RecordingContext> (edit.engine, recordedFile);
 
-            if (rc->fileWriter->isOpen())
+                StringPairArray metadata;
+                AudioFileUtils::addBWAVStartToMetadata (metadata, (int64) (playStart * sr));
+
+                rc->fileWriter.reset (new AudioFileWriter (AudioFile (edit.engine, recordedFile), format,
+                                                           wi.isStereoPair() ? 2 : 1,
+                                                           sr, wi.bitDepth, metadata, 0));
+                writer = rc->fileWriter.get();
+            }
+
+            rc->sampleRate = sr;
+
+            if (writer != nullptr && writer->isOpen())
             {
                 CRASH_TRACER
                 auto endRecTime = punchIn + Edit::maximumLength;
@@ -379,26 +498,38 @@ public:
                 }
 
                 rc->punchTimes = { punchInTime, endRecTime };
-                rc->hasHitThreshold = (wi.recordTriggerDb <= -50.0f);
 
-                if (edit.engine.getUIBehaviour().shouldGenerateLiveWaveformsWhenRecording())
+                // A shared file has to stay in sync across all its inputs so can't wait for a trigger
+                rc->hasHitThreshold = (wi.recordTriggerDb <= -50.0f) || rc->sharedFile != nullptr;
+
+                if (rc->sharedFile != nullptr)
                 {
-                    if ((rc->thumbnail = edit.engine.getRecordingThumbnailManager().getThumbnailFor (recordedFile)))
+                    if ((rc->thumbnail = rc->sharedFile->thumbnail))
+                        rc->thumbnail->punchInTime = punchInTime;
+                }
+                else if (edit.engine.getUIBehaviour().shouldGenerateLiveWaveformsWhenRecording())
+                {
+                    if ((rc->thumbnail = edit.engine.getRecordingThumbnailManager().getThumbnailFor (rc->file)))
                     {
                         rc->thumbnail->reset (wi.isStereoPair() ? 2 : 1, sr);
                         rc->thumbnail->punchInTime = punchInTime;
                     }
                 }
 
+                rc->recording = edit.engine.getWaveInputRecordingThread()
+                                  .prepareToRecord (*writer, rc->thumbnail,
+                                                    rc->sharedFile != nullptr ? rc->sharedFile->getChannelsInFile (*this)
+                                                                              : juce::Range<int>());
+
                 const ScopedLock sl (contextLock);
                 recordingContext = std::move (rc);
             }
             else
             {
-                TRACKTION_LOG_ERROR ("Record fail: couldn't write to file: " + recordedFile.getFullPathName());
+                TRACKTION_LOG_ERROR ("Record fail: couldn't write to file: " + rc->file.getFullPathName());
 
                 return TRANS("Couldn't record!") + "\n\n"
-                        + TRANS("Couldn't create the file: XZZX").replace ("XZZX", recordedFile.getFullPathName());
+                        + TRANS("Couldn't create the file: XZZX").replace ("XZZX", rc->file.getFullPathName());
             }
         }
         JUCE_CATCH_EXCEPTION
@@ -472,7 +603,10 @@ public:
         {
             const File f (rc->file);
             closeFileWriter (*rc);
-            f.deleteFile();
+
+            // A shared file is deleted once none of its inputs are using it
+            if (rc->sharedFile == nullptr)
+                f.deleteFile();
         }
     }
 
@@ -493,6 +627,12 @@ public:
               threadInitialiser (e.getWaveInputRecordingThread())
         {}
 
+        ~RecordingContext()
+        {
+            if (fileWriter != nullptr)
+                engine.getWaveInputRecordingThread().waitForWriterToFinish (*fileWriter);
+        }
+
         Engine& engine;
         File file;
         double sampleRate = 44100.0;
@@ -501,15 +641,16 @@ public:
         int adjustSamples = 0;
 
         std::unique_ptr<AudioFileWriter> fileWriter;
+        MultiChannelRecordingFile::Ptr sharedFile;
         DiskSpaceCheckTask diskSpaceChecker;
         RecordingThumbnailManager::Thumbnail::Ptr thumbnail;
         WaveInputRecordingThread::ScopedInitialiser threadInitialiser;
+        WaveInputRecordingThread::Recording* recording = nullptr;
 
         void addBlockToRecord (const juce::AudioBuffer<float>& buffer, int start, int numSamples)
         {
-            if (fileWriter != nullptr)
-                engine.getWaveInputRecordingThread().addBlockToRecord (*fileWriter, buffer,
-                                                                       start, numSamples, thumbnail);
+            if (recording != nullptr)
+                engine.getWaveInputRecordingThread().addBlockToRecord (*recording, buffer, start, numSamples);
         }
     };
 
@@ -542,7 +683,7 @@ public:
 
             if (discardRecordings || recordingDestTracks.size() == 0)
             {
-                recordedFile.deleteFile();
+                deleteRecordedFile (*rc, recordedFile);
                 return {};
             }
 
@@ -552,7 +693,9 @@ public:
                 if (activeTracks.contains (destTrack))
                 {
                     AudioFile trackRecordedFile (edit.engine);
-                    if (firstTrack)
+
+                    // Clips from a shared file only reference their own channels so don't need a copy
+                    if (firstTrack || rc->sharedFile != nullptr)
                     {
                         trackRecordedFile = recordedFile;
                     }
@@ -629,7 +772,7 @@ public:
 
             engine.getUIBehaviour().showWarningMessage (s);
 
-            recordedFile.deleteFile();
+            deleteRecordedFile (rc, recordedFile);
             return {};
         }
 
@@ -670,7 +813,12 @@ public:
         Array<File> filesCreated;
         filesCreated.add (recordedFile.getFile());
 
-        if (isLooping)
+        if (isLooping && rc.sharedFile != nullptr && rc.sharedFile->hasSplitIntoTakes)
+        {
+            extraTakes = rc.sharedFile->extraTakes;
+            filesCreated = rc.sharedFile->takeFiles;
+        }
+        else if (isLooping)
         {
             if (! splitRecordingIntoMultipleTakes (recordedFile, projectItem, recordedFileLength, extraTakes, filesCreated))
             {
@@ -678,6 +826,13 @@ public:
                                                           TRANS("Couldn't create audio files for multiple takes"));
                 return {};
             }
+
+            if (rc.sharedFile != nullptr)
+            {
+                rc.sharedFile->hasSplitIntoTakes = true;
+                rc.sharedFile->extraTakes = extraTakes;
+                rc.sharedFile->takeFiles = filesCreated;
+            }
         }
 
         double endPos = rc.punchTimes.getStart() + newClipLen;
@@ -742,6 +897,14 @@ public:
             afm.forceFileUpdate (AudioFile (edit.engine, f));
         }
 
+        if (rc.sharedFile != nullptr)
+        {
+            rc.sharedFile->keepFile = true;
+
+            if (auto acb = dynamic_cast<AudioClipBase*> (newClip.get()))
+                acb->setActiveChannels (rc.sharedFile->getChannelSetFor (*this));
+        }
+
         if (auto wc = dynamic_cast<WaveAudioClip*> (newClip.get()))
         {
             if (extraTakes.size() > 0)
@@ -1109,6 +1272,8 @@ public:
     }
 
 protected:
+    friend struct MultiChannelRecordingFile;
+
     CriticalSection contextLock;
     std::unique_ptr<RecordingContext> recordingContext;
 
@@ -1125,10 +1290,22 @@ protected:
     {
         CRASH_TRACER
 
+        rc.recording = nullptr;
+
+        if (rc.sharedFile != nullptr)
+            rc.sharedFile->closeFileWriter();
+
         if (auto localCopy = std::move (rc.fileWriter))
             rc.engine.getWaveInputRecordingThread().waitForWriterToFinish (*localCopy);
     }
 
+    static void deleteRecordedFile (const RecordingContext& rc, const AudioFile& recordedFile)
+    {
+        // A shared file is deleted once none of its inputs have made a clip from it
+        if (rc.sharedFile == nullptr)
+            recordedFile.deleteFile();
+    }
+
     WaveInputDevice& getWaveInput() const noexcept    { return static_cast<WaveInputDevice&> (owner); }
 
     //==============================================================================
@@ -1150,6 +1327,166 @@ protected:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveInputDeviceInstance)
 };
 
+//==============================================================================
+MultiChannelRecordingFile::Ptr MultiChannelRecordingFile::getOrCreate (WaveInputDeviceInstance& input, double playStart,
+                                                                       double punchIn, double sampleRate, String& error)
+{
+    CRASH_TRACER
+    auto& wi = input.getWaveInput();
+
+    if (wi.isTrackDevice())
+        return {};
+
+    auto& context = input.context;
+    auto& activeFiles = context.multiChannelRecordingFiles;
+
+    // This is held whilst the file's created so that only the first input creates it
+    const ScopedLock sl (activeFiles.lock);
+
+    for (auto f : activeFiles.files)
+    {
+        if (f->playStart == playStart && f->punchIn == punchIn && f->fileWriter != nullptr)
+        {
+            if (f->getChannelsInFile (input).isEmpty())
+                return {};
+
+            ++f->numUsers;
+            return Ptr (f);
+        }
+    }
+
+    // The file contains all the inputs that will be prepared to record, ordered by their device channels
+    auto f = std::make_unique<MultiChannelRecordingFile> (context, playStart, punchIn);
+    int bitDepth = wi.bitDepth;
+
+    for (auto in : context.getAllInputs())
+    {
+        if (auto wdi = dynamic_cast<WaveInputDeviceInstance*> (in))
+        {
+            auto& device = wdi->getWaveInput();
+
+            if (! device.isTrackDevice() && wdi->isRecordingActive())
+            {
+                f->inputs.push_back ({ wdi, 0, (int) device.getChannels().size() });
+                bitDepth = jmax (bitDepth, device.bitDepth);
+            }
+        }
+    }
+
+    if (f->inputs.size() < 2 || f->getChannelsInFile (input).isEmpty())
+        return {};
+
+    auto getLowestDeviceChannel = [] (const Input& i)
+    {
+        int lowest = std::numeric_limits<int>::max();
+
+        for (auto& ci : i.instance->getWaveInput().getChannels())
+            lowest = jmin (lowest, ci.indexInDevice);
+
+        return lowest;
+    };
+
+    std::sort (f->inputs.begin(), f->inputs.end(),
+               [&] (const Input& a, const Input& b) { return getLowestDeviceChannel (a) < getLowestDeviceChannel (b); });
+
+    int numChannels = 0;
+
+    for (auto& i : f->inputs)
+    {
+        i.firstChannel = numChannels;
+        numChannels += i.numChannels;
+    }
+
+    // Wav files can hold any number of channels and switch to RF64 when they get too large
+    auto& engine = context.edit.engine;
+    auto format = engine.getAudioFileFormatManager().getWavFormat();
+
+    if (! format->getPossibleBitDepths().contains (bitDepth))
+        bitDepth = 24;
+
+    auto res = getNewRecordingFile (context.edit, wi.filenameMask.replace (trackPattern, TRANS("Multichannel"), true),
+                                    nullptr, *format, f->file);
+
+    if (! res.wasOk())
+    {
+        error = res.getErrorMessage();
+        return {};
+    }
+
+    StringPairArray metadata;
+    AudioFileUtils::addBWAVStartToMetadata (metadata, (int64) (playStart * sampleRate));
+
+    f->fileWriter.reset (new AudioFileWriter (AudioFile (engine, f->file), format, numChannels,
+                                              sampleRate, bitDepth, metadata, 0));
+
+    if (! f->fileWriter->isOpen())
+    {
+        TRACKTION_LOG_ERROR ("Record fail: couldn't write to file: " + f->file.getFullPathName());
+
+        error = TRANS("Couldn't record!") + "\n\n"
+                  + TRANS("Couldn't create the file: XZZX").replace ("XZZX", f->file.getFullPathName());
+        return {};
+    }
+
+    if (engine.getUIBehaviour().shouldGenerateLiveWaveformsWhenRecording())
+        if ((f->thumbnail = engine.getRecordingThumbnailManager().getThumbnailFor (f->file)))
+            f->thumbnail->reset (numChannels, sampleRate);
+
+    f->numUsers = 1;
+    activeFiles.files.add (f.get());
+
+    return Ptr (f.release());
+}
+
+void MultiChannelRecordingFile::Releaser::operator() (MultiChannelRecordingFile* f) const
+{
+    if (f == nullptr)
+        return;
+
+    auto& activeFiles = f->context.multiChannelRecordingFiles;
+    std::unique_ptr<MultiChannelRecordingFile> toDelete;
+
+    {
+        const ScopedLock sl (activeFiles.lock);
+
+        if (--f->numUsers == 0)
+        {
+            activeFiles.files.removeFirstMatchingValue (f);
+            toDelete.reset (f);
+        }
+    }
+
+    // Closing the file waits for the writer thread so mustn't hold the lock
+    toDelete.reset();
+}
+
+EditPlaybackContext::MultiChannelRecordingFiles::~MultiChannelRecordingFiles()
+{
+    // All the inputs should have released their files by now
+    jassert (files.isEmpty());
+}
+
+void MultiChannelRecordingFile::closeFileWriter()
+{
+    CRASH_TRACER
+
+    if (fileWriter == nullptr)
+        return;
+
+    // All the inputs have to stop adding blocks before the file can be finished
+    for (auto& i : inputs)
+    {
+        const ScopedLock sl (i.instance->contextLock);
+
+        if (auto rc = i.instance->recordingContext.get())
+            if (rc->sharedFile.get() == this)
+                rc->recording = nullptr;
+    }
+
+    if (auto localCopy = std::move (fileWriter))
+        context.edit.engine.getWaveInputRecordingThread().waitForWriterToFinish (*localCopy);
+}
+
 //==============================================================================
 WaveInputDevice::WaveInputDevice (Engine& e, const juce::String& deviceName, const juce::String& devType,
                                   const std::vector<ChannelIndex>& channels, DeviceType t)
@@ -1490,145 +1827,171 @@ void WaveInputDevice::updateRetrospectiveBufferLength (double length)
 }
 
 //==============================================================================
-struct WaveInputRecordingThread::BlockQueue
+struct WaveInputRecordingThread::Recording
 {
-    BlockQueue()
+    Recording (AudioFileWriter& w, const RecordingThumbnailManager::Thumbnail::Ptr& thumb,
+               Range<int> channels, double lengthSeconds)
+        : writer (w), thumbnail (thumb),
+          channelsInFile (channels.isEmpty() ? Range<int> (0, w.getNumChannels()) : channels),
+          sampleRate (w.getSampleRate()),
+          fifo (jmax (8192, roundToInt (lengthSeconds * w.getSampleRate()))),
+          buffer (channelsInFile.getLength(), fifo.getTotalSize()),
+          minBatchSize (jmin (fifo.getTotalSize() / 4, roundToInt (sampleRate * 0.1)))
     {
-        for (int i = 32; --i >= 0;)
-            addToFreeQueue (new QueuedBlock());
+        jassert (channelsInFile.getEnd() <= w.getNumChannels());
+        buffer.clear();
     }
 
-    struct QueuedBlock
-    {
-        QueuedBlock() = default;
-
-        void load (AudioFileWriter& w, const juce::AudioBuffer<float>& newBuffer,
-                   int start, int numSamples, const RecordingThumbnailManager::Thumbnail::Ptr& thumb)
-        {
-            buffer.setSize (newBuffer.getNumChannels(), numSamples);
-
-            for (int i = buffer.getNumChannels(); --i >= 0;)
-                buffer.copyFrom (i, 0, newBuffer, i, start, numSamples);
-
-            writer = &w;
-            thumbnail = thumb;
-        }
-
-        std::atomic<AudioFileWriter*> writer { nullptr };
-        QueuedBlock* next = nullptr;
-        juce::AudioBuffer<float> buffer { 2, 512 };
-        RecordingThumbnailManager::Thumbnail::Ptr thumbnail;
-
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (QueuedBlock)
-    };
-
-    CriticalSection freeQueueLock, pendingQueueLock;
-    QueuedBlock* firstPending = nullptr;
-    QueuedBlock* lastPending = nullptr;
-    QueuedBlock* firstFree = nullptr;
-    std::atomic<int> numPending { 0 };
+    bool fillsWholeFile() const     { return channelsInFile == Range<int> (0, writer.getNumChannels()); }
 
-    QueuedBlock* findFreeBlock()
+    //==============================================================================
+    /** Called on the audio thread to queue any drop that hasn't been queued yet.
+        Until this succeeds no more blocks can be added, as they'd be written before it.
+    */
+    bool pushPendingDrop() noexcept
     {
-        const ScopedLock sl (freeQueueLock);
+        if (pendingDrop.numSamples == 0)
+            return true;
+
+        int start1, size1, start2, size2;
+        dropFifo.prepareToWrite (1, start1, size1, start2, size2);
 
-        if (firstFree == nullptr)
-            return new QueuedBlock();
+        if (size1 == 0)
+            return false;
 
-        auto* b = firstFree;
-        firstFree = b->next;
-        b->next = nullptr;
-        return b;
+        drops[(size_t) start1] = pendingDrop;
+        dropFifo.finishedWrite (1);
+        pendingDrop = {};
+        return true;
     }
 
-    void addToFreeQueue (QueuedBlock* b) noexcept
+    /** Called on the audio thread when a block can't be added. */
+    void addDrop (int numSamples) noexcept
     {
-        jassert (b != nullptr);
-        const ScopedLock sl (freeQueueLock);
-        b->writer = nullptr;
-        b->next = firstFree;
-        firstFree = b;
+        if (pendingDrop.numSamples == 0)
+            pendingDrop.position = numSamplesPushed;
+
+        pendingDrop.numSamples += numSamples;
+        pushPendingDrop();
     }
 
-    void addToPendingQueue (QueuedBlock* b) noexcept
+    //==============================================================================
+    /** Returns the number of samples, including any silence for dropped blocks, that can be read. */
+    int getNumPending() const noexcept
     {
-        jassert (b != nullptr);
-        b->next = nullptr;
-        const ScopedLock sl (pendingQueueLock);
+        // The drops have to be checked first as any that are visible will have all the
+        // samples before them in the FIFO too
+        int numSilent = 0;
+        int start1, size1, start2, size2;
+        dropFifo.prepareToRead (dropFifo.getNumReady(), start1, size1, start2, size2);
 
-        if (lastPending != nullptr)
-            lastPending->next = b;
-        else
-            firstPending = b;
+        for (int i = 0; i < size1; ++i)     numSilent += drops[(size_t) (start1 + i)].numSamples;
+        for (int i = 0; i < size2; ++i)     numSilent += drops[(size_t) (start2 + i)].numSamples;
 
-        lastPending = b;
-        ++numPending;
+        return numSilent + fifo.getNumReady();
     }
 
-    QueuedBlock* removeFirstPending() noexcept
+    bool hasDropsPending() const noexcept   { return dropFifo.getNumReady() > 0; }
+
+    /** Reads up to maxSamples in the order they were recorded. The callback is called with
+        each section of the buffer to write, or nullptr for silence where a block was dropped.
+        Returns the number of samples read.
+    */
+    template<typename Callback>
+    int readPending (int maxSamples, Callback&& callback)
     {
-        const ScopedLock sl (pendingQueueLock);
+        int numDone = 0;
 
-        if (auto b = firstPending)
+        while (numDone < maxSamples)
         {
-            firstPending = b->next;
+            int dropStart, numDrops, start2, size2;
+            dropFifo.prepareToRead (1, dropStart, numDrops, start2, size2);
+            int numAvailable = fifo.getNumReady();
 
-            if (firstPending == nullptr)
-                lastPending = nullptr;
+            if (numDrops > 0)
+            {
+                auto& drop = drops[(size_t) dropStart];
 
-            --numPending;
-            return b;
-        }
+                if (drop.position == numSamplesRead)
+                {
+                    const int num = jmin (maxSamples - numDone, drop.numSamples);
+                    callback (nullptr, 0, num);
+                    numDone += num;
+                    drop.numSamples -= num;
 
-        return {};
-    }
+                    if (drop.numSamples == 0)
+                        dropFifo.finishedRead (1);
 
-    void moveAnyPendingBlocksToFree() noexcept
-    {
-        while (auto b = removeFirstPending())
-            addToFreeQueue (b);
+                    continue;
+                }
 
-        jassert (numPending == 0);
-        numPending = 0;
-    }
+                numAvailable = (int) jmin ((juce::int64) numAvailable, drop.position - numSamplesRead);
+            }
 
-    bool isWriterInQueue (AudioFileWriter& writer) const
-    {
-        const ScopedLock sl (pendingQueueLock);
+            const int num = jmin (maxSamples - numDone, numAvailable);
 
-        for (auto b = firstPending; b != nullptr; b = b->next)
-            if (b->writer == &writer)
-                return true;
+            if (num <= 0)
+                break;
 
-        return false;
-    }
+            int start1, size1;
+            fifo.prepareToRead (num, start1, size1, start2, size2);
 
-    void deleteFreeQueue() noexcept
-    {
-        auto b = firstFree;
-        firstFree = nullptr;
+            if (size1 > 0)  callback (&buffer, start1, size1);
+            if (size2 > 0)  callback (&buffer, start2, size2);
 
-        while (b != nullptr)
-        {
-            std::unique_ptr<QueuedBlock> toDelete (b);
-            b = b->next;
+            fifo.finishedRead (size1 + size2);
+            numSamplesRead += size1 + size2;
+            numDone += size1 + size2;
         }
+
+        return numDone;
     }
+
+    //==============================================================================
+    AudioFileWriter& writer;
+    const RecordingThumbnailManager::Thumbnail::Ptr thumbnail;
+    const Range<int> channelsInFile;
+    const double sampleRate;
+
+    // The buffer is written to by the audio thread and read by the writer thread
+    AbstractFifo fifo;
+    juce::AudioBuffer<float> buffer;
+    const int minBatchSize;
+
+    // Blocks that had to be dropped, marked with the number of samples that were added
+    // to the FIFO before them so the writer can insert silence in the right place
+    struct Drop
+    {
+        juce::int64 position = 0;
+        int numSamples = 0;
+    };
+
+    static constexpr int maxNumDrops = 64;
+    AbstractFifo dropFifo { maxNumDrops };
+    std::array<Drop, (size_t) maxNumDrops> drops;
+
+    Drop pendingDrop;                       // Only used by the audio thread
+    juce::int64 numSamplesPushed = 0;       // Only used by the audio thread
+    juce::int64 numSamplesRead = 0;         // Only used by the writer thread
+
+    std::atomic<int> highWaterMark { 0 };
+    std::atomic<bool> isFinishing { false }, isFinished { false };
 };
 
 //==============================================================================
 WaveInputRecordingThread::WaveInputRecordingThread (Engine& e)
     : Thread ("WaveInputRecordingThread"),
-      engine (e),
-      queue (new BlockQueue())
+      engine (e)
 {
 }
 
 WaveInputRecordingThread::~WaveInputRecordingThread()
 {
     flushAndStop();
-    queue->deleteFreeQueue();
-    queue.reset();
+
+    const ScopedLock sl (recordingsLock);
+    jassert (recordings.isEmpty()); // All writers should have been finished by now
+    recordings.clear();
 }
 
 void WaveInputRecordingThread::addUser()
@@ -1644,22 +2007,265 @@ void WaveInputRecordingThread::removeUser()
 }
 
 //==============================================================================
-void WaveInputRecordingThread::addBlockToRecord (AudioFileWriter& writer, const juce::AudioBuffer<float>& buffer,
-                                                 int start, int numSamples, const RecordingThumbnailManager::Thumbnail::Ptr& thumbnail)
+WaveInputRecordingThread::Recording* WaveInputRecordingThread::prepareToRecord (AudioFileWriter& writer,
+                                                                                const RecordingThumbnailManager::Thumbnail::Ptr& thumbnail,
+                                                                                Range<int> channelsInFile)
+{
+    CRASH_TRACER
+    jassert (writer.isOpen());
+    auto r = std::make_unique<Recording> (writer, thumbnail, channelsInFile,
+                                          engine.getEngineBehaviour().getRecordingBufferLengthSeconds());
+
+    const ScopedLock sl (recordingsLock);
+    return recordings.add (r.release());
+}
+
+void WaveInputRecordingThread::addBlockToRecord (Recording& r, const juce::AudioBuffer<float>& source, int start, int numSamples)
 {
-    if (! threadShouldExit())
+    if (numSamples <= 0 || threadShouldExit())
+        return;
+
+    int start1, size1, start2, size2;
+    r.fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    if (size1 + size2 < numSamples || ! r.pushPendingDrop())
+    {
+        // The writer can't keep up so this block has to be lost
+        r.addDrop (numSamples);
+        numSamplesDropped += numSamples;
+        return;
+    }
+
+    const int numSourceChannels = source.getNumChannels();
+
+    for (int i = r.buffer.getNumChannels(); --i >= 0;)
     {
-        auto block = queue->findFreeBlock();
-        block->load (writer, buffer, start, numSamples, thumbnail);
-        queue->addToPendingQueue (block);
-        notify();
+        if (i < numSourceChannels)
+        {
+            r.buffer.copyFrom (i, start1, source, i, start, size1);
+            r.buffer.copyFrom (i, start2, source, i, start + size1, size2);
+        }
+        else
+        {
+            r.buffer.clear (i, start1, size1);
+            r.buffer.clear (i, start2, size2);
+        }
     }
+
+    r.fifo.finishedWrite (size1 + size2);
+    r.numSamplesPushed += size1 + size2;
+
+    const int numReady = r.fifo.getNumReady();
+
+    if (numReady > r.highWaterMark)
+        r.highWaterMark = numReady;
 }
 
 void WaveInputRecordingThread::waitForWriterToFinish (AudioFileWriter& writer)
 {
-    while (queue->isWriterInQueue (writer) && isThreadRunning())
+    CRASH_TRACER
+    juce::Array<Recording*> writerRecordings;
+
+    {
+        const ScopedLock sl (recordingsLock);
+        writerRecordings = getRecordingsFor (writer);
+    }
+
+    if (writerRecordings.isEmpty())
+        return;
+
+    for (auto r : writerRecordings)
+        r->isFinishing = true;
+
+    notify();
+
+    // Once the writer thread has marked them as finished it won't use them again
+    auto areAllFinished = [&writerRecordings]
+    {
+        for (auto r : writerRecordings)
+            if (! r->isFinished)
+                return false;
+
+        return true;
+    };
+
+    while (! areAllFinished() && isThreadRunning())
         Thread::sleep (2);
+
+    // If the thread has stopped, anything left needs to be written here
+    if (! areAllFinished())
+        writePendingBlocks (writerRecordings, true);
+
+    const ScopedLock sl (recordingsLock);
+
+    for (auto r : writerRecordings)
+    {
+        highWaterMarkSeconds = jmax (highWaterMarkSeconds.load(), r->highWaterMark / r->sampleRate);
+        recordings.removeObject (r);
+    }
+}
+
+//==============================================================================
+juce::Array<WaveInputRecordingThread::Recording*> WaveInputRecordingThread::getRecordingsFor (AudioFileWriter& writer) const
+{
+    juce::Array<Recording*> found;
+
+    for (auto r : recordings)
+        if (&r->writer == &writer)
+            found.add (r);
+
+    return found;
+}
+
+bool WaveInputRecordingThread::writePendingBlocks (const juce::Array<Recording*>& writerRecordings, bool writeEverything)
+{
+    if (writerRecordings.size() == 1 && writerRecordings.getFirst()->fillsWholeFile())
+        return writePendingBlocks (*writerRecordings.getFirst(), writeEverything);
+
+    return writeInterleavedBlocks (writerRecordings, writeEverything);
+}
+
+bool WaveInputRecordingThread::writePendingBlocks (Recording& r, bool writeEverything)
+{
+    const bool anyDrops = r.hasDropsPending();
+    const int numPending = r.getNumPending();
+
+    if (numPending == 0 || (numPending < r.minBatchSize && ! writeEverything && ! anyDrops))
+        return false;
+
+    bool ok = true;
+    juce::AudioBuffer<float> silence;
+
+    // Coalesce everything that's ready into as few large writes as possible
+    r.readPending (numPending, [&] (const juce::AudioBuffer<float>* source, int start, int numSamples)
+    {
+        if (source != nullptr)
+        {
+            juce::AudioBuffer<float> block (source->getArrayOfWritePointers(), source->getNumChannels(), start, numSamples);
+            ok = r.writer.appendBuffer (block, numSamples) && ok;
+
+            if (r.thumbnail != nullptr)
+                r.thumbnail->addBlock (block, 0, numSamples);
+
+            ++numWrites;
+            numSamplesWritten += numSamples;
+            return;
+        }
+
+        // Any dropped blocks are replaced with silence to keep the file in sync with the timeline
+        if (silence.getNumSamples() == 0)
+        {
+            silence.setSize (r.buffer.getNumChannels(), jmin (numSamples, roundToInt (r.sampleRate)));
+            silence.clear();
+        }
+
+        for (int numLeft = numSamples; numLeft > 0;)
+        {
+            const int num = jmin (numLeft, silence.getNumSamples());
+            ok = r.writer.appendBuffer (silence, num) && ok;
+
+            if (r.thumbnail != nullptr)
+                r.thumbnail->addBlock (silence, 0, num);
+
+            ++numWrites;
+            numLeft -= num;
+        }
+    });
+
+    if (anyDrops && ! hasWarned)
+    {
+        hasWarned = true;
+        TRACKTION_LOG_ERROR ("Audio recording can't keep up!");
+    }
+
+    if (! ok && ! hasSentStop)
+    {
+        hasSentStop = true;
+        TRACKTION_LOG_ERROR ("Audio recording failed to write to disk!");
+        startTimer (1);
+    }
+
+    return true;
+}
+
+bool WaveInputRecordingThread::writeInterleavedBlocks (const juce::Array<Recording*>& group, bool writeEverything)
+{
+    if (group.isEmpty())
+        return false;
+
+    auto& first = *group.getFirst();
+    auto& writer = first.writer;
+
+    // Every Recording is given the same blocks so normally only the rows that all of them
+    // have are written. When finishing, whatever's left is written and padded with silence
+    int numRows = writeEverything ? 0 : std::numeric_limits<int>::max();
+    bool anyDrops = false;
+
+    for (auto r : group)
+    {
+        anyDrops = anyDrops || r->hasDropsPending();
+        const int numPending = r->getNumPending();
+        numRows = writeEverything ? jmax (numRows, numPending) : jmin (numRows, numPending);
+    }
+
+    if (numRows == 0 || (numRows < first.minBatchSize && ! writeEverything && ! anyDrops))
+        return false;
+
+    const int maxBlockSize = jmax (first.minBatchSize, roundToInt (first.sampleRate));
+
+    if (interleaveBuffer.getNumChannels() < writer.getNumChannels() || interleaveBuffer.getNumSamples() < maxBlockSize)
+        interleaveBuffer.setSize (writer.getNumChannels(), maxBlockSize);
+
+    bool ok = true;
+
+    for (int numLeft = numRows; numLeft > 0;)
+    {
+        const int numThisTime = jmin (numLeft, maxBlockSize);
+        juce::AudioBuffer<float> block (interleaveBuffer.getArrayOfWritePointers(), writer.getNumChannels(), numThisTime);
+        block.clear();
+
+        for (auto r : group)
+        {
+            int destStart = 0;
+
+            // Any dropped blocks are left silent to keep the channels in sync
+            r->readPending (numThisTime, [&] (const juce::AudioBuffer<float>* source, int start, int numSamples)
+            {
+                if (source != nullptr)
+                {
+                    for (int i = 0; i < r->channelsInFile.getLength(); ++i)
+                        block.copyFrom (r->channelsInFile.getStart() + i, destStart, *source, i, start, numSamples);
+
+                    numSamplesWritten += numSamples;
+                }
+
+                destStart += numSamples;
+            });
+        }
+
+        ok = writer.appendBuffer (block, numThisTime) && ok;
+
+        if (first.thumbnail != nullptr)
+            first.thumbnail->addBlock (block, 0, numThisTime);
+
+        ++numWrites;
+        numLeft -= numThisTime;
+    }
+
+    if (anyDrops && ! hasWarned)
+    {
+        hasWarned = true;
+        TRACKTION_LOG_ERROR ("Audio recording can't keep up!");
+    }
+
+    if (! ok && ! hasSentStop)
+    {
+        hasSentStop = true;
+        TRACKTION_LOG_ERROR ("Audio recording failed to write to disk!");
+        startTimer (1);
+    }
+
+    return true;
 }
 
 void WaveInputRecordingThread::run()
@@ -1669,38 +2275,59 @@ void WaveInputRecordingThread::run()
 
     for (;;)
     {
-        if (queue->numPending > 500 && ! hasWarned)
+        bool anyWritten = false;
+        juce::Array<Recording*> toWrite;
+
+        // The lock's only held to take a copy of the list so a slow disk doesn't hold up
+        // recordings being added or removed. Recordings aren't deleted until they've been
+        // marked as finished so the ones in the copy stay valid
         {
-            hasWarned = true;
-            TRACKTION_LOG_ERROR ("Audio recording can't keep up!");
+            const ScopedLock sl (recordingsLock);
+
+            for (auto r : recordings)
+                if (! r->isFinished)
+                    toWrite.add (r);
         }
 
-        if (auto block = queue->removeFirstPending())
+        const bool anyRecordings = ! toWrite.isEmpty();
+
+        while (! toWrite.isEmpty())
         {
-            if (! block->writer.load()->appendBuffer (block->buffer, block->buffer.getNumSamples()))
+            // Recordings sharing a writer are all written together
+            auto& writer = toWrite.getFirst()->writer;
+            juce::Array<Recording*> group;
+            bool allFinishing = true;
+
+            for (auto r : toWrite)
             {
-                if (! hasSentStop)
+                if (&r->writer == &writer)
                 {
-                    hasSentStop = true;
-                    TRACKTION_LOG_ERROR ("Audio recording failed to write to disk!");
-                    startTimer (1);
+                    group.add (r);
+                    allFinishing = allFinishing && r->isFinishing;
+
+                    if (r->fifo.getNumReady() > r->fifo.getTotalSize() / 2 && ! hasWarned)
+                    {
+                        hasWarned = true;
+                        TRACKTION_LOG_ERROR ("Audio recording can't keep up!");
+                    }
                 }
             }
 
-            if (block->thumbnail != nullptr)
-            {
-                block->thumbnail->addBlock (block->buffer, 0, block->buffer.getNumSamples());
-                block->thumbnail = nullptr;
-            }
+            toWrite.removeValuesIn (group);
+            anyWritten = writePendingBlocks (group, allFinishing || threadShouldExit()) || anyWritten;
 
-            queue->addToFreeQueue (block);
+            if (allFinishing)
+                for (auto r : group)
+                    r->isFinished = true;
         }
-        else
+
+        if (! anyWritten)
         {
             if (threadShouldExit())
                 break;
 
-            wait (401);
+            // The audio thread doesn't signal this thread so the FIFOs are polled whilst recording
+            wait (anyRecordings ? 10 : 401);
         }
     }
 }
@@ -1711,6 +2338,41 @@ void WaveInputRecordingThread::timerCallback()
     TransportControl::stopAllTransports (engine, false, false);
 }
 
+//==============================================================================
+WaveInputRecordingThread::Statistics WaveInputRecordingThread::getStatistics() const
+{
+    Statistics stats;
+    stats.numSamplesWritten = numSamplesWritten;
+    stats.numWrites = numWrites;
+    stats.numSamplesDropped = numSamplesDropped;
+    stats.highWaterMarkSeconds = highWaterMarkSeconds;
+
+    const ScopedLock sl (recordingsLock);
+    stats.numRecordings = recordings.size();
+
+    for (auto r : recordings)
+    {
+        stats.backlogSeconds = jmax (stats.backlogSeconds, r->fifo.getNumReady() / r->sampleRate);
+        stats.highWaterMarkSeconds = jmax (stats.highWaterMarkSeconds, r->highWaterMark / r->sampleRate);
+    }
+
+    return stats;
+}
+
+void WaveInputRecordingThread::resetStatistics()
+{
+    numSamplesWritten = 0;
+    numWrites = 0;
+    numSamplesDropped = 0;
+    highWaterMarkSeconds = 0.0;
+
+    const ScopedLock sl (recordingsLock);
+
+    for (auto r : recordings)
+        r->highWaterMark = 0;
+}
+
+//==============================================================================
 void WaveInputRecordingThread::prepareToStart()
 {
     flushAndStop();
@@ -1724,7 +2386,6 @@ void WaveInputRecordingThread::flushAndStop()
     signalThreadShouldExit();
     notify();
     stopThread (30000);
-    queue->moveAnyPendingBlocksToFree();
     hasSentStop = false;
     hasWarned = false;
 }
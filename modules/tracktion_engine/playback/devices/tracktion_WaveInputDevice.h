@@ -78,6 +78,7 @@ protected:
 private:
     friend class DeviceManager;
     friend class WaveInputDeviceInstance;
+    friend struct MultiChannelRecordingFile;
 
     const std::vector<ChannelIndex> deviceChannels;
     const DeviceType deviceType;
@@ -129,21 +130,70 @@ public:
     void removeUser();
 
     //==============================================================================
-    void addBlockToRecord (AudioFileWriter&, const juce::AudioBuffer<float>&,
-                           int start, int numSamples, const RecordingThumbnailManager::Thumbnail::Ptr&);
+    /** Buffers the incoming audio for a single AudioFileWriter. */
+    struct Recording;
+
+    /** Registers a writer to be recorded to, preallocating a FIFO large enough to hold
+        EngineBehaviour::getRecordingBufferLengthSeconds() of its audio.
+        The Recording returned should be passed to addBlockToRecord and remains valid
+        until waitForWriterToFinish is called for the writer.
+
+        Several Recordings can share a multichannel writer by each passing the range of
+        the writer's channels that it should fill. Their blocks are interleaved into the
+        file as it's written, with any channels that don't have a Recording left silent.
+        Each Recording must then be given the same number of samples.
+    */
+    Recording* prepareToRecord (AudioFileWriter&, const RecordingThumbnailManager::Thumbnail::Ptr&,
+                                juce::Range<int> channelsInFile = {});
+
+    /** Adds a block of audio to be written. This doesn't lock or allocate so can be
+        called from the audio thread. If the Recording's FIFO is full the block is dropped
+        and replaced with the same length of silence at the same position in the file.
+    */
+    void addBlockToRecord (Recording&, const juce::AudioBuffer<float>&, int start, int numSamples);
+
+    /** Blocks until all the audio for a writer has been written and then releases its Recordings. */
     void waitForWriterToFinish (AudioFileWriter&);
+
     void run() override;
     void timerCallback() override;
 
+    //==============================================================================
+    /** Describes how well the writer thread is keeping up with the incoming audio. */
+    struct Statistics
+    {
+        int numRecordings = 0;                  /**< The number of writers currently being recorded to. */
+        double backlogSeconds = 0.0;            /**< The largest amount of audio currently waiting to be written. */
+        double highWaterMarkSeconds = 0.0;      /**< The largest backlog since the statistics were reset. */
+        juce::int64 numSamplesWritten = 0;      /**< The total number of samples written to all writers. */
+        juce::int64 numWrites = 0;              /**< The number of batched writes made. */
+        juce::int64 numSamplesDropped = 0;      /**< The number of samples lost because a FIFO was full. */
+    };
+
+    /** Returns the statistics for all the recordings since they were last reset. */
+    Statistics getStatistics() const;
+
+    /** Resets the statistics. */
+    void resetStatistics();
+
     Engine& engine;
 
 private:
     int activeUsers = 0;
     bool hasWarned = false, hasSentStop = false;
 
-    struct BlockQueue;
-    std::unique_ptr<BlockQueue> queue;
+    juce::OwnedArray<Recording> recordings;
+    juce::CriticalSection recordingsLock;
+
+    std::atomic<juce::int64> numSamplesWritten { 0 }, numWrites { 0 }, numSamplesDropped { 0 };
+    std::atomic<double> highWaterMarkSeconds { 0.0 };
+
+    juce::AudioBuffer<float> interleaveBuffer;
 
+    juce::Array<Recording*> getRecordingsFor (AudioFileWriter&) const;
+    bool writePendingBlocks (const juce::Array<Recording*>&, bool writeEverything);
+    bool writePendingBlocks (Recording&, bool writeEverything);
+    bool writeInterleavedBlocks (const juce::Array<Recording*>&, bool writeEverything);
     void prepareToStart();
     void flushAndStop();
 
@@ -0,0 +1,556 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class WaveInputRecordingThreadTests    : public juce::UnitTest
+{
+public:
+    WaveInputRecordingThreadTests()
+        : juce::UnitTest ("WaveInputRecordingThread", "Tracktion:Longer") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+
+        beginTest ("Slow disk, real-time input");
+        {
+            // 64 channels at 96kHz with each write taking 20ms
+            auto stats = runStressTest (engine, 32, 96000.0, 2.0, 20, true);
+            expectEquals (stats.numSamplesDropped, (juce::int64) 0);
+            expectGreaterThan (stats.highWaterMarkSeconds, 0.0);
+            expectLessThan (stats.highWaterMarkSeconds, engine.getEngineBehaviour().getRecordingBufferLengthSeconds());
+            expectEquals (stats.numSamplesWritten, (juce::int64) (32 * 96000 * 2));
+            expectLessThan (stats.numWrites, stats.numSamplesWritten / 512, "Blocks should be coalesced into larger writes");
+        }
+
+        beginTest ("Stalled disk, overflowing the buffers");
+        {
+            // Input much faster than the disk can write it should drop blocks but keep the files in sync
+            const double lengthSeconds = engine.getEngineBehaviour().getRecordingBufferLengthSeconds() * 3.0;
+            auto stats = runStressTest (engine, 4, 48000.0, lengthSeconds, 50, false);
+            expectGreaterThan (stats.numSamplesDropped, (juce::int64) 0);
+            expectEquals (stats.numRecordings, 0);
+        }
+
+        beginTest ("Dropped blocks are replaced with silence in place");
+        {
+            testDroppedBlockPositions (engine, 1);
+        }
+
+        beginTest ("Interleaved multichannel file, dropped blocks in place");
+        {
+            testDroppedBlockPositions (engine, 2);
+        }
+
+        beginTest ("Interleaved multichannel file");
+        {
+            testInterleavedRecording (engine, { 1, 2, 2, 1, 2 }, false);
+        }
+
+        beginTest ("Interleaved multichannel file, stalled disk");
+        {
+            testInterleavedRecording (engine, { 2, 2, 2, 2 }, true);
+        }
+
+        beginTest ("Discrete channel names");
+        {
+            auto set = juce::AudioChannelSet::discreteChannels (40);
+            set.removeChannel (juce::AudioChannelSet::discreteChannel0);
+            expect (channelSetFromSpeakerArrangmentString (set.getSpeakerArrangementAsString()) == set);
+            expect (channelSetFromSpeakerArrangmentString ("L R") == juce::AudioChannelSet::stereo());
+            expect (channelTypeFromAbbreviatedName ("#0") == juce::AudioChannelSet::unknown);
+            expect (channelTypeFromAbbreviatedName ("#3x") == juce::AudioChannelSet::unknown);
+        }
+    }
+
+private:
+    //==============================================================================
+    /** Wraps a writer to simulate a slow disk. */
+    struct SlowAudioFormatWriter  : public juce::AudioFormatWriter
+    {
+        SlowAudioFormatWriter (juce::AudioFormatWriter* w, int delay)
+            : juce::AudioFormatWriter (nullptr, "Slow", w->getSampleRate(),
+                                       (unsigned int) w->getNumChannels(), (unsigned int) w->getBitsPerSample()),
+              writer (w), delayMs (delay)
+        {
+            usesFloatingPointData = writer->isFloatingPoint();
+        }
+
+        bool write (const int** samples, int numSamples) override
+        {
+            juce::Thread::sleep (delayMs);
+            return writer->write (samples, numSamples);
+        }
+
+        bool flush() override
+        {
+            return writer->flush();
+        }
+
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        const int delayMs;
+    };
+
+    struct SlowWavAudioFormat  : public juce::WavAudioFormat
+    {
+        SlowWavAudioFormat (int delay) : delayMs (delay) {}
+
+        using juce::WavAudioFormat::createWriterFor;
+
+        juce::AudioFormatWriter* createWriterFor (juce::OutputStream* out, double sampleRate, unsigned int numChannels,
+                                                  int bitsPerSample, const juce::StringPairArray& metadata, int quality) override
+        {
+            if (auto w = juce::WavAudioFormat::createWriterFor (out, sampleRate, numChannels, bitsPerSample, metadata, quality))
+                return new SlowAudioFormatWriter (w, delayMs);
+
+            return nullptr;
+        }
+
+        const int delayMs;
+    };
+
+    //==============================================================================
+    WaveInputRecordingThread::Statistics runStressTest (Engine& engine, int numStereoInputs, double sampleRate,
+                                                        double lengthSeconds, int writeDelayMs, bool realTime)
+    {
+        auto& thread = engine.getWaveInputRecordingThread();
+        WaveInputRecordingThread::ScopedInitialiser initialiser (thread);
+        thread.resetStatistics();
+
+        SlowWavAudioFormat format (writeDelayMs);
+        juce::OwnedArray<juce::TemporaryFile> files;
+        std::vector<std::unique_ptr<AudioFileWriter>> writers;
+        std::vector<WaveInputRecordingThread::Recording*> recordings;
+
+        for (int i = 0; i < numStereoInputs; ++i)
+        {
+            auto f = files.add (new juce::TemporaryFile (".wav"));
+            writers.push_back (std::make_unique<AudioFileWriter> (AudioFile (engine, f->getFile()), &format,
+                                                                  2, sampleRate, 24, juce::StringPairArray(), 0));
+            expect (writers.back()->isOpen());
+            recordings.push_back (thread.prepareToRecord (*writers.back(), {}));
+        }
+
+        // Simulate the audio callback
+        const int blockSize = 512;
+        const auto totalNumSamples = (int) (sampleRate * lengthSeconds);
+        juce::AudioBuffer<float> block (2, blockSize);
+        juce::Random r;
+
+        for (int i = 0; i < block.getNumSamples(); ++i)
+            for (int c = 0; c < block.getNumChannels(); ++c)
+                block.setSample (c, i, r.nextFloat() - 0.5f);
+
+        for (int pos = 0; pos < totalNumSamples; pos += blockSize)
+        {
+            const int numSamples = juce::jmin (blockSize, totalNumSamples - pos);
+
+            for (auto recording : recordings)
+                thread.addBlockToRecord (*recording, block, 0, numSamples);
+
+            if (realTime)
+                juce::Thread::sleep ((int) (1000.0 * blockSize / sampleRate));
+        }
+
+        for (auto& w : writers)
+        {
+            thread.waitForWriterToFinish (*w);
+            w.reset();
+        }
+
+        // Even if blocks were dropped, the files should be the right length
+        juce::WavAudioFormat wav;
+
+        for (auto f : files)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (f->getFile().createInputStream().release(), true));
+            expect (reader != nullptr);
+
+            if (reader != nullptr)
+                expectEquals (reader->lengthInSamples, (juce::int64) totalNumSamples);
+        }
+
+        return thread.getStatistics();
+    }
+
+    /** Records several inputs of different widths into one file, each filling its
+        channels with a constant value, and checks they end up in the right channels.
+    */
+    void testInterleavedRecording (Engine& engine, std::vector<int> inputWidths, bool slowDisk)
+    {
+        auto& thread = engine.getWaveInputRecordingThread();
+        WaveInputRecordingThread::ScopedInitialiser initialiser (thread);
+        thread.resetStatistics();
+
+        const double sampleRate = 48000.0;
+        const int numChannels = std::accumulate (inputWidths.begin(), inputWidths.end(), 0);
+        const double lengthSeconds = slowDisk ? engine.getEngineBehaviour().getRecordingBufferLengthSeconds() * 3.0 : 1.0;
+        const int totalNumSamples = (int) (sampleRate * lengthSeconds);
+
+        SlowWavAudioFormat format (slowDisk ? 50 : 0);
+        juce::TemporaryFile file (".wav");
+        auto writer = std::make_unique<AudioFileWriter> (AudioFile (engine, file.getFile()), &format,
+                                                         numChannels, sampleRate, 32, juce::StringPairArray(), 0);
+        expect (writer->isOpen());
+
+        std::vector<WaveInputRecordingThread::Recording*> recordings;
+        int firstChannel = 0;
+
+        for (auto width : inputWidths)
+        {
+            recordings.push_back (thread.prepareToRecord (*writer, {}, { firstChannel, firstChannel + width }));
+            firstChannel += width;
+        }
+
+        const int blockSize = 512;
+
+        for (int pos = 0; pos < totalNumSamples; pos += blockSize)
+        {
+            const int numSamples = juce::jmin (blockSize, totalNumSamples - pos);
+
+            for (size_t i = 0; i < recordings.size(); ++i)
+            {
+                juce::AudioBuffer<float> block (inputWidths[i], numSamples);
+
+                for (int c = 0; c < block.getNumChannels(); ++c)
+                    juce::FloatVectorOperations::fill (block.getWritePointer (c), getValueForInput ((int) i, c), numSamples);
+
+                thread.addBlockToRecord (*recordings[i], block, 0, numSamples);
+            }
+        }
+
+        thread.waitForWriterToFinish (*writer);
+        writer.reset();
+
+        const auto stats = thread.getStatistics();
+        expectEquals (stats.numRecordings, 0);
+
+        // Samples are counted per Recording, the same as when each has its own file
+        if (! slowDisk)
+            expectEquals (stats.numSamplesWritten, (juce::int64) totalNumSamples * (juce::int64) recordings.size());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (file.getFile().createInputStream().release(), true));
+        expect (reader != nullptr);
+
+        if (reader == nullptr)
+            return;
+
+        expectEquals ((int) reader->numChannels, numChannels);
+        expectEquals (reader->lengthInSamples, (juce::int64) totalNumSamples);
+
+        juce::AudioBuffer<float> contents (numChannels, totalNumSamples);
+        reader->read (&contents, 0, totalNumSamples, 0, true, true);
+        firstChannel = 0;
+
+        for (size_t i = 0; i < inputWidths.size(); ++i)
+        {
+            for (int c = 0; c < inputWidths[i]; ++c)
+            {
+                auto range = contents.findMinMax (firstChannel + c, 0, totalNumSamples);
+                const auto value = getValueForInput ((int) i, c);
+
+                // Any dropped blocks are silent, but no audio should end up in the wrong channel
+                expectEquals (range.getEnd(), value);
+
+                if (slowDisk)
+                    expect (range.getStart() == 0.0f || range.getStart() == value);
+                else
+                    expectEquals (range.getStart(), value);
+            }
+
+            firstChannel += inputWidths[i];
+        }
+    }
+
+    /** Records blocks that each contain their own index to a disk that's too slow to keep
+        up, and checks that the dropped blocks are replaced with silence where they were
+        dropped rather than later on in the file.
+    */
+    void testDroppedBlockPositions (Engine& engine, int numInputs)
+    {
+        auto& thread = engine.getWaveInputRecordingThread();
+        WaveInputRecordingThread::ScopedInitialiser initialiser (thread);
+        thread.resetStatistics();
+
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numBlocks = (int) (engine.getEngineBehaviour().getRecordingBufferLengthSeconds() * 3.0 * sampleRate / blockSize);
+
+        SlowWavAudioFormat format (50);
+        juce::TemporaryFile file (".wav");
+        auto writer = std::make_unique<AudioFileWriter> (AudioFile (engine, file.getFile()), &format,
+                                                         numInputs, sampleRate, 32, juce::StringPairArray(), 0);
+        expect (writer->isOpen());
+
+        std::vector<WaveInputRecordingThread::Recording*> recordings;
+
+        for (int i = 0; i < numInputs; ++i)
+            recordings.push_back (thread.prepareToRecord (*writer, {}, numInputs == 1 ? juce::Range<int>()
+                                                                                      : juce::Range<int> (i, i + 1)));
+
+        juce::AudioBuffer<float> block (1, blockSize);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            juce::FloatVectorOperations::fill (block.getWritePointer (0), getValueForBlock (i), blockSize);
+
+            for (auto r : recordings)
+                thread.addBlockToRecord (*r, block, 0, blockSize);
+        }
+
+        thread.waitForWriterToFinish (*writer);
+        writer.reset();
+        expectGreaterThan (thread.getStatistics().numSamplesDropped, (juce::int64) 0);
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (file.getFile().createInputStream().release(), true));
+        expect (reader != nullptr);
+
+        if (reader == nullptr)
+            return;
+
+        expectEquals (reader->lengthInSamples, (juce::int64) numBlocks * blockSize);
+
+        juce::AudioBuffer<float> contents (numInputs, numBlocks * blockSize);
+        reader->read (&contents, 0, contents.getNumSamples(), 0, true, true);
+
+        for (int chan = 0; chan < numInputs; ++chan)
+        {
+            int numSilent = 0, numMisplaced = 0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                auto range = contents.findMinMax (chan, i * blockSize, blockSize);
+
+                if (range == juce::Range<float>())
+                    ++numSilent;
+                else if (range != juce::Range<float> (getValueForBlock (i), getValueForBlock (i)))
+                    ++numMisplaced;
+            }
+
+            expectGreaterThan (numSilent, 0);
+            expectEquals (numMisplaced, 0);
+        }
+    }
+
+    static float getValueForBlock (int blockIndex)
+    {
+        return (blockIndex + 1) / 8192.0f;
+    }
+
+    static float getValueForInput (int inputIndex, int channel)
+    {
+        return (inputIndex + 1) / 16.0f + channel / 64.0f;
+    }
+};
+
+static WaveInputRecordingThreadTests waveInputRecordingThreadTests;
+
+
+//==============================================================================
+//==============================================================================
+class MultiChannelRecordingTests    : public juce::UnitTest
+{
+public:
+    MultiChannelRecordingTests()
+        : juce::UnitTest ("MultiChannelRecording", "Tracktion:Longer") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        // This needs its own Engine as the EngineBehaviour enables the multichannel file
+        Engine engine ("MultiChannelRecordingTests", nullptr, std::make_unique<MultiChannelEngineBehaviour>());
+
+        HostedAudioDeviceInterface::Parameters params;
+        params.sampleRate = 44100.0;
+        params.blockSize = 256;
+        params.inputChannels = 4;
+        params.fixedBlockSize = true;
+
+        auto& deviceManager = engine.getDeviceManager();
+        auto& audioIO = deviceManager.getHostedAudioDeviceInterface();
+        audioIO.initialise (params);
+        audioIO.prepareToPlay (params.sampleRate, params.blockSize);
+
+        const auto tempDir = juce::File::createTempFile ({});
+        const auto originalCwd = juce::File::getCurrentWorkingDirectory();
+        tempDir.createDirectory();
+        tempDir.setAsCurrentWorkingDirectory();
+
+        beginTest ("Recording discrete channels and playing back the clips");
+        {
+            testRecordingAndPlayback (engine, audioIO, params);
+        }
+
+        originalCwd.setAsCurrentWorkingDirectory();
+        tempDir.deleteRecursively (false);
+
+        deviceManager.closeDevices();
+        deviceManager.removeHostedAudioDeviceInterface();
+        deviceManager.deviceManager.closeAudioDevice();
+    }
+
+private:
+    struct MultiChannelEngineBehaviour  : public EngineBehaviour
+    {
+        bool autoInitialiseDeviceManager() override             { return false; }
+        bool shouldRecordInputsToMultiChannelFile() override    { return true; }
+    };
+
+    /** Each input records a constant value so its channel can be identified. */
+    static float getValueForChannel (int channel)
+    {
+        return (channel + 1) / 8.0f;
+    }
+
+    void testRecordingAndPlayback (Engine& engine, HostedAudioDeviceInterface& audioIO,
+                                   const HostedAudioDeviceInterface::Parameters& params)
+    {
+        auto edit = std::make_unique<Edit> (Edit::Options { engine, createEmptyEdit (engine), ProjectItemID::createNewID (0) });
+        auto& transport = edit->getTransport();
+        transport.ensureContextAllocated();
+
+        edit->ensureNumberOfAudioTracks (params.inputChannels);
+        auto tracks = getAudioTracks (*edit);
+        auto inputs = transport.getCurrentPlaybackContext()->getAllInputs();
+        inputs.removeIf ([] (auto instance) { return instance->owner.isMidi(); });
+        expectEquals (inputs.size(), params.inputChannels);
+
+        if (inputs.size() != params.inputChannels)
+            return;
+
+        for (int i = 0; i < params.inputChannels; ++i)
+        {
+            inputs[i]->setTargetTrack (*tracks[i], 0, true);
+            inputs[i]->setRecordingEnabled (*tracks[i], true);
+        }
+
+        // Record a second of each input's value
+        {
+            std::atomic<bool> shouldStop { false };
+
+            std::thread audioThread ([&]
+            {
+                juce::AudioBuffer<float> buffer (params.inputChannels, params.blockSize);
+                juce::MidiBuffer midi;
+                const auto blockDuration = std::chrono::microseconds ((int) (1.0e6 * params.blockSize / params.sampleRate));
+
+                while (! shouldStop)
+                {
+                    const auto endTime = std::chrono::steady_clock::now() + blockDuration;
+
+                    for (int c = 0; c < params.inputChannels; ++c)
+                        juce::FloatVectorOperations::fill (buffer.getWritePointer (c), getValueForChannel (c), params.blockSize);
+
+                    audioIO.processBlock (buffer, midi);
+                    midi.clear();
+                    std::this_thread::sleep_until (endTime);
+                }
+            });
+
+            transport.record (false, false);
+            auto& epc = *transport.getCurrentPlaybackContext();
+
+            while (epc.getUnloopedPosition() < 1.0)
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+            transport.stop (false, true);
+            shouldStop = true;
+            audioThread.join();
+        }
+
+        // All the clips should share one file, each using its own channel
+        juce::Array<WaveAudioClip*> clips;
+
+        for (auto t : tracks)
+            for (auto c : t->getClips())
+                if (auto wc = dynamic_cast<WaveAudioClip*> (c))
+                    clips.add (wc);
+
+        expectEquals (clips.size(), params.inputChannels);
+
+        if (clips.size() != params.inputChannels)
+            return;
+
+        const auto sourceFile = clips.getFirst()->getCurrentSourceFile();
+        std::unique_ptr<juce::AudioFormatReader> reader (AudioFileUtils::createReaderFor (engine, sourceFile));
+        expect (reader != nullptr);
+
+        if (reader != nullptr)
+            expectEquals ((int) reader->numChannels, params.inputChannels);
+
+        for (int i = 0; i < clips.size(); ++i)
+        {
+            expect (clips[i]->getCurrentSourceFile() == sourceFile);
+
+            auto channels = clips[i]->getActiveChannels();
+            expectEquals (channels.size(), 1);
+            expect (channels.getTypeOfChannel (0) == static_cast<juce::AudioChannelSet::ChannelType> (juce::AudioChannelSet::discreteChannel0 + i));
+        }
+
+        // Rendering each track on its own should play back just its input's channel
+        const auto clipTime = clips.getFirst()->getPosition().time;
+        const EditTimeRange renderTime (clipTime.getStart() + 0.2, clipTime.getStart() + 0.5);
+        juce::Array<float> levels;
+
+        for (int i = 0; i < tracks.size(); ++i)
+        {
+            juce::TemporaryFile renderFile (".wav");
+
+            Renderer::Parameters r (*edit);
+            r.tracksToDo.setBit (tracks[i]->getIndexInEditTrackList());
+            r.destFile = renderFile.getFile();
+            r.audioFormat = engine.getAudioFileFormatManager().getWavFormat();
+            r.bitDepth = 32;
+            r.blockSizeForAudio = params.blockSize;
+            r.sampleRateForAudio = params.sampleRate;
+            r.time = renderTime;
+            r.canRenderInMono = false;
+
+            expect (Renderer::renderToFile ({}, r) == r.destFile);
+
+            std::unique_ptr<juce::AudioFormatReader> renderReader (AudioFileUtils::createReaderFor (engine, r.destFile));
+            expect (renderReader != nullptr);
+
+            if (renderReader == nullptr)
+                return;
+
+            juce::AudioBuffer<float> rendered ((int) renderReader->numChannels, (int) renderReader->lengthInSamples);
+            renderReader->read (&rendered, 0, rendered.getNumSamples(), 0, true, true);
+            auto range = rendered.findMinMax (0, 0, rendered.getNumSamples());
+
+            expectWithinAbsoluteError (range.getStart(), range.getEnd(), 1.0e-4f);
+            levels.add (range.getEnd());
+        }
+
+        // The track gains are all the same so the levels should be in the ratio of the inputs' values
+        for (int i = 0; i < levels.size(); ++i)
+            expectWithinAbsoluteError (levels[i] / getValueForChannel (i), levels[0] / getValueForChannel (0), 1.0e-3f);
+
+        expectGreaterThan (levels[0], 0.0f);
+
+        edit.reset();
+        engine.getAudioFileManager().releaseAllFiles();
+    }
+};
+
+static MultiChannelRecordingTests multiChannelRecordingTests;
+
+#endif
+
+} // namespace tracktion_engine
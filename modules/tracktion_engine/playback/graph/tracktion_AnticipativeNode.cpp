@@ -0,0 +1,484 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace anticipative_node
+{
+    /** The workers check whether the audio thread needs the subgraph after each chunk. */
+    static constexpr int maxChunkSize = 128;
+
+    /** Finds the AnticipativeNode with the given ID in the graph being replaced. */
+    static AnticipativeNode* findNodeToReplace (tracktion_graph::Node* rootNodeToReplace, size_t nodeID)
+    {
+        AnticipativeNode* nodeToReplace = nullptr;
+
+        if (rootNodeToReplace == nullptr || nodeID == 0)
+            return nullptr;
+
+        tracktion_graph::visitNodes (*rootNodeToReplace,
+                                     [&] (tracktion_graph::Node& n)
+                                     {
+                                         if (auto other = dynamic_cast<AnticipativeNode*> (&n))
+                                             if (other->getNodeProperties().nodeID == nodeID)
+                                                 nodeToReplace = other;
+                                     }, true);
+
+        return nodeToReplace;
+    }
+}
+
+//==============================================================================
+/** Keeps track of all the AnticipativeNodes and the threads that render them. */
+class AnticipativeNode::SharedState  : private juce::DeletedAtShutdown
+{
+public:
+    SharedState() = default;
+
+    ~SharedState() override
+    {
+        for (auto w : workers)
+            w->signalThreadShouldExit();
+
+        workAvailable.signal (workers.size());
+        workers.clear();
+        clearSingletonInstance();
+    }
+
+    JUCE_DECLARE_SINGLETON (SharedState, false)
+
+    //==============================================================================
+    void addNode (AnticipativeNode& node)
+    {
+        const juce::ScopedLock sl (lock);
+        nodes.add (&node);
+
+        if (workers.isEmpty())
+            for (int i = juce::jlimit (1, 4, juce::SystemStats::getNumCpus() / 2); --i >= 0;)
+                workers.add (new Worker (*this));
+    }
+
+    void removeNode (AnticipativeNode& node)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            nodes.removeFirstMatchingValue (&node);
+        }
+
+        // A worker might be part way through a chunk
+        node.cancelRendering = true;
+
+        while (node.owner.load (std::memory_order_acquire) == workerOwned)
+            std::this_thread::yield();
+    }
+
+    void notifyWorkers() noexcept
+    {
+        // This is called on the audio thread so mustn't take any locks
+        workAvailable.signal();
+    }
+
+private:
+    //==============================================================================
+    class Worker  : public juce::Thread
+    {
+    public:
+        Worker (SharedState& s)
+            : juce::Thread ("AnticipativeRender"), owner (s)
+        {
+            startThread (8);
+        }
+
+        ~Worker() override
+        {
+            stopThread (10000);
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                if (auto node = owner.takeNextNode())
+                {
+                    node->renderNextBlock();
+                    node->releaseFromWorker();
+                }
+                else
+                {
+                    owner.workAvailable.wait();
+                }
+            }
+        }
+
+    private:
+        SharedState& owner;
+    };
+
+    juce::CriticalSection lock;
+    juce::Array<AnticipativeNode*> nodes;
+    juce::OwnedArray<Worker> workers;
+    tracktion_graph::LightweightSemaphore workAvailable;
+
+    /** Returns the Node with the least audio rendered ahead, having taken ownership of it. */
+    AnticipativeNode* takeNextNode()
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (;;)
+        {
+            AnticipativeNode* next = nullptr;
+            int64_t nextNumAhead = 0;
+
+            for (auto n : nodes)
+            {
+                if (n->owner.load (std::memory_order_relaxed) != unowned || ! n->needsRendering())
+                    continue;
+
+                const auto numAhead = n->renderedEnd.load (std::memory_order_relaxed) - n->consumedEnd.load (std::memory_order_relaxed);
+
+                if (next == nullptr || numAhead < nextNumAhead)
+                {
+                    next = n;
+                    nextNumAhead = numAhead;
+                }
+            }
+
+            if (next == nullptr)
+                return nullptr;
+
+            // If this fails the audio thread got there first
+            int expected = unowned;
+
+            if (next->owner.compare_exchange_strong (expected, workerOwned))
+                return next;
+        }
+    }
+};
+
+JUCE_IMPLEMENT_SINGLETON (AnticipativeNode::SharedState)
+
+//==============================================================================
+AnticipativeNode::AnticipativeNode (ProcessState& processStateToFollowToUse, const NodeBuilder& createInputNode, int numBlocksAheadToUse)
+    : processStateToFollow (processStateToFollowToUse),
+      player (processState, tracktion_graph::getPoolCreatorFunction (tracktion_graph::ThreadPoolStrategy::realTime)),
+      numBlocksAhead (std::max (2, numBlocksAheadToUse))
+{
+    player.setNumThreads (0);
+    input = createInputNode (processState);
+    inputNode = input.get();
+}
+
+AnticipativeNode::~AnticipativeNode()
+{
+    if (isRegistered)
+        SharedState::getInstance()->removeNode (*this);
+}
+
+bool AnticipativeNode::isBufferFull() const noexcept
+{
+    const auto numAhead = renderedEnd.load (std::memory_order_acquire) - consumedEnd.load (std::memory_order_acquire);
+    return numAhead + blockSize > (int64_t) ringBuffer.getNumFrames();
+}
+
+//==============================================================================
+std::vector<tracktion_graph::Node*> AnticipativeNode::getDirectInputNodes()
+{
+    // The subgraph is processed by this Node's own player. The outer player processes every
+    // Node it can reach from here, so returning the subgraph would process it a second time
+    return {};
+}
+
+tracktion_graph::NodeProperties AnticipativeNode::getNodeProperties()
+{
+    jassert (inputNode != nullptr);
+    auto props = inputNode->getNodeProperties();
+
+    constexpr size_t anticipativeMagicHash = 0x616e746963;
+    props.hasMidi = false;
+    props.nodeID = tracktion_graph::hash (anticipativeMagicHash, props.nodeID);
+
+    return props;
+}
+
+void AnticipativeNode::prepareToPlay (const tracktion_graph::PlaybackInitialisationInfo& info)
+{
+    if (isRegistered)
+    {
+        SharedState::getInstance()->removeNode (*this);
+        isRegistered = false;
+    }
+
+    cancelRendering = false;
+
+    blockSize = info.blockSize;
+    numChannels = getNodeProperties().numberOfChannels;
+
+    ringBuffer.resize ({ (choc::buffer::ChannelCount) numChannels, (choc::buffer::FrameCount) (numBlocksAhead * blockSize) });
+    scratchBuffer.resize ({ (choc::buffer::ChannelCount) numChannels, (choc::buffer::FrameCount) blockSize });
+
+    if (input != nullptr)
+    {
+        // Let the subgraph take over any state from the one it's replacing, e.g. plugin latency buffers
+        auto nodeToReplace = anticipative_node::findNodeToReplace (info.rootNodeToReplace, getNodeProperties().nodeID);
+        player.setNode (std::move (input), info.sampleRate, info.blockSize,
+                        nodeToReplace != nullptr ? nodeToReplace->getInputNode() : nullptr);
+
+        inputLeafNodes.clear();
+
+        for (auto n : tracktion_graph::getNodes (*inputNode, tracktion_graph::VertexOrdering::postordering))
+            if (n->getDirectInputNodes().empty())
+                inputLeafNodes.push_back (n);
+    }
+    else
+    {
+        player.prepareToPlay (info.sampleRate, info.blockSize);
+    }
+
+    // Start from nothing rendered so the first block gets processed directly
+    renderAhead = false;
+    renderedEnd = 0;
+    consumedEnd = 0;
+    syncedInteractionTime = {};
+
+    SharedState::getInstance()->addNode (*this);
+    isRegistered = true;
+}
+
+bool AnticipativeNode::isReadyToProcess()
+{
+    // This is a leaf of the outer graph so report whether the subgraph's leaves are ready,
+    // e.g. so the Renderer waits for their files in the same way it would without this Node
+    for (auto n : inputLeafNodes)
+        if (! n->isReadyToProcess())
+            return false;
+
+    return true;
+}
+
+void AnticipativeNode::process (ProcessContext& pc)
+{
+    if (! tryToCopyRenderedBlock (pc))
+        processDirectly (pc);
+
+    if (renderAhead.load (std::memory_order_relaxed))
+        SharedState::getInstance()->notifyWorkers();
+}
+
+//==============================================================================
+bool AnticipativeNode::canRenderAhead() const
+{
+    auto& playHeadToFollow = processStateToFollow.playHeadState.playHead;
+
+    return playHeadToFollow.isPlaying()
+        && ! playHeadToFollow.isUserDragging()
+        && ! playHeadToFollow.isRollingIntoLoop();
+}
+
+bool AnticipativeNode::isFollowing (juce::Range<int64_t> referenceSampleRange) const
+{
+    auto& playHeadToFollow = processStateToFollow.playHeadState.playHead;
+    const auto start = referenceSampleRange.getStart();
+
+    return playHeadToFollow.getLastUserInteractionTime() == syncedInteractionTime
+        && playHeadToFollow.isPlaying() == playHead.isPlaying()
+        && playHeadToFollow.isLooping() == playHead.isLooping()
+        && playHeadToFollow.getLoopRange() == playHead.getLoopRange()
+        && playHeadToFollow.isUserDragging() == playHead.isUserDragging()
+        && playHeadToFollow.isRollingIntoLoop() == playHead.isRollingIntoLoop()
+        && playHeadToFollow.referenceSamplePositionToTimelinePosition (start) == playHead.referenceSamplePositionToTimelinePosition (start);
+}
+
+bool AnticipativeNode::tryToCopyRenderedBlock (ProcessContext& pc)
+{
+    const auto range = pc.referenceSampleRange;
+
+    if (! renderAhead.load (std::memory_order_relaxed))
+        return false;
+
+    if (range.getStart() != consumedEnd.load (std::memory_order_relaxed)
+        || range.getEnd() > renderedEnd.load (std::memory_order_acquire))
+        return false;
+
+    if (! canRenderAhead() || ! isFollowing (range))
+        return false;
+
+    copyFromRingBuffer (pc.buffers.audio, range.getStart());
+    consumedEnd.store (range.getEnd(), std::memory_order_release);
+    numBlocksRenderedAhead.fetch_add (1, std::memory_order_relaxed);
+
+    return true;
+}
+
+void AnticipativeNode::processDirectly (ProcessContext& pc)
+{
+    auto range = pc.referenceSampleRange;
+    auto destAudio = pc.buffers.audio;
+    takeOwnershipOnAudioThread();
+
+    const auto processedEnd = renderedEnd.load (std::memory_order_relaxed);
+    const bool isContiguous = isFollowing (range) && range.getStart() == consumedEnd.load (std::memory_order_relaxed);
+
+    if (isContiguous && processedEnd > range.getStart() && processedEnd < range.getEnd())
+    {
+        // The workers have got part way through this block so use that and process the rest
+        const auto numFramesRendered = (choc::buffer::FrameCount) (processedEnd - range.getStart());
+        copyFromRingBuffer (destAudio.getStart (numFramesRendered), range.getStart());
+        destAudio = destAudio.getFrameRange ({ numFramesRendered, destAudio.getNumFrames() });
+        range.setStart (processedEnd);
+    }
+    else if (! isContiguous || processedEnd != range.getStart())
+    {
+        // Anything rendered ahead is out of date so start following the outer PlayHead again
+        auto& playHeadToFollow = processStateToFollow.playHeadState.playHead;
+        playHead.copyStateFrom (playHeadToFollow);
+        syncedInteractionTime = playHeadToFollow.getLastUserInteractionTime();
+    }
+
+    scratchMidi.clear();
+    player.process ({ range, { destAudio, scratchMidi } });
+
+    renderedEnd.store (range.getEnd(), std::memory_order_release);
+    consumedEnd.store (range.getEnd(), std::memory_order_release);
+    renderAhead.store (canRenderAhead(), std::memory_order_relaxed);
+    numBlocksProcessedDirectly.fetch_add (1, std::memory_order_relaxed);
+
+    cancelRendering = false;
+    owner.store (unowned, std::memory_order_release);
+}
+
+void AnticipativeNode::takeOwnershipOnAudioThread() noexcept
+{
+    // A worker stops after the chunk it's rendering and signals when it's let go. These use
+    // sequentially consistent ordering so either the worker sees the cancellation or this
+    // sees that it's been let go
+    cancelRendering = true;
+
+    for (;;)
+    {
+        int expected = unowned;
+
+        if (owner.compare_exchange_strong (expected, audioThreadOwned))
+            return;
+
+        workerReleased.wait();
+    }
+}
+
+void AnticipativeNode::releaseFromWorker() noexcept
+{
+    owner = unowned;
+
+    if (cancelRendering)
+        workerReleased.signal();
+}
+
+//==============================================================================
+bool AnticipativeNode::needsRendering() const noexcept
+{
+    return renderAhead.load (std::memory_order_relaxed) && ! isBufferFull();
+}
+
+bool AnticipativeNode::renderNextBlock()
+{
+    jassert (owner.load() == workerOwned);
+
+    if (! needsRendering())
+        return false;
+
+    const auto start = renderedEnd.load (std::memory_order_relaxed);
+    const auto end = start + blockSize;
+
+    for (auto chunkStart = start; chunkStart < end;)
+    {
+        if (cancelRendering)
+            break;
+
+        const auto numFrames = (choc::buffer::FrameCount) std::min<int64_t> (anticipative_node::maxChunkSize, end - chunkStart);
+        const auto range = juce::Range<int64_t>::withStartAndLength (chunkStart, (int64_t) numFrames);
+
+        auto destAudio = scratchBuffer.getStart (numFrames);
+        destAudio.clear();
+        scratchMidi.clear();
+        player.process ({ range, { destAudio, scratchMidi } });
+
+        copyToRingBuffer (destAudio, chunkStart);
+        chunkStart = range.getEnd();
+        renderedEnd.store (chunkStart, std::memory_order_release);
+    }
+
+    return renderedEnd.load (std::memory_order_relaxed) > start;
+}
+
+void AnticipativeNode::copyToRingBuffer (choc::buffer::ChannelArrayView<float> source, int64_t startSample)
+{
+    const auto ringSize = (int64_t) ringBuffer.getNumFrames();
+    const auto numFrames = source.getNumFrames();
+    const auto ringStart = (choc::buffer::FrameCount) (startSample % ringSize);
+    const auto numBeforeWrap = std::min (numFrames, (choc::buffer::FrameCount) ringSize - ringStart);
+
+    choc::buffer::copy (ringBuffer.getFrameRange ({ ringStart, ringStart + numBeforeWrap }),
+                        source.getStart (numBeforeWrap));
+
+    if (numBeforeWrap < numFrames)
+        choc::buffer::copy (ringBuffer.getStart (numFrames - numBeforeWrap),
+                            source.getFrameRange ({ numBeforeWrap, numFrames }));
+}
+
+void AnticipativeNode::copyFromRingBuffer (choc::buffer::ChannelArrayView<float> dest, int64_t startSample)
+{
+    const auto ringSize = (int64_t) ringBuffer.getNumFrames();
+    const auto numFrames = dest.getNumFrames();
+    const auto ringStart = (choc::buffer::FrameCount) (startSample % ringSize);
+    const auto numBeforeWrap = std::min (numFrames, (choc::buffer::FrameCount) ringSize - ringStart);
+
+    choc::buffer::copyIntersection (dest.getStart (numBeforeWrap),
+                                    ringBuffer.getFrameRange ({ ringStart, ringStart + numBeforeWrap }));
+
+    if (numBeforeWrap < numFrames)
+        choc::buffer::copyIntersection (dest.getFrameRange ({ numBeforeWrap, numFrames }),
+                                        ringBuffer.getStart (numFrames - numBeforeWrap));
+}
+
+//==============================================================================
+std::vector<tracktion_graph::Node*> getNodesIncludingSubgraphs (tracktion_graph::Node& node, tracktion_graph::VertexOrdering ordering)
+{
+    using tracktion_graph::VertexOrdering;
+    const bool inputsFirst = ordering == VertexOrdering::postordering
+                              || ordering == VertexOrdering::reversePreordering
+                              || ordering == VertexOrdering::bfsReversePreordering;
+
+    std::vector<tracktion_graph::Node*> nodes;
+
+    for (auto n : tracktion_graph::getNodes (node, ordering))
+    {
+        auto anticipativeNode = dynamic_cast<AnticipativeNode*> (n);
+        auto subgraph = anticipativeNode != nullptr ? anticipativeNode->getInputNode() : nullptr;
+
+        if (subgraph == nullptr)
+        {
+            nodes.push_back (n);
+            continue;
+        }
+
+        if (! inputsFirst)
+            nodes.push_back (n);
+
+        for (auto subgraphNode : getNodesIncludingSubgraphs (*subgraph, ordering))
+            nodes.push_back (subgraphNode);
+
+        if (inputsFirst)
+            nodes.push_back (n);
+    }
+
+    return nodes;
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,149 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Processes a subgraph a few blocks ahead of the audio callback on a background thread.
+
+    The subgraph gets its own PlayHead and ProcessState which follow the ones of the
+    graph this Node is part of. While that is playing, worker threads render the subgraph
+    in to a ring buffer which this Node then copies from.
+
+    Whenever the rendered audio can't be used, e.g. after a seek, loop change, stop or when
+    the workers have fallen behind, the buffer is discarded and the subgraph is processed
+    directly on the audio thread for that block, in the same way as if this Node weren't
+    there. Rendering ahead then starts again from the following block.
+
+    The workers render in short chunks and stop after the current one when the audio
+    thread needs the subgraph, so the audio thread is never held up for longer than that.
+
+    Because the subgraph is processed ahead of time, parameter changes made to its
+    plugins will be heard a few blocks later than usual so this should only be used
+    for parts of an Edit that don't have live inputs.
+
+    The subgraph is processed by this Node's own player so it isn't one of this Node's
+    inputs, and tracktion_graph::getNodes() and visitNodes() stop here. This is handled by:
+     - prepareToPlay, which lets the subgraph's Nodes take over from the ones in the
+       AnticipativeNode this replaces, in the same way as the rest of the graph does
+     - getNodeProperties, which reports the subgraph's latency. The subgraph's player
+       balances the latency within it
+     - isReadyToProcess, which checks the subgraph's leaf Nodes
+     - getNodesIncludingSubgraphs(), which anything looking for particular Nodes, such as
+       the plugins to prepare for rendering, should use to find them
+*/
+class AnticipativeNode final    : public tracktion_graph::Node
+{
+public:
+    using NodeBuilder = std::function<std::unique_ptr<tracktion_graph::Node> (ProcessState&)>;
+
+    /** Creates an AnticipativeNode.
+        @param processStateToFollow the ProcessState of the graph this Node will be part of
+        @param createInputNode      called once with the ProcessState the subgraph should use
+        @param numBlocksAhead       the number of blocks to render ahead of the audio callback
+    */
+    AnticipativeNode (ProcessState& processStateToFollow, const NodeBuilder& createInputNode, int numBlocksAhead);
+
+    /** Destructor. */
+    ~AnticipativeNode() override;
+
+    /** Returns true if the builder created a subgraph.
+        If this returns false, this Node shouldn't be used.
+    */
+    bool hasInput() const noexcept                      { return inputNode != nullptr; }
+
+    /** Returns the number of blocks which have been copied from the rendered buffer. */
+    int getNumBlocksRenderedAhead() const noexcept      { return numBlocksRenderedAhead.load (std::memory_order_relaxed); }
+
+    /** Returns the number of blocks which have been processed on the audio thread. */
+    int getNumBlocksProcessedDirectly() const noexcept  { return numBlocksProcessedDirectly.load (std::memory_order_relaxed); }
+
+    /** Returns true if the workers have filled the buffer. */
+    bool isBufferFull() const noexcept;
+
+    /** Returns the root of the subgraph.
+        This can be used to inspect the subgraph but mustn't be processed or prepared.
+        @see getNodesIncludingSubgraphs
+    */
+    tracktion_graph::Node* getInputNode() const noexcept    { return inputNode; }
+
+    //==============================================================================
+    /** Returns nothing as the subgraph is processed by this Node's own player. */
+    std::vector<tracktion_graph::Node*> getDirectInputNodes() override;
+    tracktion_graph::NodeProperties getNodeProperties() override;
+    void prepareToPlay (const tracktion_graph::PlaybackInitialisationInfo&) override;
+    bool isReadyToProcess() override;
+    void process (ProcessContext&) override;
+
+private:
+    //==============================================================================
+    class SharedState;
+
+    enum OwnerState
+    {
+        unowned,
+        workerOwned,
+        audioThreadOwned
+    };
+
+    ProcessState& processStateToFollow;
+    tracktion_graph::PlayHead playHead;
+    tracktion_graph::PlayHeadState playHeadState { playHead };
+    ProcessState processState { playHeadState };
+
+    std::unique_ptr<tracktion_graph::Node> input;
+    tracktion_graph::Node* inputNode = nullptr;
+    TracktionNodePlayer player;
+    const int numBlocksAhead;
+    int blockSize = 0, numChannels = 0;
+    bool isRegistered = false;
+
+    std::vector<tracktion_graph::Node*> inputLeafNodes;
+
+    choc::buffer::ChannelArrayBuffer<float> ringBuffer, scratchBuffer;
+    MidiMessageArray scratchMidi;
+
+    std::atomic<int> owner { unowned };
+    std::atomic<bool> renderAhead { false }, cancelRendering { false };
+    tracktion_graph::LightweightSemaphore workerReleased;
+    std::atomic<int64_t> renderedEnd { 0 }, consumedEnd { 0 };
+    std::chrono::system_clock::time_point syncedInteractionTime;
+
+    std::atomic<int> numBlocksRenderedAhead { 0 }, numBlocksProcessedDirectly { 0 };
+
+    //==============================================================================
+    bool canRenderAhead() const;
+    bool isFollowing (juce::Range<int64_t> referenceSampleRange) const;
+    bool tryToCopyRenderedBlock (ProcessContext&);
+    void processDirectly (ProcessContext&);
+    void takeOwnershipOnAudioThread() noexcept;
+    void releaseFromWorker() noexcept;
+
+    bool needsRendering() const noexcept;
+    bool renderNextBlock();
+    void copyToRingBuffer (choc::buffer::ChannelArrayView<float>, int64_t startSample);
+    void copyFromRingBuffer (choc::buffer::ChannelArrayView<float>, int64_t startSample);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnticipativeNode)
+};
+
+//==============================================================================
+/** Returns all the Nodes in a graph like tracktion_graph::getNodes(), including the
+    subgraphs of any AnticipativeNodes.
+    Each subgraph is added next to its AnticipativeNode, before it if the ordering puts
+    inputs first, e.g. VertexOrdering::postordering, or after it otherwise.
+*/
+std::vector<tracktion_graph::Node*> getNodesIncludingSubgraphs (tracktion_graph::Node&, tracktion_graph::VertexOrdering);
+
+} // namespace tracktion_engine
@@ -0,0 +1,161 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if GRAPH_UNIT_TESTS_EDITNODE
+
+//==============================================================================
+//==============================================================================
+class AnticipativeNodeTests : public juce::UnitTest
+{
+public:
+    AnticipativeNodeTests()
+        : juce::UnitTest ("AnticipativeNode", "tracktion_graph")
+    {
+    }
+
+    void runTest() override
+    {
+        tracktion_graph::test_utilities::TestSetup ts;
+        ts.sampleRate = 44100.0;
+        ts.blockSize = 256;
+
+        runRenderingAhead (ts, 2.0);
+    }
+
+private:
+    struct Result
+    {
+        std::shared_ptr<tracktion_graph::test_utilities::TestContext> context;
+        int numNodes = 0, numBlocksRenderedAhead = 0, numBlocksProcessedDirectly = 0;
+        int numNodesIncludingSubgraphs = 0;
+    };
+
+    Result render (tracktion_graph::test_utilities::TestSetup ts, double durationInSeconds, const juce::File& sinFile,
+                   int numBlocksToRenderAhead, bool waitForWorkers, bool jumpHalfWay)
+    {
+        using namespace tracktion_graph;
+        using namespace test_utilities;
+        auto& engine = *tracktion_engine::Engine::getEngines()[0];
+
+        tracktion_graph::PlayHead playHead;
+        tracktion_graph::PlayHeadState playHeadState { playHead };
+        ProcessState processState { playHeadState };
+
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->ensureNumberOfAudioTracks (4);
+
+        for (auto track : getAudioTracks (*edit))
+            track->insertWaveClip ({}, sinFile, ClipPosition { { 0.0, durationInSeconds } }, false);
+
+        CreateNodeParams params { processState };
+        params.sampleRate = ts.sampleRate;
+        params.blockSize = ts.blockSize;
+        params.forRendering = true; // Required for audio files to be read
+        params.numBlocksToRenderAhead = numBlocksToRenderAhead;
+        auto node = createNodeForEdit (*edit, params);
+
+        TestProcess<TracktionNodePlayer> testContext (std::make_unique<TracktionNodePlayer> (std::move (node), processState, ts.sampleRate, ts.blockSize,
+                                                                                             getPoolCreatorFunction (ThreadPoolStrategy::hybrid)),
+                                                      ts, 2, durationInSeconds, true);
+        testContext.getNodePlayer().setNumThreads (0);
+
+        std::vector<AnticipativeNode*> anticipativeNodes;
+
+        for (auto n : getNodes (testContext.getNode(), VertexOrdering::postordering))
+            if (auto anticipativeNode = dynamic_cast<AnticipativeNode*> (n))
+                anticipativeNodes.push_back (anticipativeNode);
+
+        testContext.setPlayHead (&playHead);
+        playHead.playSyncedToRange ({});
+
+        const int numBlocks = juce::roundToInt (durationInSeconds * ts.sampleRate) / ts.blockSize;
+
+        for (int blockNum = 0;; ++blockNum)
+        {
+            if (jumpHalfWay && blockNum == numBlocks / 2)
+                playHead.setPosition (0);
+
+            // Give the workers time to fill the buffers as they would have during real-time playback
+            if (waitForWorkers)
+                for (auto n : anticipativeNodes)
+                    for (int i = 0; i < 1000 && ! n->isBufferFull(); ++i)
+                        juce::Thread::sleep (1);
+
+            if (! testContext.process (ts.blockSize))
+                break;
+        }
+
+        Result result;
+        result.context = testContext.getTestResult();
+        result.numNodes = (int) anticipativeNodes.size();
+        result.numNodesIncludingSubgraphs = (int) getNodesIncludingSubgraphs (testContext.getNode(), VertexOrdering::postordering).size();
+
+        for (auto n : anticipativeNodes)
+        {
+            result.numBlocksRenderedAhead += n->getNumBlocksRenderedAhead();
+            result.numBlocksProcessedDirectly += n->getNumBlocksProcessedDirectly();
+        }
+
+        return result;
+    }
+
+    void expectSameOutput (const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual)
+    {
+        expectEquals (actual.getNumSamples(), expected.getNumSamples());
+        expectGreaterThan (expected.getMagnitude (0, expected.getNumSamples()), 0.0f);
+
+        expectLessThan (audio_test_utilities::getMaxDifference (expected, actual), 0.0001f);
+    }
+
+    void runRenderingAhead (tracktion_graph::test_utilities::TestSetup ts, double durationInSeconds)
+    {
+        const auto description = tracktion_graph::test_utilities::getDescription (ts);
+        auto sinFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (ts.sampleRate, durationInSeconds, 2, 220.0f);
+
+        for (bool jumpHalfWay : { false, true })
+        {
+            beginTest ("Render ahead: " + description + (jumpHalfWay ? ", with jump" : ""));
+            {
+                auto inCallback = render (ts, durationInSeconds, sinFile->getFile(), 0, false, jumpHalfWay);
+                auto renderedAhead = render (ts, durationInSeconds, sinFile->getFile(), 4, true, jumpHalfWay);
+
+                expectEquals (inCallback.numNodes, 0);
+                expectEquals (renderedAhead.numNodes, 4);
+
+                // The subgraphs are hidden from getNodes but should contain the same Nodes as without rendering ahead
+                expectEquals (renderedAhead.numNodesIncludingSubgraphs - renderedAhead.numNodes, inCallback.numNodesIncludingSubgraphs);
+
+                // Only the first block and the one after the jump should have been processed in the callback
+                expectEquals (renderedAhead.numBlocksProcessedDirectly, renderedAhead.numNodes * (jumpHalfWay ? 2 : 1));
+                expectGreaterThan (renderedAhead.numBlocksRenderedAhead, 0);
+
+                expectSameOutput (inCallback.context->buffer, renderedAhead.context->buffer);
+            }
+
+            beginTest ("Render ahead without waiting: " + description + (jumpHalfWay ? ", with jump" : ""));
+            {
+                // The workers will often be behind here so this checks falling back mid-stream
+                auto inCallback = render (ts, durationInSeconds, sinFile->getFile(), 0, false, jumpHalfWay);
+                auto renderedAhead = render (ts, durationInSeconds, sinFile->getFile(), 4, false, jumpHalfWay);
+
+                expectSameOutput (inCallback.context->buffer, renderedAhead.context->buffer);
+            }
+        }
+    }
+};
+
+static AnticipativeNodeTests anticipativeNodeTests;
+
+#endif
+
+} // namespace tracktion_engine
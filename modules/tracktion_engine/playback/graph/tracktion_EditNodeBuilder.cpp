@@ -265,6 +265,13 @@ std::unique_ptr<tracktion_graph::Node> createNodeForAudioClip (AudioClipBase& cl
         }
     }
 
+    // Cheap effects at the end of the clip effects chain are applied by the node rather than rendered
+    std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects;
+
+    if (auto clipEffects = clip.getClipEffects())
+        if (clip.canHaveEffects())
+            realTimeEffects = clipEffects->createRealTimeProcessors (! params.forRendering);
+
     std::unique_ptr<Node> node;
     
     if (clip.getFadeInBehaviour() == AudioClipBase::speedRamp
@@ -304,7 +311,8 @@ std::unique_ptr<tracktion_graph::Node> createNodeForAudioClip (AudioClipBase& cl
                                                              params.processState,
                                                              clip.itemID,
                                                              params.forRendering,
-                                                             desc);
+                                                             desc,
+                                                             std::move (realTimeEffects));
     }
     else
     {
@@ -318,7 +326,8 @@ std::unique_ptr<tracktion_graph::Node> createNodeForAudioClip (AudioClipBase& cl
                                                     juce::AudioChannelSet::canonicalChannelSet (std::max (2, clip.getActiveChannels().size())),
                                                     params.processState,
                                                     clip.itemID,
-                                                    params.forRendering);
+                                                    params.forRendering,
+                                                    std::move (realTimeEffects));
     }
     
     // Plugins
@@ -518,6 +527,29 @@ std::unique_ptr<tracktion_graph::Node> createNodeForFrozenAudioTrack (AudioTrack
     return node;
 }
 
+std::unique_ptr<tracktion_graph::Node> createNodeForAutoFrozenAudioTrack (AudioTrack& track, const juce::File& frozenFile, const CreateNodeParams& params)
+{
+    jassert (! params.forRendering);
+
+    const bool processMidiWhenMuted = track.state.getProperty (IDs::processMidiWhenMuted, false);
+    auto trackMuteState = std::make_unique<TrackMuteState> (track, false, processMidiWhenMuted);
+    std::unique_ptr<Node> node = tracktion_graph::makeNode<WaveNode> (AudioFile (track.edit.engine, frozenFile),
+                                                                      EditTimeRange (0.0, track.getLengthIncludingInputTracks()),
+                                                                      0.0, EditTimeRange(), LiveClipLevel(),
+                                                                      1.0, juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo(),
+                                                                      params.processState,
+                                                                      track.itemID,
+                                                                      params.forRendering);
+
+    // All the plugins are in the render, only the meters need to run live
+    if (params.includePlugins)
+        for (auto p : track.pluginList)
+            if (auto meterPlugin = dynamic_cast<LevelMeterPlugin*> (p))
+                node = makeNode<LevelMeasurerProcessingNode> (std::move (node), *meterPlugin);
+
+    return makeNode<TrackMutingNode> (std::move (trackMuteState), std::move (node), false);
+}
+
 std::unique_ptr<tracktion_graph::Node> createARAClipsNode (const juce::Array<Clip*>& clips, const TrackMuteState&,
                                                            tracktion_graph::PlayHeadState& playHeadState, const CreateNodeParams& params)
 {
@@ -851,6 +883,17 @@ std::unique_ptr<tracktion_graph::Node> createNodeForAudioTrack (AudioTrack& at,
     if (! params.forRendering && at.isFrozen (AudioTrack::individualFreeze))
         return createNodeForFrozenAudioTrack (at, playHeadState, params);
 
+    if (! params.forRendering)
+    {
+        if (auto autoFreezer = at.edit.getAutoFreezer())
+        {
+            auto frozenFile = autoFreezer->getFrozenFile (at);
+
+            if (frozenFile.existsAsFile())
+                return createNodeForAutoFrozenAudioTrack (at, frozenFile, params);
+        }
+    }
+
     auto inputTracks = getDirectInputTracks (at);
     const bool processMidiWhenMuted = at.state.getProperty (IDs::processMidiWhenMuted, false);
     auto clipsMuteState = std::make_unique<TrackMuteState> (at, true, processMidiWhenMuted);
@@ -1211,6 +1254,89 @@ std::unique_ptr<tracktion_graph::Node> createMasterFadeInOutNode (Edit& edit, tr
 
 }
 
+//==============================================================================
+bool canTrackBeProcessedIndependently (AudioTrack& track)
+{
+    // Anything using live inputs or sending live output needs to be processed in the callback
+    if (track.isPartOfSubmix() || ! track.getListeners().isEmpty()
+        || track.getWaveInputDevice().isEnabled() || track.getMidiInputDevice().isEnabled())
+        return false;
+
+    if (auto output = getTrackOutput (track))
+    {
+        if (output->getDestinationTrack() != nullptr)
+            return false;
+
+        if (auto device = output->getOutputDevice (false))
+            if (device->isMidi())
+                return false;
+    }
+
+    if (auto context = track.edit.getCurrentPlaybackContext())
+        for (auto in : context->getAllInputs())
+            if (in->isOnTargetTrack (track))
+                return false;
+
+    // The subgraph is processed separately so can't be connected to any other tracks
+    if (! getDirectInputTracks (track).isEmpty() || isSidechainSource (track))
+        return false;
+
+    auto isConnectedToOtherTracks = [] (Plugin& p)
+    {
+        return dynamic_cast<AuxSendPlugin*> (&p) != nullptr
+            || dynamic_cast<AuxReturnPlugin*> (&p) != nullptr
+            || dynamic_cast<RackInstance*> (&p) != nullptr
+            || dynamic_cast<InsertPlugin*> (&p) != nullptr
+            || p.getSidechainSourceID().isValid();
+    };
+
+    for (auto p : track.pluginList)
+        if (isConnectedToOtherTracks (*p))
+            return false;
+
+    for (auto c : track.getClips())
+        if (auto pluginList = c->getPluginList())
+            for (auto p : *pluginList)
+                if (isConnectedToOtherTracks (*p))
+                    return false;
+
+    return true;
+}
+
+bool canTrackBeRenderedAhead (Track& track, const CreateNodeParams& params)
+{
+    if (params.numBlocksToRenderAhead <= 0)
+        return false;
+
+    if (auto at = dynamic_cast<AudioTrack*> (&track))
+        return canTrackBeProcessedIndependently (*at);
+
+    return false;
+}
+
+/** Creates the Node for a track, wrapping it in an AnticipativeNode if it can be rendered ahead. */
+std::unique_ptr<tracktion_graph::Node> createNodeForTrackRenderingAhead (Track& track, const CreateNodeParams& params)
+{
+    if (! canTrackBeRenderedAhead (track, params))
+        return createNodeForTrack (track, params);
+
+    auto node = std::make_unique<AnticipativeNode> (params.processState,
+                                                    [&track, &params] (ProcessState& processState)
+                                                    {
+                                                        CreateNodeParams trackParams { processState, params.sampleRate, params.blockSize,
+                                                                                       params.allowedClips, params.allowedTracks, params.forRendering,
+                                                                                       params.includePlugins, params.includeMasterPlugins,
+                                                                                       params.addAntiDenormalisationNoise, params.includeBypassedPlugins, 0 };
+                                                        return createNodeForTrack (track, trackParams);
+                                                    },
+                                                    params.numBlocksToRenderAhead);
+
+    if (! node->hasInput())
+        return {};
+
+    return node;
+}
+
 //==============================================================================
 std::unique_ptr<tracktion_graph::Node> createNodeForEdit (EditPlaybackContext& epc, std::atomic<double>& audibleTimeToUpdate, const CreateNodeParams& params)
 {
@@ -1246,7 +1372,7 @@ std::unique_ptr<tracktion_graph::Node> createNodeForEdit (EditPlaybackContext& e
                         devicesWithFrozenNodes.push_back (device);
                     }
                 }
-                else if (auto node = createNodeForTrack (*t, params))
+                else if (auto node = createNodeForTrackRenderingAhead (*t, params))
                 {
                     deviceNodes[device].push_back (std::move (node));
                 }
@@ -1368,7 +1494,7 @@ std::unique_ptr<tracktion_graph::Node> createNodeForEdit (Edit& edit, const Crea
             continue;
         }
 
-        if (auto node = createNodeForTrack (*t, params))
+        if (auto node = createNodeForTrackRenderingAhead (*t, params))
             trackNodes.push_back (std::move (node));
     }
 
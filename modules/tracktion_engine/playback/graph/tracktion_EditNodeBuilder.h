@@ -31,6 +31,7 @@ struct CreateNodeParams
     bool includeMasterPlugins = true;                   /**< Whether to include master plugins, fades and volume. */
     bool addAntiDenormalisationNoise = false;           /**< Whether to add low level anti-denormalisation noise to the output. */
     bool includeBypassedPlugins = true;                 /**< If false, bypassed plugins will be completely ommited from the graph. */
+    int numBlocksToRenderAhead = 0;                     /**< If greater than 0, tracks that don't use live inputs are processed this many blocks ahead on background threads. @see AnticipativeNode */
 };
 
 //==============================================================================
@@ -49,5 +50,10 @@ std::unique_ptr<tracktion_graph::Node> createNodeForEdit (EditPlaybackContext&,
 /** Creates a Node to render an Edit. */
 std::unique_ptr<tracktion_graph::Node> createNodeForEdit (Edit&, const CreateNodeParams&);
 
+/** Returns true if the track doesn't use any live inputs or outputs and isn't connected to
+    any other tracks so it can be processed separately from the rest of the Edit.
+*/
+bool canTrackBeProcessedIndependently (AudioTrack&);
+
 
 } // namespace tracktion_engine
@@ -19,7 +19,7 @@ namespace
     {
         Plugin::Array plugins, insideRacks;
 
-        for (auto n : getNodes (node, VertexOrdering::preordering))
+        for (auto n : getNodesIncludingSubgraphs (node, VertexOrdering::preordering))
             if (auto pluginNode = dynamic_cast<PluginNode*> (n))
                 plugins.add (&pluginNode->getPlugin());
 
@@ -82,6 +82,9 @@ NodeRenderContext::NodeRenderContext (Renderer::RenderTask& owner_, Renderer::Pa
         r.shouldNormalise = false;
         r.trimSilenceAtEnds = false;
         r.shouldNormaliseByRMS = false;
+
+        // These are written from the trimmed and normalised file after rendering
+        r.additionalOutputs.clear();
     }
 
     numOutputChans = 2;
@@ -101,9 +104,9 @@ NodeRenderContext::NodeRenderContext (Renderer::RenderTask& owner_, Renderer::Pa
 
     AudioFileUtils::addBWAVStartToMetadata (r.metadata, (int64_t) (r.time.getStart() * r.sampleRateForAudio));
 
-    writer = std::make_unique<AudioFileWriter> (AudioFile (*originalParams.engine, r.destFile),
-                                                r.audioFormat, numOutputChans, r.sampleRateForAudio,
-                                                r.bitDepth, r.metadata, r.quality);
+    auto writer = std::make_unique<AudioFileWriter> (AudioFile (*originalParams.engine, r.destFile),
+                                                     r.audioFormat, numOutputChans, r.sampleRateForAudio,
+                                                     r.bitDepth, r.metadata, r.quality);
 
     if (r.destFile != juce::File() && ! writer->isOpen())
     {
@@ -111,6 +114,17 @@ NodeRenderContext::NodeRenderContext (Renderer::RenderTask& owner_, Renderer::Pa
         return;
     }
 
+    if (auto codec = StreamingEncoder::createWriterCodec (std::move (writer)))
+    {
+        std::vector<std::unique_ptr<StreamingEncoder::Codec>> codecs;
+        codecs.push_back (std::move (codec));
+
+        encoder = std::make_unique<StreamingEncoder> (std::move (codecs), numOutputChans, getEncoderQueueSize());
+    }
+
+    if (! createAdditionalEncoders())
+        return;
+
     blockLength = r.blockSizeForAudio / r.sampleRateForAudio;
 
     // number of blank blocks to play before starting, to give plugins time to warm up
@@ -161,8 +175,12 @@ NodeRenderContext::~NodeRenderContext()
     playHead->stop();
     Renderer::RenderTask::setAllPluginsRealtime (plugins, true);
 
-    if (writer != nullptr)
-        writer->closeForWriting();
+    if (encoder != nullptr && ! encoder->finish())
+        TRACKTION_LOG_ERROR ("Failed to encode rendered audio: " + r.destFile.getFullPathName());
+
+    for (size_t i = 0; i < additionalEncoders.size(); ++i)
+        if (! additionalEncoders[i]->finish())
+            TRACKTION_LOG_ERROR ("Failed to encode rendered audio: " + r.additionalOutputs[i].destFile.getFullPathName());
 
     callBlocking ([this] { nodePlayer.reset(); });
 
@@ -183,9 +201,17 @@ bool NodeRenderContext::renderNextBlock (std::atomic<float>& progressToUpdate)
 
     if (owner.shouldExit())
     {
-        writer->closeForWriting();
+        if (encoder != nullptr)
+            encoder->cancel();
+
         r.destFile.deleteFile();
 
+        for (size_t i = 0; i < additionalEncoders.size(); ++i)
+        {
+            additionalEncoders[i]->cancel();
+            r.additionalOutputs[i].destFile.deleteFile();
+        }
+
         playHead->stop();
         Renderer::RenderTask::setAllPluginsRealtime (plugins, true);
 
@@ -319,6 +345,31 @@ bool NodeRenderContext::renderNextBlock (std::atomic<float>& progressToUpdate)
 }
 
 //==============================================================================
+int NodeRenderContext::getEncoderQueueSize() const
+{
+    // Leave room for a few seconds of audio so a slow encoder doesn't hold up the render
+    return juce::jmax (r.blockSizeForAudio * 4, (int) r.sampleRateForAudio * 4);
+}
+
+bool NodeRenderContext::createAdditionalEncoders()
+{
+    for (auto& output : r.additionalOutputs)
+    {
+        auto additionalEncoder = StreamingEncoder::createForOutput (*r.engine, output, numOutputChans, r.sampleRateForAudio,
+                                                                    r.time.getStart(), getEncoderQueueSize());
+
+        if (additionalEncoder == nullptr)
+        {
+            status = juce::Result::fail (TRANS("Couldn't write to target file") + ": " + output.destFile.getFileName());
+            return false;
+        }
+
+        additionalEncoders.push_back (std::move (additionalEncoder));
+    }
+
+    return true;
+}
+
 NodeRenderContext::WriteResult NodeRenderContext::writeAudioBlock (choc::buffer::ChannelArrayView<float> block)
 {
     CRASH_TRACER
@@ -327,6 +378,12 @@ NodeRenderContext::WriteResult NodeRenderContext::writeAudioBlock (choc::buffer:
     
     juce::AudioBuffer<float> buffer (block.data.channels, numOutputChans, blockSizeSamples);
 
+    // The additional outputs do their own dithering, so get the audio before it's dithered here
+    if (blockSizeSamples > 0)
+        for (auto& additionalEncoder : additionalEncoders)
+            if (! additionalEncoder->write (buffer, 0, blockSizeSamples))
+                return WriteResult::failed;
+
     // Apply dithering and mag/rms analysis
     if (r.ditheringEnabled && r.bitDepth < 32)
         ditherers.apply (buffer, blockSizeSamples);
@@ -357,11 +414,10 @@ NodeRenderContext::WriteResult NodeRenderContext::writeAudioBlock (choc::buffer:
         numSamplesWrittenToSource += blockSizeSamples;
     }
 
-    // And finally write to the file
-    // NB buffer gets trashed by this call
+    // And finally queue it to be written to the file
     if (blockSizeSamples > 0 && hasStartedSavingToFile
-         && writer->isOpen()
-         && ! writer->appendBuffer (buffer, blockSizeSamples))
+         && encoder != nullptr
+         && ! encoder->write (buffer, 0, blockSizeSamples))
         return WriteResult::failed;
     
     return WriteResult::succeeded;
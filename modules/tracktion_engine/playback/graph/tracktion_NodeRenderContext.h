@@ -84,7 +84,8 @@ private:
     std::unique_ptr<TracktionNodePlayer> nodePlayer;
     
     int numOutputChans = 0;
-    std::unique_ptr<AudioFileWriter> writer;
+    std::unique_ptr<StreamingEncoder> encoder;
+    std::vector<std::unique_ptr<StreamingEncoder>> additionalEncoders;
     Plugin::Array plugins;
     juce::Result status;
 
@@ -125,6 +126,8 @@ private:
     };
     
     WriteResult writeAudioBlock (choc::buffer::ChannelArrayView<float>);
+    int getEncoderQueueSize() const;
+    bool createAdditionalEncoders();
 };
 
 } // namespace tracktion_engine
@@ -35,7 +35,8 @@ SpeedRampWaveNode::SpeedRampWaveNode (const AudioFile& af,
                                       ProcessState& ps,
                                       EditItemID itemIDToUse,
                                       bool isRendering,
-                                      SpeedFadeDescription speedFadeDescriptionToUse)
+                                      SpeedFadeDescription speedFadeDescriptionToUse,
+                                      std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffectsToUse)
    : TracktionEngineNode (ps),
      editPosition (editTime),
      loopSection (loop.getStart() * speed, loop.getEnd() * speed),
@@ -47,7 +48,8 @@ SpeedRampWaveNode::SpeedRampWaveNode (const AudioFile& af,
      audioFile (af),
      clipLevel (level),
      channelsToUse (channelSetToUse),
-     destChannels (destChannelsToFill)
+     destChannels (destChannelsToFill),
+     realTimeEffects (std::move (realTimeEffectsToUse))
 {
     // Both ramp times should not be empty!
     assert ((! speedFadeDescription.inTimeRange.isEmpty())
@@ -193,6 +195,7 @@ void SpeedRampWaveNode::processSection (ProcessContext& pc, juce::Range<int64_t>
     }
     
     reader->setReadPosition (fileStart);
+    const auto sourceStartSample = reader->getReadPosition();
 
     auto destBuffer = pc.buffers.audio;
     auto numSamples = destBuffer.getNumFrames();
@@ -211,6 +214,18 @@ void SpeedRampWaveNode::processSection (ProcessContext& pc, juce::Range<int64_t>
                                  channelsToUse,
                                  isOfflineRender ? 5000 : 3))
         {
+            if (realTimeEffects != nullptr)
+            {
+                // Mono files or sources are duplicated to the rest of the channels
+                auto numSourceChannels = std::min ((int) numChannels, reader->getNumChannels());
+
+                if (channelsToUse.size() > 0)
+                    numSourceChannels = std::min (numSourceChannels, channelsToUse.size());
+
+                realTimeEffects->process (fileData.buffer, numSourceChannels, numFileSamples + 2,
+                                          sourceStartSample, reader->getLoopRange(), audioFileSampleRate);
+            }
+
             if (! getPlayHeadState().isContiguousWithPreviousBlock() && ! getPlayHeadState().isFirstBlockOfLoop())
                 lastSampleFadeLength = std::min (numSamples, getPlayHead().isUserDragging() ? 40u : 10u);
         }
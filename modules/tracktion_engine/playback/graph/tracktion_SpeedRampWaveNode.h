@@ -34,6 +34,8 @@ public:
         to use when converting the file contents to floating point. e.g. gain of
         2.0f will double the values returned.
 
+        realTimeEffects are any clip effects that should be applied to the samples read
+        from the file before they're resampled.
     */
     SpeedRampWaveNode (const AudioFile&,
                        EditTimeRange editTime,
@@ -46,7 +48,8 @@ public:
                        ProcessState&,
                        EditItemID,
                        bool isOfflineRender,
-                       SpeedFadeDescription);
+                       SpeedFadeDescription,
+                       std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects = {});
 
     //==============================================================================
     tracktion_graph::NodeProperties getNodeProperties() override;
@@ -69,6 +72,7 @@ private:
     double audioFileSampleRate = 0;
     const juce::AudioChannelSet channelsToUse, destChannels;
     AudioFileCache::Reader::Ptr reader;
+    const std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects;
 
     struct PerChannelState;
     juce::OwnedArray<PerChannelState> channelState;
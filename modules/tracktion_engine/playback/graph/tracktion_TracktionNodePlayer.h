@@ -60,9 +60,10 @@ public:
         nodePlayer.setNode (std::move (newNode));
     }
 
-    void setNode (std::unique_ptr<tracktion_graph::Node> newNode, double sampleRateToUse, int blockSizeToUse)
+    void setNode (std::unique_ptr<tracktion_graph::Node> newNode, double sampleRateToUse, int blockSizeToUse,
+                  tracktion_graph::Node* nodeToReplace = nullptr)
     {
-        nodePlayer.setNode (std::move (newNode), sampleRateToUse, blockSizeToUse);
+        nodePlayer.setNode (std::move (newNode), sampleRateToUse, blockSizeToUse, nodeToReplace);
     }
     
     void prepareToPlay (double sampleRateToUse, int blockSizeToUse)
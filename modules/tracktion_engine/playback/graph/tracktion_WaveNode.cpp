@@ -34,7 +34,8 @@ WaveNode::WaveNode (const AudioFile& af,
                     const juce::AudioChannelSet& destChannelsToFill,
                     ProcessState& ps,
                     EditItemID itemIDToUse,
-                    bool isRendering)
+                    bool isRendering,
+                    std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffectsToUse)
    : TracktionEngineNode (ps),
      editPosition (editTime),
      loopSection (loop.getStart() * speed, loop.getEnd() * speed),
@@ -45,7 +46,8 @@ WaveNode::WaveNode (const AudioFile& af,
      audioFile (af),
      clipLevel (level),
      channelsToUse (channelSetToUse),
-     destChannels (destChannelsToFill)
+     destChannels (destChannelsToFill),
+     realTimeEffects (std::move (realTimeEffectsToUse))
 {
 }
 
@@ -159,6 +161,7 @@ void WaveNode::processSection (ProcessContext& pc, juce::Range<int64_t> timeline
     const auto numFileSamples  = (int) (fileEnd - fileStart);
 
     reader->setReadPosition (fileStart);
+    const auto sourceStartSample = reader->getReadPosition();
 
     auto destBuffer = pc.buffers.audio;
     auto numFrames = destBuffer.getNumFrames();
@@ -177,6 +180,18 @@ void WaveNode::processSection (ProcessContext& pc, juce::Range<int64_t> timeline
                                  channelsToUse,
                                  isOfflineRender ? 5000 : 3))
         {
+            if (realTimeEffects != nullptr)
+            {
+                // Mono files or sources are duplicated to the rest of the channels
+                auto numSourceChannels = std::min ((int) numChannels, reader->getNumChannels());
+
+                if (channelsToUse.size() > 0)
+                    numSourceChannels = std::min (numSourceChannels, channelsToUse.size());
+
+                realTimeEffects->process (fileData.buffer, numSourceChannels, numFileSamples + 2,
+                                          sourceStartSample, reader->getLoopRange(), audioFileSampleRate);
+            }
+
             if (! getPlayHeadState().isContiguousWithPreviousBlock() && ! getPlayHeadState().isFirstBlockOfLoop())
                 lastSampleFadeLength = std::min (numFrames, getPlayHead().isUserDragging() ? 40u : 10u);
         }
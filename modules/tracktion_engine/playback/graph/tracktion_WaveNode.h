@@ -24,6 +24,8 @@ public:
         to use when converting the file contents to floating point. e.g. gain of
         2.0f will double the values returned.
 
+        realTimeEffects are any clip effects that should be applied to the samples read
+        from the file before they're resampled.
     */
     WaveNode (const AudioFile&,
               EditTimeRange editTime,
@@ -35,7 +37,8 @@ public:
               const juce::AudioChannelSet& destChannelsToFill,
               ProcessState&,
               EditItemID,
-              bool isOfflineRender);
+              bool isOfflineRender,
+              std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects = {});
 
     //==============================================================================
     tracktion_graph::NodeProperties getNodeProperties() override;
@@ -57,6 +60,7 @@ private:
     double audioFileSampleRate = 0;
     const juce::AudioChannelSet channelsToUse, destChannels;
     AudioFileCache::Reader::Ptr reader;
+    const std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects;
 
     struct PerChannelState;
     juce::OwnedArray<PerChannelState> channelState;
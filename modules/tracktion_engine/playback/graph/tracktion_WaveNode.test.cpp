@@ -30,7 +30,10 @@ public:
             runBasicTests (ts, true);
             runBasicTests (ts, false);
             runLoopedTimelineTests (ts);
+            runRealTimeClipEffectTests (ts);
         }
+
+        runRealTimeProcessorLoopTests();
     }
 
 private:
@@ -216,6 +219,260 @@ private:
             test_utilities::expectAudioBuffer (*this, testContext->buffer, 0, timeToSample ({ 0.0, 5.0 }, ts.sampleRate), 1.0f, 0.707f);
         }
     }
+    //==============================================================================
+    void runRealTimeClipEffectTests (test_utilities::TestSetup ts)
+    {
+        auto& engine = *tracktion_engine::Engine::getEngines()[0];
+
+        // Floating point files mean the rendered effects don't lose any precision
+        const double fileLengthSeconds = 2.0;
+        juce::TemporaryFile stereoFile (".wav"), monoFile (".wav");
+        const auto stereoSource = writeNoiseFile (stereoFile.getFile(), ts.sampleRate, 2, fileLengthSeconds);
+        writeNoiseFile (monoFile.getFile(), ts.sampleRate, 1, fileLengthSeconds);
+
+        const float gain = juce::Decibels::decibelsToGain (-6.0f);
+
+        beginTest ("Real-time clip effects");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, stereoFile.getFile(),
+                                               { ClipEffect::EffectType::volume,
+                                                 ClipEffect::EffectType::fadeInOut,
+                                                 ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::makeMono });
+            auto& effects = *clip->getClipEffects();
+            setVolumeAndPan (effects[0], -6.0f, 0.0f);
+
+            if (auto fadeEffect = dynamic_cast<FadeInOutEffect*> (effects[1]))
+            {
+                fadeEffect->setFadeIn (0.5);
+                fadeEffect->setFadeOut (0.3);
+            }
+
+            expectEquals (effects.getNumEffectsToRender(), 0);
+
+            // Both channels are the inverted average of the faded input
+            expectLiveEffectsMatchReference (ts, *clip, stereoFile.getFile(), fileLengthSeconds,
+                                             [=] (const juce::AudioBuffer<float>& dry, int, int i, double time)
+                                             {
+                                                 const auto fade = time < 0.5 ? (float) (time / 0.5)
+                                                                 : time > 1.7 ? (float) ((2.0 - time) / 0.3)
+                                                                 : 1.0f;
+
+                                                 return -0.5f * gain * fade * (dry.getSample (0, i) + dry.getSample (1, i));
+                                             });
+            cleanUp (engine, *edit);
+        }
+
+        beginTest ("Panning a mono source in real-time");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, monoFile.getFile(), { ClipEffect::EffectType::volume });
+            auto& effects = *clip->getClipEffects();
+            setVolumeAndPan (effects[0], -6.0f, 0.5f);
+
+            expectEquals (effects.getNumEffectsToRender(), 0);
+
+            // With a linear pan law, the left is scaled by (1 - pan) and the right by (1 + pan)
+            expectLiveEffectsMatchReference (ts, *clip, monoFile.getFile(), fileLengthSeconds,
+                                             [=] (const juce::AudioBuffer<float>& dry, int channel, int i, double)
+                                             {
+                                                 return dry.getSample (channel, i) * gain * (channel == 0 ? 0.5f : 1.5f);
+                                             });
+            cleanUp (engine, *edit);
+        }
+
+        beginTest ("Real-time clip effects after rendered effects");
+        {
+            auto edit = Edit::createSingleTrackEdit (engine);
+            auto clip = createClipWithEffects (*edit, stereoFile.getFile(),
+                                               { ClipEffect::EffectType::normalise,
+                                                 ClipEffect::EffectType::invert,
+                                                 ClipEffect::EffectType::fadeInOut,
+                                                 ClipEffect::EffectType::invert });
+            auto& effects = *clip->getClipEffects();
+
+            if (auto fadeEffect = dynamic_cast<FadeInOutEffect*> (effects[2]))
+                fadeEffect->setFadeIn (1.0);
+
+            expectEquals (effects.getNumEffectsToRender(), 1);
+
+            // The normalise effect defaults to a peak of 0dB and the inverts cancel out
+            const auto normaliseGain = 1.0f / stereoSource.getMagnitude (0, stereoSource.getNumSamples());
+
+            expectLiveEffectsMatchReference (ts, *clip, stereoFile.getFile(), fileLengthSeconds,
+                                             [=] (const juce::AudioBuffer<float>& dry, int channel, int i, double time)
+                                             {
+                                                 return dry.getSample (channel, i) * normaliseGain * (float) juce::jmin (1.0, time);
+                                             });
+            cleanUp (engine, *edit);
+        }
+    }
+
+    void runRealTimeProcessorLoopTests()
+    {
+        /** Records the source positions it's asked to process. */
+        struct PositionRecorder  : public ClipEffect::RealTimeProcessor
+        {
+            PositionRecorder (std::vector<juce::Range<juce::int64>>& r) : ranges (r) {}
+
+            void process (juce::AudioBuffer<float>&, int, int, int numSamples,
+                          juce::int64 sourceStartSample, double) const override
+            {
+                ranges.push_back ({ sourceStartSample, sourceStartSample + numSamples });
+            }
+
+            std::vector<juce::Range<juce::int64>>& ranges;
+        };
+
+        beginTest ("Real-time processors wrap starts several loops past the end");
+        {
+            std::vector<juce::Range<juce::int64>> ranges;
+            std::vector<std::unique_ptr<ClipEffect::RealTimeProcessor>> processors;
+            processors.push_back (std::make_unique<PositionRecorder> (ranges));
+
+            ClipEffects::RealTimeProcessors realTimeProcessors;
+            realTimeProcessors.setProcessors (std::move (processors));
+
+            const juce::Range<juce::int64> loopRange (100, 150);
+            juce::AudioBuffer<float> buffer (1, 120);
+
+            // 3 loop lengths and 10 samples past the end of the loop
+            realTimeProcessors.process (buffer, 1, buffer.getNumSamples(), loopRange.getEnd() + 3 * loopRange.getLength() + 10,
+                                        loopRange, 44100.0);
+
+            expect (! ranges.empty());
+            expectEquals (ranges.front().getStart(), (juce::int64) 110);
+
+            juce::int64 numProcessed = 0;
+
+            for (auto r : ranges)
+            {
+                expect (loopRange.contains (r), "Processed range outside the loop");
+                numProcessed += r.getLength();
+            }
+
+            expectEquals (numProcessed, (juce::int64) buffer.getNumSamples());
+        }
+    }
+
+    /** Plays the clip with its effects applied live and checks each sample against a reference
+        calculated from playing the source file without any effects.
+    */
+    template<typename ReferenceFunction>
+    void expectLiveEffectsMatchReference (test_utilities::TestSetup ts, WaveAudioClip& clip, const juce::File& sourceFile,
+                                          double fileLengthSeconds, ReferenceFunction&& getExpectedSample)
+    {
+        auto liveEffects = clip.getClipEffects()->createRealTimeProcessors();
+        expect (liveEffects != nullptr);
+
+        auto live = playFile (ts, waitForClipToRender (clip), liveEffects, fileLengthSeconds);
+        auto dry = playFile (ts, AudioFile (clip.edit.engine, sourceFile), {}, fileLengthSeconds);
+
+        expectEquals (live.getNumSamples(), dry.getNumSamples());
+        expect (live.getMagnitude (0, live.getNumSamples()) > 0.0f);
+
+        for (int c = 0; c < live.getNumChannels(); ++c)
+        {
+            float maxError = 0.0f;
+
+            for (int i = 0; i < live.getNumSamples(); ++i)
+                maxError = juce::jmax (maxError, std::abs (live.getSample (c, i)
+                                                            - getExpectedSample (dry, c, i, i / ts.sampleRate)));
+
+            // The volume and fades are interpolated slightly differently so this isn't exact
+            expectLessThan (maxError, 1.0e-4f);
+        }
+    }
+
+    static void setVolumeAndPan (ClipEffect* effect, float volumeDb, float pan)
+    {
+        if (auto volumeEffect = dynamic_cast<VolumeEffect*> (effect))
+        {
+            volumeEffect->plugin->setPanLaw (PanLawLinear);
+            volumeEffect->plugin->setVolumeDb (volumeDb);
+            volumeEffect->plugin->setPan (pan);
+        }
+    }
+
+    juce::AudioBuffer<float> playFile (test_utilities::TestSetup ts, const AudioFile& file,
+                                       std::shared_ptr<ClipEffects::RealTimeProcessors> realTimeEffects,
+                                       double fileLengthSeconds)
+    {
+        tracktion_graph::PlayHead playHead;
+        tracktion_graph::PlayHeadState playHeadState (playHead);
+        ProcessState processState (playHeadState);
+        playHead.playSyncedToRange ({ 0, std::numeric_limits<int64_t>::max() });
+
+        auto node = makeNode<WaveNode> (file,
+                                        EditTimeRange (0.0, fileLengthSeconds),
+                                        0.0,
+                                        EditTimeRange(),
+                                        LiveClipLevel(),
+                                        1.0,
+                                        juce::AudioChannelSet::canonicalChannelSet (file.getNumChannels()),
+                                        juce::AudioChannelSet::canonicalChannelSet (2),
+                                        processState,
+                                        EditItemID(),
+                                        true,
+                                        std::move (realTimeEffects));
+
+        return createTracktionTestContext (processState, std::move (node), ts, 2, fileLengthSeconds)->buffer;
+    }
+
+    /** Waits for any effects that can't be applied in real-time to be rendered in the background. */
+    AudioFile waitForClipToRender (WaveAudioClip& clip)
+    {
+        for (int i = 0; i < 1000 && ! clip.getAudioFile().isValid(); ++i)
+            juce::Thread::sleep (10);
+
+        expect (clip.getAudioFile().isValid());
+        return clip.getAudioFile();
+    }
+
+    static juce::AudioBuffer<float> writeNoiseFile (const juce::File& f, double sampleRate, int numChannels, double durationSeconds)
+    {
+        juce::Random r (1);
+        juce::AudioBuffer<float> buffer (numChannels, (int) (sampleRate * durationSeconds));
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (c, i, r.nextFloat() * 0.5f - 0.25f);
+
+        juce::WavAudioFormat format;
+
+        if (auto out = std::unique_ptr<juce::FileOutputStream> (f.createOutputStream()))
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (format.createWriterFor (out.get(), sampleRate,
+                                                                                                 (unsigned int) numChannels,
+                                                                                                 32, {}, 0)))
+            {
+                out.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+
+        return buffer;
+    }
+
+    static juce::ReferenceCountedObjectPtr<WaveAudioClip> createClipWithEffects (Edit& edit, const juce::File& file,
+                                                                                 std::vector<ClipEffect::EffectType> types)
+    {
+        auto track = getAudioTracks (edit)[0];
+        auto clip = track->insertWaveClip ({}, file, ClipPosition { { 0.0, AudioFile (edit.engine, file).getLength() } }, false);
+        clip->enableEffects (true, false);
+
+        for (auto type : types)
+            clip->addEffect (ClipEffect::create (type));
+
+        return clip;
+    }
+
+    static void cleanUp (Engine& engine, Edit& edit)
+    {
+        engine.getAudioFileManager().releaseAllFiles();
+        edit.getTempDirectory (false).deleteRecursively();
+    }
 };
 
 static WaveNodeTests waveNodeTests;
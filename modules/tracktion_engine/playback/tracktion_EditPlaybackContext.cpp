@@ -473,6 +473,7 @@ void EditPlaybackContext::createNode()
     }
     
     cnp.includeBypassedPlugins = ! edit.engine.getEngineBehaviour().shouldBypassedPluginsBeRemovedFromPlaybackGraph();
+    cnp.numBlocksToRenderAhead = edit.engine.getEngineBehaviour().getNumBlocksToRenderAhead();
     auto editNode = createNodeForEdit (*this, audiblePlaybackTime, cnp);
 
     const auto& tempoSections = edit.tempoSequence.getTempoSections();
@@ -582,8 +583,6 @@ void EditPlaybackContext::prepareOutputDevices (double start)
 
     for (auto mo : midiOutputs)
         mo->prepareToPlay (start, true);
-
-    midiDispatcher.prepareToPlay (start);
 }
 
 void EditPlaybackContext::prepareForPlaying (double startTime)
@@ -11,6 +11,8 @@
 namespace tracktion_engine
 {
 
+struct MultiChannelRecordingFile;
+
 class EditPlaybackContext
 {
 public:
@@ -114,6 +116,26 @@ public:
     */
     static void enablePooledMemory (bool);
 
+    //==============================================================================
+    /** @internal
+        The multichannel files being recorded by this context's inputs. The lock must be
+        held whilst looking up, adding or releasing a file.
+        @see EngineBehaviour::shouldRecordInputsToMultiChannelFile
+    */
+    struct MultiChannelRecordingFiles
+    {
+        MultiChannelRecordingFiles() = default;
+        ~MultiChannelRecordingFiles();
+
+        juce::CriticalSection lock;
+        juce::Array<MultiChannelRecordingFile*> files;
+
+        JUCE_DECLARE_NON_COPYABLE (MultiChannelRecordingFiles)
+    };
+
+    /** @internal */
+    MultiChannelRecordingFiles multiChannelRecordingFiles;
+
 private:
     bool isAllocated = false;
 
@@ -11,129 +11,300 @@
 namespace tracktion_engine
 {
 
-MidiNoteDispatcher::MidiNoteDispatcher()
+MidiOutputScheduler::MidiOutputScheduler()
+    : juce::Thread ("MIDI Output")
 {
+    fifo.reset (4096);
+    pendingMessages.reserve (4096);
+    partialMessage.reserve (1024);
 }
 
-MidiNoteDispatcher::~MidiNoteDispatcher()
+MidiOutputScheduler::~MidiOutputScheduler()
 {
-    stopTimer();
+    stopThread (1000);
 }
 
-void MidiNoteDispatcher::dispatchPendingMessagesForDevices (double editTime)
+void MidiOutputScheduler::setDestinations (const juce::Array<Destination*>& newDestinations)
 {
-    ScopedLock s (deviceLock);
+    CRASH_TRACER
 
-    for (auto state : devices)
-        dispatchPendingMessages (*state, editTime);
+    if (newDestinations.isEmpty())
+        stopThread (1000);
+
+    {
+        // Anything already in the FIFO was for the old destinations so gets ignored
+        const juce::ScopedLock sl (destinationLock);
+        destinations = newDestinations;
+        ++generation;
+    }
+
+    if (! destinations.isEmpty())
+        startThread (9);
 }
 
-void MidiNoteDispatcher::masterTimeUpdate (double editTime)
+bool MidiOutputScheduler::scheduleMessage (int destinationIndex, const juce::MidiMessage& message, double timeMs) noexcept
 {
-    const ScopedLock s (timeLock);
-    masterTime = editTime;
-    hiResClockOfMasterTime = Time::getMillisecondCounterHiRes();
+    auto data = message.getRawData();
+    auto numBytesLeft = message.getRawDataSize();
+    const auto numEntries = (juce::uint32) ((numBytesLeft + FifoEntry::maxBytes - 1) / FifoEntry::maxBytes);
+
+    // This is the only writer so the free space can't shrink while the entries are pushed,
+    // which means the reader never sees part of a message
+    if (numEntries == 0 || fifo.getFreeSlots() < numEntries)
+        return false;
+
+    FifoEntry entry;
+    entry.destinationIndex = destinationIndex;
+    entry.generation = generation.load (std::memory_order_acquire);
+    entry.timeMs = timeMs;
+
+    while (numBytesLeft > 0)
+    {
+        const auto numBytes = std::min (numBytesLeft, FifoEntry::maxBytes);
+        memcpy (entry.data, data, (size_t) numBytes);
+        entry.numBytes = (juce::uint8) numBytes;
+        entry.isContinued = numBytesLeft > numBytes;
+
+        fifo.push (entry);
+        data += numBytes;
+        numBytesLeft -= numBytes;
+    }
+
+    return true;
 }
 
-void MidiNoteDispatcher::prepareToPlay (double editTime)
+bool MidiOutputScheduler::scheduleNoteOffs (int destinationIndex) noexcept
 {
-    masterTimeUpdate (editTime);
+    FifoEntry entry;
+    entry.isNoteOffs = true;
+    entry.destinationIndex = destinationIndex;
+    entry.generation = generation.load (std::memory_order_acquire);
+
+    return fifo.push (entry);
 }
 
-double MidiNoteDispatcher::getCurrentTime() const
+void MidiOutputScheduler::triggerSend() noexcept
 {
-    const ScopedLock s (timeLock);
-    return masterTime + (Time::getMillisecondCounterHiRes() - hiResClockOfMasterTime) * 0.001;
+    notify();
 }
 
-void MidiNoteDispatcher::dispatchPendingMessages (DeviceState& state, double editTime)
+//==============================================================================
+bool MidiOutputScheduler::isDueLater (const ScheduledMessage& a, const ScheduledMessage& b) noexcept
 {
-    // N.B. This should only be called under a deviceLock
-    auto& pendingBuffer = state.device.getPendingMessages();
-    state.device.context.masterLevels.processMidi (pendingBuffer, nullptr);
-    const double delay = state.device.getMidiOutput().getDeviceDelay();
-    
-    if (! state.device.sendMessages (pendingBuffer, editTime - delay))
-        state.buffer.mergeFromAndClear (pendingBuffer);
+    // std::push_heap makes a max-heap, so this puts the earliest message at the front.
+    // Messages due at the same time are kept in the order they were scheduled.
+    if (a.timeMs != b.timeMs)
+        return a.timeMs > b.timeMs;
+
+    return a.sequenceNumber > b.sequenceNumber;
 }
 
-void MidiNoteDispatcher::setMidiDeviceList (const OwnedArray<MidiOutputDeviceInstance>& newList)
+void MidiOutputScheduler::run()
 {
-    CRASH_TRACER
-    OwnedArray<DeviceState> newDevices;
+    // Waking up from a sleep isn't accurate enough, so yield for the last part of the wait
+    constexpr double spinTimeMs = 1.5;
 
-    for (auto d : newList)
-        newDevices.add (new DeviceState (*d));
+    while (! threadShouldExit())
+    {
+        readFifo();
+        sendDueMessages (juce::Time::getMillisecondCounterHiRes());
 
-    if (newList.isEmpty())
-        stopTimer();
+        if (pendingMessages.empty())
+        {
+            wait (100);
+            continue;
+        }
 
-    bool startTimerFlag = false;
+        const auto timeUntilNext = pendingMessages.front().timeMs - juce::Time::getMillisecondCounterHiRes();
 
-    {
-        const ScopedLock sl (deviceLock);
-        newDevices.swapWith (devices);
-        startTimerFlag = ! devices.isEmpty();
+        if (timeUntilNext > spinTimeMs)
+            wait (juce::jmax (1, (int) (timeUntilNext - spinTimeMs)));
+        else if (fifo.getUsedSlots() == 0)
+            juce::Thread::yield();
     }
-
-    if (startTimerFlag)
-        startTimer (1);
 }
 
-void MidiNoteDispatcher::hiResTimerCallback()
+void MidiOutputScheduler::readFifo()
 {
-    struct MessageToSend
-    {
-        MidiOutputDeviceInstance* device;
-        MidiMessage message;
-    };
-
-    Array<MessageToSend> messagesToSend;
-    messagesToSend.ensureStorageAllocated (32);
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto currentGeneration = generation.load (std::memory_order_acquire);
+    FifoEntry entry;
 
+    while (fifo.pop (entry))
     {
-        const ScopedLock sl (deviceLock);
-
-        for (auto d : devices)
+        if (entry.isContinued)
         {
-            auto& device = d->device;
-            auto& buffer = d->buffer;
-            auto& midiOut = device.getMidiOutput();
+            partialMessage.insert (partialMessage.end(), entry.data, entry.data + entry.numBytes);
+            continue;
+        }
 
-            if (buffer.isAllNotesOff)
+        ScheduledMessage m;
+        m.timeMs = entry.timeMs;
+        m.generation = entry.generation;
+        m.destinationIndex = entry.destinationIndex;
+        m.isNoteOffs = entry.isNoteOffs;
+
+        if (! m.isNoteOffs)
+        {
+            if (partialMessage.empty())
             {
-                buffer.clear();
-                midiOut.sendNoteOffMessages();
+                m.message = juce::MidiMessage (entry.data, (int) entry.numBytes);
             }
             else
             {
-                while (buffer.isNotEmpty())
-                {
-                    auto& message = buffer[0];
-
-                    auto noteTime = message.getTimeStamp();
-                    auto currentTime = getCurrentTime();
-
-                    if (noteTime > currentTime + 0.25)
-                    {
-                        buffer.remove (0);
-                    }
-                    else if (noteTime <= currentTime)
-                    {
-                        messagesToSend.add ({ &device, message });
-                        buffer.remove (0);
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
+                partialMessage.insert (partialMessage.end(), entry.data, entry.data + entry.numBytes);
+                m.message = juce::MidiMessage (partialMessage.data(), (int) partialMessage.size());
+                partialMessage.clear();
             }
         }
+
+        if (m.generation != currentGeneration)
+            continue;
+
+        if (m.isNoteOffs)
+        {
+            // Drop anything still waiting for this destination, then send the note-offs
+            // in order with any messages due now
+            pendingMessages.erase (std::remove_if (pendingMessages.begin(), pendingMessages.end(),
+                                                   [&] (auto& p) { return p.destinationIndex == m.destinationIndex; }),
+                                   pendingMessages.end());
+            std::make_heap (pendingMessages.begin(), pendingMessages.end(), isDueLater);
+            m.timeMs = now;
+        }
+        else if (m.timeMs > now + maxTimeAheadMs)
+        {
+            continue;
+        }
+
+        m.sequenceNumber = nextSequenceNumber++;
+        pendingMessages.push_back (std::move (m));
+        std::push_heap (pendingMessages.begin(), pendingMessages.end(), isDueLater);
+    }
+}
+
+void MidiOutputScheduler::sendDueMessages (double now)
+{
+    const juce::ScopedLock sl (destinationLock);
+    const auto currentGeneration = generation.load (std::memory_order_acquire);
+
+    while (! pendingMessages.empty() && pendingMessages.front().timeMs <= now)
+    {
+        std::pop_heap (pendingMessages.begin(), pendingMessages.end(), isDueLater);
+        auto& m = pendingMessages.back();
+
+        if (m.generation == currentGeneration)
+        {
+            if (auto destination = destinations[m.destinationIndex])
+            {
+                if (m.isNoteOffs)
+                    destination->sendScheduledNoteOffs();
+                else
+                    destination->sendScheduledMessage (m.message);
+            }
+        }
+
+        pendingMessages.pop_back();
+    }
+}
+
+//==============================================================================
+void MidiNoteDispatcher::DeviceState::sendScheduledMessage (const juce::MidiMessage& message)
+{
+    device.getMidiOutput().fireMessage (message);
+}
+
+void MidiNoteDispatcher::DeviceState::sendScheduledNoteOffs()
+{
+    device.getMidiOutput().sendNoteOffMessages();
+}
+
+//==============================================================================
+MidiNoteDispatcher::MidiNoteDispatcher()
+{
+}
+
+MidiNoteDispatcher::~MidiNoteDispatcher()
+{
+    scheduler.setDestinations ({});
+}
+
+void MidiNoteDispatcher::dispatchPendingMessagesForDevices (double editTime)
+{
+    // The device list is only locked while it's being swapped, in which case the
+    // messages stay in the devices and are sent after the next block
+    const juce::ScopedTryLock s (deviceLock);
+
+    if (! s.isLocked())
+        return;
+
+    const auto callbackTimeMs = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < devices.size(); ++i)
+        dispatchPendingMessages (i, editTime, callbackTimeMs);
+
+    scheduler.triggerSend();
+}
+
+void MidiNoteDispatcher::dispatchPendingMessages (int deviceIndex, double editTime, double callbackTimeMs)
+{
+    // N.B. This should only be called under a deviceLock
+    auto& device = devices.getUnchecked (deviceIndex)->device;
+    auto& pendingBuffer = device.getPendingMessages();
+    device.context.masterLevels.processMidi (pendingBuffer, nullptr);
+    const double delay = device.getMidiOutput().getDeviceDelay();
+
+    if (device.sendMessages (pendingBuffer, editTime - delay))
+        return;
+
+    // If the scheduler's FIFO is full, anything that couldn't be scheduled is left in the
+    // device to be tried again after the next block. It'll be late, but dropping it could
+    // leave a note stuck on.
+    if (pendingBuffer.isAllNotesOff)
+    {
+        if (! scheduler.scheduleNoteOffs (deviceIndex))
+        {
+            ++numFifoOverflows;
+            return;
+        }
     }
+    else
+    {
+        int numScheduled = 0;
+
+        for (auto& m : pendingBuffer)
+        {
+            if (! scheduler.scheduleMessage (deviceIndex, m, callbackTimeMs + (m.getTimeStamp() - editTime) * 1000.0))
+                break;
+
+            ++numScheduled;
+        }
+
+        if (numScheduled < pendingBuffer.size())
+        {
+            ++numFifoOverflows;
+
+            while (--numScheduled >= 0)
+                pendingBuffer.remove (numScheduled);
+
+            return;
+        }
+    }
+
+    pendingBuffer.clear();
+}
+
+void MidiNoteDispatcher::setMidiDeviceList (const juce::OwnedArray<MidiOutputDeviceInstance>& newList)
+{
+    CRASH_TRACER
+    juce::OwnedArray<DeviceState> newDevices;
+    juce::Array<MidiOutputScheduler::Destination*> destinations;
+
+    for (auto d : newList)
+        destinations.add (newDevices.add (new DeviceState (*d)));
 
-    for (auto& m : messagesToSend)
-        m.device->getMidiOutput().fireMessage (m.message);
+    const juce::ScopedLock sl (deviceLock);
+    newDevices.swapWith (devices);
+    scheduler.setDestinations (destinations);
 }
 
 }
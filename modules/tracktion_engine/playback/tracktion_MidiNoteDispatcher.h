@@ -11,39 +11,151 @@
 namespace tracktion_engine
 {
 
-class MidiNoteDispatcher   : private juce::HighResolutionTimer
+//==============================================================================
+/**
+    Sends MIDI messages at absolute times from a dedicated high-priority thread.
+
+    Messages are pushed from the audio thread through a lock-free FIFO with the time
+    they should be sent, on the juce::Time::getMillisecondCounterHiRes() clock. The
+    thread keeps them ordered by that deadline and sleeps until shortly before the
+    next one is due, then yields until it's reached, so the timing doesn't depend on
+    the period of a timer or on how messages were batched in to audio blocks.
+*/
+class MidiOutputScheduler  : private juce::Thread
+{
+public:
+    /** Something the scheduler sends messages to, e.g. a MIDI output device. */
+    struct Destination
+    {
+        virtual ~Destination() = default;
+
+        /** Called on the scheduler's thread when a message is due. */
+        virtual void sendScheduledMessage (const juce::MidiMessage&) = 0;
+
+        /** Called on the scheduler's thread to stop any notes that are playing. */
+        virtual void sendScheduledNoteOffs() = 0;
+    };
+
+    MidiOutputScheduler();
+    ~MidiOutputScheduler() override;
+
+    /** Sets the destinations that messages are scheduled for, by their index in this array.
+        Any messages waiting to be sent to the previous destinations are dropped, and once
+        this returns the old destinations won't be used again so can be deleted.
+        This starts the thread if there are any destinations and stops it if there aren't.
+    */
+    void setDestinations (const juce::Array<Destination*>&);
+
+    /** Schedules a message to be sent to a destination at the given time.
+        This is lock-free and doesn't allocate so can be called from the audio thread, but
+        only one thread should call this and scheduleNoteOffs(). Messages due more than
+        maxTimeAheadMs from when they're received are dropped.
+        Returns false if the FIFO was too full to hold the whole message.
+    */
+    bool scheduleMessage (int destinationIndex, const juce::MidiMessage&, double timeMs) noexcept;
+
+    /** Drops any messages waiting to be sent to a destination and stops its notes.
+        Returns false if the FIFO was full.
+    */
+    bool scheduleNoteOffs (int destinationIndex) noexcept;
+
+    /** Wakes the thread to look at the newly scheduled messages.
+        Call this once after scheduling a set of messages.
+    */
+    void triggerSend() noexcept;
+
+    static constexpr double maxTimeAheadMs = 250.0;
+
+private:
+    //==============================================================================
+    /** The raw bytes of a message as they're passed through the FIFO, so that the audio
+        thread never has to copy a juce::MidiMessage (which allocates for long SysEx).
+        Messages longer than maxBytes are split over several consecutive entries.
+    */
+    struct FifoEntry
+    {
+        static constexpr int maxBytes = 16;
+
+        juce::uint8 data[maxBytes];
+        juce::uint8 numBytes = 0;
+        bool isContinued = false;
+        bool isNoteOffs = false;
+        int destinationIndex = 0;
+        juce::uint32 generation = 0;
+        double timeMs = 0.0;
+    };
+
+    struct ScheduledMessage
+    {
+        juce::MidiMessage message;
+        double timeMs = 0.0;
+        juce::uint32 generation = 0;
+        int destinationIndex = 0;
+        bool isNoteOffs = false;
+        juce::uint64 sequenceNumber = 0;
+    };
+
+    choc::fifo::SingleReaderSingleWriterFIFO<FifoEntry> fifo;
+    std::vector<ScheduledMessage> pendingMessages;
+    std::vector<juce::uint8> partialMessage;
+    juce::Array<Destination*> destinations;
+    juce::CriticalSection destinationLock;
+    std::atomic<juce::uint32> generation { 0 };
+    juce::uint64 nextSequenceNumber = 0;
+
+    static bool isDueLater (const ScheduledMessage&, const ScheduledMessage&) noexcept;
+
+    void run() override;
+    void readFifo();
+    void sendDueMessages (double now);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiOutputScheduler)
+};
+
+//==============================================================================
+/**
+    Takes the MIDI rendered for the MidiOutputDeviceInstances in each audio block and
+    sends it to the devices at the times they're due using a MidiOutputScheduler.
+*/
+class MidiNoteDispatcher
 {
 public:
     MidiNoteDispatcher();
-    ~MidiNoteDispatcher() override;
+    ~MidiNoteDispatcher();
 
     //==============================================================================
     void setMidiDeviceList (const juce::OwnedArray<MidiOutputDeviceInstance>&);
 
+    /** Called on the audio thread after each block has been rendered.
+        The messages in the devices are timestamped in edit time, so are scheduled
+        relative to when this is called with the time at the start of the block.
+    */
     void dispatchPendingMessagesForDevices (double editTime);
-    
-    void masterTimeUpdate (double editTime);
-    void prepareToPlay (double editTime);
 
-    void hiResTimerCallback() override;
+    /** Returns the number of times messages have had to wait for the next block
+        because the scheduler's FIFO was full.
+    */
+    int getNumFifoOverflows() const noexcept            { return numFifoOverflows; }
 
 private:
     //==============================================================================
-    struct DeviceState
+    struct DeviceState  : public MidiOutputScheduler::Destination
     {
         DeviceState (MidiOutputDeviceInstance& d) : device (d) {}
 
+        void sendScheduledMessage (const juce::MidiMessage&) override;
+        void sendScheduledNoteOffs() override;
+
         MidiOutputDeviceInstance& device;
-        MidiMessageArray buffer;
     };
 
     //==============================================================================
     juce::OwnedArray<DeviceState> devices;
-    juce::CriticalSection timeLock, deviceLock;
-    double masterTime = 0, hiResClockOfMasterTime = 0;
+    juce::CriticalSection deviceLock;
+    MidiOutputScheduler scheduler;
+    std::atomic<int> numFifoOverflows { 0 };
 
-    double getCurrentTime() const;
-    void dispatchPendingMessages (DeviceState&, double editTime);
+    void dispatchPendingMessages (int deviceIndex, double editTime, double callbackTimeMs);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiNoteDispatcher)
 };
@@ -0,0 +1,343 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace midi_scheduler_test_utilities
+{
+    /** Records the messages it's sent and when they arrived, standing in for a looped-back MIDI port. */
+    struct LoopbackDestination  : public MidiOutputScheduler::Destination
+    {
+        void sendScheduledMessage (const juce::MidiMessage& m) override
+        {
+            {
+                const juce::ScopedLock sl (lock);
+                received.push_back ({ m, juce::Time::getMillisecondCounterHiRes() });
+            }
+
+            messageReceived.signal();
+        }
+
+        void sendScheduledNoteOffs() override
+        {
+            ++numNoteOffCalls;
+        }
+
+        std::vector<std::pair<juce::MidiMessage, double>> getReceived() const
+        {
+            const juce::ScopedLock sl (lock);
+            return received;
+        }
+
+        /** Waits until at least the given number of messages have been received. */
+        bool waitForMessages (int numMessages, int timeoutMs = 5000)
+        {
+            const auto endTime = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+            for (;;)
+            {
+                {
+                    const juce::ScopedLock sl (lock);
+
+                    if ((int) received.size() >= numMessages)
+                        return true;
+                }
+
+                const auto now = juce::Time::getMillisecondCounter();
+
+                if (now >= endTime || ! messageReceived.wait ((int) (endTime - now)))
+                    return false;
+            }
+        }
+
+        juce::CriticalSection lock;
+        std::vector<std::pair<juce::MidiMessage, double>> received;
+        juce::WaitableEvent messageReceived;
+        std::atomic<int> numNoteOffCalls { 0 };
+    };
+
+    /** Returns the lateness of each message, using the timestamp as the time it was due. */
+    inline std::vector<double> getLatenessMs (const LoopbackDestination& destination)
+    {
+        std::vector<double> lateness;
+
+        for (auto& r : destination.getReceived())
+            lateness.push_back (r.second - r.first.getTimeStamp());
+
+        std::sort (lateness.begin(), lateness.end());
+        return lateness;
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class MidiOutputSchedulerTests  : public juce::UnitTest
+{
+public:
+    MidiOutputSchedulerTests()
+        : juce::UnitTest ("MidiOutputScheduler", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace midi_scheduler_test_utilities;
+
+        beginTest ("Messages are sent in time order");
+        {
+            LoopbackDestination destination;
+            MidiOutputScheduler scheduler;
+            scheduler.setDestinations ({ &destination });
+
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 62, 1.0f), now + 30.0);
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now + 10.0);
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 61, 1.0f), now + 20.0);
+
+            // Messages due at the same time stay in the order they were scheduled
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOff (1, 60), now + 40.0);
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now + 40.0);
+            scheduler.triggerSend();
+
+            expect (destination.waitForMessages (5));
+            auto received = destination.getReceived();
+            expectEquals ((int) received.size(), 5);
+
+            if (received.size() == 5)
+            {
+                expectEquals (received[0].first.getNoteNumber(), 60);
+                expectEquals (received[1].first.getNoteNumber(), 61);
+                expectEquals (received[2].first.getNoteNumber(), 62);
+                expect (received[3].first.isNoteOff());
+                expect (received[4].first.isNoteOn());
+
+                // None of them should be sent early
+                expectGreaterOrEqual (received[0].second, now + 10.0);
+                expectGreaterOrEqual (received[4].second, now + 40.0);
+            }
+        }
+
+        beginTest ("Note-offs drop the pending messages");
+        {
+            LoopbackDestination destination1, destination2;
+            MidiOutputScheduler scheduler;
+            scheduler.setDestinations ({ &destination1, &destination2 });
+
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now + 50.0);
+            scheduler.scheduleMessage (1, juce::MidiMessage::noteOn (1, 60, 1.0f), now + 50.0);
+            scheduler.scheduleNoteOffs (0);
+            scheduler.triggerSend();
+
+            // The note-offs are due before the message for the other destination
+            expect (destination2.waitForMessages (1));
+            expectEquals (destination1.numNoteOffCalls.load(), 1);
+            expectEquals ((int) destination1.getReceived().size(), 0);
+            expectEquals ((int) destination2.getReceived().size(), 1);
+        }
+
+        beginTest ("Messages for old destinations or too far ahead are dropped");
+        {
+            LoopbackDestination destination1, destination2;
+            MidiOutputScheduler scheduler;
+            scheduler.setDestinations ({ &destination1 });
+
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now + 50.0);
+            scheduler.setDestinations ({ &destination2 });
+
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 61, 1.0f),
+                                       now + MidiOutputScheduler::maxTimeAheadMs + 100.0);
+
+            // This is read after the others so once it's arrived they must have been dropped
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 62, 1.0f), now);
+            scheduler.triggerSend();
+
+            expect (destination2.waitForMessages (1));
+            expectEquals ((int) destination1.getReceived().size(), 0);
+            expectEquals ((int) destination2.getReceived().size(), 1);
+            expectEquals (destination2.getReceived()[0].first.getNoteNumber(), 62);
+
+            scheduler.setDestinations ({});
+        }
+
+        beginTest ("Long SysEx messages are sent intact");
+        {
+            LoopbackDestination destination;
+            MidiOutputScheduler scheduler;
+            scheduler.setDestinations ({ &destination });
+
+            juce::uint8 sysExData[100];
+
+            for (int i = 0; i < (int) sizeof (sysExData); ++i)
+                sysExData[i] = (juce::uint8) (i & 0x7f);
+
+            auto sysEx = juce::MidiMessage::createSysExMessage (sysExData, (int) sizeof (sysExData));
+
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now);
+            scheduler.scheduleMessage (0, sysEx, now + 10.0);
+            scheduler.scheduleMessage (0, juce::MidiMessage::noteOff (1, 60), now + 20.0);
+            scheduler.triggerSend();
+
+            expect (destination.waitForMessages (3));
+            auto received = destination.getReceived();
+            expectEquals ((int) received.size(), 3);
+
+            if (received.size() == 3)
+            {
+                expect (received[0].first.isNoteOn());
+                expect (received[1].first.isSysEx());
+                expectEquals (received[1].first.getRawDataSize(), sysEx.getRawDataSize());
+                expect (memcmp (received[1].first.getRawData(), sysEx.getRawData(), (size_t) sysEx.getRawDataSize()) == 0);
+                expect (received[2].first.isNoteOff());
+            }
+        }
+
+        beginTest ("A full FIFO rejects whole messages");
+        {
+            // There aren't any destinations so the thread isn't reading the FIFO
+            MidiOutputScheduler scheduler;
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+            int numScheduled = 0;
+
+            while (numScheduled < 10000 && scheduler.scheduleMessage (0, juce::MidiMessage::noteOn (1, 60, 1.0f), now))
+                ++numScheduled;
+
+            expect (numScheduled > 0 && numScheduled < 10000);
+            expect (! scheduler.scheduleMessage (0, juce::MidiMessage::noteOff (1, 60), now));
+            expect (! scheduler.scheduleNoteOffs (0));
+        }
+    }
+};
+
+static MidiOutputSchedulerTests midiOutputSchedulerTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class MidiOutputSchedulerBenchmarks  : public juce::UnitTest
+{
+public:
+    MidiOutputSchedulerBenchmarks()
+        : juce::UnitTest ("MidiOutputScheduler Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        for (double blockMs : { 2.9, 10.7 })
+        {
+            runJitterTest (blockMs, false);
+            runJitterTest (blockMs, true);
+        }
+    }
+
+private:
+    /** Sends the messages from a 1ms timer, as the dispatcher used to. */
+    struct TimerDispatcher  : private juce::HighResolutionTimer
+    {
+        TimerDispatcher (MidiOutputScheduler::Destination& d) : destination (d)  { startTimer (1); }
+        ~TimerDispatcher() override                                              { stopTimer(); }
+
+        void add (const juce::MidiMessage& m)
+        {
+            const juce::ScopedLock sl (lock);
+            pending.push_back (m);
+        }
+
+        void hiResTimerCallback() override
+        {
+            const juce::ScopedLock sl (lock);
+            const auto now = juce::Time::getMillisecondCounterHiRes();
+
+            while (! pending.empty() && pending.front().getTimeStamp() <= now)
+            {
+                destination.sendScheduledMessage (pending.front());
+                pending.erase (pending.begin());
+            }
+        }
+
+        MidiOutputScheduler::Destination& destination;
+        juce::CriticalSection lock;
+        std::vector<juce::MidiMessage> pending;
+    };
+
+    void runJitterTest (double blockMs, bool useScheduler)
+    {
+        using namespace midi_scheduler_test_utilities;
+
+        beginTest (juce::String (useScheduler ? "Scheduler" : "1ms timer") + ", "
+                    + juce::String (blockMs) + "ms blocks");
+
+        constexpr int numBlocks = 500;
+        constexpr double messageIntervalMs = 1.3;
+
+        LoopbackDestination destination;
+        MidiOutputScheduler scheduler;
+        std::unique_ptr<TimerDispatcher> timerDispatcher;
+
+        if (useScheduler)
+            scheduler.setDestinations ({ &destination });
+        else
+            timerDispatcher = std::make_unique<TimerDispatcher> (destination);
+
+        // Act like an audio callback which renders a block ahead of when it's played
+        double nextMessageTime = juce::Time::getMillisecondCounterHiRes() + blockMs;
+        int note = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const auto blockStart = juce::Time::getMillisecondCounterHiRes();
+
+            while (nextMessageTime < blockStart + 2.0 * blockMs)
+            {
+                auto m = juce::MidiMessage::noteOn (1, 36 + (note++ % 48), 1.0f);
+                m.setTimeStamp (nextMessageTime);
+
+                if (useScheduler)
+                    scheduler.scheduleMessage (0, m, nextMessageTime);
+                else
+                    timerDispatcher->add (m);
+
+                nextMessageTime += messageIntervalMs;
+            }
+
+            if (useScheduler)
+                scheduler.triggerSend();
+
+            while (juce::Time::getMillisecondCounterHiRes() < blockStart + blockMs)
+                juce::Thread::sleep (1);
+        }
+
+        juce::Thread::sleep (100);
+        timerDispatcher.reset();
+        scheduler.setDestinations ({});
+
+        auto lateness = getLatenessMs (destination);
+        expect (! lateness.empty());
+
+        benchmark_utilities::printDistribution ("Lateness", lateness, "ms", 3);
+    }
+};
+
+static MidiOutputSchedulerBenchmarks midiOutputSchedulerBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
@@ -64,9 +64,9 @@ public:
         plugin.impl->setParameter (index, current);
     }
 
-    void refresh()
+    void refresh (float newValue)
     {
-        currentValue = currentParameterValue = plugin.impl->getParameter (index);
+        currentValue = currentParameterValue = newValue;
         curveHasChanged();
         listeners.call (&Listener::currentValueChanged, *this, currentValue);
     }
@@ -196,16 +196,17 @@ void AirWindowsPlugin::deinitialise()
 
 void AirWindowsPlugin::applyToBuffer (const PluginRenderContext& fc)
 {
-    // We need to lock the processing while a preset is being loaded or the parameters
-    // will overwrite the plugin state before we can update the parameters from the
-    // plugin state
-    juce::ScopedLock sl (lock);
-
     if (fc.destBuffer == nullptr)
         return;
 
     SCOPED_REALTIME_CHECK
 
+    // A newly loaded preset is applied before the parameters. The parameters will
+    // already have been updated to the preset's values on the message thread
+    if (presetState.acquireLatest())
+        if (auto chunk = presetState.getCurrent())
+            impl->setChunk (chunk->getData(), int (chunk->getSize()), false);
+
     for (auto p : parameters)
         if (auto awp = dynamic_cast<AirWindowsAutomatableParameter*> (p))
             impl->setParameter (awp->index, awp->getCurrentValue());
@@ -281,26 +282,30 @@ void AirWindowsPlugin::processBlock (juce::AudioBuffer<float>& buffer)
 
 void AirWindowsPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
 {
-    juce::ScopedLock sl (lock);
-
     if (v.hasProperty (IDs::state))
     {
-        MemoryBlock data;
+        auto data = std::make_unique<MemoryBlock>();
 
         {
-            MemoryOutputStream os (data, false);
+            MemoryOutputStream os (*data, false);
             Base64::convertFromBase64 (os, v[IDs::state].toString());
         }
 
-        impl->setChunk (data.getData(), int (data.getSize()), false);
+        // AirWindows chunks are the normalised parameter values so the parameters can be
+        // updated here, before the audio thread gets the chunk and starts using them
+        auto values = static_cast<const float*> (data->getData());
+        const auto numValues = int (data->getSize() / sizeof (float));
+
+        for (auto p : parameters)
+            if (auto awp = dynamic_cast<AirWindowsAutomatableParameter*> (p))
+                if (awp->index < numValues)
+                    awp->refresh (jlimit (0.0f, 1.0f, values[awp->index]));
+
+        presetState.publish (std::move (data));
     }
 
     CachedValue<float>* cvsFloat[]  = { &wetValue, &dryValue, nullptr };
     copyPropertiesToNullTerminatedCachedValues (v, cvsFloat);
-
-    for (auto p : parameters)
-        if (auto awp = dynamic_cast<AirWindowsAutomatableParameter*> (p))
-            awp->refresh();
 }
 
 void AirWindowsPlugin::flushPluginStateToValueTree()
@@ -309,6 +314,16 @@ void AirWindowsPlugin::flushPluginStateToValueTree()
 
     Plugin::flushPluginStateToValueTree();
 
+    // If the audio thread hasn't picked up the last preset yet, the plugin won't have its values
+    if (presetState.isPending())
+    {
+        if (auto chunk = presetState.getLatest())
+        {
+            state.setProperty (IDs::state, Base64::toBase64 (chunk->getData(), chunk->getSize()), um);
+            return;
+        }
+    }
+
     void* data = nullptr;
     int size = impl->getChunk (&data, false);
 
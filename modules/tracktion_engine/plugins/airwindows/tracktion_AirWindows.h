@@ -81,7 +81,8 @@ protected:
     void setConversionRange (int param, juce::NormalisableRange<float> range);
     void processBlock (juce::AudioBuffer<float>& buffer);
 
-    juce::CriticalSection lock;
+    /** Presets are loaded on the message thread and handed to the audio thread as a chunk. */
+    RealTimeStateSwap<juce::MemoryBlock> presetState;
     AirWindowsCallback callback;
     std::unique_ptr<AirWindowsBase> impl;
 
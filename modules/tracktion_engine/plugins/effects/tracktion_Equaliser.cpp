@@ -193,74 +193,47 @@ static float convertEQLevelToGain (double db)
     return (float) pow (10.0, db / 20.0);
 }
 
-void EqualiserPlugin::updateIIRFilters()
+IIRCoefficients EqualiserPlugin::getCoefficientsForBand (int band, double rate) const
 {
-    const ScopedLock sl (filterLock);
-
-    if (needToUpdateFilters[0])
-    {
-        needToUpdateFilters[0] = false;
-
-        IIRCoefficients c = IIRCoefficients::makeLowShelf (lastSampleRate, loFreq->getCurrentValue(), loQ->getCurrentValue(),
-                                                           convertEQLevelToGain (loGain->getCurrentValue()));
-
-        for (int i = EQ_CHANS; --i >= 0;)
-            low[i].setCoefficients (c);
-    }
-
-    if (needToUpdateFilters[1])
-    {
-        needToUpdateFilters[1] = false;
-
-        IIRCoefficients c = IIRCoefficients::makePeakFilter (lastSampleRate, midFreq1->getCurrentValue(), midQ1->getCurrentValue(),
-                                                             convertEQLevelToGain (midGain1->getCurrentValue()));
-
-        for (int i = EQ_CHANS; --i >= 0;)
-            mid1[i].setCoefficients (c);
-    }
-
-    if (needToUpdateFilters[2])
+    switch (band)
     {
-        needToUpdateFilters[2] = false;
-
-        IIRCoefficients c = IIRCoefficients::makePeakFilter (lastSampleRate, midFreq2->getCurrentValue(), midQ2->getCurrentValue(),
-                                                             convertEQLevelToGain (midGain2->getCurrentValue()));
-
-        for (int i = EQ_CHANS; --i >= 0;)
-            mid2[i].setCoefficients (c);
+        case 0:     return IIRCoefficients::makeLowShelf (rate, loFreq->getCurrentValue(), loQ->getCurrentValue(),
+                                                          convertEQLevelToGain (loGain->getCurrentValue()));
+        case 1:     return IIRCoefficients::makePeakFilter (rate, midFreq1->getCurrentValue(), midQ1->getCurrentValue(),
+                                                            convertEQLevelToGain (midGain1->getCurrentValue()));
+        case 2:     return IIRCoefficients::makePeakFilter (rate, midFreq2->getCurrentValue(), midQ2->getCurrentValue(),
+                                                            convertEQLevelToGain (midGain2->getCurrentValue()));
+        case 3:     return IIRCoefficients::makeHighShelf (rate, hiFreq->getCurrentValue(), hiQ->getCurrentValue(),
+                                                           convertEQLevelToGain (hiGain->getCurrentValue()));
+        default:    jassertfalse; return {};
     }
+}
 
-    if (needToUpdateFilters[3])
+void EqualiserPlugin::updateIIRFilters (FilterState& filters)
+{
+    for (int band = 0; band < 4; ++band)
     {
-        needToUpdateFilters[3] = false;
-
-        IIRCoefficients c = IIRCoefficients::makeHighShelf (lastSampleRate, hiFreq->getCurrentValue(), hiQ->getCurrentValue(),
-                                                            convertEQLevelToGain (hiGain->getCurrentValue()));
+        if (needToUpdateFilters[band].exchange (false))
+        {
+            auto c = getCoefficientsForBand (band, filters.sampleRate);
 
-        for (int i = EQ_CHANS; --i >= 0;)
-            high[i].setCoefficients (c);
+            for (int i = EQ_CHANS; --i >= 0;)
+                filters.bands[band][i].setCoefficients (c);
+        }
     }
 }
 
 void EqualiserPlugin::initialise (const PluginInitialisationInfo&)
 {
-    for (int i = EQ_CHANS; --i >= 0;)
-    {
-        low[i].reset();
-        mid1[i].reset();
-        mid2[i].reset();
-        high[i].reset();
-    }
-
     if (lastSampleRate != sampleRate)
         curveNeedsUpdating = true;
 
     lastSampleRate = (float)sampleRate;
 
-    for (int i = 4; --i >= 0;)
-        needToUpdateFilters[i] = true;
-
-    updateIIRFilters();
+    // This can be called from the message thread or a render thread, so rather than
+    // touching the filters it leaves the audio thread to reset them at its next block
+    sampleRateForFilters = sampleRate;
+    filtersNeedResetting = true;
 }
 
 void EqualiserPlugin::deinitialise()
@@ -273,9 +246,19 @@ void EqualiserPlugin::applyToBuffer (const PluginRenderContext& fc)
     {
         SCOPED_REALTIME_CHECK
 
-        const ScopedLock sl (filterLock);
+        if (filtersNeedResetting.exchange (false))
+        {
+            filterState.sampleRate = sampleRateForFilters;
+
+            for (auto& band : filterState.bands)
+                for (auto& filter : band)
+                    filter.reset();
+
+            for (auto& needsUpdate : needToUpdateFilters)
+                needsUpdate = true;
+        }
 
-        updateIIRFilters();
+        updateIIRFilters (filterState);
 
         jassert (fc.bufferStartSample + fc.bufferNumSamples <= fc.destBuffer->getNumSamples());
 
@@ -287,10 +270,10 @@ void EqualiserPlugin::applyToBuffer (const PluginRenderContext& fc)
         {
             float* const data = fc.destBuffer->getWritePointer (i, fc.bufferStartSample);
 
-            if (loGain->getCurrentValue() != 0)       low[i] .processSamples (data, fc.bufferNumSamples);
-            if (midGain1->getCurrentValue() != 0)     mid1[i].processSamples (data, fc.bufferNumSamples);
-            if (midGain2->getCurrentValue() != 0)     mid2[i].processSamples (data, fc.bufferNumSamples);
-            if (hiGain->getCurrentValue() != 0)       high[i].processSamples (data, fc.bufferNumSamples);
+            if (loGain->getCurrentValue() != 0)       filterState.bands[0][i].processSamples (data, fc.bufferNumSamples);
+            if (midGain1->getCurrentValue() != 0)     filterState.bands[1][i].processSamples (data, fc.bufferNumSamples);
+            if (midGain2->getCurrentValue() != 0)     filterState.bands[2][i].processSamples (data, fc.bufferNumSamples);
+            if (hiGain->getCurrentValue() != 0)       filterState.bands[3][i].processSamples (data, fc.bufferNumSamples);
         }
 
         if (phaseInvert)
@@ -302,8 +285,6 @@ float EqualiserPlugin::getDBGainAtFrequency (float f)
 {
     if (curveNeedsUpdating)
     {
-        updateIIRFilters();
-
         curve.clear();
 
         if (loGain->getCurrentValue() == 0 && midGain1->getCurrentValue() == 0
@@ -316,10 +297,18 @@ float EqualiserPlugin::getDBGainAtFrequency (float f)
         zeromem (samps, sizeof (samps));
         samps[0] = 1.0f;
 
-        if (loGain->getCurrentValue() != 0)     IIRFilter (low[0]) .processSamples (samps, sampSize);
-        if (midGain1->getCurrentValue() != 0)   IIRFilter (mid1[0]).processSamples (samps, sampSize);
-        if (midGain2->getCurrentValue() != 0)   IIRFilter (mid2[0]).processSamples (samps, sampSize);
-        if (hiGain->getCurrentValue() != 0)     IIRFilter (high[0]).processSamples (samps, sampSize);
+        // This uses its own filters so it doesn't interfere with the ones being played
+        AutomatableParameter* gains[] = { loGain.get(), midGain1.get(), midGain2.get(), hiGain.get() };
+
+        for (int band = 0; band < 4; ++band)
+        {
+            if (gains[band]->getCurrentValue() != 0)
+            {
+                IIRFilter filter;
+                filter.setCoefficients (getCoefficientsForBand (band, lastSampleRate));
+                filter.processSamples (samps, sampSize);
+            }
+        }
 
         fft.performRealOnlyForwardTransform (samps);
 
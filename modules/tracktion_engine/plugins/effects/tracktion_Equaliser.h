@@ -82,14 +82,26 @@ private:
     bool curveNeedsUpdating = true;
 
     enum { EQ_CHANS = 2 };
-    juce::IIRFilter low[EQ_CHANS], mid1[EQ_CHANS], mid2[EQ_CHANS], high[EQ_CHANS];
+
+    /** The filters used by the audio thread. These are only ever touched by the thread
+        calling applyToBuffer, initialise just flags that they need resetting.
+    */
+    struct FilterState
+    {
+        juce::IIRFilter bands[4][EQ_CHANS];
+        double sampleRate = 44100.0;
+    };
+
+    FilterState filterState;
+    std::atomic<double> sampleRateForFilters { 0.0 };
+    std::atomic<bool> filtersNeedResetting { false };
 
     enum { fftOrder = 10 };
     juce::dsp::FFT fft { fftOrder };
 
-    void updateIIRFilters();
+    juce::IIRCoefficients getCoefficientsForBand (int band, double sampleRate) const;
+    void updateIIRFilters (FilterState&);
     std::atomic<bool> needToUpdateFilters[4];
-    juce::CriticalSection filterLock;
 
     void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
 
@@ -337,9 +337,15 @@ public:
             filterR1.reset();
             filterL2.reset();
             filterR2.reset();
+            zeromem (batchedFilterState, sizeof (batchedFilterState));
 
             for (auto& o : oscillators)
-                o.start();
+            {
+                if (synth.areRandomOscillatorPhasesEnabled())
+                    o.start();
+                else
+                    o.start (0.0f);
+            }
 
             filterFrequencySmoother.snapToValue();
 
@@ -402,28 +408,9 @@ public:
     using MPESynthesiserVoice::renderNextBlock;
     void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override
     {
-        ScopedValueSetter<bool> svs (snapAllValues, firstBlock ? true : snapAllValues);
-
-        updateParams (numSamples);
-
-        if (firstBlock)
-        {
-            filterFrequencySmoother.snapToValue();
-            firstBlock = false;
-        }
-
-        if (numSamples > renderBuffer.getNumSamples())
-            renderBuffer.setSize (2, numSamples, false, false, true);
-
-        renderBuffer.clear();
-
-        // Run oscillators
-        for (auto& o : oscillators)
-            o.process (renderBuffer, 0, numSamples);
+        renderOscillators (numSamples);
 
         // Apply velocity
-        float velocityGain = velocityToGain (currentlyPlayingNote.noteOnVelocity.asUnsignedFloat(), paramValue (synth.ampVelocity) / 100.0f);
-        velocityGain = jlimit (0.0f, 1.0f, velocityGain);
         renderBuffer.applyGain (velocityGain);
 
         // Apply filter
@@ -457,23 +444,104 @@ public:
             outputBuffer.addFrom (1, startSample, renderBuffer, 1, 0, numSamples);
         }
 
-        if (! ampAdsr.isActive())
+        finishBlock (numSamples);
+    }
+
+    //==============================================================================
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int maxBatchSize = (int) Lanes::SIMDNumElements;
+
+    /** Renders a group of voices together, with the velocity, filters, amp envelope and
+        mixing of each voice running in its own SIMD lane. This gives the same results as
+        calling renderNextBlock on each voice.
+        The oscillators still run one voice at a time as each lane would need to read
+        from a different wave table.
+    */
+    static void renderBatch (FourOscVoice* const* batch, int numVoices,
+                             juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+    {
+        jassert (numVoices > 0 && numVoices <= maxBatchSize);
+
+        auto& synth = batch[0]->synth;
+        const bool useFilter = synth.filterTypeValue != 0;
+        const bool useSecondFilter = useFilter && synth.filterSlopeValue == 24;
+
+        alignas (Lanes::SIMDRegisterSize) float velocityGains[maxBatchSize] = {};
+        const float* inputs[maxBatchSize][2] = {};
+        LaneFilter filters[2][2];
+
+        for (int i = 0; i < numVoices; ++i)
         {
-            isPlaying = false;
-            if (retrigger)
+            auto& voice = *batch[i];
+            voice.renderOscillators (numSamples);
+
+            velocityGains[i] = voice.velocityGain;
+            inputs[i][0] = voice.renderBuffer.getReadPointer (0);
+            inputs[i][1] = voice.renderBuffer.getReadPointer (1);
+
+            for (int stage = 0; stage < 2; ++stage)
+                for (int chan = 0; chan < 2; ++chan)
+                    filters[stage][chan].loadLane (i, voice.filterCoefs[stage], voice.batchedFilterState[stage][chan]);
+        }
+
+        auto outL = outputBuffer.getWritePointer (0, startSample);
+        auto outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
+
+        const auto velocityGain = Lanes::fromRawArray (velocityGains);
+        const auto clipMin = Lanes::expand (-1.0f), clipMax = Lanes::expand (1.0f);
+
+        // Unused lanes stay silent
+        alignas (Lanes::SIMDRegisterSize) float inL[maxBatchSize] = {}, inR[maxBatchSize] = {}, env[maxBatchSize] = {};
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            for (int i = 0; i < numVoices; ++i)
             {
-                noteStarted();
-                retrigger = false;
-                isQuickStop = false;
+                inL[i] = inputs[i][0][n];
+                inR[i] = inputs[i][1][n];
+                env[i] = batch[i]->ampAdsr.getNextSample();
+            }
+
+            auto l = Lanes::fromRawArray (inL) * velocityGain;
+            auto r = Lanes::fromRawArray (inR) * velocityGain;
+
+            if (useFilter)
+            {
+                l = filters[0][0].process (l);
+                r = filters[0][1].process (r);
+
+                if (useSecondFilter)
+                {
+                    l = filters[1][0].process (Lanes::max (clipMin, Lanes::min (clipMax, l)));
+                    r = filters[1][1].process (Lanes::max (clipMin, Lanes::min (clipMax, r)));
+                }
+            }
+
+            const auto envelope = Lanes::fromRawArray (env);
+            l = l * envelope;
+            r = r * envelope;
+
+            if (outR != nullptr)
+            {
+                outL[n] += l.sum();
+                outR[n] += r.sum();
             }
             else
             {
-                clearCurrentNote();
+                outL[n] += 0.5f * (l.sum() + r.sum());
             }
         }
 
-        for (auto& itr : smoothers)
-            itr.second.process (numSamples);
+        for (int i = 0; i < numVoices; ++i)
+        {
+            auto& voice = *batch[i];
+
+            for (int stage = 0; stage < 2; ++stage)
+                for (int chan = 0; chan < 2; ++chan)
+                    filters[stage][chan].storeLane (i, voice.batchedFilterState[stage][chan]);
+
+            voice.finishBlock (numSamples);
+        }
     }
 
     void applyEnvelopeToBuffer (ADSR& adsr, AudioSampleBuffer& buffer, int startSample, int numSamples)
@@ -649,6 +717,9 @@ public:
 
             filterL2.setCoefficients (coefs2);
             filterR2.setCoefficients (coefs2);
+
+            filterCoefs[0] = coefs1;
+            filterCoefs[1] = coefs2;
         }
 
         // Oscillators
@@ -686,6 +757,88 @@ public:
     void noteKeyStateChanged() override     {}
 
 private:
+    /** A biquad with the same structure as juce::IIRFilter, running a separate filter in each lane. */
+    struct LaneFilter
+    {
+        Lanes c0 = Lanes::expand (0.0f), c1 = Lanes::expand (0.0f), c2 = Lanes::expand (0.0f),
+              c3 = Lanes::expand (0.0f), c4 = Lanes::expand (0.0f),
+              v1 = Lanes::expand (0.0f), v2 = Lanes::expand (0.0f);
+
+        void loadLane (int lane, const IIRCoefficients& coefs, const float* state) noexcept
+        {
+            auto i = (size_t) lane;
+            c0.set (i, coefs.coefficients[0]);
+            c1.set (i, coefs.coefficients[1]);
+            c2.set (i, coefs.coefficients[2]);
+            c3.set (i, coefs.coefficients[3]);
+            c4.set (i, coefs.coefficients[4]);
+            v1.set (i, state[0]);
+            v2.set (i, state[1]);
+        }
+
+        void storeLane (int lane, float* state) const noexcept
+        {
+            state[0] = v1.get ((size_t) lane);
+            state[1] = v2.get ((size_t) lane);
+        }
+
+        Lanes process (Lanes in) noexcept
+        {
+            auto out = c0 * in + v1;
+            v1 = c1 * in - c3 * out + v2;
+            v2 = c2 * in - c4 * out;
+            return out;
+        }
+    };
+
+    /** Updates the parameters and renders the oscillators into renderBuffer. */
+    void renderOscillators (int numSamples)
+    {
+        ScopedValueSetter<bool> svs (snapAllValues, firstBlock ? true : snapAllValues);
+
+        updateParams (numSamples);
+
+        if (firstBlock)
+        {
+            filterFrequencySmoother.snapToValue();
+            firstBlock = false;
+        }
+
+        if (numSamples > renderBuffer.getNumSamples())
+            renderBuffer.setSize (2, numSamples, false, false, true);
+
+        renderBuffer.clear();
+
+        // Run oscillators
+        for (auto& o : oscillators)
+            o.process (renderBuffer, 0, numSamples);
+
+        velocityGain = velocityToGain (currentlyPlayingNote.noteOnVelocity.asUnsignedFloat(), paramValue (synth.ampVelocity) / 100.0f);
+        velocityGain = jlimit (0.0f, 1.0f, velocityGain);
+    }
+
+    /** Stops or retriggers the note once the amp envelope has finished. */
+    void finishBlock (int numSamples)
+    {
+        if (! ampAdsr.isActive())
+        {
+            isPlaying = false;
+            if (retrigger)
+            {
+                noteStarted();
+                retrigger = false;
+                isQuickStop = false;
+            }
+            else
+            {
+                clearCurrentNote();
+            }
+        }
+
+        for (auto& itr : smoothers)
+            itr.second.process (numSamples);
+    }
+
     float paramValue (AutomatableParameter::Ptr param)
     {
         jassert (param != nullptr);
@@ -739,6 +892,11 @@ private:
     SimpleLFO lfo1, lfo2;
     juce::IIRFilter filterL1, filterR1, filterL2, filterR2;
 
+    // The batched path keeps its own filter state as the juce::IIRFilter state is private
+    IIRCoefficients filterCoefs[2];
+    float batchedFilterState[2][2][2] = {};
+    float velocityGain = 1.0f;
+
     ValueSmoother<float> filterFrequencySmoother;
 
     bool retrigger = false, isPlaying = false, isQuickStop = false, snapAllValues = false, firstBlock = false;
@@ -1280,20 +1438,15 @@ void FourOscPlugin::valueTreePropertyChanged (juce::ValueTree& v, const juce::Id
         if (i == IDs::voiceMode
             || i == IDs::voices)
         {
-            juce::ScopedLock sl (voicesLock);
-            if (voiceModeValue == 2)
-            {
-                reduceNumVoices (voicesValue.get());
-                while (getNumVoices() < voicesValue.get())
-                    addVoice (new FourOscVoice (*this));
-            }
-            else
-            {
-                while (getNumVoices() < 1)
-                    addVoice (new FourOscVoice (*this));
+            // Voices are only ever added here, so the audio thread never allocates any. It just
+            // stops using the ones after the current count. The pool starts at the default
+            // number of voices so this only takes the synth's lock if more are needed
+            const int numVoices = voiceModeValue == 2 ? juce::jmax (1, voicesValue.get()) : 1;
 
-                reduceNumVoices (1);
-            }
+            while (getNumVoices() < juce::jmax (numVoices, defaultNumVoices))
+                addVoice (new FourOscVoice (*this));
+
+            numUsableVoices = numVoices;
         }
         else if (i == IDs::mpe)
         {
@@ -1418,6 +1571,7 @@ void FourOscPlugin::flushPluginStateToValueTree()
 void FourOscPlugin::initialise (const PluginInitialisationInfo& info)
 {
     setCurrentPlaybackSampleRate (info.sampleRate);
+    waveTables = BandlimitedWaveLookupTables::getLookupTables (info.sampleRate);
 
     reverb.setSampleRate (info.sampleRate);
     delay->setSampleRate (info.sampleRate);
@@ -1443,12 +1597,18 @@ void FourOscPlugin::reset()
 
 void FourOscPlugin::applyToBuffer (const PluginRenderContext& fc)
 {
-    juce::ScopedLock sl (voicesLock);
-
     if (fc.destBuffer != nullptr)
     {
         SCOPED_REALTIME_CHECK
 
+        if (numVoicesInUse != numUsableVoices.load())
+            stopUnusableVoices();
+
+        // Until the background thread has built the wave tables for the low notes, higher
+        // ones are used in their place, so they're built here to keep renders repeatable
+        if (fc.isRendering && waveTables != nullptr && ! waveTables->isFullyBuilt())
+            waveTables->buildAllTables();
+
         // find the tempo
         double now = fc.editTime;
         currentPos.setTime (now);
@@ -1504,6 +1664,55 @@ void FourOscPlugin::applyToBuffer (const PluginRenderContext& fc)
     }
 }
 
+void FourOscPlugin::stopUnusableVoices()
+{
+    // This is the lock the synthesiser takes for each block, the message thread only
+    // takes it when the voice pool grows
+    const juce::ScopedLock sl (voicesLock);
+    numVoicesInUse = numUsableVoices;
+
+    for (int i = numVoicesInUse; i < voices.size(); ++i)
+    {
+        auto voice = voices.getUnchecked (i);
+
+        if (voice->isActive())
+            stopVoice (voice, voice->getCurrentlyPlayingNote(), false);
+    }
+}
+
+MPESynthesiserVoice* FourOscPlugin::findFreeVoice (MPENote noteToFindVoiceFor, bool stealIfNoneAvailable) const
+{
+    const int numVoices = juce::jmin (numVoicesInUse, voices.size());
+
+    for (int i = 0; i < numVoices; ++i)
+        if (! voices.getUnchecked (i)->isActive())
+            return voices.getUnchecked (i);
+
+    return stealIfNoneAvailable ? findVoiceToSteal (noteToFindVoiceFor) : nullptr;
+}
+
+MPESynthesiserVoice* FourOscPlugin::findVoiceToSteal (MPENote) const
+{
+    // Steal the oldest released voice, or the oldest one if they're all still held.
+    // Unlike the default this only looks at the voices in use and doesn't allocate
+    const int numVoices = juce::jmin (numVoicesInUse, voices.size());
+    MPESynthesiserVoice* oldest = nullptr;
+    MPESynthesiserVoice* oldestReleased = nullptr;
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voice = voices.getUnchecked (i);
+
+        if (oldest == nullptr || voice->wasStartedBefore (*oldest))
+            oldest = voice;
+
+        if (voice->isPlayingButReleased() && (oldestReleased == nullptr || voice->wasStartedBefore (*oldestReleased)))
+            oldestReleased = voice;
+    }
+
+    return oldestReleased != nullptr ? oldestReleased : oldest;
+}
+
 void FourOscPlugin::applyToBuffer (AudioSampleBuffer& buffer, MidiBuffer& midi)
 {
     updateParams (buffer);
@@ -1514,6 +1723,39 @@ void FourOscPlugin::applyToBuffer (AudioSampleBuffer& buffer, MidiBuffer& midi)
         itr.second.process (buffer.getNumSamples());
 }
 
+void FourOscPlugin::renderNextSubBlock (AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (! voiceBatchingEnabled)
+    {
+        MPESynthesiser::renderNextSubBlock (buffer, startSample, numSamples);
+        return;
+    }
+
+    // juce::IIRFilter snaps tiny values to zero but the batched filters rely on this instead
+    const ScopedNoDenormals noDenormals;
+    const ScopedLock sl (voicesLock);
+
+    FourOscVoice* batch[FourOscVoice::maxBatchSize];
+    int numInBatch = 0;
+
+    for (auto v : voices)
+    {
+        if (v->isActive())
+        {
+            batch[numInBatch++] = static_cast<FourOscVoice*> (v);
+
+            if (numInBatch == FourOscVoice::maxBatchSize)
+            {
+                FourOscVoice::renderBatch (batch, numInBatch, buffer, startSample, numSamples);
+                numInBatch = 0;
+            }
+        }
+    }
+
+    if (numInBatch > 0)
+        FourOscVoice::renderBatch (batch, numInBatch, buffer, startSample, numSamples);
+}
+
 void FourOscPlugin::applyEffects (AudioSampleBuffer& buffer)
 {
     int numSamples = buffer.getNumSamples();
@@ -170,6 +170,19 @@ public:
     bool isLegato() const                               { return voiceModeValue.get() == 1; }
     bool isPoly() const                                 { return voiceModeValue.get() == 2; }
 
+    /** When enabled, the active voices are rendered in groups which share SIMD lanes for
+        their filters, envelopes and mixing, rather than one voice at a time.
+        This is on by default, turning it off is mainly useful for comparing the two.
+    */
+    void setVoiceBatchingEnabled (bool shouldBatch)     { voiceBatchingEnabled = shouldBatch; }
+    bool isVoiceBatchingEnabled() const                 { return voiceBatchingEnabled; }
+
+    /** Each note's oscillators normally start at a random phase. Turning this off starts
+        them all at zero so the output is the same every time, e.g. when comparing renders.
+    */
+    void setRandomOscillatorPhasesEnabled (bool shouldRandomise)    { randomOscillatorPhases = shouldRandomise; }
+    bool areRandomOscillatorPhasesEnabled() const                   { return randomOscillatorPhases; }
+
     //==============================================================================
     static const char* getPluginName()                  { return NEEDS_TRANS("4OSC"); }
     static const char* xmlTypeName;
@@ -384,7 +397,13 @@ private:
     void setupTextFunctions();
     AutomatableParameter* addParam (const juce::String& paramID, const juce::String& name, juce::NormalisableRange<float> valueRange, juce::String label = {});
 
+    void stopUnusableVoices();
+    juce::MPESynthesiserVoice* findFreeVoice (juce::MPENote, bool stealIfNoneAvailable) const override;
+    juce::MPESynthesiserVoice* findVoiceToSteal (juce::MPENote) const override;
+
     void applyToBuffer (juce::AudioSampleBuffer& buffer, juce::MidiBuffer& midi);
+    using juce::MPESynthesiser::renderNextSubBlock;
+    void renderNextSubBlock (juce::AudioBuffer<float>&, int startSample, int numSamples) override;
     void updateParams (juce::AudioSampleBuffer& buffer);
     void applyEffects (juce::AudioSampleBuffer& buffer);
     float paramValue (AutomatableParameter::Ptr param);
@@ -393,8 +412,14 @@ private:
     juce::Reverb reverb;
     std::unique_ptr<FODelay> delay;
     std::unique_ptr<FOChorus> chorus;
+    BandlimitedWaveLookupTables::Ptr waveTables;
     std::unordered_map<AutomatableParameter*, ValueSmoother<float>> smoothers;
 
+    static constexpr int defaultNumVoices = 32;
+    std::atomic<int> numUsableVoices { 1 };
+    int numVoicesInUse = 1;
+    std::atomic<bool> voiceBatchingEnabled { true }, randomOscillatorPhases { true };
+
     bool flushingState = false;
     float currentTempo = 0.0f;
     LevelMeasurer levelMeasurer;
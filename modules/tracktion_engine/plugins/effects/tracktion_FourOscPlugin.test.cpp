@@ -0,0 +1,174 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace four_osc_test_utilities
+{
+    /** Sets all the oscillators to the given wave and number of unison voices. */
+    inline void setOscillators (Plugin& plugin, Oscillator::Waves wave, int numUnisonVoices)
+    {
+        for (int i = 1; i <= 4; ++i)
+        {
+            plugin.state.setProperty (IDs::waveShape.toString() + juce::String (i), (int) wave, nullptr);
+            plugin.state.setProperty (IDs::voices.toString() + juce::String (i), numUnisonVoices, nullptr);
+        }
+    }
+
+    inline void setFilter (Plugin& plugin, int type, int slope)
+    {
+        plugin.state.setProperty (IDs::filterType, type, nullptr);
+        plugin.state.setProperty (IDs::filterSlope, slope, nullptr);
+    }
+
+    /** Returns the given number of notes, a fifth apart so none of them share frequencies. */
+    inline juce::Array<int> getNotes (int numNotes)
+    {
+        juce::Array<int> notes;
+
+        for (int i = 0; i < numNotes; ++i)
+            notes.add (24 + (i * 7) % 96);
+
+        return notes;
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class FourOscPluginTests    : public juce::UnitTest
+{
+public:
+    FourOscPluginTests()
+        : juce::UnitTest ("FourOscPlugin", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        // Batches are split into groups of lanes so these include partly filled groups
+        for (int numNotes : { 1, 3, 6, 11 })
+        {
+            beginTest ("Batched voices match single voices: " + juce::String (numNotes) + " notes");
+            {
+                for (int filterType : { 0, 1, 3 })
+                    for (int slope : { 12, 24 })
+                        expectBatchedMatchesSingleVoices (*edit, numNotes, filterType, slope);
+            }
+        }
+
+        beginTest ("Rendering builds all the wave tables first");
+        {
+            // This sample rate isn't used elsewhere so its tables won't have been built yet
+            const double sampleRate = 37800.0;
+            auto plugin = edit->getPluginCache().createNewPlugin (FourOscPlugin::xmlTypeName, {});
+            four_osc_test_utilities::setOscillators (*plugin, Oscillator::saw, 1);
+            expect (! BandlimitedWaveLookupTables::getLookupTables (sampleRate)->isFullyBuilt());
+
+            plugin_test_utilities::renderNotes (*plugin, { 24 }, sampleRate, 512, 512);
+            expect (BandlimitedWaveLookupTables::getLookupTables (sampleRate)->isFullyBuilt());
+        }
+    }
+
+private:
+    void expectBatchedMatchesSingleVoices (Edit& edit, int numNotes, int filterType, int slope)
+    {
+        using namespace four_osc_test_utilities;
+        const double sampleRate = 44100.0;
+        const int numSamples = (int) sampleRate;
+
+        juce::AudioBuffer<float> outputs[2];
+
+        for (bool batched : { false, true })
+        {
+            auto plugin = edit.getPluginCache().createNewPlugin (FourOscPlugin::xmlTypeName, {});
+            auto& fourOsc = dynamic_cast<FourOscPlugin&> (*plugin);
+            fourOsc.setVoiceBatchingEnabled (batched);
+            fourOsc.setRandomOscillatorPhasesEnabled (false);
+            setFilter (*plugin, filterType, slope);
+
+            outputs[batched ? 1 : 0] = plugin_test_utilities::renderNotes (*plugin, getNotes (numNotes), sampleRate, 512, numSamples);
+        }
+
+        expectGreaterThan (outputs[0].getMagnitude (0, numSamples), 0.0f);
+
+        expectLessThan (audio_test_utilities::getMaxDifference (outputs[0], outputs[1]), 0.0001f, "Filter type " + juce::String (filterType) + ", slope " + juce::String (slope));
+    }
+};
+
+static FourOscPluginTests fourOscPluginTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+//==============================================================================
+class FourOscPluginBenchmarks   : public juce::UnitTest
+{
+public:
+    FourOscPluginBenchmarks()
+        : juce::UnitTest ("FourOscPlugin Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        for (int numUnisonVoices : { 1, 4 })
+            for (int numNotes : { 1, 4, 8, 16, 32 })
+                runVoiceBenchmark (*edit, numNotes, numUnisonVoices);
+    }
+
+private:
+    void runVoiceBenchmark (Edit& edit, int numNotes, int numUnisonVoices)
+    {
+        using namespace four_osc_test_utilities;
+        const double sampleRate = 44100.0, durationSeconds = 10.0;
+        double seconds[2] = {};
+
+        for (bool batched : { false, true })
+        {
+            beginTest (juce::String (numNotes) + " voices, 4 saws x " + juce::String (numUnisonVoices)
+                        + (batched ? ", batched" : ", single voices"));
+            {
+                auto plugin = edit.getPluginCache().createNewPlugin (FourOscPlugin::xmlTypeName, {});
+                dynamic_cast<FourOscPlugin&> (*plugin).setVoiceBatchingEnabled (batched);
+                setOscillators (*plugin, Oscillator::saw, numUnisonVoices);
+                setFilter (*plugin, 1, 24);
+
+                const StopwatchTimer timer;
+                auto output = plugin_test_utilities::renderNotes (*plugin, getNotes (numNotes), sampleRate, 512,
+                                                                  (int) (sampleRate * durationSeconds));
+                seconds[batched ? 1 : 0] = benchmark_utilities::printRealTimeFactor (timer, durationSeconds);
+                expectGreaterThan (output.getMagnitude (0, output.getNumSamples()), 0.0f);
+            }
+        }
+
+        benchmark_utilities::printSpeedUp ("Batched speed-up", seconds[0], seconds[1]);
+    }
+};
+
+static FourOscPluginBenchmarks fourOscPluginBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
@@ -144,6 +144,8 @@ void ImpulseResponsePlugin::applyToBuffer (const PluginRenderContext& fc)
     auto& postGain = processorChain.get<postGainIndex>();
     postGain.setGainLinear (postGainParam->getCurrentValue());
 
+    processorChain.get<convolutionIndex>().setNonRealtime (fc.isRendering);
+
     dsp::AudioBlock <float> inoutBlock (*fc.destBuffer);
     dsp::ProcessContextReplacing <float> context (inoutBlock);
     processorChain.process (context);
@@ -174,11 +176,13 @@ void ImpulseResponsePlugin::loadImpulseResponseFromState()
             reader->read (&loadIRBuffer, 0, (int) reader->lengthInSamples, 0, true, true);
 
             jassert (reader->numChannels > 0);
+
+            // Other instances that have loaded the same data will share the transformed IR
+            const auto sourceHash = (juce::uint64) std::hash<std::string_view>() (std::string_view (static_cast<const char*> (irFileData->getData()),
+                                                                                                 irFileData->getSize()));
             processorChain.get<convolutionIndex>().loadImpulseResponse (std::move (loadIRBuffer),
                                                                         reader->sampleRate,
-                                                                        reader->numChannels > 1 ? dsp::Convolution::Stereo::yes : dsp::Convolution::Stereo::no,
-                                                                        dsp::Convolution::Trim::no,
-                                                                        dsp::Convolution::Normalise::no);
+                                                                        sourceHash);
         }
     }
 }
@@ -17,6 +17,10 @@ namespace tracktion_engine
 /**
     ImpulseResponsePlugin that loads an impulse response and applies it the audio stream.
     Additionally this has high and low pass filters to shape the sound.
+
+    The IR is applied with a PartitionedConvolver so there's no latency and the tails of
+    long IRs are processed on background threads. Instances that load the same IR share
+    its transformed data.
 */
 class ImpulseResponsePlugin  : public Plugin
 {
@@ -35,17 +39,17 @@ public:
 
     //==============================================================================
     /** Loads an impulse from binary audio file data i.e. not a block of raw floats.
-        @see juce::Convolution::loadImpulseResponse
+        @see PartitionedConvolver::loadImpulseResponse
     */
     bool loadImpulseResponse (const void* sourceData, size_t sourceDataSize);
 
     /** Loads an impulse from a file.
-        @see juce::Convolution::loadImpulseResponse
+        @see PartitionedConvolver::loadImpulseResponse
     */
     bool loadImpulseResponse (const File& fileImpulseResponse);
 
     /** Loads an impulse from an AudioBuffer<float>.
-        @see juce::Convolution::loadImpulseResponse
+        @see PartitionedConvolver::loadImpulseResponse
     */
     bool loadImpulseResponse (AudioBuffer<float>&& bufferImpulseResponse,
                               double sampleRateToStore,
@@ -102,7 +106,7 @@ private:
     };
 
     dsp::ProcessorChain<dsp::Gain<float>,
-                        dsp::Convolution,
+                        PartitionedConvolver,
                         dsp::ProcessorDuplicator<dsp::IIR::Filter<float>, dsp::IIR::Coefficients<float>>,
                         dsp::ProcessorDuplicator<dsp::IIR::Filter<float>, dsp::IIR::Coefficients<float>>,
                         dsp::Gain<float>> processorChain;
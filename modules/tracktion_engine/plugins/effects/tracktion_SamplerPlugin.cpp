@@ -13,40 +13,245 @@ namespace tracktion_engine
 
 // this must be high enough for low freq sounds not to click
 static constexpr int minimumSamplesToPlayWhenStopping = 8;
-static constexpr int maximumSimultaneousNotes = 32;
 
 
+//==============================================================================
+/** A reader used by one note at a time to stream the part of a sound that isn't preloaded.
+
+    Each reader is targeted at the streamed section of one file. When a note needs one
+    for a different file, the audio thread asks for it to be retargeted and doesn't touch
+    it again until that's been done, as creating a cache reader isn't real-time safe.
+*/
+struct SamplerPlugin::StreamReader
+{
+    /** Returns true if this can be read from for the given part of a file. Audio thread only. */
+    bool isTargetedAt (juce::int64 hash, int startSample) const noexcept
+    {
+        return ! retargetPending.load (std::memory_order_acquire)
+                && reader != nullptr && fileHash == hash && fileStartSample == startSample;
+    }
+
+    /** Returns true if this is targeted at, or is being retargeted at, the sound. Audio thread only. */
+    bool isFor (const SamplerSound& sound) const noexcept
+    {
+        if (retargetPending.load (std::memory_order_acquire))
+            return requestedSound.load() == &sound;
+
+        return isTargetedAt (sound.audioFile.getHash(), sound.fileStartSample);
+    }
+
+    /** Hands the reader back, leaving it at the start of the streamed section so the cache
+        has that ready for the next note. Audio thread only.
+    */
+    void release() noexcept
+    {
+        inUse = false;
+
+        if (! retargetPending.load (std::memory_order_acquire) && reader != nullptr)
+            reader->setReadPosition (fileStartSample + diskStreamingPreloadSamples);
+    }
+
+    /** Not real-time safe so only called on the message thread or when rendering. */
+    void retarget (SamplerPlugin& plugin, const SamplerSound& sound)
+    {
+        reader = plugin.engine.getAudioFileManager().cache.createReader (sound.audioFile);
+        fileHash = reader != nullptr ? sound.audioFile.getHash() : 0;
+        fileStartSample = sound.fileStartSample;
+
+        if (reader != nullptr)
+            reader->setReadPosition (fileStartSample + diskStreamingPreloadSamples);
+    }
+
+    // While a retarget is pending these belong to the message thread, otherwise to the audio thread
+    AudioFileCache::Reader::Ptr reader;
+    juce::int64 fileHash = 0;
+    int fileStartSample = 0;
+    std::atomic<const SamplerSound*> requestedSound { nullptr };
+    std::atomic<bool> retargetPending { false };
+
+    bool inUse = false;
+};
+
+//==============================================================================
+/** There's a reader for each note that can play, which are retargeted at whichever
+    sounds are being played rather than each sound needing a reader for every note.
+*/
+struct SamplerPlugin::StreamReaderPool   : private juce::Timer
+{
+    StreamReaderPool (SamplerPlugin& p)  : plugin (p) {}
+
+    /** Readers are only retargeted while there are sounds being streamed. Message thread only. */
+    void setActive (bool shouldBeActive)
+    {
+        if (shouldBeActive)
+            startTimer (10);
+        else
+            stopTimer();
+    }
+
+    /** Returns a reader for a note to stream the sound with, or nullptr if they're all in
+        use. This may not be ready yet if it needs retargeting at the sound's file, in
+        which case the note can only play the preloaded part until it is.
+        Audio thread only.
+    */
+    StreamReader* acquire (const SamplerSound& sound, const SoundList& sounds, bool isRendering)
+    {
+        for (auto& r : readers)
+        {
+            if (! r.inUse && r.isFor (sound))
+            {
+                r.inUse = true;
+                return &r;
+            }
+        }
+
+        if (auto r = findReaderToRetarget (sounds, true))
+        {
+            r->inUse = true;
+            requestRetarget (*r, sound, isRendering);
+            return r;
+        }
+
+        return nullptr;
+    }
+
+    /** Makes sure there's a reader ready for each of the streamed sounds if there are any
+        free that aren't being used for another of them. Audio thread only.
+    */
+    void prepareFor (const SoundList& sounds, bool isRendering)
+    {
+        for (auto sound : sounds)
+        {
+            if (! sound->isStreaming() || hasReaderFor (*sound))
+                continue;
+
+            if (auto r = findReaderToRetarget (sounds, false))
+                requestRetarget (*r, *sound, isRendering);
+        }
+    }
+
+private:
+    SamplerPlugin& plugin;
+    std::array<StreamReader, maximumSimultaneousNotes> readers;
+
+    bool hasReaderFor (const SamplerSound& sound) const noexcept
+    {
+        return std::any_of (readers.begin(), readers.end(), [&sound] (auto& r) { return r.isFor (sound); });
+    }
+
+    /** Prefers free readers that none of the sounds need, then ones that are targeted at
+        the same part of a file as another free reader.
+    */
+    StreamReader* findReaderToRetarget (const SoundList& sounds, bool canTakeReaderAnotherSoundNeeds) noexcept
+    {
+        StreamReader* duplicate = nullptr;
+        StreamReader* any = nullptr;
+
+        for (auto& r : readers)
+        {
+            if (r.inUse || r.retargetPending.load (std::memory_order_acquire))
+                continue;
+
+            auto targetsSameFile = [&r] (const StreamReader& other)
+            {
+                return &other != &r && ! other.inUse && other.isTargetedAt (r.fileHash, r.fileStartSample);
+            };
+
+            auto isNeededBy = [&r] (const SamplerSound* s)
+            {
+                return s->isStreaming() && r.isTargetedAt (s->audioFile.getHash(), s->fileStartSample);
+            };
+
+            if (std::none_of (sounds.begin(), sounds.end(), isNeededBy))
+                return &r;
+
+            if (duplicate == nullptr && std::any_of (readers.begin(), readers.end(), targetsSameFile))
+                duplicate = &r;
+
+            if (any == nullptr)
+                any = &r;
+        }
+
+        if (duplicate != nullptr)
+            return duplicate;
+
+        return canTakeReaderAnotherSoundNeeds ? any : nullptr;
+    }
+
+    void requestRetarget (StreamReader& r, const SamplerSound& sound, bool isRendering)
+    {
+        // When rendering the audio thread can wait for the reader to be created
+        if (isRendering)
+        {
+            r.retarget (plugin, sound);
+            return;
+        }
+
+        r.requestedSound = &sound;
+        r.retargetPending.store (true, std::memory_order_release);
+    }
+
+    void timerCallback() override
+    {
+        // Sounds are only deleted on this thread, so if a sound is one of the latest ones
+        // it's safe to use. If not, the notes using it will already have been stopped.
+        auto& latestSounds = plugin.getLatestSounds();
+
+        for (auto& r : readers)
+        {
+            if (! r.retargetPending.load (std::memory_order_acquire))
+                continue;
+
+            if (auto sound = r.requestedSound.load(); latestSounds.contains (sound))
+                r.retarget (plugin, *sound);
+
+            r.requestedSound = nullptr;
+            r.retargetPending.store (false, std::memory_order_release);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamReaderPool)
+};
+
+//==============================================================================
 struct SamplerPlugin::SampledNote   : public ReferenceCountedObject
 {
 public:
-    SampledNote (int midiNote, int keyNote,
+    SampledNote (int midiNote,
                  float velocity,
-                 const AudioFile& file,
+                 SamplerSound& sound,
                  double sampleRate,
                  int sampleDelayFromBufferStart,
-                 const juce::AudioBuffer<float>& data,
-                 int lengthInSamples,
-                 float gainDb,
-                 float pan,
-                 bool openEnded_)
+                 StreamReader* streamReader)
        : note (midiNote),
          offset (-sampleDelayFromBufferStart),
-         audioData (data),
-         openEnded (openEnded_)
+         audioData (sound.audioData),
+         numPreloadedSamples (sound.numPreloadedSamples),
+         fileStartSample (sound.fileStartSample),
+         fileHash (sound.audioFile.getHash()),
+         stream (streamReader),
+         openEnded (sound.openEnded)
     {
         resampler[0].reset();
         resampler[1].reset();
 
-        const float volumeSliderPos = decibelsToVolumeFaderPosition (gainDb - (20.0f * (1.0f - velocity)));
-        getGainsFromVolumeFaderPositionAndPan (volumeSliderPos, pan, getDefaultPanLaw(), gains[0], gains[1]);
+        const float volumeSliderPos = decibelsToVolumeFaderPosition (sound.gainDb - (20.0f * (1.0f - velocity)));
+        getGainsFromVolumeFaderPositionAndPan (volumeSliderPos, sound.pan, getDefaultPanLaw(), gains[0], gains[1]);
 
         const double hz = MidiMessage::getMidiNoteInHertz (midiNote);
-        playbackRatio = hz / MidiMessage::getMidiNoteInHertz (keyNote);
-        playbackRatio *= file.getSampleRate() / sampleRate;
+        playbackRatio = hz / MidiMessage::getMidiNoteInHertz (sound.keyNote);
+        playbackRatio *= sound.audioFile.getSampleRate() / sampleRate;
+
+        int lengthInSamples = sound.fileLengthSamples;
+
+        // If all the readers are busy, just the preloaded part can be played
+        if (sound.isStreaming() && stream == nullptr)
+            lengthInSamples = jmin (lengthInSamples, numPreloadedSamples);
+
         samplesLeftToPlay = playbackRatio > 0 ? (1 + (int) (lengthInSamples / playbackRatio)) : 0;
     }
 
-    void addNextBlock (juce::AudioBuffer<float>& outBuffer, int startSamp, int numSamples)
+    void addNextBlock (juce::AudioBuffer<float>& outBuffer, int startSamp, int numSamples, bool isRendering)
     {
         jassert (! isFinished);
 
@@ -62,22 +267,24 @@ public:
 
         if (numSamps > 0)
         {
+            const int numSampsNeeded = 2 + roundToInt ((numSamps + 2) * playbackRatio);
             int numUsed = 0;
 
-            for (int i = jmin (2, outBuffer.getNumChannels()); --i >= 0;)
+            if (stream != nullptr && offset + numSampsNeeded > numPreloadedSamples)
+            {
+                AudioScratchBuffer scratch (audioData.getNumChannels(), numSampsNeeded);
+                readSourceSamples (scratch.buffer, numSampsNeeded, isRendering);
+                numUsed = resample (scratch.buffer, 0, outBuffer, startSamp, numSamps);
+            }
+            else
             {
-                numUsed = resampler[i]
-                            .processAdding (playbackRatio,
-                                            audioData.getReadPointer (jmin (i, audioData.getNumChannels() - 1), offset),
-                                            outBuffer.getWritePointer (i, startSamp),
-                                            numSamps,
-                                            gains[i]);
+                numUsed = resample (audioData, offset, outBuffer, startSamp, numSamps);
             }
 
             offset += numUsed;
             samplesLeftToPlay -= numSamps;
 
-            jassert (offset <= audioData.getNumSamples());
+            jassert (stream != nullptr || offset <= audioData.getNumSamples());
         }
 
         if (numSamples > numSamps && startFade > 0.0f)
@@ -99,7 +306,12 @@ public:
             const int numSampsNeeded = 2 + roundToInt ((numSamps + 2) * playbackRatio);
             AudioScratchBuffer scratch (audioData.getNumChannels(), numSampsNeeded + 8);
 
-            if (offset + numSampsNeeded < audioData.getNumSamples())
+            if (stream != nullptr)
+            {
+                scratch.buffer.clear();
+                readSourceSamples (scratch.buffer, numSampsNeeded, isRendering);
+            }
+            else if (offset + numSampsNeeded < audioData.getNumSamples())
             {
                 for (int i = scratch.buffer.getNumChannels(); --i >= 0;)
                     scratch.buffer.copyFrom (i, 0, audioData, i, offset, numSampsNeeded);
@@ -115,37 +327,83 @@ public:
 
             startFade = endFade;
 
-            int numUsed = 0;
-
-            for (int i = jmin (2, outBuffer.getNumChannels()); --i >= 0;)
-                numUsed = resampler[i].processAdding (playbackRatio,
-                                                      scratch.buffer.getReadPointer (jmin (i, scratch.buffer.getNumChannels() - 1)),
-                                                      outBuffer.getWritePointer (i, startSamp),
-                                                      numSamps, gains[i]);
-
-            offset += numUsed;
+            offset += resample (scratch.buffer, 0, outBuffer, startSamp, numSamps);
 
             if (startFade <= 0.0f)
                 isFinished = true;
         }
     }
 
+    void releaseStreamReader() noexcept
+    {
+        if (auto s = std::exchange (stream, nullptr))
+            s->release();
+    }
+
     LagrangeInterpolator resampler[2];
     int note;
     int offset, samplesLeftToPlay = 0;
     float gains[2];
     double playbackRatio = 1.0;
     const juce::AudioBuffer<float>& audioData;
+    const int numPreloadedSamples, fileStartSample;
+    const juce::int64 fileHash;
+    StreamReader* stream = nullptr;
     float lastVals[4] = { 0, 0, 0, 0 };
     float startFade = 1.0f;
     bool openEnded, isFinished = false;
 
 private:
+    int resample (const juce::AudioBuffer<float>& source, int sourceOffset,
+                  juce::AudioBuffer<float>& outBuffer, int startSamp, int numSamps)
+    {
+        int numUsed = 0;
+
+        for (int i = jmin (2, outBuffer.getNumChannels()); --i >= 0;)
+            numUsed = resampler[i].processAdding (playbackRatio,
+                                                  source.getReadPointer (jmin (i, source.getNumChannels() - 1), sourceOffset),
+                                                  outBuffer.getWritePointer (i, startSamp),
+                                                  numSamps, gains[i]);
+
+        return numUsed;
+    }
+
+    /** Copies the sound's samples from the current offset into a buffer, taking them
+        from memory where they're preloaded and from the stream reader after that.
+    */
+    void readSourceSamples (juce::AudioBuffer<float>& dest, int numSamples, bool isRendering)
+    {
+        jassert (stream != nullptr);
+        const int numFromMemory = jlimit (0, numSamples, numPreloadedSamples - offset);
+
+        if (numFromMemory > 0)
+            for (int i = dest.getNumChannels(); --i >= 0;)
+                dest.copyFrom (i, 0, audioData, jmin (i, audioData.getNumChannels() - 1), offset, numFromMemory);
+
+        if (numSamples > numFromMemory)
+        {
+            // The reader may still be being retargeted at this sound, in which case, or
+            // for any samples that aren't in the cache yet, the note is left silent
+            if (! stream->isTargetedAt (fileHash, fileStartSample))
+            {
+                dest.clear (numFromMemory, numSamples - numFromMemory);
+                return;
+            }
+
+            auto& reader = *stream->reader;
+            reader.setReadPosition (fileStartSample + offset + numFromMemory);
+            reader.readSamples (numSamples - numFromMemory, dest,
+                                AudioChannelSet::canonicalChannelSet (dest.getNumChannels()), numFromMemory,
+                                AudioChannelSet::stereo(), isRendering ? 5000 : 3);
+        }
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampledNote)
 };
 
 //==============================================================================
-SamplerPlugin::SamplerPlugin (PluginCreationInfo info)  : Plugin (info)
+SamplerPlugin::SamplerPlugin (PluginCreationInfo info)
+    : Plugin (info), streamReaderPool (std::make_unique<StreamReaderPool> (*this))
 {
     triggerAsyncUpdate();
 }
@@ -165,7 +423,28 @@ void SamplerPlugin::valueTreeChanged()
 
 void SamplerPlugin::handleAsyncUpdate()
 {
-    OwnedArray<SamplerSound> newSounds;
+    loadSounds();
+}
+
+void SamplerPlugin::loadPendingSounds()
+{
+    TRACKTION_ASSERT_MESSAGE_THREAD
+    handleUpdateNowIfNeeded();
+}
+
+void SamplerPlugin::loadSounds()
+{
+    // Only the sounds whose media or excerpt has changed are read from disk again
+    auto findLoadedSound = [this] (const ValueTree& v) -> const SamplerSound*
+    {
+        for (auto s : getLatestSounds())
+            if (s->hasLoaded (v[IDs::source].toString(), v[IDs::startTime], v[IDs::length]))
+                return s;
+
+        return nullptr;
+    };
+
+    auto newSounds = std::make_unique<SoundList>();
 
     auto numSounds = state.getNumChildren();
 
@@ -180,7 +459,8 @@ void SamplerPlugin::handleAsyncUpdate()
                                        v[IDs::name],
                                        v[IDs::startTime],
                                        v[IDs::length],
-                                       v[IDs::gainDb]);
+                                       v[IDs::gainDb],
+                                       findLoadedSound (v));
 
             s->keyNote      = jlimit (0, 127, static_cast<int> (v[IDs::keyNote]));
             s->minNote      = jlimit (0, 127, static_cast<int> (v[IDs::minNote]));
@@ -188,41 +468,51 @@ void SamplerPlugin::handleAsyncUpdate()
             s->pan          = jlimit (-1.0f, 1.0f, static_cast<float> (v[IDs::pan]));
             s->openEnded    = v[IDs::openEnded];
 
-            newSounds.add (s);
+            newSounds->add (s);
         }
     }
 
-    for (auto newSound : newSounds)
-    {
-        for (auto s : soundList)
-        {
-            if (s->source == newSound->source
-                && s->startTime == newSound->startTime
-                && s->length == newSound->length)
-            {
-                newSound->audioFile = s->audioFile;
-                newSound->fileStartSample = s->fileStartSample;
-                newSound->fileLengthSamples = s->fileLengthSamples;
-                newSound->audioData = s->audioData;
-            }
-        }
-    }
+    streamReaderPool->setActive (std::any_of (newSounds->begin(), newSounds->end(),
+                                              [] (auto s) { return s->isStreaming(); }));
 
-    {
-        const ScopedLock sl (lock);
-        allNotesOff();
-        soundList.swapWith (newSounds);
+    // The audio thread stops any playing notes when it picks up the new sounds and
+    // the old ones are deleted back on this thread
+    soundLists.publish (std::move (newSounds));
+    changed();
+}
 
-        sourceMediaChanged();
-    }
+const SamplerPlugin::SoundList& SamplerPlugin::getLatestSounds() const
+{
+    static const SoundList noSounds;
 
-    newSounds.clear();
-    changed();
+    if (auto sounds = soundLists.getLatest())
+        return *sounds;
+
+    return noSounds;
+}
+
+juce::int64 SamplerPlugin::getMemoryUsageBytes() const
+{
+    juce::int64 total = 0;
+
+    for (auto s : getLatestSounds())
+        total += (juce::int64) s->audioData.getNumChannels() * s->audioData.getNumSamples() * (juce::int64) sizeof (float);
+
+    return total;
+}
+
+void SamplerPlugin::setDiskStreamingEnabled (bool shouldStream)
+{
+    state.setProperty (IDs::streamFromDisk, shouldStream, getUndoManager());
+}
+
+bool SamplerPlugin::isDiskStreamingEnabled() const
+{
+    return state[IDs::streamFromDisk];
 }
 
 void SamplerPlugin::initialise (const PluginInitialisationInfo&)
 {
-    const ScopedLock sl (lock);
     allNotesOff();
 }
 
@@ -234,8 +524,16 @@ void SamplerPlugin::deinitialise()
 //==============================================================================
 void SamplerPlugin::playNotes (const BigInteger& keysDown)
 {
-    const ScopedLock sl (lock);
+    previewNotes.publish (std::make_unique<BigInteger> (keysDown));
+}
+
+void SamplerPlugin::allNotesOff()
+{
+    allNotesOffPending = true;
+}
 
+void SamplerPlugin::updatePreviewNotes (const BigInteger& keysDown, const SoundList& sounds, bool isRendering)
+{
     if (highlightedNotes != keysDown)
     {
         for (int i = playingNotes.size(); --i >= 0;)
@@ -248,7 +546,7 @@ void SamplerPlugin::playNotes (const BigInteger& keysDown)
         {
             if (keysDown [note] && ! highlightedNotes [note])
             {
-                for (auto ss : soundList)
+                for (auto ss : sounds)
                 {
                     if (ss->minNote <= note
                          && ss->maxNote >= note
@@ -256,17 +554,8 @@ void SamplerPlugin::playNotes (const BigInteger& keysDown)
                          && (! ss->audioFile.isNull())
                          && playingNotes.size() < maximumSimultaneousNotes)
                     {
-                        playingNotes.add (new SampledNote (note,
-                                                           ss->keyNote,
-                                                           0.75f,
-                                                           ss->audioFile,
-                                                           sampleRate,
-                                                           0,
-                                                           ss->audioData,
-                                                           ss->fileLengthSamples,
-                                                           ss->gainDb,
-                                                           ss->pan,
-                                                           ss->openEnded));
+                        auto stream = ss->isStreaming() ? streamReaderPool->acquire (*ss, sounds, isRendering) : nullptr;
+                        playingNotes.add (new SampledNote (note, 0.75f, *ss, sampleRate, 0, stream));
                     }
                 }
             }
@@ -276,9 +565,11 @@ void SamplerPlugin::playNotes (const BigInteger& keysDown)
     }
 }
 
-void SamplerPlugin::allNotesOff()
+void SamplerPlugin::clearPlayingNotes()
 {
-    const ScopedLock sl (lock);
+    for (auto n : playingNotes)
+        n->releaseStreamReader();
+
     playingNotes.clear();
     highlightedNotes.clear();
 }
@@ -289,17 +580,29 @@ void SamplerPlugin::applyToBuffer (const PluginRenderContext& fc)
     {
         SCOPED_REALTIME_CHECK
 
-        const ScopedLock sl (lock);
+        // Changes made on the message thread are picked up here without locking. Any
+        // notes are stopped before new sounds are used as they refer to the old sounds' data
+        const bool soundsChanged = soundLists.acquireLatest();
+        const bool notesOff = allNotesOffPending.exchange (false);
+
+        static const SoundList noSounds;
+        auto sounds = soundLists.getCurrent() != nullptr ? soundLists.getCurrent() : &noSounds;
+
+        if (soundsChanged || notesOff)
+            clearPlayingNotes();
+
+        if (soundsChanged)
+            streamReaderPool->prepareFor (*sounds, fc.isRendering);
+
+        if (previewNotes.acquireLatest())
+            updatePreviewNotes (*previewNotes.getCurrent(), *sounds, fc.isRendering);
 
         clearChannels (*fc.destBuffer, 2, -1, fc.bufferStartSample, fc.bufferNumSamples);
 
         if (fc.bufferForMidiMessages != nullptr)
         {
             if (fc.bufferForMidiMessages->isAllNotesOff)
-            {
-                playingNotes.clear();
-                highlightedNotes.clear();
-            }
+                clearPlayingNotes();
 
             for (auto& m : *fc.bufferForMidiMessages)
             {
@@ -318,7 +621,7 @@ void SamplerPlugin::applyToBuffer (const PluginRenderContext& fc)
                         }
                     }
 
-                    for (auto ss : soundList)
+                    for (auto ss : *sounds)
                     {
                         if (ss->minNote <= note
                             && ss->maxNote >= note
@@ -327,17 +630,8 @@ void SamplerPlugin::applyToBuffer (const PluginRenderContext& fc)
                         {
                             highlightedNotes.setBit (note);
 
-                            playingNotes.add (new SampledNote (note,
-                                                               ss->keyNote,
-                                                               m.getVelocity() / 127.0f,
-                                                               ss->audioFile,
-                                                               sampleRate,
-                                                               noteTimeSample,
-                                                               ss->audioData,
-                                                               ss->fileLengthSamples,
-                                                               ss->gainDb,
-                                                               ss->pan,
-                                                               ss->openEnded));
+                            auto stream = ss->isStreaming() ? streamReaderPool->acquire (*ss, *sounds, fc.isRendering) : nullptr;
+                            playingNotes.add (new SampledNote (note, m.getVelocity() / 127.0f, *ss, sampleRate, noteTimeSample, stream));
                         }
                     }
                 }
@@ -359,8 +653,7 @@ void SamplerPlugin::applyToBuffer (const PluginRenderContext& fc)
                 }
                 else if (m.isAllNotesOff() || m.isAllSoundOff())
                 {
-                    playingNotes.clear();
-                    highlightedNotes.clear();
+                    clearPlayingNotes();
                 }
             }
         }
@@ -369,10 +662,13 @@ void SamplerPlugin::applyToBuffer (const PluginRenderContext& fc)
         {
             auto sn = playingNotes.getUnchecked (i);
 
-            sn->addNextBlock (*fc.destBuffer, fc.bufferStartSample, fc.bufferNumSamples);
+            sn->addNextBlock (*fc.destBuffer, fc.bufferStartSample, fc.bufferNumSamples, fc.isRendering);
 
             if (sn->isFinished)
+            {
+                sn->releaseStreamReader();
                 playingNotes.remove (i);
+            }
         }
     }
 }
@@ -398,18 +694,14 @@ bool SamplerPlugin::hasNameForMidiNoteNumber (int note, int, String& noteName)
 {
     String s;
 
+    for (auto ss : getLatestSounds())
     {
-        const ScopedLock sl (lock);
-
-        for (auto ss : soundList)
+        if (ss->minNote <= note && ss->maxNote >= note)
         {
-            if (ss->minNote <= note && ss->maxNote >= note)
-            {
-                if (s.isNotEmpty())
-                    s << " + " << ss->name;
-                else
-                    s = ss->name;
-            }
+            if (s.isNotEmpty())
+                s << " + " << ss->name;
+            else
+                s = ss->name;
         }
     }
 
@@ -419,9 +711,7 @@ bool SamplerPlugin::hasNameForMidiNoteNumber (int note, int, String& noteName)
 
 AudioFile SamplerPlugin::getSoundFile (int index) const
 {
-    const ScopedLock sl (lock);
-
-    if (auto s = soundList[index])
+    if (auto s = getLatestSounds()[index])
         return s->audioFile;
 
     return AudioFile (edit.engine);
@@ -429,9 +719,7 @@ AudioFile SamplerPlugin::getSoundFile (int index) const
 
 juce::String SamplerPlugin::getSoundMedia (int index) const
 {
-    const ScopedLock sl (lock);
-
-    if (auto s = soundList[index])
+    if (auto s = getLatestSounds()[index])
         return s->source;
 
     return {};
@@ -450,12 +738,8 @@ double SamplerPlugin::getSoundLength (int index) const
     const double l = getSound (index)[IDs::length];
 
     if (l == 0.0)
-    {
-        const ScopedLock sl (lock);
-
-        if (auto s = soundList[index])
+        if (auto s = getLatestSounds()[index])
             return s->length;
-    }
 
     return l;
 }
@@ -485,10 +769,7 @@ String SamplerPlugin::addSound (const juce::String& source, const String& name,
 void SamplerPlugin::removeSound (int index)
 {
     state.removeChild (index, getUndoManager());
-
-    const ScopedLock sl (lock);
-    playingNotes.clear();
-    highlightedNotes.clear();
+    allNotesOff();
 }
 
 void SamplerPlugin::setSoundParams (int index, int keyNote, int minNote, int maxNote)
@@ -586,10 +867,9 @@ void SamplerPlugin::reassignReferencedItem (const ReferencedItem& item, ProjectI
 
 void SamplerPlugin::sourceMediaChanged()
 {
-    const ScopedLock sl (lock);
-
-    for (auto s : soundList)
-        s->refreshFile();
+    // The sounds being played can't be modified so a new set is built, which
+    // reloads any sounds whose files have moved or been modified
+    triggerAsyncUpdate();
 }
 
 void SamplerPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
@@ -603,16 +883,22 @@ SamplerPlugin::SamplerSound::SamplerSound (SamplerPlugin& sf,
                                            const String& name_,
                                            const double startTime_,
                                            const double length_,
-                                           const float gainDb_)
+                                           const float gainDb_,
+                                           const SamplerSound* loadedSound)
     : owner (sf),
       source (source_),
       name (name_),
       gainDb (jlimit (-48.0f, 48.0f, gainDb_)),
       startTime (startTime_),
       length (length_),
+      requestedStartTime (startTime_),
+      requestedLength (length_),
       audioFile (owner.edit.engine, SourceFileReference::findFileFromString (owner.edit, source))
 {
-    setExcerpt (startTime_, length_);
+    if (loadedSound != nullptr)
+        copyLoadedAudio (*loadedSound);
+    else
+        setExcerpt (startTime_, length_);
 
     keyNote = audioFile.getInfo().loopInfo.getRootNote();
 
@@ -650,16 +936,22 @@ void SamplerPlugin::SamplerSound::setExcerpt (double startTime_, double length_)
 
         fileStartSample = roundToInt (startTime * audioFile.getSampleRate());
         fileLengthSamples = roundToInt (length * audioFile.getSampleRate());
+        numPreloadedSamples = fileLengthSamples;
+        fileModificationTime = audioFile.getFile().getLastModificationTime();
+        diskStreamingWasEnabled = owner.isDiskStreamingEnabled();
+
+        if (owner.isDiskStreamingEnabled() && fileLengthSamples > diskStreamingPreloadSamples && canBeStreamed())
+            numPreloadedSamples = diskStreamingPreloadSamples;
 
         if (auto reader = owner.engine.getAudioFileManager().cache.createReader (audioFile))
         {
-            audioData.setSize (audioFile.getNumChannels(), fileLengthSamples + 32);
+            audioData.setSize (audioFile.getNumChannels(), numPreloadedSamples + 32);
             audioData.clear();
 
             auto audioDataChannelSet = AudioChannelSet::canonicalChannelSet (audioFile.getNumChannels());
             auto channelsToUse = AudioChannelSet::stereo();
 
-            int total = fileLengthSamples;
+            int total = numPreloadedSamples;
             int offset = 0;
 
             while (total > 0)
@@ -701,6 +993,38 @@ void SamplerPlugin::SamplerSound::setExcerpt (double startTime_, double length_)
     }
 }
 
+bool SamplerPlugin::SamplerSound::hasLoaded (const String& source_, double startTime_, double length_) const
+{
+    return audioFile.isValid()
+            && source == source_
+            && requestedStartTime == startTime_
+            && requestedLength == length_
+            && diskStreamingWasEnabled == owner.isDiskStreamingEnabled()
+            && audioFile.getFile() == SourceFileReference::findFileFromString (owner.edit, source_)
+            && fileModificationTime == audioFile.getFile().getLastModificationTime();
+}
+
+void SamplerPlugin::SamplerSound::copyLoadedAudio (const SamplerSound& other)
+{
+    audioFile = other.audioFile;
+    startTime = other.startTime;
+    length = other.length;
+    fileStartSample = other.fileStartSample;
+    fileLengthSamples = other.fileLengthSamples;
+    numPreloadedSamples = other.numPreloadedSamples;
+    fileModificationTime = other.fileModificationTime;
+    diskStreamingWasEnabled = other.diskStreamingWasEnabled;
+    audioData = other.audioData;
+}
+
+bool SamplerPlugin::SamplerSound::canBeStreamed() const
+{
+    // Only memory-mapped files are streamed, other formats would each need their own
+    // buffered reader which would use more memory than loading the sound
+    return owner.engine.getAudioFileFormatManager().memoryMappedFormatManager
+             .findFormatForFileExtension (audioFile.getFile().getFileExtension()) != nullptr;
+}
+
 void SamplerPlugin::SamplerSound::refreshFile()
 {
     audioFile = AudioFile (owner.edit.engine);
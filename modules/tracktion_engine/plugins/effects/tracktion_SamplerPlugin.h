@@ -46,6 +46,27 @@ public:
     void playNotes (const juce::BigInteger& keysDown);
     void allNotesOff();
 
+    /** Sounds are loaded asynchronously when the state or their media changes. This
+        loads any pending changes straight away, e.g. before rendering.
+        Message thread only.
+    */
+    void loadPendingSounds();
+
+    //==============================================================================
+    /** In disk-streaming mode only the start of each sound is kept in memory and the
+        rest is read from disk as it's played, with each note reading ahead of itself
+        through the AudioFileCache. Sounds in formats that can't be memory-mapped are
+        always loaded fully.
+    */
+    void setDiskStreamingEnabled (bool);
+    bool isDiskStreamingEnabled() const;
+
+    /** The number of samples of each sound that are kept in memory when streaming. */
+    static constexpr int diskStreamingPreloadSamples = 32768;
+
+    /** Returns the number of bytes of audio held in memory by the loaded sounds. */
+    juce::int64 getMemoryUsageBytes() const;
+
     //==============================================================================
     static const char* getPluginName()                  { return NEEDS_TRANS("Sampler"); }
     static const char* xmlTypeName;
@@ -77,38 +98,69 @@ public:
     //==============================================================================
     struct SamplerSound
     {
+        /** If a sound that's already loaded from the same part of the same file is given,
+            its audio is copied rather than being read from disk again.
+        */
         SamplerSound (SamplerPlugin&, const juce::String& sourcePathOrProjectID, const juce::String& name,
-                      double startTime, double length, float gainDb);
+                      double startTime, double length, float gainDb,
+                      const SamplerSound* loadedSound = nullptr);
 
         void setExcerpt (double startTime, double length);
         void refreshFile();
 
+        /** Returns true if this has loaded the given part of a file, and the file hasn't changed since. */
+        bool hasLoaded (const juce::String& sourcePathOrProjectID, double startTime, double length) const;
+
+        bool isStreaming() const noexcept           { return numPreloadedSamples < fileLengthSamples; }
+
         SamplerPlugin& owner;
         juce::String source;
         juce::String name;
         int keyNote = -1, minNote = 0, maxNote = 0;
-        int fileStartSample = 0, fileLengthSamples = 0;
+        int fileStartSample = 0, fileLengthSamples = 0, numPreloadedSamples = 0;
         bool openEnded = false;
         float gainDb = 0, pan = 0;
         double startTime = 0, length = 0;
+        double requestedStartTime = 0, requestedLength = 0;
+        bool diskStreamingWasEnabled = false;
+        juce::Time fileModificationTime;
         AudioFile audioFile;
         juce::AudioBuffer<float> audioData { 2, 64 };
 
     private:
+        bool canBeStreamed() const;
+        void copyLoadedAudio (const SamplerSound&);
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerSound)
     };
 
 private:
     //==============================================================================
     struct SampledNote;
+    struct StreamReader;
+    struct StreamReaderPool;
+
+    using SoundList = juce::OwnedArray<SamplerSound>;
+
+    static constexpr int maximumSimultaneousNotes = 32;
 
     juce::Colour colour;
-    juce::CriticalSection lock;
     juce::ReferenceCountedArray<SampledNote> playingNotes;
-    juce::OwnedArray<SamplerSound> soundList;
     juce::BigInteger highlightedNotes;
 
+    // These are set on the message thread and picked up by the audio thread
+    RealTimeStateSwap<SoundList> soundLists;
+    RealTimeStateSwap<juce::BigInteger> previewNotes;
+    std::atomic<bool> allNotesOffPending { false };
+
+    // The readers streaming notes use, shared between all the sounds
+    std::unique_ptr<StreamReaderPool> streamReaderPool;
+
     juce::ValueTree getSound (int index) const;
+    const SoundList& getLatestSounds() const;
+    void loadSounds();
+    void updatePreviewNotes (const juce::BigInteger& keysDown, const SoundList&, bool isRendering);
+    void clearPlayingNotes();
 
     void valueTreeChanged() override;
     void handleAsyncUpdate() override;
@@ -0,0 +1,273 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace sampler_test_utilities
+{
+    /** Creates a sampler with a sound for each of the files, loaded synchronously. */
+    inline Plugin::Ptr createSampler (Edit& edit, const juce::Array<juce::File>& files, bool streamFromDisk)
+    {
+        auto plugin = edit.getPluginCache().createNewPlugin (SamplerPlugin::xmlTypeName, {});
+
+        if (auto sampler = dynamic_cast<SamplerPlugin*> (plugin.get()))
+        {
+            sampler->setDiskStreamingEnabled (streamFromDisk);
+
+            for (auto& f : files)
+                sampler->addSound (f.getFullPathName(), f.getFileNameWithoutExtension(), 0.0, 0.0, 0.0f);
+
+            sampler->loadPendingSounds();
+        }
+
+        return plugin;
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class SamplerPluginTests    : public juce::UnitTest
+{
+public:
+    SamplerPluginTests()
+        : juce::UnitTest ("SamplerPlugin", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace sampler_test_utilities;
+        using namespace plugin_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        const double sampleRate = 44100.0;
+        auto sinFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (sampleRate, 4.0, 2);
+        const int numSourceSamples = (int) (sampleRate * 4.0);
+
+        auto loaded = createSampler (*edit, { sinFile->getFile() }, false);
+        auto streamed = createSampler (*edit, { sinFile->getFile() }, true);
+        auto& loadedSampler = dynamic_cast<SamplerPlugin&> (*loaded);
+        auto& streamedSampler = dynamic_cast<SamplerPlugin&> (*streamed);
+
+        beginTest ("Streamed sounds only keep the preload in memory");
+        {
+            expect (streamedSampler.isDiskStreamingEnabled());
+            expect (! loadedSampler.isDiskStreamingEnabled());
+            expectEquals (streamedSampler.getNumSounds(), 1);
+            expect (streamedSampler.getSoundFile (0).isValid());
+
+            const auto bytesPerSample = (juce::int64) (2 * sizeof (float));
+            expectGreaterOrEqual (loadedSampler.getMemoryUsageBytes(), numSourceSamples * bytesPerSample);
+            expectLessThan (streamedSampler.getMemoryUsageBytes(),
+                            (SamplerPlugin::diskStreamingPreloadSamples + 64) * bytesPerSample);
+        }
+
+        beginTest ("Streamed sounds play the same as loaded sounds");
+        {
+            // The note is the sound's key note so plays at the original pitch and
+            // crosses from the preloaded audio to the streamed part part-way through
+            const int numSamples = numSourceSamples - (int) sampleRate;
+            auto loadedOutput = renderNotes (*loaded, { 72 }, sampleRate, 512, numSamples, true);
+            auto streamedOutput = renderNotes (*streamed, { 72 }, sampleRate, 512, numSamples, true);
+
+            expectSameOutput (loadedOutput, streamedOutput);
+        }
+
+        beginTest ("Streamed sounds play the same as loaded sounds in real-time");
+        {
+            // A new sampler's readers haven't been targeted at its sound yet so this checks
+            // they are in time for the note to reach the streamed part, and that the cache
+            // keeps up without the longer timeout used when rendering
+            auto plugin = createSampler (*edit, { sinFile->getFile() }, true);
+            const int numSamples = SamplerPlugin::diskStreamingPreloadSamples * 2;
+            auto loadedOutput = renderNotes (*loaded, { 72 }, sampleRate, 512, numSamples, false);
+            auto streamedOutput = renderNotes (*plugin, { 72 }, sampleRate, 512, numSamples, false, true);
+
+            expectSameOutput (loadedOutput, streamedOutput);
+        }
+
+        beginTest ("Several sounds stream from the shared readers");
+        {
+            // Each note of each sound takes a reader from the ones the plugin shares between its sounds
+            auto plugin = createSampler (*edit, { sinFile->getFile(), sinFile->getFile() }, true);
+            const int numSamples = SamplerPlugin::diskStreamingPreloadSamples * 2;
+            juce::Array<int> notes;
+
+            for (int i = 0; i < 8; ++i)
+                notes.add (72 + i);
+
+            auto output = renderNotes (*plugin, notes, sampleRate, 512, numSamples, true);
+            expectGreaterThan (output.getMagnitude (numSamples - 4096, 4096), 0.1f);
+        }
+
+        beginTest ("Short sounds are always fully loaded");
+        {
+            auto shortFile = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (sampleRate, 0.25, 2);
+            auto plugin = createSampler (*edit, { shortFile->getFile() }, true);
+            auto& sampler = dynamic_cast<SamplerPlugin&> (*plugin);
+
+            expectGreaterOrEqual (sampler.getMemoryUsageBytes(), (juce::int64) (sampleRate * 0.25) * 2 * (juce::int64) sizeof (float));
+        }
+
+        beginTest ("Modified media is reloaded");
+        {
+            juce::TemporaryFile file (".wav");
+            writeConstantFile (file.getFile(), sampleRate, 0.5f);
+
+            auto plugin = createSampler (*edit, { file.getFile() }, false);
+            const int numSamples = 4096;
+            auto before = renderNotes (*plugin, { 72 }, sampleRate, 512, numSamples, true);
+
+            // Make sure the modification time changes even on file systems with a coarse resolution
+            writeConstantFile (file.getFile(), sampleRate, 0.25f);
+            file.getFile().setLastModificationTime (juce::Time::getCurrentTime() + juce::RelativeTime::seconds (10.0));
+
+            auto& sampler = dynamic_cast<SamplerPlugin&> (*plugin);
+            sampler.sourceMediaChanged();
+            sampler.loadPendingSounds();
+
+            auto after = renderNotes (*plugin, { 72 }, sampleRate, 512, numSamples, true);
+
+            // Skip the fade-in at the start of the sound
+            expectWithinAbsoluteError (after.getSample (0, numSamples / 2), before.getSample (0, numSamples / 2) * 0.5f, 0.0001f);
+            expectGreaterThan (after.getSample (0, numSamples / 2), 0.0f);
+        }
+    }
+
+    void expectSameOutput (const juce::AudioBuffer<float>& loadedOutput, const juce::AudioBuffer<float>& streamedOutput)
+    {
+        const int numSamples = loadedOutput.getNumSamples();
+        expectEquals (streamedOutput.getNumSamples(), numSamples);
+
+        expectGreaterThan (loadedOutput.getMagnitude (0, numSamples), 0.1f);
+        expectGreaterThan (streamedOutput.getMagnitude (SamplerPlugin::diskStreamingPreloadSamples,
+                                                        numSamples - SamplerPlugin::diskStreamingPreloadSamples), 0.1f);
+
+        expectLessThan (audio_test_utilities::getMaxDifference (loadedOutput, streamedOutput), 0.0001f);
+    }
+
+    static void writeConstantFile (const juce::File& f, double sampleRate, float value)
+    {
+        juce::AudioBuffer<float> buffer (2, (int) sampleRate);
+
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+            juce::FloatVectorOperations::fill (buffer.getWritePointer (c), value, buffer.getNumSamples());
+
+        f.deleteFile();
+        juce::WavAudioFormat format;
+
+        if (auto out = std::unique_ptr<juce::FileOutputStream> (f.createOutputStream()))
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (format.createWriterFor (out.get(), sampleRate, 2, 32, {}, 0)))
+            {
+                out.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+    }
+};
+
+static SamplerPluginTests samplerPluginTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+//==============================================================================
+class SamplerPluginBenchmarks   : public juce::UnitTest
+{
+public:
+    SamplerPluginBenchmarks()
+        : juce::UnitTest ("SamplerPlugin Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        juce::OwnedArray<juce::TemporaryFile> sourceFiles;
+        juce::Array<juce::File> files;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            auto f = tracktion_graph::test_utilities::getSinFile<juce::WavAudioFormat> (44100.0, 30.0, 2, 110.0f * (i + 1));
+            files.add (f->getFile());
+            sourceFiles.add (f.release());
+        }
+
+        for (bool streamFromDisk : { false, true })
+            runLoadingBenchmark (*edit, files, streamFromDisk);
+
+        // Every note triggers each sound in its range so these use a single sound
+        for (bool streamFromDisk : { false, true })
+        {
+            auto sampler = sampler_test_utilities::createSampler (*edit, { files.getFirst() }, streamFromDisk);
+
+            for (int numVoices : { 1, 8, 32 })
+                runVoiceBenchmark (*sampler, numVoices, streamFromDisk);
+        }
+    }
+
+private:
+    static juce::String getModeName (bool streamFromDisk)
+    {
+        return streamFromDisk ? "streaming" : "fully loaded";
+    }
+
+    void runLoadingBenchmark (Edit& edit, const juce::Array<juce::File>& files, bool streamFromDisk)
+    {
+        beginTest ("Loading " + juce::String (files.size()) + " sounds, " + getModeName (streamFromDisk));
+        {
+            const StopwatchTimer timer;
+            auto plugin = sampler_test_utilities::createSampler (edit, files, streamFromDisk);
+            auto& sampler = dynamic_cast<SamplerPlugin&> (*plugin);
+            expectEquals (sampler.getNumSounds(), files.size());
+
+            benchmark_utilities::printTime ("Loading", timer);
+            benchmark_utilities::printValue ("Resident sample memory", juce::File::descriptionOfSizeInBytes (sampler.getMemoryUsageBytes()));
+        }
+    }
+
+    void runVoiceBenchmark (Plugin& plugin, int numVoices, bool streamFromDisk)
+    {
+        beginTest ("Playing " + juce::String (numVoices) + " voices, " + getModeName (streamFromDisk));
+        {
+            const double sampleRate = 44100.0, durationSeconds = 20.0;
+            juce::Array<int> notes;
+
+            for (int i = 0; i < numVoices; ++i)
+                notes.add (48 + i);
+
+            // This renders as fast as possible so lets the streamed notes wait for the cache
+            const StopwatchTimer timer;
+            auto output = plugin_test_utilities::renderNotes (plugin, notes, sampleRate, 512,
+                                                               (int) (sampleRate * durationSeconds), true);
+            benchmark_utilities::printRealTimeFactor (timer, durationSeconds);
+            expectGreaterThan (output.getMagnitude (0, output.getNumSamples()), 0.0f);
+        }
+    }
+};
+
+static SamplerPluginBenchmarks samplerPluginBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
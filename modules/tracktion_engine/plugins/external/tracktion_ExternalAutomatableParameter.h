@@ -77,6 +77,8 @@ public:
         {
             if (p->getValue() != newValue)
             {
+                valueSetByAutomation = byAutomation ? newValue : -1.0f;
+
                 if (! byAutomation)
                     markAsChanged();
 
@@ -129,6 +131,23 @@ public:
         return {};
     }
 
+    /** Returns true if this is the value that was last set by following the automation
+        curve, i.e. the plugin is just reporting it back rather than having changed it.
+        This can be called from any thread.
+    */
+    bool isValueSetByAutomation (float value) const noexcept
+    {
+        return std::abs (value - valueSetByAutomation.load()) < 1.0e-6f;
+    }
+
+    /** Returns true if the plugin has reported a value other than the one automation last set
+        since this was last called, and clears the flag.
+    */
+    bool getAndClearChangedByPlugin() noexcept
+    {
+        return changedByPlugin.exchange (false);
+    }
+
     void valueChangedByPlugin()
     {
         if (auto p = getParam())
@@ -279,6 +298,10 @@ private:
     const VSTXML::Param* param = nullptr;
     const VSTXML::ValueType* valueType = nullptr;
 
+    // Normalised values are never negative so this won't match anything until automation's set it
+    std::atomic<float> valueSetByAutomation { -1.0f };
+    std::atomic<bool> changedByPlugin { false };
+
     AudioPluginInstance* getPlugin() const noexcept
     {
         jassert (plugin != nullptr);
@@ -298,10 +321,17 @@ private:
         getEdit().pluginChanged (*plugin);
     }
 
-    void parameterValueChanged (int index, float /*newValue*/) override
+    void parameterValueChanged (int index, float newValue) override
     {
         if (parameterIndex == index)
+        {
+            // This is checked here, on the thread that changed the value, as by the time
+            // the message thread sees it automation may have moved on to a different value
+            if (! isValueSetByAutomation (newValue))
+                changedByPlugin = true;
+
             triggerAsyncUpdate();
+        }
         else
             jassertfalse;
     }
@@ -28,6 +28,8 @@ struct ExternalPlugin::ProcessorChangedManager  : public juce::AudioProcessorLis
     ProcessorChangedManager (ExternalPlugin& p)
         : plugin (p)
     {
+        changedParameterIndexes.reset (256);
+
         if (auto pi = plugin.getAudioPluginInstance())
             pi->addListener (this);
         else
@@ -44,12 +46,16 @@ struct ExternalPlugin::ProcessorChangedManager  : public juce::AudioProcessorLis
             jassertfalse;
     }
 
-    void audioProcessorParameterChanged (AudioProcessor*, int, float) override
+    void audioProcessorParameterChanged (AudioProcessor*, int parameterIndex, float) override
     {
         if (plugin.edit.isLoading())
             return;
 
-        paramChanged = true;
+        // This can be called from the audio thread so the parameter list, which can be rebuilt
+        // at any time on the message thread, is only looked at in handleAsyncUpdate
+        if (! changedParameterIndexes.push (parameterIndex))
+            changedParameterIndexesOverflowed = true;
+
         triggerAsyncUpdate();
     }
 
@@ -126,21 +132,35 @@ private:
         plugin.edit.pluginChanged (plugin);
     }
     
-    void handleAsyncUpdate() override
+    bool haveParametersChanged()
     {
-        if (paramChanged)
+        TRACKTION_ASSERT_MESSAGE_THREAD
+        bool changed = changedParameterIndexesOverflowed.exchange (false);
+
+        for (int index = 0; changedParameterIndexes.pop (index);)
         {
-            paramChanged = false;
-            plugin.edit.pluginChanged (plugin);
+            // Plugins report back the values automation sets them to but that isn't a change to
+            // the plugin's state so shouldn't invalidate any renders of it
+            auto param = plugin.autoParamForParamNumbers[index];
+
+            if (param == nullptr || param->getAndClearChangedByPlugin())
+                changed = true;
         }
-        if (processorChanged)
-        {
-            processorChanged = false;
+
+        return changed;
+    }
+
+    void handleAsyncUpdate() override
+    {
+        if (haveParametersChanged())
+            plugin.edit.pluginChanged (plugin);
+
+        if (processorChanged.exchange (false))
             updateFromPlugin();
-        }
     }
 
-    bool paramChanged = false, processorChanged = false;
+    choc::fifo::MultipleReaderMultipleWriterFIFO<int> changedParameterIndexes;
+    std::atomic<bool> changedParameterIndexesOverflowed { false }, processorChanged { false };
 };
 
 //==============================================================================
@@ -530,16 +550,13 @@ ExternalPlugin::ExternalPlugin (PluginCreationInfo info)  : Plugin (info)
 
     dryValue.referTo (state, IDs::dry, um);
     wetValue.referTo (state, IDs::wet, um, 1.0f);
+    runInSeparateProcess.referTo (state, IDs::separateProcess, um);
 
     dryGain->attachToCurrentValue (dryValue);
     wetGain->attachToCurrentValue (wetValue);
 
-    desc.uniqueId = (int) state[IDs::uniqueId].toString().getHexValue64();
-    desc.deprecatedUid = (int) state[IDs::uid].toString().getHexValue64();
-    desc.fileOrIdentifier = state[IDs::filename];
+    desc = createDescriptionFromState (state);
     setEnabled (state.getProperty (IDs::enabled, true));
-    desc.name = state[IDs::name];
-    desc.manufacturerName = state[IDs::manufacturer];
     identiferString = createIdentifierString (desc);
 
     initialiseFully();
@@ -561,6 +578,18 @@ ValueTree ExternalPlugin::create (Engine& e, const PluginDescription& desc)
     return v;
 }
 
+PluginDescription ExternalPlugin::createDescriptionFromState (const juce::ValueTree& v)
+{
+    PluginDescription d;
+    d.uniqueId = (int) v[IDs::uniqueId].toString().getHexValue64();
+    d.deprecatedUid = (int) v[IDs::uid].toString().getHexValue64();
+    d.fileOrIdentifier = v[IDs::filename];
+    d.name = v[IDs::name];
+    d.manufacturerName = v[IDs::manufacturer];
+
+    return d;
+}
+
 const char* ExternalPlugin::xmlTypeName = "vst";
 
 void ExternalPlugin::initialiseFully()
@@ -570,8 +599,8 @@ void ExternalPlugin::initialiseFully()
         CRASH_TRACER_PLUGIN (getDebugName());
         fullyInitialised = true;
 
-        doFullInitialisation();
-        restorePluginStateFromValueTree (state);
+        if (! doFullInitialisation())
+            restorePluginStateFromValueTree (state);
         buildParameterList();
         restoreChannelLayout (*this);
     }
@@ -677,7 +706,7 @@ void ExternalPlugin::refreshParameterValues()
             p->valueChangedByPlugin();
 }
 
-std::unique_ptr<PluginDescription> ExternalPlugin::findDescForUID (int uid, int deprecatedUid) const
+static std::unique_ptr<PluginDescription> findDescForUID (Engine& engine, int uid, int deprecatedUid)
 {
     if (uid != 0)
         for (auto d : engine.getPluginManager().knownPluginList.getTypes())
@@ -692,7 +721,7 @@ std::unique_ptr<PluginDescription> ExternalPlugin::findDescForUID (int uid, int
     return {};
 }
 
-std::unique_ptr<PluginDescription> ExternalPlugin::findDescForFileOrID (const String& fileOrID) const
+static std::unique_ptr<PluginDescription> findDescForFileOrID (Engine& engine, const String& fileOrID)
 {
     if (fileOrID.isNotEmpty())
     {
@@ -739,6 +768,11 @@ static std::unique_ptr<PluginDescription> findDescForName (Engine& engine, const
 }
 
 std::unique_ptr<PluginDescription> ExternalPlugin::findMatchingPlugin() const
+{
+    return findMatchingPlugin (engine, desc);
+}
+
+std::unique_ptr<PluginDescription> ExternalPlugin::findMatchingPlugin (Engine& engine, const PluginDescription& desc)
 {
     CRASH_TRACER
     auto& pm = engine.getPluginManager();
@@ -755,10 +789,10 @@ std::unique_ptr<PluginDescription> ExternalPlugin::findMatchingPlugin() const
             return p;
     }
 
-    if (auto p = findDescForFileOrID (desc.fileOrIdentifier))
+    if (auto p = findDescForFileOrID (engine, desc.fileOrIdentifier))
         return p;
 
-    if (auto p = findDescForUID (desc.uniqueId, desc.deprecatedUid))
+    if (auto p = findDescForUID (engine, desc.uniqueId, desc.deprecatedUid))
         return p;
 
     auto getPreferredFormat = [] (juce::PluginDescription d)
@@ -782,7 +816,7 @@ std::unique_ptr<PluginDescription> ExternalPlugin::findMatchingPlugin() const
             return std::make_unique<PluginDescription> (d);
 
     if (desc.uniqueId == 0x4d44416a || desc.deprecatedUid == 0x4d44416a) // old JX-10: hack to update to JX-16
-        if (auto p = findDescForUID (0x4D44414A, 0x4D44414A))
+        if (auto p = findDescForUID (engine, 0x4D44414A, 0x4D44414A))
             return p;
 
     return {};
@@ -808,8 +842,10 @@ void ExternalPlugin::processingChanged()
     }
 }
 
-void ExternalPlugin::doFullInitialisation()
+bool ExternalPlugin::doFullInitialisation()
 {
+    bool stateRestored = false;
+
     if (auto foundDesc = findMatchingPlugin())
     {
         desc = *foundDesc;
@@ -819,16 +855,31 @@ void ExternalPlugin::doFullInitialisation()
         if (processing && pluginInstance == nullptr && edit.shouldLoadPlugins())
         {
             if (isDisabled())
-                return;
+                return false;
 
             CRASH_TRACER_PLUGIN (getDebugName());
             String error;
 
-            callBlocking ([this, &error, &foundDesc]
+            if (auto preloader = edit.getExternalPluginPreloader())
+            {
+                auto preloaded = preloader->takeInstance (itemID, *foundDesc);
+
+                if (preloaded.instance != nullptr)
+                {
+                    pluginInstance = std::move (preloaded.instance);
+                    processorChangedManager = std::make_unique<ProcessorChangedManager> (*this);
+                    stateRestored = preloaded.stateRestored;
+                }
+            }
+
+            if (pluginInstance == nullptr)
             {
-                CRASH_TRACER_PLUGIN (getDebugName());
-                error = createPluginInstance (*foundDesc);
-            });
+                callBlocking ([this, &error, &foundDesc]
+                {
+                    CRASH_TRACER_PLUGIN (getDebugName());
+                    error = createPluginInstance (*foundDesc);
+                });
+            }
 
             if (pluginInstance != nullptr)
             {
@@ -850,6 +901,8 @@ void ExternalPlugin::doFullInitialisation()
             }
         }
     }
+
+    return stateRestored;
 }
 
 //==============================================================================
@@ -935,7 +988,7 @@ void ExternalPlugin::flushBusesLayoutToValueTree()
     }
 }
 
-void ExternalPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
+juce::MemoryBlock ExternalPlugin::getPluginStateChunk (const juce::ValueTree& v)
 {
     String s;
 
@@ -956,18 +1009,26 @@ void ExternalPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
         }
     }
 
-    if (pluginInstance != nullptr && s.isNotEmpty())
+    MemoryBlock chunk;
+
+    if (s.isNotEmpty())
+        chunk.fromBase64Encoding (s);
+
+    return chunk;
+}
+
+void ExternalPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
+{
+    auto chunk = getPluginStateChunk (v);
+
+    if (pluginInstance != nullptr && chunk.getSize() > 0)
     {
         CRASH_TRACER_PLUGIN (getDebugName());
 
         if (getNumPrograms() > 1)
             setCurrentProgram (v.getProperty (IDs::programNum), false);
 
-        MemoryBlock chunk;
-        chunk.fromBase64Encoding (s);
-
-        if (chunk.getSize() > 0)
-            callBlocking ([this, &chunk]() { pluginInstance->setStateInformation (chunk.getData(), (int) chunk.getSize()); });
+        callBlocking ([this, &chunk]() { pluginInstance->setStateInformation (chunk.getData(), (int) chunk.getSize()); });
     }
 }
 
@@ -1676,7 +1737,11 @@ String ExternalPlugin::createPluginInstance (const PluginDescription& descriptio
     auto& dm = engine.getDeviceManager();
 
     String error;
-    pluginInstance = engine.getPluginManager().createPluginInstance (description, dm.getSampleRate(), dm.getBlockSize(), error);
+
+    if (runInSeparateProcess)
+        pluginInstance = SandboxedPluginInstance::create (description, dm.getSampleRate(), dm.getBlockSize(), error);
+    else
+        pluginInstance = engine.getPluginManager().createPluginInstance (description, dm.getSampleRate(), dm.getBlockSize(), error);
 
     if (pluginInstance != nullptr)
     {
@@ -1770,9 +1835,52 @@ AudioPluginInstance* ExternalPlugin::getAudioPluginInstance() const
     return pluginInstance.get();
 }
 
+void ExternalPlugin::setRunInSeparateProcess (bool shouldRunInSeparateProcess)
+{
+    runInSeparateProcess = shouldRunInSeparateProcess;
+}
+
 void ExternalPlugin::valueTreePropertyChanged (ValueTree& v, const juce::Identifier& id)
 {
-    if (v == state && id == IDs::layout)
+    if (v == state && id == IDs::separateProcess)
+    {
+        runInSeparateProcess.forceUpdateOfCachedValue();
+
+        // If the plugin failed to load, e.g. because it can't be run in a separate process on
+        // this platform, give it another go with the new setting
+        if (pluginInstance == nullptr)
+        {
+            if (fullyInitialised)
+                forceFullReinitialise();
+
+            return;
+        }
+
+        const bool isSandboxed = dynamic_cast<SandboxedPluginInstance*> (pluginInstance.get()) != nullptr;
+
+        if (isSandboxed == runInSeparateProcess.get())
+            return;
+
+        // Keep the current state so the new instance picks up where this one left off
+        flushPluginStateToValueTree();
+
+        for (auto param : autoParamForParamNumbers)
+            if (param != nullptr)
+                param->unregisterAsListener();
+
+        clearParameterList();
+        autoParamForParamNumbers.clear();
+        getParameterTree().clear();
+
+        {
+            const ScopedLock sl (lock);
+            deletePluginInstance();
+            isInstancePrepared = false;
+        }
+
+        forceFullReinitialise();
+    }
+    else if (v == state && id == IDs::layout)
     {
         if (isFlushingLayoutToState)
             return;
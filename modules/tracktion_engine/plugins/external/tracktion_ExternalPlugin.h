@@ -30,6 +30,17 @@ public:
 
     static juce::ValueTree create (Engine&, const juce::PluginDescription&);
 
+    /** Returns the partial PluginDescription stored in an ExternalPlugin's state. */
+    static juce::PluginDescription createDescriptionFromState (const juce::ValueTree&);
+
+    /** Finds the known plugin that best matches a description stored in an Edit. */
+    static std::unique_ptr<juce::PluginDescription> findMatchingPlugin (Engine&, const juce::PluginDescription&);
+
+    /** Returns the plugin's state chunk stored in an ExternalPlugin's state, or an empty
+        block if there isn't one. This handles the older VSTDATA format as well.
+    */
+    static juce::MemoryBlock getPluginStateChunk (const juce::ValueTree&);
+
     void processingChanged() override;
 
     //==============================================================================
@@ -110,6 +121,21 @@ public:
     bool hasNameForMidiProgram (int programNum, int bank, juce::String& name) override;
     bool hasNameForMidiNoteNumber (int note, int midiChannel, juce::String& name) override;
 
+    //==============================================================================
+    /** Returns true if the plugin is set to run in a separate process.
+        @see SandboxedPluginInstance
+    */
+    bool isRunningInSeparateProcess() const         { return runInSeparateProcess.get(); }
+
+    /** Moves the plugin in to or out of a separate process, recreating the instance.
+        A plugin in a separate process can't crash or stall the engine but its output is
+        delayed by an extra block so the other process has time to process it.
+        On platforms where SharedAudioBlock::isSupported() is false, the plugin will fail
+        to load with an error message while this is set.
+        @see SandboxedPluginInstance::getStatistics
+    */
+    void setRunInSeparateProcess (bool);
+
     //==============================================================================
     const VSTXML* getVSTXML() const noexcept        { return vstXML.get(); }
 
@@ -118,6 +144,7 @@ public:
     juce::PluginDescription desc;
 
     juce::CachedValue<float> dryValue, wetValue;
+    juce::CachedValue<bool> runInSeparateProcess;
     AutomatableParameter::Ptr dryGain, wetGain;
 
     ActiveNoteList getActiveNotes() const           { return activeNotes; }
@@ -164,15 +191,14 @@ private:
     void buildParameterTree (const VSTXML::Group*, AutomatableParameterTree::TreeNode*, juce::SortedSet<int>&) const;
 
     //==============================================================================
-    void doFullInitialisation();
+    /** Returns true if the plugin's state was restored whilst creating the instance. */
+    bool doFullInitialisation();
     void buildParameterList();
     void refreshParameterValues();
     void updateDebugName();
     void processPluginBlock (const PluginRenderContext&, bool processedBypass);
 
     std::unique_ptr<juce::PluginDescription> findMatchingPlugin() const;
-    std::unique_ptr<juce::PluginDescription> findDescForUID (int uid, int deprecatedUid) const;
-    std::unique_ptr<juce::PluginDescription> findDescForFileOrID (const juce::String&) const;
 
     void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
 
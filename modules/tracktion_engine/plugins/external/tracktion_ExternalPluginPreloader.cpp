@@ -0,0 +1,239 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+struct ExternalPluginPreloader::PluginToLoad
+{
+    EditItemID itemID;
+    juce::PluginDescription desc;
+    juce::MemoryBlock stateChunk;
+    int programNum = 0;
+    bool createOnBackgroundThread = false;
+
+    std::unique_ptr<juce::AudioPluginInstance> instance;
+    bool stateRestored = false;
+};
+
+//==============================================================================
+class ExternalPluginPreloader::LoadJob  : public juce::ThreadPoolJob
+{
+public:
+    LoadJob (ExternalPluginPreloader& o, PluginToLoad& p, Edit::LoadContext* lc)
+        : juce::ThreadPoolJob ("Plugin Preload: " + p.desc.name),
+          owner (o), plugin (p), loadContext (lc)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (loadContext == nullptr || ! loadContext->shouldExit)
+            owner.loadPlugin (plugin, loadContext);
+
+        return jobHasFinished;
+    }
+
+private:
+    ExternalPluginPreloader& owner;
+    PluginToLoad& plugin;
+    Edit::LoadContext* loadContext;
+};
+
+//==============================================================================
+static bool formatRequiresUnblockedMessageThread (PluginManager& pm, const juce::PluginDescription& desc)
+{
+    for (auto format : pm.pluginFormatManager.getFormats())
+        if (format->getName() == desc.pluginFormatName)
+            return format->requiresUnblockedMessageThreadDuringCreation (desc);
+
+    return false;
+}
+
+static void findExternalPluginStates (const juce::ValueTree& v, juce::Array<juce::ValueTree>& found)
+{
+    for (auto child : v)
+    {
+        if (child.hasType (IDs::PLUGIN) && child[IDs::type].toString() == ExternalPlugin::xmlTypeName)
+            found.add (child);
+        else
+            findExternalPluginStates (child, found);
+    }
+}
+
+//==============================================================================
+ExternalPluginPreloader::ExternalPluginPreloader (Edit& e)
+    : edit (e)
+{
+}
+
+ExternalPluginPreloader::~ExternalPluginPreloader()
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto p : plugins)
+        AsyncPluginDeleter::getInstance()->deletePlugin (p->instance.release());
+}
+
+void ExternalPluginPreloader::preloadPlugins (const juce::ValueTree& editState, Edit::LoadContext* loadContext)
+{
+    CRASH_TRACER
+    auto& engine = edit.engine;
+    auto& pm = engine.getPluginManager();
+    const bool isMessageThread = juce::MessageManager::getInstance()->isThisTheMessageThread();
+
+    juce::Array<juce::ValueTree> pluginStates;
+    findExternalPluginStates (editState, pluginStates);
+
+    std::unordered_set<EditItemID> seenIDs, duplicateIDs;
+
+    for (auto& v : pluginStates)
+    {
+        auto itemID = EditItemID::fromID (v);
+
+        if (itemID.isValid() && ! seenIDs.insert (itemID).second)
+            duplicateIDs.insert (itemID);
+    }
+
+    for (auto& v : pluginStates)
+    {
+        auto itemID = EditItemID::fromID (v);
+
+        // Plugins without a unique ID will be given one when they're created so can't be matched
+        if (! itemID.isValid() || duplicateIDs.count (itemID) > 0)
+            continue;
+
+        // Sandboxed plugins are created in their own process so don't need preloading
+        if (! v.getProperty (IDs::process, true) || v.getProperty (IDs::separateProcess))
+            continue;
+
+        auto foundDesc = ExternalPlugin::findMatchingPlugin (engine, ExternalPlugin::createDescriptionFromState (v));
+
+        if (foundDesc == nullptr || engine.getEngineBehaviour().isPluginDisabled (createIdentifierString (*foundDesc)))
+            continue;
+
+        const bool needsUnblockedMessageThread = formatRequiresUnblockedMessageThread (pm, *foundDesc);
+
+        // We can't block the message thread waiting for plugins that need it to be running so
+        // leave those to be created the normal way
+        if (needsUnblockedMessageThread && isMessageThread)
+            continue;
+
+        auto p = std::make_unique<PluginToLoad>();
+        p->itemID = itemID;
+        p->desc = *foundDesc;
+        p->stateChunk = ExternalPlugin::getPluginStateChunk (v);
+        p->programNum = v.getProperty (IDs::programNum);
+        p->createOnBackgroundThread = needsUnblockedMessageThread
+                                        || engine.getEngineBehaviour().canCreatePluginOnBackgroundThread (*foundDesc);
+        plugins.add (p.release());
+    }
+
+    if (plugins.isEmpty())
+        return;
+
+    // Kick off the background plugins first so they load whilst the message thread ones are created
+    juce::OwnedArray<LoadJob> jobs;
+    juce::ThreadPool pool (engine.getEngineBehaviour().getNumThreadsForLoadingPlugins());
+
+    for (auto p : plugins)
+    {
+        if (p->createOnBackgroundThread)
+        {
+            auto job = jobs.add (new LoadJob (*this, *p, loadContext));
+            pool.addJob (job, false);
+        }
+    }
+
+    for (auto p : plugins)
+    {
+        if (loadContext != nullptr && loadContext->shouldExit)
+            break;
+
+        if (! p->createOnBackgroundThread)
+            callBlocking ([this, p, loadContext] { loadPlugin (*p, loadContext); });
+    }
+
+    for (auto job : jobs)
+    {
+        while (! pool.waitForJobToFinish (job, 50))
+        {
+            if (loadContext != nullptr && loadContext->shouldExit)
+            {
+                pool.removeAllJobs (true, 10000);
+                return;
+            }
+        }
+    }
+}
+
+ExternalPluginPreloader::PreloadedInstance ExternalPluginPreloader::takeInstance (EditItemID itemID, const juce::PluginDescription& desc)
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto p : plugins)
+    {
+        if (p->itemID == itemID)
+        {
+            if (p->instance == nullptr || ! p->desc.isDuplicateOf (desc))
+                return {};
+
+            return { std::move (p->instance), p->stateRestored };
+        }
+    }
+
+    return {};
+}
+
+void ExternalPluginPreloader::loadPlugin (PluginToLoad& p, Edit::LoadContext* loadContext)
+{
+    CRASH_TRACER_PLUGIN (p.desc.name.toUTF8());
+    const StopwatchTimer loadTimer;
+
+    auto& dm = edit.engine.getDeviceManager();
+    juce::String error;
+    auto instance = edit.engine.getPluginManager().createPluginInstance (p.desc, dm.getSampleRate(), dm.getBlockSize(), error);
+
+    if (instance == nullptr)
+    {
+        TRACKTION_LOG_ERROR (error);
+        return;
+    }
+
+    instance->enableAllBuses();
+    bool stateRestored = false;
+
+    // Plugins that can't be used off the message thread are loaded via callBlocking so
+    // the state can always be restored on the thread the instance was created on
+    if (p.stateChunk.getSize() > 0)
+    {
+        const int numPrograms = instance->getNumPrograms();
+
+        if (numPrograms > 1)
+        {
+            const int programNum = juce::jlimit (0, numPrograms - 1, p.programNum);
+
+            if (programNum != instance->getCurrentProgram())
+                instance->setCurrentProgram (programNum);
+        }
+
+        instance->setStateInformation (p.stateChunk.getData(), (int) p.stateChunk.getSize());
+        stateRestored = true;
+    }
+
+    if (loadContext != nullptr)
+        loadContext->addPluginLoadTime ({ p.itemID, p.desc.name, loadTimer.getSeconds(), ! p.createOnBackgroundThread });
+
+    const juce::ScopedLock sl (lock);
+    p.instance = std::move (instance);
+    p.stateRestored = stateRestored;
+}
+
+} // namespace tracktion_engine
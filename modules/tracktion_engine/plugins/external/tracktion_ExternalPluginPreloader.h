@@ -0,0 +1,72 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Creates the AudioPluginInstances for all the ExternalPlugins in an Edit before
+    its PluginLists are built.
+
+    Loading an Edit would otherwise instantiate each plugin one after another as the
+    tracks are created. This instead collects all the plugin states up-front and
+    creates the instances on a bounded pool of worker threads. Plugins whose formats
+    must be created on the message thread are still created there, one at a time,
+    but while the background-capable ones are loading.
+
+    When an ExternalPlugin is then constructed it takes its preloaded instance
+    instead of creating a new one.
+
+    @see EngineBehaviour::canCreatePluginOnBackgroundThread, Edit::LoadContext
+*/
+class ExternalPluginPreloader
+{
+public:
+    /** Creates a preloader for an Edit. */
+    ExternalPluginPreloader (Edit&);
+
+    /** Destructor. Any instances that haven't been taken will be deleted. */
+    ~ExternalPluginPreloader();
+
+    /** Creates instances for all the enabled ExternalPlugins in the given state,
+        blocking until they have all loaded or the LoadContext signals to exit.
+        If a LoadContext is provided, the load time of each plugin will be added to it.
+    */
+    void preloadPlugins (const juce::ValueTree& editState, Edit::LoadContext*);
+
+    /** The result of taking a preloaded instance. */
+    struct PreloadedInstance
+    {
+        std::unique_ptr<juce::AudioPluginInstance> instance;    /**< The instance, may be nullptr. */
+        bool stateRestored = false;                             /**< True if the state has already been applied. */
+    };
+
+    /** Returns the preloaded instance for a plugin, transferring ownership to the caller.
+        This will return an empty instance if the plugin wasn't preloaded or the
+        description doesn't match the one it was created with.
+    */
+    PreloadedInstance takeInstance (EditItemID, const juce::PluginDescription&);
+
+private:
+    //==============================================================================
+    struct PluginToLoad;
+    class LoadJob;
+
+    Edit& edit;
+    juce::OwnedArray<PluginToLoad> plugins;
+    juce::CriticalSection lock;
+
+    void loadPlugin (PluginToLoad&, Edit::LoadContext*);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ExternalPluginPreloader)
+};
+
+} // namespace tracktion_engine
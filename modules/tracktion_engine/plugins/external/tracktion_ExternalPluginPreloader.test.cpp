@@ -0,0 +1,266 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class ExternalPluginPreloaderTests  : public juce::UnitTest
+{
+public:
+    ExternalPluginPreloaderTests()
+        : juce::UnitTest ("ExternalPluginPreloader", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        beginTest ("Background plugins are started before message thread ones");
+        {
+            TestPlugins plugins (*edit, { backgroundFormat, messageThreadFormat, backgroundFormat,
+                                          messageThreadFormat, backgroundFormat, messageThreadFormat });
+            Edit::LoadContext loadContext;
+            ExternalPluginPreloader preloader (*edit);
+            preloader.preloadPlugins (plugins.editState, &loadContext);
+
+            auto created = plugins.getCreated();
+            expectEquals ((int) created.size(), plugins.getNumPlugins());
+            expect (plugins.backgroundStartedBeforeMessageThread);
+
+            // Message thread plugins are created serially, in the order they appear in the Edit
+            juce::StringArray messageThreadOrder;
+
+            for (auto& c : created)
+            {
+                expect (c.onMessageThread == (c.format == messageThreadFormat));
+
+                if (c.onMessageThread)
+                    messageThreadOrder.add (c.name);
+            }
+
+            expectEquals (messageThreadOrder.joinIntoString (","), juce::String ("Plugin 1,Plugin 3,Plugin 5"));
+
+            // Every plugin has its state restored and its load time recorded, wherever it was created
+            for (int i = 0; i < plugins.getNumPlugins(); ++i)
+            {
+                auto preloaded = preloader.takeInstance (plugins.getID (i), plugins.getDescription (i));
+                expect (preloaded.instance != nullptr);
+                expect (preloaded.stateRestored);
+
+                if (auto instance = dynamic_cast<TestInstance*> (preloaded.instance.get()))
+                    expectEquals (instance->restoredState, plugins.getState (i));
+            }
+
+            auto loadTimes = loadContext.getPluginLoadTimes();
+            expectEquals ((int) loadTimes.size(), plugins.getNumPlugins());
+
+            for (auto& loadTime : loadTimes)
+                expect (loadTime.createdOnMessageThread == plugins.isMessageThreadPlugin (loadTime.pluginID));
+        }
+
+        beginTest ("Nothing is loaded if the load has already been cancelled");
+        {
+            TestPlugins plugins (*edit, { backgroundFormat, messageThreadFormat, backgroundFormat, messageThreadFormat });
+            Edit::LoadContext loadContext;
+            loadContext.shouldExit = true;
+
+            ExternalPluginPreloader preloader (*edit);
+            preloader.preloadPlugins (plugins.editState, &loadContext);
+
+            expect (plugins.getCreated().empty());
+            expect (loadContext.getPluginLoadTimes().empty());
+
+            for (int i = 0; i < plugins.getNumPlugins(); ++i)
+                expect (preloader.takeInstance (plugins.getID (i), plugins.getDescription (i)).instance == nullptr);
+        }
+
+        beginTest ("Cancelling stops the remaining message thread plugins being created");
+        {
+            TestPlugins plugins (*edit, { messageThreadFormat, messageThreadFormat, messageThreadFormat, messageThreadFormat });
+            Edit::LoadContext loadContext;
+            plugins.onCreate = [&] (int numCreated)
+            {
+                if (numCreated == 2)
+                    loadContext.shouldExit = true;
+            };
+
+            ExternalPluginPreloader preloader (*edit);
+            preloader.preloadPlugins (plugins.editState, &loadContext);
+
+            expectEquals ((int) plugins.getCreated().size(), 2);
+
+            for (int i = 0; i < plugins.getNumPlugins(); ++i)
+                expect ((preloader.takeInstance (plugins.getID (i), plugins.getDescription (i)).instance != nullptr) == (i < 2));
+        }
+    }
+
+private:
+    // The format name decides where the preloader creates the plugin,
+    // see EngineBehaviour::canCreatePluginOnBackgroundThread
+    static constexpr const char* backgroundFormat = "LV2";
+    static constexpr const char* messageThreadFormat = "PreloaderTestFormat";
+
+    //==============================================================================
+    struct TestInstance  : public juce::AudioPluginInstance
+    {
+        TestInstance (const juce::PluginDescription& d) : desc (d) {}
+
+        void fillInPluginDescription (juce::PluginDescription& d) const override    { d = desc; }
+        const juce::String getName() const override                                 { return desc.name; }
+        void prepareToPlay (double, int) override                                   {}
+        void releaseResources() override                                            {}
+        void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override   {}
+        double getTailLengthSeconds() const override                                { return 0.0; }
+        bool acceptsMidi() const override                                           { return false; }
+        bool producesMidi() const override                                          { return false; }
+        juce::AudioProcessorEditor* createEditor() override                         { return nullptr; }
+        bool hasEditor() const override                                             { return false; }
+        int getNumPrograms() override                                               { return 1; }
+        int getCurrentProgram() override                                            { return 0; }
+        void setCurrentProgram (int) override                                       {}
+        const juce::String getProgramName (int) override                            { return {}; }
+        void changeProgramName (int, const juce::String&) override                  {}
+        void getStateInformation (juce::MemoryBlock& mb) override                   { mb.append (restoredState.toRawUTF8(), restoredState.getNumBytesAsUTF8()); }
+
+        void setStateInformation (const void* data, int size) override
+        {
+            restoredState = juce::String::fromUTF8 (static_cast<const char*> (data), size);
+        }
+
+        juce::PluginDescription desc;
+        juce::String restoredState;
+    };
+
+    //==============================================================================
+    /** Adds some plugin descriptions to the known list and swaps the PluginManager's
+        factory for one that creates TestInstances, recording where they were created.
+    */
+    struct TestPlugins
+    {
+        TestPlugins (Edit& e, const juce::StringArray& formats)
+            : pluginManager (e.engine.getPluginManager()),
+              originalCreateFunction (pluginManager.createPluginInstance),
+              hasBackgroundPlugins (formats.contains (backgroundFormat))
+        {
+            for (int i = 0; i < formats.size(); ++i)
+            {
+                juce::PluginDescription d;
+                d.name = "Plugin " + juce::String (i);
+                d.pluginFormatName = formats[i];
+                d.fileOrIdentifier = "preloader_test_" + juce::String (i);
+                d.uniqueId = d.deprecatedUid = 0x7e570000 + i;
+                descriptions.add (d);
+                pluginManager.knownPluginList.addType (d);
+
+                auto v = ExternalPlugin::create (e.engine, d);
+                e.createNewItemID().writeID (v, nullptr);
+                juce::MemoryBlock chunk;
+                chunk.append (getState (i).toRawUTF8(), getState (i).getNumBytesAsUTF8());
+                v.setProperty (IDs::state, chunk.toBase64Encoding(), nullptr);
+                editState.appendChild (v, nullptr);
+            }
+
+            pluginManager.createPluginInstance = [this] (const juce::PluginDescription& d, double, int, juce::String&)
+                                                 {
+                                                     return create (d);
+                                                 };
+        }
+
+        ~TestPlugins()
+        {
+            pluginManager.createPluginInstance = originalCreateFunction;
+
+            for (auto& d : descriptions)
+                pluginManager.knownPluginList.removeType (d);
+        }
+
+        int getNumPlugins() const                                       { return descriptions.size(); }
+        const juce::PluginDescription& getDescription (int i) const     { return descriptions.getReference (i); }
+        EditItemID getID (int i) const                                  { return EditItemID::fromID (editState.getChild (i)); }
+        static juce::String getState (int i)                            { return "state " + juce::String (i); }
+
+        bool isMessageThreadPlugin (EditItemID itemID) const
+        {
+            for (int i = 0; i < getNumPlugins(); ++i)
+                if (getID (i) == itemID)
+                    return getDescription (i).pluginFormatName != backgroundFormat;
+
+            return false;
+        }
+
+        struct Creation
+        {
+            juce::String name, format;
+            bool onMessageThread = false;
+        };
+
+        std::vector<Creation> getCreated() const
+        {
+            const juce::ScopedLock sl (lock);
+            return created;
+        }
+
+        juce::ValueTree editState { IDs::EDIT };
+        std::function<void (int numCreated)> onCreate;
+        bool backgroundStartedBeforeMessageThread = false;
+
+    private:
+        PluginManager& pluginManager;
+        decltype (PluginManager::createPluginInstance) originalCreateFunction;
+        const bool hasBackgroundPlugins;
+        bool hasWaitedForBackground = false;
+        juce::Array<juce::PluginDescription> descriptions;
+        juce::WaitableEvent backgroundStarted { true };
+        juce::CriticalSection lock;
+        std::vector<Creation> created;
+
+        std::unique_ptr<juce::AudioPluginInstance> create (const juce::PluginDescription& d)
+        {
+            const bool onMessageThread = juce::MessageManager::getInstance()->isThisTheMessageThread();
+
+            if (! onMessageThread)
+            {
+                backgroundStarted.signal();
+            }
+            else if (hasBackgroundPlugins && ! hasWaitedForBackground)
+            {
+                // If the background jobs were only queued after these, this would time out
+                hasWaitedForBackground = true;
+                backgroundStartedBeforeMessageThread = backgroundStarted.wait (5000);
+            }
+
+            int numCreated = 0;
+
+            {
+                const juce::ScopedLock sl (lock);
+                created.push_back ({ d.name, d.pluginFormatName, onMessageThread });
+                numCreated = (int) created.size();
+            }
+
+            if (onCreate)
+                onCreate (numCreated);
+
+            return std::make_unique<TestInstance> (d);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (TestPlugins)
+    };
+};
+
+static ExternalPluginPreloaderTests externalPluginPreloaderTests;
+
+#endif
+
+} // namespace tracktion_engine
@@ -0,0 +1,1279 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace sandbox
+{
+    static const char* commandLineUID = "PluginHost";
+
+    static MemoryBlock createMessage (const XmlElement& xml)
+    {
+        MemoryOutputStream mo;
+        xml.writeTo (mo, XmlElement::TextFormat().withoutHeader().singleLine());
+        return mo.getMemoryBlock();
+    }
+
+    static size_t getSharedBlockSize (int maxNumChannels, int maxBlockSize)
+    {
+        return sizeof (SharedAudioBlock::Header) + sizeof (float) * (size_t) maxNumChannels * (size_t) maxBlockSize;
+    }
+
+    static_assert (sizeof (std::atomic<uint32>) == sizeof (uint32), "The counters must be usable as futex words");
+    static_assert (std::is_trivially_copyable<AudioPlayHead::CurrentPositionInfo>::value, "The position must be able to live in shared memory");
+
+    /** Waits for a counter in shared memory to be set to (or away from) a value.
+        This spins for a few microseconds first as the other side is usually quick, then
+        sleeps on a futex on Linux or yields on other platforms.
+    */
+    static bool waitForCounter (std::atomic<uint32>& counter, uint32 value, bool waitUntilEqual, double timeoutMs) noexcept
+    {
+        auto isDone = [&] (uint32 current) { return (current == value) == waitUntilEqual; };
+
+        for (int i = 0; i < 256; ++i)
+            if (isDone (counter.load (std::memory_order_acquire)))
+                return true;
+
+        const auto endTime = Time::getMillisecondCounterHiRes() + timeoutMs;
+
+        for (;;)
+        {
+            const auto current = counter.load (std::memory_order_acquire);
+
+            if (isDone (current))
+                return true;
+
+            const auto remainingMs = endTime - Time::getMillisecondCounterHiRes();
+
+            if (remainingMs <= 0.0)
+                return false;
+
+           #if JUCE_LINUX
+            timespec timeout;
+            timeout.tv_sec = (time_t) (remainingMs / 1000.0);
+            timeout.tv_nsec = (long) (std::fmod (remainingMs, 1000.0) * 1000000.0);
+
+            // This isn't a private futex as the other side is in another process
+            syscall (SYS_futex, reinterpret_cast<uint32*> (&counter), FUTEX_WAIT, current, &timeout, nullptr, 0);
+           #else
+            Thread::yield();
+           #endif
+        }
+    }
+
+    static void wakeCounter (std::atomic<uint32>& counter) noexcept
+    {
+       #if JUCE_LINUX
+        syscall (SYS_futex, reinterpret_cast<uint32*> (&counter), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+       #else
+        ignoreUnused (counter);
+       #endif
+    }
+}
+
+//==============================================================================
+SharedAudioBlock::SharedAudioBlock (const String& n, void* d, size_t s, bool owner)
+    : name (n), data (d), size (s), header (static_cast<Header*> (d)), isOwner (owner)
+{
+}
+
+SharedAudioBlock::~SharedAudioBlock()
+{
+    unlink();
+
+   #if JUCE_LINUX || JUCE_MAC
+    munmap (data, size);
+   #endif
+}
+
+bool SharedAudioBlock::isSupported()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+std::unique_ptr<SharedAudioBlock> SharedAudioBlock::create (int maxNumChannels, int maxBlockSize)
+{
+   #if JUCE_LINUX || JUCE_MAC
+    // N.B. macOS limits these names to 31 characters
+    auto name = "/tkn_" + String::toHexString (Random::getSystemRandom().nextInt64());
+    auto size = sandbox::getSharedBlockSize (maxNumChannels, maxBlockSize);
+
+    auto fd = shm_open (name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd < 0)
+        return {};
+
+    if (ftruncate (fd, (off_t) size) != 0)
+    {
+        close (fd);
+        shm_unlink (name.toRawUTF8());
+        return {};
+    }
+
+    auto data = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+
+    if (data == MAP_FAILED)
+    {
+        shm_unlink (name.toRawUTF8());
+        return {};
+    }
+
+    auto header = new (data) Header();
+    header->maxNumChannels = maxNumChannels;
+    header->maxBlockSize = maxBlockSize;
+
+    return std::unique_ptr<SharedAudioBlock> (new SharedAudioBlock (name, data, size, true));
+   #else
+    ignoreUnused (maxNumChannels, maxBlockSize);
+    return {};
+   #endif
+}
+
+std::unique_ptr<SharedAudioBlock> SharedAudioBlock::open (const String& name)
+{
+   #if JUCE_LINUX || JUCE_MAC
+    auto fd = shm_open (name.toRawUTF8(), O_RDWR, 0600);
+
+    if (fd < 0)
+        return {};
+
+    struct stat info;
+
+    if (fstat (fd, &info) != 0 || (size_t) info.st_size < sizeof (Header))
+    {
+        close (fd);
+        return {};
+    }
+
+    auto size = (size_t) info.st_size;
+    auto data = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+
+    if (data == MAP_FAILED)
+        return {};
+
+    std::unique_ptr<SharedAudioBlock> block (new SharedAudioBlock (name, data, size, false));
+
+    if (sandbox::getSharedBlockSize (block->getMaxNumChannels(), block->getMaxBlockSize()) > size)
+        return {};
+
+    return block;
+   #else
+    ignoreUnused (name);
+    return {};
+   #endif
+}
+
+void SharedAudioBlock::unlink()
+{
+    if (isOwner)
+    {
+        isOwner = false;
+
+       #if JUCE_LINUX || JUCE_MAC
+        shm_unlink (name.toRawUTF8());
+       #endif
+    }
+}
+
+float* SharedAudioBlock::getChannel (int channel) noexcept
+{
+    jassert (isPositiveAndBelow (channel, header->maxNumChannels));
+    auto audioData = reinterpret_cast<float*> (static_cast<char*> (data) + sizeof (Header));
+    return audioData + (size_t) channel * (size_t) header->maxBlockSize;
+}
+
+bool SharedAudioBlock::writeMidi (const MidiBuffer& midi, int startSample, int numSamples) noexcept
+{
+    auto dest = header->midiData;
+    int numBytes = 0;
+    bool allWritten = true;
+
+    for (auto it = midi.findNextSamplePosition (startSample); it != midi.cend(); ++it)
+    {
+        const auto m = *it;
+
+        if (m.samplePosition >= startSample + numSamples)
+            break;
+
+        const int eventSize = (int) (sizeof (int32) + sizeof (uint16)) + m.numBytes;
+
+        if (numBytes + eventSize > Header::maxMidiBytes)
+        {
+            allWritten = false;
+            break;
+        }
+
+        const auto position = (int32) (m.samplePosition - startSample);
+        const auto size = (uint16) m.numBytes;
+        memcpy (dest + numBytes, &position, sizeof (position));
+        memcpy (dest + numBytes + sizeof (position), &size, sizeof (size));
+        memcpy (dest + numBytes + sizeof (position) + sizeof (size), m.data, (size_t) m.numBytes);
+        numBytes += eventSize;
+    }
+
+    header->numMidiBytes = numBytes;
+    return allWritten;
+}
+
+void SharedAudioBlock::readMidi (MidiBuffer& midi, int sampleOffset) const
+{
+    auto source = header->midiData;
+    const int numBytes = jlimit (0, (int) Header::maxMidiBytes, (int) header->numMidiBytes);
+
+    for (int i = 0; i + (int) (sizeof (int32) + sizeof (uint16)) <= numBytes;)
+    {
+        int32 position;
+        uint16 size;
+        memcpy (&position, source + i, sizeof (position));
+        memcpy (&size, source + i + sizeof (position), sizeof (size));
+        i += (int) (sizeof (position) + sizeof (size));
+
+        if (i + size > numBytes)
+            break;
+
+        midi.addEvent (source + i, size, position + sampleOffset);
+        i += size;
+    }
+}
+
+bool SharedAudioBlock::isWaitingForReply() const noexcept
+{
+    return header->replyNumber.load (std::memory_order_acquire) != header->requestNumber.load (std::memory_order_relaxed);
+}
+
+uint32 SharedAudioBlock::sendRequest() noexcept
+{
+    jassert (! isWaitingForReply());
+    const auto requestNumber = header->requestNumber.load (std::memory_order_relaxed) + 1;
+    header->requestNumber.store (requestNumber, std::memory_order_release);
+    sandbox::wakeCounter (header->requestNumber);
+    return requestNumber;
+}
+
+bool SharedAudioBlock::waitForReply (uint32 requestNumber, double timeoutMs) noexcept
+{
+    return sandbox::waitForCounter (header->replyNumber, requestNumber, true, timeoutMs);
+}
+
+bool SharedAudioBlock::waitForRequest (uint32 lastRequestNumber, double timeoutMs) noexcept
+{
+    return sandbox::waitForCounter (header->requestNumber, lastRequestNumber, false, timeoutMs);
+}
+
+void SharedAudioBlock::sendReply (uint32 requestNumber) noexcept
+{
+    header->replyTicks = Time::getHighResolutionTicks();
+    header->replyNumber.store (requestNumber, std::memory_order_release);
+    sandbox::wakeCounter (header->replyNumber);
+}
+
+
+//==============================================================================
+class SandboxedPluginInstance::WorkerConnection  : private ChildProcessMaster
+{
+public:
+    WorkerConnection() = default;
+
+    bool launch()
+    {
+        // don't get stdout or strerr from the child process. We don't do anything with it and it fills up the pipe and hangs
+        if (launchSlaveProcess (File::getSpecialLocation (File::currentExecutableFile), sandbox::commandLineUID, 0, 0))
+        {
+            TRACKTION_LOG ("----- Launched Plugin Host Process");
+            return true;
+        }
+
+        TRACKTION_LOG_ERROR ("Failed to launch plugin host process");
+        return false;
+    }
+
+    /** Sends a message and waits for the reply with the same id. */
+    std::unique_ptr<XmlElement> sendAndWait (XmlElement& message, int timeoutMs)
+    {
+        const int requestID = ++lastRequestID;
+        message.setAttribute ("id", requestID);
+
+        if (crashed || ! sendMessageToSlave (sandbox::createMessage (message)))
+            return {};
+
+        const auto endTime = Time::getMillisecondCounter() + (uint32) timeoutMs;
+
+        for (;;)
+        {
+            if (auto reply = findReply (requestID))
+                return reply;
+
+            if (crashed || Time::getMillisecondCounter() > endTime)
+                return {};
+
+            replyArrived.wait (10);
+        }
+    }
+
+    std::atomic<bool> crashed { false };
+
+private:
+    OwnedArray<XmlElement> replies;
+    CriticalSection replyLock;
+    WaitableEvent replyArrived;
+    std::atomic<int> lastRequestID { 0 };
+
+    std::unique_ptr<XmlElement> findReply (int requestID)
+    {
+        const ScopedLock sl (replyLock);
+
+        for (int i = replies.size(); --i >= 0;)
+            if (replies.getUnchecked (i)->getIntAttribute ("id") == requestID)
+                return std::unique_ptr<XmlElement> (replies.removeAndReturn (i));
+
+        return {};
+    }
+
+    void handleMessageFromSlave (const MemoryBlock& mb) override
+    {
+        if (auto xml = std::unique_ptr<XmlElement> (XmlDocument::parse (mb.toString())))
+        {
+            const ScopedLock sl (replyLock);
+            replies.add (xml.release());
+        }
+
+        replyArrived.signal();
+    }
+
+    void handleConnectionLost() override
+    {
+        crashed = true;
+        replyArrived.signal();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerConnection)
+};
+
+//==============================================================================
+#if JUCE_VERSION >= 0x60100
+ using SandboxedParameterBase = HostedAudioProcessorParameter;
+#else
+ using SandboxedParameterBase = AudioProcessorParameter;
+#endif
+
+class SandboxedPluginInstance::Parameter  : public SandboxedParameterBase
+{
+public:
+    Parameter (SandboxedPluginInstance& o, int index, const XmlElement& xml)
+        : owner (o),
+          parameterID (xml.getStringAttribute ("paramID", String (index))),
+          name (xml.getStringAttribute ("name")),
+          label (xml.getStringAttribute ("label")),
+          defaultValue ((float) xml.getDoubleAttribute ("default")),
+          numSteps (xml.getIntAttribute ("steps", AudioProcessor::getDefaultNumParameterSteps())),
+          discrete (xml.getBoolAttribute ("discrete")),
+          boolean (xml.getBoolAttribute ("boolean")),
+          automatable (xml.getBoolAttribute ("automatable", true)),
+          value ((float) xml.getDoubleAttribute ("value"))
+    {
+    }
+
+    float getValue() const override                             { return value.load (std::memory_order_relaxed); }
+
+    void setValue (float newValue) override
+    {
+        value.store (newValue, std::memory_order_relaxed);
+        needsSending.store (true, std::memory_order_release);
+        owner.parametersChanged.store (true, std::memory_order_release);
+    }
+
+    /** Updates the value after the worker's plugin has changed it. */
+    void setValueFromWorker (float newValue)
+    {
+        value.store (newValue, std::memory_order_relaxed);
+        sendValueChangedMessageToListeners (newValue);
+    }
+
+    bool getAndClearNeedsSending() noexcept                     { return needsSending.exchange (false, std::memory_order_acquire); }
+
+    float getDefaultValue() const override                      { return defaultValue; }
+    String getName (int maximumStringLength) const override     { return name.substring (0, maximumStringLength); }
+    String getLabel() const override                            { return label; }
+    int getNumSteps() const override                            { return numSteps; }
+    bool isDiscrete() const override                            { return discrete; }
+    bool isBoolean() const override                             { return boolean; }
+    bool isAutomatable() const override                         { return automatable; }
+    float getValueForText (const String& text) const override   { return jlimit (0.0f, 1.0f, text.getFloatValue()); }
+
+   #if JUCE_VERSION >= 0x60100
+    String getParameterID() const override                      { return parameterID; }
+   #endif
+
+private:
+    SandboxedPluginInstance& owner;
+    const String parameterID, name, label;
+    const float defaultValue;
+    const int numSteps;
+    const bool discrete, boolean, automatable;
+    std::atomic<float> value;
+    std::atomic<bool> needsSending { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Parameter)
+};
+
+//==============================================================================
+static AudioProcessor::BusesProperties createSandboxedBuses (const XmlElement& info)
+{
+    AudioProcessor::BusesProperties buses;
+    const int numInputs = info.getIntAttribute ("numInputs");
+    const int numOutputs = info.getIntAttribute ("numOutputs");
+
+    if (numInputs > 0)
+        buses = buses.withInput ("Input", AudioChannelSet::canonicalChannelSet (numInputs));
+
+    if (numOutputs > 0)
+        buses = buses.withOutput ("Output", AudioChannelSet::canonicalChannelSet (numOutputs));
+
+    return buses;
+}
+
+std::unique_ptr<SandboxedPluginInstance> SandboxedPluginInstance::create (const PluginDescription& desc,
+                                                                          double sampleRate, int blockSize,
+                                                                          String& errorMessage)
+{
+    CRASH_TRACER
+
+    if (! SharedAudioBlock::isSupported())
+    {
+        errorMessage = TRANS("Plugins can't be run in a separate process on this platform");
+        return {};
+    }
+
+    auto connection = std::make_unique<WorkerConnection>();
+
+    if (! connection->launch())
+    {
+        errorMessage = TRANS("Couldn't launch a process to host the plugin");
+        return {};
+    }
+
+    XmlElement createMessage ("CREATE");
+    createMessage.setAttribute ("sampleRate", sampleRate);
+    createMessage.setAttribute ("blockSize", blockSize);
+    createMessage.addChildElement (desc.createXml().release());
+
+    // Some plugins take a long time to load so give them plenty of time
+    auto info = connection->sendAndWait (createMessage, 60000);
+
+    if (info == nullptr)
+    {
+        errorMessage = TRANS("The plugin host process crashed or stopped responding");
+        return {};
+    }
+
+    if (! info->hasTagName ("INFO"))
+    {
+        errorMessage = info->getStringAttribute ("error", TRANS("Couldn't create the plugin"));
+        return {};
+    }
+
+    std::unique_ptr<SandboxedPluginInstance> instance (new SandboxedPluginInstance (std::move (connection), desc, *info));
+    instance->setRateAndBufferSizeDetails (sampleRate, blockSize);
+
+    if (! instance->openSharedBlock (blockSize))
+    {
+        errorMessage = TRANS("Couldn't share memory with the plugin host process");
+        return {};
+    }
+
+    return instance;
+}
+
+SandboxedPluginInstance::SandboxedPluginInstance (std::unique_ptr<WorkerConnection> c, const PluginDescription& desc, const XmlElement& info)
+    : AudioPluginInstance (createSandboxedBuses (info)),
+      connection (std::move (c)),
+      description (desc),
+      tailLengthSeconds (info.getDoubleAttribute ("tail")),
+      pluginAcceptsMidi (info.getBoolAttribute ("acceptsMidi")),
+      pluginProducesMidi (info.getBoolAttribute ("producesMidi"))
+{
+    if (auto d = info.getChildByName ("PLUGIN"))
+        description.loadFromXml (*d);
+
+    pluginLatencySamples = info.getIntAttribute ("latency");
+    setLatencySamples (pluginLatencySamples);
+
+    int index = 0;
+
+    for (auto p : info.getChildWithTagNameIterator ("PARAM"))
+    {
+        auto parameter = new Parameter (*this, index++, *p);
+        sandboxedParameters.add (parameter);
+
+       #if JUCE_VERSION >= 0x60100
+        addHostedParameter (std::unique_ptr<HostedAudioProcessorParameter> (parameter));
+       #else
+        addParameter (parameter);
+       #endif
+    }
+}
+
+SandboxedPluginInstance::~SandboxedPluginInstance()
+{
+    // Closing the connection makes the worker process quit
+    connection.reset();
+    sharedBlock.reset();
+}
+
+bool SandboxedPluginInstance::hasCrashed() const noexcept
+{
+    return connection->crashed;
+}
+
+bool SandboxedPluginInstance::openSharedBlock (int maxBlockSize)
+{
+    const int maxNumChannels = jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    auto newBlock = SharedAudioBlock::create (maxNumChannels, jmax (32, maxBlockSize));
+
+    if (newBlock == nullptr)
+        return false;
+
+    XmlElement message ("OPEN");
+    message.setAttribute ("name", newBlock->getName());
+    auto reply = sendToWorker (message, 10000);
+
+    if (reply == nullptr || ! reply->hasTagName ("OK"))
+        return false;
+
+    // The worker has its own mapping now so the name can be removed
+    newBlock->unlink();
+    sharedBlock = std::move (newBlock);
+    resetDelayedOutput();
+    return true;
+}
+
+void SandboxedPluginInstance::resetDelayedOutput()
+{
+    if (sharedBlock == nullptr)
+        return;
+
+    // The output is a whole block behind so that the worker has until the next block to process it
+    const int delay = sharedBlock->getMaxBlockSize();
+    delayedOutput.setSize (sharedBlock->getMaxNumChannels(), 2 * delay);
+    delayedOutput.clear();
+    numDelayedSamples = delay;
+
+    // Any reply that's still to come will be ignored
+    numSamplesInFlight = 0;
+
+    delayedMidi.clear();
+    delayedMidi.ensureSize (2 * SharedAudioBlock::Header::maxMidiBytes);
+    remainingMidi.ensureSize (2 * SharedAudioBlock::Header::maxMidiBytes);
+
+    setLatencySamples (pluginLatencySamples + delay);
+}
+
+std::unique_ptr<XmlElement> SandboxedPluginInstance::sendToWorker (XmlElement& message, int timeoutMs)
+{
+    auto reply = connection->sendAndWait (message, timeoutMs);
+
+    if (reply == nullptr)
+        TRACKTION_LOG_ERROR ("Plugin host process didn't reply: " + description.name);
+
+    return reply;
+}
+
+void SandboxedPluginInstance::updateParameterValues (const String& values)
+{
+    auto tokens = StringArray::fromTokens (values, ",", {});
+
+    for (int i = 0; i < jmin (tokens.size(), sandboxedParameters.size()); ++i)
+    {
+        auto p = sandboxedParameters.getUnchecked (i);
+        const auto newValue = tokens[i].getFloatValue();
+
+        if (p->getValue() != newValue)
+            p->setValueFromWorker (newValue);
+    }
+}
+
+//==============================================================================
+SandboxedPluginInstance::Statistics SandboxedPluginInstance::getStatistics() const
+{
+    Statistics s;
+    s.numBlocks = numBlocks.load();
+    s.numLateBlocks = numLateBlocks.load();
+
+    const int numOnTime = s.numBlocks - s.numLateBlocks;
+
+    if (numOnTime > 0)
+    {
+        s.averageRoundTripMs = totalRoundTripMicroseconds.load() / (1000.0 * numOnTime);
+        s.averageOverheadMs = totalOverheadMicroseconds.load() / (1000.0 * numOnTime);
+    }
+
+    s.maxOverheadMs = maxOverheadMicroseconds.load() / 1000.0;
+    return s;
+}
+
+void SandboxedPluginInstance::resetStatistics()
+{
+    numBlocks = 0;
+    numLateBlocks = 0;
+    totalRoundTripMicroseconds = 0;
+    totalOverheadMicroseconds = 0;
+    maxOverheadMicroseconds = 0;
+}
+
+//==============================================================================
+void SandboxedPluginInstance::fillInPluginDescription (PluginDescription& d) const
+{
+    d = description;
+}
+
+const String SandboxedPluginInstance::getName() const           { return description.name; }
+double SandboxedPluginInstance::getTailLengthSeconds() const    { return tailLengthSeconds; }
+bool SandboxedPluginInstance::acceptsMidi() const               { return pluginAcceptsMidi; }
+bool SandboxedPluginInstance::producesMidi() const              { return pluginProducesMidi; }
+
+void SandboxedPluginInstance::prepareToPlay (double sampleRate, int blockSize)
+{
+    CRASH_TRACER
+
+    if (hasCrashed())
+        return;
+
+    if (sharedBlock == nullptr || blockSize > sharedBlock->getMaxBlockSize())
+        openSharedBlock (blockSize);
+
+    XmlElement message ("PREPARE");
+    message.setAttribute ("sampleRate", sampleRate);
+    message.setAttribute ("blockSize", blockSize);
+
+    if (auto reply = sendToWorker (message, 30000))
+        pluginLatencySamples = reply->getIntAttribute ("latency", pluginLatencySamples);
+
+    midiOutput.ensureSize (SharedAudioBlock::Header::maxMidiBytes);
+    resetDelayedOutput();
+}
+
+void SandboxedPluginInstance::releaseResources()
+{
+    if (! hasCrashed())
+    {
+        XmlElement message ("RELEASE");
+        sendToWorker (message, 10000);
+    }
+}
+
+void SandboxedPluginInstance::reset()
+{
+    if (! hasCrashed())
+    {
+        XmlElement message ("RESET");
+        sendToWorker (message, 10000);
+    }
+
+    resetDelayedOutput();
+}
+
+void SandboxedPluginInstance::getStateInformation (MemoryBlock& destData)
+{
+    if (hasCrashed())
+        return;
+
+    XmlElement message ("GETSTATE");
+
+    if (auto reply = sendToWorker (message, 30000))
+        destData.fromBase64Encoding (reply->getStringAttribute ("state"));
+}
+
+void SandboxedPluginInstance::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (hasCrashed())
+        return;
+
+    XmlElement message ("SETSTATE");
+    message.setAttribute ("state", MemoryBlock (data, (size_t) sizeInBytes).toBase64Encoding());
+
+    if (auto reply = sendToWorker (message, 30000))
+        updateParameterValues (reply->getStringAttribute ("values"));
+}
+
+//==============================================================================
+void SandboxedPluginInstance::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    processInWorker (buffer, midi, false);
+}
+
+void SandboxedPluginInstance::processBlockBypassed (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    processInWorker (buffer, midi, true);
+}
+
+void SandboxedPluginInstance::processInWorker (AudioBuffer<float>& buffer, MidiBuffer& midi, bool bypassed)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    if (sharedBlock == nullptr || hasCrashed())
+    {
+        buffer.clear();
+        midi.clear();
+        return;
+    }
+
+    midiOutput.clear();
+    const int maxBlockSize = sharedBlock->getMaxBlockSize();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        processChunk (buffer, start, jmin (maxBlockSize, numSamples - start), midi, bypassed);
+
+    midi.swapWith (midiOutput);
+}
+
+void SandboxedPluginInstance::processChunk (AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                            const MidiBuffer& midiIn, bool bypassed)
+{
+    ++numBlocks;
+
+    // The worker's had since the last block to process the one it was sent then so don't wait
+    // for it, unless this is rendering in which case wait as long as it takes
+    const double timeoutMs = isNonRealtime() ? 30000.0 : 0.0;
+
+    if (numSamplesInFlight > 0)
+    {
+        if (sharedBlock->waitForReply (lastRequestNumber, timeoutMs))
+        {
+            receiveReply();
+        }
+        else
+        {
+            // Output silence in its place and ignore the reply when it does arrive
+            ++numLateBlocks;
+            appendSilence (numSamplesInFlight);
+        }
+
+        numSamplesInFlight = 0;
+    }
+
+    // If the worker still hasn't finished the last block it was late with, it can't be given another one yet
+    if (sharedBlock->isWaitingForReply() && ! sharedBlock->waitForReply (lastRequestNumber, timeoutMs))
+    {
+        ++numLateBlocks;
+        appendSilence (numSamples);
+    }
+    else
+    {
+        sendChunk (buffer, startSample, numSamples, midiIn, bypassed);
+    }
+
+    popDelayedOutput (buffer, startSample, numSamples);
+}
+
+void SandboxedPluginInstance::sendChunk (const AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                         const MidiBuffer& midiIn, bool bypassed)
+{
+    auto& header = sharedBlock->getHeader();
+    const int numChannels = jmin (buffer.getNumChannels(), sharedBlock->getMaxNumChannels());
+
+    header.numChannels = numChannels;
+    header.numSamples = numSamples;
+    header.bypassed = bypassed ? 1 : 0;
+    header.nonRealtime = isNonRealtime() ? 1 : 0;
+    header.hasPosition = 0;
+
+    if (auto ph = getPlayHead())
+    {
+        if (ph->getCurrentPosition (header.position))
+        {
+            header.hasPosition = 1;
+            header.position.timeInSamples += startSample;
+            header.position.timeInSeconds += startSample / getSampleRate();
+        }
+    }
+
+    for (int c = 0; c < numChannels; ++c)
+        FloatVectorOperations::copy (sharedBlock->getChannel (c), buffer.getReadPointer (c, startSample), numSamples);
+
+    sharedBlock->writeMidi (midiIn, startSample, numSamples);
+
+    int numParameterChanges = 0;
+
+    if (parametersChanged.exchange (false, std::memory_order_acquire))
+    {
+        for (int i = 0; i < sandboxedParameters.size(); ++i)
+        {
+            auto p = sandboxedParameters.getUnchecked (i);
+
+            if (numParameterChanges >= SharedAudioBlock::Header::maxParameterChanges)
+            {
+                // Too many to send in one go so leave the rest for the next block
+                parametersChanged = true;
+                break;
+            }
+
+            if (p->getAndClearNeedsSending())
+                header.parameterChanges[numParameterChanges++] = { (int32) i, p->getValue() };
+        }
+    }
+
+    header.numParameterChanges = numParameterChanges;
+
+    requestStartTicks = Time::getHighResolutionTicks();
+    lastRequestNumber = sharedBlock->sendRequest();
+    numSamplesInFlight = numSamples;
+}
+
+void SandboxedPluginInstance::receiveReply()
+{
+    auto& header = sharedBlock->getHeader();
+    const int numSamples = numSamplesInFlight;
+    const int numChannels = jmin ((int) header.numChannels, delayedOutput.getNumChannels());
+    jassert (numDelayedSamples + numSamples <= delayedOutput.getNumSamples());
+
+    for (int c = 0; c < numChannels; ++c)
+        FloatVectorOperations::copy (delayedOutput.getWritePointer (c, numDelayedSamples), sharedBlock->getChannel (c), numSamples);
+
+    for (int c = numChannels; c < delayedOutput.getNumChannels(); ++c)
+        delayedOutput.clear (c, numDelayedSamples, numSamples);
+
+    sharedBlock->readMidi (delayedMidi, numDelayedSamples);
+    numDelayedSamples += numSamples;
+
+    const int numChanges = jlimit (0, (int) SharedAudioBlock::Header::maxParameterChanges, (int) header.numParameterChanges);
+
+    for (int i = 0; i < numChanges; ++i)
+        if (auto p = sandboxedParameters[header.parameterChanges[i].index])
+            p->setValueFromWorker (header.parameterChanges[i].value);
+
+    const auto roundTripSeconds = Time::highResolutionTicksToSeconds (header.replyTicks - requestStartTicks);
+    const auto roundTripMicroseconds = jmax ((int64) 0, (int64) (roundTripSeconds * 1000000.0));
+    const auto overheadMicroseconds = jmax ((int64) 0, (int64) ((roundTripSeconds - header.processingSeconds) * 1000000.0));
+    totalRoundTripMicroseconds += roundTripMicroseconds;
+    totalOverheadMicroseconds += overheadMicroseconds;
+
+    auto currentMax = maxOverheadMicroseconds.load();
+
+    while (overheadMicroseconds > currentMax
+            && ! maxOverheadMicroseconds.compare_exchange_weak (currentMax, overheadMicroseconds))
+    {}
+}
+
+void SandboxedPluginInstance::appendSilence (int numSamples)
+{
+    jassert (numDelayedSamples + numSamples <= delayedOutput.getNumSamples());
+    delayedOutput.clear (numDelayedSamples, numSamples);
+    numDelayedSamples += numSamples;
+}
+
+void SandboxedPluginInstance::popDelayedOutput (AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    jassert (numDelayedSamples >= numSamples);
+    const int numRemaining = numDelayedSamples - numSamples;
+
+    for (int c = 0; c < delayedOutput.getNumChannels(); ++c)
+    {
+        auto d = delayedOutput.getWritePointer (c);
+
+        if (c < buffer.getNumChannels())
+            FloatVectorOperations::copy (buffer.getWritePointer (c, startSample), d, numSamples);
+
+        memmove (d, d + numSamples, sizeof (float) * (size_t) numRemaining);
+    }
+
+    for (int c = delayedOutput.getNumChannels(); c < buffer.getNumChannels(); ++c)
+        buffer.clear (c, startSample, numSamples);
+
+    numDelayedSamples = numRemaining;
+
+    remainingMidi.clear();
+
+    for (auto m : delayedMidi)
+    {
+        if (m.samplePosition < numSamples)
+            midiOutput.addEvent (m.data, m.numBytes, m.samplePosition + startSample);
+        else
+            remainingMidi.addEvent (m.data, m.numBytes, m.samplePosition - numSamples);
+    }
+
+    delayedMidi.swapWith (remainingMidi);
+}
+
+
+//==============================================================================
+/**
+    Runs in the worker process, hosting a single plugin.
+    Control messages are handled on the message thread and audio is processed on a
+    realtime thread whenever the engine signals the shared block.
+*/
+struct PluginHostSlaveProcess  : public ChildProcessSlave,
+                                 private AsyncUpdater,
+                                 private AudioProcessorListener,
+                                 private Thread
+{
+    PluginHostSlaveProcess()
+        : Thread ("Sandboxed Plugin")
+    {
+        pluginFormatManager.addDefaultFormats();
+    }
+
+    ~PluginHostSlaveProcess() override
+    {
+        stopThread (1000);
+
+        if (instance != nullptr)
+            instance->removeListener (this);
+    }
+
+    void handleConnectionMade() override {}
+
+    void handleConnectionLost() override
+    {
+        std::exit (0);
+    }
+
+private:
+    //==============================================================================
+    struct SharedPlayHead  : public AudioPlayHead
+    {
+        SharedAudioBlock::Header* header = nullptr;
+
+        bool getCurrentPosition (CurrentPositionInfo& result) override
+        {
+            if (header == nullptr || header->hasPosition == 0)
+                return false;
+
+            result = header->position;
+            return true;
+        }
+    };
+
+    AudioPluginFormatManager pluginFormatManager;
+    OwnedArray<XmlElement, CriticalSection> pendingMessages;
+
+    CriticalSection processLock;
+    std::unique_ptr<AudioPluginInstance> instance;
+    std::unique_ptr<SharedAudioBlock> sharedBlock;
+    SharedPlayHead playHead;
+    AudioBuffer<float> buffer;
+    MidiBuffer midi;
+    bool isNonRealtime = false;
+
+    std::unique_ptr<std::atomic<bool>[]> changedParameters;
+    std::atomic<bool> anyParameterChanged { false };
+    int numParameters = 0;
+
+    //==============================================================================
+    void handleMessageFromMaster (const MemoryBlock& mb) override
+    {
+        if (auto xml = std::unique_ptr<XmlElement> (XmlDocument::parse (mb.toString())))
+        {
+            pendingMessages.add (xml.release());
+            triggerAsyncUpdate();
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        while (pendingMessages.size() > 0)
+            if (auto xml = std::unique_ptr<XmlElement> (pendingMessages.removeAndReturn (0)))
+                handleMessage (*xml);
+    }
+
+    void reply (const XmlElement& request, XmlElement& result)
+    {
+        result.setAttribute ("id", request.getIntAttribute ("id"));
+        sendMessageToMaster (sandbox::createMessage (result));
+    }
+
+    void replyOK (const XmlElement& request)
+    {
+        XmlElement result ("OK");
+        reply (request, result);
+    }
+
+    void replyError (const XmlElement& request, const String& error)
+    {
+        XmlElement result ("ERROR");
+        result.setAttribute ("error", error);
+        reply (request, result);
+    }
+
+    String getParameterValues() const
+    {
+        StringArray values;
+
+        for (auto p : instance->getParameters())
+            values.add (String (p->getValue()));
+
+        return values.joinIntoString (",");
+    }
+
+    void handleMessage (const XmlElement& m)
+    {
+        if (m.hasTagName ("CREATE"))
+        {
+            createPlugin (m);
+            return;
+        }
+
+        if (instance == nullptr)
+        {
+            replyError (m, "No plugin");
+            return;
+        }
+
+        if (m.hasTagName ("OPEN"))
+        {
+            stopThread (1000);
+            sharedBlock = SharedAudioBlock::open (m.getStringAttribute ("name"));
+
+            if (sharedBlock == nullptr)
+            {
+                replyError (m, "Couldn't open shared memory");
+                return;
+            }
+
+            const int numChannels = jmax (sharedBlock->getMaxNumChannels(),
+                                          instance->getTotalNumInputChannels(),
+                                          instance->getTotalNumOutputChannels());
+            buffer.setSize (numChannels, sharedBlock->getMaxBlockSize());
+            midi.ensureSize (SharedAudioBlock::Header::maxMidiBytes);
+            playHead.header = &sharedBlock->getHeader();
+
+            startThread (10);
+            replyOK (m);
+        }
+        else if (m.hasTagName ("PREPARE"))
+        {
+            XmlElement result ("OK");
+
+            {
+                const ScopedLock sl (processLock);
+                instance->prepareToPlay (m.getDoubleAttribute ("sampleRate"), m.getIntAttribute ("blockSize"));
+                result.setAttribute ("latency", instance->getLatencySamples());
+            }
+
+            reply (m, result);
+        }
+        else if (m.hasTagName ("RELEASE"))
+        {
+            const ScopedLock sl (processLock);
+            instance->releaseResources();
+            replyOK (m);
+        }
+        else if (m.hasTagName ("RESET"))
+        {
+            const ScopedLock sl (processLock);
+            instance->reset();
+            replyOK (m);
+        }
+        else if (m.hasTagName ("GETSTATE"))
+        {
+            MemoryBlock state;
+
+            {
+                const ScopedLock sl (processLock);
+                instance->getStateInformation (state);
+            }
+
+            XmlElement result ("STATE");
+            result.setAttribute ("state", state.toBase64Encoding());
+            reply (m, result);
+        }
+        else if (m.hasTagName ("SETSTATE"))
+        {
+            MemoryBlock state;
+            state.fromBase64Encoding (m.getStringAttribute ("state"));
+
+            XmlElement result ("OK");
+
+            {
+                const ScopedLock sl (processLock);
+                instance->setStateInformation (state.getData(), (int) state.getSize());
+                result.setAttribute ("values", getParameterValues());
+            }
+
+            reply (m, result);
+        }
+    }
+
+    void createPlugin (const XmlElement& m)
+    {
+        PluginDescription desc;
+
+        if (auto d = m.getChildByName ("PLUGIN"))
+            desc.loadFromXml (*d);
+
+        String error;
+        instance = pluginFormatManager.createPluginInstance (desc, m.getDoubleAttribute ("sampleRate"),
+                                                             m.getIntAttribute ("blockSize"), error);
+
+        if (instance == nullptr)
+        {
+            replyError (m, error);
+            return;
+        }
+
+        instance->enableAllBuses();
+        instance->setPlayHead (&playHead);
+
+        auto& parameters = instance->getParameters();
+        numParameters = parameters.size();
+        changedParameters.reset (new std::atomic<bool>[(size_t) numParameters]);
+
+        for (int i = 0; i < numParameters; ++i)
+            changedParameters[(size_t) i] = false;
+
+        XmlElement result ("INFO");
+        result.setAttribute ("numInputs", instance->getTotalNumInputChannels());
+        result.setAttribute ("numOutputs", instance->getTotalNumOutputChannels());
+        result.setAttribute ("latency", instance->getLatencySamples());
+        result.setAttribute ("tail", instance->getTailLengthSeconds());
+        result.setAttribute ("acceptsMidi", instance->acceptsMidi());
+        result.setAttribute ("producesMidi", instance->producesMidi());
+        result.addChildElement (instance->getPluginDescription().createXml().release());
+
+        for (auto p : parameters)
+        {
+            auto e = result.createNewChildElement ("PARAM");
+
+            if (auto withID = dynamic_cast<AudioProcessorParameterWithID*> (p))
+                e->setAttribute ("paramID", withID->paramID);
+
+            e->setAttribute ("name", p->getName (1024));
+            e->setAttribute ("label", p->getLabel());
+            e->setAttribute ("default", p->getDefaultValue());
+            e->setAttribute ("value", p->getValue());
+            e->setAttribute ("steps", p->getNumSteps());
+            e->setAttribute ("discrete", p->isDiscrete());
+            e->setAttribute ("boolean", p->isBoolean());
+            e->setAttribute ("automatable", p->isAutomatable());
+        }
+
+        instance->addListener (this);
+        reply (m, result);
+    }
+
+    //==============================================================================
+    void run() override
+    {
+        auto& header = sharedBlock->getHeader();
+        auto lastRequestNumber = header.replyNumber.load();
+
+        while (! threadShouldExit())
+        {
+            if (! sharedBlock->waitForRequest (lastRequestNumber, 100.0))
+                continue;
+
+            lastRequestNumber = header.requestNumber.load (std::memory_order_acquire);
+
+            {
+                const ScopedLock sl (processLock);
+                processRequest (header);
+            }
+
+            sharedBlock->sendReply (lastRequestNumber);
+        }
+    }
+
+    void processRequest (SharedAudioBlock::Header& header)
+    {
+        const int numSamples = jlimit (0, buffer.getNumSamples(), (int) header.numSamples);
+        const int numChannels = jlimit (0, sharedBlock->getMaxNumChannels(), (int) header.numChannels);
+        AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+            FloatVectorOperations::copy (block.getWritePointer (c), sharedBlock->getChannel (c), numSamples);
+
+        for (int c = numChannels; c < block.getNumChannels(); ++c)
+            block.clear (c, 0, numSamples);
+
+        midi.clear();
+        sharedBlock->readMidi (midi, 0);
+
+        auto& parameters = instance->getParameters();
+        const int numChanges = jlimit (0, (int) SharedAudioBlock::Header::maxParameterChanges, (int) header.numParameterChanges);
+
+        for (int i = 0; i < numChanges; ++i)
+            if (auto p = parameters[header.parameterChanges[i].index])
+                p->setValue (header.parameterChanges[i].value);
+
+        if (isNonRealtime != (header.nonRealtime != 0))
+        {
+            isNonRealtime = header.nonRealtime != 0;
+            instance->setNonRealtime (isNonRealtime);
+        }
+
+        const auto startTicks = Time::getHighResolutionTicks();
+
+        if (header.bypassed != 0)
+            instance->processBlockBypassed (block, midi);
+        else
+            instance->processBlock (block, midi);
+
+        header.processingSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+        for (int c = 0; c < numChannels; ++c)
+            FloatVectorOperations::copy (sharedBlock->getChannel (c), block.getReadPointer (c), numSamples);
+
+        sharedBlock->writeMidi (midi, 0, numSamples);
+
+        int numParameterChanges = 0;
+
+        if (anyParameterChanged.exchange (false))
+        {
+            for (int i = 0; i < numParameters; ++i)
+            {
+                if (numParameterChanges >= SharedAudioBlock::Header::maxParameterChanges)
+                {
+                    anyParameterChanged = true;
+                    break;
+                }
+
+                if (changedParameters[(size_t) i].exchange (false))
+                    header.parameterChanges[numParameterChanges++] = { (int32) i, parameters.getUnchecked (i)->getValue() };
+            }
+        }
+
+        header.numParameterChanges = numParameterChanges;
+    }
+
+    //==============================================================================
+    void audioProcessorParameterChanged (AudioProcessor*, int parameterIndex, float) override
+    {
+        if (isPositiveAndBelow (parameterIndex, numParameters))
+        {
+            changedParameters[(size_t) parameterIndex] = true;
+            anyParameterChanged = true;
+        }
+    }
+
+    void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override {}
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginHostSlaveProcess)
+};
+
+bool PluginManager::startChildProcessPluginHost (const String& commandLine)
+{
+    auto slave = std::make_unique<PluginHostSlaveProcess>();
+
+    if (slave->initialiseFromCommandLine (commandLine, sandbox::commandLineUID))
+    {
+        slave.release(); // allow the slave object to stay alive - it'll handle its own deletion.
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,287 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    A block of memory shared between two processes, used to pass audio, MIDI and
+    parameter changes to and from a plugin running in a separate process.
+
+    The engine writes a request and increments the request number, then the worker
+    processes it and sets the reply number to match. Neither side takes a lock: each
+    waits for the other's counter to change, spinning briefly and then sleeping on a
+    futex on Linux, or yielding on other platforms.
+
+    Only one request can be in flight. If the worker doesn't reply in time, the engine
+    can't send another request until the late reply has arrived, so a slow or hung
+    plugin can't write in to a block the engine is using.
+
+    This is a single slot rather than a ring of blocks. A ring would let the worker fall
+    a few blocks behind without any being dropped, but every slot it could fall behind by
+    adds another block of latency. With one slot the worker has exactly one block period
+    to reply, which costs SandboxedPluginInstance one block of latency.
+
+    Shared memory is only implemented on Linux and macOS. On other platforms create()
+    and open() always return nullptr.
+*/
+class SharedAudioBlock
+{
+public:
+    /** Returns true if shared memory can be used on this platform. */
+    static bool isSupported();
+
+    /** Creates a new shared block with a unique name.
+        Returns nullptr if the memory couldn't be created.
+    */
+    static std::unique_ptr<SharedAudioBlock> create (int maxNumChannels, int maxBlockSize);
+
+    /** Opens a block created by another process.
+        Returns nullptr if the memory couldn't be opened.
+    */
+    static std::unique_ptr<SharedAudioBlock> open (const juce::String& name);
+
+    /** Destructor. */
+    ~SharedAudioBlock();
+
+    /** Removes the name so no other process can open the block.
+        Processes which already have it open can carry on using it, and the memory is
+        freed once they've all closed it. Call this once the other process has opened
+        the block so it isn't left behind if either process crashes.
+    */
+    void unlink();
+
+    /** Returns the name to pass to the other process. */
+    const juce::String& getName() const noexcept            { return name; }
+
+    //==============================================================================
+    struct ParameterChange
+    {
+        juce::int32 index;
+        float value;
+    };
+
+    /** The part of the shared memory before the audio data. */
+    struct Header
+    {
+        static constexpr int maxMidiBytes = 16384;
+        static constexpr int maxParameterChanges = 512;
+
+        std::atomic<juce::uint32> requestNumber { 0 }, replyNumber { 0 };
+        juce::int32 maxNumChannels = 0, maxBlockSize = 0;
+
+        juce::int32 numChannels = 0, numSamples = 0;
+        juce::int32 bypassed = 0, nonRealtime = 0;
+        juce::AudioPlayHead::CurrentPositionInfo position;
+        juce::int32 hasPosition = 0;
+
+        double processingSeconds = 0.0;     /**< Set by the worker to the time it spent processing. */
+        juce::int64 replyTicks = 0;         /**< Set by sendReply() to Time::getHighResolutionTicks(), which all processes share. */
+
+        juce::int32 numMidiBytes = 0;
+        juce::uint8 midiData[maxMidiBytes];
+
+        juce::int32 numParameterChanges = 0;
+        ParameterChange parameterChanges[maxParameterChanges];
+    };
+
+    Header& getHeader() noexcept                            { return *header; }
+    int getMaxNumChannels() const noexcept                  { return header->maxNumChannels; }
+    int getMaxBlockSize() const noexcept                    { return header->maxBlockSize; }
+
+    /** Returns a channel of the audio data. */
+    float* getChannel (int channel) noexcept;
+
+    /** Copies a MidiBuffer in to the header, returning false if it didn't fit. */
+    bool writeMidi (const juce::MidiBuffer&, int startSample, int numSamples) noexcept;
+
+    /** Adds the header's MIDI to a buffer, offsetting the events by the given number of samples. */
+    void readMidi (juce::MidiBuffer&, int sampleOffset) const;
+
+    //==============================================================================
+    /** Returns true if a request has been sent which hasn't been replied to yet. */
+    bool isWaitingForReply() const noexcept;
+
+    /** Signals the worker that a request is ready and returns its number. */
+    juce::uint32 sendRequest() noexcept;
+
+    /** Waits for the reply to a request, returning false if it timed out. */
+    bool waitForReply (juce::uint32 requestNumber, double timeoutMs) noexcept;
+
+    /** Called by the worker to wait for a request after the given one.
+        Returns false if it timed out.
+    */
+    bool waitForRequest (juce::uint32 lastRequestNumber, double timeoutMs) noexcept;
+
+    /** Called by the worker once it's finished with a request. */
+    void sendReply (juce::uint32 requestNumber) noexcept;
+
+private:
+    juce::String name;
+    void* data = nullptr;
+    size_t size = 0;
+    Header* header = nullptr;
+    bool isOwner = false;
+
+    SharedAudioBlock (const juce::String&, void*, size_t, bool isOwner);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedAudioBlock)
+};
+
+
+//==============================================================================
+/**
+    An AudioPluginInstance which runs the real plugin in a separate process.
+
+    The worker process is launched from the current executable in the same way as the
+    plugin scanner, so the app must call PluginManager::startChildProcessPluginHost()
+    with its command line at startup.
+
+    Control calls such as preparing and getting or setting the state are sent as
+    messages and block until the worker replies. Audio and MIDI are passed through a
+    SharedAudioBlock. Each block is sent to the worker and its output is collected at the
+    start of the next one, so the audio thread never waits for the worker but a block of
+    latency is added to the plugin's own, e.g. 5.8ms for 256 samples at 44.1kHz. When
+    rendering, the next block waits for the worker instead.
+
+    On platforms where SharedAudioBlock::isSupported() is false, create() fails with
+    an error message rather than falling back to running the plugin in-process.
+
+    If the worker hasn't replied by the next block, that block is output as silence and
+    counted in the Statistics. If the worker crashes, the instance outputs silence from
+    then on and hasCrashed() returns true.
+
+    The plugin's editor can't be shown from another process so this has no editor.
+    Parameter text is generated from the normalised values rather than by the plugin.
+*/
+class SandboxedPluginInstance  : public juce::AudioPluginInstance
+{
+public:
+    /** Launches a worker process and creates the plugin in it.
+        Returns nullptr and sets the error message if it failed.
+    */
+    static std::unique_ptr<SandboxedPluginInstance> create (const juce::PluginDescription&,
+                                                            double sampleRate, int blockSize,
+                                                            juce::String& errorMessage);
+
+    /** Destructor. This shuts down the worker process. */
+    ~SandboxedPluginInstance() override;
+
+    /** Returns true if the worker process has crashed or been closed. */
+    bool hasCrashed() const noexcept;
+
+    //==============================================================================
+    /** Timings of the blocks sent to the worker process. */
+    struct Statistics
+    {
+        int numBlocks = 0;                  /**< The number of blocks processed. */
+        int numLateBlocks = 0;              /**< The number of blocks output as silence because the worker was late. */
+        double averageRoundTripMs = 0.0;    /**< The average time from sending a block to the worker replying. */
+        double averageOverheadMs = 0.0;     /**< The average round trip minus the time the plugin spent processing. */
+        double maxOverheadMs = 0.0;         /**< The largest overhead of a single block. */
+    };
+
+    /** Returns the timings since this was created or resetStatistics() was called. */
+    Statistics getStatistics() const;
+
+    /** Clears the timings. */
+    void resetStatistics();
+
+    //==============================================================================
+    /** @internal */
+    void fillInPluginDescription (juce::PluginDescription&) const override;
+    /** @internal */
+    const juce::String getName() const override;
+    /** @internal */
+    void prepareToPlay (double sampleRate, int blockSize) override;
+    /** @internal */
+    void releaseResources() override;
+    /** @internal */
+    void reset() override;
+    /** @internal */
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    /** @internal */
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    /** @internal */
+    double getTailLengthSeconds() const override;
+    /** @internal */
+    bool acceptsMidi() const override;
+    /** @internal */
+    bool producesMidi() const override;
+    /** @internal */
+    juce::AudioProcessorEditor* createEditor() override     { return nullptr; }
+    /** @internal */
+    bool hasEditor() const override                         { return false; }
+    /** @internal */
+    int getNumPrograms() override                           { return 1; }
+    /** @internal */
+    int getCurrentProgram() override                        { return 0; }
+    /** @internal */
+    void setCurrentProgram (int) override                   {}
+    /** @internal */
+    const juce::String getProgramName (int) override        { return {}; }
+    /** @internal */
+    void changeProgramName (int, const juce::String&) override {}
+    /** @internal */
+    void getStateInformation (juce::MemoryBlock&) override;
+    /** @internal */
+    void setStateInformation (const void*, int) override;
+
+private:
+    //==============================================================================
+    class WorkerConnection;
+    class Parameter;
+
+    std::unique_ptr<WorkerConnection> connection;
+    std::unique_ptr<SharedAudioBlock> sharedBlock;
+    juce::PluginDescription description;
+    double tailLengthSeconds = 0.0;
+    bool pluginAcceptsMidi = false, pluginProducesMidi = false;
+
+    juce::Array<Parameter*> sandboxedParameters;
+    std::atomic<bool> parametersChanged { false };
+    int pluginLatencySamples = 0;
+
+    // The worker's output is held here until it's a block old
+    juce::AudioBuffer<float> delayedOutput;
+    juce::MidiBuffer delayedMidi, remainingMidi, midiOutput;
+    int numDelayedSamples = 0, numSamplesInFlight = 0;
+    juce::uint32 lastRequestNumber = 0;
+    juce::int64 requestStartTicks = 0;
+
+    std::atomic<int> numBlocks { 0 }, numLateBlocks { 0 };
+    std::atomic<juce::int64> totalRoundTripMicroseconds { 0 }, totalOverheadMicroseconds { 0 }, maxOverheadMicroseconds { 0 };
+
+    SandboxedPluginInstance (std::unique_ptr<WorkerConnection>, const juce::PluginDescription&, const juce::XmlElement& info);
+
+    bool openSharedBlock (int maxBlockSize);
+    void resetDelayedOutput();
+    std::unique_ptr<juce::XmlElement> sendToWorker (juce::XmlElement&, int timeoutMs);
+    void updateParameterValues (const juce::String& values);
+
+    void processInWorker (juce::AudioBuffer<float>&, juce::MidiBuffer&, bool bypassed);
+    void processChunk (juce::AudioBuffer<float>&, int startSample, int numSamples,
+                       const juce::MidiBuffer& midiIn, bool bypassed);
+    void sendChunk (const juce::AudioBuffer<float>&, int startSample, int numSamples,
+                    const juce::MidiBuffer& midiIn, bool bypassed);
+    void receiveReply();
+    void appendSilence (int numSamples);
+    void popDelayedOutput (juce::AudioBuffer<float>&, int startSample, int numSamples);
+
+   #if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+    friend class PluginSandboxTests;
+    friend struct SandboxTestInstance;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SandboxedPluginInstance)
+};
+
+} // namespace tracktion_engine
@@ -0,0 +1,475 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace sandbox_test_utilities
+{
+    /** Stands in for the worker process, applying a gain set by parameter 0 and echoing any MIDI. */
+    struct GainWorker  : public juce::Thread
+    {
+        GainWorker (const juce::String& blockName)
+            : juce::Thread ("GainWorker"), block (SharedAudioBlock::open (blockName))
+        {
+            startThread (10);
+        }
+
+        ~GainWorker() override
+        {
+            stopThread (1000);
+        }
+
+        void run() override
+        {
+            auto& header = block->getHeader();
+            auto lastRequestNumber = header.replyNumber.load();
+
+            while (! threadShouldExit())
+            {
+                if (! block->waitForRequest (lastRequestNumber, 100.0))
+                    continue;
+
+                lastRequestNumber = header.requestNumber.load();
+
+                if (delayMs > 0)
+                    juce::Thread::sleep (delayMs);
+
+                bool gainChanged = false;
+
+                for (int i = 0; i < header.numParameterChanges; ++i)
+                {
+                    if (header.parameterChanges[i].index == 0)
+                    {
+                        gain = header.parameterChanges[i].value;
+                        gainChanged = true;
+                    }
+                }
+
+                for (int c = 0; c < header.numChannels; ++c)
+                    juce::FloatVectorOperations::multiply (block->getChannel (c), gain, header.numSamples);
+
+                // Echo the parameter change back as if the plugin had changed it
+                header.numParameterChanges = gainChanged ? 1 : 0;
+                header.processingSeconds = 0.0;
+                block->sendReply (lastRequestNumber);
+            }
+        }
+
+        std::unique_ptr<SharedAudioBlock> block;
+        std::atomic<int> delayMs { 0 };
+        float gain = 1.0f;
+    };
+}
+
+//==============================================================================
+/** A stereo SandboxedPluginInstance with a gain parameter, connected to a GainWorker rather
+    than a worker process. Control messages fail but the audio goes through the shared block
+    in the same way.
+*/
+struct SandboxTestInstance
+{
+    SandboxTestInstance (double sampleRate, int blockSize)
+    {
+        juce::XmlElement info ("INFO");
+        info.setAttribute ("numInputs", 2);
+        info.setAttribute ("numOutputs", 2);
+        info.setAttribute ("acceptsMidi", true);
+        info.setAttribute ("producesMidi", true);
+
+        auto gainParam = info.createNewChildElement ("PARAM");
+        gainParam->setAttribute ("name", "Gain");
+        gainParam->setAttribute ("default", 1.0);
+        gainParam->setAttribute ("value", 1.0);
+
+        instance.reset (new SandboxedPluginInstance (std::make_unique<SandboxedPluginInstance::WorkerConnection>(), {}, info));
+        instance->setRateAndBufferSizeDetails (sampleRate, blockSize);
+        instance->sharedBlock = SharedAudioBlock::create (2, blockSize);
+
+        if (instance->sharedBlock != nullptr)
+        {
+            worker = std::make_unique<sandbox_test_utilities::GainWorker> (instance->sharedBlock->getName());
+            instance->sharedBlock->unlink();
+            instance->resetDelayedOutput();
+        }
+    }
+
+    std::unique_ptr<SandboxedPluginInstance> instance;
+    std::unique_ptr<sandbox_test_utilities::GainWorker> worker;
+};
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class PluginSandboxTests    : public juce::UnitTest
+{
+public:
+    PluginSandboxTests()
+        : juce::UnitTest ("PluginSandbox", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        if (! SharedAudioBlock::isSupported())
+            return;
+
+        runSharedBlockTests();
+        runInstanceTests();
+    }
+
+private:
+    void runSharedBlockTests()
+    {
+        using namespace sandbox_test_utilities;
+
+        auto block = SharedAudioBlock::create (2, 512);
+        expect (block != nullptr);
+
+        if (block == nullptr)
+            return;
+
+        GainWorker worker (block->getName());
+        expect (worker.block != nullptr);
+        block->unlink();
+        expect (SharedAudioBlock::open (block->getName()) == nullptr);
+
+        auto& header = block->getHeader();
+
+        beginTest ("Audio and parameters make the round trip");
+        {
+            for (int c = 0; c < 2; ++c)
+                juce::FloatVectorOperations::fill (block->getChannel (c), 1.0f, 512);
+
+            header.numChannels = 2;
+            header.numSamples = 512;
+            header.numParameterChanges = 1;
+            header.parameterChanges[0] = { 0, 0.5f };
+
+            auto requestNumber = block->sendRequest();
+            expect (block->waitForReply (requestNumber, 1000.0));
+            expect (! block->isWaitingForReply());
+
+            expectEquals (block->getChannel (0)[0], 0.5f);
+            expectEquals (block->getChannel (1)[511], 0.5f);
+            expectEquals ((int) header.numParameterChanges, 1);
+        }
+
+        beginTest ("MIDI is offset by the start of the chunk");
+        {
+            juce::MidiBuffer midiIn;
+            midiIn.addEvent (juce::MidiMessage::noteOn (1, 60, 1.0f), 10);
+            midiIn.addEvent (juce::MidiMessage::noteOff (1, 60), 300);
+            midiIn.addEvent (juce::MidiMessage::noteOn (1, 62, 1.0f), 600);
+
+            expect (block->writeMidi (midiIn, 256, 256));
+
+            juce::MidiBuffer midiOut;
+            block->readMidi (midiOut, 256);
+
+            expectEquals (midiOut.getNumEvents(), 1);
+
+            for (auto m : midiOut)
+            {
+                expectEquals (m.samplePosition, 300);
+                expect (m.getMessage().isNoteOff());
+            }
+        }
+
+        beginTest ("A late worker doesn't get another request until it's replied");
+        {
+            worker.delayMs = 50;
+            header.numParameterChanges = 0;
+
+            auto requestNumber = block->sendRequest();
+            expect (! block->waitForReply (requestNumber, 1.0));
+            expect (block->isWaitingForReply());
+
+            expect (block->waitForReply (requestNumber, 5000.0));
+            expect (! block->isWaitingForReply());
+            worker.delayMs = 0;
+        }
+    }
+
+    void runInstanceTests()
+    {
+        const int blockSize = 256;
+        const double sampleRate = 44100.0;
+
+        SandboxTestInstance testInstance (sampleRate, blockSize);
+        auto& instance = testInstance.instance;
+        expect (testInstance.worker != nullptr);
+
+        if (testInstance.worker == nullptr)
+            return;
+
+        auto& worker = *testInstance.worker;
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+
+        auto processBlock = [&] (int numSamples, float inputValue)
+        {
+            buffer.setSize (2, numSamples, false, false, true);
+
+            for (int c = 0; c < 2; ++c)
+                juce::FloatVectorOperations::fill (buffer.getWritePointer (c), inputValue, numSamples);
+
+            instance->processBlock (buffer, midi);
+        };
+
+        beginTest ("Output is a block behind the input");
+        {
+            instance->setNonRealtime (true);
+            expectEquals (instance->getLatencySamples(), blockSize);
+
+            juce::AudioBuffer<float> input (2, 2048), output (2, 2048);
+
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                for (int c = 0; c < 2; ++c)
+                    input.setSample (c, i, (float) (i + 1) / input.getNumSamples() * (c == 0 ? 1.0f : -1.0f));
+
+            int start = 0;
+
+            for (int numSamples : { 256, 100, 256, 37, 200, 256, 1, 255, 256, 256, 175 })
+            {
+                buffer.setSize (2, numSamples, false, false, true);
+
+                for (int c = 0; c < 2; ++c)
+                    buffer.copyFrom (c, 0, input, c, start, numSamples);
+
+                instance->processBlock (buffer, midi);
+
+                for (int c = 0; c < 2; ++c)
+                    output.copyFrom (c, start, buffer, c, 0, numSamples);
+
+                start += numSamples;
+            }
+
+            expectEquals (start, output.getNumSamples());
+            expectEquals (output.getMagnitude (0, blockSize), 0.0f);
+
+            juce::AudioBuffer<float> delayedInput (2, output.getNumSamples() - blockSize);
+
+            for (int c = 0; c < 2; ++c)
+                delayedInput.copyFrom (c, 0, input, c, 0, delayedInput.getNumSamples());
+
+            juce::AudioBuffer<float> delayedOutput (output.getArrayOfWritePointers(), 2, blockSize, delayedInput.getNumSamples());
+            expectEquals (audio_test_utilities::getMaxDifference (delayedInput, delayedOutput), 0.0f);
+        }
+
+        beginTest ("MIDI is a block behind the input");
+        {
+            midi.clear();
+            midi.addEvent (juce::MidiMessage::noteOn (1, 60, 1.0f), 10);
+            processBlock (blockSize, 0.0f);
+            expect (midi.isEmpty());
+
+            processBlock (blockSize, 0.0f);
+            expectEquals (midi.getNumEvents(), 1);
+
+            for (auto m : midi)
+            {
+                expectEquals (m.samplePosition, 10);
+                expect (m.getMessage().isNoteOn());
+            }
+
+            midi.clear();
+        }
+
+        beginTest ("Parameter changes make the round trip");
+        {
+            instance->getParameters()[0]->setValue (0.5f);
+            processBlock (blockSize, 1.0f);
+            processBlock (blockSize, 1.0f);
+
+            expectEquals (buffer.getSample (0, 0), 0.5f);
+            expectEquals (worker.gain, 0.5f);
+            expectEquals (instance->getParameters()[0]->getValue(), 0.5f);
+        }
+
+        beginTest ("Statistics");
+        {
+            instance->resetStatistics();
+            expectEquals (instance->getStatistics().numBlocks, 0);
+
+            for (int i = 0; i < 10; ++i)
+                processBlock (blockSize, 1.0f);
+
+            auto stats = instance->getStatistics();
+            expectEquals (stats.numBlocks, 10);
+            expectEquals (stats.numLateBlocks, 0);
+            expectGreaterOrEqual (stats.averageRoundTripMs, stats.averageOverheadMs);
+            expectGreaterOrEqual (stats.maxOverheadMs, stats.averageOverheadMs);
+
+            // Chunks larger than the shared block are split up
+            processBlock (3 * blockSize, 1.0f);
+            expectEquals (instance->getStatistics().numBlocks, 13);
+        }
+
+        beginTest ("A late worker doesn't hold up the audio thread");
+        {
+            instance->setNonRealtime (false);
+            instance->resetStatistics();
+            worker.delayMs = 100;
+
+            const double blockMs = 1000.0 * blockSize / sampleRate;
+            double maxProcessMs = 0.0;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+                processBlock (blockSize, 1.0f);
+                maxProcessMs = std::max (maxProcessMs, 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks));
+            }
+
+            // The first block was sent but not returned in time and the rest couldn't be sent
+            expectEquals (buffer.getMagnitude (0, blockSize), 0.0f);
+            expectLessThan (maxProcessMs, blockMs / 2.0);
+            expectEquals (instance->getStatistics().numLateBlocks, 4);
+
+            // It catches up once the late reply arrives
+            worker.delayMs = 0;
+            instance->setNonRealtime (true);
+            processBlock (blockSize, 1.0f);
+            processBlock (blockSize, 1.0f);
+            expectEquals (buffer.getMagnitude (0, blockSize), 0.5f);
+        }
+
+        beginTest ("A crashed worker outputs silence");
+        {
+            instance->connection->crashed = true;
+            expect (instance->hasCrashed());
+
+            midi.addEvent (juce::MidiMessage::noteOn (1, 60, 1.0f), 10);
+            processBlock (blockSize, 1.0f);
+            expectEquals (buffer.getMagnitude (0, blockSize), 0.0f);
+            expect (midi.isEmpty());
+        }
+    }
+};
+
+static PluginSandboxTests pluginSandboxTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class PluginSandboxBenchmarks   : public juce::UnitTest
+{
+public:
+    PluginSandboxBenchmarks()
+        : juce::UnitTest ("PluginSandbox Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        if (! SharedAudioBlock::isSupported())
+            return;
+
+        for (int blockSize : { 64, 256, 1024 })
+            runRoundTrip (blockSize, 10000);
+
+        for (int blockSize : { 64, 256, 1024 })
+            runInstance (blockSize, 5.0);
+    }
+
+private:
+    void runRoundTrip (int blockSize, int numBlocks)
+    {
+        using namespace sandbox_test_utilities;
+
+        beginTest ("Round trip: " + juce::String (blockSize) + " samples");
+        {
+            auto block = SharedAudioBlock::create (2, blockSize);
+            GainWorker worker (block->getName());
+            auto& header = block->getHeader();
+            header.numChannels = 2;
+            header.numSamples = blockSize;
+
+            std::vector<double> roundTripsUs;
+            roundTripsUs.reserve ((size_t) numBlocks);
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                expect (block->waitForReply (block->sendRequest(), 1000.0));
+                roundTripsUs.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6);
+            }
+
+            benchmark_utilities::printDistribution ("Round trip", roundTripsUs, "us");
+        }
+    }
+
+    /** Plays audio through a SandboxedPluginInstance at the rate an audio device would call it,
+        measuring how long the audio thread spends in processBlock and the latency added.
+    */
+    void runInstance (int blockSize, double durationSeconds)
+    {
+        const double sampleRate = 44100.0;
+
+        beginTest ("Instance: " + juce::String (blockSize) + " samples");
+        {
+            SandboxTestInstance testInstance (sampleRate, blockSize);
+            auto& instance = *testInstance.instance;
+            expect (testInstance.worker != nullptr);
+
+            if (testInstance.worker == nullptr)
+                return;
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            const int numBlocks = (int) (durationSeconds * sampleRate / blockSize);
+            const double blockMs = 1000.0 * blockSize / sampleRate;
+
+            std::vector<double> processUs;
+            processUs.reserve ((size_t) numBlocks);
+
+            instance.setNonRealtime (false);
+            instance.resetStatistics();
+            auto nextBlockMs = juce::Time::getMillisecondCounterHiRes();
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                buffer.clear();
+                const auto start = juce::Time::getHighResolutionTicks();
+                instance.processBlock (buffer, midi);
+                processUs.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6);
+
+                nextBlockMs += blockMs;
+
+                while (juce::Time::getMillisecondCounterHiRes() < nextBlockMs)
+                    juce::Thread::yield();
+            }
+
+            const auto stats = instance.getStatistics();
+            benchmark_utilities::printValue ("Added latency", juce::String (instance.getLatencySamples()) + " samples, "
+                                                              + juce::String (1000.0 * instance.getLatencySamples() / sampleRate, 2) + " ms");
+            benchmark_utilities::printDistribution ("processBlock", processUs, "us");
+            benchmark_utilities::printValue ("Round trip", "mean: " + juce::String (stats.averageRoundTripMs * 1000.0, 1) + "us"
+                                                           + ", overhead mean: " + juce::String (stats.averageOverheadMs * 1000.0, 1) + "us"
+                                                           + ", overhead max: " + juce::String (stats.maxOverheadMs * 1000.0, 1) + "us");
+            benchmark_utilities::printValue ("Late blocks", juce::String (stats.numLateBlocks) + " of " + juce::String (stats.numBlocks));
+            expectEquals (stats.numBlocks, numBlocks);
+        }
+    }
+};
+
+static PluginSandboxBenchmarks pluginSandboxBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
@@ -130,6 +130,277 @@ private:
 
 static InternalPluginTests internalPluginTests;
 
+
+//==============================================================================
+//==============================================================================
+class RealTimeStateSwapTests : public UnitTest
+{
+public:
+    RealTimeStateSwapTests() : UnitTest ("RealTimeStateSwap", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        runStateSwapTests();
+        runPluginTests();
+    }
+
+private:
+    struct Counters
+    {
+        std::atomic<int> numLive { 0 };
+        std::atomic<Thread::ThreadID> readerThreadID { nullptr };
+        std::atomic<bool> deletedOnReaderThread { false };
+    };
+
+    struct TestState
+    {
+        TestState (int v, Counters& c) : version (v), counters (c)     { ++counters.numLive; }
+
+        ~TestState()
+        {
+            --counters.numLive;
+
+            if (Thread::getCurrentThreadId() == counters.readerThreadID.load())
+                counters.deletedOnReaderThread = true;
+        }
+
+        const int version;
+        Counters& counters;
+    };
+
+    void runStateSwapTests()
+    {
+        beginTest ("States are passed to the reader in order and deleted by the writer");
+        {
+            Counters counters;
+            const int numStates = 10000;
+
+            {
+                RealTimeStateSwap<TestState> stateSwap;
+                std::atomic<bool> finished { false };
+                int lastVersion = -1, numAcquired = 0;
+                bool versionsIncrease = true;
+
+                std::thread reader ([&]
+                {
+                    counters.readerThreadID = Thread::getCurrentThreadId();
+
+                    auto acquire = [&]
+                    {
+                        SCOPED_REALTIME_CHECK
+
+                        if (stateSwap.acquireLatest())
+                        {
+                            const auto version = stateSwap.getCurrent()->version;
+                            versionsIncrease = versionsIncrease && version > lastVersion;
+                            lastVersion = version;
+                            ++numAcquired;
+                        }
+                    };
+
+                    while (! finished)
+                        acquire();
+
+                    acquire();
+                });
+
+                for (int i = 0; i < numStates; ++i)
+                    stateSwap.publish (std::make_unique<TestState> (i, counters));
+
+                finished = true;
+                reader.join();
+
+                expect (versionsIncrease);
+                expectEquals (lastVersion, numStates - 1);
+                expectGreaterThan (numAcquired, 0);
+                expect (counters.numLive <= 3, "Only the current and retired states should be alive");
+            }
+
+            expectEquals (counters.numLive.load(), 0);
+            expect (! counters.deletedOnReaderThread, "States should never be deleted by the reader");
+        }
+    }
+
+    //==============================================================================
+    void runPluginTests()
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+
+        beginTest ("Equaliser re-initialised while processing");
+        {
+            testStateChangesWhileProcessing (*edit, EqualiserPlugin::xmlTypeName, [] (Plugin& p, int i)
+            {
+                p.baseClassInitialise ({ 0.0, (i % 2) == 0 ? 48000.0 : 44100.0, 512 });
+                p.baseClassDeinitialise();
+            });
+        }
+
+        beginTest ("Equaliser re-initialised from other threads while processing");
+        {
+            testStateChangesWhileProcessing (*edit, EqualiserPlugin::xmlTypeName, [] (Plugin& p, int i)
+            {
+                // e.g. a render thread initialising the plugin, alternating with the message thread
+                auto initialise = [&p, i] { p.baseClassInitialise ({ 0.0, (i % 2) == 0 ? 48000.0 : 44100.0, 512 }); };
+
+                if ((i % 2) == 0)
+                    std::thread (initialise).join();
+                else
+                    initialise();
+
+                p.baseClassDeinitialise();
+            });
+        }
+
+        beginTest ("4OSC voice changes while processing");
+        {
+            testStateChangesWhileProcessing (*edit, FourOscPlugin::xmlTypeName, [] (Plugin& p, int i)
+            {
+                p.state.setProperty (IDs::voiceMode, (i % 5) == 0 ? 0 : 2, nullptr);
+                p.state.setProperty (IDs::voices, 1 + (i % 16), nullptr);
+            });
+        }
+
+        beginTest ("Sampler sound changes while processing");
+        {
+            auto sinFile = tracktion_graph::test_utilities::getSinFile<WavAudioFormat> (44100.0, 1.0);
+            Plugin::Ptr lastPlugin;
+
+            testStateChangesWhileProcessing (*edit, SamplerPlugin::xmlTypeName, [&] (Plugin& p, int i)
+            {
+                auto& sampler = dynamic_cast<SamplerPlugin&> (p);
+                lastPlugin = &p;
+
+                if (sampler.getNumSounds() < 4)
+                    sampler.addSound (sinFile->getFile().getFullPathName(), "sin", 0.0, 0.0, 0.0f);
+                else
+                    sampler.removeSound (0);
+
+                // Normally this happens asynchronously
+                sampler.loadPendingSounds();
+
+                BigInteger keysDown;
+                keysDown.setBit (60 + (i % 12));
+                sampler.playNotes (keysDown);
+            });
+
+            if (auto sampler = dynamic_cast<SamplerPlugin*> (lastPlugin.get()))
+                expect (sampler->getSoundFile (0).isValid());
+        }
+
+       #if TRACKTION_AIR_WINDOWS
+        beginTest ("AirWindows preset loads while processing");
+        {
+            Plugin::Ptr lastPlugin;
+
+            testStateChangesWhileProcessing (*edit, AirWindowsADClip7::xmlTypeName, [&] (Plugin& p, int i)
+            {
+                lastPlugin = &p;
+                p.flushPluginStateToValueTree();
+
+                MemoryBlock chunk;
+
+                {
+                    MemoryOutputStream os (chunk, false);
+                    Base64::convertFromBase64 (os, p.state[IDs::state].toString());
+                }
+
+                auto values = static_cast<float*> (chunk.getData());
+
+                for (size_t j = 0; j < chunk.getSize() / sizeof (float); ++j)
+                    values[j] = (i % 2) == 0 ? 0.25f : 0.75f;
+
+                auto preset = p.state.createCopy();
+                preset.setProperty (IDs::state, Base64::toBase64 (chunk.getData(), chunk.getSize()), nullptr);
+                p.restorePluginStateFromValueTree (preset);
+            });
+
+            // The parameters should have the values of the last preset even if the audio
+            // thread was processing when it was loaded
+            if (auto airWindows = dynamic_cast<AirWindowsPlugin*> (lastPlugin.get()))
+                for (auto param : airWindows->parameters)
+                    expectWithinAbsoluteError (param->getCurrentValue(), 0.75f, 0.0001f);
+        }
+       #endif
+    }
+
+    /** Processes the plugin on a separate thread, in real-time checked blocks, while the
+        state is repeatedly changed on this thread.
+    */
+    void testStateChangesWhileProcessing (Edit& edit, const String& pluginType, std::function<void (Plugin&, int)> changeState)
+    {
+        auto plugin = edit.getPluginCache().createNewPlugin (pluginType, {});
+        expect (plugin != nullptr);
+
+        if (plugin == nullptr)
+            return;
+
+        const int blockSize = 512;
+        plugin->baseClassInitialise ({ 0.0, 44100.0, blockSize });
+
+        std::atomic<bool> finished { false };
+        std::atomic<int> numBlocks { 0 };
+        bool outputIsFinite = true;
+
+        std::thread audioThread ([&]
+        {
+            AudioBuffer<float> buffer (2, blockSize);
+            MidiMessageArray midi;
+            const auto midiSourceID = MidiMessageArray::createUniqueMPESourceID();
+            Random r;
+
+            while (! finished)
+            {
+                const int blockNum = numBlocks;
+                midi.clear();
+
+                if ((blockNum % 8) == 0)
+                    midi.addMidiMessage (MidiMessage::noteOn (1, 60 + (blockNum % 12), 0.8f), 0.0, midiSourceID);
+                else if ((blockNum % 8) == 4)
+                    midi.addMidiMessage (MidiMessage::allNotesOff (1), 0.0, midiSourceID);
+
+                for (int c = 0; c < buffer.getNumChannels(); ++c)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample (c, i, r.nextFloat() * 0.5f - 0.25f);
+
+                {
+                    SCOPED_REALTIME_CHECK
+                    plugin->applyToBuffer (PluginRenderContext (&buffer, AudioChannelSet::stereo(), 0, blockSize,
+                                                                &midi, 0.0, blockNum * blockSize / 44100.0,
+                                                                true, false, false, false));
+                }
+
+                for (int c = 0; c < buffer.getNumChannels(); ++c)
+                    for (int i = 0; i < blockSize; ++i)
+                        outputIsFinite = outputIsFinite && std::isfinite (buffer.getSample (c, i));
+
+                ++numBlocks;
+            }
+        });
+
+        for (int i = 0; i < 100; ++i)
+        {
+            changeState (*plugin, i);
+            Thread::sleep (1);
+        }
+
+        // Make sure the last change has been picked up
+        const int lastBlock = numBlocks + 2;
+
+        while (numBlocks < lastBlock)
+            Thread::yield();
+
+        finished = true;
+        audioThread.join();
+
+        expect (outputIsFinite);
+        plugin->baseClassDeinitialise();
+    }
+};
+
+static RealTimeStateSwapTests realTimeStateSwapTests;
+
 #endif // TRACKTION_UNIT_TESTS
 
 }
@@ -20,10 +20,10 @@ namespace
     }
 }
 
-struct PluginList::ObjectList  : public ValueTreeObjectList<Plugin>
+struct PluginList::ObjectList  : public IndexedValueTreeObjectList<Plugin>
 {
     ObjectList (PluginList& l, const juce::ValueTree& parentTree)
-        : ValueTreeObjectList<Plugin> (parentTree), list (l)
+        : IndexedValueTreeObjectList<Plugin> (parentTree), list (l)
     {
         // NB: rebuildObjects() is called after construction so that the edit has a valid
         // list while they're being created
@@ -137,7 +137,10 @@ Plugin* PluginList::operator[] (int index) const
 
 bool PluginList::contains (const Plugin* plugin) const
 {
-    return indexOf (plugin) >= 0;
+    if (list == nullptr || plugin == nullptr)
+        return false;
+
+    return list->getObjectFor (plugin->state) == plugin;
 }
 
 int PluginList::indexOf (const Plugin* plugin) const
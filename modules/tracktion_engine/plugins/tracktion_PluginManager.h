@@ -26,6 +26,12 @@ public:
     //==============================================================================
     static bool startChildProcessPluginScan (const juce::String& commandLine);
 
+    /** Call this at startup, in the same way as startChildProcessPluginScan(), if any
+        ExternalPlugins are to be run in a separate process.
+        @see ExternalPlugin::setRunInSeparateProcess
+    */
+    static bool startChildProcessPluginHost (const juce::String& commandLine);
+
     bool areGUIsLockedByDefault();
     void setGUIsLockedByDefault (bool);
 
@@ -0,0 +1,62 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace plugin_test_utilities
+{
+    /** Plays the given notes from the start and renders the plugin's output in blocks.
+        If playInRealTime is set, the message loop is run between blocks so they're
+        processed no faster than they'd be played.
+    */
+    inline juce::AudioBuffer<float> renderNotes (Plugin& plugin, const juce::Array<int>& notes,
+                                                 double sampleRate, int blockSize, int numSamples,
+                                                 bool isRendering = true, bool playInRealTime = false)
+    {
+        plugin.baseClassInitialise ({ 0.0, sampleRate, blockSize });
+
+        juce::AudioBuffer<float> output (2, numSamples);
+        juce::AudioBuffer<float> block (2, blockSize);
+        MidiMessageArray midi;
+        const auto midiSourceID = MidiMessageArray::createUniqueMPESourceID();
+
+        for (auto note : notes)
+            midi.addMidiMessage (juce::MidiMessage::noteOn (1, note, 1.0f), 0.0, midiSourceID);
+
+        for (int pos = 0; pos < numSamples; pos += blockSize)
+        {
+            const int numThisTime = std::min (blockSize, numSamples - pos);
+            block.clear();
+
+            plugin.applyToBuffer (PluginRenderContext (&block, juce::AudioChannelSet::stereo(), 0, numThisTime,
+                                                       &midi, 0.0, pos / sampleRate, true, false, isRendering, false));
+            midi.clear();
+
+            for (int c = 0; c < output.getNumChannels(); ++c)
+                output.copyFrom (c, pos, block, c, 0, numThisTime);
+
+            if (playInRealTime)
+                juce::MessageManager::getInstance()->runDispatchLoopUntil (juce::roundToInt (numThisTime * 1000.0 / sampleRate));
+        }
+
+        plugin.baseClassDeinitialise();
+
+        return output;
+    }
+}
+
+#endif
+
+} // namespace tracktion_engine
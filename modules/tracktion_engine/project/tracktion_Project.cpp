@@ -271,13 +271,8 @@ void Project::saveTo (FileOutputStream& out)
     }
 
     indexOffset = (int) out.getPosition();
-    ProjectSearchIndex searchIndex (*this);
-
-    for (auto& o : objects)
-        if (auto c = o.item)
-            searchIndex.addClip (c);
-
-    searchIndex.writeToStream (out);
+    updateSearchIndex();
+    searchIndex->writeToStream (out);
 
     out.setPosition (8);
     out.writeInt (objectOffset);
@@ -693,6 +688,13 @@ void Project::searchFor (Array<ProjectItemID>& results, SearchOperation& searchO
 {
     save();
 
+    if (searchIndex != nullptr)
+    {
+        const ScopedLock sl (objectLock);
+        searchIndex->findMatches (searchOp, results);
+        return;
+    }
+
     if (indexOffset > 0)
     {
         ProjectSearchIndex psi (*this);
@@ -700,10 +702,13 @@ void Project::searchFor (Array<ProjectItemID>& results, SearchOperation& searchO
         {
             const ScopedLock sl (objectLock);
 
-            if (auto in = getInputStream())
+            if (! psi.mapFromFile (file, indexOffset))
             {
-                in->setPosition (indexOffset);
-                psi.readFromStream (*in);
+                if (auto in = getInputStream())
+                {
+                    in->setPosition (indexOffset);
+                    psi.readFromStream (*in);
+                }
             }
         }
 
@@ -711,6 +716,27 @@ void Project::searchFor (Array<ProjectItemID>& results, SearchOperation& searchO
     }
 }
 
+void Project::updateSearchIndex()
+{
+    CRASH_TRACER
+    const ScopedLock sl (objectLock);
+
+    if (searchIndex == nullptr)
+        searchIndex = std::make_unique<ProjectSearchIndex> (*this);
+
+    // Items are only re-indexed if their words have changed
+    for (auto& o : objects)
+        if (auto c = o.item)
+            searchIndex->addClip (c);
+
+    auto currentIDs = getAllItemIDs();
+    currentIDs.sort();
+
+    for (auto id : searchIndex->getIndexedItemIDs())
+        if (! std::binary_search (currentIDs.begin(), currentIDs.end(), id))
+            searchIndex->removeClip (id);
+}
+
 void Project::mergeArchiveContents (const File& archiveFile)
 {
     TracktionArchiveFile archive (engine, archiveFile);
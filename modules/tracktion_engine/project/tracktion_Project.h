@@ -164,6 +164,7 @@ private:
 
     juce::Array<ObjectInfo> objects;
     int objectOffset = 0, indexOffset = 0;
+    std::unique_ptr<ProjectSearchIndex> searchIndex;
     bool readOnly = false, hasChanged = false, temporary = false;
 
     Project (Engine&, ProjectManager&, const juce::File&);
@@ -175,6 +176,7 @@ private:
     bool readProjectHeader (juce::InputStream&, bool clearObjectInfo = true);
     void loadAllProjectItems();
     bool loadProjectItem (ObjectInfo&);
+    void updateSearchIndex();
     void ensureFolderCreated (ProjectItem::Category);
     void changed() override;
 
@@ -11,56 +11,217 @@
 namespace tracktion_engine
 {
 
-struct IndexedWord
+namespace SearchIndexFormat
 {
-    String word;
-    int numIDs;
-    HeapBlock<int> ids;
+    static const char* magicNumber = "TPSI";
+    static constexpr juce::uint32 version = 1;
+
+    // magic, version, numWords, stringPoolOffset, postingsOffset, totalSize
+    static constexpr juce::uint32 headerSize = 24;
+
+    // wordOffset, wordLength, postingsOffset, numIDs
+    static constexpr juce::uint32 entrySize = 16;
 
-    IndexedWord (InputStream& in)  : word (in.readString())
+    static void writeVarInt (MemoryOutputStream& out, juce::uint32 v)
     {
-        numIDs = in.readShort();
-        ids.malloc ((size_t) numIDs);
-        in.read (ids, (int) sizeof (int) * numIDs);
+        while (v >= 0x80)
+        {
+            out.writeByte ((char) ((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+
+        out.writeByte ((char) v);
     }
 
-    IndexedWord (const String& w, int mid) : word (w), numIDs (1)
+    static void padToAlignment (OutputStream& out, int alignment)
     {
-        ids.malloc (1);
-        *ids = mid;
+        while ((out.getPosition() % alignment) != 0)
+            out.writeByte (0);
     }
 
-    void writeToStream (OutputStream& out)
+    // Older versions read a count of words, each followed by a short count of IDs and
+    // the IDs, and ignore anything after it. So that they can still read a project's
+    // index, that's written first and the memory-mappable index follows it.
+    static constexpr int maxLegacyIDsPerWord = 32766;
+    static constexpr int mappableIndexAlignment = 8;
+
+    /** Returns the size of the legacy index at the start of some data, or -1 if it's incomplete. */
+    static juce::int64 getLegacyIndexSize (const juce::uint8* data, size_t size)
     {
-        out.writeString (word);
-        out.writeShort ((short) numIDs);
-        out.write (ids, (size_t) numIDs * sizeof (int));
+        if (data == nullptr || size < 4)
+            return -1;
+
+        auto numWords = (int) ByteOrder::littleEndianInt (data);
+        size_t pos = 4;
+
+        if (numWords < 0)
+            return -1;
+
+        for (int i = 0; i < numWords; ++i)
+        {
+            auto wordEnd = static_cast<const juce::uint8*> (memchr (data + pos, 0, size - pos));
+
+            if (wordEnd == nullptr)
+                return -1;
+
+            pos = (size_t) (wordEnd - data) + 1;
+
+            if (pos + 2 > size)
+                return -1;
+
+            auto numIDs = (int) (juce::int16) ByteOrder::littleEndianShort (data + pos);
+            pos += 2;
+
+            if (numIDs < 0 || pos + (size_t) numIDs * sizeof (int) > size)
+                return -1;
+
+            pos += (size_t) numIDs * sizeof (int);
+        }
+
+        return (juce::int64) pos;
     }
 
-    void addMediaId (int mid)
+    /** Returns the offset of the mappable index from the start of the legacy one.
+        It's aligned relative to the start of the stream the two were written to.
+    */
+    static juce::int64 getMappableIndexOffset (juce::int64 startPosition, juce::int64 legacyIndexSize)
+    {
+        auto end = startPosition + legacyIndexSize;
+        return end + (mappableIndexAlignment - end % mappableIndexAlignment) % mappableIndexAlignment - startPosition;
+    }
+}
+
+//==============================================================================
+/** A read-only view of an index in the format written by writeToStream. */
+struct ProjectSearchIndex::MappedIndex
+{
+    struct Entry
     {
-        for (int i = numIDs; --i >= 0;)
-            if (ids[i] == mid)
-                return;
+        const char* word;
+        juce::uint32 wordLength, postingsOffset, numIDs;
 
-        if (numIDs > 32766)
+        String getWord() const      { return String::fromUTF8 (word, (int) wordLength); }
+    };
+
+    bool initialise (const void* d, size_t availableSize)
+    {
+        using namespace SearchIndexFormat;
+        data = static_cast<const juce::uint8*> (d);
+
+        if (data == nullptr || availableSize < headerSize || memcmp (data, magicNumber, 4) != 0)
+            return false;
+
+        if (readInt (4) != version)
+            return false;
+
+        numWords = readInt (8);
+        stringPoolOffset = readInt (12);
+        postingsOffset = readInt (16);
+        size = readInt (20);
+
+        if (size > availableSize
+             || (juce::uint64) headerSize + (juce::uint64) numWords * entrySize > stringPoolOffset
+             || stringPoolOffset > postingsOffset
+             || postingsOffset > size)
+            return false;
+
+        // Check the entries once here so lookups don't need to
+        for (juce::uint32 i = 0; i < numWords; ++i)
         {
-            jassertfalse;
-            return;
+            auto entryStart = headerSize + i * entrySize;
+            auto wordOffset = readInt (entryStart);
+            auto wordLength = readInt (entryStart + 4);
+
+            if ((juce::uint64) stringPoolOffset + wordOffset + wordLength > postingsOffset
+                 || (juce::uint64) postingsOffset + readInt (entryStart + 8) > size)
+                return false;
         }
 
-        ids.realloc ((size_t) ++numIDs);
-        ids[numIDs - 1] = mid;
+        return true;
+    }
+
+    juce::uint32 readInt (size_t offset) const noexcept
+    {
+        return ByteOrder::littleEndianInt (data + offset);
+    }
+
+    Entry getEntry (juce::uint32 index) const noexcept
+    {
+        auto entryStart = SearchIndexFormat::headerSize + index * SearchIndexFormat::entrySize;
+
+        return { reinterpret_cast<const char*> (data + stringPoolOffset + readInt (entryStart)),
+                 readInt (entryStart + 4), readInt (entryStart + 8), readInt (entryStart + 12) };
+    }
+
+    static int compare (const Entry& e, const char* word, size_t wordLength) noexcept
+    {
+        auto res = memcmp (e.word, word, std::min ((size_t) e.wordLength, wordLength));
+
+        if (res != 0)
+            return res;
+
+        return (int) e.wordLength - (int) wordLength;
+    }
+
+    /** Returns the index of the first entry not less than the given word. */
+    juce::uint32 lowerBound (const String& word) const noexcept
+    {
+        auto utf8 = word.toRawUTF8();
+        auto len = word.getNumBytesAsUTF8();
+        juce::uint32 start = 0, end = numWords;
+
+        while (start < end)
+        {
+            auto mid = (start + end) / 2;
+
+            if (compare (getEntry (mid), utf8, len) < 0)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return start;
+    }
+
+    bool startsWith (const Entry& e, const String& prefix) const noexcept
+    {
+        auto len = prefix.getNumBytesAsUTF8();
+        return e.wordLength >= len && memcmp (e.word, prefix.toRawUTF8(), len) == 0;
+    }
+
+    template<typename Callback>
+    void decodePostings (const Entry& e, Callback&& callback) const
+    {
+        auto p = data + postingsOffset + e.postingsOffset;
+        auto end = data + size;
+        juce::uint32 lastID = 0;
+
+        for (juce::uint32 i = 0; i < e.numIDs; ++i)
+        {
+            juce::uint32 delta = 0;
+
+            for (int shift = 0; p < end && shift < 32; shift += 7)
+            {
+                auto b = *p++;
+                delta |= (juce::uint32) (b & 0x7f) << shift;
+
+                if ((b & 0x80) == 0)
+                    break;
+            }
+
+            lastID += delta;
+            callback ((int) lastID);
+        }
     }
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IndexedWord)
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    MemoryBlock block;
+
+    const juce::uint8* data = nullptr;
+    juce::uint32 size = 0, numWords = 0, stringPoolOffset = 0, postingsOffset = 0;
 };
 
 //==============================================================================
-ProjectSearchIndex::ProjectSearchIndex (Project& p) : project (p)
-{
-}
-
 static bool isNoiseWord (const String& word)
 {
     return     word == "a"
@@ -92,75 +253,446 @@ static bool isNoiseWord (const String& word)
             || word == "but";
 }
 
+static Array<int> createSortedArray (std::vector<int>& ids)
+{
+    std::sort (ids.begin(), ids.end());
+    ids.erase (std::unique (ids.begin(), ids.end()), ids.end());
+
+    return Array<int> (ids.data(), (int) ids.size());
+}
+
+static int getEditDistance (const String& a, const String& b, int maxEdits)
+{
+    const int lenA = a.length(), lenB = b.length();
+
+    if (std::abs (lenA - lenB) > maxEdits)
+        return maxEdits + 1;
+
+    std::vector<int> previous ((size_t) lenB + 1), current ((size_t) lenB + 1);
+
+    for (int j = 0; j <= lenB; ++j)
+        previous[(size_t) j] = j;
+
+    auto charA = a.getCharPointer();
+
+    for (int i = 1; i <= lenA; ++i)
+    {
+        auto ca = charA.getAndAdvance();
+        auto charB = b.getCharPointer();
+        current[0] = i;
+        int rowMin = current[0];
+
+        for (int j = 1; j <= lenB; ++j)
+        {
+            auto cost = (ca == charB.getAndAdvance()) ? 0 : 1;
+            current[(size_t) j] = std::min ({ previous[(size_t) j] + 1,
+                                              current[(size_t) j - 1] + 1,
+                                              previous[(size_t) j - 1] + cost });
+            rowMin = std::min (rowMin, current[(size_t) j]);
+        }
+
+        if (rowMin > maxEdits)
+            return maxEdits + 1;
+
+        std::swap (previous, current);
+    }
+
+    return previous[(size_t) lenB];
+}
+
+//==============================================================================
+ProjectSearchIndex::ProjectSearchIndex (Project& p) : project (p)
+{
+}
+
+ProjectSearchIndex::~ProjectSearchIndex()
+{
+}
+
 void ProjectSearchIndex::addClip (const ProjectItem::Ptr& item)
 {
-    if (item != nullptr)
+    if (item == nullptr)
+        return;
+
+    ensureLoadedIntoMemory();
+
+    StringArray newWords;
+
+    for (auto newWord : item->getSearchTokens())
+    {
+        auto word = newWord.toLowerCase().retainCharacters ("abcdefghijklmnopqrstuvwxyz0123456789");
+
+        if (! (word.isEmpty() || isNoiseWord (word)))
+            newWords.addIfNotAlreadyThere (word);
+    }
+
+    newWords.sort (false);
+
+    const int itemID = item->getID().getItemID();
+    auto existing = itemWords.find (itemID);
+
+    if (existing != itemWords.end())
+    {
+        if (existing->second == newWords)
+            return;
+
+        for (auto& w : existing->second)
+            if (! newWords.contains (w))
+                removeWord (w, itemID);
+
+        for (auto& w : newWords)
+            if (! existing->second.contains (w))
+                addWord (w, itemID);
+    }
+    else
+    {
+        for (auto& w : newWords)
+            addWord (w, itemID);
+    }
+
+    if (newWords.isEmpty())
+        itemWords.erase (itemID);
+    else
+        itemWords[itemID] = newWords;
+}
+
+void ProjectSearchIndex::removeClip (int itemID)
+{
+    ensureLoadedIntoMemory();
+
+    auto existing = itemWords.find (itemID);
+
+    if (existing == itemWords.end())
+        return;
+
+    for (auto& w : existing->second)
+        removeWord (w, itemID);
+
+    itemWords.erase (existing);
+}
+
+Array<int> ProjectSearchIndex::getIndexedItemIDs() const
+{
+    std::vector<int> ids;
+
+    if (mappedIndex != nullptr)
+    {
+        for (juce::uint32 i = 0; i < mappedIndex->numWords; ++i)
+            mappedIndex->decodePostings (mappedIndex->getEntry (i), [&ids] (int id) { ids.push_back (id); });
+    }
+    else
     {
-        for (auto newWord : item->getSearchTokens())
+        ids.reserve (itemWords.size());
+
+        for (auto& i : itemWords)
+            ids.push_back (i.first);
+    }
+
+    return createSortedArray (ids);
+}
+
+void ProjectSearchIndex::addWord (const String& word, int itemID)
+{
+    auto& ids = words[word];
+    auto found = std::lower_bound (ids.begin(), ids.end(), itemID);
+
+    if (found == ids.end() || *found != itemID)
+        ids.insert (found, itemID);
+}
+
+void ProjectSearchIndex::removeWord (const String& word, int itemID)
+{
+    auto found = words.find (word);
+
+    if (found == words.end())
+        return;
+
+    auto& ids = found->second;
+    auto foundID = std::lower_bound (ids.begin(), ids.end(), itemID);
+
+    if (foundID != ids.end() && *foundID == itemID)
+        ids.erase (foundID);
+
+    if (ids.empty())
+        words.erase (found);
+}
+
+void ProjectSearchIndex::ensureLoadedIntoMemory()
+{
+    if (mappedIndex == nullptr)
+        return;
+
+    CRASH_TRACER
+    auto mapped = std::move (mappedIndex);
+
+    for (juce::uint32 i = 0; i < mapped->numWords; ++i)
+    {
+        auto entry = mapped->getEntry (i);
+        auto word = entry.getWord();
+        auto& ids = words[word];
+        ids.reserve (entry.numIDs);
+
+        mapped->decodePostings (entry, [&ids] (int id) { ids.push_back (id); });
+        std::sort (ids.begin(), ids.end());
+
+        for (auto id : ids)
+            itemWords[id].add (word);
+    }
+
+    // Words are added in sorted order so each item's word list will already be sorted
+}
+
+//==============================================================================
+void ProjectSearchIndex::writeToStream (OutputStream& out) const
+{
+    using namespace SearchIndexFormat;
+
+    writeLegacyIndex (out);
+    padToAlignment (out, mappableIndexAlignment);
+
+    if (mappedIndex != nullptr)
+    {
+        out.write (mappedIndex->data, mappedIndex->size);
+        return;
+    }
+
+    MemoryOutputStream entries, stringPool, postings;
+
+    for (auto& w : words)
+    {
+        auto& ids = w.second;
+
+        entries.writeInt ((int) stringPool.getPosition());
+        entries.writeInt ((int) w.first.getNumBytesAsUTF8());
+        entries.writeInt ((int) postings.getPosition());
+        entries.writeInt ((int) ids.size());
+
+        stringPool.write (w.first.toRawUTF8(), w.first.getNumBytesAsUTF8());
+
+        juce::uint32 lastID = 0;
+
+        for (auto id : ids)
         {
-            auto word = newWord.toLowerCase().retainCharacters ("abcdefghijklmnopqrstuvwxyz0123456789");
+            writeVarInt (postings, (juce::uint32) id - lastID);
+            lastID = (juce::uint32) id;
+        }
+    }
 
-            if (! (word.isEmpty() || isNoiseWord (word)))
-            {
-                if (auto w = findWordMatch (word))
-                {
-                    w->addMediaId (item->getID().getItemID());
-                }
-                else
-                {
-                    index.add (new IndexedWord (word, item->getID().getItemID()));
+    padToAlignment (stringPool, 4);
+
+    const auto stringPoolOffset = headerSize + (juce::uint32) entries.getDataSize();
+    const auto postingsOffset = stringPoolOffset + (juce::uint32) stringPool.getDataSize();
+    const auto totalSize = postingsOffset + (juce::uint32) postings.getDataSize();
+
+    out.write (magicNumber, 4);
+    out.writeInt ((int) version);
+    out.writeInt ((int) words.size());
+    out.writeInt ((int) stringPoolOffset);
+    out.writeInt ((int) postingsOffset);
+    out.writeInt ((int) totalSize);
+    out.write (entries.getData(), entries.getDataSize());
+    out.write (stringPool.getData(), stringPool.getDataSize());
+    out.write (postings.getData(), postings.getDataSize());
+}
 
-                    std::sort (index.begin(), index.end(),
-                               [] (IndexedWord* a, IndexedWord* b) { return a->word < b->word; });
-                }
-            }
+void ProjectSearchIndex::writeLegacyIndex (OutputStream& out) const
+{
+    auto writeWord = [&out] (const String& word, const std::vector<int>& ids)
+    {
+        // Older versions can't read any more IDs than this for a word
+        auto numIDs = std::min ((int) ids.size(), SearchIndexFormat::maxLegacyIDsPerWord);
+
+        out.writeString (word);
+        out.writeShort ((short) numIDs);
+
+        for (int i = 0; i < numIDs; ++i)
+            out.writeInt (ids[(size_t) i]);
+    };
+
+    if (mappedIndex != nullptr)
+    {
+        out.writeInt ((int) mappedIndex->numWords);
+        std::vector<int> ids;
+
+        for (juce::uint32 i = 0; i < mappedIndex->numWords; ++i)
+        {
+            auto entry = mappedIndex->getEntry (i);
+            ids.clear();
+            mappedIndex->decodePostings (entry, [&ids] (int id) { ids.push_back (id); });
+            writeWord (entry.getWord(), ids);
         }
+
+        return;
     }
+
+    out.writeInt ((int) words.size());
+
+    for (auto& w : words)
+        writeWord (w.first, w.second);
 }
 
-void ProjectSearchIndex::writeToStream (OutputStream& out)
+void ProjectSearchIndex::readLegacyIndex (InputStream& in)
 {
-    out.writeInt (index.size());
+    // A list of words each followed by an unsorted list of IDs
+    for (int i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+    {
+        auto word = in.readString();
+        auto numIDs = (int) in.readShort();
 
-    for (auto&& i : index)
-        i->writeToStream (out);
+        for (int j = 0; j < numIDs; ++j)
+        {
+            auto id = in.readInt();
+            addWord (word, id);
+            itemWords[id].addIfNotAlreadyThere (word);
+        }
+    }
+
+    for (auto& i : itemWords)
+        i.second.sort (false);
 }
 
-void ProjectSearchIndex::readFromStream (InputStream& in)
+bool ProjectSearchIndex::readFromStream (InputStream& in)
 {
-    index.clear();
+    using namespace SearchIndexFormat;
+
+    words.clear();
+    itemWords.clear();
+    mappedIndex.reset();
+
+    auto startPos = in.getPosition();
+    auto newIndex = std::make_unique<MappedIndex>();
+    in.readIntoMemoryBlock (newIndex->block);
 
-    for (int i = in.readInt(); --i >= 0;)
-        index.add (new IndexedWord (in));
+    auto data = static_cast<const juce::uint8*> (newIndex->block.getData());
+    auto size = newIndex->block.getSize();
+    auto legacySize = getLegacyIndexSize (data, size);
+
+    if (legacySize < 0)
+        return false;
+
+    auto mappableOffset = getMappableIndexOffset (startPos, legacySize);
+
+    // Indexes written by older versions end after the legacy index
+    if (mappableOffset >= (juce::int64) size)
+    {
+        MemoryInputStream legacyIn (data, (size_t) legacySize, false);
+        readLegacyIndex (legacyIn);
+        return true;
+    }
+
+    if (! newIndex->initialise (data + mappableOffset, size - (size_t) mappableOffset))
+        return false;
+
+    mappedIndex = std::move (newIndex);
+    return true;
 }
 
-IndexedWord* ProjectSearchIndex::findWordMatch (const String& word) const
+bool ProjectSearchIndex::mapFromFile (const File& f, juce::int64 startPosition)
 {
-    int start = 0;
-    int end = index.size();
+    using namespace SearchIndexFormat;
+
+    auto newIndex = std::make_unique<MappedIndex>();
+    newIndex->mappedFile = std::make_unique<MemoryMappedFile> (f, Range<juce::int64> (startPosition, f.getSize()),
+                                                               MemoryMappedFile::readOnly);
 
-    for (;;)
+    auto data = static_cast<const juce::uint8*> (newIndex->mappedFile->getData());
+    auto size = newIndex->mappedFile->getSize();
+
+    // This has to step over the legacy index, but that's only a scan of the words
+    auto legacySize = getLegacyIndexSize (data, size);
+
+    if (legacySize < 0)
+        return false;
+
+    auto mappableOffset = getMappableIndexOffset (startPosition, legacySize);
+
+    if (mappableOffset >= (juce::int64) size
+         || ! newIndex->initialise (data + mappableOffset, size - (size_t) mappableOffset))
+        return false;
+
+    words.clear();
+    itemWords.clear();
+    mappedIndex = std::move (newIndex);
+
+    return true;
+}
+
+//==============================================================================
+Array<int> ProjectSearchIndex::findWordMatches (const String& word) const
+{
+    std::vector<int> ids;
+
+    if (mappedIndex != nullptr)
     {
-        if (start >= end)
-            break;
+        auto index = mappedIndex->lowerBound (word);
 
-        auto w = index.getUnchecked (start);
+        if (index < mappedIndex->numWords)
+        {
+            auto entry = mappedIndex->getEntry (index);
 
-        if (word == w->word)
-            return w;
+            if (MappedIndex::compare (entry, word.toRawUTF8(), word.getNumBytesAsUTF8()) == 0)
+                mappedIndex->decodePostings (entry, [&ids] (int id) { ids.push_back (id); });
+        }
+    }
+    else
+    {
+        auto found = words.find (word);
 
-        const int halfway = (start + end) >> 1;
+        if (found != words.end())
+            ids = found->second;
+    }
 
-        if (halfway == start)
-            break;
+    return createSortedArray (ids);
+}
 
-        if (word.compare (index[halfway]->word) >= 0)
-            start = halfway;
-        else
-            end = halfway;
+Array<int> ProjectSearchIndex::findPrefixMatches (const String& prefix) const
+{
+    std::vector<int> ids;
+
+    if (mappedIndex != nullptr)
+    {
+        for (auto i = mappedIndex->lowerBound (prefix); i < mappedIndex->numWords; ++i)
+        {
+            auto entry = mappedIndex->getEntry (i);
+
+            if (! mappedIndex->startsWith (entry, prefix))
+                break;
+
+            mappedIndex->decodePostings (entry, [&ids] (int id) { ids.push_back (id); });
+        }
+    }
+    else
+    {
+        for (auto w = words.lower_bound (prefix); w != words.end() && w->first.startsWith (prefix); ++w)
+            ids.insert (ids.end(), w->second.begin(), w->second.end());
     }
 
-    return {};
+    return createSortedArray (ids);
+}
+
+Array<int> ProjectSearchIndex::findFuzzyMatches (const String& word, int maxEdits) const
+{
+    std::vector<int> ids;
+
+    if (mappedIndex != nullptr)
+    {
+        for (juce::uint32 i = 0; i < mappedIndex->numWords; ++i)
+        {
+            auto entry = mappedIndex->getEntry (i);
+
+            if (std::abs ((int) entry.wordLength - word.length()) <= maxEdits
+                 && getEditDistance (entry.getWord(), word, maxEdits) <= maxEdits)
+                mappedIndex->decodePostings (entry, [&ids] (int id) { ids.push_back (id); });
+        }
+    }
+    else
+    {
+        for (auto& w : words)
+            if (getEditDistance (w.first, word, maxEdits) <= maxEdits)
+                ids.insert (ids.end(), w.second.begin(), w.second.end());
+    }
+
+    return createSortedArray (ids);
 }
 
 void ProjectSearchIndex::findMatches (SearchOperation& search, Array<ProjectItemID>& results)
@@ -186,18 +718,41 @@ struct WordMatchOperation : public SearchOperation
 
     Array<int> getMatches (ProjectSearchIndex& psi) override
     {
-        Array<int> found;
+        return psi.findWordMatches (word);
+    }
+
+    String word;
+};
+
+struct PrefixMatchOperation : public SearchOperation
+{
+    PrefixMatchOperation (const String& w) : prefix (w.toLowerCase().trim()) {}
+
+    Array<int> getMatches (ProjectSearchIndex& psi) override
+    {
+        return psi.findPrefixMatches (prefix);
+    }
 
-        if (auto w = psi.findWordMatch (word))
-            for (int j = 0; j < w->numIDs; ++j)
-                found.add (w->ids[j]);
+    String prefix;
+};
 
-        return found;
+struct FuzzyMatchOperation : public SearchOperation
+{
+    FuzzyMatchOperation (const String& w)
+        : word (w.toLowerCase().trim()), maxEdits (word.length() > 5 ? 2 : 1)
+    {
+    }
+
+    Array<int> getMatches (ProjectSearchIndex& psi) override
+    {
+        return psi.findFuzzyMatches (word, maxEdits);
     }
 
     String word;
+    int maxEdits;
 };
 
+// All the operations return sorted arrays so can be combined with linear merges
 struct OrOperation : public SearchOperation
 {
     OrOperation (SearchOperation* a, SearchOperation* b)  : SearchOperation (a, b) {}
@@ -213,10 +768,11 @@ struct OrOperation : public SearchOperation
         if (i2.isEmpty())
             return i1;
 
-        for (int i = i2.size(); --i >= 0;)
-            i1.addIfNotAlreadyThere (i2[i]);
+        std::vector<int> result;
+        result.reserve ((size_t) (i1.size() + i2.size()));
+        std::set_union (i1.begin(), i1.end(), i2.begin(), i2.end(), std::back_inserter (result));
 
-        return i1;
+        return Array<int> (result.data(), (int) result.size());
     }
 };
 
@@ -236,8 +792,11 @@ struct AndOperation : public SearchOperation
         if (i2.isEmpty())
             return i2;
 
-        i1.removeValuesNotIn (i2);
-        return i1;
+        std::vector<int> result;
+        result.reserve ((size_t) std::min (i1.size(), i2.size()));
+        std::set_intersection (i1.begin(), i1.end(), i2.begin(), i2.end(), std::back_inserter (result));
+
+        return Array<int> (result.data(), (int) result.size());
     }
 };
 
@@ -245,14 +804,18 @@ struct NotOperation : public SearchOperation
 {
     NotOperation (SearchOperation* in) : SearchOperation (in, nullptr) {}
 
-    Array<int> getMatches (ProjectSearchIndex& psi)
+    Array<int> getMatches (ProjectSearchIndex& psi) override
     {
-        Array<int> i1;
+        auto all = psi.project.getAllItemIDs();
+        all.sort();
 
-        i1 = psi.project.getAllItemIDs();
-        i1.removeValuesIn (in1->getMatches (psi));
+        auto toRemove = in1->getMatches (psi);
 
-        return i1;
+        std::vector<int> result;
+        result.reserve ((size_t) all.size());
+        std::set_difference (all.begin(), all.end(), toRemove.begin(), toRemove.end(), std::back_inserter (result));
+
+        return Array<int> (result.data(), (int) result.size());
     }
 };
 
@@ -359,10 +922,26 @@ SearchOperation* createCondition (const StringArray& words, int start, int lengt
 
     if (length == 1)
     {
-        if (words[start] == TRANS("All"))
+        auto word = words[start];
+
+        if (word == TRANS("All"))
             return new NotOperation (new FalseOperation());
 
-        return createPluralOptions (words[start]);
+        if (word.endsWithChar ('*'))
+        {
+            word = word.removeCharacters ("*~");
+
+            if (word.isEmpty())
+                return new NotOperation (new FalseOperation());
+
+            return new PrefixMatchOperation (word);
+        }
+
+        if (word.endsWithChar ('~'))
+            return new OrOperation (createPluralOptions (word.removeCharacters ("*~")),
+                                    new FuzzyMatchOperation (word.removeCharacters ("*~")));
+
+        return createPluralOptions (word.removeCharacters ("*~"));
     }
 
     if (length > 1 && words[start] == TRANS("Not"))
@@ -397,7 +976,7 @@ SearchOperation* createSearchForKeywords (const String& keywords)
     const String k (keywords.toLowerCase()
                             .replace ("-", " " + TRANS("Not") + " ")
                             .replace ("+", " " + TRANS("And") + " ")
-                            .retainCharacters (CharPointer_UTF8 ("abcdefghijklmnopqrstuvwxyz0123456789\xc3\xa0\xc3\xa1\xc3\xa2\xc3\xa3\xc3\xa4\xc3\xa5\xc3\xa6\xc3\xa7\xc3\xa8\xc3\xa9\xc3\xaa\xc3\xab\xc3\xac\xc3\xad\xc3\xae\xc3\xaf\xc3\xb0\xc3\xb1\xc3\xb2\xc3\xb3\xc3\xb4\xc3\xb5\xc3\xb6\xc3\xb8\xc3\xb9\xc3\xba\xc3\xbb\xc3\xbc\xc3\xbd\xc3\xbf\xc3\x9f"))
+                            .retainCharacters (CharPointer_UTF8 ("abcdefghijklmnopqrstuvwxyz0123456789*~\xc3\xa0\xc3\xa1\xc3\xa2\xc3\xa3\xc3\xa4\xc3\xa5\xc3\xa6\xc3\xa7\xc3\xa8\xc3\xa9\xc3\xaa\xc3\xab\xc3\xac\xc3\xad\xc3\xae\xc3\xaf\xc3\xb0\xc3\xb1\xc3\xb2\xc3\xb3\xc3\xb4\xc3\xb5\xc3\xb6\xc3\xb8\xc3\xb9\xc3\xba\xc3\xbb\xc3\xbc\xc3\xbd\xc3\xbf\xc3\x9f"))
                             .trim());
 
     StringArray words;
@@ -11,31 +11,90 @@
 namespace tracktion_engine
 {
 
-struct IndexedWord;
 class SearchOperation;
 
 //==============================================================================
+/**
+    An inverted index of the words in a Project's items, mapping each word to a
+    sorted list of the item IDs that contain it.
+
+    The index can be modified incrementally with addClip/removeClip. When it's
+    written to a stream it uses a flat, sorted layout with delta-encoded posting
+    lists so it can be searched directly from a memory-mapped file without having
+    to be read in first. Modifying a mapped index will load it into memory.
+
+    So that older versions can still search a project, the index is written in the
+    legacy format first, followed by the memory-mappable one.
+*/
 class ProjectSearchIndex
 {
 public:
     ProjectSearchIndex (Project&);
+    ~ProjectSearchIndex();
 
+    /** Adds an item to the index, or re-indexes it if its search tokens have changed. */
     void addClip (const ProjectItem::Ptr&);
+
+    /** Removes an item from the index. */
+    void removeClip (int itemID);
+
+    /** Returns the IDs of all the items in the index, sorted. */
+    juce::Array<int> getIndexedItemIDs() const;
+
     void findMatches (SearchOperation&, juce::Array<ProjectItemID>& results);
 
-    void writeToStream (juce::OutputStream&);
-    void readFromStream (juce::InputStream&);
+    //==============================================================================
+    /** Writes the index in the legacy format followed by its memory-mappable format. */
+    void writeToStream (juce::OutputStream&) const;
+
+    /** Reads an index from the current position of a stream until its end.
+        This can read both the current format and the legacy-only format written by
+        older versions. Returns false if the index is incomplete.
+    */
+    bool readFromStream (juce::InputStream&);
 
-    IndexedWord* findWordMatch (const juce::String& word) const;
+    /** Maps an index that was written with writeToStream at the given position in a
+        file. Returns false if the file doesn't contain a memory-mappable index, e.g.
+        if it was written by an older version, in which case use readFromStream.
+    */
+    bool mapFromFile (const juce::File&, juce::int64 startPosition);
+
+    //==============================================================================
+    /** Returns the sorted IDs of the items that contain a word. */
+    juce::Array<int> findWordMatches (const juce::String& word) const;
+
+    /** Returns the sorted IDs of the items that contain a word starting with the given prefix. */
+    juce::Array<int> findPrefixMatches (const juce::String& prefix) const;
+
+    /** Returns the sorted IDs of the items that contain a word within the given
+        number of edits (insertions, deletions or substitutions) of the given word.
+    */
+    juce::Array<int> findFuzzyMatches (const juce::String& word, int maxEdits) const;
 
     Project& project;
-    juce::OwnedArray<IndexedWord> index;
+
+private:
+    //==============================================================================
+    struct MappedIndex;
+
+    std::map<juce::String, std::vector<int>> words;
+    std::unordered_map<int, juce::StringArray> itemWords;
+    std::unique_ptr<MappedIndex> mappedIndex;
+
+    void ensureLoadedIntoMemory();
+    void writeLegacyIndex (juce::OutputStream&) const;
+    void readLegacyIndex (juce::InputStream&);
+    void addWord (const juce::String&, int itemID);
+    void removeWord (const juce::String&, int itemID);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProjectSearchIndex)
 };
 
 //==============================================================================
-/** turns a keyword string into a search condition tree.. */
+/** turns a keyword string into a search condition tree..
+    A word ending in '*' matches any words starting with it and a word ending in
+    '~' will also match words with small spelling differences.
+*/
 SearchOperation* createSearchForKeywords (const juce::String& keywords);
 
 //==============================================================================
@@ -46,6 +105,7 @@ public:
                      SearchOperation* in2 = nullptr);
     virtual ~SearchOperation();
 
+    /** Should return the sorted item IDs that match this operation. */
     virtual juce::Array<int> getMatches (ProjectSearchIndex&) = 0;
 
 protected:
@@ -0,0 +1,287 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class ProjectSearchIndexTests  : public juce::UnitTest
+{
+public:
+    ProjectSearchIndexTests()
+        : juce::UnitTest ("ProjectSearchIndex", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines().getFirst();
+        juce::TemporaryFile projectFile (".tracktion");
+        ProjectManager::TempProject temp (engine.getProjectManager(), projectFile.getFile(), true);
+        auto project = temp.project;
+
+        expect (project != nullptr && project->isValid());
+
+        if (project == nullptr)
+            return;
+
+        auto addItem = [&] (const juce::String& name, const juce::String& description)
+        {
+            auto item = project->createNewItem (juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile (name + ".wav"),
+                                                ProjectItem::waveItemType(), name, description,
+                                                ProjectItem::Category::imported, false);
+            expect (item != nullptr);
+            return item;
+        };
+
+        auto drumLoop       = addItem ("Drum Loop", {});
+        auto guitarRiff     = addItem ("Guitar Riff", "Clean");
+        auto drummerSolo    = addItem ("Drummer Solo", "Live take");
+        auto bassLoop       = addItem ("Bass Loop", "The clean one");
+
+        if (drumLoop == nullptr || guitarRiff == nullptr || drummerSolo == nullptr || bassLoop == nullptr)
+            return;
+
+        const int drum = drumLoop->getID().getItemID(), guitar = guitarRiff->getID().getItemID();
+        const int drummer = drummerSolo->getID().getItemID(), bass = bassLoop->getID().getItemID();
+
+        ProjectSearchIndex index (*project);
+
+        for (auto item : { drumLoop, guitarRiff, drummerSolo, bassLoop })
+            index.addClip (item);
+
+        beginTest ("In memory");
+        {
+            expectMatches (index, { drum, guitar, drummer, bass }, { drum, bass }, { guitar, bass }, { drum, drummer }, { guitar });
+        }
+
+        beginTest ("Re-indexing an item");
+        {
+            ProjectSearchIndex reindexed (*project);
+
+            for (auto item : { drumLoop, guitarRiff, drummerSolo, bassLoop })
+                reindexed.addClip (item);
+
+            bassLoop->setName ("Bass Riff", ProjectItem::SetNameMode::forceNoRename);
+            reindexed.addClip (bassLoop);
+            expectIDs (reindexed.findWordMatches ("loop"), { drum });
+            expectIDs (reindexed.findWordMatches ("riff"), { guitar, bass });
+
+            reindexed.removeClip (guitar);
+            expectIDs (reindexed.findWordMatches ("riff"), { bass });
+            expectIDs (reindexed.getIndexedItemIDs(), sorted ({ drum, drummer, bass }));
+
+            bassLoop->setName ("Bass Loop", ProjectItem::SetNameMode::forceNoRename);
+        }
+
+        beginTest ("Written and read back");
+        {
+            juce::MemoryOutputStream out;
+            index.writeToStream (out);
+
+            ProjectSearchIndex readBack (*project);
+            juce::MemoryInputStream in (out.getData(), out.getDataSize(), false);
+            expect (readBack.readFromStream (in));
+            expectMatches (readBack, { drum, guitar, drummer, bass }, { drum, bass }, { guitar, bass }, { drum, drummer }, { guitar });
+        }
+
+        beginTest ("Memory-mapped");
+        {
+            // Write some other data first as the index is normally at the end of the project file
+            juce::TemporaryFile indexFile;
+            const juce::int64 indexStart = 37;
+
+            {
+                juce::FileOutputStream out (indexFile.getFile());
+                expect (out.openedOk());
+
+                for (int i = 0; i < (int) indexStart; ++i)
+                    out.writeByte ((char) i);
+
+                index.writeToStream (out);
+            }
+
+            ProjectSearchIndex mapped (*project);
+            expect (mapped.mapFromFile (indexFile.getFile(), indexStart));
+            expectMatches (mapped, { drum, guitar, drummer, bass }, { drum, bass }, { guitar, bass }, { drum, drummer }, { guitar });
+
+            // Writing a mapped index should give exactly the same data
+            juce::MemoryOutputStream original, rewritten;
+            index.writeToStream (original);
+            mapped.writeToStream (rewritten);
+            expect (original.getMemoryBlock() == rewritten.getMemoryBlock());
+
+            // Modifying it loads it into memory
+            mapped.removeClip (drum);
+            expectIDs (mapped.findWordMatches ("loop"), { bass });
+            expectIDs (mapped.findPrefixMatches ("drum"), { drummer });
+
+            expect (! mapped.mapFromFile (indexFile.getFile(), 0));
+        }
+
+        beginTest ("Corrupt indexes are rejected");
+        {
+            juce::MemoryOutputStream out;
+            index.writeToStream (out);
+
+            juce::MemoryBlock truncated (out.getData(), out.getDataSize() / 2);
+            ProjectSearchIndex readBack (*project);
+            juce::MemoryInputStream in (truncated, false);
+            expect (! readBack.readFromStream (in));
+        }
+
+        beginTest ("Legacy format");
+        {
+            // A count of words, each followed by a short count of unsorted IDs
+            const std::vector<std::pair<juce::String, std::vector<int>>> legacyWords
+            {
+                { "loop",   { bass, drum } },
+                { "drum",   { drum } },
+                { "drummer",{ drummer } },
+                { "solo",   { drummer } },
+                { "live",   { drummer } },
+                { "take",   { drummer } },
+                { "guitar", { guitar } },
+                { "riff",   { guitar } },
+                { "clean",  { bass, guitar } },
+                { "bass",   { bass } },
+                { "one",    { bass } }
+            };
+
+            juce::MemoryOutputStream out;
+            out.writeInt ((int) legacyWords.size());
+
+            for (auto& w : legacyWords)
+            {
+                out.writeString (w.first);
+                out.writeShort ((short) w.second.size());
+
+                for (auto id : w.second)
+                    out.writeInt (id);
+            }
+
+            ProjectSearchIndex legacy (*project);
+            juce::MemoryInputStream in (out.getData(), out.getDataSize(), false);
+            expect (legacy.readFromStream (in));
+            expectMatches (legacy, { drum, guitar, drummer, bass }, { drum, bass }, { guitar, bass }, { drum, drummer }, { guitar });
+
+            // And it's written back out with the memory-mappable index after the legacy one
+            juce::MemoryOutputStream converted;
+            legacy.writeToStream (converted);
+            expect (converted.getDataSize() > out.getDataSize());
+            expect (readAsOlderVersion (converted.getMemoryBlock()) == readAsOlderVersion (out.getMemoryBlock()));
+
+            ProjectSearchIndex readBack (*project);
+            juce::MemoryInputStream convertedIn (converted.getData(), converted.getDataSize(), false);
+            expect (readBack.readFromStream (convertedIn));
+            expectMatches (readBack, { drum, guitar, drummer, bass }, { drum, bass }, { guitar, bass }, { drum, drummer }, { guitar });
+        }
+
+        beginTest ("Older versions can read the index");
+        {
+            juce::MemoryOutputStream out;
+            index.writeToStream (out);
+
+            auto oldWords = readAsOlderVersion (out.getMemoryBlock());
+            expectEquals ((int) oldWords.size(), 11);
+            expect (oldWords["loop"] == std::set<int> { drum, bass });
+            expect (oldWords["drummer"] == std::set<int> { drummer });
+            expect (oldWords["clean"] == std::set<int> { guitar, bass });
+        }
+
+        beginTest ("Prefix and fuzzy matching");
+        {
+            expect (index.findPrefixMatches ("x").isEmpty());
+            expectIDs (index.findPrefixMatches ("dr"), sorted ({ drum, drummer }));
+            expectIDs (index.findPrefixMatches ("drumm"), { drummer });
+            expectIDs (index.findPrefixMatches (""), sorted ({ drum, guitar, drummer, bass }));
+
+            expectIDs (index.findFuzzyMatches ("lop", 1), sorted ({ drum, bass }));
+            expectIDs (index.findFuzzyMatches ("guitra", 2), { guitar });
+            expect (index.findFuzzyMatches ("guitra", 1).isEmpty());
+            expect (index.findFuzzyMatches ("sax", 1).isEmpty());
+        }
+
+        beginTest ("Keyword searches");
+        {
+            expectSearch (index, "drum*", sorted ({ drum, drummer }));
+            expectSearch (index, "gitar~", { guitar });
+            expectSearch (index, "loop and clean", { bass });
+            expectSearch (index, "loops", sorted ({ drum, bass }));
+            expectSearch (index, "drum* solo", { drummer });
+            expectSearch (index, "piano", {});
+        }
+    }
+
+private:
+    /** Reads an index the way versions before the memory-mappable format did. */
+    static std::map<juce::String, std::set<int>> readAsOlderVersion (const juce::MemoryBlock& data)
+    {
+        juce::MemoryInputStream in (data, false);
+        std::map<juce::String, std::set<int>> words;
+
+        for (int i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+        {
+            auto& ids = words[in.readString()];
+
+            for (int j = in.readShort(); --j >= 0;)
+                ids.insert (in.readInt());
+        }
+
+        return words;
+    }
+
+    static juce::Array<int> sorted (juce::Array<int> ids)
+    {
+        ids.sort();
+        return ids;
+    }
+
+    void expectIDs (const juce::Array<int>& actual, const juce::Array<int>& expected)
+    {
+        expect (actual == sorted (expected), "Expected " + juce::String (expected.size()) + " matches, got " + juce::String (actual.size()));
+    }
+
+    void expectMatches (ProjectSearchIndex& index, juce::Array<int> all, juce::Array<int> loop,
+                        juce::Array<int> clean, juce::Array<int> drumPrefix, juce::Array<int> guitar)
+    {
+        expectIDs (index.getIndexedItemIDs(), all);
+        expectIDs (index.findWordMatches ("loop"), loop);
+        expectIDs (index.findWordMatches ("clean"), clean);
+        expectIDs (index.findPrefixMatches ("drum"), drumPrefix);
+        expectIDs (index.findFuzzyMatches ("gutar", 1), guitar);
+
+        // Noise words aren't indexed
+        expect (index.findWordMatches ("the").isEmpty());
+        expect (index.findWordMatches ("guitars").isEmpty());
+    }
+
+    void expectSearch (ProjectSearchIndex& index, const juce::String& keywords, const juce::Array<int>& expected)
+    {
+        std::unique_ptr<SearchOperation> search (createSearchForKeywords (keywords));
+        juce::Array<ProjectItemID> results;
+        index.findMatches (*search, results);
+
+        juce::Array<int> ids;
+
+        for (auto& r : results)
+            ids.add (r.getItemID());
+
+        expectIDs (sorted (ids), expected);
+    }
+};
+
+static ProjectSearchIndexTests projectSearchIndexTests;
+
+#endif
+
+} // namespace tracktion_engine
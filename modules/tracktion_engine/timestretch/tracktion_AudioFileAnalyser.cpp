@@ -0,0 +1,337 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+void AudioFileAnalysis::applyTo (LoopInfo& loopInfo, const AudioFileInfo& info) const
+{
+    if (isBpmSensible())
+        loopInfo.setBpm (bpm, info);
+
+    loopInfo.clearLoopPoints (LoopInfo::LoopPointType::automatic);
+
+    const auto in = loopInfo.getInMarker();
+    const auto out = loopInfo.getOutMarker() == -1 ? info.lengthInSamples
+                                                   : loopInfo.getOutMarker();
+
+    for (auto beat : beats)
+        if (beat >= in && beat < out)
+            loopInfo.addLoopPoint (beat, LoopInfo::LoopPointType::automatic);
+}
+
+juce::ValueTree AudioFileAnalysis::toValueTree() const
+{
+    juce::StringArray beatPositions;
+
+    for (auto beat : beats)
+        beatPositions.add (juce::String (beat));
+
+    juce::ValueTree v (IDs::AUDIOANALYSIS);
+    v.setProperty (IDs::bpm, bpm, nullptr);
+    v.setProperty (IDs::beatSensitivity, beatSensitivity, nullptr);
+    v.setProperty (IDs::peakLevel, peakLevel, nullptr);
+    v.setProperty (IDs::rmsLevel, rmsLevel, nullptr);
+    v.setProperty (IDs::beats, beatPositions.joinIntoString (" "), nullptr);
+
+    return v;
+}
+
+AudioFileAnalysis AudioFileAnalysis::fromValueTree (const juce::ValueTree& v)
+{
+    AudioFileAnalysis analysis;
+
+    if (! v.hasType (IDs::AUDIOANALYSIS))
+        return analysis;
+
+    analysis.bpm                = v.getProperty (IDs::bpm, -1.0f);
+    analysis.beatSensitivity    = v.getProperty (IDs::beatSensitivity, 0.5f);
+    analysis.peakLevel          = v.getProperty (IDs::peakLevel);
+    analysis.rmsLevel           = v.getProperty (IDs::rmsLevel);
+
+    for (auto& beat : juce::StringArray::fromTokens (v[IDs::beats].toString(), false))
+        analysis.beats.add (beat.getLargeIntValue());
+
+    analysis.valid = true;
+    return analysis;
+}
+
+//==============================================================================
+namespace
+{
+    struct FileStamp
+    {
+        FileStamp (const juce::File& f)
+            : size (f.getSize()), time (f.getLastModificationTime().toMilliseconds())
+        {
+        }
+
+        FileStamp (const juce::ValueTree& v)
+            : size (static_cast<juce::int64> (v[IDs::fileSize])), time (static_cast<juce::int64> (v[IDs::fileTime]))
+        {
+        }
+
+        bool operator== (const FileStamp& other) const noexcept     { return size == other.size && time == other.time; }
+
+        juce::int64 size, time;
+    };
+
+    juce::ValueTree readCacheFile (const juce::File& cacheFile, const juce::File& sourceFile)
+    {
+        if (cacheFile.existsAsFile())
+        {
+            if (auto xml = juce::parseXML (cacheFile))
+            {
+                auto v = juce::ValueTree::fromXml (*xml);
+
+                if (FileStamp (v) == FileStamp (sourceFile))
+                    return v;
+            }
+        }
+
+        return {};
+    }
+
+    void writeCacheFile (const juce::File& cacheFile, juce::ValueTree v, const FileStamp& stamp)
+    {
+        v.setProperty (IDs::fileSize, stamp.size, nullptr);
+        v.setProperty (IDs::fileTime, stamp.time, nullptr);
+
+        cacheFile.getParentDirectory().createDirectory();
+
+        if (auto xml = v.createXml())
+        {
+            // Another thread could be writing the same file, so write to a temp and swap it in
+            juce::TemporaryFile temp (cacheFile);
+
+            if (xml->writeTo (temp.getFile()))
+                temp.overwriteTargetFileWithTemporary();
+        }
+    }
+
+    bool isSameSensitivity (float a, float b) noexcept
+    {
+        return std::abs (a - b) < 0.0001f;
+    }
+}
+
+//==============================================================================
+AudioFileAnalyser::AudioFileAnalyser (Engine& e)
+    : engine (e)
+{
+}
+
+std::vector<AudioFileAnalysis> AudioFileAnalyser::analyse (const juce::Array<AudioFile>& files, float beatSensitivity,
+                                                           int numThreads, std::atomic<bool>* shouldExit)
+{
+    CRASH_TRACER
+    std::vector<AudioFileAnalysis> results ((size_t) files.size());
+    juce::Array<int> filesToAnalyse;
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        results[(size_t) i] = getCachedAnalysis (files.getReference (i), beatSensitivity);
+
+        if (! results[(size_t) i].isValid())
+            filesToAnalyse.add (i);
+    }
+
+    if (filesToAnalyse.isEmpty())
+        return results;
+
+    juce::ThreadPool pool (juce::jlimit (1, filesToAnalyse.size(), numThreads));
+    juce::WaitableEvent finishedEvent;
+    std::atomic<int> numLeft { filesToAnalyse.size() };
+
+    for (auto index : filesToAnalyse)
+    {
+        pool.addJob ([&, index]
+                     {
+                         results[(size_t) index] = analyseAndCache (files.getReference (index), beatSensitivity, shouldExit);
+
+                         if (--numLeft == 0)
+                             finishedEvent.signal();
+                     });
+    }
+
+    finishedEvent.wait();
+
+    return results;
+}
+
+AudioFileAnalysis AudioFileAnalyser::analyse (const AudioFile& file, float beatSensitivity, std::atomic<bool>* shouldExit)
+{
+    auto analysis = getCachedAnalysis (file, beatSensitivity);
+
+    if (analysis.isValid())
+        return analysis;
+
+    return analyseAndCache (file, beatSensitivity, shouldExit);
+}
+
+AudioFileAnalysis AudioFileAnalyser::getCachedAnalysis (const AudioFile& file, float beatSensitivity) const
+{
+    auto analysis = AudioFileAnalysis::fromValueTree (readCacheFile (getCacheFile (file), file.getFile()));
+
+    if (analysis.isValid() && (beatSensitivity < 0.0f || isSameSensitivity (analysis.beatSensitivity, beatSensitivity)))
+        return analysis;
+
+    return {};
+}
+
+juce::File AudioFileAnalyser::getCacheFile (const AudioFile& file) const
+{
+    return engine.getTemporaryFileManager().getTempFile ("analysis")
+                 .getChildFile ("analysis_" + file.getHashString() + ".xml");
+}
+
+AudioFileAnalysis AudioFileAnalyser::analyseAndCache (const AudioFile& file, float beatSensitivity, std::atomic<bool>* shouldExit)
+{
+    // Take the stamp first so the cache is invalid if the file changes while it's being read
+    const FileStamp stamp (file.getFile());
+    auto analysis = analyseFile (engine, file, beatSensitivity, shouldExit);
+
+    if (! analysis.isValid())
+        return analysis;
+
+    writeCacheFile (getCacheFile (file), analysis.toValueTree(), stamp);
+
+    return analysis;
+}
+
+//==============================================================================
+std::pair<bool, juce::Array<double>> AudioFileAnalyser::getCachedTransients (const AudioFile& file, float sensitivity) const
+{
+    auto v = readCacheFile (getTransientCacheFile (file), file.getFile());
+
+    if (! (v.hasType (IDs::TRANSIENTS) && isSameSensitivity (v[IDs::sensitivity], sensitivity)))
+        return { false, {} };
+
+    juce::Array<double> times;
+
+    for (auto& time : juce::StringArray::fromTokens (v[IDs::times].toString(), false))
+        times.add (time.getDoubleValue());
+
+    return { true, times };
+}
+
+void AudioFileAnalyser::saveTransients (const AudioFile& file, float sensitivity, const juce::Array<double>& times,
+                                        juce::Time fileModificationTime)
+{
+    FileStamp stamp (file.getFile());
+
+    if (stamp.time != fileModificationTime.toMilliseconds())
+        return;
+
+    juce::StringArray timeStrings;
+
+    for (auto time : times)
+        timeStrings.add (juce::String (time));
+
+    juce::ValueTree v (IDs::TRANSIENTS);
+    v.setProperty (IDs::sensitivity, sensitivity, nullptr);
+    v.setProperty (IDs::times, timeStrings.joinIntoString (" "), nullptr);
+
+    writeCacheFile (getTransientCacheFile (file), v, stamp);
+}
+
+juce::File AudioFileAnalyser::getTransientCacheFile (const AudioFile& file) const
+{
+    return getCacheFile (file).getSiblingFile ("transients_" + file.getHashString() + ".xml");
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatReader> AudioFileAnalyser::createReader (Engine& engine, const juce::File& file)
+{
+    juce::AudioFormat* format = nullptr;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader (AudioFileUtils::createMemoryMappedReader (engine, file, format));
+
+    if (mappedReader != nullptr && mappedReader->mapEntireFile())
+        return std::move (mappedReader);
+
+    return std::unique_ptr<juce::AudioFormatReader> (AudioFileUtils::createReaderFor (engine, file));
+}
+
+AudioFileAnalysis AudioFileAnalyser::analyseFile (Engine& engine, const AudioFile& file, float beatSensitivity,
+                                                  std::atomic<bool>* shouldExit)
+{
+    CRASH_TRACER
+    AudioFileAnalysis analysis;
+    analysis.beatSensitivity = beatSensitivity;
+
+    auto reader = createReader (engine, file.getFile());
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+        return analysis;
+
+    const auto numChannels = (int) reader->numChannels;
+    const auto numSamples = reader->lengthInSamples;
+
+    TempoDetect tempoDetect (numChannels, reader->sampleRate);
+
+    BeatDetect beatDetect;
+    beatDetect.setSensitivity (beatSensitivity);
+    beatDetect.setSampleRate (reader->sampleRate);
+
+    // Read in multiples of the beat detection block so each block goes through all the detectors
+    const int beatBlockSize = beatDetect.getBlockSize();
+    const int blockSize = beatBlockSize * 64;
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::HeapBlock<const float*> beatChannels ((size_t) numChannels);
+
+    double sumOfSquares = 0;
+    float peakLevel = 0.0f;
+
+    for (juce::int64 startSample = 0; startSample < numSamples;)
+    {
+        if (shouldExit != nullptr && shouldExit->load())
+            return analysis;
+
+        const int numThisTime = (int) juce::jmin ((juce::int64) blockSize, numSamples - startSample);
+        reader->read (&buffer, 0, numThisTime, startSample, true, numChannels > 1);
+
+        tempoDetect.processSection (buffer, numThisTime);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax (buffer.getReadPointer (chan), numThisTime);
+            peakLevel = juce::jmax (peakLevel, -range.getStart(), range.getEnd());
+        }
+
+        // The beat detector gets the energy of each whole block, which are also summed for the RMS
+        int pos = 0;
+
+        for (; pos + beatBlockSize <= numThisTime; pos += beatBlockSize)
+        {
+            for (int chan = 0; chan < numChannels; ++chan)
+                beatChannels[chan] = buffer.getReadPointer (chan, pos);
+
+            sumOfSquares += beatDetect.audioProcess (beatChannels.getData(), numChannels);
+        }
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            sumOfSquares += BeatDetect::getSumOfSquares (buffer.getReadPointer (chan, pos), numThisTime - pos);
+
+        startSample += numThisTime;
+    }
+
+    analysis.bpm = tempoDetect.finishAndDetect();
+    analysis.peakLevel = peakLevel;
+    analysis.rmsLevel = (float) std::sqrt (sumOfSquares / (double) (numSamples * numChannels));
+
+    for (int i = 0; i < beatDetect.getNumBeats(); ++i)
+        analysis.beats.add (beatDetect.getBeat (i));
+
+    analysis.valid = true;
+    return analysis;
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,113 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/** The tempo, beats and levels found by an AudioFileAnalyser. */
+struct AudioFileAnalysis
+{
+    float bpm = -1.0f;                  /**< The tempo, or -1 if one couldn't be found. */
+    juce::Array<juce::int64> beats;     /**< The sample positions of the beats. */
+    float beatSensitivity = 0.5f;       /**< The sensitivity the beats were detected with. */
+    float peakLevel = 0.0f;             /**< The highest absolute sample value. */
+    float rmsLevel = 0.0f;              /**< The RMS level of all the channels. */
+
+    /** Returns true if the file could be read and analysed. */
+    bool isValid() const noexcept                   { return valid; }
+
+    /** Returns true if the tempo is within TempoDetect's sensible range. */
+    bool isBpmSensible() const noexcept             { return bpm >= 29.0f && bpm <= 200.0f; }
+
+    /** Sets the tempo and replaces the automatic loop points of a LoopInfo with the results. */
+    void applyTo (LoopInfo&, const AudioFileInfo&) const;
+
+    //==============================================================================
+    juce::ValueTree toValueTree() const;
+    static AudioFileAnalysis fromValueTree (const juce::ValueTree&);
+
+    bool valid = false;
+};
+
+//==============================================================================
+/**
+    Runs tempo, beat and level analysis across lots of audio files in parallel and
+    keeps the results in a persistent cache.
+
+    Each file is read once, through a memory-mapped reader where the format supports
+    it, and each block is passed to the TempoDetect, BeatDetect and level meters in turn.
+    The results are saved in the temp directory, keyed on the file's hash and
+    invalidated if the file's size or modification time change, so a library only
+    needs analysing once.
+*/
+class AudioFileAnalyser
+{
+public:
+    AudioFileAnalyser (Engine&);
+
+    /** Analyses a set of files, using cached results where they exist.
+        This blocks until all the files are done, running the analysis on up to
+        numThreads threads. The results are in the same order as the files.
+        @param shouldExit   if this is set, analysis stops early and the remaining
+                            results are left invalid
+    */
+    std::vector<AudioFileAnalysis> analyse (const juce::Array<AudioFile>&, float beatSensitivity,
+                                            int numThreads = juce::SystemStats::getNumCpus(),
+                                            std::atomic<bool>* shouldExit = nullptr);
+
+    /** Analyses a single file on the calling thread, using the cache if it can. */
+    AudioFileAnalysis analyse (const AudioFile&, float beatSensitivity, std::atomic<bool>* shouldExit = nullptr);
+
+    /** Returns the cached analysis for a file if there's an up-to-date one.
+        If beatSensitivity is negative, the beats from any sensitivity will be accepted.
+    */
+    AudioFileAnalysis getCachedAnalysis (const AudioFile&, float beatSensitivity = -1.0f) const;
+
+    /** Analyses a file without touching the cache. */
+    static AudioFileAnalysis analyseFile (Engine&, const AudioFile&, float beatSensitivity,
+                                          std::atomic<bool>* shouldExit = nullptr);
+
+    /** Returns the file the analysis for an AudioFile is cached in. */
+    juce::File getCacheFile (const AudioFile&) const;
+
+    //==============================================================================
+    /** Returns the cached transient times for a file, in seconds.
+        The bool will be false if there aren't any up-to-date ones for this sensitivity.
+        @see TransientDetect
+    */
+    std::pair<bool, juce::Array<double>> getCachedTransients (const AudioFile&, float sensitivity) const;
+
+    /** Adds the transient times found for a file to the cache.
+        @param fileModificationTime the time the file was last modified when the
+                                    detection started, so a file that changed while
+                                    it was being read isn't cached
+    */
+    void saveTransients (const AudioFile&, float sensitivity, const juce::Array<double>& times,
+                         juce::Time fileModificationTime);
+
+    /** Returns the file the transients for an AudioFile are cached in. */
+    juce::File getTransientCacheFile (const AudioFile&) const;
+
+    //==============================================================================
+    /** Creates a reader for analysing a file.
+        This memory-maps the whole file if the format allows it, so it's only read from disk once.
+    */
+    static std::unique_ptr<juce::AudioFormatReader> createReader (Engine&, const juce::File&);
+
+private:
+    Engine& engine;
+
+    AudioFileAnalysis analyseAndCache (const AudioFile&, float beatSensitivity, std::atomic<bool>* shouldExit);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileAnalyser)
+};
+
+} // namespace tracktion_engine
@@ -0,0 +1,292 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace audio_file_analyser_test_utilities
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr float clickLevel = 0.8f;
+
+    /** Returns the sample position of each click in a click track. */
+    inline juce::Array<juce::int64> getClickPositions (double bpm, double lengthInSeconds)
+    {
+        juce::Array<juce::int64> positions;
+        const double samplesPerBeat = sampleRate * 60.0 / bpm;
+
+        for (double pos = 0.0; pos < lengthInSeconds * sampleRate; pos += samplesPerBeat)
+            positions.add ((juce::int64) pos);
+
+        return positions;
+    }
+
+    /** Writes a stereo click track of short decaying sine bursts. */
+    inline void writeClickTrack (Engine& engine, const juce::File& file, double bpm, double lengthInSeconds)
+    {
+        const int numSamples = (int) (lengthInSeconds * sampleRate);
+        const int clickLength = (int) (sampleRate * 0.005);
+
+        juce::AudioBuffer<float> buffer (2, numSamples);
+        buffer.clear();
+
+        for (auto pos : getClickPositions (bpm, lengthInSeconds))
+        {
+            for (int i = 0; i < clickLength && pos + i < numSamples; ++i)
+            {
+                const auto gain = clickLevel * std::exp (-5.0f * (float) i / (float) clickLength);
+                const auto sample = gain * std::sin (juce::MathConstants<float>::twoPi * 1000.0f * (float) i / (float) sampleRate);
+
+                for (int chan = 0; chan < buffer.getNumChannels(); ++chan)
+                    buffer.setSample (chan, (int) pos + i, sample);
+            }
+        }
+
+        juce::WavAudioFormat format;
+        AudioFileWriter writer (AudioFile (engine, file), &format, buffer.getNumChannels(), sampleRate, 24, {}, 0);
+
+        if (writer.isOpen())
+            writer.appendBuffer (buffer, buffer.getNumSamples());
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class AudioFileAnalyserTests  : public juce::UnitTest
+{
+public:
+    AudioFileAnalyserTests()
+        : juce::UnitTest ("AudioFileAnalyser", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace audio_file_analyser_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+        AudioFileAnalyser analyser (engine);
+
+        beginTest ("Sum of squares");
+        {
+            juce::Random r (42);
+            std::vector<float> samples (1027);
+            double expected = 0.0;
+
+            for (auto& s : samples)
+            {
+                s = r.nextFloat() * 2.0f - 1.0f;
+                expected += (double) s * (double) s;
+            }
+
+            expectWithinAbsoluteError (BeatDetect::getSumOfSquares (samples.data(), (int) samples.size()), expected, expected * 1.0e-5);
+            expectEquals (BeatDetect::getSumOfSquares (samples.data(), 0), 0.0);
+        }
+
+        beginTest ("Beats, tempo and levels");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            writeClickTrack (engine, tempFile.getFile(), 120.0, 20.0);
+            AudioFile file (engine, tempFile.getFile());
+
+            auto analysis = AudioFileAnalyser::analyseFile (engine, file, 0.5f);
+            expect (analysis.isValid());
+            expectWithinAbsoluteError (analysis.bpm, 120.0f, 2.0f);
+            expectWithinAbsoluteError (analysis.peakLevel, clickLevel, 0.01f);
+            expect (analysis.rmsLevel > 0.0f && analysis.rmsLevel < clickLevel);
+
+            // Each beat is reported at the start of the block it's in
+            auto clicks = getClickPositions (120.0, 20.0);
+            expectEquals (analysis.beats.size(), clicks.size());
+
+            for (int i = 0; i < juce::jmin (analysis.beats.size(), clicks.size()); ++i)
+                expect (clicks[i] - analysis.beats[i] >= 0 && clicks[i] - analysis.beats[i] < 1024);
+
+            LoopInfo loopInfo (engine);
+            loopInfo.addLoopPoint (100, LoopInfo::LoopPointType::manual);
+            loopInfo.addLoopPoint (200, LoopInfo::LoopPointType::automatic);
+            analysis.applyTo (loopInfo, file.getInfo());
+
+            expectEquals (loopInfo.getNumLoopPoints(), analysis.beats.size() + 1);
+            expectWithinAbsoluteError (loopInfo.getBpm (file.getInfo()), (double) analysis.bpm, 0.01);
+        }
+
+        beginTest ("Invalid files");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            tempFile.getFile().replaceWithText ("not audio");
+
+            expect (! AudioFileAnalyser::analyseFile (engine, AudioFile (engine, tempFile.getFile()), 0.5f).isValid());
+            expect (! analyser.analyse (AudioFile (engine, tempFile.getFile()), 0.5f).isValid());
+            expect (! analyser.getCacheFile (AudioFile (engine, tempFile.getFile())).exists());
+        }
+
+        beginTest ("Cached results");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            writeClickTrack (engine, tempFile.getFile(), 100.0, 10.0);
+            AudioFile file (engine, tempFile.getFile());
+            analyser.getCacheFile (file).deleteFile();
+
+            expect (! analyser.getCachedAnalysis (file).isValid());
+            auto analysis = analyser.analyse (file, 0.5f);
+
+            auto cached = analyser.getCachedAnalysis (file);
+            expect (cached.isValid());
+            expectEquals (cached.bpm, analysis.bpm);
+            expectEquals (cached.peakLevel, analysis.peakLevel);
+            expect (cached.beats == analysis.beats);
+
+            expect (analyser.getCachedAnalysis (file, 0.5f).isValid());
+            expect (! analyser.getCachedAnalysis (file, 0.75f).isValid());
+
+            // Changing the file invalidates the cache
+            writeClickTrack (engine, tempFile.getFile(), 100.0, 12.0);
+            expect (! analyser.getCachedAnalysis (file).isValid());
+
+            analyser.getCacheFile (file).deleteFile();
+        }
+
+        beginTest ("Batch analysis");
+        {
+            juce::OwnedArray<juce::TemporaryFile> tempFiles;
+            juce::Array<AudioFile> files;
+
+            for (double bpm : { 90.0, 110.0, 130.0, 150.0, 170.0 })
+            {
+                auto tempFile = tempFiles.add (new juce::TemporaryFile (".wav"));
+                writeClickTrack (engine, tempFile->getFile(), bpm, 10.0);
+                files.add (AudioFile (engine, tempFile->getFile()));
+                analyser.getCacheFile (files.getLast()).deleteFile();
+            }
+
+            auto results = analyser.analyse (files, 0.5f, 3);
+            expectEquals ((int) results.size(), files.size());
+
+            for (int i = 0; i < files.size(); ++i)
+            {
+                auto single = AudioFileAnalyser::analyseFile (engine, files[i], 0.5f);
+                expect (results[(size_t) i].isValid());
+                expectEquals (results[(size_t) i].bpm, single.bpm);
+                expect (results[(size_t) i].beats == single.beats);
+                expect (analyser.getCachedAnalysis (files[i], 0.5f).isValid());
+
+                analyser.getCacheFile (files[i]).deleteFile();
+            }
+        }
+    }
+};
+
+static AudioFileAnalyserTests audioFileAnalyserTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class AudioFileAnalyserBenchmarks  : public juce::UnitTest
+{
+public:
+    AudioFileAnalyserBenchmarks()
+        : juce::UnitTest ("AudioFileAnalyser Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace audio_file_analyser_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+        AudioFileAnalyser analyser (engine);
+
+        beginTest ("Analyse 32 one minute files");
+
+        juce::OwnedArray<juce::TemporaryFile> tempFiles;
+        juce::Array<AudioFile> files;
+
+        for (int i = 0; i < 32; ++i)
+        {
+            auto tempFile = tempFiles.add (new juce::TemporaryFile (".wav"));
+            writeClickTrack (engine, tempFile->getFile(), 80.0 + i * 3.0, 60.0);
+            files.add (AudioFile (engine, tempFile->getFile()));
+            analyser.getCacheFile (files.getLast()).deleteFile();
+        }
+
+        {
+            const StopwatchTimer timer;
+
+            for (auto& f : files)
+                analyseWithSeparatePasses (engine, f.getFile(), 0.5f);
+
+            benchmark_utilities::printTime ("Separate tempo and beat passes, one file at a time", timer);
+        }
+
+        {
+            const StopwatchTimer timer;
+
+            for (auto& f : files)
+                AudioFileAnalyser::analyseFile (engine, f, 0.5f);
+
+            benchmark_utilities::printTime ("Single pass, one file at a time", timer);
+        }
+
+        {
+            const StopwatchTimer timer;
+            analyser.analyse (files, 0.5f);
+            benchmark_utilities::printTime ("Single pass, all threads", timer);
+        }
+
+        {
+            const StopwatchTimer timer;
+            auto results = analyser.analyse (files, 0.5f);
+            benchmark_utilities::printTime ("Cached", timer);
+            expect (std::all_of (results.begin(), results.end(), [] (auto& r) { return r.isValid(); }));
+        }
+
+        for (auto& f : files)
+            analyser.getCacheFile (f).deleteFile();
+    }
+
+private:
+    /** The way the tempo and beats were found before, reading the file once for each. */
+    static void analyseWithSeparatePasses (Engine& engine, const juce::File& file, float sensitivity)
+    {
+        if (auto reader = std::unique_ptr<juce::AudioFormatReader> (AudioFileUtils::createReaderFor (engine, file)))
+        {
+            TempoDetect tempoDetect ((int) reader->numChannels, reader->sampleRate);
+            tempoDetect.processReader (*reader);
+        }
+
+        if (auto reader = std::unique_ptr<juce::AudioFormatReader> (AudioFileUtils::createReaderFor (engine, file)))
+        {
+            BeatDetect beatDetect;
+            beatDetect.setSensitivity (sensitivity);
+            beatDetect.setSampleRate (reader->sampleRate);
+
+            const int blockSize = beatDetect.getBlockSize();
+            juce::AudioBuffer<float> buffer ((int) reader->numChannels, blockSize);
+
+            for (juce::int64 pos = 0; pos + blockSize <= reader->lengthInSamples; pos += blockSize)
+            {
+                reader->read (&buffer, 0, blockSize, pos, true, reader->numChannels > 1);
+                beatDetect.audioProcess (buffer.getArrayOfReadPointers(), buffer.getNumChannels());
+            }
+        }
+    }
+};
+
+static AudioFileAnalyserBenchmarks audioFileAnalyserBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
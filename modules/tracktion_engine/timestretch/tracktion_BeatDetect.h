@@ -28,19 +28,41 @@ struct BeatDetect
         sensitivity = C_MIN + newSensitivity * (C_MAX - C_MIN);
     }
 
-    void audioProcess (const float** inputs, int numChans)
+    /** Processes a block of getBlockSize() samples, returning its sum of squares. */
+    double audioProcess (const float** inputs, int numChans)
     {
         double blockEnergy = 0;
 
         for (int chan = numChans; --chan >= 0;)
-        {
-            const float* const c = inputs[chan];
-
-            for (int i = 0; i < blockSize; ++i)
-                blockEnergy += static_cast<double> (c[i] * c[i]);
-        }
+            blockEnergy += getSumOfSquares (inputs[chan], blockSize);
 
         pushEnergy (blockEnergy);
+        return blockEnergy;
+    }
+
+    /** Returns the sum of the squares of some samples.
+        This keeps eight separate sums so the compiler can vectorise the loop, which it
+        can't do with a single running total as that would change the rounding.
+    */
+    static double getSumOfSquares (const float* samples, int numSamples) noexcept
+    {
+        constexpr int numLanes = 8;
+        float sums[numLanes] = {};
+        int i = 0;
+
+        for (; i + numLanes <= numSamples; i += numLanes)
+            for (int lane = 0; lane < numLanes; ++lane)
+                sums[lane] += samples[i + lane] * samples[i + lane];
+
+        double total = 0;
+
+        for (auto sum : sums)
+            total += static_cast<double> (sum);
+
+        for (; i < numSamples; ++i)
+            total += static_cast<double> (samples[i] * samples[i]);
+
+        return total;
     }
 
     int getBlockSize()                      { return blockSize; }
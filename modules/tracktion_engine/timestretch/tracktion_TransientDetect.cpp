@@ -0,0 +1,265 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+TransientDetect::TransientDetect (Engine& e, const AudioFile& f, float sens)
+    : engine (e), file (f), sensitivity (sens)
+{
+}
+
+TransientDetect::~TransientDetect()
+{
+    cancel();
+}
+
+bool TransientDetect::start (int numThreads)
+{
+    CRASH_TRACER
+    jassert (pool == nullptr);
+
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (AudioFileUtils::createReaderFor (engine, file.getFile()));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        {
+            failed = true;
+            return false;
+        }
+
+        numChannels = (int) reader->numChannels;
+        numSamples = reader->lengthInSamples;
+        sampleRate = reader->sampleRate;
+    }
+
+    // Frames are centred on each hop so there's one at the very start of the file
+    const auto numFrames = (int) ((numSamples + hopSize - 1) / hopSize);
+    flux.assign ((size_t) numFrames, 0.0f);
+
+    // Use a few chunks per thread so they all finish at about the same time
+    constexpr int minFramesPerChunk = 512;
+    const int numChunksWanted = juce::jlimit (1, juce::jmax (1, numFrames / minFramesPerChunk), juce::jmax (1, numThreads) * 4);
+    const int framesPerChunk = (numFrames + numChunksWanted - 1) / numChunksWanted;
+    const int numChunks = (numFrames + framesPerChunk - 1) / framesPerChunk;
+
+    numChunksLeft = numChunks;
+    pool = std::make_unique<juce::ThreadPool> (juce::jlimit (1, numChunks, numThreads));
+
+    for (int firstFrame = 0; firstFrame < numFrames; firstFrame += framesPerChunk)
+    {
+        const int endFrame = juce::jmin (numFrames, firstFrame + framesPerChunk);
+
+        pool->addJob ([this, firstFrame, endFrame]
+                      {
+                          processChunk (firstFrame, endFrame);
+
+                          if (--numChunksLeft == 0)
+                              finishedEvent.signal();
+                      });
+    }
+
+    return true;
+}
+
+void TransientDetect::cancel()
+{
+    shouldStop = true;
+    pool.reset();
+}
+
+bool TransientDetect::waitForFinish (int timeOutMilliseconds)
+{
+    if (pool == nullptr)
+        return true;
+
+    return finishedEvent.wait (timeOutMilliseconds);
+}
+
+float TransientDetect::getProgress() const noexcept
+{
+    if (flux.empty())
+        return 0.0f;
+
+    return juce::jmin (1.0f, numFramesDone.load() / (float) flux.size());
+}
+
+juce::Array<double> TransientDetect::getTransientTimes()
+{
+    if (pool == nullptr || shouldStop || failed || ! finishedEvent.wait (0))
+        return {};
+
+    const auto minFramesBetweenPeaks = juce::roundToInt (0.1 * sampleRate / hopSize);
+    const auto lengthInSeconds = numSamples / sampleRate;
+    juce::Array<double> times;
+
+    // The flux is highest when the onset is just after the centre of the frame
+    for (auto frame : pickPeaks (flux, sensitivity, minFramesBetweenPeaks))
+        times.add (juce::jmin (lengthInSeconds, (frame * hopSize + hopSize / 2) / sampleRate));
+
+    return times;
+}
+
+juce::Array<double> TransientDetect::findTransients (Engine& engine, const AudioFile& file, float sensitivity, int numThreads)
+{
+    TransientDetect detect (engine, file, sensitivity);
+
+    if (! detect.start (numThreads))
+        return {};
+
+    detect.waitForFinish (-1);
+    return detect.getTransientTimes();
+}
+
+//==============================================================================
+float TransientDetect::getSpectralFlux (const float* magnitudes, const float* previousMagnitudes, int numBins) noexcept
+{
+    constexpr int numLanes = 8;
+    float sums[numLanes] = {};
+    int i = 0;
+
+    for (; i + numLanes <= numBins; i += numLanes)
+        for (int lane = 0; lane < numLanes; ++lane)
+            sums[lane] += juce::jmax (0.0f, magnitudes[i + lane] - previousMagnitudes[i + lane]);
+
+    float total = 0.0f;
+
+    for (auto sum : sums)
+        total += sum;
+
+    for (; i < numBins; ++i)
+        total += juce::jmax (0.0f, magnitudes[i] - previousMagnitudes[i]);
+
+    return total;
+}
+
+juce::Array<int> TransientDetect::pickPeaks (const std::vector<float>& flux, float sensitivity, int minFramesBetweenPeaks)
+{
+    juce::Array<int> peaks;
+    const auto numFrames = (int) flux.size();
+
+    if (numFrames == 0)
+        return peaks;
+
+    const auto maxFlux = *std::max_element (flux.begin(), flux.end());
+
+    if (maxFlux <= 0.0f)
+        return peaks;
+
+    constexpr int localMaxRadius = 3;
+    constexpr int averageRadius = 16;
+    const auto delta = maxFlux * juce::jmap (juce::jlimit (0.0f, 1.0f, sensitivity), 0.4f, 0.02f);
+
+    double windowSum = 0.0;
+    int windowStart = 0, windowEnd = 0;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const auto value = flux[(size_t) i];
+
+        while (windowEnd < juce::jmin (numFrames, i + averageRadius + 1))
+            windowSum += flux[(size_t) windowEnd++];
+
+        while (windowStart < i - averageRadius)
+            windowSum -= flux[(size_t) windowStart++];
+
+        if (value < (float) (windowSum / (windowEnd - windowStart)) + delta)
+            continue;
+
+        // Where neighbouring frames are equal, the first one is the peak
+        bool isLocalMax = true;
+
+        for (int j = juce::jmax (0, i - localMaxRadius); j <= juce::jmin (numFrames - 1, i + localMaxRadius); ++j)
+        {
+            if (j < i ? flux[(size_t) j] >= value : flux[(size_t) j] > value)
+            {
+                isLocalMax = false;
+                break;
+            }
+        }
+
+        if (! isLocalMax)
+            continue;
+
+        if (! peaks.isEmpty() && i - peaks.getLast() < minFramesBetweenPeaks)
+        {
+            if (value > flux[(size_t) peaks.getLast()])
+                peaks.setUnchecked (peaks.size() - 1, i);
+
+            continue;
+        }
+
+        peaks.add (i);
+    }
+
+    return peaks;
+}
+
+//==============================================================================
+void TransientDetect::processChunk (int firstFrame, int endFrame)
+{
+    CRASH_TRACER
+    auto reader = AudioFileAnalyser::createReader (engine, file.getFile());
+
+    if (reader == nullptr)
+    {
+        failed = true;
+        return;
+    }
+
+    constexpr int numBins = fftSize / 2 + 1;
+    constexpr int framesPerBlock = 64;
+
+    juce::dsp::FFT fft (fftOrder);
+    std::vector<float> window ((size_t) fftSize), fftData ((size_t) fftSize * 2), previous ((size_t) numBins, 0.0f);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) fftSize,
+                                                              juce::dsp::WindowingFunction<float>::hann, false);
+
+    juce::AudioBuffer<float> buffer (numChannels, (framesPerBlock - 1) * hopSize + fftSize);
+
+    // Start a frame early so the first one has the previous spectrum to compare with
+    int frame = juce::jmax (0, firstFrame - 1);
+
+    while (frame < endFrame)
+    {
+        if (shouldStop)
+            return;
+
+        const int numFrames = juce::jmin (framesPerBlock, endFrame - frame);
+        const int numSamplesNeeded = (numFrames - 1) * hopSize + fftSize;
+
+        // Anything before the start or after the end of the file is read as silence
+        reader->read (&buffer, 0, numSamplesNeeded, (juce::int64) frame * hopSize - fftSize / 2, true, numChannels > 1);
+
+        for (int chan = 1; chan < numChannels; ++chan)
+            buffer.addFrom (0, 0, buffer, chan, 0, numSamplesNeeded);
+
+        if (numChannels > 1)
+            buffer.applyGain (0, 0, numSamplesNeeded, 1.0f / (float) numChannels);
+
+        auto mono = buffer.getReadPointer (0);
+
+        for (int i = 0; i < numFrames; ++i, ++frame)
+        {
+            juce::FloatVectorOperations::multiply (fftData.data(), mono + i * hopSize, window.data(), fftSize);
+            juce::FloatVectorOperations::clear (fftData.data() + fftSize, fftSize);
+            fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+            if (frame >= firstFrame)
+                flux[(size_t) frame] = getSpectralFlux (fftData.data(), previous.data(), numBins);
+
+            std::copy (fftData.begin(), fftData.begin() + numBins, previous.begin());
+        }
+
+        numFramesDone += numFrames;
+    }
+}
+
+} // namespace tracktion_engine
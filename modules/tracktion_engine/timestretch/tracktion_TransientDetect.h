@@ -0,0 +1,93 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Finds the transients in an audio file using spectral flux.
+
+    The file is split in to chunks which are analysed in parallel on a pool of
+    threads. Each chunk also analyses the frame before it so the flux is the same
+    as if the file had been read from start to finish, then the peaks are picked
+    from the whole file's flux once all the chunks have finished.
+*/
+class TransientDetect
+{
+public:
+    /** Creates a detector for a file. Call start() to begin the analysis. */
+    TransientDetect (Engine&, const AudioFile&, float sensitivity);
+
+    /** Destructor. Stops the analysis if it's still running. */
+    ~TransientDetect();
+
+    /** Starts analysing the file, returning false if it can't be read. */
+    bool start (int numThreads = juce::SystemStats::getNumCpus());
+
+    /** Stops the analysis. getTransientTimes() will return an empty array. */
+    void cancel();
+
+    /** Waits for the analysis to finish, returning true if it has. */
+    bool waitForFinish (int timeOutMilliseconds);
+
+    /** Returns true if the file couldn't be read, either when starting or during the analysis.
+        In that case getTransientTimes() returns an empty array which shouldn't be taken to
+        mean the file has no transients.
+    */
+    bool hasFailed() const noexcept                 { return failed; }
+
+    /** Returns how far through the analysis is, from 0 to 1. */
+    float getProgress() const noexcept;
+
+    /** Returns the times of the transients in seconds once the analysis has finished. */
+    juce::Array<double> getTransientTimes();
+
+    /** Runs the detection, blocking until it's done. */
+    static juce::Array<double> findTransients (Engine&, const AudioFile&, float sensitivity,
+                                               int numThreads = juce::SystemStats::getNumCpus());
+
+    //==============================================================================
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+
+    /** Returns the sum of the increases in magnitude from one spectrum to the next.
+        Like BeatDetect::getSumOfSquares(), this uses separate sums so it can be vectorised.
+    */
+    static float getSpectralFlux (const float* magnitudes, const float* previousMagnitudes, int numBins) noexcept;
+
+    /** Returns the indexes of the frames that are onsets.
+        A frame is an onset if it's the largest in its neighbourhood and higher than the
+        local average by an amount which gets smaller as the sensitivity increases.
+    */
+    static juce::Array<int> pickPeaks (const std::vector<float>& flux, float sensitivity, int minFramesBetweenPeaks);
+
+private:
+    //==============================================================================
+    Engine& engine;
+    AudioFile file;
+    float sensitivity;
+    int numChannels = 0;
+    juce::int64 numSamples = 0;
+    double sampleRate = 0.0;
+
+    std::vector<float> flux;
+    std::unique_ptr<juce::ThreadPool> pool;
+    juce::WaitableEvent finishedEvent { true };
+    std::atomic<int> numChunksLeft { 0 }, numFramesDone { 0 };
+    std::atomic<bool> shouldStop { false }, failed { false };
+
+    void processChunk (int firstFrame, int endFrame);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransientDetect)
+};
+
+} // namespace tracktion_engine
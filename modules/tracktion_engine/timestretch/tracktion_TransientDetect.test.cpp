@@ -0,0 +1,173 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+class TransientDetectTests  : public juce::UnitTest
+{
+public:
+    TransientDetectTests()
+        : juce::UnitTest ("TransientDetect", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace audio_file_analyser_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+
+        beginTest ("Spectral flux");
+        {
+            juce::Random r (42);
+            std::vector<float> magnitudes (513), previous (513);
+            float expected = 0.0f;
+
+            for (size_t i = 0; i < magnitudes.size(); ++i)
+            {
+                magnitudes[i] = r.nextFloat();
+                previous[i] = r.nextFloat();
+                expected += juce::jmax (0.0f, magnitudes[i] - previous[i]);
+            }
+
+            expectWithinAbsoluteError (TransientDetect::getSpectralFlux (magnitudes.data(), previous.data(), (int) magnitudes.size()),
+                                       expected, expected * 1.0e-5f);
+        }
+
+        beginTest ("Peak picking");
+        {
+            std::vector<float> flux (200, 0.1f);
+            flux[20] = 1.0f;
+            flux[21] = 0.8f;
+            flux[60] = 0.5f;
+            flux[65] = 0.6f;    // Too close to the last one, but higher so replaces it
+            flux[120] = 0.15f;  // Too quiet
+
+            auto peaks = TransientDetect::pickPeaks (flux, 0.5f, 10);
+            expect (peaks == juce::Array<int> ({ 20, 65 }));
+
+            expect (TransientDetect::pickPeaks (flux, 1.0f, 10).contains (120));
+            expect (TransientDetect::pickPeaks (std::vector<float> (100, 0.0f), 0.5f, 10).isEmpty());
+        }
+
+        beginTest ("Click track transients");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            writeClickTrack (engine, tempFile.getFile(), 120.0, 10.0);
+            AudioFile file (engine, tempFile.getFile());
+
+            auto times = TransientDetect::findTransients (engine, file, 0.5f, 1);
+            auto clicks = getClickPositions (120.0, 10.0);
+            expectEquals (times.size(), clicks.size());
+
+            for (int i = 0; i < juce::jmin (times.size(), clicks.size()); ++i)
+                expectWithinAbsoluteError (times[i], clicks[i] / sampleRate, 0.005);
+
+            // Splitting the file in to chunks doesn't change the results
+            expect (TransientDetect::findTransients (engine, file, 0.5f, 4) == times);
+        }
+
+        beginTest ("Cancelling");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            writeClickTrack (engine, tempFile.getFile(), 120.0, 30.0);
+
+            TransientDetect detect (engine, AudioFile (engine, tempFile.getFile()), 0.5f);
+            expect (detect.start (2));
+            detect.cancel();
+
+            expect (detect.getTransientTimes().isEmpty());
+            expect (! detect.hasFailed());
+        }
+
+        beginTest ("Unreadable files");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            tempFile.getFile().replaceWithText ("Not a wav file");
+
+            TransientDetect detect (engine, AudioFile (engine, tempFile.getFile()), 0.5f);
+            expect (! detect.start (2));
+            expect (detect.hasFailed());
+            expect (detect.getTransientTimes().isEmpty());
+        }
+
+        beginTest ("Cached transients");
+        {
+            juce::TemporaryFile tempFile (".wav");
+            writeClickTrack (engine, tempFile.getFile(), 100.0, 5.0);
+            AudioFile file (engine, tempFile.getFile());
+            AudioFileAnalyser analyser (engine);
+
+            expect (! analyser.getCachedTransients (file, 0.5f).first);
+
+            auto times = TransientDetect::findTransients (engine, file, 0.5f);
+            analyser.saveTransients (file, 0.5f, times, tempFile.getFile().getLastModificationTime());
+
+            auto cached = analyser.getCachedTransients (file, 0.5f);
+            expect (cached.first);
+            expectEquals (cached.second.size(), times.size());
+
+            for (int i = 0; i < juce::jmin (times.size(), cached.second.size()); ++i)
+                expectWithinAbsoluteError (cached.second[i], times[i], 1.0e-9);
+
+            expect (! analyser.getCachedTransients (file, 0.75f).first);
+
+            analyser.getTransientCacheFile (file).deleteFile();
+        }
+    }
+};
+
+static TransientDetectTests transientDetectTests;
+
+#endif
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+//==============================================================================
+class TransientDetectBenchmarks  : public juce::UnitTest
+{
+public:
+    TransientDetectBenchmarks()
+        : juce::UnitTest ("TransientDetect Benchmarks", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        using namespace audio_file_analyser_test_utilities;
+        auto& engine = *Engine::getEngines().getFirst();
+
+        beginTest ("Detect transients in a five minute file");
+
+        juce::TemporaryFile tempFile (".wav");
+        const double durationSeconds = 300.0;
+        writeClickTrack (engine, tempFile.getFile(), 128.0, durationSeconds);
+        AudioFile file (engine, tempFile.getFile());
+
+        for (int numThreads : { 1, 2, 4, juce::SystemStats::getNumCpus() })
+        {
+            const StopwatchTimer timer;
+            auto times = TransientDetect::findTransients (engine, file, 0.5f, numThreads);
+
+            expect (! times.isEmpty());
+            benchmark_utilities::printRealTimeFactor (timer, durationSeconds,
+                                                      juce::String (numThreads) + " threads, " + juce::String (times.size()) + " transients");
+        }
+    }
+};
+
+static TransientDetectBenchmarks transientDetectBenchmarks;
+
+#endif
+
+} // namespace tracktion_engine
@@ -254,6 +254,8 @@ namespace tracktion_engine
     struct TrackInsertPoint;
     struct TrackList;
     class TrackCompManager;
+    class AutoFreezer;
+    class EditChangeTracker;
     class CompFactory;
     class WarpTimeFactory;
     class TempoSequence;
@@ -315,6 +317,8 @@ namespace tracktion_engine
     class ProjectManager;
     class ExternalAutomatableParameter;
     class ExternalPlugin;
+    class ExternalPluginPreloader;
+    class SandboxedPluginInstance;
     struct PluginWindowState;
     class PluginInstanceWrapper;
     struct LiveClipLevel;
@@ -349,6 +353,8 @@ namespace tracktion_engine
 #include "utilities/tracktion_CrashTracer.h"
 #include "utilities/tracktion_AsyncFunctionUtils.h"
 #include "utilities/tracktion_CpuMeasurement.h"
+#include "utilities/tracktion_TestUtilities.h"
+#include "utilities/tracktion_RealTimeStateSwap.h"
 #include "utilities/tracktion_ConstrainedCachedValue.h"
 #include "utilities/tracktion_FileUtilities.h"
 #include "utilities/tracktion_AudioUtilities.h"
@@ -371,6 +377,7 @@ namespace tracktion_engine
 #include "utilities/tracktion_CurveEditor.h"
 #include "utilities/tracktion_Envelope.h"
 #include "utilities/tracktion_Oscillators.h"
+#include "utilities/tracktion_PartitionedConvolver.h"
 
 #include "project/tracktion_ProjectItemID.h"
 
@@ -427,6 +434,7 @@ namespace tracktion_engine
 #include "playback/tracktion_LevelMeasurer.h"
 
 #include "plugins/external/tracktion_VSTXML.h"
+#include "plugins/external/tracktion_PluginSandbox.h"
 #include "plugins/external/tracktion_ExternalPlugin.h"
 
 #include "plugins/internal/tracktion_VCA.h"
@@ -449,6 +457,8 @@ namespace tracktion_engine
 #include "model/edit/tracktion_PitchSetting.h"
 #include "model/edit/tracktion_PitchSequence.h"
 #include "model/edit/tracktion_Edit.h"
+#include "model/edit/tracktion_EditChangeTracker.h"
+#include "plugins/external/tracktion_ExternalPluginPreloader.h"
 
 #include "playback/tracktion_TransportControl.h"
 #include "playback/tracktion_AbletonLink.h"
@@ -493,12 +503,16 @@ namespace tracktion_engine
 #include "model/tracks/tracktion_AudioTrack.h"
 
 #include "timestretch/tracktion_BeatDetect.h"
+#include "timestretch/tracktion_AudioFileAnalyser.h"
+#include "timestretch/tracktion_TransientDetect.h"
 #include "timestretch/tracktion_TimeStretch.h"
 
 #include "model/export/tracktion_ArchiveFile.h"
 #include "model/export/tracktion_ExportJob.h"
 #include "model/export/tracktion_ReferencedMaterialList.h"
 #include "model/export/tracktion_Renderer.h"
+#include "model/export/tracktion_StreamingEncoder.h"
+#include "model/export/tracktion_IncrementalRenderer.h"
 #include "model/export/tracktion_RenderManager.h"
 
 #include "model/edit/tracktion_QuantisationType.h"
@@ -532,6 +546,7 @@ namespace tracktion_engine
 #include "model/tracks/tracktion_TrackCompManager.h"
 #include "model/export/tracktion_RenderOptions.h"
 #include "model/clips/tracktion_EditClipRenderJob.h"
+#include "model/tracks/tracktion_AutoFreezer.h"
 
 #include "selection/tracktion_Clipboard.h"
 
@@ -29,6 +29,7 @@ extern "C"
 #include <string>
 
 #include "audio_files/formats/tracktion_FloatAudioFileFormat.cpp"
+#include "audio_files/formats/tracktion_FloatAudioFileFormat.test.cpp"
 #include "audio_files/formats/tracktion_RexFileFormat.cpp"
 #include "audio_files/formats/tracktion_LAMEManager.cpp"
 
@@ -40,6 +41,7 @@ extern "C"
 #include "audio_files/tracktion_AudioFormatManager.cpp"
 
 #include "midi/tracktion_MidiList.cpp"
+#include "midi/tracktion_MidiList.test.cpp"
 #include "midi/tracktion_MidiProgramManager.cpp"
 #include "midi/tracktion_Musicality.cpp"
 #include "midi/tracktion_SelectedMidiEvents.cpp"
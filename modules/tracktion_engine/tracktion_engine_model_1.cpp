@@ -22,6 +22,9 @@ using namespace juce;
 #include "model/edit/tracktion_OldEditConversion.h"
 #include "model/edit/tracktion_EditItem.cpp"
 #include "model/edit/tracktion_Edit.cpp"
+#include "model/edit/tracktion_Edit.test.cpp"
+#include "model/edit/tracktion_EditChangeTracker.cpp"
+#include "model/edit/tracktion_EditChangeTracker.test.cpp"
 #include "model/edit/tracktion_EditUtilities.cpp"
 #include "model/edit/tracktion_SourceFileReference.cpp"
 #include "model/clips/tracktion_Clip.cpp"
@@ -56,6 +59,7 @@ using namespace juce;
 #include "model/clips/tracktion_StepClipPattern.cpp"
 #include "model/clips/tracktion_StepClip.cpp"
 #include "model/clips/tracktion_ClipEffects.cpp"
+#include "model/clips/tracktion_ClipEffects.test.cpp"
 #include "model/clips/tracktion_WarpTimeManager.cpp"
 
 #endif
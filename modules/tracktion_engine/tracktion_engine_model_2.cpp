@@ -39,6 +39,8 @@ using namespace juce;
 #include "model/tracks/tracktion_TrackItem.cpp"
 #include "model/tracks/tracktion_TrackOutput.cpp"
 #include "model/tracks/tracktion_TrackCompManager.cpp"
+#include "model/tracks/tracktion_AutoFreezer.cpp"
+#include "model/tracks/tracktion_AutoFreezer.test.cpp"
 
 #include "model/edit/tracktion_GrooveTemplate.cpp"
 #include "model/edit/tracktion_MarkerManager.cpp"
@@ -56,8 +58,13 @@ using namespace juce;
 #include "model/export/tracktion_Exportable.cpp"
 #include "model/export/tracktion_ExportJob.cpp"
 #include "model/export/tracktion_Renderer.cpp"
+#include "model/export/tracktion_StreamingEncoder.cpp"
+#include "model/export/tracktion_StreamingEncoder.test.cpp"
+#include "model/export/tracktion_IncrementalRenderer.cpp"
+#include "model/export/tracktion_IncrementalRenderer.test.cpp"
 #include "model/export/tracktion_RenderManager.cpp"
 #include "model/export/tracktion_ArchiveFile.cpp"
+#include "model/export/tracktion_ArchiveFile.test.cpp"
 #include "model/export/tracktion_RenderOptions.cpp"
 #include "model/clips/tracktion_EditClipRenderJob.cpp"
 #include "model/clips/tracktion_AudioSegmentList.cpp"
@@ -68,5 +75,6 @@ using namespace juce;
 #include "project/tracktion_Project.cpp"
 #include "project/tracktion_ProjectManager.cpp"
 #include "project/tracktion_ProjectSearchIndex.cpp"
+#include "project/tracktion_ProjectSearchIndex.test.cpp"
 
 #endif
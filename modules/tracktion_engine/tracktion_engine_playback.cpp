@@ -150,9 +150,13 @@ extern "C"
 #include "playback/graph/tracktion_WaveInputDeviceNode.h"
 #include "playback/graph/tracktion_WaveInputDeviceNode.cpp"
 
+#include "playback/graph/tracktion_AnticipativeNode.h"
+#include "playback/graph/tracktion_AnticipativeNode.cpp"
+
 #include "playback/graph/tracktion_EditNodeBuilder.h"
 #include "playback/graph/tracktion_EditNodeBuilder.cpp"
 #include "playback/graph/tracktion_EditNodeBuilder.test.cpp"
+#include "playback/graph/tracktion_AnticipativeNode.test.cpp"
 
 #include "playback/graph/tracktion_NodeRenderContext.h"
 #include "playback/graph/tracktion_NodeRenderContext.cpp"
@@ -170,6 +174,7 @@ using namespace juce;
 #include "playback/tracktion_EditInputDevices.cpp"
 #include "playback/tracktion_LevelMeasurer.cpp"
 #include "playback/tracktion_MidiNoteDispatcher.cpp"
+#include "playback/tracktion_MidiNoteDispatcher.test.cpp"
 #include "playback/tracktion_TransportControl.test.cpp"
 #include "playback/tracktion_TransportControl.cpp"
 #include "playback/tracktion_AbletonLink.cpp"
@@ -195,6 +200,7 @@ using namespace juce;
 #include "playback/devices/tracktion_OutputDevice.cpp"
 #include "playback/devices/tracktion_WaveDeviceDescription.cpp"
 #include "playback/devices/tracktion_WaveInputDevice.cpp"
+#include "playback/devices/tracktion_WaveInputDevice.test.cpp"
 #include "playback/devices/tracktion_WaveOutputDevice.cpp"
 
 #include "playback/tracktion_HostedAudioDevice.cpp"
@@ -33,6 +33,17 @@
 
 #include "tracktion_engine.h"
 
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_LINUX
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+#endif
+
 using namespace juce;
 
 #include "playback/graph/tracktion_PluginNode.h"
@@ -43,6 +54,8 @@ using namespace juce;
 
 #include "model/automation/modifiers/tracktion_ModifierInternal.h"
 
+#include "plugins/tracktion_PluginTestUtilities.h"
+
 #include "plugins/tracktion_Plugin.cpp"
 #include "plugins/tracktion_PluginList.cpp"
 #include "plugins/tracktion_PluginManager.cpp"
@@ -51,6 +64,10 @@ using namespace juce;
 #include "plugins/external/tracktion_ExternalAutomatableParameter.h"
 #include "plugins/external/tracktion_ExternalPluginBlacklist.h"
 #include "plugins/external/tracktion_ExternalPlugin.cpp"
+#include "plugins/external/tracktion_ExternalPluginPreloader.cpp"
+#include "plugins/external/tracktion_ExternalPluginPreloader.test.cpp"
+#include "plugins/external/tracktion_PluginSandbox.cpp"
+#include "plugins/external/tracktion_PluginSandbox.test.cpp"
 
 #include "plugins/internal/tracktion_AuxReturn.cpp"
 #include "plugins/internal/tracktion_AuxSend.cpp"
@@ -69,6 +86,7 @@ using namespace juce;
 #include "plugins/effects/tracktion_Compressor.cpp"
 #include "plugins/effects/tracktion_Delay.cpp"
 #include "plugins/effects/tracktion_FourOscPlugin.cpp"
+#include "plugins/effects/tracktion_FourOscPlugin.test.cpp"
 #include "plugins/effects/tracktion_LatencyPlugin.cpp"
 #include "plugins/effects/tracktion_Equaliser.cpp"
 #include "plugins/effects/tracktion_ImpulseResponsePlugin.cpp"
@@ -80,6 +98,7 @@ using namespace juce;
 #include "plugins/effects/tracktion_PitchShift.cpp"
 #include "plugins/effects/tracktion_Reverb.cpp"
 #include "plugins/effects/tracktion_SamplerPlugin.cpp"
+#include "plugins/effects/tracktion_SamplerPlugin.test.cpp"
 #include "plugins/effects/tracktion_ToneGenerator.cpp"
 
 #include "plugins/ARA/tracktion_MelodyneFileReader.cpp"
@@ -56,6 +56,11 @@ using namespace juce;
 
 #include "timestretch/tracktion_TimeStretch.cpp"
 #include "timestretch/tracktion_TimeStretch.test.cpp"
+#include "timestretch/tracktion_TempoDetect.h"
+#include "timestretch/tracktion_AudioFileAnalyser.cpp"
+#include "timestretch/tracktion_AudioFileAnalyser.test.cpp"
+#include "timestretch/tracktion_TransientDetect.cpp"
+#include "timestretch/tracktion_TransientDetect.test.cpp"
 
 namespace tracktion_engine
 {
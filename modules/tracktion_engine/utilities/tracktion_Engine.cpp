@@ -73,6 +73,8 @@ void Engine::initialise()
     getProjectManager().initialise();
 
     externalControllerManager->initialise();
+
+    BandlimitedWaveLookupTables::precomputeLookupTables (engineBehaviour->getSampleRatesToPrecomputeWaveTablesFor());
 }
 
 Engine::~Engine()
@@ -58,6 +58,22 @@ public:
     */
     virtual bool shouldBypassedPluginsBeRemovedFromPlaybackGraph()                { return false; }
 
+    /** Should return the number of blocks ahead of the audio callback to process tracks which
+        don't have any live inputs, or 0 to process everything in the audio callback.
+        Rendering ahead on background threads leaves more of the callback free for the tracks
+        that are being monitored, but means changes to those tracks' plugin parameters will
+        be heard up to this many blocks later.
+        @see AnticipativeNode
+    */
+    virtual int getNumBlocksToRenderAhead()                                       { return 0; }
+
+    /** Should return the number of seconds a track has to stay unchanged before it's rendered
+        in the background and played back from the rendered file, or 0 to disable this.
+        Any change to the track switches it back to live playback straight away.
+        @see AutoFreezer
+    */
+    virtual double getAutoFreezeDelaySeconds()                                    { return 0.0; }
+
     /** Gives plugins an opportunity to save custom data when the plugin state gets flushed. */
     virtual void saveCustomPluginProperties (juce::ValueTree&, juce::AudioPluginInstance&, juce::UndoManager*) {}
 
@@ -76,6 +92,47 @@ public:
       */
     virtual bool canScanPluginsOutOfProcess()                                       { return false; }
 
+    /** Should return true if the given plugin can be created and have its state restored
+        on a background thread.
+        When an Edit loads, plugins that return true here are instantiated concurrently on
+        a pool of worker threads, the rest are created one at a time on the message thread.
+        Formats that require an unblocked message thread during creation (e.g. AUv3) are
+        always created on a background thread regardless of this.
+
+        By default this only returns true for LV2 and LADSPA plugins, whose specifications
+        allow them to be instantiated from any non-audio thread. VST, VST3 and AU plugins
+        commonly assume they're created on the message thread so these are loaded one at a
+        time there unless a host overrides this, which means Edits using only those formats
+        won't load any faster.
+        @see ExternalPluginPreloader
+    */
+    virtual bool canCreatePluginOnBackgroundThread (const juce::PluginDescription& desc)
+    {
+        return desc.pluginFormatName == "LV2" || desc.pluginFormatName == "LADSPA";
+    }
+
+    /** Should return the maximum number of threads to use when loading an Edit's plugins. */
+    virtual int getNumThreadsForLoadingPlugins()                                    { return juce::jlimit (1, 8, juce::SystemStats::getNumCpus()); }
+
+    /** Should return the length of audio to buffer for each file being recorded.
+        Larger values use more memory but can cope with slower disks.
+        @see WaveInputRecordingThread::getStatistics
+    */
+    virtual double getRecordingBufferLengthSeconds()                                { return 5.0; }
+
+    /** If this returns true, all the armed inputs of the audio device will be recorded into
+        a single interleaved multichannel file rather than one file per input. The clips
+        created will each reference their own channels of the file.
+    */
+    virtual bool shouldRecordInputsToMultiChannelFile()                             { return false; }
+
+    /** Should return the sample rates to build the oscillator wave tables for when the
+        engine starts. These are built on a background thread, otherwise they're built
+        the first time a synth needs them.
+        @see BandlimitedWaveLookupTables::precomputeLookupTables
+    */
+    virtual juce::Array<double> getSampleRatesToPrecomputeWaveTablesFor()           { return {}; }
+
     // You may want to disable auto initialisation of the device manager if you
     // are using the engine in a plugin
     virtual bool autoInitialiseDeviceManager()                                      { return true; }
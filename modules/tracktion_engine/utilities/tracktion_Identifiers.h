@@ -213,6 +213,7 @@ namespace IDs
     DECLARE_ID (minNote)
     DECLARE_ID (maxNote)
     DECLARE_ID (openEnded)
+    DECLARE_ID (streamFromDisk)
     DECLARE_ID (SOUND)
     DECLARE_ID (threshold)
     DECLARE_ID (inputDb)
@@ -377,6 +378,15 @@ namespace IDs
     DECLARE_ID (oneShot)
     DECLARE_ID (LOOPPOINTS)
     DECLARE_ID (LOOPPOINT)
+    DECLARE_ID (AUDIOANALYSIS)
+    DECLARE_ID (beats)
+    DECLARE_ID (peakLevel)
+    DECLARE_ID (rmsLevel)
+    DECLARE_ID (fileSize)
+    DECLARE_ID (fileTime)
+    DECLARE_ID (TRANSIENTS)
+    DECLARE_ID (sensitivity)
+    DECLARE_ID (times)
     DECLARE_ID (value)
     DECLARE_ID (TAGS)
     DECLARE_ID (TAG)
@@ -632,6 +642,7 @@ namespace IDs
     DECLARE_ID (oscType)
     DECLARE_ID (bandLimit)
     DECLARE_ID (irFileData)
+    DECLARE_ID (separateProcess)
 
     #undef DECLARE_ID
 }
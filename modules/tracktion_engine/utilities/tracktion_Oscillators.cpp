@@ -82,8 +82,8 @@ void Oscillator::process (AudioSampleBuffer& buffer, int startSample, int numSam
             case none:      break;
             case sine:      processSine (buffer, startSample, numSamples);  break;
             case square:    processSquare (buffer, startSample, numSamples);  break;
-            case saw:       processLookup (buffer, startSample, numSamples, lookupTables->sawUpFunctions);    break;
-            case triangle:  processLookup (buffer, startSample, numSamples, lookupTables->triangleFunctions); break;
+            case saw:       processLookup (buffer, startSample, numSamples, BandlimitedWaveLookupTables::Wave::sawUp);    break;
+            case triangle:  processLookup (buffer, startSample, numSamples, BandlimitedWaveLookupTables::Wave::triangle); break;
             case noise:     processNoise (buffer, startSample, numSamples); break;
         }
     }
@@ -125,7 +125,7 @@ void Oscillator::processNoise (AudioSampleBuffer& buffer, int startSample, int n
 }
 
 void Oscillator::processLookup (juce::AudioSampleBuffer& buffer, int startSample, int numSamples,
-                                const juce::OwnedArray<juce::dsp::LookupTableTransform<float>>& tableSet)
+                                BandlimitedWaveLookupTables::Wave tableWave)
 {
     const float frequency = jmin (float (sampleRate) / 2.0f, 440.0f * std::pow (2.0f, (note - 69.0f) / 12.0f));
     const float period = 1.0f / float (frequency);
@@ -135,9 +135,7 @@ void Oscillator::processLookup (juce::AudioSampleBuffer& buffer, int startSample
     auto* channels = buffer.getArrayOfWritePointers();
     const int numChannels = buffer.getNumChannels();
 
-    int tableIndex = jlimit (0, tableSet.size() - 1, int ((note - 0.5) / lookupTables->tablePerNumNotes));
-
-    auto table = tableSet[tableIndex];
+    auto table = lookupTables->getTable (tableWave, note);
     jassert (table != nullptr);
 
     if (table != nullptr)
@@ -165,10 +163,8 @@ void Oscillator::processSquare (juce::AudioSampleBuffer& buffer, int startSample
     auto* channels = buffer.getArrayOfWritePointers();
     const int numChannels = buffer.getNumChannels();
 
-    int tableIndex = jlimit (0, lookupTables->sawUpFunctions.size() - 1, int ((note - 0.5) / lookupTables->tablePerNumNotes));
-
-    auto saw1 = lookupTables->sawUpFunctions[tableIndex];
-    auto saw2 = lookupTables->sawDownFunctions[tableIndex];
+    auto saw1 = lookupTables->getTable (BandlimitedWaveLookupTables::Wave::sawUp, note);
+    auto saw2 = lookupTables->getTable (BandlimitedWaveLookupTables::Wave::sawDown, note);
 
     jassert (saw1 != nullptr && saw2 != nullptr);
 
@@ -214,6 +210,12 @@ void MultiVoiceOscillator::start()
     }
 }
 
+void MultiVoiceOscillator::start (float phase)
+{
+    for (auto o : oscillators)
+        o->start (phase);
+}
+
 void MultiVoiceOscillator::setSampleRate (double sr)
 {
     for (auto o : oscillators)
@@ -312,52 +314,402 @@ void MultiVoiceOscillator::process (juce::AudioSampleBuffer& buffer, int startSa
 }
 
 //==============================================================================
-static Array<BandlimitedWaveLookupTables*> tableCache;
+struct BandlimitedWaveLookupTables::Band
+{
+    // Indexed by Wave
+    juce::OwnedArray<juce::dsp::LookupTableTransform<float>> tables[3];
+};
+
+//==============================================================================
+class BandlimitedWaveLookupTables::Cache  : public juce::Thread,
+                                            private juce::DeletedAtShutdown
+{
+public:
+    Cache()  : juce::Thread ("WaveTableBuilder")
+    {
+        startThread();
+    }
+
+    ~Cache() override
+    {
+        signalThreadShouldExit();
+        bandRequested();
+        stopThread (10000);
+        clearSingletonInstance();
+    }
+
+    JUCE_DECLARE_SINGLETON (Cache, false)
+
+    Ptr getTables (double sampleRate)
+    {
+        const ScopedLock sl (lock);
+        Ptr result;
+
+        for (auto t : tables)
+        {
+            if (t->sampleRate == sampleRate)
+            {
+                result = t;
+                break;
+            }
+        }
 
+        if (result == nullptr)
+            result = tables.add (new BandlimitedWaveLookupTables (sampleRate, 1024));
+
+        result->lastRequestTime = Time::getMillisecondCounter();
+        trimToBudget();
+
+        return result;
+    }
+
+    void setMemoryBudget (juce::int64 numBytes)
+    {
+        const ScopedLock sl (lock);
+        memoryBudget = numBytes;
+        trimToBudget();
+    }
+
+    juce::int64 getMemoryBudget() const
+    {
+        const ScopedLock sl (lock);
+        return memoryBudget;
+    }
+
+    /** Wakes the builder thread without taking any locks, so can be called on the audio thread. */
+    void bandRequested() noexcept
+    {
+        requestSemaphore.signal();
+    }
+
+    juce::int64 getTotalMemoryUsageBytes() const
+    {
+        const ScopedLock sl (lock);
+        juce::int64 total = 0;
+
+        for (auto t : tables)
+            total += t->getMemoryUsageBytes();
+
+        return total;
+    }
+
+private:
+    CriticalSection lock;
+    ReferenceCountedArray<BandlimitedWaveLookupTables> tables;
+    juce::int64 memoryBudget = 16 * 1024 * 1024;
+    tracktion_graph::LightweightSemaphore requestSemaphore;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (! buildNextRequestedBand())
+                requestSemaphore.wait();
+
+            const ScopedLock sl (lock);
+            trimToBudget();
+        }
+    }
+
+    bool buildNextRequestedBand()
+    {
+        ReferenceCountedArray<BandlimitedWaveLookupTables> tablesToCheck;
+
+        {
+            // Only the tables with work to do are held on to, so the others can still be trimmed
+            const ScopedLock sl (lock);
+
+            for (auto t : tables)
+                if (t->hasUnbuiltRequestedBands())
+                    tablesToCheck.add (t);
+        }
+
+        for (auto t : tablesToCheck)
+            if (! threadShouldExit() && t->buildNextRequestedBand())
+                return true;
+
+        return false;
+    }
+
+    /** Deletes the least recently requested tables that aren't in use until they fit the budget. */
+    void trimToBudget()
+    {
+        auto total = getTotalMemoryUsageBytes();
+
+        while (total > memoryBudget)
+        {
+            BandlimitedWaveLookupTables* oldest = nullptr;
+
+            for (auto t : tables)
+                if (t->getReferenceCount() == 1 && (oldest == nullptr || t->lastRequestTime < oldest->lastRequestTime))
+                    oldest = t;
+
+            if (oldest == nullptr)
+                break;
+
+            total -= oldest->getMemoryUsageBytes();
+            tables.removeObject (oldest);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Cache)
+};
+
+JUCE_IMPLEMENT_SINGLETON (BandlimitedWaveLookupTables::Cache)
+
+//==============================================================================
 BandlimitedWaveLookupTables::Ptr BandlimitedWaveLookupTables::getLookupTables (double sampleRate)
 {
-    for (auto table : tableCache)
-        if (table->sampleRate == sampleRate)
-            return table;
+    return Cache::getInstance()->getTables (sampleRate);
+}
+
+void BandlimitedWaveLookupTables::precomputeLookupTables (const juce::Array<double>& sampleRates)
+{
+    for (auto sampleRate : sampleRates)
+    {
+        auto tables = getLookupTables (sampleRate);
+
+        for (int i = 0; i < numBands; ++i)
+            tables->requestBand (i);
+    }
+}
+
+void BandlimitedWaveLookupTables::setMemoryBudget (juce::int64 numBytes)
+{
+    Cache::getInstance()->setMemoryBudget (numBytes);
+}
+
+juce::int64 BandlimitedWaveLookupTables::getMemoryBudget()
+{
+    return Cache::getInstance()->getMemoryBudget();
+}
+
+juce::int64 BandlimitedWaveLookupTables::getTotalMemoryUsageBytes()
+{
+    return Cache::getInstance()->getTotalMemoryUsageBytes();
+}
+
+BandlimitedWaveLookupTables::BandlimitedWaveLookupTables (double sr, int size)
+    : sampleRate (sr), tableSize (size),
+      sineFunction ([] (float in) { return sine (in); }, 0.0f, 1.0f, (size_t) size)
+{
+    for (int i = 0; i < numBands; ++i)
+    {
+        bands[i] = nullptr;
+        bandRequested[i] = false;
+    }
 
-    Ptr table = new BandlimitedWaveLookupTables (sampleRate, 1024);
-    return table;
+    // The top octave only has a few harmonics so is quick to build and
+    // means there's always a table to fall back on
+    buildBand (numBands - 1);
 }
 
-BandlimitedWaveLookupTables::BandlimitedWaveLookupTables (double sr, int tableSize)
-    : sampleRate (sr),
-    sineFunction ([] (float in) { return sine (in); }, 0.0f, 1.0f, (size_t) tableSize)
+BandlimitedWaveLookupTables::~BandlimitedWaveLookupTables()
+{
+    for (auto& b : bands)
+        delete b.load();
+}
+
+const juce::dsp::LookupTableTransform<float>* BandlimitedWaveLookupTables::getTable (Wave wave, float note) const noexcept
+{
+    const int tableIndex = jlimit (0, numTables - 1, int ((note - 0.5f) / tablePerNumNotes));
+    const int bandIndex = tableIndex / tablesPerBand;
+
+    if (auto band = bands[bandIndex].load (std::memory_order_acquire))
+        return band->tables[(int) wave].getUnchecked (tableIndex % tablesPerBand);
+
+    requestBand (bandIndex);
+
+    for (int i = bandIndex + 1; i < numBands; ++i)
+        if (auto band = bands[i].load (std::memory_order_acquire))
+            return band->tables[(int) wave].getFirst();
+
+    jassertfalse;
+    return nullptr;
+}
+
+void BandlimitedWaveLookupTables::buildAllTables()
+{
+    for (int i = numBands; --i >= 0;)
+        if (bands[i].load (std::memory_order_acquire) == nullptr)
+            buildBand (i);
+}
+
+bool BandlimitedWaveLookupTables::isFullyBuilt() const noexcept
+{
+    for (auto& b : bands)
+        if (b.load (std::memory_order_acquire) == nullptr)
+            return false;
+
+    return true;
+}
+
+juce::int64 BandlimitedWaveLookupTables::getMemoryUsageBytes() const noexcept
+{
+    // Each LookupTable holds an extra point for the interpolation
+    const auto bytesPerTable = (juce::int64) (tableSize + 1) * (juce::int64) sizeof (float);
+    juce::int64 numTablesBuilt = 1;
+
+    for (auto& b : bands)
+        if (auto band = b.load (std::memory_order_acquire))
+            for (auto& t : band->tables)
+                numTablesBuilt += t.size();
+
+    return numTablesBuilt * bytesPerTable;
+}
+
+void BandlimitedWaveLookupTables::requestBand (int band) const noexcept
+{
+    if (! bandRequested[band].exchange (true))
+        if (auto cache = Cache::getInstanceWithoutCreating())
+            cache->bandRequested();
+}
+
+bool BandlimitedWaveLookupTables::hasUnbuiltRequestedBands() const noexcept
+{
+    for (int i = 0; i < numBands; ++i)
+        if (bandRequested[i] && bands[i].load (std::memory_order_acquire) == nullptr)
+            return true;
+
+    return false;
+}
+
+bool BandlimitedWaveLookupTables::buildNextRequestedBand()
+{
+    // The higher octaves are quicker to build so do those first
+    for (int i = numBands; --i >= 0;)
+    {
+        if (bandRequested[i] && bands[i].load() == nullptr)
+        {
+            buildBand (i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BandlimitedWaveLookupTables::buildBand (int bandIndex)
 {
     auto getMidiNoteInHertz = [](float noteNumber)
     {
         return 440.0f * std::pow (2.0f, (noteNumber - 69) / 12.0f);
     };
 
-    Time start (Time::getCurrentTime());
+    auto band = std::make_unique<Band>();
+    const auto sr = sampleRate;
+    const auto size = (size_t) tableSize;
 
-    for (float note = tablePerNumNotes + 0.5f; note < 127; note += tablePerNumNotes)
+    for (int i = bandIndex * tablesPerBand; i < jmin (numTables, (bandIndex + 1) * tablesPerBand); ++i)
     {
-        const float freq = getMidiNoteInHertz (note);
+        const float freq = getMidiNoteInHertz (tablePerNumNotes * (i + 1) + 0.5f);
 
-        triangleFunctions.add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
-                               { return triangle (value, freq, sr); }, 0.0f, 1.0f, (size_t) tableSize));
+        band->tables[(int) Wave::triangle].add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
+                                                { return triangle (value, freq, sr); }, 0.0f, 1.0f, size));
 
-        sawUpFunctions.add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
-                            { return sawUp (value, freq, sr); }, 0.0f, 1.0f, (size_t) tableSize));
+        band->tables[(int) Wave::sawUp].add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
+                                             { return sawUp (value, freq, sr); }, 0.0f, 1.0f, size));
 
-        sawDownFunctions.add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
-                              { return sawDown (value, freq, sr); }, 0.0f, 1.0f, (size_t) tableSize));
+        band->tables[(int) Wave::sawDown].add (new juce::dsp::LookupTableTransform<float> ([freq, sr] (float value)
+                                               { return sawDown (value, freq, sr); }, 0.0f, 1.0f, size));
     }
 
-    RelativeTime elapsed (Time::getCurrentTime() - start);
-    DBG ("Generating waves: " + String (elapsed.inMilliseconds()) + "ms");
+    // A render thread and the builder thread may both have built this, in which case the
+    // first one is kept as oscillators may already be using it
+    bandRequested[bandIndex] = true;
+    Band* noBand = nullptr;
 
-    tableCache.add (this);
+    if (bands[bandIndex].compare_exchange_strong (noBand, band.get(), std::memory_order_acq_rel))
+        band.release();
 }
 
-BandlimitedWaveLookupTables::~BandlimitedWaveLookupTables()
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class BandlimitedWaveLookupTablesTests   : public juce::UnitTest
 {
-    tableCache.removeFirstMatchingValue (this);
-}
+public:
+    BandlimitedWaveLookupTablesTests()
+        : juce::UnitTest ("BandlimitedWaveLookupTables", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        using Wave = BandlimitedWaveLookupTables::Wave;
+        const auto bytesPerTable = (juce::int64) (1024 + 1) * (juce::int64) sizeof (float);
+
+        beginTest ("Tables are shared between oscillators");
+        {
+            auto tables1 = BandlimitedWaveLookupTables::getLookupTables (11025.0);
+            auto tables2 = BandlimitedWaveLookupTables::getLookupTables (11025.0);
+            auto tables3 = BandlimitedWaveLookupTables::getLookupTables (22050.0);
+
+            expect (tables1 == tables2);
+            expect (tables1 != tables3);
+        }
+
+        beginTest ("Octaves are built when they're first needed");
+        {
+            auto tables = BandlimitedWaveLookupTables::getLookupTables (12345.0);
+
+            // Only the sine and the top octave's tables are built straight away
+            expect (! tables->isFullyBuilt());
+            expectEquals (tables->getMemoryUsageBytes(), (1 + 2 * 3) * bytesPerTable);
+            expect (tables->getTable (Wave::sawUp, 127.0f) != nullptr);
+
+            // A low note falls back to a higher table until its own one is ready
+            auto fallback = tables->getTable (Wave::sawUp, 20.0f);
+            expect (fallback != nullptr);
+
+            expect (waitFor ([&] { return tables->getTable (Wave::sawUp, 20.0f) != fallback; }));
+            expect (! tables->isFullyBuilt());
+        }
+
+        beginTest ("Precomputing tables");
+        {
+            BandlimitedWaveLookupTables::precomputeLookupTables ({ 23456.0 });
+            auto tables = BandlimitedWaveLookupTables::getLookupTables (23456.0);
+
+            expect (waitFor ([&] { return tables->isFullyBuilt(); }));
+            expectEquals (tables->getMemoryUsageBytes(), (1 + BandlimitedWaveLookupTables::numTables * 3) * bytesPerTable);
+            expectGreaterOrEqual (BandlimitedWaveLookupTables::getTotalMemoryUsageBytes(), tables->getMemoryUsageBytes());
+        }
+
+        beginTest ("Unused tables are deleted to fit the memory budget");
+        {
+            const auto originalBudget = BandlimitedWaveLookupTables::getMemoryBudget();
+            auto inUse = BandlimitedWaveLookupTables::getLookupTables (12345.0);
+
+            // These are built on this thread so the builder thread never holds on to them
+            BandlimitedWaveLookupTables::getLookupTables (34567.0)->buildAllTables();
+            expect (BandlimitedWaveLookupTables::getLookupTables (34567.0)->isFullyBuilt());
+
+            BandlimitedWaveLookupTables::setMemoryBudget (0);
+
+            expect (! BandlimitedWaveLookupTables::getLookupTables (34567.0)->isFullyBuilt());
+            expect (inUse == BandlimitedWaveLookupTables::getLookupTables (12345.0));
+
+            BandlimitedWaveLookupTables::setMemoryBudget (originalBudget);
+        }
+    }
+
+private:
+    static bool waitFor (std::function<bool()> condition)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (condition())
+                return true;
+
+            juce::Thread::sleep (10);
+        }
+
+        return false;
+    }
+};
+
+static BandlimitedWaveLookupTablesTests bandlimitedWaveLookupTablesTests;
+
+#endif // TRACKTION_UNIT_TESTS
 
 }
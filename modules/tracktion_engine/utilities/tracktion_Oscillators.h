@@ -11,6 +11,19 @@ namespace tracktion_engine
 {
 
 //==============================================================================
+/**
+    Band-limited sine, triangle and saw tables for a sample rate, shared by all the
+    oscillators running at that rate.
+
+    Building the tables for the low notes is slow as they contain so many harmonics, so
+    only the sine table and the highest octave are built when these are created. The other
+    octaves are built on a background thread the first time an oscillator needs them, and
+    until then the nearest higher octave that is ready is used in their place. As that
+    depends on timing, offline renders should call buildAllTables() first.
+
+    Tables for sample rates that are no longer in use are kept around so switching back
+    doesn't rebuild them, up to the limit set with setMemoryBudget().
+*/
 class BandlimitedWaveLookupTables : public juce::ReferenceCountedObject
 {
 public:
@@ -18,19 +31,76 @@ public:
 
     using Ptr = juce::ReferenceCountedObjectPtr<BandlimitedWaveLookupTables>;
 
+    /** Returns the shared tables for a sample rate, creating them if needed. */
     static Ptr getLookupTables (double sampleRate);
 
-    double sampleRate = 44100.0;
+    /** Starts building all the tables for the given sample rates on the background thread,
+        so they're ready before any oscillators need them.
+        @see EngineBehaviour::getSampleRatesToPrecomputeWaveTablesFor
+    */
+    static void precomputeLookupTables (const juce::Array<double>& sampleRates);
+
+    /** Sets the maximum amount of memory all the cached tables should use.
+        Tables still in use by an oscillator are never deleted, so this can be exceeded.
+    */
+    static void setMemoryBudget (juce::int64 numBytes);
+    static juce::int64 getMemoryBudget();
+
+    /** Returns the memory used by all the cached tables. */
+    static juce::int64 getTotalMemoryUsageBytes();
 
     //==============================================================================
-    juce::dsp::LookupTableTransform<float> sineFunction;
+    enum class Wave
+    {
+        triangle,
+        sawUp,
+        sawDown
+    };
+
+    /** Returns the table to use for a note.
+        If the note's octave hasn't been built yet, this asks for it to be built and returns
+        the nearest higher table that is ready, which has fewer harmonics so won't alias.
+        This is lock-free so can be called on the audio thread.
+    */
+    const juce::dsp::LookupTableTransform<float>* getTable (Wave, float note) const noexcept;
 
-    juce::OwnedArray<juce::dsp::LookupTableTransform<float>> triangleFunctions, sawUpFunctions, sawDownFunctions;
+    /** Returns true once all of the octaves have been built. */
+    bool isFullyBuilt() const noexcept;
 
-    const int tablePerNumNotes = 3;
+    /** Builds any octaves that haven't been built yet on the calling thread.
+        This is slow so mustn't be called on a real-time thread, but means the output
+        of an offline render doesn't depend on how far the background thread has got.
+    */
+    void buildAllTables();
+
+    /** Returns the memory used by the tables built so far. */
+    juce::int64 getMemoryUsageBytes() const noexcept;
+
+    //==============================================================================
+    const double sampleRate;
+    const int tableSize;
+
+    juce::dsp::LookupTableTransform<float> sineFunction;
+
+    static constexpr int tablePerNumNotes = 3;
+    static constexpr int numTables = 42;
+    static constexpr int tablesPerBand = 12 / tablePerNumNotes;
+    static constexpr int numBands = (numTables + tablesPerBand - 1) / tablesPerBand;
 
 private:
+    class Cache;
+    struct Band;
+
+    std::atomic<Band*> bands[numBands];
+    mutable std::atomic<bool> bandRequested[numBands];
+    juce::uint32 lastRequestTime = 0;
+
     BandlimitedWaveLookupTables (double sampleRate, int tableSize);
+
+    void requestBand (int band) const noexcept;
+    bool hasUnbuiltRequestedBands() const noexcept;
+    bool buildNextRequestedBand();
+    void buildBand (int band);
 };
 
 //==============================================================================
@@ -69,7 +139,7 @@ private:
     void processNoise (juce::AudioSampleBuffer& buffer, int startSample, int numSamples);
 
     void processLookup (juce::AudioSampleBuffer& buffer, int startSample, int numSamples,
-                        const juce::OwnedArray<juce::dsp::LookupTableTransform<float>>& tableSet);
+                        BandlimitedWaveLookupTables::Wave);
 
     //==============================================================================
     Waves wave = sine;
@@ -88,7 +158,10 @@ class MultiVoiceOscillator
 public:
     MultiVoiceOscillator (int maxVoices = 8);
 
+    /** Starts each voice at a random phase. */
     void start();
+    /** Starts all the voices at the given phase, in the range 0 to 1. */
+    void start (float phase);
     void setSampleRate (double sr);
     void setWave (Oscillator::Waves w);
     void setNote (float n);
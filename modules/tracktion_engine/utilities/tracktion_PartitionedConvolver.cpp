@@ -0,0 +1,989 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace partitioned_convolver
+{
+    /** The start of the IR is applied directly so there's no latency. */
+    static constexpr int headSize = 64;
+
+    /** The rest is split into partitions of these sizes. Each size starts at twice its own
+        length into the IR, so it has a whole partition's worth of time to be processed in,
+        apart from the first which has to be processed as soon as its input arrives.
+    */
+    static constexpr int partitionSizes[] = { 64, 512, 4096 };
+
+    static int getFFTOrder (int fftSize)
+    {
+        return juce::roundToInt (std::log2 ((double) fftSize));
+    }
+
+    static juce::AudioBuffer<float> resample (const juce::AudioBuffer<float>& source, double sourceRate, double destRate)
+    {
+        if (sourceRate <= 0.0 || destRate <= 0.0 || sourceRate == destRate)
+            return source;
+
+        const auto ratio = sourceRate / destRate;
+        const int numSourceSamples = source.getNumSamples();
+        const int numDestSamples = (int) std::ceil (numSourceSamples / ratio);
+
+        // The interpolator reads a few samples ahead so this is padded with silence
+        juce::AudioBuffer<float> padded (source.getNumChannels(), numSourceSamples + 8);
+        padded.clear();
+
+        juce::AudioBuffer<float> dest (source.getNumChannels(), numDestSamples);
+
+        for (int c = 0; c < source.getNumChannels(); ++c)
+        {
+            padded.copyFrom (c, 0, source, c, 0, numSourceSamples);
+
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process (ratio, padded.getReadPointer (c), dest.getWritePointer (c), numDestSamples);
+        }
+
+        // Scale the IR so its overall gain stays the same with the new number of samples
+        dest.applyGain ((float) ratio);
+
+        return dest;
+    }
+}
+
+//==============================================================================
+/** Shared by all the convolvers: the IRs in use and the threads that process the tails. */
+class PartitionedConvolver::SharedState  : private juce::DeletedAtShutdown
+{
+public:
+    SharedState() = default;
+
+    ~SharedState() override
+    {
+        for (auto w : workers)
+            w->signalThreadShouldExit();
+
+        jobsAvailable.signal (workers.size());
+        workers.clear();
+        clearSingletonInstance();
+    }
+
+    JUCE_DECLARE_SINGLETON (SharedState, false)
+
+    //==============================================================================
+    ImpulseResponse::Ptr getImpulseResponse (juce::uint64 sourceHash, const juce::AudioBuffer<float>& source,
+                                             double sourceSampleRate, double sampleRate)
+    {
+        const juce::ScopedLock sl (impulseResponseLock);
+        removeUnusedImpulseResponses();
+
+        for (auto ir : impulseResponses)
+            if (ir->sourceHash == sourceHash && ir->sampleRate == sampleRate)
+                return ir;
+
+        return impulseResponses.add (new ImpulseResponse (sourceHash, source, sourceSampleRate, sampleRate));
+    }
+
+    int getNumImpulseResponses()
+    {
+        const juce::ScopedLock sl (impulseResponseLock);
+        removeUnusedImpulseResponses();
+        return impulseResponses.size();
+    }
+
+    //==============================================================================
+    void addStage (Stage&);
+    void removeStage (Stage&);
+    void notifyWorkers() noexcept;
+
+private:
+    class Worker;
+
+    juce::CriticalSection impulseResponseLock, stageLock;
+    juce::ReferenceCountedArray<ImpulseResponse> impulseResponses;
+    juce::Array<Stage*> stages;
+    juce::OwnedArray<Worker> workers;
+    tracktion_graph::LightweightSemaphore jobsAvailable;
+
+    void removeUnusedImpulseResponses()
+    {
+        for (int i = impulseResponses.size(); --i >= 0;)
+            if (impulseResponses.getObjectPointerUnchecked (i)->getReferenceCount() == 1)
+                impulseResponses.remove (i);
+    }
+
+    Stage* takeNextJob();
+};
+
+JUCE_IMPLEMENT_SINGLETON (PartitionedConvolver::SharedState)
+
+//==============================================================================
+PartitionedConvolver::ImpulseResponse::ImpulseResponse (juce::uint64 hash, const juce::AudioBuffer<float>& source,
+                                                        double sourceRate, double rate)
+    : sourceHash (hash), sampleRate (rate)
+{
+    using namespace partitioned_convolver;
+    auto ir = resample (source, sourceRate, rate);
+    numChannels = ir.getNumChannels();
+    length = ir.getNumSamples();
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        std::vector<float> reversed ((size_t) headSize, 0.0f);
+
+        for (int i = 0; i < std::min (headSize, length); ++i)
+            reversed[(size_t) (headSize - 1 - i)] = ir.getSample (c, i);
+
+        head.push_back (std::move (reversed));
+    }
+
+    int offset = headSize;
+
+    for (size_t i = 0; i < std::size (partitionSizes) && offset < length; ++i)
+    {
+        const int partitionSize = partitionSizes[i];
+        const int end = i + 1 < std::size (partitionSizes) ? std::min (length, 2 * partitionSizes[i + 1]) : length;
+
+        Partitions p;
+        p.partitionSize = partitionSize;
+        p.offset = offset;
+        p.numPartitions = (end - offset + partitionSize - 1) / partitionSize;
+
+        juce::dsp::FFT fft (getFFTOrder (2 * partitionSize));
+        std::vector<float> fftBuffer ((size_t) (4 * partitionSize));
+        const auto numBinValues = (size_t) (2 * (partitionSize + 1));
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            std::vector<float> spectra;
+            spectra.reserve ((size_t) p.numPartitions * numBinValues);
+
+            for (int part = 0; part < p.numPartitions; ++part)
+            {
+                const int start = offset + part * partitionSize;
+                const int numToCopy = std::min (partitionSize, length - start);
+
+                std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+                std::copy_n (ir.getReadPointer (c, start), numToCopy, fftBuffer.begin());
+                fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+                spectra.insert (spectra.end(), fftBuffer.begin(), fftBuffer.begin() + (std::ptrdiff_t) numBinValues);
+            }
+
+            p.spectra.push_back (std::move (spectra));
+        }
+
+        offset += p.numPartitions * partitionSize;
+        stages.push_back (std::move (p));
+    }
+}
+
+PartitionedConvolver::ImpulseResponse::Ptr PartitionedConvolver::ImpulseResponse::getOrCreate (juce::uint64 hash, const juce::AudioBuffer<float>& source,
+                                                                                                double sourceRate, double rate)
+{
+    return SharedState::getInstance()->getImpulseResponse (hash, source, sourceRate, rate);
+}
+
+int PartitionedConvolver::ImpulseResponse::getNumShared()
+{
+    return SharedState::getInstance()->getNumImpulseResponses();
+}
+
+juce::int64 PartitionedConvolver::ImpulseResponse::getMemoryUsageBytes() const noexcept
+{
+    juce::int64 numFloats = 0;
+
+    for (auto& h : head)
+        numFloats += (juce::int64) h.size();
+
+    for (auto& s : stages)
+        for (auto& channelSpectra : s.spectra)
+            numFloats += (juce::int64) channelSpectra.size();
+
+    return numFloats * (juce::int64) sizeof (float);
+}
+
+//==============================================================================
+/** Processes the partitions of one size using a uniformly partitioned overlap-save. */
+struct PartitionedConvolver::Stage
+{
+    enum JobState
+    {
+        idle,
+        pending,
+        running,
+        done
+    };
+
+    Stage (const ImpulseResponse& ir, const ImpulseResponse::Partitions& partitions, int numChannels)
+        : partitionSize (partitions.partitionSize),
+          numPartitions (partitions.numPartitions),
+          numBinValues (2 * (partitions.partitionSize + 1)),
+          isTail (partitions.offset >= 2 * partitions.partitionSize),
+          fft (partitioned_convolver::getFFTOrder (2 * partitions.partitionSize))
+    {
+        for (int c = 0; c < numChannels; ++c)
+        {
+            Channel channel;
+            channel.impulseResponse = &partitions.spectra[(size_t) std::min (c, ir.getNumChannels() - 1)];
+            channel.input.resize ((size_t) partitionSize);
+            channel.deferredInput.resize ((size_t) partitionSize);
+            channel.window.resize ((size_t) (2 * partitionSize));
+            channel.fftBuffer.resize ((size_t) (4 * partitionSize));
+            channel.history.resize ((size_t) (numPartitions * numBinValues));
+            channel.accumulator.resize ((size_t) numBinValues);
+            channel.output[0].resize ((size_t) partitionSize);
+            channel.output[1].resize ((size_t) partitionSize);
+            channels.push_back (std::move (channel));
+        }
+
+        reset (true);
+    }
+
+    /** Clears the stage. If a worker is still running a job and the caller can't wait for
+        it, the parts the job uses are cleared once it's finished.
+    */
+    void reset (bool canWait) noexcept
+    {
+        inputPos = 0;
+
+        for (auto& c : channels)
+            std::fill (c.input.begin(), c.input.end(), 0.0f);
+
+        if (hasJob && ! finishJob (canWait))
+        {
+            waitingForJob = true;
+            resetWhenJobDone = true;
+            return;
+        }
+
+        hasJob = false;
+        waitingForJob = false;
+        resetWhenJobDone = false;
+        clear();
+    }
+
+    //==============================================================================
+    void addInput (int channel, const float* source, int numSamples) noexcept
+    {
+        std::copy_n (source, numSamples, channels[(size_t) channel].input.begin() + inputPos);
+    }
+
+    void addOutput (int channel, float* dest, int numSamples) const noexcept
+    {
+        // A late job's output is mixed in once it's done
+        if (! waitingForJob)
+            juce::FloatVectorOperations::add (dest, channels[(size_t) channel].output[readIndex].data() + inputPos, numSamples);
+    }
+
+    /** Moves on by a number of samples, which mustn't cross a partition boundary.
+        Returns true if a new partition has been filled.
+    */
+    bool advance (int numSamples) noexcept
+    {
+        inputPos += numSamples;
+        jassert (inputPos <= partitionSize);
+        return inputPos == partitionSize;
+    }
+
+    /** Called when a partition's worth of input has arrived. The previous tail job's
+        output is needed from now on so that has to be finished before the next is started.
+        If a worker is still running it and the caller can't wait, the input is kept and the
+        next job is started once that one's done.
+    */
+    void startNextPartition (SharedState& shared, double sampleRate, bool canWait) noexcept
+    {
+        inputPos = 0;
+
+        if (waitingForJob && canWait)
+            waitForWorker();
+
+        update (shared, sampleRate);
+
+        if (waitingForJob || (hasJob && ! finishJob (canWait)))
+        {
+            // If the job is more than a whole partition late this drops the previous partition's input
+            for (auto& c : channels)
+                std::copy (c.input.begin(), c.input.end(), c.deferredInput.begin());
+
+            waitingForJob = true;
+            return;
+        }
+
+        if (hasJob)
+            takeJobOutput();
+
+        startJob (shared, sampleRate, &Channel::input);
+    }
+
+    /** Called at the start of each block to pick up a job that finished late. */
+    void update (SharedState& shared, double sampleRate) noexcept
+    {
+        if (! waitingForJob || jobState.load (std::memory_order_acquire) != done)
+            return;
+
+        waitingForJob = false;
+
+        if (std::exchange (resetWhenJobDone, false))
+        {
+            hasJob = false;
+            clear();
+            return;
+        }
+
+        takeJobOutput();
+        startJob (shared, sampleRate, &Channel::deferredInput);
+    }
+
+    /** Called on whichever thread has claimed the job. */
+    void runJob() noexcept
+    {
+        run();
+        jobState.store (done, std::memory_order_release);
+    }
+
+    /** Waits for a job taken by a worker to finish, e.g. before the stage is deleted. */
+    void waitForWorker() const noexcept
+    {
+        while (jobState.load (std::memory_order_acquire) == running)
+            std::this_thread::yield();
+    }
+
+    //==============================================================================
+    const int partitionSize, numPartitions, numBinValues;
+    const bool isTail;
+
+    std::atomic<int> jobState { idle };
+    std::atomic<juce::int64> deadline { 0 };
+
+private:
+    struct Channel
+    {
+        const std::vector<float>* impulseResponse = nullptr;
+        std::vector<float> input, deferredInput, window, fftBuffer, history, accumulator;
+        std::vector<float> output[2];
+    };
+
+    juce::dsp::FFT fft;
+    std::vector<Channel> channels;
+    int inputPos = 0, historyIndex = 0, readIndex = 0, writeIndex = 0;
+    bool hasJob = false, waitingForJob = false, resetWhenJobDone = false;
+
+    /** Runs the current job here if no worker has started it yet, or waits for it if
+        allowed. Returns false if a worker is still running it.
+    */
+    bool finishJob (bool canWait) noexcept
+    {
+        int expected = pending;
+
+        if (jobState.compare_exchange_strong (expected, running, std::memory_order_acquire))
+        {
+            runJob();
+            return true;
+        }
+
+        if (canWait)
+            waitForWorker();
+
+        return jobState.load (std::memory_order_acquire) == done;
+    }
+
+    void takeJobOutput() noexcept
+    {
+        hasJob = false;
+        readIndex = writeIndex;
+        writeIndex ^= 1;
+    }
+
+    void startJob (SharedState& shared, double sampleRate, std::vector<float> Channel::* input) noexcept
+    {
+        for (auto& c : channels)
+        {
+            std::copy (c.window.begin() + partitionSize, c.window.end(), c.window.begin());
+            std::copy ((c.*input).begin(), (c.*input).end(), c.window.begin() + partitionSize);
+        }
+
+        if (! isTail)
+        {
+            run();
+            return;
+        }
+
+        deadline.store (juce::Time::getHighResolutionTicks()
+                          + juce::Time::secondsToHighResolutionTicks (partitionSize / sampleRate), std::memory_order_relaxed);
+        jobState.store (pending, std::memory_order_release);
+        hasJob = true;
+        shared.notifyWorkers();
+    }
+
+    void clear() noexcept
+    {
+        historyIndex = 0;
+        readIndex = 0;
+        writeIndex = isTail ? 1 : 0;
+
+        for (auto& c : channels)
+        {
+            std::fill (c.window.begin(), c.window.end(), 0.0f);
+            std::fill (c.history.begin(), c.history.end(), 0.0f);
+            std::fill (c.output[0].begin(), c.output[0].end(), 0.0f);
+            std::fill (c.output[1].begin(), c.output[1].end(), 0.0f);
+        }
+    }
+
+    void run() noexcept
+    {
+        for (auto& c : channels)
+        {
+            // The history holds the spectra of the last numPartitions windows
+            std::copy (c.window.begin(), c.window.end(), c.fftBuffer.begin());
+            fft.performRealOnlyForwardTransform (c.fftBuffer.data(), true);
+            std::copy_n (c.fftBuffer.begin(), numBinValues, c.history.begin() + historyIndex * numBinValues);
+
+            std::fill (c.accumulator.begin(), c.accumulator.end(), 0.0f);
+            auto acc = c.accumulator.data();
+
+            for (int part = 0; part < numPartitions; ++part)
+            {
+                const int index = (historyIndex + numPartitions - part) % numPartitions;
+                auto x = c.history.data() + index * numBinValues;
+                auto h = c.impulseResponse->data() + part * numBinValues;
+
+                for (int i = 0; i < numBinValues; i += 2)
+                {
+                    acc[i]     += x[i] * h[i]     - x[i + 1] * h[i + 1];
+                    acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i];
+                }
+            }
+
+            std::copy (c.accumulator.begin(), c.accumulator.end(), c.fftBuffer.begin());
+            fft.performRealOnlyInverseTransform (c.fftBuffer.data());
+
+            // Only the second half of the window is valid output
+            std::copy_n (c.fftBuffer.begin() + partitionSize, partitionSize, c.output[writeIndex].begin());
+        }
+
+        historyIndex = (historyIndex + 1) % numPartitions;
+    }
+};
+
+//==============================================================================
+class PartitionedConvolver::SharedState::Worker  : public juce::Thread
+{
+public:
+    Worker (SharedState& s)
+        : juce::Thread ("ConvolutionTail"), owner (s)
+    {
+        startThread (8);
+    }
+
+    ~Worker() override
+    {
+        stopThread (10000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (auto stage = owner.takeNextJob())
+                stage->runJob();
+            else
+                owner.jobsAvailable.wait();
+        }
+    }
+
+private:
+    SharedState& owner;
+};
+
+void PartitionedConvolver::SharedState::addStage (Stage& stage)
+{
+    const juce::ScopedLock sl (stageLock);
+    stages.add (&stage);
+
+    if (workers.isEmpty())
+        for (int i = juce::jlimit (1, 4, juce::SystemStats::getNumCpus() / 2); --i >= 0;)
+            workers.add (new Worker (*this));
+}
+
+void PartitionedConvolver::SharedState::removeStage (Stage& stage)
+{
+    {
+        const juce::ScopedLock sl (stageLock);
+        stages.removeFirstMatchingValue (&stage);
+    }
+
+    // A worker might have just taken a job
+    stage.waitForWorker();
+}
+
+void PartitionedConvolver::SharedState::notifyWorkers() noexcept
+{
+    // This is called on the audio thread so mustn't take any locks
+    jobsAvailable.signal();
+}
+
+PartitionedConvolver::Stage* PartitionedConvolver::SharedState::takeNextJob()
+{
+    const juce::ScopedLock sl (stageLock);
+
+    for (;;)
+    {
+        Stage* next = nullptr;
+
+        for (auto s : stages)
+            if (s->jobState.load (std::memory_order_relaxed) == Stage::pending
+                 && (next == nullptr || s->deadline.load (std::memory_order_relaxed) < next->deadline.load (std::memory_order_relaxed)))
+                next = s;
+
+        if (next == nullptr)
+            return nullptr;
+
+        // If this fails the audio thread got there first
+        int expected = Stage::pending;
+
+        if (next->jobState.compare_exchange_strong (expected, Stage::running, std::memory_order_acquire))
+            return next;
+    }
+}
+
+//==============================================================================
+struct PartitionedConvolver::Processor
+{
+    Processor (ImpulseResponse::Ptr irToUse, int numChannelsToUse, double sampleRateToUse)
+        : ir (std::move (irToUse)),
+          shared (*SharedState::getInstance()),
+          numChannels (numChannelsToUse),
+          sampleRate (sampleRateToUse)
+    {
+        using namespace partitioned_convolver;
+
+        for (auto& partitions : ir->stages)
+        {
+            stages.push_back (std::make_unique<Stage> (*ir, partitions, numChannels));
+
+            if (stages.back()->isTail)
+                shared.addStage (*stages.back());
+        }
+
+        headHistory.resize ((size_t) numChannels, std::vector<float> ((size_t) (2 * headSize - 1), 0.0f));
+    }
+
+    ~Processor()
+    {
+        for (auto& s : stages)
+            if (s->isTail)
+                shared.removeStage (*s);
+    }
+
+    void reset (bool canWait) noexcept
+    {
+        for (auto& h : headHistory)
+            std::fill (h.begin(), h.end(), 0.0f);
+
+        for (auto& s : stages)
+            s->reset (canWait);
+
+        headPos = 0;
+    }
+
+    void process (const juce::dsp::AudioBlock<const float>& input, const juce::dsp::AudioBlock<float>& output, bool canWait) noexcept
+    {
+        using namespace partitioned_convolver;
+        const int numSamples = (int) output.getNumSamples();
+        const int numChannelsToDo = std::min ({ numChannels, (int) input.getNumChannels(), (int) output.getNumChannels() });
+
+        for (auto& s : stages)
+            s->update (shared, sampleRate);
+
+        // This goes in chunks up to the smallest partition boundary. As all the partition sizes
+        // are multiples of the head size none of the stages will be crossing a boundary either
+        for (int start = 0; start < numSamples;)
+        {
+            const int numThisTime = std::min (numSamples - start, headSize - headPos);
+
+            for (int c = 0; c < numChannelsToDo; ++c)
+            {
+                auto src = input.getChannelPointer ((size_t) c) + start;
+                auto dest = output.getChannelPointer ((size_t) c) + start;
+
+                // The input and output may be the same so the input is used before writing
+                auto& history = headHistory[(size_t) c];
+                std::copy_n (src, numThisTime, history.begin() + (headSize - 1));
+
+                for (auto& s : stages)
+                    s->addInput (c, src, numThisTime);
+
+                auto headIR = ir->head[(size_t) std::min (c, ir->numChannels - 1)].data();
+
+                for (int i = 0; i < numThisTime; ++i)
+                {
+                    auto x = history.data() + i;
+                    float sum = 0.0f;
+
+                    for (int k = 0; k < headSize; ++k)
+                        sum += headIR[k] * x[k];
+
+                    dest[i] = sum;
+                }
+
+                for (auto& s : stages)
+                    s->addOutput (c, dest, numThisTime);
+
+                std::copy (history.begin() + numThisTime, history.begin() + (numThisTime + headSize - 1), history.begin());
+            }
+
+            headPos = (headPos + numThisTime) % headSize;
+
+            for (auto& s : stages)
+                if (s->advance (numThisTime))
+                    s->startNextPartition (shared, sampleRate, canWait);
+
+            start += numThisTime;
+        }
+    }
+
+    const ImpulseResponse::Ptr ir;
+    SharedState& shared;
+    const int numChannels;
+    const double sampleRate;
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::vector<std::vector<float>> headHistory;
+    int headPos = 0;
+};
+
+//==============================================================================
+PartitionedConvolver::PartitionedConvolver() = default;
+PartitionedConvolver::~PartitionedConvolver() = default;
+
+void PartitionedConvolver::loadImpulseResponse (juce::AudioBuffer<float>&& impulseResponse, double impulseResponseSampleRate,
+                                                juce::uint64 hash)
+{
+    sourceImpulseResponse = std::move (impulseResponse);
+    sourceSampleRate = impulseResponseSampleRate;
+    sourceHash = hash;
+    updateProcessor();
+}
+
+PartitionedConvolver::ImpulseResponse::Ptr PartitionedConvolver::getImpulseResponse() const
+{
+    if (auto p = processor.getLatest())
+        return p->ir;
+
+    return {};
+}
+
+void PartitionedConvolver::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    if (spec.sampleRate == sampleRate && (int) spec.numChannels == numChannels)
+    {
+        reset();
+        return;
+    }
+
+    sampleRate = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+    updateProcessor();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    resetPending = true;
+}
+
+void PartitionedConvolver::updateProcessor()
+{
+    if (sampleRate <= 0.0 || numChannels == 0
+         || sourceImpulseResponse.getNumChannels() == 0 || sourceImpulseResponse.getNumSamples() == 0)
+        return;
+
+    auto ir = ImpulseResponse::getOrCreate (sourceHash, sourceImpulseResponse, sourceSampleRate, sampleRate);
+    processor.publish (std::make_unique<Processor> (std::move (ir), numChannels, sampleRate));
+}
+
+void PartitionedConvolver::processSamples (const juce::dsp::AudioBlock<const float>& input,
+                                           const juce::dsp::AudioBlock<float>& output, bool isBypassed) noexcept
+{
+    // A new processor starts off cleared so any pending reset can be ignored
+    if (processor.acquireLatest())
+        resetPending = false;
+
+    auto p = processor.getCurrent();
+
+    const bool canWait = nonRealtime.load (std::memory_order_relaxed);
+
+    if (p != nullptr && resetPending.exchange (false))
+        p->reset (canWait);
+
+    if (p == nullptr || isBypassed)
+    {
+        if (input.getNumChannels() > 0 && input.getChannelPointer (0) != output.getChannelPointer (0))
+            output.copyFrom (input);
+
+        return;
+    }
+
+    p->process (input, output, canWait);
+}
+
+
+//==============================================================================
+//==============================================================================
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace partitioned_convolver
+{
+    /** A decaying noise IR. */
+    static juce::AudioBuffer<float> createImpulseResponse (int numChannels, int length, juce::Random& r)
+    {
+        juce::AudioBuffer<float> ir (numChannels, length);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < length; ++i)
+                ir.setSample (c, i, (r.nextFloat() * 2.0f - 1.0f) * std::exp (-4.0f * i / (float) length));
+
+        return ir;
+    }
+
+    /** Processes the buffer in place in blocks of the given size, optionally no faster
+        than it would be played at the given sample rate.
+    */
+    template<typename ProcessorType>
+    static void processInBlocks (ProcessorType& convolver, juce::AudioBuffer<float>& buffer, int blockSize, juce::Random* randomBlockSizes = nullptr,
+                                 double realTimeSampleRate = 0.0)
+    {
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (int start = 0; start < buffer.getNumSamples();)
+        {
+            // Waits until the start of the block would be played
+            if (realTimeSampleRate > 0.0)
+                juce::Time::waitForMillisecondCounter ((juce::uint32) (startTime + 1000.0 * start / realTimeSampleRate));
+
+            const int numThisTime = std::min (buffer.getNumSamples() - start,
+                                              randomBlockSizes != nullptr ? randomBlockSizes->nextInt ({ 1, blockSize + 1 }) : blockSize);
+
+            juce::dsp::AudioBlock<float> block (buffer.getArrayOfWritePointers(), (size_t) buffer.getNumChannels(),
+                                                (size_t) start, (size_t) numThisTime);
+            convolver.process (juce::dsp::ProcessContextReplacing<float> (block));
+            start += numThisTime;
+        }
+    }
+}
+
+#endif
+
+#if TRACKTION_UNIT_TESTS
+
+class PartitionedConvolverTests   : public juce::UnitTest
+{
+public:
+    PartitionedConvolverTests()
+        : juce::UnitTest ("PartitionedConvolver", "Tracktion") {}
+
+    void runTest() override
+    {
+        using namespace partitioned_convolver;
+        juce::Random r (42);
+
+        // These cover just the head and then each of the partition sizes
+        for (int irLength : { 1, 50, 64, 65, 1000, 1100, 9000 })
+        {
+            beginTest ("Matches direct convolution: " + juce::String (irLength) + " sample IR");
+            {
+                for (int numIRChannels : { 1, 2 })
+                    expectMatchesDirectConvolution (createImpulseResponse (numIRChannels, irLength, r), r);
+            }
+        }
+
+        beginTest ("Instances share IRs");
+        {
+            auto ir = createImpulseResponse (2, 20000, r);
+            const int numSharedBefore = ImpulseResponse::getNumShared();
+
+            {
+                PartitionedConvolver c1, c2, c3;
+                c1.loadImpulseResponse (juce::AudioBuffer<float> (ir), 44100.0, 1234);
+                c2.loadImpulseResponse (juce::AudioBuffer<float> (ir), 44100.0, 1234);
+                c3.loadImpulseResponse (juce::AudioBuffer<float> (ir), 44100.0, 1234);
+                expect (c1.getImpulseResponse() == nullptr, "Not created until the sample rate is known");
+
+                c1.prepare ({ 44100.0, 512, 2 });
+                c2.prepare ({ 44100.0, 128, 2 });
+                c3.prepare ({ 48000.0, 512, 2 });
+
+                expect (c1.getImpulseResponse() != nullptr);
+                expect (c1.getImpulseResponse() == c2.getImpulseResponse());
+                expect (c1.getImpulseResponse() != c3.getImpulseResponse());
+                expectEquals (ImpulseResponse::getNumShared(), numSharedBefore + 2);
+                expectEquals (c3.getImpulseResponse()->getLengthInSamples(), (int) std::ceil (20000 * 48000.0 / 44100.0));
+            }
+
+            expectEquals (ImpulseResponse::getNumShared(), numSharedBefore);
+        }
+
+        beginTest ("Matches direct convolution in real-time");
+        {
+            // Played at this rate the workers should always finish in time
+            expectMatchesDirectConvolution (createImpulseResponse (2, 9000, r), r, true);
+        }
+
+        beginTest ("Reset clears the tail");
+        {
+            PartitionedConvolver convolver;
+            convolver.loadImpulseResponse (createImpulseResponse (1, 20000, r), 44100.0, 5678);
+            convolver.prepare ({ 44100.0, 256, 1 });
+
+            // This runs faster than real-time so the reset usually happens while a worker is busy
+            auto buffer = audio_test_utilities::createNoise (1, 4096, r, 0.5f);
+            processInBlocks (convolver, buffer, 256);
+
+            convolver.reset();
+            buffer.clear();
+            processInBlocks (convolver, buffer, 256);
+            expectEquals (buffer.getMagnitude (0, buffer.getNumSamples()), 0.0f);
+        }
+    }
+
+private:
+    void expectMatchesDirectConvolution (const juce::AudioBuffer<float>& ir, juce::Random& r, bool inRealTime = false)
+    {
+        using namespace partitioned_convolver;
+        const int numSamples = ir.getNumSamples() + 2000;
+        auto input = audio_test_utilities::createNoise (2, numSamples, r, 0.5f);
+
+        auto expected = juce::AudioBuffer<float> (2, numSamples);
+        expected.clear();
+
+        for (int c = 0; c < 2; ++c)
+        {
+            auto x = input.getReadPointer (c);
+            auto h = ir.getReadPointer (std::min (c, ir.getNumChannels() - 1));
+            auto y = expected.getWritePointer (c);
+
+            for (int i = 0; i < numSamples; ++i)
+                for (int k = 0; k < std::min (i + 1, ir.getNumSamples()); ++k)
+                    y[i] += h[k] * x[i - k];
+        }
+
+        for (int blockSize : { 1, 100, 512 })
+        {
+            if (inRealTime && blockSize == 1)
+                continue;
+
+            PartitionedConvolver convolver;
+            convolver.loadImpulseResponse (juce::AudioBuffer<float> (ir), 44100.0, (juce::uint64) r.nextInt64());
+            convolver.prepare ({ 44100.0, (juce::uint32) blockSize, 2 });
+            convolver.setNonRealtime (! inRealTime);
+
+            auto output = input;
+            processInBlocks (convolver, output, blockSize, blockSize > 1 ? &r : nullptr, inRealTime ? 44100.0 : 0.0);
+
+            expectLessThan (audio_test_utilities::getMaxDifference (output, expected), 0.0001f * std::max (1.0f, expected.getMagnitude (0, numSamples)),
+                            juce::String (ir.getNumChannels()) + " channel IR, block size " + juce::String (blockSize));
+        }
+    }
+};
+
+static PartitionedConvolverTests partitionedConvolverTests;
+
+#endif // TRACKTION_UNIT_TESTS
+
+#if TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+class PartitionedConvolverBenchmarks   : public juce::UnitTest
+{
+public:
+    PartitionedConvolverBenchmarks()
+        : juce::UnitTest ("PartitionedConvolver Benchmarks", "tracktion_graph_performance") {}
+
+    void runTest() override
+    {
+        for (double irSeconds : { 1.0, 5.0, 10.0 })
+            for (int blockSize : { 32, 64, 256, 1024 })
+                runBenchmark (irSeconds, blockSize);
+    }
+
+private:
+    void runBenchmark (double irSeconds, int blockSize)
+    {
+        using namespace partitioned_convolver;
+        const double sampleRate = 44100.0, durationSeconds = 10.0;
+        juce::Random r (42);
+        auto ir = createImpulseResponse (2, (int) (irSeconds * sampleRate), r);
+        auto input = audio_test_utilities::createNoise (2, (int) (durationSeconds * sampleRate), r, 0.5f);
+        const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+        const auto description = juce::String (irSeconds, 0) + "s IR, " + juce::String (blockSize) + " block size";
+        double seconds[2] = {};
+
+        beginTest ("juce::dsp::Convolution: " + description);
+        {
+            juce::dsp::Convolution convolution;
+            convolution.prepare (spec);
+            convolution.loadImpulseResponse (juce::AudioBuffer<float> (ir), sampleRate,
+                                             juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::no,
+                                             juce::dsp::Convolution::Normalise::no);
+            waitForIRToLoad (convolution, blockSize);
+
+            auto buffer = input;
+            const StopwatchTimer timer;
+            processInBlocks (convolution, buffer, blockSize);
+            seconds[0] = benchmark_utilities::printRealTimeFactor (timer, durationSeconds);
+            expectGreaterThan (buffer.getMagnitude (0, buffer.getNumSamples()), 0.0f);
+        }
+
+        beginTest ("PartitionedConvolver: " + description);
+        {
+            PartitionedConvolver convolver;
+            convolver.loadImpulseResponse (juce::AudioBuffer<float> (ir), sampleRate, (juce::uint64) r.nextInt64());
+            convolver.prepare (spec);
+            convolver.setNonRealtime (true);
+
+            // This is the time spent on the processing thread, the tail is mostly done on the workers.
+            // It waits for any the workers haven't finished so this is the same work as the juce version
+            auto buffer = input;
+            const StopwatchTimer timer;
+            processInBlocks (convolver, buffer, blockSize);
+            seconds[1] = benchmark_utilities::printRealTimeFactor (timer, durationSeconds);
+            expectGreaterThan (buffer.getMagnitude (0, buffer.getNumSamples()), 0.0f);
+        }
+
+        benchmark_utilities::printSpeedUp ("Speed-up", seconds[0], seconds[1]);
+    }
+
+    /** juce::dsp::Convolution loads IRs on a background thread and swaps them in while processing. */
+    static void waitForIRToLoad (juce::dsp::Convolution& convolution, int blockSize)
+    {
+        juce::AudioBuffer<float> buffer (2, blockSize);
+
+        for (int attempt = 0; attempt < 500; ++attempt)
+        {
+            buffer.clear();
+            buffer.setSample (0, 0, 1.0f);
+            buffer.setSample (1, 0, 1.0f);
+            partitioned_convolver::processInBlocks (convolution, buffer, blockSize);
+
+            if (buffer.getMagnitude (0, blockSize) > 0.0f)
+                break;
+
+            juce::Thread::sleep (10);
+        }
+
+        convolution.reset();
+    }
+};
+
+static PartitionedConvolverBenchmarks partitionedConvolverBenchmarks;
+
+#endif // TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+} // namespace tracktion_engine
@@ -0,0 +1,143 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    A zero-latency convolver for long impulse responses.
+
+    The IR is split into partitions that get longer the further into the IR they are.
+    The first few milliseconds are applied directly and the early partitions are
+    processed on the audio thread as soon as enough input has arrived. The longer tail
+    partitions aren't needed until a whole partition later, so they're handed to a shared
+    pool of worker threads which always pick the job with the nearest deadline. If a job
+    hasn't been picked up by the time its output is needed, the audio thread does it
+    itself. If a worker is still in the middle of it, the audio thread doesn't wait for it
+    when processing in real-time: that partition's output is mixed in from the next block
+    once it's ready. When processing offline it does wait so the output is exact.
+
+    The transformed IRs are shared between all the convolvers that have loaded the same
+    IR at the same sample rate.
+
+    This has the same interface as the juce::dsp processors so can be used in a
+    juce::dsp::ProcessorChain.
+*/
+class PartitionedConvolver
+{
+public:
+    /** Creates an empty convolver which will pass audio through until an IR is loaded. */
+    PartitionedConvolver();
+
+    /** Destructor. */
+    ~PartitionedConvolver();
+
+    //==============================================================================
+    /** An IR split into partitions and transformed for a particular sample rate. */
+    class ImpulseResponse  : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<ImpulseResponse>;
+
+        /** Returns the partitioned IR for the given sample rate, reusing one that's already
+            in use if the same source has been loaded elsewhere.
+            @param sourceHash       identifies the IR data, e.g. a hash of the file contents
+            @param source           the IR, which is resampled if its rate is different
+            @param sourceSampleRate the sample rate of the IR
+            @param sampleRate       the sample rate the IR will be used at
+        */
+        static Ptr getOrCreate (juce::uint64 sourceHash, const juce::AudioBuffer<float>& source,
+                                double sourceSampleRate, double sampleRate);
+
+        /** Returns the number of IRs currently shared between convolvers. */
+        static int getNumShared();
+
+        int getNumChannels() const noexcept             { return numChannels; }
+        int getLengthInSamples() const noexcept         { return length; }
+        juce::int64 getMemoryUsageBytes() const noexcept;
+
+        const juce::uint64 sourceHash;
+        const double sampleRate;
+
+    private:
+        friend class PartitionedConvolver;
+
+        struct Partitions
+        {
+            int partitionSize = 0, offset = 0, numPartitions = 0;
+            std::vector<std::vector<float>> spectra; // Per channel, interleaved complex bins for each partition
+        };
+
+        int numChannels = 0, length = 0;
+        std::vector<std::vector<float>> head; // Per channel, reversed
+        std::vector<Partitions> stages;
+
+        ImpulseResponse (juce::uint64 sourceHash, const juce::AudioBuffer<float>&, double sourceSampleRate, double sampleRate);
+    };
+
+    //==============================================================================
+    /** Loads an IR, replacing the current one.
+        The IR is kept so it can be re-partitioned if the sample rate changes.
+        This and prepare() should be called from the same thread, usually the message thread.
+        @param sourceHash   identifies the IR data so instances loading the same IR can share it
+    */
+    void loadImpulseResponse (juce::AudioBuffer<float>&& impulseResponse, double impulseResponseSampleRate,
+                              juce::uint64 sourceHash);
+
+    /** Returns the IR that will be used, or nullptr if none has been loaded or this
+        hasn't been prepared yet.
+    */
+    ImpulseResponse::Ptr getImpulseResponse() const;
+
+    //==============================================================================
+    /** Prepares the convolver, re-partitioning the IR if the sample rate has changed. */
+    void prepare (const juce::dsp::ProcessSpec&);
+
+    /** Clears the convolver's state. This is applied at the start of the next block. */
+    void reset() noexcept;
+
+    /** Sets whether the convolver is being used for offline processing, e.g. a render.
+        When it is, a partition that a worker hasn't finished in time is waited for rather
+        than being mixed in late.
+    */
+    void setNonRealtime (bool isNonRealtime) noexcept   { nonRealtime = isNonRealtime; }
+
+    /** Returns the latency, which is always 0. */
+    int getLatency() const noexcept                     { return 0; }
+
+    /** Processes a block of audio. */
+    template<typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        processSamples (context.getInputBlock(), context.getOutputBlock(), context.isBypassed);
+    }
+
+private:
+    //==============================================================================
+    struct Stage;
+    struct Processor;
+    class SharedState;
+
+    RealTimeStateSwap<Processor> processor;
+    std::atomic<bool> resetPending { false }, nonRealtime { false };
+
+    juce::AudioBuffer<float> sourceImpulseResponse;
+    double sourceSampleRate = 0.0, sampleRate = 0.0;
+    juce::uint64 sourceHash = 0;
+    int numChannels = 0;
+
+    void updateProcessor();
+    void processSamples (const juce::dsp::AudioBlock<const float>&, const juce::dsp::AudioBlock<float>&, bool isBypassed) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PartitionedConvolver)
+};
+
+} // namespace tracktion_engine
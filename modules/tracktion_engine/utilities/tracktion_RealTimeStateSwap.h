@@ -0,0 +1,136 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Passes objects built on one thread (usually the message thread) to a real-time
+    thread without either of them having to take a lock.
+
+    The writer builds a complete new state and calls publish(). At the start of each
+    block the reader calls acquireLatest() which swaps in the most recent state if
+    there is one. The reader never deletes anything; states it has finished with are
+    handed back and deleted by the writer the next time it calls publish() or
+    collectGarbage(), or when this object is destroyed.
+
+    There must only be one writer thread and one reader thread.
+
+    @code
+    // Message thread
+    auto newState = std::make_unique<State> (...);
+    stateSwap.publish (std::move (newState));
+
+    // Audio thread
+    stateSwap.acquireLatest();
+
+    if (auto state = stateSwap.getCurrent())
+        process (*state);
+    @endcode
+*/
+template<typename StateType>
+class RealTimeStateSwap
+{
+public:
+    RealTimeStateSwap() = default;
+
+    ~RealTimeStateSwap()
+    {
+        delete pending.exchange (nullptr);
+        collectGarbage();
+        delete current;
+    }
+
+    //==============================================================================
+    /** Makes a new state available to the reader, replacing any state that was
+        published but hasn't been picked up yet.
+        Writer thread only.
+    */
+    void publish (std::unique_ptr<StateType> newState)
+    {
+        collectGarbage();
+        latest = newState.get();
+        delete pending.exchange (newState.release(), std::memory_order_acq_rel);
+    }
+
+    /** Deletes any states the reader has finished with.
+        Writer thread only.
+    */
+    void collectGarbage()
+    {
+        for (auto& r : retired)
+            delete r.exchange (nullptr, std::memory_order_acq_rel);
+    }
+
+    /** Returns the most recently published state, whether or not the reader has picked
+        it up yet. This stays valid until the next call to publish().
+        Writer thread only.
+    */
+    StateType* getLatest() const noexcept
+    {
+        return latest;
+    }
+
+    /** Returns true if a state has been published that the reader hasn't picked up yet. */
+    bool isPending() const noexcept
+    {
+        return pending.load (std::memory_order_acquire) != nullptr;
+    }
+
+    //==============================================================================
+    /** Swaps in the most recently published state if there is one, returning true
+        if the current state changed.
+        This never blocks, allocates or deletes anything.
+        Reader thread only.
+    */
+    bool acquireLatest() noexcept
+    {
+        // As the writer collects the garbage before each publish, the reader can only
+        // retire two states between collections so there will always be a free slot
+        for (auto& r : retired)
+        {
+            if (r.load (std::memory_order_acquire) != nullptr)
+                continue;
+
+            if (auto newState = pending.exchange (nullptr, std::memory_order_acq_rel))
+            {
+                r.store (current, std::memory_order_release);
+                current = newState;
+                return true;
+            }
+
+            return false;
+        }
+
+        jassertfalse;
+        return false;
+    }
+
+    /** Returns the state the reader is currently using, or nullptr if nothing has
+        been acquired yet.
+        Reader thread only.
+    */
+    StateType* getCurrent() const noexcept
+    {
+        return current;
+    }
+
+private:
+    //==============================================================================
+    std::atomic<StateType*> pending { nullptr };
+    std::atomic<StateType*> retired[2] { { nullptr }, { nullptr } };
+    StateType* current = nullptr;
+    StateType* latest = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (RealTimeStateSwap)
+};
+
+} // namespace tracktion_engine
@@ -204,6 +204,7 @@ static juce::String getClipProxyPrefix()                { return "clip_"; }
 static juce::String getFileProxyPrefix()                { return "proxy_"; }
 static juce::String getDeviceFreezePrefix (Edit& edit)  { return "freeze_" + edit.getProjectItemID().toStringSuitableForFilename() + "_"; }
 static juce::String getTrackFreezePrefix()              { return "trackFreeze_"; }
+static juce::String getTrackAutoFreezePrefix()          { return "autoFreeze_"; }
 static juce::String getCompPrefix()                     { return "comp_"; }
 
 static AudioFile getCachedEditFile (Edit& edit, const juce::String& prefix, juce::int64 hash)
@@ -253,6 +254,12 @@ juce::File TemporaryFileManager::getFreezeFileForTrack (const AudioTrack& track)
              .getChildFile (getTrackFreezePrefix() + "0_" + track.itemID.toString() + ".freeze");
 }
 
+juce::File TemporaryFileManager::getAutoFreezeFileForTrack (const AudioTrack& track, juce::int64 hash)
+{
+    return track.edit.getTempDirectory (true)
+             .getChildFile (getTrackAutoFreezePrefix() + "0_" + track.itemID.toString() + "_" + String::toHexString (hash) + ".freeze");
+}
+
 juce::Array<juce::File> TemporaryFileManager::getFrozenTrackFiles (Edit& edit)
 {
     return edit.getTempDirectory (false)
@@ -355,6 +362,13 @@ void TemporaryFileManager::purgeOrphanFreezeAndProxyFiles (Edit& edit)
                     if (! at->isFrozen (Track::individualFreeze))
                         filesToDelete.add (entry.getFile());
             }
+            else if (name.startsWith (getTrackAutoFreezePrefix()))
+            {
+                auto autoFreezer = edit.getAutoFreezer();
+
+                if (autoFreezer == nullptr || ! autoFreezer->isUsingFile (entry.getFile()))
+                    filesToDelete.add (entry.getFile());
+            }
         }
         else if (name.startsWith (RenderManager::getFileRenderPrefix()))
         {
@@ -83,6 +83,9 @@ public:
     /** */
     static juce::File getFreezeFileForTrack (const AudioTrack&);
 
+    /** Returns the file an AutoFreezer renders a track to for a given hash of the track's state. */
+    static juce::File getAutoFreezeFileForTrack (const AudioTrack&, juce::int64 hash);
+
     /** */
     static juce::Array<juce::File> getFrozenTrackFiles (Edit&);
 
@@ -0,0 +1,132 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS || TRACKTION_GRAPH_PERFORMANCE_TESTS
+
+namespace audio_test_utilities
+{
+    /** Returns a buffer of white noise with the given peak level. */
+    inline juce::AudioBuffer<float> createNoise (int numChannels, int numSamples, juce::Random& r, float level = 1.0f)
+    {
+        juce::AudioBuffer<float> noise (numChannels, numSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample (c, i, (r.nextFloat() * 2.0f - 1.0f) * level);
+
+        return noise;
+    }
+
+    /** Returns the largest difference between any two samples of the buffers over the
+        given range, or over the whole of the first buffer if the range is empty.
+    */
+    inline float getMaxDifference (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b,
+                                   juce::Range<int> sampleRange = {})
+    {
+        if (sampleRange.isEmpty())
+            sampleRange = { 0, a.getNumSamples() };
+
+        jassert (b.getNumChannels() >= a.getNumChannels() && b.getNumSamples() >= sampleRange.getEnd());
+        float maxDifference = 0.0f;
+
+        for (int c = 0; c < a.getNumChannels(); ++c)
+            for (int i = sampleRange.getStart(); i < sampleRange.getEnd(); ++i)
+                maxDifference = std::max (maxDifference, std::abs (a.getSample (c, i) - b.getSample (c, i)));
+
+        return maxDifference;
+    }
+}
+
+//==============================================================================
+namespace benchmark_utilities
+{
+    /** Returns the timer's elapsed seconds, clamped so it can safely be divided by. */
+    inline double getElapsedSeconds (const StopwatchTimer& timer)
+    {
+        return std::max (0.001, timer.getSeconds());
+    }
+
+    /** Prints a named timing, e.g. "Insert: 12 ms". */
+    inline void printTime (const juce::String& name, const StopwatchTimer& timer)
+    {
+        std::cout << name << ": " << timer.getDescription() << "\n";
+    }
+
+    /** Prints a named result, e.g. "Resident sample memory: 12 MB". */
+    inline void printValue (const juce::String& name, const juce::String& value)
+    {
+        std::cout << name << ": " << value << "\n";
+    }
+
+    /** Prints how long it took to process some audio and how many times faster than
+        real-time that was, optionally prefixed with a description of the run.
+        Returns the elapsed seconds so runs can be compared.
+    */
+    inline double printRealTimeFactor (const StopwatchTimer& timer, double audioDurationSeconds,
+                                       const juce::String& name = {})
+    {
+        const auto seconds = getElapsedSeconds (timer);
+
+        if (name.isNotEmpty())
+            std::cout << name << ": ";
+
+        std::cout << timer.getDescription() << ", " << juce::String (audioDurationSeconds / seconds, 1) << "x real-time\n";
+        return seconds;
+    }
+
+    /** Prints the mean, some percentiles and the maximum of a set of measurements,
+        e.g. the lateness of each message or the time each block took.
+    */
+    inline void printDistribution (const juce::String& name, std::vector<double> values,
+                                   const juce::String& units, int numDecimalPlaces = 1)
+    {
+        if (values.empty())
+            return;
+
+        std::sort (values.begin(), values.end());
+        auto percentile = [&] (double p) { return values[(size_t) (p * (double) (values.size() - 1))]; };
+        auto format = [&] (double v) { return juce::String (v, numDecimalPlaces) + units; };
+        double total = 0.0;
+
+        for (auto v : values)
+            total += v;
+
+        const auto mean = total / (double) values.size();
+
+        std::cout << name << ": " << values.size() << " values"
+                  << ", mean: " << format (mean)
+                  << ", p50: " << format (percentile (0.5))
+                  << ", p90: " << format (percentile (0.9))
+                  << ", p99: " << format (percentile (0.99))
+                  << ", max: " << format (values.back()) << "\n";
+    }
+
+    /** Prints how long it took to process some data and the throughput that gives. */
+    inline void printThroughput (const StopwatchTimer& timer, juce::int64 numBytes)
+    {
+        std::cout << timer.getDescription() << ", "
+                  << juce::String (numBytes / (1024.0 * 1024.0) / getElapsedSeconds (timer), 1) << " MB/s\n";
+    }
+
+    /** Prints the ratio between two timings, e.g. "Speed-up: 1.52x". */
+    inline void printSpeedUp (const juce::String& name, double secondsBefore, double secondsAfter)
+    {
+        std::cout << name << ": " << juce::String (secondsBefore / std::max (0.001, secondsAfter), 2) << "x\n";
+    }
+}
+
+#endif
+
+} // namespace tracktion_engine
@@ -311,6 +311,382 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SortedValueTreeObjectList)
 };
 
+//==============================================================================
+/**
+    A ValueTreeObjectList which also keeps an array with an entry for each child of
+    the parent tree, holding the child's object or nullptr if it doesn't have one.
+    The listener callbacks give the index of a removed or moved child so this can be
+    kept up to date without searching the objects, and removing the object for a tree
+    doesn't need a search of the whole list. This matters for lists with thousands
+    of children such as the notes in a MidiList.
+
+    Finding the object for a tree in getObjectFor() checks the children after the last
+    one found first, so looking up trees in the order they are in the parent (which is
+    what bulk edits do) is constant time. Otherwise it has to find the tree's index in
+    the parent.
+
+    When adding or removing a lot of children at once, use a ScopedBatch. The objects
+    array is then updated in a single pass when it's deleted, and the newObjectAdded()
+    and objectRemoved() callbacks are made then. Until that happens, the objects array
+    still contains the removed objects and doesn't contain the added ones, but
+    getObjectFor() is kept up to date.
+*/
+template<typename ObjectType, typename CriticalSectionType = juce::DummyCriticalSection>
+class IndexedValueTreeObjectList   : public ValueTreeObjectList<ObjectType, CriticalSectionType>
+{
+public:
+    using BaseListType = ValueTreeObjectList<ObjectType, CriticalSectionType>;
+    using ScopedLockType = typename BaseListType::ScopedLockType;
+
+    IndexedValueTreeObjectList (const juce::ValueTree& parentTree)
+        : BaseListType (parentTree)
+    {
+    }
+
+    // call in the sub-class when being created
+    void rebuildObjects()
+    {
+        BaseListType::rebuildObjects();
+
+        const ScopedLockType sl (this->arrayLock);
+        childObjects.clear();
+        childObjects.reserve ((size_t) this->parent.getNumChildren());
+
+        // The objects are created in the order of the children so can be matched in one pass
+        int nextObject = 0;
+
+        for (const auto& v : this->parent)
+        {
+            if (nextObject < this->objects.size() && this->objects.getUnchecked (nextObject)->state == v)
+                childObjects.push_back (this->objects.getUnchecked (nextObject++));
+            else
+                childObjects.push_back (nullptr);
+        }
+
+        jassert (nextObject == this->objects.size());
+    }
+
+    // call in the sub-class when being destroyed
+    void freeObjects()
+    {
+        jassert (batchDepth == 0); // must not be destroyed in the middle of a batch!
+
+        {
+            const ScopedLockType sl (this->arrayLock);
+            childObjects.clear();
+        }
+
+        BaseListType::freeObjects();
+    }
+
+    /** Returns the object for a given state, or nullptr if there isn't one. */
+    ObjectType* getObjectFor (const juce::ValueTree& v) const
+    {
+        const ScopedLockType sl (this->arrayLock);
+        auto index = findChildIndex (v);
+        return index >= 0 ? childObjects[(size_t) index] : nullptr;
+    }
+
+    //==============================================================================
+    /** Starts collecting changes. Batches can be nested. */
+    void beginBatch()
+    {
+        TRACKTION_ASSERT_MESSAGE_THREAD
+        ++batchDepth;
+    }
+
+    /** Applies the changes made since the matching beginBatch() call. */
+    void endBatch()
+    {
+        TRACKTION_ASSERT_MESSAGE_THREAD
+        jassert (batchDepth > 0);
+
+        if (--batchDepth > 0)
+            return;
+
+        if (addedInBatch.empty() && removedInBatch.empty() && ! orderChangedInBatch)
+            return;
+
+        {
+            const ScopedLockType sl (this->arrayLock);
+            rebuildArrayInTreeOrder();
+        }
+
+        auto added = std::move (addedInBatch);
+        auto removed = std::move (removedInBatch);
+        const bool orderChanged = std::exchange (orderChangedInBatch, false);
+        addedInBatch.clear();
+        removedInBatch.clear();
+
+        for (auto o : removed)
+        {
+            this->objectRemoved (o);
+            this->deleteObject (o);
+        }
+
+        // Call these in the order of the tree, the same as they'd have been added
+        if (! added.empty())
+            for (auto o : this->objects)
+                if (added.count (o) > 0)
+                    this->newObjectAdded (o);
+
+        if (orderChanged)
+            this->objectOrderChanged();
+    }
+
+    /** Batches the changes made to a list while it exists. */
+    struct ScopedBatch
+    {
+        ScopedBatch (IndexedValueTreeObjectList& l) : list (l)  { list.beginBatch(); }
+        ~ScopedBatch()                                          { list.endBatch(); }
+
+        IndexedValueTreeObjectList& list;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatch)
+    };
+
+    //==============================================================================
+    void valueTreeChildAdded (juce::ValueTree& parentTree, juce::ValueTree& tree) override
+    {
+        if (parentTree != this->parent)
+            return;
+
+        auto childIndex = getIndexOfAddedChild (tree);
+
+        if (! juce::isPositiveAndNotGreaterThan (childIndex, (int) childObjects.size()))
+        {
+            jassertfalse; // rebuildObjects() must be called before any children are added
+            return;
+        }
+
+        ObjectType* newObject = nullptr;
+
+        if (this->isSuitableType (tree))
+        {
+            newObject = this->createNewObject (tree);
+            jassert (newObject != nullptr);
+        }
+
+        {
+            const ScopedLockType sl (this->arrayLock);
+            childObjects.insert (childObjects.begin() + childIndex, newObject);
+
+            if (newObject != nullptr && batchDepth == 0)
+                this->objects.insert (getNumObjectsBefore (childIndex), newObject);
+        }
+
+        if (newObject == nullptr)
+            return;
+
+        if (batchDepth > 0)
+            addedInBatch.insert (newObject);
+        else
+            this->newObjectAdded (newObject);
+    }
+
+    void valueTreeChildRemoved (juce::ValueTree& exParent, juce::ValueTree& tree, int indexFromWhichChildWasRemoved) override
+    {
+        if (exParent != this->parent)
+            return;
+
+        ObjectType* o = nullptr;
+
+        {
+            const ScopedLockType sl (this->arrayLock);
+            if (! juce::isPositiveAndBelow (indexFromWhichChildWasRemoved, (int) childObjects.size()))
+            {
+                jassertfalse;
+                return;
+            }
+
+            o = childObjects[(size_t) indexFromWhichChildWasRemoved];
+            childObjects.erase (childObjects.begin() + indexFromWhichChildWasRemoved);
+
+            if (o == nullptr)
+                return;
+
+            jassert (o->state == tree);
+            juce::ignoreUnused (tree);
+
+            if (batchDepth == 0)
+            {
+                auto index = findIndexOf (o, indexFromWhichChildWasRemoved);
+                jassert (index >= 0);
+                this->objects.remove (index);
+            }
+        }
+
+        if (batchDepth > 0)
+        {
+            // If it was added in this batch, nothing has been told about it yet
+            if (addedInBatch.erase (o) > 0)
+                this->deleteObject (o);
+            else
+                removedInBatch.push_back (o);
+
+            return;
+        }
+
+        this->objectRemoved (o);
+        this->deleteObject (o);
+    }
+
+    void valueTreeChildOrderChanged (juce::ValueTree& tree, int oldIndex, int newIndex) override
+    {
+        if (tree != this->parent)
+            return;
+
+        {
+            const ScopedLockType sl (this->arrayLock);
+            moveChildObject (oldIndex, newIndex);
+
+            if (batchDepth == 0)
+                rebuildArrayInTreeOrder();
+        }
+
+        if (batchDepth > 0)
+            orderChangedInBatch = true;
+        else
+            this->objectOrderChanged();
+    }
+
+protected:
+    /** Returns the index of an object's state in the objects array. */
+    int indexOf (const juce::ValueTree& v) const noexcept
+    {
+        if (auto o = getObjectFor (v))
+            return this->objects.indexOf (o);
+
+        return -1;
+    }
+
+private:
+    std::vector<ObjectType*> childObjects;
+    std::unordered_set<ObjectType*> addedInBatch;
+    std::vector<ObjectType*> removedInBatch;
+    mutable std::atomic<int> lastFoundChildIndex { 0 };
+    int batchDepth = 0;
+    bool orderChangedInBatch = false;
+
+    bool isObjectAt (int childIndex, const juce::ValueTree& v) const noexcept
+    {
+        if (! juce::isPositiveAndBelow (childIndex, (int) childObjects.size()))
+            return false;
+
+        auto o = childObjects[(size_t) childIndex];
+        return o != nullptr && o->state == v;
+    }
+
+    int findChildIndex (const juce::ValueTree& v) const
+    {
+        // Check just after the last child found, allowing for a few children of other types in between
+        auto hint = lastFoundChildIndex.load (std::memory_order_relaxed);
+
+        for (int index = hint - 1; index <= hint + 8; ++index)
+            if (isObjectAt (index, v))
+                return lastFoundChildIndex = index;
+
+        auto index = this->parent.indexOf (v);
+
+        if (index < 0 || ! isObjectAt (index, v))
+            return -1;
+
+        return lastFoundChildIndex = index;
+    }
+
+    int getIndexOfAddedChild (const juce::ValueTree& tree) const
+    {
+        auto& parentTree = this->parent;
+        auto lastIndex = parentTree.getNumChildren() - 1;
+
+        // Most children are added to the end so check that first
+        if (parentTree.getChild (lastIndex) == tree)
+            return lastIndex;
+
+        return parentTree.indexOf (tree);
+    }
+
+    int getNumObjectsBefore (int childIndex) const noexcept
+    {
+        if (childIndex == (int) childObjects.size() - 1)
+            return this->objects.size();
+
+        return (int) std::count_if (childObjects.begin(), childObjects.begin() + childIndex,
+                                    [] (ObjectType* o) { return o != nullptr; });
+    }
+
+    void moveChildObject (int oldIndex, int newIndex)
+    {
+        auto numChildren = (int) childObjects.size();
+
+        if (oldIndex != newIndex
+             && juce::isPositiveAndBelow (oldIndex, numChildren)
+             && juce::isPositiveAndBelow (newIndex, numChildren))
+        {
+            auto start = childObjects.begin();
+
+            if (oldIndex < newIndex)
+                std::rotate (start + oldIndex, start + oldIndex + 1, start + newIndex + 1);
+            else
+                std::rotate (start + newIndex, start + oldIndex, start + oldIndex + 1);
+
+            return;
+        }
+
+        // ValueTree::sort() doesn't say which children moved so they have to be matched again.
+        // This is a search of the remaining objects for each child so is only done then.
+        std::vector<ObjectType*> remaining;
+        remaining.reserve (childObjects.size());
+
+        for (auto o : childObjects)
+            if (o != nullptr)
+                remaining.push_back (o);
+
+        for (int i = 0; i < numChildren; ++i)
+        {
+            auto child = this->parent.getChild (i);
+            auto found = std::find_if (remaining.begin(), remaining.end(),
+                                       [&child] (ObjectType* o) { return o->state == child; });
+
+            if (found != remaining.end())
+            {
+                childObjects[(size_t) i] = *found;
+                remaining.erase (found);
+            }
+            else
+            {
+                childObjects[(size_t) i] = nullptr;
+            }
+        }
+
+        jassert (remaining.empty());
+    }
+
+    void rebuildArrayInTreeOrder()
+    {
+        juce::Array<ObjectType*> newObjects;
+        newObjects.ensureStorageAllocated ((int) childObjects.size());
+
+        for (auto o : childObjects)
+            if (o != nullptr)
+                newObjects.add (o);
+
+        this->objects.swapWith (newObjects);
+    }
+
+    int findIndexOf (ObjectType* o, int treeIndexHint) const noexcept
+    {
+        // The objects are a subset of the children so are at or before their index in the tree
+        for (int i = std::min (treeIndexHint, this->objects.size() - 1); i >= 0; --i)
+            if (this->objects.getUnchecked (i) == o)
+                return i;
+
+        return this->objects.indexOf (o);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IndexedValueTreeObjectList)
+};
+
 //==============================================================================
 /** Returns the object for a given state if it exists. */
 template<typename ObjectType>
@@ -323,6 +699,13 @@ static ObjectType* getObjectFor (const ValueTreeObjectList<ObjectType>& objectLi
     return {};
 }
 
+/** Returns the object for a given state if it exists. */
+template<typename ObjectType, typename CriticalSectionType>
+static ObjectType* getObjectFor (const IndexedValueTreeObjectList<ObjectType, CriticalSectionType>& objectList, const juce::ValueTree& v)
+{
+    return objectList.getObjectFor (v);
+}
+
 //==============================================================================
 // Easy way to get one callback for all value tree change events
 struct ValueTreeAllEventListener  : public juce::ValueTree::Listener
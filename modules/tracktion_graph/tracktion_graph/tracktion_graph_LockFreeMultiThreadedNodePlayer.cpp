@@ -47,9 +47,10 @@ void LockFreeMultiThreadedNodePlayer::setNode (std::unique_ptr<Node> newNode)
     setNode (std::move (newNode), getSampleRate(), blockSize);
 }
 
-void LockFreeMultiThreadedNodePlayer::setNode (std::unique_ptr<Node> newNode, double sampleRateToUse, int blockSizeToUse)
+void LockFreeMultiThreadedNodePlayer::setNode (std::unique_ptr<Node> newNode, double sampleRateToUse, int blockSizeToUse,
+                                               Node* nodeToReplace)
 {
-    setNewCurrentNode (std::move (newNode), sampleRateToUse, blockSizeToUse);
+    setNewCurrentNode (std::move (newNode), sampleRateToUse, blockSizeToUse, nodeToReplace);
 }
 
 void LockFreeMultiThreadedNodePlayer::prepareToPlay (double sampleRateToUse, int blockSizeToUse)
@@ -219,13 +220,14 @@ inline void LockFreeMultiThreadedNodePlayer::pause()
 
 //==============================================================================
 void LockFreeMultiThreadedNodePlayer::setNewCurrentNode (std::unique_ptr<Node> newRoot,
-                                                         double sampleRateToUse, int blockSizeToUse)
+                                                         double sampleRateToUse, int blockSizeToUse,
+                                                         Node* nodeToReplace)
 {
     while (isUpdatingPreparedNode)
         pause();
 
     const bool useAudioBufferPool = useMemoryPool;
-    auto currentRoot = preparedNode.rootNode.get();
+    auto currentRoot = preparedNode.rootNode != nullptr ? preparedNode.rootNode.get() : nodeToReplace;
     auto newNodes = prepareToPlay (newRoot.get(), currentRoot,
                                    sampleRateToUse, blockSizeToUse,
                                    useAudioBufferPool ? pendingPreparedNodeStorage.audioBufferPool.get() : nullptr);
@@ -150,8 +150,13 @@ public:
     /** Sets the Node to process. */
     void setNode (std::unique_ptr<Node>);
 
-    /** Sets the Node to process with a new sample rate and block size. */
-    void setNode (std::unique_ptr<Node> newNode, double sampleRateToUse, int blockSizeToUse);
+    /** Sets the Node to process with a new sample rate and block size.
+        The new Nodes can take over state from the Nodes they replace in this player's current
+        Node. If this player doesn't have a Node yet, nodeToReplace can be a graph another
+        player is processing for them to take over state from instead.
+    */
+    void setNode (std::unique_ptr<Node> newNode, double sampleRateToUse, int blockSizeToUse,
+                  Node* nodeToReplace = nullptr);
 
     /** Prepares the current Node to be played.
         Calling this will cause a drop in the output stream as the Node is re-prepared.
@@ -263,7 +268,7 @@ private:
     void pause();
 
     //==============================================================================
-    void setNewCurrentNode (std::unique_ptr<Node> newRoot, double sampleRateToUse, int blockSizeToUse);
+    void setNewCurrentNode (std::unique_ptr<Node> newRoot, double sampleRateToUse, int blockSizeToUse, Node* nodeToReplace);
     
     //==============================================================================
     static void buildNodesOutputLists (PreparedNode&);
@@ -109,6 +109,14 @@ public:
     */
     void setRollInToLoop (int64_t playbackPosition);
 
+    //==============================================================================
+    /** Copies the play state, loop range and position mapping from another PlayHead.
+        This logs a user interaction so anything following this PlayHead will see a jump.
+        It can be used to keep a second PlayHead in step with the main one when part of
+        a graph is processed separately.
+    */
+    void copyStateFrom (const PlayHead&);
+
     //==============================================================================
     /** Sets the user dragging which logs a user interaction and enables scrubbing mode. */
     void setUserIsDragging (bool);
@@ -282,6 +290,19 @@ inline void PlayHead::setRollInToLoop (int64_t position)
     setSyncPositions (newSyncPositions);
 }
 
+inline void PlayHead::copyStateFrom (const PlayHead& other)
+{
+    referenceSampleRange = other.referenceSampleRange.load();
+    timelinePlayRange = other.timelinePlayRange.load();
+    scrubbingBlockLength = other.scrubbingBlockLength.load();
+    speed = other.speed.load();
+    looping = other.looping.load();
+    userDragging = other.userDragging.load();
+    rollInToLoop = other.rollInToLoop.load();
+    setSyncPositions (other.getSyncPositions());
+    userInteraction();
+}
+
 //==============================================================================
 inline void PlayHead::setUserIsDragging (bool b)
 {